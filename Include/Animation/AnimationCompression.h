@@ -0,0 +1,208 @@
+/* NekoEngine
+ *
+ * AnimationCompression.h
+ * Author: Alexandru Naiman
+ *
+ * Compressed animation track definitions
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+/*
+ * Track storage types. NANIM2 clips only use ANIM_TRACK_KEYS; the other types
+ * are written by the ModelImporter compressor (NANIM3).
+ */
+#define ANIM_TRACK_KEYS			0	// uncompressed double precision keys
+#define ANIM_TRACK_DEFAULT		1	// stripped; the node keeps its bind pose value
+#define ANIM_TRACK_CONSTANT		2	// a single full precision value
+#define ANIM_TRACK_QUANTIZED	3	// error-bounded keys, 16 bits per component
+
+#define ANIM_QUAT_RANGE			0.70710678f
+#define ANIM_QUAT_MAX			32767
+#define ANIM_RANGE_MAX			65535
+
+/**
+ * Translation or scaling track. Quantized values are stored as three
+ * 16 bit components per key, relative to min and extent.
+ * Constant tracks store their value in min.
+ */
+struct CompressedVectorTrack
+{
+	uint8_t type{ ANIM_TRACK_KEYS };
+	glm::vec3 min{ 0.f };
+	glm::vec3 extent{ 0.f };
+	std::vector<float> times;
+	std::vector<uint16_t> values;
+};
+
+/**
+ * Rotation track. Quantized keys use the smallest three encoding:
+ * 2 bits for the index of the dropped component and 15 bits for each of
+ * the other three, packed in 48 bits.
+ */
+struct CompressedQuatTrack
+{
+	uint8_t type{ ANIM_TRACK_KEYS };
+	glm::quat constant{ 1.f, 0.f, 0.f, 0.f };
+	std::vector<float> times;
+	std::vector<uint16_t> values;
+};
+
+static inline void AnimEncodeVector(const glm::vec3 &v, const glm::vec3 &min, const glm::vec3 &extent, uint16_t *out) noexcept
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		const float f{ extent[i] > 0.f ? (v[i] - min[i]) / extent[i] : 0.f };
+		out[i] = (uint16_t)(glm::clamp(f, 0.f, 1.f) * ANIM_RANGE_MAX + .5f);
+	}
+}
+
+static inline glm::vec3 AnimDecodeVector(const uint16_t *in, const glm::vec3 &min, const glm::vec3 &extent) noexcept
+{
+	return min + glm::vec3(in[0], in[1], in[2]) * (extent / (float)ANIM_RANGE_MAX);
+}
+
+static inline void AnimEncodeQuat(const glm::quat &q, uint16_t *out) noexcept
+{
+	const float c[4]{ q.x, q.y, q.z, q.w };
+	uint64_t largest{ 0 };
+
+	for (int i = 1; i < 4; ++i)
+		if (fabsf(c[i]) > fabsf(c[largest]))
+			largest = i;
+
+	// q and -q are the same rotation; flip so the dropped component is positive
+	const float sign{ c[largest] < 0.f ? -1.f : 1.f };
+	uint64_t packed{ largest << 45 }, shift{ 30 };
+
+	for (int i = 0; i < 4; ++i)
+	{
+		if (i == (int)largest)
+			continue;
+
+		const float f{ glm::clamp(c[i] * sign / ANIM_QUAT_RANGE, -1.f, 1.f) * .5f + .5f };
+		packed |= (uint64_t)(f * ANIM_QUAT_MAX + .5f) << shift;
+		shift -= 15;
+	}
+
+	out[0] = (uint16_t)(packed & 0xFFFF);
+	out[1] = (uint16_t)((packed >> 16) & 0xFFFF);
+	out[2] = (uint16_t)((packed >> 32) & 0xFFFF);
+}
+
+static inline glm::quat AnimDecodeQuat(const uint16_t *in) noexcept
+{
+	const uint64_t packed{ (uint64_t)in[0] | ((uint64_t)in[1] << 16) | ((uint64_t)in[2] << 32) };
+	const int largest{ (int)(packed >> 45) & 0x3 };
+	float c[4], sum{ 0.f };
+	int shift{ 30 };
+
+	for (int i = 0; i < 4; ++i)
+	{
+		if (i == largest)
+			continue;
+
+		c[i] = ((float)((packed >> shift) & ANIM_QUAT_MAX) / ANIM_QUAT_MAX * 2.f - 1.f) * ANIM_QUAT_RANGE;
+		sum += c[i] * c[i];
+		shift -= 15;
+	}
+
+	c[largest] = sqrtf(glm::max(0.f, 1.f - sum));
+
+	return glm::quat(c[3], c[0], c[1], c[2]);
+}
+
+/*
+ * Key lookup and sampling of compressed tracks, shared by AnimationSampler and
+ * the ModelImporter compressor so the error the importer reports is the error
+ * the engine sees. Key types other than the float times of compressed tracks
+ * provide an AnimKeyTime overload.
+ */
+static inline double AnimKeyTime(float time) noexcept { return time; }
+
+/**
+ * Index of the key that starts the segment containing time. cursor is the
+ * index returned by the previous call and makes forward playback O(1).
+ */
+template<typename T>
+static inline uint32_t AnimFindKey(const std::vector<T> &keys, double time, uint32_t &cursor) noexcept
+{
+	const uint32_t last{ (uint32_t)keys.size() - 1 };
+
+	// The clip looped or was rewound
+	if (cursor >= last || time < AnimKeyTime(keys[cursor]))
+		cursor = 0;
+
+	while (cursor < last - 1 && time >= AnimKeyTime(keys[cursor + 1]))
+		++cursor;
+
+	return cursor;
+}
+
+template<typename T>
+static inline float AnimKeyFactor(const std::vector<T> &keys, uint32_t index, double time) noexcept
+{
+	const double dt{ AnimKeyTime(keys[index + 1]) - AnimKeyTime(keys[index]) };
+	return dt > 0.0 ? (float)glm::clamp((time - AnimKeyTime(keys[index])) / dt, 0.0, 1.0) : 0.f;
+}
+
+static inline glm::vec3 AnimSampleTrack(const CompressedVectorTrack &track, double time, uint32_t &cursor) noexcept
+{
+	if (track.times.size() == 1)
+		return AnimDecodeVector(&track.values[0], track.min, track.extent);
+
+	const uint32_t i{ AnimFindKey(track.times, time, cursor) };
+	return glm::mix(AnimDecodeVector(&track.values[i * 3], track.min, track.extent),
+					AnimDecodeVector(&track.values[(i + 1) * 3], track.min, track.extent),
+					AnimKeyFactor(track.times, i, time));
+}
+
+static inline glm::quat AnimSampleTrack(const CompressedQuatTrack &track, double time, uint32_t &cursor) noexcept
+{
+	if (track.times.size() == 1)
+		return AnimDecodeQuat(&track.values[0]);
+
+	const uint32_t i{ AnimFindKey(track.times, time, cursor) };
+	return glm::normalize(glm::slerp(AnimDecodeQuat(&track.values[i * 3]), AnimDecodeQuat(&track.values[(i + 1) * 3]),
+									 AnimKeyFactor(track.times, i, time)));
+}
@@ -0,0 +1,271 @@
+/* NekoEngine
+ *
+ * AnimationGraph.h
+ * Author: Alexandru Naiman
+ *
+ * Animation blend graph and state machine definitions
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <Engine/Defs.h>
+#include <Animation/SkeletonPose.h>
+#include <Animation/AnimationSampler.h>
+
+#define ANIM_NO_PARAMETER	-1
+#define ANIM_NO_STATE		-1
+#define ANIM_ANY_STATE		-2
+
+#define ANIM_COND_GREATER	0
+#define ANIM_COND_LESS		1
+
+class Skeleton;
+class AnimationClip;
+class AnimationGraph;
+
+/**
+ * A node of the blend graph. Every node writes a complete local pose.
+ * A node must have a single parent, because parents advance the time of
+ * their inputs in Update.
+ */
+class AnimationGraphNode
+{
+public:
+	ENGINE_API AnimationGraphNode(AnimationGraph *graph) noexcept : _graph(graph) { }
+
+	ENGINE_API virtual void Update(double deltaTime) noexcept = 0;
+	ENGINE_API virtual void Evaluate(SkeletonPose &pose) noexcept = 0;
+	ENGINE_API virtual void Reset() noexcept = 0;
+
+	/**
+	 * Playback progress in [0, 1]; used by exit time transitions
+	 */
+	ENGINE_API virtual float GetNormalizedTime() const noexcept { return 0.f; }
+
+	ENGINE_API virtual ~AnimationGraphNode() { }
+
+protected:
+	AnimationGraph *_graph;
+};
+
+class AnimationClipNode : public AnimationGraphNode
+{
+public:
+	ENGINE_API AnimationClipNode(AnimationGraph *graph, AnimationClip *clip, bool loop, float speed) noexcept;
+
+	ENGINE_API void SetSpeed(float speed) noexcept { _speed = speed; }
+	ENGINE_API bool IsFinished() const noexcept;
+
+	ENGINE_API virtual void Update(double deltaTime) noexcept override { _time += deltaTime * _speed; }
+	ENGINE_API virtual void Evaluate(SkeletonPose &pose) noexcept override;
+	ENGINE_API virtual void Reset() noexcept override;
+	ENGINE_API virtual float GetNormalizedTime() const noexcept override;
+
+private:
+	AnimationSampler _sampler;
+	double _time;
+	float _speed;
+	bool _loop;
+};
+
+/**
+ * Base class for nodes that blend two inputs. The blend weight is read from
+ * a graph parameter, or from the fixed weight if no parameter is set.
+ */
+class AnimationBlendNode : public AnimationGraphNode
+{
+public:
+	ENGINE_API AnimationBlendNode(AnimationGraph *graph, AnimationGraphNode *a, AnimationGraphNode *b, int32_t parameter) noexcept;
+
+	ENGINE_API void SetWeight(float weight) noexcept { _weight = weight; }
+	ENGINE_API float GetWeight() const noexcept;
+
+	ENGINE_API virtual void Update(double deltaTime) noexcept override;
+	ENGINE_API virtual void Reset() noexcept override;
+	ENGINE_API virtual float GetNormalizedTime() const noexcept override { return _a->GetNormalizedTime(); }
+
+protected:
+	AnimationGraphNode *_a, *_b;
+	int32_t _parameter;
+	float _weight;
+	SkeletonPose _scratch;
+};
+
+/**
+ * Crossfade between a and b
+ */
+class AnimationLerpNode : public AnimationBlendNode
+{
+public:
+	ENGINE_API AnimationLerpNode(AnimationGraph *graph, AnimationGraphNode *a, AnimationGraphNode *b, int32_t parameter) noexcept :
+		AnimationBlendNode(graph, a, b, parameter)
+	{ }
+
+	ENGINE_API virtual void Evaluate(SkeletonPose &pose) noexcept override;
+};
+
+/**
+ * Adds the difference between b and the bind pose on top of a
+ */
+class AnimationAdditiveNode : public AnimationBlendNode
+{
+public:
+	ENGINE_API AnimationAdditiveNode(AnimationGraph *graph, AnimationGraphNode *base, AnimationGraphNode *additive, int32_t parameter) noexcept :
+		AnimationBlendNode(graph, base, additive, parameter)
+	{ }
+
+	ENGINE_API virtual void Evaluate(SkeletonPose &pose) noexcept override;
+};
+
+/**
+ * Blends b over a only for the subtree starting at the mask's root node
+ * (eg. upper body)
+ */
+class AnimationMaskNode : public AnimationBlendNode
+{
+public:
+	ENGINE_API AnimationMaskNode(AnimationGraph *graph, AnimationGraphNode *base, AnimationGraphNode *overlay, const char *rootNode, int32_t parameter) noexcept;
+
+	ENGINE_API virtual void Evaluate(SkeletonPose &pose) noexcept override;
+
+private:
+	std::vector<uint8_t> _mask;
+};
+
+struct AnimationState
+{
+	std::string name;
+	AnimationGraphNode *node;
+};
+
+/**
+ * A transition fires when its parameter condition holds and, if exitTime is
+ * not negative, the source state reached exitTime (normalized).
+ * Transitions without a parameter and without an exit time are only taken
+ * through SetState.
+ */
+struct AnimationTransition
+{
+	int16_t from;
+	int16_t to;
+	float duration;
+	float exitTime;
+	int32_t parameter;
+	uint8_t condition;
+	float threshold;
+};
+
+class AnimationStateMachine : public AnimationGraphNode
+{
+public:
+	ENGINE_API AnimationStateMachine(AnimationGraph *graph) noexcept;
+
+	/**
+	 * The first state added is the initial state
+	 */
+	ENGINE_API int16_t AddState(const char *name, AnimationGraphNode *node);
+	ENGINE_API void AddTransition(const AnimationTransition &transition) { _transitions.push_back(transition); }
+
+	ENGINE_API int16_t GetStateIndex(const char *name) const noexcept;
+	ENGINE_API int16_t GetCurrentState() const noexcept { return _current; }
+	ENGINE_API const char *GetCurrentStateName() const noexcept { return _current == ANIM_NO_STATE ? nullptr : _states[_current].name.c_str(); }
+	ENGINE_API bool IsInTransition() const noexcept { return _next != ANIM_NO_STATE; }
+
+	/**
+	 * Crossfade to state over duration seconds. A transition already in
+	 * progress completes immediately.
+	 */
+	ENGINE_API void SetState(int16_t state, float duration) noexcept;
+
+	ENGINE_API virtual void Update(double deltaTime) noexcept override;
+	ENGINE_API virtual void Evaluate(SkeletonPose &pose) noexcept override;
+	ENGINE_API virtual void Reset() noexcept override;
+	ENGINE_API virtual float GetNormalizedTime() const noexcept override;
+
+private:
+	std::vector<AnimationState> _states;
+	std::vector<AnimationTransition> _transitions;
+	int16_t _current, _next;
+	double _fadeTime, _fadeDuration;
+	SkeletonPose _scratch;
+
+	bool _CanTransition(const AnimationTransition &transition) const noexcept;
+};
+
+/**
+ * Owns the nodes and the float parameters of a blend graph evaluated for one
+ * skeleton.
+ */
+class AnimationGraph
+{
+public:
+	ENGINE_API AnimationGraph(Skeleton *skeleton) noexcept;
+
+	ENGINE_API Skeleton *GetSkeleton() noexcept { return _skeleton; }
+	ENGINE_API AnimationGraphNode *GetRoot() noexcept { return _root; }
+	ENGINE_API void SetRoot(AnimationGraphNode *root) noexcept;
+
+	ENGINE_API AnimationClipNode *AddClip(AnimationClip *clip, bool loop = true, float speed = 1.f);
+	ENGINE_API AnimationLerpNode *AddLerp(AnimationGraphNode *a, AnimationGraphNode *b, const char *parameter = nullptr);
+	ENGINE_API AnimationAdditiveNode *AddAdditive(AnimationGraphNode *base, AnimationGraphNode *additive, const char *parameter = nullptr);
+
+	/**
+	 * Returns nullptr if rootNode is not a node of the skeleton
+	 */
+	ENGINE_API AnimationMaskNode *AddMask(AnimationGraphNode *base, AnimationGraphNode *overlay, const char *rootNode, const char *parameter = nullptr);
+	ENGINE_API AnimationStateMachine *AddStateMachine();
+
+	/**
+	 * Parameters are created on first use and default to 0
+	 */
+	ENGINE_API int32_t GetParameterId(const char *name);
+	ENGINE_API float GetParameter(int32_t id) const noexcept { return id == ANIM_NO_PARAMETER ? 0.f : _parameters[id]; }
+	ENGINE_API void SetParameter(int32_t id, float value) noexcept { if (id != ANIM_NO_PARAMETER) _parameters[id] = value; }
+
+	ENGINE_API void Update(double deltaTime) noexcept;
+	ENGINE_API void Evaluate(SkeletonPose &pose) noexcept;
+
+	ENGINE_API ~AnimationGraph();
+
+private:
+	Skeleton *_skeleton;
+	AnimationGraphNode *_root;
+	std::vector<AnimationGraphNode *> _nodes;
+	std::vector<float> _parameters;
+	std::unordered_map<std::string, int32_t> _parameterMap;
+};
@@ -0,0 +1,110 @@
+/* NekoEngine
+ *
+ * AnimationManager.h
+ * Author: Alexandru Naiman
+ *
+ * Skinning scheduler and shared bone palette
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <Engine/Engine.h>
+#include <Renderer/Buffer.h>
+#include <Animation/Skeleton.h>
+
+#define ANIM_LOD_FULL		0
+#define ANIM_LOD_HALF		1
+#define ANIM_LOD_REDUCED	2
+#define ANIM_LOD_HIDDEN		3
+#define ANIM_LOD_COUNT		4
+
+#define ANIM_NO_PALETTE		UINT32_MAX
+
+class AnimatorComponent;
+
+/**
+ * Owns the bone palette shared by all skeletons and evaluates the animators
+ * queued during the scene update on the task system.
+ * Every skeleton gets a range of the palette; the ranges written this frame
+ * are uploaded with a single copy.
+ */
+class AnimationManager
+{
+public:
+	static int Initialize();
+
+	/**
+	 * Reserve a range of count matrices.
+	 * Returns the index of the first matrix or ANIM_NO_PALETTE if full.
+	 */
+	ENGINE_API static uint32_t AllocatePalette(uint32_t count) noexcept;
+	ENGINE_API static void FreePalette(uint32_t offset, uint32_t count) noexcept;
+
+	ENGINE_API static TrMat *GetPalette(uint32_t offset) noexcept { return _palette + offset; }
+	ENGINE_API static Buffer *GetPaletteBuffer() noexcept { return _paletteBuffer; }
+
+	/**
+	 * Mark a range as written so it is included in the next upload
+	 */
+	ENGINE_API static void Invalidate(uint32_t offset, uint32_t count) noexcept;
+
+	ENGINE_API static uint32_t GetFrame() noexcept { return _frame; }
+
+	ENGINE_API static void QueueEvaluation(AnimatorComponent *animator) noexcept { _queue.push_back(animator); }
+	ENGINE_API static void CancelEvaluation(AnimatorComponent *animator) noexcept;
+
+	/**
+	 * Evaluate the queued animators. Called once per frame after the scene update.
+	 */
+	static void Update() noexcept;
+	static void UpdateData(VkCommandBuffer commandBuffer) noexcept;
+
+	static void Release() noexcept;
+
+private:
+	struct PaletteRange
+	{
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	static Buffer *_paletteBuffer;
+	static TrMat *_palette;
+	static uint32_t _paletteSize, _alignment, _frame;
+	static uint32_t _dirtyBegin, _dirtyEnd;
+	static std::vector<PaletteRange> _freeRanges;
+	static std::vector<AnimatorComponent *> _queue;
+};
@@ -43,6 +43,7 @@
 #include <vector>
 
 #include <Engine/Defs.h>
+#include <Animation/AnimationCompression.h>
 
 struct VectorKey
 {
@@ -56,12 +57,18 @@ struct QuatKey
 	double time;
 };
 
+static inline double AnimKeyTime(const VectorKey &key) noexcept { return key.time; }
+static inline double AnimKeyTime(const QuatKey &key) noexcept { return key.time; }
+
 struct AnimationNode
 {
 	NString name;	
 	std::vector<VectorKey> positionKeys;
 	std::vector<QuatKey> rotationKeys;
 	std::vector<VectorKey> scalingKeys;
+	CompressedVectorTrack positionTrack;
+	CompressedQuatTrack rotationTrack;
+	CompressedVectorTrack scalingTrack;
 };
 
 #if defined(_MSC_VER)
@@ -0,0 +1,91 @@
+/* NekoEngine
+ *
+ * AnimationSampler.h
+ * Author: Alexandru Naiman
+ *
+ * AnimationSampler class definition
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <Engine/Defs.h>
+#include <Animation/SkeletonPose.h>
+
+class Skeleton;
+class AnimationClip;
+
+struct AnimationKeyCursor
+{
+	uint32_t position;
+	uint32_t rotation;
+	uint32_t scaling;
+};
+
+/**
+ * Samples an animation clip into a SkeletonPose.
+ * The clip's channels are resolved to skeleton nodes once in Bind and every
+ * channel remembers the last key it used, so playing forward does not search
+ * the key arrays.
+ */
+class AnimationSampler
+{
+public:
+	ENGINE_API AnimationSampler() noexcept;
+
+	ENGINE_API AnimationClip *GetClip() const noexcept { return _clip; }
+
+	ENGINE_API void Bind(const Skeleton *skeleton, AnimationClip *clip);
+	ENGINE_API void Reset() noexcept;
+
+	/**
+	 * Convert a time in seconds to the clip's time in ticks.
+	 * Looped time wraps around the duration, otherwise it stops at the end.
+	 */
+	ENGINE_API double GetClipTime(double seconds, bool loop = true) const noexcept;
+
+	/**
+	 * Write the animated channels at time (in ticks) into the pose.
+	 * Nodes without a channel, or with a zero entry in mask, are left untouched.
+	 */
+	ENGINE_API void Sample(double time, SkeletonPose &pose, const uint8_t *mask = nullptr) noexcept;
+
+	ENGINE_API ~AnimationSampler() { }
+
+private:
+	AnimationClip *_clip;
+	std::vector<int16_t> _channelNodes;
+	std::vector<AnimationKeyCursor> _cursors;
+};
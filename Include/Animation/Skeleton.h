@@ -46,9 +46,13 @@
 #include <Engine/Engine.h>
 #include <Animation/Bone.h>
 #include <Animation/AnimationNode.h>
+#include <Animation/SkeletonPose.h>
 #include <Animation/TransformNode.h>
+#include <Animation/AnimationSampler.h>
 
 #define SKEL_MAX_BONES	100
+#define SKEL_NO_PARENT	-1
+#define SKEL_NO_BONE	-1
 
 class AnimationClip;
 
@@ -63,31 +67,51 @@ public:
 	ENGINE_API Skeleton(std::vector<Bone> &bones, std::vector<TransformNode> &nodes, glm::dmat4 &globalInverseTransform) noexcept;
 	
 	ENGINE_API Buffer *GetBuffer() { return _buffer; }
-	ENGINE_API AnimationClip *GetAnimationClip() noexcept { return _animationClip; }
+	ENGINE_API AnimationClip *GetAnimationClip() noexcept { return _sampler.GetClip(); }
 
-	ENGINE_API void SetAnimationClip(AnimationClip *clip) noexcept { _animationClip = clip; };
+	ENGINE_API void SetAnimationClip(AnimationClip *clip) noexcept { if (clip != _sampler.GetClip()) _sampler.Bind(this, clip); }
 	ENGINE_API int Load();
 	ENGINE_API void TransformBones(double time);
 
-	ENGINE_API virtual ~Skeleton() noexcept;
+	/**
+	 * Nodes are stored flattened so that every parent precedes its children
+	 */
+	ENGINE_API uint16_t GetNodeCount() const noexcept { return _numNodes; }
+	ENGINE_API int16_t GetNodeIndex(const char *name) const noexcept;
+	ENGINE_API int16_t GetParentIndex(uint16_t node) const noexcept { return _parents[node]; }
+	ENGINE_API const SkeletonPose &GetBindPose() const noexcept { return _bindPose; }
+	ENGINE_API SkeletonPose &GetPose() noexcept { return _pose; }
+
+	/**
+	 * Compute the bone matrices from the current pose
+	 */
+	ENGINE_API void ComputeTransforms() noexcept;
+
+	/**
+	 * At reduced detail the leaf nodes are not sampled and keep the bind pose
+	 */
+	ENGINE_API void SetReducedDetail(bool reduced) noexcept { _reducedDetail = reduced; }
+	ENGINE_API const uint8_t *GetSampleMask() const noexcept { return _reducedDetail ? _lodMask.data() : nullptr; }
 
-	void UpdateData(VkCommandBuffer commandBuffer) noexcept;
+	ENGINE_API uint16_t GetBoneCount() const noexcept { return _numBones; }
+	ENGINE_API uint32_t GetPaletteOffset() const noexcept { return _paletteOffset; }
+
+	ENGINE_API virtual ~Skeleton() noexcept;
 	
 private:
-	TransformNode *_rootNode;
-	std::vector<Bone> _bones;
-	std::vector<TransformNode> _nodes;
 	uint16_t _numBones;
 	uint16_t _numNodes;
-	uint64_t _bufferSize;
+	uint32_t _paletteOffset;
+	bool _reducedDetail;
 	Buffer *_buffer;
-	glm::dmat4 _globalInverseTransform;
-	std::vector<TrMat> _transforms, _prevTransforms;
-	std::map<std::string, uint16_t> _boneMap;
-	AnimationClip *_animationClip;
-	
-	void _CalculatePosition(glm::dvec3 &out, double time, const AnimationNode *node);
-	void _CalculateRotation(glm::dquat &out, double time, const AnimationNode *node);
-	void _CalculateScaling(glm::dvec3 &out, double time, const AnimationNode *node);
-	void _TransformHierarchy(double time, const TransformNode *node, glm::dmat4 &parentTransform);
-};
\ No newline at end of file
+	TrMat *_transforms;
+	glm::mat4 _globalInverseTransform;
+	std::vector<glm::mat4> _offsets;
+	std::vector<int16_t> _parents;
+	std::vector<int16_t> _nodeBones;
+	std::vector<glm::mat4> _globalTransforms;
+	std::vector<uint8_t> _lodMask;
+	std::unordered_map<std::string, int16_t> _nodeMap;
+	SkeletonPose _bindPose, _pose;
+	AnimationSampler _sampler;
+};
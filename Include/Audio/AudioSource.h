@@ -44,13 +44,24 @@
 
 #define ASRC_NO_CLIP	-1
 
+#define ASRC_PRIORITY_LOW		0
+#define ASRC_PRIORITY_NORMAL	128
+#define ASRC_PRIORITY_HIGH		255
+
 class AudioSource
 {
 public:
-	AudioSource() noexcept { }
+	AudioSource() noexcept : _clip(nullptr), _priority(ASRC_PRIORITY_NORMAL) { }
 
 	ENGINE_API bool HasClip() noexcept { return _clip != nullptr; }
 
+	/**
+	 * Voice priority used by audio systems that limit the number of voices.
+	 * Higher priority sources are the last to be virtualized.
+	 */
+	ENGINE_API void SetPriority(uint8_t priority) noexcept { _priority = priority; }
+	ENGINE_API uint8_t GetPriority() noexcept { return _priority; }
+
 	virtual void SetPitch(float p) noexcept = 0;
 	virtual void SetGain(float g) noexcept = 0;
 
@@ -66,6 +77,7 @@ public:
 
 	virtual void SetMaxDistance(float maxDistance) noexcept = 0;
 	virtual void SetReferenceDistance(float referenceDistance) noexcept = 0;
+	virtual void SetRolloffFactor(float rolloff) noexcept = 0;
 
 	virtual int SetClip(AudioClip *clip) noexcept = 0;
 
@@ -79,5 +91,6 @@ public:
 
 protected:
 	AudioClip *_clip;
+	uint8_t _priority;
 };
 
@@ -44,6 +44,7 @@
 #include <stdint.h>
 
 #include <Engine/Vertex.h>
+#include <Engine/FixedTimestep.h>
 #include <Engine/EngineClassFactory.h>
 #include <Renderer/Renderer.h>
 #include <Platform/Platform.h>
@@ -63,6 +64,13 @@ struct EngineConfig
 	bool Fullscreen;
 	bool LoadLooseFiles;
 	bool EnableConsole;
+	int WorkerThreads;
+	int FixedUpdateRate;
+	int MaxSubsteps;
+	float ScriptGCBudget;
+	int ScriptInstructionBudget;
+	bool HotReload;
+	int HotReloadDelay;
 	char DataDirectory[NE_PATH_SIZE];
 	char LogFile[NE_PATH_SIZE];
 };
@@ -90,6 +98,8 @@ struct RendererConfig
 
 	bool EnableAsyncCompute;
 
+	bool DistanceFieldText;
+
 	float Gamma;
 
 	bool UseDeviceGroup;
@@ -125,6 +135,21 @@ struct AudioConfig
 	float MasterVolume;
 	float EffectsVolume;
 	float MusicVolume;
+
+	int MaxVoices;
+	int MixRate;
+	bool OfflineRender;
+	char OutputFile[NE_PATH_SIZE];
+};
+
+/**
+ * Animation system configuration information
+ */
+struct AnimationConfig
+{
+	int MaxBones;
+	float LOD1Distance;
+	float LOD2Distance;
 };
 
 /**
@@ -136,6 +161,7 @@ struct Configuration
 	RendererConfig Renderer;
 	PostProcessorConfig PostProcessor;
 	AudioConfig Audio;
+	AnimationConfig Animation;
 };
 
 /**
@@ -168,6 +194,17 @@ public:
 
 	static double GetTime() noexcept;
 
+	/**
+	 * Simulation timing. Physics, scripts and components are stepped with
+	 * GetFixedDeltaTime() in the fixed update phase; GetFixedFrame() is the
+	 * index of the last step and GetInterpolationFactor() the fraction of
+	 * a step elapsed since it.
+	 */
+	static double GetFixedDeltaTime() noexcept { return _fixedTimestep.GetStep(); }
+	static uint64_t GetFixedFrame() noexcept { return _fixedFrame; }
+	static float GetInterpolationFactor() noexcept { return _fixedTimestep.GetAlpha(); }
+	static bool InFixedUpdate() noexcept { return _inFixedUpdate; }
+
 	static Object *NewObject(const std::string &className, ObjectInitializer *initializer = nullptr);
 	static ObjectComponent *NewComponent(const std::string &className, ComponentInitializer *initializer);
 
@@ -189,6 +226,12 @@ public:
 	static DebugVariables &GetDebugVariables() noexcept { return _debugVariables; }
 
 	static GameModule *GetGameModule() noexcept { return _gameModule; }
+
+	/**
+	 * Run the fixed steps due after a frame of deltaTime seconds.
+	 * Returns the number of steps, at most iMaxSubsteps.
+	 */
+	static uint32_t StepFixedUpdate(double deltaTime);
 #endif
 
 private:
@@ -202,7 +245,10 @@ private:
 	static bool _disposed;
 	static bool _drawStats;
 	static bool _startup;
+	static bool _inFixedUpdate;
 	static glm::vec2 _scaleFactor;
+	static FixedTimestep _fixedTimestep;
+	static uint64_t _fixedFrame;
 
 	static void _FixedUpdate();
 	static void _Update(double deltaTime);
@@ -44,4 +44,9 @@
 
 #define NE_EVT_OBJ_ADDED		210
 #define NE_EVT_OBJ_REMOVED		211
-#define NE_EVT_OBJ_MOVED		212
\ No newline at end of file
+#define NE_EVT_OBJ_MOVED		212
+
+#define NE_EVT_RES_RELOADING	300
+#define NE_EVT_RES_RELOADED		301
+
+#define NE_EVT_TEX_RELEASED		310
\ No newline at end of file
@@ -0,0 +1,105 @@
+/* NekoEngine
+ *
+ * FixedTimestep.h
+ * Author: Alexandru Naiman
+ *
+ * Fixed timestep accumulator
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+/**
+ * Converts variable frame times into a whole number of fixed simulation
+ * steps. Time that would need more than maxSubsteps steps in one frame is
+ * dropped, so a slow frame can not make the next one slower.
+ */
+class FixedTimestep
+{
+public:
+	FixedTimestep(double step = 1.0 / 60.0, uint32_t maxSubsteps = 5) noexcept :
+		_step{ step }, _accumulator{ 0.0 }, _droppedTime{ 0.0 }, _maxSubsteps{ maxSubsteps }
+	{ }
+
+	void SetStep(double step, uint32_t maxSubsteps) noexcept
+	{
+		_step = step;
+		_maxSubsteps = maxSubsteps ? maxSubsteps : 1;
+		Reset();
+	}
+
+	void Reset() noexcept { _accumulator = 0.0; _droppedTime = 0.0; }
+
+	double GetStep() const noexcept { return _step; }
+	uint32_t GetMaxSubsteps() const noexcept { return _maxSubsteps; }
+	double GetDroppedTime() const noexcept { return _droppedTime; }
+
+	/**
+	 * Fraction of a step accumulated since the last simulation state, in [0, 1].
+	 * Renderers blend the previous and current state with it.
+	 */
+	float GetAlpha() const noexcept { return (float)(_accumulator / _step); }
+
+	/**
+	 * Add the frame time and return the number of steps to simulate
+	 */
+	uint32_t Advance(double deltaTime) noexcept
+	{
+		if (deltaTime > 0.0)
+			_accumulator += deltaTime;
+
+		double steps{ floor(_accumulator / _step) };
+		if (steps > _maxSubsteps)
+		{
+			const double keep{ fmod(_accumulator, _step) };
+			_droppedTime += _accumulator - keep - _maxSubsteps * _step;
+			_accumulator = keep + _maxSubsteps * _step;
+			steps = _maxSubsteps;
+		}
+
+		_accumulator -= steps * _step;
+		if (_accumulator < 0.0)
+			_accumulator = 0.0;
+		else if (_accumulator >= _step)
+			_accumulator = nextafter(_step, 0.0);
+
+		return (uint32_t)steps;
+	}
+
+private:
+	double _step, _accumulator, _droppedTime;
+	uint32_t _maxSubsteps;
+};
@@ -81,6 +81,27 @@ public:
 	ENGINE_API static size_t LoadedFonts() noexcept { return _loadedResources[ResourceType::RES_FONT]; }
 	
 	ENGINE_API static NArray<Resource *> GetResourcesOfType(ResourceType type) noexcept;
+
+	/**
+	 * Queue a changed file for reloading. The path is the VFS path of the
+	 * file; loaded materials and shader modules using it and scripts loaded
+	 * from it are reloaded by Update() once the file has not changed for
+	 * iHotReloadDelay milliseconds. Thread safe.
+	 */
+	ENGINE_API static void QueueReload(const char *path) noexcept;
+	ENGINE_API static size_t GetPendingReloadCount() noexcept;
+
+	/**
+	 * Watch the directory for changes and queue the changed files
+	 */
+	static int EnableHotReload(const char *directory);
+
+	/**
+	 * Apply the queued reloads; must be called between frames. Broadcasts
+	 * NE_EVT_RES_RELOADING before reloading resources and NE_EVT_RES_RELOADED
+	 * with the list of reloaded resources after.
+	 */
+	static void Update();
 	
 	ENGINE_API static void Release() noexcept;
 	
@@ -96,6 +117,8 @@ private:
 	static Resource* _LoadResourceInternal(ResourceInfo *ri);
 	static int _LoadResources();
 	static void _UnloadResources() noexcept;
+	static void _ApplyReloads(const std::vector<std::string> &paths);
+	static void _ReleaseReloads() noexcept;
 	
 	ResourceManager() { }
 };
\ No newline at end of file
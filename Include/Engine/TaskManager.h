@@ -39,8 +39,11 @@
 
 #pragma once
 
+#include <stdint.h>
 #include <functional>
 
+#include <Engine/Defs.h>
+
 struct Task
 {
 	void(*execute)(void);
@@ -55,9 +58,18 @@ public:
 	static void SetMinimumTasks(uint32_t min);
 	static void SetMaximumTasks(uint32_t max);
 
-	static bool Schedule(std::function<void(void)> task);
+	ENGINE_API static uint32_t GetWorkerCount();
+
+	ENGINE_API static bool Schedule(std::function<void(void)> task);
+
+	/**
+	 * Split [0, count) into chunks of at most grain items and run fn on each
+	 * chunk. The calling thread processes chunks too and returns when all of
+	 * them are done. Runs inline if the pool is not initialized.
+	 */
+	ENGINE_API static void ParallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t begin, uint32_t end)> &fn);
 
-	static void Wait();
+	ENGINE_API static void Wait();
 
 	static void Release();
 };
\ No newline at end of file
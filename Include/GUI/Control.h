@@ -42,6 +42,7 @@
 #include <vulkan/vulkan.h>
 
 #include <GUI/GUIDefs.h>
+#include <GUI/GUILayout.h>
 #include <GUI/GUIManager.h>
 #include <Renderer/NFont.h>
 #include <Engine/Engine.h>
@@ -61,19 +62,27 @@ public:
 	ENGINE_API virtual bool IsVisible() { return _visible; }
 	ENGINE_API virtual bool IsFocused() { return _focused; }
 
-	ENGINE_API virtual void SetPosition(int x, int y) { _controlRect.x = x; _controlRect.y = y; }
-	ENGINE_API virtual void SetPosition(Point pt) { _controlRect.x = pt.x; _controlRect.y = pt.y; }
-	ENGINE_API virtual void SetSize(int width, int height) { _controlRect.w = width; _controlRect.h = height; }
-	ENGINE_API virtual void SetSize(Point pt) { _controlRect.w = pt.x; _controlRect.h = pt.y; }
-	ENGINE_API virtual void SetColor(glm::vec4 &color) { _color = color; }
+	ENGINE_API virtual void SetPosition(int x, int y) { _layout.SetPosition(x, y); }
+	ENGINE_API virtual void SetPosition(Point pt) { _layout.SetPosition(pt.x, pt.y); }
+	ENGINE_API virtual void SetSize(int width, int height) { _layout.SetSize(width, height); }
+	ENGINE_API virtual void SetSize(Point pt) { _layout.SetSize(pt.x, pt.y); }
+	ENGINE_API virtual void SetColor(glm::vec4 &color) { _color = color; _layout.MarkContentDirty(); }
 	ENGINE_API virtual void SetText(std::string text) { _text = text; }
 	ENGINE_API virtual void SetTextColor(glm::vec3 &color) { _textColor = color; }
 	ENGINE_API virtual void SetEnabled(bool enable) { _enabled = enable; }
-	ENGINE_API virtual void SetVisible(bool visible) { _visible = visible; }
+	ENGINE_API virtual void SetVisible(bool visible) { _visible = visible; _layout.SetVisible(visible); }
 	ENGINE_API virtual void SetFont(NFont *font) { _font = font; }
 
 	ENGINE_API virtual void SetFocus() { GUIManager::SetFocus(this); }
 
+	/** Positions of children are relative to this control; the rect is solved in GUIManager::Update */
+	ENGINE_API virtual void AddChild(Control *child) { _layout.AddChild(&child->_layout); }
+	ENGINE_API virtual void RemoveChild(Control *child) { _layout.RemoveChild(&child->_layout); }
+	ENGINE_API virtual void SetAnchors(glm::vec2 anchorMin, glm::vec2 anchorMax, Point offsetMin = Point(), Point offsetMax = Point()) { _layout.SetAnchors(anchorMin, anchorMax, offsetMin, offsetMax); }
+	ENGINE_API virtual void SetLayoutDirection(LayoutDirection direction, int spacing = 0, int padding = 0) { _layout.SetDirection(direction, spacing, padding); }
+	ENGINE_API virtual void SetGrow(float grow) { _layout.SetGrow(grow); }
+	ENGINE_API GUILayoutNode *GetLayoutNode() { return &_layout; }
+
 	ENGINE_API virtual void SetClickHandler(std::function<void(void)> onClick) { _onClick = onClick; }
 	ENGINE_API virtual void SetRightClickHandler(std::function<void(void)> onRightClick) { _onRightClick = onRightClick; }
 	ENGINE_API virtual void SetMiddleClickHandler(std::function<void(void)> onMiddleClick) { _onMiddleClick = onMiddleClick; }
@@ -96,7 +105,7 @@ protected:
 	glm::vec3 _textColor, _hoveredTextColor;
 	glm::vec4 _color;
 	NFont *_font;
-	Buffer *_buffer;
+	GUILayoutNode _layout;
 	bool _focused;
 
 	std::function <void(void)> _onClick, _onRightClick, _onMiddleClick, _onMouseEnter, _onMouseLeave;
@@ -105,14 +114,7 @@ protected:
 	std::function<void(uint8_t)> _onKeyUp, _onKeyDown;
 
 	ENGINE_API virtual int _InitializeControl() { return ENGINE_OK;  }
-	ENGINE_API virtual int _CreateDescriptorSet() { return ENGINE_OK; }
-	ENGINE_API virtual int _BuildCommandBuffer() { return ENGINE_OK; }
-	ENGINE_API virtual int _RebuildCommandBuffer() { return ENGINE_OK; }
 	ENGINE_API virtual void _Update(double deltaTime) = 0;
-	ENGINE_API virtual void _UpdateData(void *commandBuffer) { (void)commandBuffer; }
-
-	VkCommandBuffer _commandBuffer;
-	VkDescriptorSet _descriptorSet;
-	VkDescriptorPool _descriptorPool;
-	VkDeviceSize _vertexOffset;
+	ENGINE_API virtual void _LayoutChanged() { }
+	ENGINE_API virtual void _Batch(GUIBatcher &batcher) { (void)batcher; }
 };
\ No newline at end of file
@@ -83,4 +83,8 @@ struct Rect
 	};
 
 	inline bool PtInRect(const Point &pt) const { return x < pt.x && y < pt.y && x + w > pt.x && y + h > pt.y; }
+	inline bool Intersects(const Rect &r) const { return x < r.x + r.w && r.x < x + w && y < r.y + r.h && r.y < y + h; }
+
+	inline bool operator==(const Rect &r) const { return pos == r.pos && size == r.size; }
+	inline bool operator!=(const Rect &r) const { return pos != r.pos || size != r.size; }
 };
\ No newline at end of file
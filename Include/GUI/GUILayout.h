@@ -0,0 +1,172 @@
+/* NekoEngine
+ *
+ * GUILayout.h
+ * Author: Alexandru Naiman
+ *
+ * GUI Layout Solver & Batcher
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <Engine/Engine.h>
+#include <Engine/Vertex.h>
+#include <GUI/GUIDefs.h>
+
+#define GUI_BATCH_LOOKBACK	256
+
+enum class LayoutDirection : uint8_t
+{
+	Absolute,
+	Row,
+	Column
+};
+
+/**
+ * Placement of a control inside its parent.
+ *
+ * Without a flex parent the rect spans from parent + anchorMin * parentSize + offsetMin
+ * to parent + anchorMax * parentSize + offsetMax, so a control anchored at (0, 0) keeps the old
+ * absolute behaviour. Inside a Row/Column parent the main axis is taken from the preferred size
+ * (offsetMax - offsetMin) plus a share of the free space proportional to grow; the cross axis
+ * still uses the anchors.
+ */
+class GUILayoutNode
+{
+	friend class GUILayout;
+
+public:
+	ENGINE_API GUILayoutNode();
+
+	ENGINE_API void AddChild(GUILayoutNode *child);
+	ENGINE_API void RemoveChild(GUILayoutNode *child);
+	ENGINE_API void ClearChildren();
+	ENGINE_API GUILayoutNode *GetParent() const noexcept { return _parent; }
+	ENGINE_API const std::vector<GUILayoutNode *> &GetChildren() const noexcept { return _children; }
+
+	ENGINE_API void SetRect(int x, int y, int width, int height);
+	ENGINE_API void SetPosition(int x, int y);
+	ENGINE_API void SetSize(int width, int height);
+	ENGINE_API void SetAnchors(glm::vec2 anchorMin, glm::vec2 anchorMax, Point offsetMin = Point(), Point offsetMax = Point());
+	ENGINE_API void SetDirection(LayoutDirection direction, int spacing = 0, int padding = 0);
+	ENGINE_API void SetGrow(float grow);
+	ENGINE_API void SetVisible(bool visible);
+
+	ENGINE_API void SetUserData(void *data) noexcept { _userData = data; }
+	ENGINE_API void *GetUserData() const noexcept { return _userData; }
+
+	/** Solved rect in screen space, y down */
+	ENGINE_API const Rect &GetRect() const noexcept { return _rect; }
+	ENGINE_API bool IsVisible() const noexcept { return _visible; }
+	ENGINE_API bool IsDirty() const noexcept { return _dirty || _contentDirty || _childDirty; }
+
+	/** Placement changed; the parent re-solves its children */
+	ENGINE_API void MarkDirty();
+
+	/** Appearance changed; the rect stays but the area must be redrawn */
+	ENGINE_API void MarkContentDirty();
+
+	ENGINE_API ~GUILayoutNode();
+
+private:
+	GUILayoutNode *_parent;
+	std::vector<GUILayoutNode *> _children;
+	glm::vec2 _anchorMin, _anchorMax;
+	Point _offsetMin, _offsetMax;
+	LayoutDirection _direction;
+	int _spacing, _padding;
+	float _grow;
+	Rect _rect;
+	void *_userData;
+	bool _visible, _solved;
+	bool _dirty, _contentDirty, _childDirty;
+
+	void _PropagateDirty();
+};
+
+typedef struct GUI_LAYOUT_RESULT
+{
+	/** Nodes whose rect or appearance changed, parents before children */
+	std::vector<GUILayoutNode *> changed;
+	/** Screen areas that must be redrawn */
+	std::vector<Rect> dirtyRects;
+	uint32_t nodesSolved;
+} GUILayoutResult;
+
+class GUILayout
+{
+public:
+	/**
+	 * Solve the tree under root for the given bounds.
+	 * Only subtrees on a dirty path are visited, so an idle UI costs one flag check.
+	 */
+	ENGINE_API static void Solve(GUILayoutNode *root, const Rect &bounds, GUILayoutResult &result);
+
+private:
+	static void _Arrange(GUILayoutNode *node, bool force, GUILayoutResult &result);
+};
+
+typedef struct GUI_BATCH
+{
+	uint32_t pipeline;
+	const void *texture;
+	uint32_t firstQuad;
+	uint32_t quadCount;
+} GUIBatch;
+
+/**
+ * Collects the quads of all controls in draw order and groups them into one vertex
+ * stream with a batch per pipeline & texture. A quad joins an earlier batch with the same
+ * key when it does not overlap anything submitted in between, so the result draws exactly
+ * like the submission order.
+ */
+class GUIBatcher
+{
+public:
+	ENGINE_API void Begin();
+	ENGINE_API void AddQuad(uint32_t pipeline, const void *texture, const GUIVertex *vertices);
+	ENGINE_API void End();
+
+	ENGINE_API const std::vector<GUIVertex> &GetVertices() const noexcept { return _vertices; }
+	ENGINE_API const std::vector<GUIBatch> &GetBatches() const noexcept { return _batches; }
+	ENGINE_API uint32_t GetQuadCount() const noexcept { return _quadCount; }
+
+private:
+	std::vector<GUIVertex> _quads, _vertices;
+	std::vector<glm::vec4> _quadBounds, _batchBounds;
+	std::vector<std::vector<uint32_t>> _batchQuads;
+	std::vector<GUIBatch> _batches;
+	uint32_t _quadCount{ 0 };
+};
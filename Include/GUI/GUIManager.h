@@ -40,15 +40,20 @@
 #pragma once
 
 #include <vector>
+#include <unordered_map>
 
 #ifdef ENGINE_INTERNAL
 	#include <Renderer/PipelineManager.h>
 #endif
 
 #include <Engine/Vertex.h>
+#include <GUI/GUILayout.h>
 #include <Renderer/NFont.h>
 #include <Renderer/Texture.h>
 
+#define GUI_MAX_QUADS		4096
+#define GUI_MAX_TEXTURES	64
+
 class GUIManager
 {
 public:
@@ -70,14 +75,18 @@ public:
 
 	ENGINE_API static void UnregisterControl(class Control *ctl);
 
+	/** Parent of all top level controls; its rect is the screen */
+	ENGINE_API static GUILayoutNode *GetRootNode() noexcept;
+	ENGINE_API static const GUILayoutResult &GetLayoutResult() noexcept;
+	ENGINE_API static uint32_t GetBatchCount() noexcept;
+	ENGINE_API static uint32_t GetQuadCount() noexcept;
+
 	static void ScreenResized();
 
 	static void Release();
 
 #ifdef ENGINE_INTERNAL
 
-	static Buffer *CreateVertexBuffer(size_t size, uint8_t *data = nullptr);
-	static void FreeVertexBuffer(Buffer *buff);
 	static Buffer *GetGUIIndexBuffer() { return _indexBuffer; }
 	static VkSampler GetSampler() { return _sampler; }
 	static VkCommandBuffer GetCommandBuffer() { return _commandBuffer; }
@@ -85,17 +94,40 @@ public:
 	static void BindDescriptorSet(VkCommandBuffer buffer) { vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipelineLayout(PIPE_LYT_GUI), 0, 1, &_descriptorSet, 0, nullptr); }
 
 private:
-	static VkDescriptorPool _descriptorPool;
+	static VkDescriptorPool _descriptorPool, _textureDescriptorPool;
 	static VkDescriptorSet _descriptorSet;
 	static VkCommandBuffer _commandBuffer;
 	static VkSampler _sampler;
-	static Buffer *_buffer, *_indexBuffer;
+	static Buffer *_buffer, *_indexBuffer, *_vertexBuffer;
 	static class NFont *_systemFont;
-	static bool _needUpdate;
+	static bool _needUpdate, _rebuildBatches, _rebuildCommandBuffer;
 	static std::vector<class NFont *> _fonts;
 	static std::vector<class Control *> _controls;
+	static std::unordered_map<const void *, VkDescriptorSet> _textureSets;
+	static std::vector<GUIBatch> _drawnBatches;
+	static std::vector<GUIVertex> _uploadedVertices;
+	static GUILayoutNode _layoutRoot;
+	static GUILayoutResult _layoutResult;
+	static GUIBatcher _batcher;
+
+	/** Objects the GPU may still use; freed MAX_INFLIGHT_COMMAND_BUFFERS frames after they were replaced */
+	typedef struct GUI_RETIRED_OBJECT
+	{
+		uint64_t frame;
+		VkCommandBuffer commandBuffer;
+		VkDescriptorSet textureSet;
+	} GUIRetiredObject;
+
+	static std::vector<GUIRetiredObject> _retiredObjects;
+	static uint64_t _frame;
 
 	static bool _CreateDescriptorSet();
+	static VkDescriptorSet _GetTextureDescriptorSet(Texture *texture);
+	static void _TextureReleased(Texture *texture);
+	static void _BatchNode(GUILayoutNode *node);
+	static int _BuildCommandBuffer();
+	static void _Retire(VkCommandBuffer commandBuffer, VkDescriptorSet textureSet);
+	static void _ReleaseRetired(bool all);
 
 #endif
 };
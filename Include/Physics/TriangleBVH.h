@@ -0,0 +1,158 @@
+/* NekoEngine
+ *
+ * TriangleBVH.h
+ * Author: Alexandru Naiman
+ *
+ * Bounding volume hierarchy over mesh triangles
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <Engine/Defs.h>
+#include <Runtime/Runtime.h>
+
+#define BVH_PACKET_SIZE		8
+
+class VFSFile;
+class StaticMesh;
+
+/**
+ * 32 byte node. Interior nodes store their first child right after them and
+ * the second child at offset; leaves store count triangles starting at offset.
+ */
+struct BVHNode
+{
+	glm::vec3 min;
+	uint32_t offset;
+	glm::vec3 max;
+	uint16_t count;
+	uint16_t axis;
+};
+
+struct BVHHit
+{
+	float t;
+	float u, v;
+	uint32_t triangle;
+	glm::vec3 normal;
+};
+
+/**
+ * Up to BVH_PACKET_SIZE rays traversed together. Coherent rays (picking
+ * grids, shadow or visibility probes from one point) share most of the
+ * node visits.
+ */
+struct BVHRayPacket
+{
+	glm::vec3 origin[BVH_PACKET_SIZE];
+	glm::vec3 direction[BVH_PACKET_SIZE];
+	float maxT[BVH_PACKET_SIZE];
+	uint32_t count;
+};
+
+/**
+ * Triangle BVH built with binned SAH. The triangles are stored in leaf
+ * order; hits report the index of the triangle in the source mesh.
+ * StaticMesh::GetBVH builds one on demand and caches it next to the mesh
+ * file.
+ */
+class TriangleBVH
+{
+public:
+	ENGINE_API TriangleBVH() noexcept : _sourceHash{ 0 } { }
+
+	/**
+	 * Build from a triangle soup, three positions per triangle
+	 */
+	ENGINE_API int Build(const std::vector<glm::vec3> &triangles);
+	ENGINE_API int Build(const StaticMesh *mesh);
+
+	/**
+	 * Load a cached hierarchy. Fails with ENGINE_INVALID_HEADER if the file
+	 * is not a BVH or was built from different geometry.
+	 */
+	ENGINE_API int Load(VFSFile *file, uint64_t sourceHash);
+	ENGINE_API int Save(VFSFile *file) const;
+
+	ENGINE_API uint32_t GetTriangleCount() const noexcept { return (uint32_t)_triangleIds.size(); }
+	ENGINE_API uint32_t GetNodeCount() const noexcept { return (uint32_t)_nodes.size(); }
+	ENGINE_API const std::vector<BVHNode> &GetNodes() const noexcept { return _nodes; }
+	ENGINE_API const glm::vec3 &GetMin() const noexcept { return _nodes[0].min; }
+	ENGINE_API const glm::vec3 &GetMax() const noexcept { return _nodes[0].max; }
+	ENGINE_API uint64_t GetSourceHash() const noexcept { return _sourceHash; }
+
+	/**
+	 * Closest intersection of origin + t * direction, t in [0, maxT].
+	 * The direction does not have to be normalized; t is in its units.
+	 */
+	ENGINE_API bool ClosestHit(const glm::vec3 &origin, const glm::vec3 &direction, float maxT, BVHHit &hit) const noexcept;
+
+	/**
+	 * True if any triangle intersects the ray; stops at the first hit
+	 */
+	ENGINE_API bool AnyHit(const glm::vec3 &origin, const glm::vec3 &direction, float maxT) const noexcept;
+
+	/**
+	 * Closest hits for a packet. Returns a mask with bit i set if ray i hit.
+	 */
+	ENGINE_API uint32_t ClosestHit(const BVHRayPacket &packet, BVHHit *hits) const noexcept;
+
+	/**
+	 * Append the source indices of the triangles intersecting the box or
+	 * sphere to triangles. Returns the number of triangles found.
+	 */
+	ENGINE_API uint32_t Overlap(const glm::vec3 &min, const glm::vec3 &max, std::vector<uint32_t> &triangles) const;
+	ENGINE_API uint32_t Overlap(const glm::vec3 &center, float radius, std::vector<uint32_t> &triangles) const;
+
+	/**
+	 * Hash of the source triangles, used to validate cached files
+	 */
+	ENGINE_API static uint64_t HashTriangles(const std::vector<glm::vec3> &triangles) noexcept;
+	ENGINE_API static void GetMeshTriangles(const StaticMesh *mesh, std::vector<glm::vec3> &triangles);
+
+	ENGINE_API ~TriangleBVH() { }
+
+private:
+	std::vector<BVHNode> _nodes;
+	std::vector<glm::vec3> _vertices;
+	std::vector<uint32_t> _triangleIds;
+	uint64_t _sourceHash;
+
+	uint32_t _Build(uint32_t first, uint32_t count, std::vector<uint32_t> &ids, const std::vector<glm::vec3> &lo,
+		const std::vector<glm::vec3> &hi, const std::vector<glm::vec3> &centroids, uint32_t depth);
+	bool _Validate() const;
+	bool _IntersectTriangle(uint32_t triangle, const glm::vec3 &origin, const glm::vec3 &direction, float maxT, BVHHit &hit) const noexcept;
+};
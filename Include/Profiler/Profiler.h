@@ -46,6 +46,11 @@ public:
 	static void InsertMarker(const char *name, glm::vec3 color);
 	static void EndRegion();
 
+	/**
+	 * Report a value for the current frame, drawn after the regions
+	 */
+	static void InsertCounter(const char *name, double value, const char *unit, glm::vec3 color);
+
 	static void Draw();
 };
 
@@ -53,10 +58,12 @@ public:
 	#define PROF_BEGIN(name, color) Profiler::BeginRegion(name, color)
 	#define PROF_MARKER(name, color) Profiler::InsertMarker(name, color)
 	#define PROF_END() Profiler::EndRegion()
+	#define PROF_COUNTER(name, value, unit, color) Profiler::InsertCounter(name, value, unit, color)
 	#define PROF_DRAW() Profiler::Draw()
 #else
 	#define PROF_BEGIN(name, color)
 	#define PROF_MARKER(name, color)
 	#define PROF_END()
+	#define PROF_COUNTER(name, value, unit, color)
 	#define PROF_DRAW()
 #endif
\ No newline at end of file
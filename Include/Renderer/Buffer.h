@@ -41,6 +41,8 @@
 
 #include <vulkan/vulkan.h>
 
+#include <Renderer/MemoryAllocator.h>
+
 class Buffer
 {
 public:
@@ -56,6 +58,7 @@ public:
 	VkDeviceMemory &GetMemoryHandle() { return _memory; }
 	VkDeviceSize GetParentOffset() { return _offset; }
 	VkDeviceSize GetSize() { return _size; }
+	const MemoryAllocation &GetAllocation() { return _allocation; }
 
 	uint8_t *Map(VkDeviceSize offset = 0, VkDeviceSize size = 0);
 	void Unmap();
@@ -76,8 +79,10 @@ public:
 private:
 	VkBuffer _buffer;
 	VkDeviceMemory _memory;
-	VkDeviceSize _offset, _size;
-	bool _persistent, _ownMemory, _child;
+	VkDeviceSize _offset, _size, _memoryOffset;
+	MemoryAllocation _allocation;
+	uint8_t *_mapped;
+	bool _persistent, _child;
 
 	void _CreateBuffer(size_t size, VkBufferUsageFlags usage, uint8_t *data, VkDeviceMemory memory, VkDeviceSize offset, VkMemoryPropertyFlags properties);
 };
\ No newline at end of file
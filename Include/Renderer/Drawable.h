@@ -51,6 +51,21 @@ struct Drawable
 	VkCommandBuffer depthCommandBuffer;
 	bool transparent;
 	bool *visible;
+
+	// Identify the draw state for the render queue; draws with the same
+	// pipeline, material, mesh and group are submitted next to each other
+	uint8_t pipeline;
+	const void *material;
+	const void *mesh;
+	uint32_t group;
+
+	// Set for draws that can be merged with their neighbours into one
+	// instanced draw. The instanced command buffers read the ObjectData of
+	// the batch from the instance buffer through indirect command instanceCommand.
+	VkCommandBuffer instancedSceneCommandBuffer;
+	VkCommandBuffer instancedDepthCommandBuffer;
+	int32_t instanceCommand;
+	const void *instanceData;
 };
 
 #if defined(_MSC_VER)
@@ -0,0 +1,178 @@
+/* NekoEngine
+ *
+ * GlyphCache.h
+ * Author: Alexandru Naiman
+ *
+ * Glyph atlas packing and text layout
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include <Engine/Engine.h>
+
+#define GLYPH_PADDING			1
+#define GLYPH_REPLACEMENT_CHAR	0xFFFD
+
+typedef struct GLYPH_INFO
+{
+	glm::ivec2 size;
+	glm::ivec2 bearing;
+	glm::ivec2 position;
+	int advance;
+} GlyphInfo;
+
+typedef struct GLYPH_BITMAP
+{
+	glm::ivec2 size;
+	glm::ivec2 bearing;
+	int advance;
+	int pitch;
+	const uint8_t *data;
+} GlyphBitmap;
+
+typedef struct FONT_METRICS
+{
+	int ascender;
+	int lineHeight;
+} FontMetrics;
+
+typedef struct PLACED_GLYPH
+{
+	glm::ivec2 position;
+	const GlyphInfo *glyph;
+} PlacedGlyph;
+
+typedef struct GLYPH_UPLOAD
+{
+	uint32_t x, y;
+	uint32_t width, height;
+	size_t offset;
+} GlyphUpload;
+
+/**
+ * Rasterizes glyphs for a GlyphCache. The bitmap data only has to stay
+ * valid until the next call.
+ */
+class GlyphSource
+{
+public:
+	virtual bool RasterizeGlyph(uint32_t codepoint, int pixelSize, GlyphBitmap &bitmap) = 0;
+	virtual int GetKerning(uint32_t left, uint32_t right, int pixelSize) = 0;
+	virtual void GetMetrics(int pixelSize, FontMetrics &metrics) = 0;
+
+	virtual ~GlyphSource() { }
+};
+
+/**
+ * Skyline bottom-left rectangle packer
+ */
+class SkylinePacker
+{
+public:
+	ENGINE_API SkylinePacker(uint32_t width, uint32_t height);
+
+	ENGINE_API uint32_t GetWidth() const noexcept { return _width; }
+	ENGINE_API uint32_t GetHeight() const noexcept { return _height; }
+	ENGINE_API float GetOccupancy() const noexcept { return (float)_usedArea / (float)(_width * _height); }
+
+	ENGINE_API bool Pack(uint32_t width, uint32_t height, glm::uvec2 &position);
+	ENGINE_API void Reset();
+
+private:
+	typedef struct SKYLINE_NODE
+	{
+		uint32_t x, y, width;
+	} SkylineNode;
+
+	std::vector<SkylineNode> _skyline;
+	uint32_t _width, _height;
+	uint64_t _usedArea;
+
+	bool _Fit(size_t index, uint32_t width, uint32_t height, uint32_t &y) const;
+};
+
+/**
+ * Lazily rasterized glyphs of any codepoint and pixel size, packed into a
+ * single R8 atlas. Newly packed glyphs are queued for upload; the cache
+ * itself does not touch the GPU.
+ */
+class GlyphCache
+{
+public:
+	ENGINE_API GlyphCache(GlyphSource *source, uint32_t width, uint32_t height);
+
+	ENGINE_API const GlyphInfo *GetGlyph(uint32_t codepoint, int pixelSize);
+	ENGINE_API int GetKerning(uint32_t left, uint32_t right, int pixelSize);
+	ENGINE_API const FontMetrics &GetMetrics(int pixelSize);
+
+	/**
+	 * Place the glyphs of an UTF-8 string. Positions are the top left corner
+	 * of each bitmap, relative to the origin of the first line's baseline.
+	 * Returns the width of the widest line.
+	 */
+	ENGINE_API int Layout(const char *text, size_t length, int pixelSize, std::vector<PlacedGlyph> &glyphs);
+	ENGINE_API int Measure(const char *text, size_t length, int pixelSize);
+
+	ENGINE_API SkylinePacker &GetPacker() noexcept { return _packer; }
+	ENGINE_API size_t GetGlyphCount() const noexcept { return _glyphs.size(); }
+	ENGINE_API bool IsFull() const noexcept { return _full; }
+
+	ENGINE_API const std::vector<GlyphUpload> &GetPendingUploads() const noexcept { return _uploads; }
+	ENGINE_API const uint8_t *GetUploadData() const noexcept { return _uploadData.data(); }
+	ENGINE_API size_t GetUploadDataSize() const noexcept { return _uploadData.size(); }
+	ENGINE_API void ClearPendingUploads();
+
+	/** Evict every glyph. The atlas contents become undefined. */
+	ENGINE_API void Reset();
+
+	ENGINE_API static uint32_t DecodeUTF8(const char *&text, const char *end);
+
+private:
+	GlyphSource *_source;
+	SkylinePacker _packer;
+	std::unordered_map<uint64_t, GlyphInfo> _glyphs;
+	std::unordered_map<uint64_t, int> _kerning;
+	std::unordered_map<int, FontMetrics> _metrics;
+	std::vector<GlyphUpload> _uploads;
+	std::vector<uint8_t> _uploadData;
+	bool _full;
+
+	template<typename T>
+	int _Layout(const char *text, size_t length, int pixelSize, T place);
+};
@@ -91,6 +91,7 @@ public:
 	ENGINE_API void SetAnimated(bool animated);
 
 	ENGINE_API virtual int Load() override;
+	ENGINE_API virtual int Reload() override;
 	ENGINE_API bool CreateDescriptorSet();
 
 	ENGINE_API void SetType(MaterialType type) { _data.Type = (int32_t)type; }
@@ -107,10 +108,17 @@ public:
 
 	ENGINE_API virtual ~Material();
 
-	VkPipelineLayout GetPipelineLayout() { return PipelineManager::GetPipelineLayout(_pipelineLayoutId); }
+	VkPipelineLayout GetPipelineLayout(bool instanced = false)
+	{
+		return PipelineManager::GetPipelineLayout(instanced ? (PipelineLayoutId)(_pipelineLayoutId + PIPE_LYT_Instanced_OneSampler) : _pipelineLayoutId);
+	}
+	PipelineId GetPipelineId() const noexcept { return _pipelineId; }
 
-	void Enable(VkCommandBuffer buffer);
-	void BindNormal(VkCommandBuffer buffer);
+	/** Static opaque materials can be drawn with the instanced pipelines */
+	bool CanInstance() const noexcept { return PipelineManager::HasInstancing() && _pipelineId < PIPE_Anim_Unlit; }
+
+	void Enable(VkCommandBuffer buffer, bool instanced = false);
+	void BindNormal(VkCommandBuffer buffer, bool instanced = false);
 	bool HasDescriptorSet() { return _descriptorSet != VK_NULL_HANDLE; }
 
 private:
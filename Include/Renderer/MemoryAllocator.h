@@ -0,0 +1,220 @@
+/* NekoEngine
+ *
+ * MemoryAllocator.h
+ * Author: Alexandru Naiman
+ *
+ * Device Memory Sub-Allocator
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <functional>
+
+#include <vulkan/vulkan.h>
+
+#define MEMORY_BLOCK_SIZE			(64 * 1024 * 1024)
+#define MEMORY_MIN_BLOCK_SIZE		(4 * 1024 * 1024)
+#define MEMORY_TLSF_SL_BITS			4
+#define MEMORY_TLSF_FL_COUNT		40
+#define MEMORY_TLSF_MIN_SPLIT		256
+#define MEMORY_INVALID_NODE			0xFFFFFFFF
+
+/**
+ * Two level segregated fit allocator over an abstract range of bytes.
+ * Allocation and free are O(1); the first level is the power of two class of the size,
+ * the second splits each class into 2^MEMORY_TLSF_SL_BITS linear ranges.
+ */
+class TLSFHeap
+{
+public:
+	TLSFHeap(VkDeviceSize size);
+
+	/** Returns the node id or MEMORY_INVALID_NODE; userData is kept on the node for Walk */
+	uint32_t Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset, void *userData = nullptr);
+	void Free(uint32_t node);
+	void SetUserData(uint32_t node, void *userData) { _nodes[node].userData = userData; }
+
+	/** Visit every allocation in address order */
+	void Walk(const std::function<void(VkDeviceSize offset, VkDeviceSize size, void *userData)> &visitor) const;
+
+	VkDeviceSize GetSize() const noexcept { return _size; }
+	VkDeviceSize GetUsed() const noexcept { return _used; }
+	uint32_t GetAllocationCount() const noexcept { return _allocations; }
+	VkDeviceSize GetLargestFree() const;
+
+	/** Checks links, bitmaps and coalescing; used by the headless tests */
+	bool Validate() const;
+
+private:
+	typedef struct TLSF_NODE
+	{
+		VkDeviceSize offset, size;
+		uint32_t prevPhys, nextPhys;
+		uint32_t prevFree, nextFree;
+		void *userData;
+		bool free;
+	} TLSFNode;
+
+	std::vector<TLSFNode> _nodes;
+	std::vector<uint32_t> _unusedNodes;
+	uint32_t _heads[MEMORY_TLSF_FL_COUNT][1 << MEMORY_TLSF_SL_BITS];
+	uint32_t _slBitmap[MEMORY_TLSF_FL_COUNT];
+	uint64_t _flBitmap;
+	VkDeviceSize _size, _used;
+	uint32_t _allocations;
+
+	uint32_t _NewNode();
+	void _InsertFree(uint32_t node);
+	void _RemoveFree(uint32_t node);
+	uint32_t _FindFree(VkDeviceSize size);
+	uint32_t _Split(uint32_t node, VkDeviceSize size);
+};
+
+/**
+ * Everything the allocator needs from the device. The engine uses VKMemoryDevice;
+ * tests provide a mock so the policy can run without a GPU.
+ */
+class MemoryDevice
+{
+public:
+	virtual uint32_t GetMemoryTypeCount() = 0;
+	virtual VkMemoryPropertyFlags GetMemoryTypeProperties(uint32_t type) = 0;
+	virtual VkDeviceSize GetMemoryTypeHeapSize(uint32_t type) = 0;
+	virtual bool AllocateMemory(uint32_t type, VkDeviceSize size, VkDeviceMemory &memory) = 0;
+	virtual void FreeMemory(VkDeviceMemory memory) = 0;
+	virtual uint8_t *MapMemory(VkDeviceMemory memory) = 0;
+	virtual void UnmapMemory(VkDeviceMemory memory) = 0;
+
+	virtual ~MemoryDevice() { }
+};
+
+class VKMemoryDevice : public MemoryDevice
+{
+public:
+	VKMemoryDevice();
+
+	virtual uint32_t GetMemoryTypeCount() override { return _properties.memoryTypeCount; }
+	virtual VkMemoryPropertyFlags GetMemoryTypeProperties(uint32_t type) override { return _properties.memoryTypes[type].propertyFlags; }
+	virtual VkDeviceSize GetMemoryTypeHeapSize(uint32_t type) override { return _properties.memoryHeaps[_properties.memoryTypes[type].heapIndex].size; }
+	virtual bool AllocateMemory(uint32_t type, VkDeviceSize size, VkDeviceMemory &memory) override;
+	virtual void FreeMemory(VkDeviceMemory memory) override;
+	virtual uint8_t *MapMemory(VkDeviceMemory memory) override;
+	virtual void UnmapMemory(VkDeviceMemory memory) override;
+
+private:
+	VkPhysicalDeviceMemoryProperties _properties;
+};
+
+enum class MemoryResourceType : uint8_t
+{
+	/** Buffers and linear images */
+	Linear,
+	/** Optimal tiling images; kept in separate blocks so bufferImageGranularity never applies */
+	Image,
+	/** Render targets; recreated on resize, so large ones get their own allocation */
+	Attachment
+};
+
+typedef struct MEMORY_ALLOCATION
+{
+	VkDeviceMemory memory;
+	VkDeviceSize offset, size, alignment;
+	/** Persistent mapping of the allocation for host visible memory, nullptr otherwise */
+	uint8_t *mapped;
+	uint32_t memoryType;
+	uint32_t pool, block, node;
+	bool dedicated;
+	void *owner;
+} MemoryAllocation;
+
+typedef struct MEMORY_STATS
+{
+	uint32_t blockCount, dedicatedCount, allocationCount;
+	VkDeviceSize blockBytes, dedicatedBytes, usedBytes, largestFree;
+	uint32_t defragMoves;
+} MemoryStats;
+
+/**
+ * Called for every allocation Defragment wants to relocate. The handler copies the
+ * contents and rebinds its resource to dst, then returns true; src is released afterwards.
+ */
+typedef std::function<bool(const MemoryAllocation &src, const MemoryAllocation &dst)> MemoryMoveHandler;
+
+class MemoryAllocator
+{
+public:
+	/** Takes ownership of the device */
+	MemoryAllocator(MemoryDevice *device, VkDeviceSize blockSize = MEMORY_BLOCK_SIZE);
+
+	bool Allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, MemoryResourceType type, MemoryAllocation &allocation, void *owner = nullptr);
+	void Free(MemoryAllocation &allocation);
+
+	/**
+	 * Empty the least used blocks by moving at most maxMoves allocations into fuller ones.
+	 * The MemoryAllocation the owner passed to Allocate is updated in place.
+	 */
+	uint32_t Defragment(uint32_t maxMoves, const MemoryMoveHandler &handler);
+
+	void GetStats(MemoryStats &stats) const;
+	void LogStats() const;
+
+	~MemoryAllocator();
+
+private:
+	typedef struct MEMORY_BLOCK
+	{
+		VkDeviceMemory memory;
+		uint8_t *mapped;
+		TLSFHeap *heap;
+	} MemoryBlock;
+
+	typedef struct MEMORY_POOL
+	{
+		std::vector<MemoryBlock> blocks;
+		VkDeviceSize blockSize;
+		uint32_t memoryType;
+		bool hostVisible;
+	} MemoryPool;
+
+	MemoryDevice *_device;
+	VkDeviceSize _blockSize;
+	std::vector<MemoryPool> _pools;
+	uint32_t _dedicatedCount, _defragMoves;
+	VkDeviceSize _dedicatedBytes;
+
+	bool _AllocateFromPool(uint32_t poolIndex, const VkMemoryRequirements &requirements, MemoryAllocation &allocation, void *owner, bool newBlock);
+	bool _AllocateDedicated(uint32_t memoryType, VkDeviceSize size, MemoryAllocation &allocation, void *owner);
+	void _ReleaseEmptyBlocks(MemoryPool &pool, bool keepOne);
+};
@@ -43,36 +43,64 @@
 #include <Renderer/Buffer.h>
 #include <Runtime/Runtime.h>
 #include <Resource/Resource.h>
+#include <Renderer/GlyphCache.h>
+#include <Renderer/TextRunCache.h>
 #include <Resource/FontResource.h>
 
-#define FONT_START_CHAR		32
-#define FONT_NUM_CHARS		128
+#define FONT_ATLAS_SIZE			1024
+#define FONT_PRELOAD_START		32
+#define FONT_PRELOAD_END		127
+#define FONT_SDF_SIZE			48
+#define FONT_SDF_SPREAD			6
 
-typedef struct CHARACTER_INFO
+/**
+ * Distance field text effects, pushed to the PIPE_Font_SDF fragment shader.
+ * Widths and softness are in distance units, where 0.5 spans the spread.
+ */
+typedef struct FONT_EFFECTS
 {
-	glm::ivec2 size;
-	glm::ivec2 bearing;
-	unsigned int advance;
-	float offset;
-} CharacterInfo;
+	glm::vec4 outlineColor;
+	glm::vec4 shadowColor;
+	glm::vec2 shadowOffset;
+	float outlineWidth;
+	float softness;
+} FontEffects;
 
-class NFont : public Resource
+class NFont : public Resource, private GlyphSource
 {
 public:
 	ENGINE_API NFont(FontResource *res);
 
 	ENGINE_API FontResource* GetResourceInfo() noexcept { return (FontResource*)_resourceInfo; }
-	ENGINE_API uint32_t GetCharacterHeight() { return _texHeight; }
+	ENGINE_API uint32_t GetCharacterHeight() { return (uint32_t)_cache.GetMetrics(_pixelSize).lineHeight; }
 	ENGINE_API uint32_t GetTextLength(const char *text);
 	ENGINE_API uint32_t GetTextLength(const NString &text);
 
+	/** Select the size used by the following calls. Glyphs of every size share the atlas. */
 	ENGINE_API int SetPixelSize(int pixelSize);
+	ENGINE_API int GetPixelSize() const noexcept { return _pixelSize; }
+
+	/**
+	 * Render glyphs once at FONT_SDF_SIZE into distance fields and scale them
+	 * to any pixel size. Switching modes evicts the glyph cache.
+	 */
+	ENGINE_API int SetDistanceField(bool enable);
+	ENGINE_API bool IsDistanceField() const noexcept { return _distanceField; }
+
+	/** Outline width and shadow offset are in pixels at FONT_SDF_SIZE, up to FONT_SDF_SPREAD. Distance field fonts only. */
+	ENGINE_API int SetOutline(float width, const glm::vec4 &color);
+	ENGINE_API int SetShadow(const glm::vec2 &offset, const glm::vec4 &color, float softness = 0.f);
 
 	ENGINE_API virtual int Load() override;
 
 	ENGINE_API void UpdateData(VkCommandBuffer cmdBuffer);
-	ENGINE_API void Draw(NString text, glm::vec2& pos) noexcept { glm::vec3 white(1.f, 1.f, 1.f); Draw(text, pos, white); }
-	ENGINE_API void Draw(NString text, glm::vec2& pos, glm::vec3& color) noexcept;
+	ENGINE_API void Draw(const NString &text, glm::vec2& pos) noexcept { glm::vec3 white(1.f, 1.f, 1.f); Draw(*text, pos, white); }
+	ENGINE_API void Draw(const NString &text, glm::vec2& pos, glm::vec3& color) noexcept { Draw(*text, pos, color); }
+
+	/** Text is retained between frames; redrawing an unchanged string at the same place costs a hash lookup */
+	ENGINE_API void Draw(const char *text, glm::vec2& pos, glm::vec3& color) noexcept;
+
+	ENGINE_API const TextRunStats *GetTextRunStats() const noexcept { return _runs ? &_runs->GetStats() : nullptr; }
 
 	ENGINE_API virtual ~NFont();
 
@@ -82,12 +110,29 @@ public:
 #endif
 
 private:
-	NArray<GUIVertex> _vertices;
-	NArray<uint32_t> _indices;
-	CharacterInfo _characterInfo[FONT_NUM_CHARS];
+	std::vector<PlacedGlyph> _placedGlyphs;
+	std::vector<uint8_t> _fieldData;
+	GlyphCache _cache;
+	TextRunCache *_runs;
+	TextRunUpdate _runUpdate;
 	Buffer *_buffer, *_stagingBuffer;
-	uint32_t _texWidth, _texHeight;
-	int _pixelSize;
+	struct FT_FaceRec_ *_face;
+	uint8_t *_fontData;
+	uint32_t _maxChars;
+	int _pixelSize, _facePixelSize;
+	bool _distanceField;
+	FontEffects _effects;
+
+	int _LayoutSize() const noexcept { return _distanceField ? FONT_SDF_SIZE : _pixelSize; }
+	float _LayoutScale() const noexcept { return (float)_pixelSize / (float)_LayoutSize(); }
+
+	virtual bool RasterizeGlyph(uint32_t codepoint, int pixelSize, GlyphBitmap &bitmap) override;
+	virtual int GetKerning(uint32_t left, uint32_t right, int pixelSize) override;
+	virtual void GetMetrics(int pixelSize, FontMetrics &metrics) override;
+
+	int _LoadFace();
+	void _Tessellate(const char *text, size_t length, const glm::vec2 &pos, const glm::vec3 &color, TextRun &run);
+	void _SetFaceSize(int pixelSize);
 
 #ifdef ENGINE_INTERNAL
 	VkImage _image;
@@ -96,10 +141,14 @@ private:
 	VkCommandBuffer _cmdBuffer, _oldCmdBuffer;
 	VkDescriptorSet _descriptorSet;
 	VkDescriptorPool _descriptorPool;
-	VkDeviceSize _vboOffset, _iboOffset, _bufferSize;
-	VkDrawIndexedIndirectCommand _drawCommand;
+	VkDeviceSize _vboOffset, _iboOffset, _bufferSize, _stagingSliceSize;
+	VkDrawIndexedIndirectCommand _drawCommands[2];
+	std::vector<VkBufferCopy> _copyRegions;
+	uint32_t _stagingSlice;
 
-	int _BuildAtlas();
+	int _CreateAtlas();
+	int _CreateBuffers();
+	void _UploadGlyphs(VkCommandBuffer cmdBuffer);
 	int _CreateDescriptorSet();
 	void _UpdateDescriptorSet();
 	int _BuildCommandBuffer();
@@ -108,5 +157,4 @@ private:
 
 #if defined(_MSC_VER)
 template class ENGINE_API NArray<NFont *>;
-template class ENGINE_API NArray<CharacterInfo>;
-#endif
\ No newline at end of file
+#endif
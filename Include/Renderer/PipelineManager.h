@@ -61,6 +61,7 @@ enum DescriptorLayoutId : uint8_t
 	DESC_LYT_ShadowFilter,
 	DESC_LYT_ParticleCompute,
 	DESC_LYT_ParticleDraw,
+	DESC_LYT_Instances,
 };
 
 enum PipelineLayoutId : uint8_t
@@ -77,6 +78,11 @@ enum PipelineLayoutId : uint8_t
 	PIPE_LYT_Anim_FourSamplers = 13,
 	PIPE_LYT_Anim_Depth = 14,
 	PIPE_LYT_Anim_Shadow = 15,
+	PIPE_LYT_Instanced_OneSampler = 20,
+	PIPE_LYT_Instanced_TwoSamplers = 21,
+	PIPE_LYT_Instanced_ThreeSamplers = 22,
+	PIPE_LYT_Instanced_FourSamplers = 23,
+	PIPE_LYT_Instanced_Depth = 24,
 	PIPE_LYT_GUI = 100,
 	PIPE_LYT_PostProcess = 101,
 	PIPE_LYT_Culling = 102,
@@ -125,6 +131,15 @@ enum PipelineId : uint8_t
 	PIPE_Transparent_Anim_PhongNormal = 34,
 	PIPE_Transparent_Anim_PhongNormalSpecular = 35,
 	PIPE_Transparent_Anim_PhongNormalSpecularEmissive = 36,
+	PIPE_Instanced_Unlit = 40,
+	PIPE_Instanced_Phong = 41,
+	PIPE_Instanced_PhongSpecular = 42,
+	PIPE_Instanced_PhongSpecularEmissive = 43,
+	PIPE_Instanced_PhongNormal = 44,
+	PIPE_Instanced_PhongNormalSpecular = 45,
+	PIPE_Instanced_PhongNormalSpecularEmissive = 46,
+	PIPE_Instanced_Depth = 47,
+	PIPE_Instanced_DepthNormal = 48,
 	PIPE_Skysphere = 100,
 	PIPE_GUI = 101,
 	PIPE_Font = 102,
@@ -132,6 +147,7 @@ enum PipelineId : uint8_t
 	PIPE_Terrain = 104,
 	PIPE_Terrain_Depth = 105,
 	PIPE_Terrain_Shadow = 106,
+	PIPE_Font_SDF = 107,
 	PIPE_ShadowFilter = 190,
 	PIPE_ParticleEmit = 200,
 	PIPE_ParticleUpdate = 201,
@@ -150,6 +166,9 @@ public:
 	static VkPipelineLayout GetPipelineLayout(PipelineLayoutId layout) { return _pipelineLayouts[layout]; }
 	static VkDescriptorSetLayout GetDescriptorSetLayout(DescriptorLayoutId layout) { return _descriptorSetLayouts[layout]; }
 
+	/** The instanced pipelines exist only when their vertex shaders are in the resource database */
+	static bool HasInstancing() noexcept { return _instancing; }
+
 	static int RecreatePipelines();
 
 	static void Release();
@@ -158,6 +177,7 @@ private:
 	static std::unordered_map<uint8_t, VkPipeline> _pipelines;
 	static std::unordered_map<uint8_t, VkPipelineLayout> _pipelineLayouts;
 	static std::unordered_map<uint8_t, VkDescriptorSetLayout> _descriptorSetLayouts;
+	static bool _instancing;
 
 	static int _LoadShaders();
 	static int _CreatePipelines();
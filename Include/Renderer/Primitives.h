@@ -60,6 +60,9 @@ public:
 	static const NBounds &GetPrimitiveBounds(PrimitiveID primitive);
 
 	static void DrawPrimitive(PrimitiveID primitive, VkCommandBuffer commandBuffer);
+	static void DrawPrimitiveIndirect(PrimitiveID primitive, VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset);
+	static uint32_t GetIndexCount(PrimitiveID primitive);
+	static uint32_t GetFirstIndex(PrimitiveID primitive);
 
 	static void Release();
 };
\ No newline at end of file
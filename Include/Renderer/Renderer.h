@@ -39,6 +39,7 @@
 
 #pragma once
 
+#include <vector>
 #include <unordered_map>
 #include <algorithm>
 
@@ -50,6 +51,11 @@
 
 #define MAX_INFLIGHT_COMMAND_BUFFERS	12
 #define TEMPORARY_BUFFER_SIZE			2097152		// 2 MB
+#define STAGING_RING_SIZE				33554432	// 32 MB
+#define STAGING_RING_FRAMES				2
+#define STAGING_RING_ALIGNMENT			256
+#define STAGING_RING_FRAME_DATA			2097152		// 2 MB
+#define STAGING_LOAD_SIZE				16777216	// 16 MB
 
 #ifdef ENGINE_INTERNAL
 struct QueueFamilyIndices
@@ -180,9 +186,38 @@ public:
 	// WARNING: THE RETURNED BUFFER MUST NOT BE FREED. IT WILL BE FREED WHEN THE NEXT FRAME STARTS
 	Buffer *GetTemporaryBuffer(VkDeviceSize size);
 
+	/**
+	 * Host visible memory for a synchronous upload, carved out of the load staging area when possible.
+	 * FreeStagingBuffer must be called once the copy has completed.
+	 */
 	Buffer *GetStagingBuffer(VkDeviceSize size);
 	void FreeStagingBuffer(Buffer *buffer);
 
+	/**
+	 * Staging memory for a copy recorded into the update command buffer of this frame.
+	 * It is reclaimed once that frame's uploads complete. Returns nullptr if the frame's budget is spent;
+	 * frame data is exempt from the budget and only fails when the ring is full.
+	 */
+	uint8_t *AllocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkBuffer &buffer, VkDeviceSize &offset, bool frameData = false);
+
+	/**
+	 * Copy data to dst through the staging ring. What does not fit in this frame's budget
+	 * is kept and uploaded by the following frames, in order.
+	 */
+	void UploadBuffer(Buffer *dst, VkDeviceSize offset, const uint8_t *data, VkDeviceSize size, VkCommandBuffer cmdBuffer);
+
+	/**
+	 * Copy per frame data, like uniforms, to dst in this frame. It is never split across frames
+	 * and supersedes queued uploads to the same range.
+	 */
+	void UploadFrameData(Buffer *dst, VkDeviceSize offset, const uint8_t *data, VkDeviceSize size, VkCommandBuffer cmdBuffer);
+	void CancelUploads(Buffer *dst);
+
+	class MemoryAllocator *GetMemoryAllocator() { return _memoryAllocator; }
+
+	/** Indirect draws can take more than one command per call */
+	bool HasMultiDrawIndirect() { return _multiDrawIndirect; }
+
 	int32_t AllocLight();
 	Light *GetLight(int32_t id);
 	void FreeLight(int32_t id);
@@ -207,6 +242,7 @@ private:
 	VkDebugReportCallbackEXT _debugCB;
 	SwapchainInfo _swapchainInfo;
 	Swapchain *_swapchain;
+	class MemoryAllocator *_memoryAllocator;
 
 	VkFramebuffer _framebuffer, _depthFramebuffer, _guiFramebuffer;
 	VkSampler _textureSampler, _nearestSampler, _depthSampler;
@@ -240,15 +276,32 @@ private:
 		_aoReadySemaphore,
 		_aoFinishedSemaphore;
 
-	Buffer *_buffer, *_stagingBuffer;
+	typedef struct PENDING_UPLOAD
+	{
+		Buffer *dst;
+		VkDeviceSize offset;
+		std::vector<uint8_t> data;
+	} PendingUpload;
+
+	class StagingRing *_stagingRing, *_loadStaging;
+	Buffer *_stagingRingBuffer, *_loadStagingBuffer;
+	uint8_t *_stagingRingData;
+	uint32_t _loadStagingCount;
+	VkFence _uploadFences[STAGING_RING_FRAMES];
+	uint64_t _uploadFrames[STAGING_RING_FRAMES], _uploadFrame;
+	std::vector<PendingUpload> _pendingUploads;
+
+	Buffer *_buffer;
 	SceneData _sceneData;
 	class Texture *_blankTexture;
 
 	uint32_t _nFrames;
+	bool _multiDrawIndirect;
 
 	NArray<const NBounds *> _drawBoundsList;
 
 	virtual void _RecreateSwapchain();
+	void _ResourcesReloaded(NArray<struct Resource *> &resources);
 
 	// ----
 
@@ -263,6 +316,11 @@ private:
 	bool _CreateBuffer();
 	bool _CreateCommandBuffers();
 	bool _CreateSemaphores();
+	bool _CreateStagingRing();
+
+	VkCommandBuffer _BeginUploadFrame();
+	VkDeviceSize _StageCopy(Buffer *dst, VkDeviceSize offset, const uint8_t *data, VkDeviceSize size, VkCommandBuffer cmdBuffer);
+	void _FlushPendingUploads(VkCommandBuffer cmdBuffer);
 
 	bool _BuildDepthCommandBuffer();
 	bool _BuildSceneCommandBuffer();
@@ -51,6 +51,7 @@ public:
 	ENGINE_API ShaderModuleResource* GetResourceInfo() noexcept { return (ShaderModuleResource *)_resourceInfo; }
 
 	ENGINE_API virtual int Load() override;
+	ENGINE_API virtual int Reload() override;
 
 	ENGINE_API virtual ~ShaderModule() noexcept;
 
@@ -60,6 +61,8 @@ public:
 
 private:
 	VkShaderModule _module;
+
+	int _CreateModule(VkShaderModule &module);
 #endif
 };
 
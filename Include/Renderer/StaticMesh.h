@@ -50,6 +50,8 @@
 #include <Resource/Resource.h>
 #include <Resource/MeshResource.h>
 
+class TriangleBVH;
+
 struct MeshGroup
 {
 	uint32_t vertexOffset;
@@ -75,6 +77,12 @@ public:
 	ENGINE_API const std::vector<Vertex> &GetVertices() const noexcept { return _vertices; }
 	ENGINE_API const std::vector<uint32_t> &GetIndices() const noexcept { return _indices; }
 	ENGINE_API const NBounds &GetBounds() const noexcept { return _bounds; }
+
+	/**
+	 * Triangle BVH for ray and overlap queries, built on first use. Meshes
+	 * loaded from files cache it in a .nbvh file next to the mesh.
+	 */
+	ENGINE_API const TriangleBVH *GetBVH() const;
 	ENGINE_API uint64_t GetVertexOffset() const noexcept { return _vertexOffset; }
 	ENGINE_API uint64_t GetIndexOffset() const noexcept { return _indexOffset; }
 	ENGINE_API const MeshGroup &GetGroup(uint32_t group) const noexcept { return _groups[group]; }
@@ -121,10 +129,20 @@ protected:
 
 	VkDeviceSize _vertexOffset;
 	VkDeviceSize _indexOffset;
+	mutable TriangleBVH *_bvh;
 
 	PipelineId _depthPipelineId;
 	PipelineLayoutId _depthPipelineLayoutId;
 
+	// When set, drawables issue these VkDrawIndexedIndirectCommands instead of their group
+	Buffer *_indirectBuffer;
+	uint32_t _indirectDrawCount;
+
 	void _CalculateTangents();
 	void _BuildBounds(uint32_t group, NBounds &bounds);
+	void _DrawGroup(VkCommandBuffer commandBuffer, size_t group) const noexcept;
+
+	/** Record the command buffers that draw a whole batch led by this drawable */
+	bool _BuildInstancedDrawable(Material *material, Drawable &drawable, size_t group, bool buildDepth);
+	void _DrawInstances(VkCommandBuffer commandBuffer, int32_t command) const noexcept;
 };
\ No newline at end of file
@@ -0,0 +1,135 @@
+/* NekoEngine
+ *
+ * TextRunCache.h
+ * Author: Alexandru Naiman
+ *
+ * Retained text geometry
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include <Engine/Engine.h>
+#include <Engine/Vertex.h>
+
+#define TEXT_RUN_PROMOTE_FRAMES		3
+#define TEXT_RUN_RING_SIZE			2
+#define TEXT_RUN_QUAD_SIZE			(sizeof(GUIVertex) * 4)
+
+typedef struct TEXT_RUN
+{
+	std::vector<GUIVertex> vertices;
+	float width;
+	uint32_t age;
+	uint32_t firstQuad;
+	uint64_t lastFrame;
+	bool persistent;
+} TextRun;
+
+/** Byte ranges; destinations are relative to the start of the vertex region */
+typedef struct TEXT_RUN_COPY
+{
+	size_t srcOffset, dstOffset, size;
+} TextRunCopy;
+
+typedef struct TEXT_RUN_FILL
+{
+	size_t offset, size;
+} TextRunFill;
+
+typedef struct TEXT_RUN_UPDATE
+{
+	std::vector<TextRunCopy> copies;
+	std::vector<TextRunFill> fills;
+	uint32_t persistentQuads;
+	uint32_t dynamicFirstQuad;
+	uint32_t dynamicQuads;
+	size_t stagingUsed;
+} TextRunUpdate;
+
+typedef struct TEXT_RUN_STATS
+{
+	uint64_t tessellations;
+	uint64_t bytesUploaded;
+	uint64_t promotions;
+	uint64_t evictions;
+} TextRunStats;
+
+/**
+ * Tessellated text runs retained across frames. A run is tessellated once,
+ * when its key is first seen. Runs drawn for TEXT_RUN_PROMOTE_FRAMES
+ * consecutive frames move to the persistent region and are never uploaded
+ * again; younger runs are copied every frame into a slice of the dynamic
+ * ring. Runs not drawn in a frame are evicted and their persistent quads
+ * zeroed. The cache only plans the uploads, the owner records them.
+ */
+class TextRunCache
+{
+public:
+	ENGINE_API TextRunCache(uint32_t persistentQuads, uint32_t dynamicQuads);
+
+	/** Returns the run and marks it as drawn this frame, or nullptr if it has to be tessellated */
+	ENGINE_API TextRun *Find(uint64_t key);
+	ENGINE_API TextRun *Add(uint64_t key);
+
+	/**
+	 * Evict, promote and place the runs of this frame. Vertex data is written
+	 * to staging, which may be null when GetDynamicRunCount() is 0.
+	 */
+	ENGINE_API void EndFrame(uint8_t *staging, size_t stagingSize, TextRunUpdate &update);
+
+	/** Drop every run, e.g. when the glyph atlas was evicted */
+	ENGINE_API void Clear();
+
+	ENGINE_API size_t GetRunCount() const noexcept { return _runs.size(); }
+	ENGINE_API uint32_t GetDynamicRunCount() const noexcept { return _dynamicRuns; }
+	ENGINE_API uint32_t GetPersistentCapacity() const noexcept { return _persistentCapacity; }
+	ENGINE_API uint32_t GetDynamicCapacity() const noexcept { return _dynamicCapacity; }
+	ENGINE_API const TextRunStats &GetStats() const noexcept { return _stats; }
+
+	ENGINE_API static uint64_t Hash(const void *data, size_t size, uint64_t hash = 14695981039346656037ULL) noexcept;
+
+private:
+	std::unordered_map<uint64_t, TextRun> _runs;
+	std::vector<std::pair<uint32_t, uint32_t>> _freeRanges;
+	uint32_t _persistentCapacity, _dynamicCapacity, _persistentTop;
+	uint32_t _dynamicRuns;
+	uint64_t _frame;
+	TextRunStats _stats;
+
+	bool _Allocate(uint32_t count, uint32_t &first);
+	void _Free(uint32_t first, uint32_t count, TextRunUpdate &update);
+};
@@ -43,6 +43,7 @@
 
 #include <Resource/Resource.h>
 #include <Resource/TextureResource.h>
+#include <Renderer/MemoryAllocator.h>
 
 enum SamplerFilter : uint8_t
 {
@@ -107,6 +108,7 @@ public:
 	VkFormat GetFormat() { return _format; }
 	uint32_t GetWidth() { return _width; }
 	uint32_t GetHeight() { return _height; }
+	uint32_t GetMipLevels() { return _mipLevels; }
 
 	bool CreateView(VkImageAspectFlags aspect, bool forceArray = false);
 
@@ -116,14 +118,16 @@ public:
 private:
 	VkImage _image;
 	VkDeviceMemory _imageMemory;
+	MemoryAllocation _allocation;
 	VkImageView _view;
 	VkFormat _format;
 	VkSampler _sampler;
 	VkImageType _type;
-	bool _isAttachment, _ownMemory;
+	bool _isAttachment;
 	uint32_t _width, _height, _depth, _mipLevels, _arrayLayers;
 
 	VkDeviceSize _GetByteSize(uint32_t width, uint32_t height);
+	bool _BindMemory(VkImageUsageFlags usage, VkImageTiling tiling);
 };
 
 #if defined(_MSC_VER)
@@ -51,6 +51,12 @@ public:
 	ResourceInfo *GetResourceInfo() noexcept { return _resourceInfo; }
 	virtual int Load() = 0;
 
+	/**
+	 * Load the resource again from its file, in place, so pointers to it
+	 * stay valid. Fails without changing the resource if the file is invalid.
+	 */
+	virtual int Reload() { return ENGINE_FAIL; }
+
 	int GetReferenceCount() noexcept { return _refCount; }
 	void IncrementReferenceCount() noexcept { _refCount++; }
 	void DecrementReferenceCount() noexcept { _refCount--; }
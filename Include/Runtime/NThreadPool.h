@@ -40,6 +40,7 @@
 #pragma once
 
 #include <mutex>
+#include <atomic>
 #include <queue>
 #include <thread>
 #include <assert.h>
@@ -145,7 +146,8 @@ public:
 private:
 	std::vector<std::thread> _workers;
 	std::queue<std::function<void(void)>> _tasks;
-	bool _stop, *_active;
+	std::atomic<bool> _stop;
+	bool *_active;
 	int32_t _numWorkers;
 	std::mutex _taskMutex;
 	std::condition_variable _condition;
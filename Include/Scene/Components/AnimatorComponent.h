@@ -43,6 +43,7 @@
 #include <Scene/ObjectComponent.h>
 #include <Animation/AnimationClip.h>
 #include <Animation/Skeleton.h>
+#include <Animation/AnimationGraph.h>
 
 class AnimatorComponent : public ObjectComponent
 {
@@ -68,13 +69,31 @@ public:
 	}
 	
 	ENGINE_API virtual void Update(double deltaTime) noexcept override;
-	ENGINE_API void UpdateData(VkCommandBuffer commandBuffer) noexcept override;
+
+	/**
+	 * Sample the animation and compute the bone matrices.
+	 * Called by the AnimationManager on a worker thread.
+	 */
+	ENGINE_API void Evaluate() noexcept;
 
 	ENGINE_API virtual bool Unload() override;
 
 	ENGINE_API virtual ~AnimatorComponent() { }
 
-	Buffer *GetSkeletonBuffer() const noexcept { return _skeleton->GetBuffer(); }	
+	Buffer *GetSkeletonBuffer() const noexcept { return _skeleton->GetBuffer(); }
+	ENGINE_API Skeleton *GetSkeleton() noexcept { return _skeleton; }
+
+	/**
+	 * Level of detail picked from the distance to the active camera.
+	 * Lower levels are evaluated less often; see AnimationManager.h
+	 */
+	ENGINE_API uint8_t GetLOD() const noexcept { return _lod; }
+
+	/**
+	 * When the graph has a root node it drives the skeleton and the single
+	 * clip playback functions have no effect.
+	 */
+	ENGINE_API AnimationGraph *GetGraph() noexcept { return _graph; }
 	
 protected:
 	std::string _defaultAnimId;
@@ -84,8 +103,11 @@ protected:
 	bool _loop;
 	bool _prevLoop;
 	bool _oneShot;
+	uint8_t _lod;
+	uint32_t _frameOffset;
 	
 	Skeleton *_skeleton;
 	AnimationClip *_defaultAnim;
 	AnimationClip *_prevClip;
+	AnimationGraph *_graph;
 };
@@ -39,18 +39,20 @@
 
 #pragma once
 
+#include <vector>
+
 #include <Engine/Engine.h>
 #include <Renderer/Renderer.h>
 #include <Scene/ObjectComponent.h>
 #include <Scene/Particles/Emitter.h>
-#include <Scene/Particles/Particle.h>
-
-struct ParticleTexture
-{
-	float age;
-	int index;
-};
+#include <Scene/Particles/ParticlePool.h>
+#include <Scene/Particles/ParticleSorter.h>
 
+/**
+ * Particle system simulated on the CPU. The particles are stored in a
+ * ParticlePool, simulated in chunks on the task manager, sorted back to front
+ * and drawn as a single batch of billboards per emitter.
+ */
 class ENGINE_API CPUParticleSystemComponent : public ObjectComponent
 {
 public:
@@ -64,14 +66,23 @@ public:
 
 	virtual bool Unload() override;
 
+	ParticlePool &GetPool() noexcept { return _pool; }
+
 	~CPUParticleSystemComponent() noexcept { }
 
 protected:
 	Emitter *_emitter;
-	NArray<Particle *> _particles;
-	NArrayTS<uint32_t> _deadList;
+	ParticlePool _pool;
+	ParticleSorter _sorter;
+	bool _depthSort;
+	EasingTable _speedCurve, _sizeCurve, _colorCurve;
+	glm::vec3 _acceleration;
+	std::vector<ParticleVertex> _vertices;
+	std::string _textureId;
+	Texture *_texture;
+	VkImageView _textureView;
+	Buffer *_particleBuffer;
+	VkDescriptorPool _descriptorPool;
+	VkDescriptorSet _descriptorSet;
+	VkCommandBuffer _drawCommandBuffer;
 };
-
-#if defined(_MSC_VER)
-template class ENGINE_API NArray<ParticleTexture>;
-#endif
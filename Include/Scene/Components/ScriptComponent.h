@@ -51,6 +51,7 @@ public:
 
 	virtual int Load() override;
 	virtual int InitializeComponent() override;
+	virtual void FixedUpdate() noexcept override;
 	virtual void Update(double deltaTime) noexcept override;
 	virtual void UpdatePosition() noexcept override;
 	virtual bool Unload() override;
@@ -61,11 +62,24 @@ public:
 	bool Invoke(const char *name);
 	void SetGlobalInteger(const char *name, int value);
 
+	/**
+	 * Run the new version of a script file in the components created from
+	 * it on the calling thread, keeping their state. Returns the number of
+	 * components reloaded.
+	 */
+	static int ReloadScript(const char *file);
+
 	~ScriptComponent() noexcept;
 
 protected:
 	struct lua_State *_state;
+	int _instance, _updateRef, _fixedUpdateRef, _updatePositionRef, _scriptId;
 	bool _enabled;
 	NString _scriptFile;
 	const char *_scriptSource;
+
+	int _Call(int nargs, int nresults);
+	bool _PushFunction(const char *name);
+	bool _Reload(int chunk);
+	void _GetFunctions();
 };
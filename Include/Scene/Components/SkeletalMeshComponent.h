@@ -69,6 +69,7 @@ public:
 	
 	virtual void UpdateData(VkCommandBuffer commandBuffer) noexcept override;
 	ENGINE_API virtual void DrawShadow(VkCommandBuffer commandBuffer, uint32_t shadowId) const noexcept override;
+	virtual bool HasAnimatedShadow() const noexcept override { return true; }
 
 protected:
 	SkeletalMesh *_mesh;
@@ -109,4 +109,5 @@ protected:
 
 	void _SortGroups();
 	void _UpdateModelMatrix();
+	void _FreeCommandBuffers();
 };
@@ -42,10 +42,16 @@
 #include <Engine/Engine.h>
 #include <Renderer/Material.h>
 #include <Renderer/StaticMesh.h>
+#include <Scene/TerrainQuadtree.h>
 #include <Scene/Components/StaticMeshComponent.h>
 
 #define SM_GENERATED	"generated"
 
+/**
+ * The whole terrain is one drawable with one material. Its command buffers
+ * issue one indirect draw per quadtree chunk, and every frame the chunks
+ * that are selected and inside the view get a non-empty command.
+ */
 class TerrainComponent : public StaticMeshComponent
 {
 public:
@@ -58,6 +64,10 @@ public:
 
 	ENGINE_API virtual int Load() override;
 	ENGINE_API virtual bool Upload(Buffer *buffer = nullptr) override;
+	ENGINE_API virtual void Update(double deltaTime) noexcept override;
+	ENGINE_API virtual void UpdateData(VkCommandBuffer commandBuffer) noexcept override;
+
+	ENGINE_API virtual bool InitDrawables() override;
 
 	ENGINE_API virtual bool Unload() override;
 	ENGINE_API virtual ~TerrainComponent() { };
@@ -65,12 +75,18 @@ public:
 	virtual VkDeviceSize GetRequiredMemorySize() const noexcept override;
 
 	ENGINE_API virtual void DrawShadow(VkCommandBuffer commandBuffer, uint32_t shadowId) const noexcept override;
+	virtual bool HasAnimatedShadow() const noexcept override { return _selectionChanged; }
 
 protected:
-	std::vector<TerrainVertex> _terrainVertices;
-	std::vector<uint32_t> _terrainIndices;
+	TerrainQuadtree _quadtree;
+	std::vector<uint32_t> _selectedChunks, _nextSelection;
+	std::vector<VkDrawIndexedIndirectCommand> _drawCommands;
+	uint32_t _drawCount;
+	bool _selectionChanged;
 	float _cellSize;
 	unsigned short _numCells;
+	uint32_t _chunkCells;
+	float _lodDistance;
 	float _uvStep;
 	NString _heightmapPath;
 	uint8_t *_heightmapData;
@@ -81,4 +97,5 @@ protected:
 	bool _GenerateTerrain() noexcept;
 	bool _LoadHeightmap() noexcept;
 	float _ReadHeightmap(float x, float y) noexcept;
+	void _SelectChunks() noexcept;
 };
\ No newline at end of file
@@ -165,6 +165,7 @@ public:
 	VkDeviceSize GetRequiredMemorySize();
 
 	ENGINE_API virtual void DrawShadow(VkCommandBuffer commandBuffer, uint32_t shadowId) const noexcept;
+	ENGINE_API bool HasAnimatedShadow() const noexcept;
 	ENGINE_API virtual void UpdateData(VkCommandBuffer commandBuffer) noexcept;
 
 protected:
@@ -173,11 +174,14 @@ protected:
 	glm::vec3 _position, _rotation, _scale;
 	glm::vec3 _center, _forward, _right;
 	glm::quat _rotationQuaternion;
+	glm::vec3 _prevPosition;
+	glm::quat _prevRotationQuaternion;
+	uint64_t _fixedFrame;
 	ForwardDirection _objectForward;
 	bool _loaded, _visible;
 	std::map<std::string, ObjectComponent*> _components;
 	glm::mat4 _translationMatrix, _scaleMatrix, _modelMatrix;
-	bool _updateWhilePaused, _noCull, _updateModelMatrix, _haveMesh, _enabled;
+	bool _updateWhilePaused, _noCull, _updateModelMatrix, _haveMesh, _enabled, _interpolating;
 	Buffer *_buffer;
 	NBounds _bounds, _transformedBounds;
 
@@ -197,6 +201,9 @@ protected:
 		_bounds.Transform(_modelMatrix, &_transformedBounds);
 	}
 
+	void _SavePreviousTransform() noexcept;
+	void _InterpolateModelMatrix(float alpha) noexcept;
+
 	inline void _UpdateTransformedBounds() noexcept
 	{
 		if (!_bounds.IsValid()) return;
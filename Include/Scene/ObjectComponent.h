@@ -92,6 +92,7 @@ public:
 	virtual int CreateBuffers() { return ENGINE_OK; }
 	virtual int InitializeComponent();
 	virtual bool Upload(Buffer *buffer) { (void)buffer; return true; }
+	virtual void FixedUpdate() noexcept { }
 	virtual void Update(double deltaTime) noexcept { (void)deltaTime; }
 	virtual void UpdatePosition() noexcept { }
 	
@@ -108,6 +109,7 @@ public:
 	virtual VkDeviceSize GetRequiredMemorySize() const noexcept { return 0; }
 	virtual void UpdateData(VkCommandBuffer commandBuffer) noexcept { (void)commandBuffer; }
 	virtual void DrawShadow(VkCommandBuffer commandBuffer, uint32_t shadowId) const noexcept { (void)commandBuffer; (void)shadowId; }
+	virtual bool HasAnimatedShadow() const noexcept { return false; }
 
 protected:
 	class Object *_parent;
@@ -39,6 +39,47 @@
 
 #pragma once
 
+#include <stdint.h>
+
+#define PART_UPD_CURVE_LINEAR		0
+#define PART_UPD_CURVE_QUADRATIC	1
+#define PART_UPD_CURVE_CUBIC		2
+#define PART_UPD_CURVE_QUARTIC		3
+#define PART_UPD_CURVE_QUINTIC		4
+#define PART_UPD_CURVE_SINE			5
+#define PART_UPD_CURVE_CIRCULAR		6
+#define PART_UPD_CURVE_EXPONENTIAL	7
+#define PART_UPD_CURVE_ELASTIC		8
+#define PART_UPD_CURVE_BACK			9
+#define PART_UPD_CURVE_BOUNCE		11
+
+#define EASING_TABLE_SIZE			256
+
+typedef double (*CurveFunction)(double);
+
+/**
+ * Returns the in-out variant of the curve, or linear for unknown ids
+ */
+CurveFunction GetCurveFunction(uint8_t id);
+
+/**
+ * Curve sampled at EASING_TABLE_SIZE + 1 evenly spaced points in [0, 1].
+ * The last value is repeated so that a lookup at t = 1 can read one past it.
+ */
+struct EasingTable
+{
+	float values[EASING_TABLE_SIZE + 2];
+
+	void Build(CurveFunction curve, bool invert = false) noexcept;
+
+	inline float Sample(float t) const noexcept
+	{
+		const float x{ t * EASING_TABLE_SIZE };
+		const int32_t i{ (int32_t)x };
+		return values[i] + (values[i + 1] - values[i]) * (x - (float)i);
+	}
+};
+
 double linearEase(double p);
 double quadraticEaseIn(double p);
 double quadraticEaseOut(double p);
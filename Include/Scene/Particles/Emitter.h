@@ -41,7 +41,10 @@
 
 #include <Engine/Defs.h>
 #include <Runtime/Runtime.h>
-#include <Scene/Particles/Particle.h>
+#include <Scene/Particles/ParticlePool.h>
+#include <Scene/Particles/ParticleRandom.h>
+
+class StaticMesh;
 
 #define EMITTER_QUAD		0
 #define EMITTER_CIRCLE		1
@@ -55,8 +58,7 @@ class Emitter
 public:
 	ENGINE_API Emitter();
 
-	ENGINE_API void SetParticles(NArray<Particle *> *particles) { _particles = particles; }
-	ENGINE_API void SetDeadList(NArrayTS<uint32_t> *deadList) { _deadList = deadList; }
+	ENGINE_API void SetPool(ParticlePool *pool) { _pool = pool; }
 	ENGINE_API void SetPosition(glm::vec3 &position) { _position = position; }
 	ENGINE_API void SetRotation(glm::vec3 &rotation) { _rotation = rotation; }
 	ENGINE_API void SetScale(glm::vec3 &scale) { _scale = scale; }
@@ -72,17 +74,30 @@ public:
 	ENGINE_API void SetVelocityCurve(uint8_t curveId) { _velocityCurve = curveId; }
 	ENGINE_API void SetColorCurve(uint8_t curveId) { _colorCurve = curveId; }
 	ENGINE_API void SetSizeCurve(uint8_t curveId) { _sizeCurve = curveId; }
+	ENGINE_API void SetSeed(uint64_t seed) { _seed = seed; _emission = 0; }
 
-	ENGINE_API int InitializeParticles();
+	ENGINE_API uint32_t GetMaxParticles() const { return _maxParticles; }
+	ENGINE_API float GetInitialSize() const { return (float)_initialSize; }
+	ENGINE_API float GetFinalSize() const { return (float)_finalSize; }
+	ENGINE_API const glm::vec4 &GetInitialColor() const { return _initialColor; }
+	ENGINE_API const glm::vec4 &GetFinalColor() const { return _finalColor; }
+	ENGINE_API uint8_t GetVelocityCurve() const { return _velocityCurve; }
+	ENGINE_API uint8_t GetColorCurve() const { return _colorCurve; }
+	ENGINE_API uint8_t GetSizeCurve() const { return _sizeCurve; }
 
 	ENGINE_API virtual void Update(double deltaTime) noexcept;
 
+	/**
+	 * Emit up to the maximum emit count. The new particles are initialized
+	 * in parallel; each chunk draws from its own random stream, so the result
+	 * depends only on the seed and the number of previous emissions.
+	 */
 	ENGINE_API void Emit();
 
 	ENGINE_API virtual ~Emitter();
 
 protected:
-	NArray<Particle *> *_particles;
+	ParticlePool *_pool;
 	glm::vec3 _position, _rotation, _scale;
 	uint32_t _maxEmit, _maxParticles;
 	uint8_t _velocityCurve, _colorCurve, _sizeCurve;
@@ -91,11 +106,13 @@ protected:
 	double _lifespan;
 	glm::vec3 _initialVelocity;
 	glm::vec4 _initialColor, _finalColor;
-	NString _particleClass;
-	ObjectInitializer _particleInitializer;
-	NArrayTS<uint32_t> *_deadList;
+	uint64_t _seed, _emission;
 
-	virtual void _EmitParticle(uint32_t id) = 0;
+	/**
+	 * Set the initial position of a newly emitted particle. Called
+	 * concurrently from worker threads.
+	 */
+	virtual void _EmitParticle(ParticleData &data, uint32_t id, ParticleRandom &random) = 0;
 };
 
 class QuadEmitter : public Emitter
@@ -105,7 +122,7 @@ public:
 	ENGINE_API ~QuadEmitter();
 
 protected:
-	virtual void _EmitParticle(uint32_t id) override;
+	virtual void _EmitParticle(ParticleData &data, uint32_t id, ParticleRandom &random) override;
 };
 
 class CircleEmitter : public Emitter
@@ -115,7 +132,7 @@ public:
 	ENGINE_API ~CircleEmitter();
 
 protected:
-	virtual void _EmitParticle(uint32_t id) override;
+	virtual void _EmitParticle(ParticleData &data, uint32_t id, ParticleRandom &random) override;
 };
 
 class SphereEmitter : public Emitter
@@ -125,7 +142,7 @@ public:
 	ENGINE_API ~SphereEmitter();
 
 protected:
-	virtual void _EmitParticle(uint32_t id) override;
+	virtual void _EmitParticle(ParticleData &data, uint32_t id, ParticleRandom &random) override;
 };
 
 class BoxEmitter : public Emitter
@@ -135,7 +152,7 @@ public:
 	ENGINE_API ~BoxEmitter();
 
 protected:
-	virtual void _EmitParticle(uint32_t id) override;
+	virtual void _EmitParticle(ParticleData &data, uint32_t id, ParticleRandom &random) override;
 };
 
 class PointEmitter : public Emitter
@@ -145,7 +162,7 @@ public:
 	ENGINE_API ~PointEmitter();
 
 protected:
-	virtual void _EmitParticle(uint32_t id) override;
+	virtual void _EmitParticle(ParticleData &data, uint32_t id, ParticleRandom &random) override;
 };
 
 class MeshEmitter : public Emitter
@@ -158,5 +175,5 @@ public:
 
 protected:
 	StaticMesh *_mesh;
-	virtual void _EmitParticle(uint32_t id) override;
+	virtual void _EmitParticle(ParticleData &data, uint32_t id, ParticleRandom &random) override;
 };
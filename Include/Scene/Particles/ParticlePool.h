@@ -0,0 +1,117 @@
+/* NekoEngine
+ *
+ * ParticlePool.h
+ * Author: Alexandru Naiman
+ *
+ * Structure of arrays particle storage
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <Engine/Defs.h>
+#include <Engine/Vertex.h>
+#include <Scene/Particles/Easing.h>
+
+/**
+ * Per-particle streams. Every stream holds capacity rounded up to a multiple
+ * of 4 floats so the simulation can process four particles at a time.
+ */
+struct ParticleData
+{
+	float *positionX, *positionY, *positionZ;
+	float *velocityX, *velocityY, *velocityZ;
+	float *age;
+	float *invLifespan;
+};
+
+/**
+ * Alive particles are kept packed at the start of the streams. Emitting
+ * appends after the last alive particle and killing one moves the last alive
+ * particle in its place, so both are O(1) and no free list is needed.
+ */
+class ParticlePool
+{
+public:
+	ENGINE_API ParticlePool() noexcept;
+
+	ENGINE_API void Resize(uint32_t capacity);
+	ENGINE_API void Clear() noexcept { _alive = 0; }
+
+	ENGINE_API uint32_t GetCapacity() const noexcept { return _capacity; }
+	ENGINE_API uint32_t GetAliveCount() const noexcept { return _alive; }
+	ENGINE_API ParticleData &GetData() noexcept { return _data; }
+	ENGINE_API const ParticleData &GetData() const noexcept { return _data; }
+
+	/**
+	 * Reserve up to count particles after the last alive one.
+	 * Returns the number of particles reserved; the caller initializes them.
+	 */
+	ENGINE_API uint32_t Emit(uint32_t count) noexcept;
+	ENGINE_API void Kill(uint32_t id) noexcept;
+
+	/**
+	 * Age and integrate the particles in [begin, end). The speed is scaled
+	 * by speedCurve sampled at the normalized age.
+	 */
+	ENGINE_API void Integrate(uint32_t begin, uint32_t end, float deltaTime, const glm::vec3 &acceleration, const EasingTable &speedCurve) noexcept;
+
+	/**
+	 * Remove the particles that outlived their lifespan
+	 */
+	ENGINE_API void RemoveDead() noexcept;
+
+	ENGINE_API void Update(float deltaTime, const glm::vec3 &acceleration, const EasingTable &speedCurve) noexcept
+	{
+		Integrate(0, _alive, deltaTime, acceleration, speedCurve);
+		RemoveDead();
+	}
+
+	/**
+	 * Write billboard vertices [begin, end). If order is set, vertex i is
+	 * written from particle order[i], otherwise from particle i.
+	 */
+	ENGINE_API void WriteVertices(uint32_t begin, uint32_t end, ParticleVertex *vertices,
+		float initialSize, float finalSize, const EasingTable &sizeCurve,
+		const glm::vec4 &initialColor, const glm::vec4 &finalColor, const EasingTable &colorCurve,
+		const uint32_t *order = nullptr) const noexcept;
+
+	ENGINE_API ~ParticlePool() { }
+
+private:
+	std::vector<float> _streams;
+	ParticleData _data;
+	uint32_t _capacity, _alive;
+};
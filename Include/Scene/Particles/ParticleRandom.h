@@ -0,0 +1,76 @@
+/* NekoEngine
+ *
+ * ParticleRandom.h
+ * Author: Alexandru Naiman
+ *
+ * Deterministic random streams for particle emission
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Counter based generator (SplitMix64). Every emission chunk owns a stream
+ * derived from the emitter seed and the chunk index, so the generated values
+ * do not depend on which worker thread runs the chunk.
+ */
+struct ParticleRandom
+{
+	uint64_t state;
+
+	ParticleRandom(uint64_t seed, uint64_t stream) noexcept :
+		state{ seed }
+	{
+		state ^= Mix(stream + 0x9E3779B97F4A7C15ull);
+	}
+
+	static uint64_t Mix(uint64_t z) noexcept
+	{
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	uint32_t Next() noexcept
+	{
+		state += 0x9E3779B97F4A7C15ull;
+		return (uint32_t)(Mix(state) >> 32);
+	}
+
+	/**
+	 * Uniform float in [0, 1)
+	 */
+	float NextFloat() noexcept { return (float)(Next() >> 8) * (1.f / 16777216.f); }
+};
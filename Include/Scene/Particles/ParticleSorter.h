@@ -0,0 +1,72 @@
+/* NekoEngine
+ *
+ * ParticleSorter.h
+ * Author: Alexandru Naiman
+ *
+ * Parallel depth sort for CPU particles
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <Engine/Defs.h>
+#include <Scene/Particles/ParticlePool.h>
+
+/**
+ * Orders the alive particles of a pool back to front with a LSD radix sort
+ * on the squared distance to the eye. Keys are split into fixed size chunks
+ * that are histogrammed and scattered on the task manager; the sort is stable
+ * and the chunking does not depend on the worker count, so the order is the
+ * same on every run.
+ */
+class ParticleSorter
+{
+public:
+	ENGINE_API ParticleSorter() noexcept;
+
+	/**
+	 * Sort the alive particles of pool. Returns the particle indices in
+	 * drawing order; the array is valid until the next call.
+	 */
+	ENGINE_API const uint32_t *Sort(const ParticlePool &pool, const glm::vec3 &eye);
+
+	ENGINE_API const uint32_t *GetOrder() const noexcept { return _indices[0].data(); }
+
+	ENGINE_API ~ParticleSorter() { }
+
+private:
+	std::vector<uint32_t> _keys[2], _indices[2];
+	std::vector<uint32_t> _histograms;
+};
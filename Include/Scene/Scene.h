@@ -95,6 +95,7 @@ public:
 	ENGINE_API OcTree *GetOcTree() noexcept { return _ocTree; }
 	
 	ENGINE_API int Load();
+	ENGINE_API void FixedUpdate() noexcept;
 	ENGINE_API void Update(double deltaTime) noexcept;
 	ENGINE_API void Unload() noexcept;
 
@@ -120,7 +121,8 @@ public:
 #ifdef ENGINE_INTERNAL
 	Buffer *GetSceneBuffer() noexcept { return _sceneBuffer; }
 	void UpdateData(VkCommandBuffer buffer) noexcept;
-	void DrawShadow(VkCommandBuffer commandBuffer, uint32_t shadowId) noexcept;
+	void UpdateShadowCasters(class ShadowCache *cache) noexcept;
+	void GetShadowCasters(const NFrustum &frustum, NArray<const Object *> &casters) noexcept { _ocTree->GetVisible(frustum, casters); }
 #endif
 
 private:
@@ -141,6 +143,7 @@ private:
 	Object *_LoadObject(VFSFile *f, NString &className);
 	void _LoadSceneInfo(VFSFile *f);
 	void _LoadComponent(VFSFile *f, struct COMPONNENT_INITIALIZER_INFO *initInfo);
+	void _BuildRenderQueue() noexcept;
 #endif
 };
 
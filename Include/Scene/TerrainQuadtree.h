@@ -0,0 +1,128 @@
+/* NekoEngine
+ *
+ * TerrainQuadtree.h
+ * Author: Alexandru Naiman
+ *
+ * Terrain chunk quadtree
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <stdint.h>
+
+#include <Engine/Vertex.h>
+#include <Runtime/NBounds.h>
+#include <Runtime/NFrustum.h>
+
+#define TQT_DEFAULT_CHUNK_CELLS		32
+#define TQT_DEFAULT_LOD_DISTANCE	2.f
+#define TQT_MAX_DEPTH				8
+#define TQT_NO_CHILDREN				0xFFFFFFFF
+
+#define TQT_EDGE_NORTH				0x01
+#define TQT_EDGE_SOUTH				0x02
+#define TQT_EDGE_WEST				0x04
+#define TQT_EDGE_EAST				0x08
+
+/**
+ * Returns the terrain height at a vertex of the finest grid.
+ * Called concurrently while the chunks are built.
+ */
+typedef std::function<float(uint32_t x, uint32_t z)> TerrainHeightFunc;
+
+typedef struct TERRAIN_CHUNK
+{
+	uint32_t level;
+	uint32_t x, z;			// origin on the finest grid
+	uint32_t step;			// finest cells covered by one chunk cell
+	uint32_t firstChild;	// children are stored contiguously
+	uint32_t vertexOffset;
+	uint32_t indexOffset;
+	uint32_t indexCount;
+	uint8_t skirtEdges;
+	NBounds bounds;
+} TerrainChunk;
+
+/**
+ * Chunked LOD terrain. Every quadtree node owns a grid of the same
+ * resolution covering its area, so the node size doubles with each level
+ * up the tree while the vertex count stays the same. Chunks of different
+ * levels are joined by skirts hanging from the interior chunk edges.
+ */
+class TerrainQuadtree
+{
+public:
+	TerrainQuadtree() :
+		_numCells(0), _chunkCells(0), _depth(0),
+		_cellSize(0.f)
+	{ }
+
+	/**
+	 * Build the tree and the geometry of every chunk.
+	 * The depth is the largest one that divides numCells evenly and keeps
+	 * at least chunkCells cells per leaf chunk.
+	 */
+	bool Build(uint32_t numCells, uint32_t chunkCells, float cellSize, const TerrainHeightFunc &height);
+
+	/**
+	 * Select the chunks to draw for the view position (in terrain space).
+	 * A node is split while the view is closer than lodDistance times its size.
+	 * Nodes outside the frustum are skipped with their subtree when one is supplied.
+	 */
+	void Select(const glm::vec3 &viewPosition, float lodDistance, const NFrustum *frustum, std::vector<uint32_t> &selected) const;
+
+	const std::vector<TerrainChunk> &GetChunks() const noexcept { return _chunks; }
+	const std::vector<TerrainVertex> &GetVertices() const noexcept { return _vertices; }
+	const std::vector<uint32_t> &GetIndices() const noexcept { return _indices; }
+	const NBounds &GetBounds() const noexcept { return _chunks[0].bounds; }
+
+	uint32_t GetChunkCells() const noexcept { return _chunkCells; }
+	uint32_t GetChunkVertexCount() const noexcept { return (_chunkCells + 1) * (_chunkCells + 5); }
+	uint32_t GetDepth() const noexcept { return _depth; }
+	float GetChunkSize(const TerrainChunk &chunk) const noexcept { return _chunkCells * chunk.step * _cellSize; }
+
+	void Clear() noexcept;
+
+private:
+	uint32_t _numCells, _chunkCells, _depth;
+	float _cellSize;
+	std::vector<TerrainChunk> _chunks;
+	std::vector<TerrainVertex> _vertices;
+	std::vector<uint32_t> _indices;
+
+	void _BuildChunk(TerrainChunk &chunk, const TerrainHeightFunc &height) noexcept;
+	void _Select(uint32_t id, const glm::vec3 &viewPosition, float lodDistance, const NFrustum *frustum, std::vector<uint32_t> &selected) const;
+};
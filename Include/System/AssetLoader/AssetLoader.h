@@ -61,6 +61,7 @@
 #define NANIM1_HEADER	"NANIM1 "
 #define NANIM2_HEADER	"NANIM2 "
 #define NANIM2_FOOTER	"ENDANIM"
+#define NANIM3_HEADER	"NANIM3 "
 
 class AssetLoader
 {
@@ -283,4 +284,10 @@ private:
 		double *duration,
 		double *ticksPerSecond,
 		std::vector<AnimationNode> &channels);
+
+	static int _LoadAnimationV3(VFSFile *file,
+		std::string &name,
+		double *duration,
+		double *ticksPerSecond,
+		std::vector<AnimationNode> &channels);
 };
\ No newline at end of file
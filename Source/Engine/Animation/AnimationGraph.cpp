@@ -0,0 +1,437 @@
+/* NekoEngine
+ *
+ * AnimationGraph.cpp
+ * Author: Alexandru Naiman
+ *
+ * Animation blend graph and state machine implementation
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Animation/Skeleton.h>
+#include <Animation/AnimationClip.h>
+#include <Animation/AnimationGraph.h>
+
+using namespace std;
+using namespace glm;
+
+static inline quat _Nlerp(const quat &a, const quat &b, float t) noexcept
+{
+	const quat c{ dot(a, b) < 0.f ? -b : b };
+	return normalize(a * (1.f - t) + c * t);
+}
+
+static inline void _BlendNode(SkeletonPose &a, const SkeletonPose &b, size_t i, float t) noexcept
+{
+	a.translations[i] = mix(a.translations[i], b.translations[i], t);
+	a.rotations[i] = _Nlerp(a.rotations[i], b.rotations[i], t);
+	a.scales[i] = mix(a.scales[i], b.scales[i], t);
+}
+
+/**
+ * a = lerp(a, b, t)
+ */
+static inline void _Blend(SkeletonPose &a, const SkeletonPose &b, float t) noexcept
+{
+	for (size_t i = 0; i < a.Count(); ++i)
+		_BlendNode(a, b, i, t);
+}
+
+// Clip
+
+AnimationClipNode::AnimationClipNode(AnimationGraph *graph, AnimationClip *clip, bool loop, float speed) noexcept :
+	AnimationGraphNode(graph),
+	_time(0.0),
+	_speed(speed),
+	_loop(loop)
+{
+	_sampler.Bind(graph->GetSkeleton(), clip);
+}
+
+bool AnimationClipNode::IsFinished() const noexcept
+{
+	return !_loop && GetNormalizedTime() >= 1.f;
+}
+
+void AnimationClipNode::Evaluate(SkeletonPose &pose) noexcept
+{
+	const Skeleton *skeleton{ _graph->GetSkeleton() };
+
+	pose.CopyFrom(skeleton->GetBindPose());
+	_sampler.Sample(_sampler.GetClipTime(_time, _loop), pose, skeleton->GetSampleMask());
+}
+
+void AnimationClipNode::Reset() noexcept
+{
+	_time = 0.0;
+	_sampler.Reset();
+}
+
+float AnimationClipNode::GetNormalizedTime() const noexcept
+{
+	AnimationClip *clip{ _sampler.GetClip() };
+
+	if (!clip || clip->GetDuration() <= 0.0)
+		return 1.f;
+
+	return (float)(_sampler.GetClipTime(_time, _loop) / clip->GetDuration());
+}
+
+// Blend
+
+AnimationBlendNode::AnimationBlendNode(AnimationGraph *graph, AnimationGraphNode *a, AnimationGraphNode *b, int32_t parameter) noexcept :
+	AnimationGraphNode(graph),
+	_a(a), _b(b),
+	_parameter(parameter),
+	_weight(1.f)
+{
+	_scratch.Resize(graph->GetSkeleton()->GetNodeCount());
+}
+
+float AnimationBlendNode::GetWeight() const noexcept
+{
+	return glm::clamp(_parameter == ANIM_NO_PARAMETER ? _weight : _graph->GetParameter(_parameter), 0.f, 1.f);
+}
+
+void AnimationBlendNode::Update(double deltaTime) noexcept
+{
+	_a->Update(deltaTime);
+	_b->Update(deltaTime);
+}
+
+void AnimationBlendNode::Reset() noexcept
+{
+	_a->Reset();
+	_b->Reset();
+}
+
+void AnimationLerpNode::Evaluate(SkeletonPose &pose) noexcept
+{
+	const float w{ GetWeight() };
+
+	// Skip the input that does not contribute
+	if (w <= 0.f)
+	{
+		_a->Evaluate(pose);
+	}
+	else if (w >= 1.f)
+	{
+		_b->Evaluate(pose);
+	}
+	else
+	{
+		_a->Evaluate(pose);
+		_b->Evaluate(_scratch);
+		_Blend(pose, _scratch, w);
+	}
+}
+
+void AnimationAdditiveNode::Evaluate(SkeletonPose &pose) noexcept
+{
+	const float w{ GetWeight() };
+	const SkeletonPose &ref{ _graph->GetSkeleton()->GetBindPose() };
+
+	_a->Evaluate(pose);
+
+	if (w <= 0.f)
+		return;
+
+	_b->Evaluate(_scratch);
+
+	for (size_t i = 0; i < pose.Count(); ++i)
+	{
+		const quat delta{ inverse(ref.rotations[i]) * _scratch.rotations[i] };
+		const vec3 &refScale{ ref.scales[i] };
+		const vec3 scale{ refScale.x != 0.f ? _scratch.scales[i].x / refScale.x : 1.f,
+						  refScale.y != 0.f ? _scratch.scales[i].y / refScale.y : 1.f,
+						  refScale.z != 0.f ? _scratch.scales[i].z / refScale.z : 1.f };
+
+		pose.translations[i] += (_scratch.translations[i] - ref.translations[i]) * w;
+		pose.rotations[i] = normalize(pose.rotations[i] * _Nlerp(quat(1.f, 0.f, 0.f, 0.f), delta, w));
+		pose.scales[i] *= mix(vec3(1.f), scale, w);
+	}
+}
+
+AnimationMaskNode::AnimationMaskNode(AnimationGraph *graph, AnimationGraphNode *base, AnimationGraphNode *overlay, const char *rootNode, int32_t parameter) noexcept :
+	AnimationBlendNode(graph, base, overlay, parameter)
+{
+	const Skeleton *skel{ graph->GetSkeleton() };
+	const int16_t root{ skel->GetNodeIndex(rootNode) };
+
+	// Parents precede their children, so one pass marks the whole subtree
+	_mask.resize(skel->GetNodeCount(), 0);
+	for (uint16_t i = 0; i < skel->GetNodeCount(); ++i)
+	{
+		const int16_t parent{ skel->GetParentIndex(i) };
+		_mask[i] = (i == root || (parent != SKEL_NO_PARENT && _mask[parent])) ? 1 : 0;
+	}
+}
+
+void AnimationMaskNode::Evaluate(SkeletonPose &pose) noexcept
+{
+	const float w{ GetWeight() };
+
+	_a->Evaluate(pose);
+
+	if (w <= 0.f)
+		return;
+
+	_b->Evaluate(_scratch);
+
+	for (size_t i = 0; i < pose.Count(); ++i)
+		if (_mask[i])
+			_BlendNode(pose, _scratch, i, w);
+}
+
+// State machine
+
+AnimationStateMachine::AnimationStateMachine(AnimationGraph *graph) noexcept :
+	AnimationGraphNode(graph),
+	_current(ANIM_NO_STATE), _next(ANIM_NO_STATE),
+	_fadeTime(0.0), _fadeDuration(0.0)
+{
+	_scratch.Resize(graph->GetSkeleton()->GetNodeCount());
+}
+
+int16_t AnimationStateMachine::AddState(const char *name, AnimationGraphNode *node)
+{
+	_states.push_back({ name, node });
+
+	if (_current == ANIM_NO_STATE)
+	{
+		_current = 0;
+		node->Reset();
+	}
+
+	return (int16_t)(_states.size() - 1);
+}
+
+int16_t AnimationStateMachine::GetStateIndex(const char *name) const noexcept
+{
+	for (size_t i = 0; i < _states.size(); ++i)
+		if (_states[i].name == name)
+			return (int16_t)i;
+
+	return ANIM_NO_STATE;
+}
+
+void AnimationStateMachine::SetState(int16_t state, float duration) noexcept
+{
+	if (state < 0 || state >= (int16_t)_states.size())
+		return;
+
+	if (_next != ANIM_NO_STATE)
+	{
+		_current = _next;
+		_next = ANIM_NO_STATE;
+	}
+
+	if (state == _current)
+		return;
+
+	_states[state].node->Reset();
+
+	if (_current == ANIM_NO_STATE || duration <= 0.f)
+	{
+		_current = state;
+		return;
+	}
+
+	_next = state;
+	_fadeTime = 0.0;
+	_fadeDuration = duration;
+}
+
+bool AnimationStateMachine::_CanTransition(const AnimationTransition &transition) const noexcept
+{
+	if (transition.parameter == ANIM_NO_PARAMETER && transition.exitTime < 0.f)
+		return false;
+
+	if (transition.exitTime >= 0.f && _states[_current].node->GetNormalizedTime() < transition.exitTime)
+		return false;
+
+	if (transition.parameter == ANIM_NO_PARAMETER)
+		return true;
+
+	const float value{ _graph->GetParameter(transition.parameter) };
+	return transition.condition == ANIM_COND_LESS ? value < transition.threshold : value > transition.threshold;
+}
+
+void AnimationStateMachine::Update(double deltaTime) noexcept
+{
+	if (_current == ANIM_NO_STATE)
+		return;
+
+	_states[_current].node->Update(deltaTime);
+
+	if (_next != ANIM_NO_STATE)
+	{
+		_states[_next].node->Update(deltaTime);
+
+		_fadeTime += deltaTime;
+		if (_fadeTime >= _fadeDuration)
+		{
+			_current = _next;
+			_next = ANIM_NO_STATE;
+		}
+
+		return;
+	}
+
+	for (const AnimationTransition &t : _transitions)
+	{
+		if ((t.from != ANIM_ANY_STATE && t.from != _current) || t.to == _current)
+			continue;
+
+		if (!_CanTransition(t))
+			continue;
+
+		SetState(t.to, t.duration);
+		break;
+	}
+}
+
+void AnimationStateMachine::Evaluate(SkeletonPose &pose) noexcept
+{
+	if (_current == ANIM_NO_STATE)
+	{
+		pose.CopyFrom(_graph->GetSkeleton()->GetBindPose());
+		return;
+	}
+
+	_states[_current].node->Evaluate(pose);
+
+	if (_next == ANIM_NO_STATE)
+		return;
+
+	_states[_next].node->Evaluate(_scratch);
+	_Blend(pose, _scratch, (float)glm::clamp(_fadeTime / _fadeDuration, 0.0, 1.0));
+}
+
+void AnimationStateMachine::Reset() noexcept
+{
+	_next = ANIM_NO_STATE;
+	_current = _states.empty() ? ANIM_NO_STATE : 0;
+
+	if (_current != ANIM_NO_STATE)
+		_states[_current].node->Reset();
+}
+
+float AnimationStateMachine::GetNormalizedTime() const noexcept
+{
+	return _current == ANIM_NO_STATE ? 0.f : _states[_current].node->GetNormalizedTime();
+}
+
+// Graph
+
+AnimationGraph::AnimationGraph(Skeleton *skeleton) noexcept :
+	_skeleton(skeleton),
+	_root(nullptr)
+{
+}
+
+void AnimationGraph::SetRoot(AnimationGraphNode *root) noexcept
+{
+	_root = root;
+
+	if (_root)
+		_root->Reset();
+}
+
+AnimationClipNode *AnimationGraph::AddClip(AnimationClip *clip, bool loop, float speed)
+{
+	AnimationClipNode *node{ new AnimationClipNode(this, clip, loop, speed) };
+	_nodes.push_back(node);
+	return node;
+}
+
+AnimationLerpNode *AnimationGraph::AddLerp(AnimationGraphNode *a, AnimationGraphNode *b, const char *parameter)
+{
+	AnimationLerpNode *node{ new AnimationLerpNode(this, a, b, GetParameterId(parameter)) };
+	_nodes.push_back(node);
+	return node;
+}
+
+AnimationAdditiveNode *AnimationGraph::AddAdditive(AnimationGraphNode *base, AnimationGraphNode *additive, const char *parameter)
+{
+	AnimationAdditiveNode *node{ new AnimationAdditiveNode(this, base, additive, GetParameterId(parameter)) };
+	_nodes.push_back(node);
+	return node;
+}
+
+AnimationMaskNode *AnimationGraph::AddMask(AnimationGraphNode *base, AnimationGraphNode *overlay, const char *rootNode, const char *parameter)
+{
+	if (_skeleton->GetNodeIndex(rootNode) == SKEL_NO_PARENT)
+		return nullptr;
+
+	AnimationMaskNode *node{ new AnimationMaskNode(this, base, overlay, rootNode, GetParameterId(parameter)) };
+	_nodes.push_back(node);
+	return node;
+}
+
+AnimationStateMachine *AnimationGraph::AddStateMachine()
+{
+	AnimationStateMachine *node{ new AnimationStateMachine(this) };
+	_nodes.push_back(node);
+	return node;
+}
+
+int32_t AnimationGraph::GetParameterId(const char *name)
+{
+	if (!name)
+		return ANIM_NO_PARAMETER;
+
+	unordered_map<string, int32_t>::iterator it{ _parameterMap.find(name) };
+	if (it != _parameterMap.end())
+		return it->second;
+
+	_parameters.push_back(0.f);
+	return _parameterMap[name] = (int32_t)_parameters.size() - 1;
+}
+
+void AnimationGraph::Update(double deltaTime) noexcept
+{
+	if (_root)
+		_root->Update(deltaTime);
+}
+
+void AnimationGraph::Evaluate(SkeletonPose &pose) noexcept
+{
+	if (_root)
+		_root->Evaluate(pose);
+}
+
+AnimationGraph::~AnimationGraph()
+{
+	for (AnimationGraphNode *node : _nodes)
+		delete node;
+}
@@ -0,0 +1,214 @@
+/* NekoEngine
+ *
+ * AnimationManager.cpp
+ * Author: Alexandru Naiman
+ *
+ * Skinning scheduler and shared bone palette
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include <Engine/TaskManager.h>
+#include <Animation/AnimationManager.h>
+#include <Scene/Components/AnimatorComponent.h>
+#include <Renderer/VKUtil.h>
+#include <Renderer/Renderer.h>
+#include <Renderer/DebugMarker.h>
+#include <System/Logger.h>
+
+#define ANIMMGR_MODULE		"AnimationManager"
+#define ANIMMGR_GRAIN		8
+
+using namespace std;
+
+Buffer *AnimationManager::_paletteBuffer{ nullptr };
+TrMat *AnimationManager::_palette{ nullptr };
+uint32_t AnimationManager::_paletteSize{ 0 };
+uint32_t AnimationManager::_alignment{ 1 };
+uint32_t AnimationManager::_frame{ 0 };
+uint32_t AnimationManager::_dirtyBegin{ UINT32_MAX };
+uint32_t AnimationManager::_dirtyEnd{ 0 };
+vector<AnimationManager::PaletteRange> AnimationManager::_freeRanges{};
+vector<AnimatorComponent *> AnimationManager::_queue{};
+
+int AnimationManager::Initialize()
+{
+	_paletteSize = Engine::GetConfiguration().Animation.MaxBones;
+	if (!_paletteSize)
+		_paletteSize = 65536;
+
+	// Skeleton ranges are bound as storage buffer descriptors, so they must start at a valid offset
+	VkPhysicalDeviceProperties props{};
+	vkGetPhysicalDeviceProperties(VKUtil::GetPhysicalDevice(), &props);
+	_alignment = (uint32_t)((props.limits.minStorageBufferOffsetAlignment + sizeof(TrMat) - 1) / sizeof(TrMat));
+	if (!_alignment) _alignment = 1;
+
+	const VkDeviceSize size{ sizeof(TrMat) * _paletteSize };
+
+	if ((_paletteBuffer = new Buffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, nullptr, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) == nullptr)
+	{
+		Logger::Log(ANIMMGR_MODULE, LOG_CRITICAL, "Failed to create palette buffer");
+		return ENGINE_OUT_OF_RESOURCES;
+	}
+	VK_DBG_SET_OBJECT_NAME((uint64_t)_paletteBuffer->GetHandle(), VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Bone palette");
+
+	// The skeletons write their matrices here; the dirty range goes out through the staging ring
+	if ((_palette = new TrMat[_paletteSize]) == nullptr)
+	{
+		Logger::Log(ANIMMGR_MODULE, LOG_CRITICAL, "Failed to allocate palette");
+		return ENGINE_OUT_OF_RESOURCES;
+	}
+
+	_freeRanges.push_back({ 0, _paletteSize });
+	_queue.reserve(256);
+
+	Logger::Log(ANIMMGR_MODULE, LOG_INFORMATION, "Initialized with a palette of %d bones", _paletteSize);
+
+	return ENGINE_OK;
+}
+
+uint32_t AnimationManager::AllocatePalette(uint32_t count) noexcept
+{
+	count = ((count + _alignment - 1) / _alignment) * _alignment;
+
+	for (size_t i = 0; i < _freeRanges.size(); ++i)
+	{
+		PaletteRange &range{ _freeRanges[i] };
+		if (range.count < count)
+			continue;
+
+		const uint32_t offset{ range.offset };
+		range.offset += count;
+		range.count -= count;
+
+		if (!range.count)
+			_freeRanges.erase(_freeRanges.begin() + i);
+
+		return offset;
+	}
+
+	Logger::Log(ANIMMGR_MODULE, LOG_CRITICAL, "Bone palette full, increase [Animation] iMaxBones");
+	return ANIM_NO_PALETTE;
+}
+
+void AnimationManager::FreePalette(uint32_t offset, uint32_t count) noexcept
+{
+	if (offset == ANIM_NO_PALETTE)
+		return;
+
+	count = ((count + _alignment - 1) / _alignment) * _alignment;
+
+	vector<PaletteRange>::iterator it{ lower_bound(_freeRanges.begin(), _freeRanges.end(), offset,
+		[](const PaletteRange &r, uint32_t o) { return r.offset < o; }) };
+	it = _freeRanges.insert(it, { offset, count });
+
+	// Merge with the following and preceding ranges
+	vector<PaletteRange>::iterator next{ it + 1 };
+	if (next != _freeRanges.end() && it->offset + it->count == next->offset)
+	{
+		it->count += next->count;
+		_freeRanges.erase(next);
+	}
+
+	if (it != _freeRanges.begin())
+	{
+		vector<PaletteRange>::iterator prev{ it - 1 };
+		if (prev->offset + prev->count == it->offset)
+		{
+			prev->count += it->count;
+			_freeRanges.erase(it);
+		}
+	}
+}
+
+void AnimationManager::Invalidate(uint32_t offset, uint32_t count) noexcept
+{
+	if (offset == ANIM_NO_PALETTE)
+		return;
+
+	if (offset < _dirtyBegin) _dirtyBegin = offset;
+	if (offset + count > _dirtyEnd) _dirtyEnd = offset + count;
+}
+
+void AnimationManager::CancelEvaluation(AnimatorComponent *animator) noexcept
+{
+	_queue.erase(remove(_queue.begin(), _queue.end(), animator), _queue.end());
+}
+
+void AnimationManager::Update() noexcept
+{
+	++_frame;
+
+	if (_queue.empty())
+		return;
+
+	TaskManager::ParallelFor((uint32_t)_queue.size(), ANIMMGR_GRAIN, [](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i)
+			_queue[i]->Evaluate();
+	});
+
+	for (AnimatorComponent *animator : _queue)
+	{
+		Skeleton *skeleton{ animator->GetSkeleton() };
+		Invalidate(skeleton->GetPaletteOffset(), skeleton->GetBoneCount());
+	}
+
+	_queue.clear();
+}
+
+void AnimationManager::UpdateData(VkCommandBuffer commandBuffer) noexcept
+{
+	if (_dirtyBegin >= _dirtyEnd)
+		return;
+
+	const VkDeviceSize offset{ sizeof(TrMat) * _dirtyBegin };
+	Renderer::GetInstance()->UploadFrameData(_paletteBuffer, offset, (uint8_t *)(_palette + _dirtyBegin), sizeof(TrMat) * (_dirtyEnd - _dirtyBegin), commandBuffer);
+
+	_dirtyBegin = UINT32_MAX;
+	_dirtyEnd = 0;
+}
+
+void AnimationManager::Release() noexcept
+{
+	delete[] _palette;
+	delete _paletteBuffer;
+
+	_paletteBuffer = nullptr;
+	_palette = nullptr;
+
+	_freeRanges.clear();
+	_queue.clear();
+
+	Logger::Log(ANIMMGR_MODULE, LOG_INFORMATION, "Released");
+}
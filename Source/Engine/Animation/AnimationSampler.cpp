@@ -0,0 +1,177 @@
+/* NekoEngine
+ *
+ * AnimationSampler.cpp
+ * Author: Alexandru Naiman
+ *
+ * AnimationSampler class implementation
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Animation/Skeleton.h>
+#include <Animation/AnimationClip.h>
+#include <Animation/AnimationSampler.h>
+
+using namespace std;
+using namespace glm;
+
+static inline vec3 _SampleVector(const vector<VectorKey> &keys, double time, uint32_t &cursor) noexcept
+{
+	if (keys.size() == 1)
+		return (vec3)keys[0].value;
+
+	const uint32_t i{ AnimFindKey(keys, time, cursor) };
+	return mix((vec3)keys[i].value, (vec3)keys[i + 1].value, AnimKeyFactor(keys, i, time));
+}
+
+static inline quat _SampleQuat(const vector<QuatKey> &keys, double time, uint32_t &cursor) noexcept
+{
+	if (keys.size() == 1)
+		return (quat)keys[0].value;
+
+	const uint32_t i{ AnimFindKey(keys, time, cursor) };
+	return normalize(slerp((quat)keys[i].value, (quat)keys[i + 1].value, AnimKeyFactor(keys, i, time)));
+}
+
+static inline void _SamplePosition(const AnimationNode &channel, double time, uint32_t &cursor, vec3 &out) noexcept
+{
+	switch (channel.positionTrack.type)
+	{
+		case ANIM_TRACK_KEYS:
+			if (!channel.positionKeys.empty())
+				out = _SampleVector(channel.positionKeys, time, cursor);
+		break;
+		case ANIM_TRACK_CONSTANT:
+			out = channel.positionTrack.min;
+		break;
+		case ANIM_TRACK_QUANTIZED:
+			out = AnimSampleTrack(channel.positionTrack, time, cursor);
+		break;
+	}
+}
+
+static inline void _SampleRotation(const AnimationNode &channel, double time, uint32_t &cursor, quat &out) noexcept
+{
+	switch (channel.rotationTrack.type)
+	{
+		case ANIM_TRACK_KEYS:
+			if (!channel.rotationKeys.empty())
+				out = _SampleQuat(channel.rotationKeys, time, cursor);
+		break;
+		case ANIM_TRACK_CONSTANT:
+			out = channel.rotationTrack.constant;
+		break;
+		case ANIM_TRACK_QUANTIZED:
+			out = AnimSampleTrack(channel.rotationTrack, time, cursor);
+		break;
+	}
+}
+
+static inline void _SampleScaling(const AnimationNode &channel, double time, uint32_t &cursor, vec3 &out) noexcept
+{
+	switch (channel.scalingTrack.type)
+	{
+		case ANIM_TRACK_KEYS:
+			if (!channel.scalingKeys.empty())
+				out = _SampleVector(channel.scalingKeys, time, cursor);
+		break;
+		case ANIM_TRACK_CONSTANT:
+			out = channel.scalingTrack.min;
+		break;
+		case ANIM_TRACK_QUANTIZED:
+			out = AnimSampleTrack(channel.scalingTrack, time, cursor);
+		break;
+	}
+}
+
+AnimationSampler::AnimationSampler() noexcept :
+	_clip(nullptr)
+{
+}
+
+void AnimationSampler::Bind(const Skeleton *skeleton, AnimationClip *clip)
+{
+	_clip = clip;
+	_channelNodes.clear();
+	_cursors.clear();
+
+	if (!_clip || !skeleton)
+		return;
+
+	const vector<AnimationNode> &channels{ _clip->GetChannels() };
+
+	_channelNodes.resize(channels.size());
+	_cursors.resize(channels.size());
+
+	for (size_t i = 0; i < channels.size(); ++i)
+		_channelNodes[i] = skeleton->GetNodeIndex(*channels[i].name);
+
+	Reset();
+}
+
+void AnimationSampler::Reset() noexcept
+{
+	for (AnimationKeyCursor &c : _cursors)
+		c = { 0, 0, 0 };
+}
+
+double AnimationSampler::GetClipTime(double seconds, bool loop) const noexcept
+{
+	if (!_clip || _clip->GetDuration() <= 0.0)
+		return 0.0;
+
+	const double ticks{ _clip->GetTicksPerSecond() != 0.0 ? _clip->GetTicksPerSecond() : 25.0 };
+	return loop ? mod(seconds * ticks, _clip->GetDuration()) : glm::min(seconds * ticks, _clip->GetDuration());
+}
+
+void AnimationSampler::Sample(double time, SkeletonPose &pose, const uint8_t *mask) noexcept
+{
+	if (!_clip)
+		return;
+
+	const vector<AnimationNode> &channels{ _clip->GetChannels() };
+
+	for (size_t i = 0; i < channels.size(); ++i)
+	{
+		const int16_t node{ _channelNodes[i] };
+		if (node < 0 || (mask && !mask[node]))
+			continue;
+
+		const AnimationNode &channel{ channels[i] };
+		AnimationKeyCursor &cursor{ _cursors[i] };
+
+		// Stripped (ANIM_TRACK_DEFAULT) tracks keep the bind pose value
+		_SamplePosition(channel, time, cursor.position, pose.translations[node]);
+		_SampleRotation(channel, time, cursor.rotation, pose.rotations[node]);
+		_SampleScaling(channel, time, cursor.scaling, pose.scales[node]);
+	}
+}
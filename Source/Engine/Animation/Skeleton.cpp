@@ -39,12 +39,14 @@
 
 #include <Animation/Skeleton.h>
 #include <Animation/AnimationClip.h>
+#include <Animation/AnimationManager.h>
 #include <Engine/Vertex.h>
 #include <Engine/Engine.h>
 #include <System/Logger.h>
 #include <System/AssetLoader/AssetLoader.h>
 
 #define SKEL_MODULE		"Skeleton"
+#define SKEL_MIN_SCALE	1e-6f
 
 using namespace std;
 using namespace glm;
@@ -52,47 +54,87 @@ using namespace glm;
 Skeleton::Skeleton(vector<Bone> &bones, vector<TransformNode> &nodes, dmat4 &globalInverseTransform) noexcept
 {
 	_buffer = nullptr;
-	_animationClip = nullptr;
-	_rootNode = nullptr;
-	_bufferSize = 0;
+	_transforms = nullptr;
+	_paletteOffset = ANIM_NO_PALETTE;
+	_reducedDetail = false;
 
-	_numBones = (unsigned int)bones.size();
-	_numNodes = (unsigned int)nodes.size();
+	_numBones = (uint16_t)bones.size();
+	_numNodes = (uint16_t)nodes.size();
 
-	_bones.resize(_numBones);
-	for (unsigned int i = 0; i < _numBones; i++)
+	unordered_map<string, int16_t> boneMap{};
+	_offsets.resize(_numBones);
+	for (uint16_t i = 0; i < _numBones; ++i)
 	{
-		_bones[i] = bones[i];
-		_boneMap.insert(make_pair(_bones[i].name.c_str(), i));
+		_offsets[i] = (mat4)bones[i].offset;
+		boneMap.insert(make_pair(bones[i].name, i));
 	}
 
-	_nodes.reserve(_numNodes);
-	for (unsigned int i = 0; i < _numNodes; ++i)
+	// Flatten the hierarchy breadth first so parents are always evaluated before their children
+	vector<uint16_t> order{};
+	vector<int16_t> flatIndex(_numNodes, SKEL_NO_PARENT);
+	order.reserve(_numNodes);
+
+	for (uint16_t i = 0; i < _numNodes; ++i)
+		if (nodes[i].parentId == -1)
+			order.push_back(i);
+
+	for (size_t i = 0; i < order.size(); ++i)
 	{
-		_nodes.push_back(nodes[i]);
-		_nodes[i].parent = _nodes[i].parentId == -1 ? nullptr : &_nodes[_nodes[i].parentId];
+		const TransformNode &node{ nodes[order[i]] };
+		flatIndex[order[i]] = (int16_t)i;
 
-		if(!_nodes[i].parent)
-			_rootNode = &_nodes[i];
+		for (int16_t j = 0; j < node.numChildren; ++j)
+			order.push_back(node.childrenIds[j]);
 	}
 
-	for (TransformNode &t : _nodes)
+	_numNodes = (uint16_t)order.size();
+	_parents.resize(_numNodes);
+	_nodeBones.resize(_numNodes);
+	_globalTransforms.resize(_numNodes);
+	_lodMask.resize(_numNodes, 0);
+	_bindPose.Resize(_numNodes);
+
+	for (uint16_t i = 0; i < _numNodes; ++i)
 	{
-		if(!t.numChildren)
+		const TransformNode &node{ nodes[order[i]] };
+
+		_parents[i] = node.parentId == -1 ? SKEL_NO_PARENT : flatIndex[node.parentId];
+		if (_parents[i] != SKEL_NO_PARENT)
+			_lodMask[_parents[i]] = 1;
+		_nodeMap.insert(make_pair(node.name, (int16_t)i));
+
+		unordered_map<string, int16_t>::iterator it{ boneMap.find(node.name) };
+		_nodeBones[i] = it == boneMap.end() ? SKEL_NO_BONE : it->second;
+
+		mat4 m{ (mat4)node.transform };
+		vec3 s{ length(vec3(m[0])), length(vec3(m[1])), length(vec3(m[2])) };
+
+		_bindPose.translations[i] = vec3(m[3]);
+		_bindPose.scales[i] = s;
+
+		// A collapsed axis has no rotation to extract; keep the scale so the node stays collapsed
+		if (s.x < SKEL_MIN_SCALE || s.y < SKEL_MIN_SCALE || s.z < SKEL_MIN_SCALE)
+		{
+			Logger::Log(SKEL_MODULE, LOG_WARNING, "Node %s has a degenerate bind transform", node.name.c_str());
+			_bindPose.rotations[i] = quat(1.f, 0.f, 0.f, 0.f);
 			continue;
+		}
 
-		for(int i = 0; i < t.numChildren; ++i)
-			t.children.push_back(&_nodes[t.childrenIds[i]]);
+		_bindPose.rotations[i] = normalize(quat_cast(mat3(vec3(m[0]) / s.x, vec3(m[1]) / s.y, vec3(m[2]) / s.z)));
 	}
 
-	_globalInverseTransform = globalInverseTransform;
+	_pose.CopyFrom(_bindPose);
+
+	_globalInverseTransform = (mat4)globalInverseTransform;
 }
 
 int Skeleton::Load()
 {
-	_bufferSize = sizeof(mat4) * _numBones;
-	if((_buffer = new Buffer(_bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, nullptr, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) == nullptr)
-	{ DIE("Out of resources"); }
+	if ((_paletteOffset = AnimationManager::AllocatePalette(_numBones)) == ANIM_NO_PALETTE)
+		return ENGINE_OUT_OF_RESOURCES;
+
+	// The skeleton's range of the palette is bound as its bone buffer
+	_buffer = new Buffer(AnimationManager::GetPaletteBuffer(), sizeof(TrMat) * _paletteOffset, sizeof(TrMat) * _numBones);
 
 	constexpr TrMat t =
 	{ {
@@ -102,182 +144,61 @@ int Skeleton::Load()
 		0.f, 0.f, 0.f, 1.f
 	} };
 
-	_transforms.resize(_numBones);
-	_prevTransforms.resize(_numBones);
+	_transforms = AnimationManager::GetPalette(_paletteOffset);
 
 	for(int i = 0; i < _numBones; ++i)
-	{
 		_transforms[i] = t;
-		_prevTransforms[i] = t;
-	}
+
+	AnimationManager::Invalidate(_paletteOffset, _numBones);
 	
 	return ENGINE_OK;
 }
 
 void Skeleton::TransformBones(double time)
 {
-	if(!_animationClip)
-		return;
-
-	dmat4 ident = dmat4();
-
-	const double ticks = _animationClip->GetTicksPerSecond() != 0 ? _animationClip->GetTicksPerSecond() : 25.f;
-	const double timeInTicks = time * ticks;
-	const double animTime = mod(timeInTicks, _animationClip->GetDuration());
-
-	_TransformHierarchy(animTime, _rootNode, ident);
-}
-
-void Skeleton::UpdateData(VkCommandBuffer commandBuffer) noexcept
-{
-	_buffer->UpdateData((uint8_t *)_transforms.data(), 0, _bufferSize, commandBuffer);
-}
-
-void Skeleton::_CalculatePosition(dvec3 &out, double time, const AnimationNode *node)
-{
-	const size_t numKeys = node->positionKeys.size();
-
-	if(numKeys == 1)
-	{
-		out = node->positionKeys[0].value;
-		return;
-	}
-
-	uint16_t posIndex = 0;
-
-	for(uint16_t i = 0; i < numKeys - 1; ++i)
-	{
-		if(time < node->positionKeys[i + 1].time)
-		{
-			posIndex = i;
-			break;
-		}
-	}
-
-	const uint16_t nextPosIndex = posIndex + 1;
-
-	const double dt = node->positionKeys[nextPosIndex].time - node->positionKeys[posIndex].time;
-	const double factor = (time - node->positionKeys[posIndex].time) / dt;
-
-	const dvec3 &start = node->positionKeys[posIndex].value;
-	const dvec3 &end = node->positionKeys[nextPosIndex].value;
-
-	const dvec3 delta = end - start;
-	out = start + factor * delta;
-}
-
-void Skeleton::_CalculateRotation(dquat &out, double time, const AnimationNode *node)
-{
-	const size_t numKeys = node->rotationKeys.size();
-
-	if(numKeys == 1)
-	{
-		out = node->rotationKeys[0].value;
+	if (!_sampler.GetClip())
 		return;
-	}
-
-	uint16_t rotIndex = 0;
-
-	for(uint16_t i = 0; i < numKeys - 1; ++i)
-	{
-		if(time < node->rotationKeys[i + 1].time)
-		{
-			rotIndex = i;
-			break;
-		}
-	}
-
-	const uint16_t nextRotIndex = rotIndex + 1;
 
-	const double dt = node->rotationKeys[nextRotIndex].time - node->rotationKeys[rotIndex].time;
-	const double factor = (time - node->rotationKeys[rotIndex].time) / dt;
+	_pose.CopyFrom(_bindPose);
+	_sampler.Sample(_sampler.GetClipTime(time), _pose, GetSampleMask());
 
-	const dquat &start = node->rotationKeys[rotIndex].value;
-	const dquat &end = node->rotationKeys[nextRotIndex].value;
-
-	out = slerp(start, end, factor);
-	out = normalize(out);
+	ComputeTransforms();
 }
 
-void Skeleton::_CalculateScaling(dvec3 &out, double time, const AnimationNode *node)
+int16_t Skeleton::GetNodeIndex(const char *name) const noexcept
 {
-	const size_t numKeys = node->scalingKeys.size();
-
-	if(numKeys == 1)
-	{
-		out = node->scalingKeys[0].value;
-		return;
-	}
+	if (!name)
+		return SKEL_NO_PARENT;
 
-	uint16_t scaleIndex = 0;
-
-	for(uint16_t i = 0; i < numKeys - 1; ++i)
-	{
-		if(time < node->scalingKeys[i + 1].time)
-		{
-			scaleIndex = i;
-			break;
-		}
-	}
-
-	const uint16_t nextScaleIndex = scaleIndex + 1;
-
-	const double dt = node->scalingKeys[nextScaleIndex].time - node->scalingKeys[scaleIndex].time;
-	const double factor = (time - node->scalingKeys[scaleIndex].time) / dt;
-
-	const dvec3 &start = node->scalingKeys[scaleIndex].value;
-	const dvec3 &end = node->scalingKeys[nextScaleIndex].value;
-
-	const dvec3 delta = end - start;
-	out = start + factor * delta;
+	unordered_map<string, int16_t>::const_iterator it{ _nodeMap.find(name) };
+	return it == _nodeMap.end() ? SKEL_NO_PARENT : it->second;
 }
 
-void Skeleton::_TransformHierarchy(double time, const TransformNode *node, dmat4 &parentTransform)
+void Skeleton::ComputeTransforms() noexcept
 {
-	const AnimationNode *animNode = nullptr;
-
-	dmat4 nodeTransform = node->transform;
-
-	for(uint i = 0; i < _animationClip->GetChannels().size(); ++i)
+	for (uint16_t i = 0; i < _numNodes; ++i)
 	{
-		if(*_animationClip->GetChannels()[i].name && !strncmp(*_animationClip->GetChannels()[i].name, node->name.c_str(), node->name.length()))
-		{
-			animNode = &_animationClip->GetChannels()[i];
-			break;
-		}
-	}
+		const vec3 &s{ _pose.scales[i] };
+		mat4 local{ mat4_cast(_pose.rotations[i]) };
 
-	if(animNode)
-	{
-		dvec3 scaling;
-		_CalculateScaling(scaling, time, animNode);
-		dmat4 scaleMatrix = scale(dmat4(1), scaling);
+		local[0] *= s.x;
+		local[1] *= s.y;
+		local[2] *= s.z;
+		local[3] = vec4(_pose.translations[i], 1.f);
 
-		dquat rotation;
-		_CalculateRotation(rotation, time, animNode);
-		dmat4 rotationMatrix = mat4_cast(rotation);
+		_globalTransforms[i] = _parents[i] == SKEL_NO_PARENT ? local : _globalTransforms[_parents[i]] * local;
 
-		dvec3 position;
-		_CalculatePosition(position, time, animNode);
-		dmat4 translationMatirx = translate(dmat4(1), position);
-
-		nodeTransform = (translationMatirx * rotationMatrix) * scaleMatrix;
-	}
-
-	dmat4 globalTransform = parentTransform * nodeTransform;
+		const int16_t bone{ _nodeBones[i] };
+		if (bone == SKEL_NO_BONE)
+			continue;
 
-	if(_boneMap.find(node->name) != _boneMap.end())
-	{
-		const uint16_t index = _boneMap[node->name];
-		mat4 m = (mat4)(_globalInverseTransform * globalTransform * _bones[index].offset);
-		memcpy(&_transforms[index], &m[0][0], sizeof(TrMat));
+		mat4 m{ _globalInverseTransform * _globalTransforms[i] * _offsets[bone] };
+		memcpy(&_transforms[bone], &m[0][0], sizeof(TrMat));
 	}
-
-	for(uint16_t i = 0; i < node->numChildren; ++i)
-		_TransformHierarchy(time, node->children[i], globalTransform);
 }
 
 Skeleton::~Skeleton() noexcept
 {
 	delete _buffer;
+	AnimationManager::FreePalette(_paletteOffset, _numBones);
 }
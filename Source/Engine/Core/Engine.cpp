@@ -48,21 +48,24 @@
 #include <Engine/Console.h>
 #include <Engine/GameModule.h>
 #include <Engine/SoundManager.h>
+#include <Engine/TaskManager.h>
 #include <Engine/EventManager.h>
 #include <Engine/ResourceManager.h>
 #include <Scene/SceneManager.h>
+#include <Animation/AnimationManager.h>
 #include <Audio/AudioSystem.h>
 #include <System/Logger.h>
 #include <System/VFS/VFS.h>
 #include <Renderer/SSAO.h>
 #include <Renderer/Renderer.h>
 #include <Renderer/PostProcessor.h>
+#include <Renderer/InstanceManager.h>
 #include <Profiler/Profiler.h>
 #include <Physics/Physics.h>
+#include <Script/Script.h>
+#include <Script/ScriptScheduler.h>
 #include <Platform/CrashHandler.h>
 
- // 60 Hz logic update
-#define UPDATE_DELTA			.01666
 #define VFS_ARCHIVE_LIST_SIZE	4096
 
 #define ENGINE_MODULE			"Engine"
@@ -84,7 +87,10 @@ bool Engine::_editor = false;
 bool Engine::_disposed = false;
 bool Engine::_drawStats = false;
 bool Engine::_startup = true;
+bool Engine::_inFixedUpdate = false;
 vec2 Engine::_scaleFactor{ 1.f,1.f };
+FixedTimestep Engine::_fixedTimestep;
+uint64_t Engine::_fixedFrame = 0;
 
 high_resolution_clock::time_point _prevTime;
 PlatformWindowType _engineWindow = 0;
@@ -117,7 +123,7 @@ int Engine::Run()
 
 void Engine::Frame() noexcept
 {
-	static double lastTime = GetTime(), lastFPSTime = GetTime(), nextFixedUpdateTime = GetTime();
+	static double lastTime = GetTime(), lastFPSTime = GetTime();
 	static int nFrames = 0;
 	const double curTime = GetTime();
 	const double deltaTime = curTime - lastTime;
@@ -136,12 +142,6 @@ void Engine::Frame() noexcept
 	_Update(deltaTime);
 	lastTime = curTime;
 
-	if (curTime > nextFixedUpdateTime)
-	{
-		_FixedUpdate();
-		nextFixedUpdateTime += UPDATE_DELTA;
-	}
-
 	_Draw();
 
 #if defined(NE_CONFIG_DEBUG) || defined(NE_CONFIG_DEVELOPMENT)
@@ -213,6 +213,13 @@ bool Engine::SaveConfiguration() noexcept
 	fprintf(fp, "bFullscreen=%d\n", _config.Engine.Fullscreen ? 1 : 0);
 	fprintf(fp, "bLoadLooseFiles=%d\n", _config.Engine.LoadLooseFiles ? 1 : 0);
 	fprintf(fp, "bEnableConsole=%d\n", _config.Engine.EnableConsole ? 1 : 0);
+	fprintf(fp, "iWorkerThreads=%d\n", _config.Engine.WorkerThreads);
+	fprintf(fp, "iFixedUpdateRate=%d\n", _config.Engine.FixedUpdateRate);
+	fprintf(fp, "iMaxSubsteps=%d\n", _config.Engine.MaxSubsteps);
+	fprintf(fp, "fScriptGCBudget=%.02f\n", _config.Engine.ScriptGCBudget);
+	fprintf(fp, "iScriptInstructionBudget=%d\n", _config.Engine.ScriptInstructionBudget);
+	fprintf(fp, "bHotReload=%d\n", _config.Engine.HotReload ? 1 : 0);
+	fprintf(fp, "iHotReloadDelay=%d\n", _config.Engine.HotReloadDelay);
 
 	fprintf(fp, "[Renderer]\n");
 	fprintf(fp, "bSupersampling=%d\n", _config.Renderer.Supersampling ? 1 : 0);
@@ -230,6 +237,7 @@ bool Engine::SaveConfiguration() noexcept
 	fprintf(fp, "bEnableAsyncCompute=%d\n", _config.Renderer.EnableAsyncCompute ? 1 : 0);
 	fprintf(fp, "fGamma=%.02f\n", _config.Renderer.Gamma);
 	fprintf(fp, "bUseDeviceGroup=%d\n", _config.Renderer.UseDeviceGroup ? 1 : 0);
+	fprintf(fp, "bDistanceFieldText=%d\n", _config.Renderer.DistanceFieldText ? 1 : 0);
 
 	fprintf(fp, "[Renderer.SSAO]\n");
 	fprintf(fp, "bEnable=%d\n", _config.Renderer.SSAO.Enable ? 1 : 0);
@@ -250,6 +258,15 @@ bool Engine::SaveConfiguration() noexcept
 	fprintf(fp, "fMasterVolume=%.01f\n", _config.Audio.MasterVolume);
 	fprintf(fp, "fEffectsVolume=%.01f\n", _config.Audio.EffectsVolume);
 	fprintf(fp, "fMusicVolume=%.01f\n", _config.Audio.MusicVolume);
+	fprintf(fp, "iMaxVoices=%d\n", _config.Audio.MaxVoices);
+	fprintf(fp, "iMixRate=%d\n", _config.Audio.MixRate);
+	fprintf(fp, "bOfflineRender=%d\n", _config.Audio.OfflineRender ? 1 : 0);
+	fprintf(fp, "sOutputFile=%s\n", _config.Audio.OutputFile);
+
+	fprintf(fp, "[Animation]\n");
+	fprintf(fp, "iMaxBones=%d\n", _config.Animation.MaxBones);
+	fprintf(fp, "fLOD1Distance=%.01f\n", _config.Animation.LOD1Distance);
+	fprintf(fp, "fLOD2Distance=%.01f\n", _config.Animation.LOD2Distance);
 
 	fprintf(fp, "[Input.VirtualAxis]\n");
 	for (uint32_t i = 0; i < Input::GetVirtualAxisList().Count(); ++i) {
@@ -291,11 +308,15 @@ void Engine::CleanUp() noexcept
 
 	GUIManager::Release();
 	SceneManager::Release();
+	Script::Release();
 	ResourceManager::Release();
 	SoundManager::Release();
+	AnimationManager::Release();
+	InstanceManager::Release();
 	Renderer::Release();
 	AudioSystem::ReleaseInstance();
 	Physics::ReleaseInstance();
+	TaskManager::Release();
 	VFS::Release();
 	Input::Release();
 	Console::Release();
@@ -318,24 +339,30 @@ void Engine::CleanUp() noexcept
 	_disposed = true;
 }
 
-void Engine::_FixedUpdate()
-{
-	//
-}
-
 void Engine::_Update(double deltaTime)
 {
 	PROF_BEGIN("Update", vec3(1.f, 1.f, 0.f));
 
+	// Before anything of this frame is updated or recorded
+	ResourceManager::Update();
+	PROF_MARKER("Reload", vec3(1.f, 1.f, 0.f));
+
 	Input::Update();
 	PROF_MARKER("Input", vec3(1.f, 1.f, 0.f));
 
-	Physics::GetInstance()->Update(deltaTime);
-	PROF_MARKER("Physics", vec3(1.f, 1.f, 0.f));
+	// Runs after input so the steps see this frame's key state
+	StepFixedUpdate(deltaTime);
+	PROF_MARKER("Fixed update", vec3(1.f, 1.f, 0.f));
 
 	SceneManager::UpdateScene(deltaTime);
 	PROF_MARKER("Scene", vec3(1.f, 1.f, 0.f));
 
+	ScriptScheduler::Update(deltaTime);
+	PROF_MARKER("Scripts", vec3(1.f, 1.f, 0.f));
+
+	AnimationManager::Update();
+	PROF_MARKER("Animation", vec3(1.f, 1.f, 0.f));
+
 	if (_drawStats) _DrawStats();
 	if (Console::IsOpen()) Console::Update();
 
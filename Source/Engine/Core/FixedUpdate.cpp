@@ -1,9 +1,9 @@
 /* NekoEngine
  *
- * Particle.h
+ * FixedUpdate.cpp
  * Author: Alexandru Naiman
  *
- * CPU mesh particles
+ * Fixed rate simulation steps
  *
  * -----------------------------------------------------------------------------
  *
@@ -37,37 +37,27 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <Scene/Particles/MeshParticle.h>
+#include <Engine/Engine.h>
+#include <Scene/SceneManager.h>
+#include <Physics/Physics.h>
 
-ENGINE_REGISTER_OBJECT_CLASS(MeshParticle);
-
-MeshParticle::MeshParticle(ObjectInitializer *initializer) :
-	Particle(initializer),
-	_smcInitializer{},
-	_smc{ nullptr }
+uint32_t Engine::StepFixedUpdate(double deltaTime)
 {
-	ArgumentMapType::iterator it{};
-	//const char *ptr{ nullptr };
+	const uint32_t steps{ _fixedTimestep.Advance(deltaTime) };
+
+	for (uint32_t i = 0; i < steps; ++i)
+		_FixedUpdate();
 
-	_smcInitializer.parent = this;
-	_smcInitializer.arguments = initializer->arguments;
+	return steps;
 }
 
-int MeshParticle::Load()
+void Engine::_FixedUpdate()
 {
-	_smc = (StaticMeshComponent *)Engine::NewComponent("StaticMeshComponent", &_smcInitializer);
-	int ret{ _smc->Load() };
-	if (ret != ENGINE_OK) return ret;
-
-	AddComponent("Mesh", _smc);
+	_inFixedUpdate = true;
+	++_fixedFrame;
 
-	ret = Particle::Load();
-	if (ret != ENGINE_OK) return ret;
+	Physics::GetInstance()->Update(_fixedTimestep.GetStep());
+	SceneManager::FixedUpdateScene();
 
-	//SetVisible(false);
-	SetNoCull(true);
-
-	return ENGINE_OK;
+	_inFixedUpdate = false;
 }
-
-MeshParticle::~MeshParticle() { }
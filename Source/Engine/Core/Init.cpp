@@ -47,11 +47,14 @@
 #include <Engine/Version.h>
 #include <Engine/GameModule.h>
 #include <Engine/SoundManager.h>
+#include <Engine/TaskManager.h>
 #include <Engine/ResourceManager.h>
 #include <Renderer/SSAO.h>
 #include <Renderer/Renderer.h>
 #include <Renderer/PostProcessor.h>
+#include <Renderer/InstanceManager.h>
 #include <Scene/SceneManager.h>
+#include <Animation/AnimationManager.h>
 #include <Profiler/Profiler.h>
 #include <Platform/Platform.h>
 #include <Platform/CrashHandler.h>
@@ -148,6 +151,18 @@ int Engine::Initialize(const char *cmdLine, bool editor)
 		return ENGINE_FAIL;
 	}
 
+	if (AnimationManager::Initialize() != ENGINE_OK)
+	{
+		Logger::Log(ENGINE_MODULE, LOG_CRITICAL, "Failed to initialize the animation manager");
+		return ENGINE_FAIL;
+	}
+
+	if (InstanceManager::Initialize() != ENGINE_OK)
+	{
+		Logger::Log(ENGINE_MODULE, LOG_CRITICAL, "Failed to initialize the instance manager");
+		return ENGINE_FAIL;
+	}
+
 	if (Physics::InitInstance(_physicsModuleFile) != ENGINE_OK)
 	{
 		Platform::MessageBox("Fatal Error", "Failed to initialize the Physics module !", MessageBoxButtons::OK, MessageBoxIcon::Error);
@@ -208,6 +223,8 @@ int Engine::Initialize(const char *cmdLine, bool editor)
 
 	Platform::SetWindowTitle(_engineWindow, *title);
 
+	_fixedTimestep.SetStep(1.0 / _config.Engine.FixedUpdateRate, _config.Engine.MaxSubsteps);
+
 	_prevTime = high_resolution_clock::now();\
 	_startup = false;
 
@@ -354,6 +371,20 @@ void Engine::_ReadINIFile(const char *file)
 	_config.Engine.Fullscreen = Platform::GetConfigInt("Engine", "bFullscreen", 0, file) != 0;
 	_config.Engine.LoadLooseFiles = Platform::GetConfigInt("Engine", "bLoadLooseFiles", 0, file) != 0;
 	_config.Engine.EnableConsole = Platform::GetConfigInt("Engine", "bEnableConsole", 0, file) != 0;
+	_config.Engine.WorkerThreads = Platform::GetConfigInt("Engine", "iWorkerThreads", 0, file);
+	_config.Engine.FixedUpdateRate = Platform::GetConfigInt("Engine", "iFixedUpdateRate", 60, file);
+	_config.Engine.MaxSubsteps = Platform::GetConfigInt("Engine", "iMaxSubsteps", 5, file);
+	_config.Engine.ScriptGCBudget = Platform::GetConfigFloat("Engine", "fScriptGCBudget", 1.f, file);
+	_config.Engine.ScriptInstructionBudget = Platform::GetConfigInt("Engine", "iScriptInstructionBudget", 0, file);
+	_config.Engine.HotReload = Platform::GetConfigInt("Engine", "bHotReload", 0, file) != 0;
+	_config.Engine.HotReloadDelay = Platform::GetConfigInt("Engine", "iHotReloadDelay", 250, file);
+
+	if (_config.Engine.FixedUpdateRate < 1)
+		_config.Engine.FixedUpdateRate = 60;
+	if (_config.Engine.MaxSubsteps < 1)
+		_config.Engine.MaxSubsteps = 1;
+	if (_config.Engine.HotReloadDelay < 0)
+		_config.Engine.HotReloadDelay = 0;
 
 	_config.Renderer.Supersampling = Platform::GetConfigInt("Renderer", "bSupersampling", 0, file) != 0;
 	_config.Renderer.Multisampling = Platform::GetConfigInt("Renderer", "bMultisampling", 1, file) != 0;
@@ -370,6 +401,7 @@ void Engine::_ReadINIFile(const char *file)
 	_config.Renderer.EnableAsyncCompute = Platform::GetConfigInt("Renderer", "bEnableAsyncCompute", 0, file) != 0;
 	_config.Renderer.Gamma = Platform::GetConfigFloat("Renderer", "fGamma", 2.2f, file);
 	_config.Renderer.UseDeviceGroup = Platform::GetConfigInt("Renderer", "bUseDeviceGroup", 0, file) != 0;
+	_config.Renderer.DistanceFieldText = Platform::GetConfigInt("Renderer", "bDistanceFieldText", 0, file) != 0;
 
 	_config.Renderer.SSAO.Enable = Platform::GetConfigInt("Renderer.SSAO", "bEnable", 1, file) != 0;
 	_config.Renderer.SSAO.KernelSize = Platform::GetConfigInt("Renderer.SSAO", "iKernelSize", 128, file);
@@ -387,6 +419,15 @@ void Engine::_ReadINIFile(const char *file)
 	_config.Audio.MasterVolume = Platform::GetConfigFloat("Audio", "fMasterVolume", 1.f, file);
 	_config.Audio.EffectsVolume = Platform::GetConfigFloat("Audio", "fEffectsVolume", 1.f, file);
 	_config.Audio.MusicVolume = Platform::GetConfigFloat("Audio", "fMusicVolume", 1.f, file);
+	_config.Audio.MaxVoices = Platform::GetConfigInt("Audio", "iMaxVoices", 32, file);
+	_config.Audio.MixRate = Platform::GetConfigInt("Audio", "iMixRate", 48000, file);
+	_config.Audio.OfflineRender = Platform::GetConfigInt("Audio", "bOfflineRender", 0, file) != 0;
+	memset(_config.Audio.OutputFile, 0x0, NE_PATH_SIZE);
+	Platform::GetConfigString("Audio", "sOutputFile", "", _config.Audio.OutputFile, NE_PATH_SIZE, file);
+
+	_config.Animation.MaxBones = Platform::GetConfigInt("Animation", "iMaxBones", 65536, file);
+	_config.Animation.LOD1Distance = Platform::GetConfigFloat("Animation", "fLOD1Distance", 20.f, file);
+	_config.Animation.LOD2Distance = Platform::GetConfigFloat("Animation", "fLOD2Distance", 50.f, file);
 
 	_ReadInputConfig(file);
 	_ReadRendererConfig(file);
@@ -592,6 +633,20 @@ int Engine::_InitSystem()
 		return false;
 	}
 
+	if (_config.Engine.HotReload)
+	{
+		if (!_config.Engine.LoadLooseFiles)
+			Logger::Log(ENGINE_MODULE, LOG_WARNING, "Hot reload requires loose files to be enabled");
+		else if (ResourceManager::EnableHotReload(_config.Engine.DataDirectory) != ENGINE_OK)
+			Logger::Log(ENGINE_MODULE, LOG_WARNING, "Failed to enable hot reload");
+	}
+
+	if (TaskManager::Initialize() != ENGINE_OK)
+	{
+		Logger::Log(ENGINE_MODULE, LOG_CRITICAL, "Failed to initialize the task manager");
+		return ENGINE_FAIL;
+	}
+
 	return ENGINE_OK;
 }
 
@@ -419,6 +419,7 @@ NArray<Resource *> ResourceManager::GetResourcesOfType(ResourceType type) noexce
 
 void ResourceManager::Release() noexcept
 {
+	_ReleaseReloads();
 	_UnloadResources();
 
 	if(_db)
@@ -0,0 +1,212 @@
+/* NekoEngine
+ *
+ * ResourceReload.cpp
+ * Author: Alexandru Naiman
+ *
+ * Reloading of changed resource and script files
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Engine/Engine.h>
+#include <Engine/EventManager.h>
+#include <Engine/ResourceManager.h>
+#include <Scene/Components/ScriptComponent.h>
+#include <Platform/FileWatcher.h>
+#include <System/Logger.h>
+
+#include <mutex>
+#include <chrono>
+
+#define RM_MODULE			"ResourceManager"
+#define RM_SCRIPT_EXT		".lua"
+
+using namespace std;
+using namespace std::chrono;
+
+// Path -> time of the last change
+static map<string, steady_clock::time_point> _pendingReloads;
+static mutex _reloadLock;
+
+static const char *_rm_ReloadPath(ResourceInfo *ri)
+{
+	switch (ri->type)
+	{
+		case ResourceType::RES_SHADERMODULE:
+			return *((ShaderModuleResource *)ri)->filePath;
+		case ResourceType::RES_MATERIAL:
+			return *((MaterialResource *)ri)->filePath;
+		default:
+			return nullptr;
+	}
+}
+
+static inline bool _rm_SamePath(const char *a, const char *b)
+{
+	while (*a == '/') ++a;
+	while (*b == '/') ++b;
+	return !strcmp(a, b);
+}
+
+static inline bool _rm_IsScript(const string &path)
+{
+	const size_t len{ sizeof(RM_SCRIPT_EXT) - 1 };
+	return path.length() > len && !path.compare(path.length() - len, len, RM_SCRIPT_EXT);
+}
+
+void ResourceManager::QueueReload(const char *path) noexcept
+{
+	if (!path || !*path)
+		return;
+
+	string file{ path };
+	if (file[0] != '/')
+		file.insert(0, "/");
+
+	lock_guard<mutex> lock{ _reloadLock };
+	_pendingReloads[file] = steady_clock::now();
+}
+
+size_t ResourceManager::GetPendingReloadCount() noexcept
+{
+	lock_guard<mutex> lock{ _reloadLock };
+	return _pendingReloads.size();
+}
+
+int ResourceManager::EnableHotReload(const char *directory)
+{
+	return FileWatcher::Initialize(directory);
+}
+
+void ResourceManager::Update()
+{
+	if (FileWatcher::IsActive())
+	{
+		vector<string> changed{};
+		FileWatcher::Poll(changed);
+
+		for (const string &path : changed)
+			QueueReload(path.c_str());
+	}
+
+	vector<string> paths{};
+	{
+		lock_guard<mutex> lock{ _reloadLock };
+		if (_pendingReloads.empty())
+			return;
+
+		// Editors often write a file more than once when saving
+		const steady_clock::time_point now{ steady_clock::now() };
+		const milliseconds delay{ Engine::GetConfiguration().Engine.HotReloadDelay };
+
+		for (auto it = _pendingReloads.begin(); it != _pendingReloads.end(); )
+		{
+			if (now - it->second < delay)
+			{
+				++it;
+				continue;
+			}
+
+			paths.push_back(it->first);
+			it = _pendingReloads.erase(it);
+		}
+	}
+
+	if (!paths.empty())
+		_ApplyReloads(paths);
+}
+
+void ResourceManager::_ApplyReloads(const vector<string> &paths)
+{
+	vector<Resource *> targets{};
+	vector<string> scripts{};
+
+	// Only materials and shader modules are reloaded from their files
+	NArray<Resource *> candidates{ GetResourcesOfType(ResourceType::RES_SHADERMODULE) };
+	candidates.Add(GetResourcesOfType(ResourceType::RES_MATERIAL));
+
+	for (const string &path : paths)
+	{
+		if (_rm_IsScript(path))
+		{
+			scripts.push_back(path);
+			continue;
+		}
+
+		size_t count{ targets.size() };
+
+		for (Resource *r : candidates)
+		{
+			const char *file{ _rm_ReloadPath(r->GetResourceInfo()) };
+			if (file && _rm_SamePath(file, path.c_str()))
+				targets.push_back(r);
+		}
+
+		if (count == targets.size())
+			Logger::Log(RM_MODULE, LOG_DEBUG, "No loaded resource uses %s", path.c_str());
+	}
+
+	if (!targets.empty())
+	{
+		NArray<Resource *> reloaded{};
+
+		EventManager::Broadcast(NE_EVT_RES_RELOADING, nullptr);
+
+		for (Resource *r : targets)
+		{
+			ResourceInfo *ri{ r->GetResourceInfo() };
+			const int ret{ r->Reload() };
+
+			if (ret != ENGINE_OK)
+			{
+				Logger::Log(RM_MODULE, LOG_CRITICAL, "Failed to reload resource \"%s\", error code %d; the previous version is kept", ri->name.c_str(), ret);
+				continue;
+			}
+
+			Logger::Log(RM_MODULE, LOG_INFORMATION, "Reloaded resource \"%s\"", ri->name.c_str());
+			reloaded.Add(r);
+		}
+
+		EventManager::Broadcast(NE_EVT_RES_RELOADED, &reloaded);
+	}
+
+	for (const string &script : scripts)
+		ScriptComponent::ReloadScript(script.c_str());
+}
+
+void ResourceManager::_ReleaseReloads() noexcept
+{
+	FileWatcher::Release();
+
+	lock_guard<mutex> lock{ _reloadLock };
+	_pendingReloads.clear();
+}
@@ -61,6 +61,7 @@ int SoundManager::Initialize()
 
 	_bgMusicSource = AudioSystem::GetInstance()->CreateSource();
 	_bgMusicSource->SetLooping(true);
+	_bgMusicSource->SetPriority(ASRC_PRIORITY_HIGH);
 
 	Logger::Log(SNDMGR_MODULE, LOG_INFORMATION, "Initialized");
 
@@ -37,38 +37,139 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <atomic>
+#include <memory>
+
 #include <Runtime/Runtime.h>
+#include <Engine/Engine.h>
 #include <Engine/TaskManager.h>
+#include <Platform/Platform.h>
+#include <System/Logger.h>
+
+#define TASKMGR_MODULE	"TaskManager"
+
+using namespace std;
+
+struct ParallelJob
+{
+	atomic<uint32_t> next{ 0 };
+	atomic<uint32_t> done{ 0 };
+	uint32_t count{ 0 }, grain{ 0 }, chunks{ 0 };
+	const function<void(uint32_t, uint32_t)> *fn{ nullptr };
+};
+
+static NThreadPool *_threadPool{ nullptr };
+static atomic<uint32_t> _pendingTasks{ 0 };
+static uint32_t _minWorkers{ 1 }, _maxWorkers{ 64 };
+
+static inline void _RunChunks(ParallelJob *job)
+{
+	uint32_t chunk{ 0 };
+	while ((chunk = job->next.fetch_add(1)) < job->chunks)
+	{
+		uint32_t begin{ chunk * job->grain };
+		uint32_t end{ begin + job->grain };
+		if (end > job->count) end = job->count;
 
-//static NThreadPool *_threadPool{ nullptr };
+		(*job->fn)(begin, end);
+		job->done.fetch_add(1, memory_order_release);
+	}
+}
 
 int TaskManager::Initialize()
 {
+	int32_t workers{ Engine::GetConfiguration().Engine.WorkerThreads };
+
+	if (workers <= 0)
+		workers = Platform::GetNumberOfProcessors() - 1;
+
+	if (workers < (int32_t)_minWorkers) workers = _minWorkers;
+	if (workers > (int32_t)_maxWorkers) workers = _maxWorkers;
+
+	_threadPool = new NThreadPool(workers);
+
+	Logger::Log(TASKMGR_MODULE, LOG_INFORMATION, "Initialized with %d workers", workers);
+
 	return ENGINE_OK;
 }
 
 void TaskManager::SetMinimumTasks(uint32_t min)
 {
-	//
+	_minWorkers = min ? min : 1;
 }
 
 void TaskManager::SetMaximumTasks(uint32_t max)
 {
-	//
+	_maxWorkers = max < _minWorkers ? _minWorkers : max;
 }
 
-bool TaskManager::Schedule(std::function<void(void)> task)
+uint32_t TaskManager::GetWorkerCount()
 {
-	//_threadPool->Enqueue(task);
-	return false;
+	return _threadPool ? _threadPool->GetWorkerCount() : 0;
+}
+
+bool TaskManager::Schedule(function<void(void)> task)
+{
+	if (!_threadPool)
+		return false;
+
+	++_pendingTasks;
+	_threadPool->Enqueue([task]() {
+		task();
+		--_pendingTasks;
+	});
+
+	return true;
+}
+
+void TaskManager::ParallelFor(uint32_t count, uint32_t grain, const function<void(uint32_t begin, uint32_t end)> &fn)
+{
+	if (!count)
+		return;
+
+	if (!grain) grain = 1;
+	uint32_t chunks{ (count + grain - 1) / grain };
+
+	if (!_threadPool || chunks == 1)
+	{
+		fn(0, count);
+		return;
+	}
+
+	// Helpers that start after the caller drained the queue find no chunks left
+	// and only touch the job through the shared pointer they hold.
+	shared_ptr<ParallelJob> job{ make_shared<ParallelJob>() };
+	job->count = count;
+	job->grain = grain;
+	job->chunks = chunks;
+	job->fn = &fn;
+
+	uint32_t helpers{ (uint32_t)_threadPool->GetWorkerCount() };
+	if (helpers > chunks - 1) helpers = chunks - 1;
+
+	for (uint32_t i = 0; i < helpers; ++i)
+		_threadPool->Enqueue([job]() { _RunChunks(job.get()); });
+
+	_RunChunks(job.get());
+
+	while (job->done.load(memory_order_acquire) < chunks)
+		this_thread::yield();
 }
 
 void TaskManager::Wait()
 {
-	//
+	while (_pendingTasks.load())
+		this_thread::yield();
 }
 
 void TaskManager::Release()
 {
-	//
+	if (!_threadPool)
+		return;
+
+	Wait();
+	delete _threadPool;
+	_threadPool = nullptr;
+
+	Logger::Log(TASKMGR_MODULE, LOG_INFORMATION, "Released");
 }
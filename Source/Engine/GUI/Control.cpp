@@ -38,7 +38,6 @@
  */
 
 #include <GUI/Control.h>
-#include <Renderer/VKUtil.h>
 
 Control::Control(int x, int y, int width, int height) :
 	_controlRect{ { Point(x, y) }, { Point(width, height) } },
@@ -46,7 +45,6 @@ Control::Control(int x, int y, int width, int height) :
 	_text(""),
 	_textColor(0.f), _hoveredTextColor(1.f, 0.f, 0.f),
 	_font(GUIManager::GetGUIFont()),
-	_buffer(nullptr),
 	_focused(false),
 	_onClick(nullptr), _onRightClick(nullptr), _onMiddleClick(nullptr),
 	_onMouseEnter(nullptr), _onMouseLeave(nullptr),
@@ -54,21 +52,11 @@ Control::Control(int x, int y, int width, int height) :
 	_onMouseMoved(nullptr),
 	_onKeyUp(nullptr), _onKeyDown(nullptr)
 {
-	_commandBuffer = VK_NULL_HANDLE;
-	_descriptorSet = VK_NULL_HANDLE;
-	_descriptorPool = VK_NULL_HANDLE;
-	_vertexOffset = 0;
+	_layout.SetRect(x, y, width, height);
+	_layout.SetUserData(this);
 }
 
 Control::~Control()
 {
 	GUIManager::UnregisterControl(this);
-
-	if (_commandBuffer != VK_NULL_HANDLE)
-		VKUtil::FreeCommandBuffer(_commandBuffer);
-	_commandBuffer = VK_NULL_HANDLE;
-
-	if (_descriptorPool != VK_NULL_HANDLE)
-		vkDestroyDescriptorPool(VKUtil::GetDevice(), _descriptorPool, VKUtil::GetAllocator());
-	_descriptorPool = VK_NULL_HANDLE;
 }
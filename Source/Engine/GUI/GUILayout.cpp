@@ -0,0 +1,397 @@
+/* NekoEngine
+ *
+ * GUILayout.cpp
+ * Author: Alexandru Naiman
+ *
+ * GUI Layout Solver & Batcher
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include <GUI/GUILayout.h>
+
+using namespace std;
+using namespace glm;
+
+static inline Rect _gl_MakeRect(int x, int y, int w, int h)
+{
+	return Rect{ { Point(x, y) }, { Point(w, h) } };
+}
+
+static inline Rect _gl_Union(const Rect &a, const Rect &b)
+{
+	int x0{ std::min(a.x, b.x) }, y0{ std::min(a.y, b.y) };
+	int x1{ std::max(a.x + a.w, b.x + b.w) }, y1{ std::max(a.y + a.h, b.y + b.h) };
+	return _gl_MakeRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+static inline bool _gl_Overlaps(const vec4 &a, const vec4 &b)
+{
+	return a.x < b.z && b.x < a.z && a.y < b.w && b.y < a.w;
+}
+
+GUILayoutNode::GUILayoutNode() :
+	_parent(nullptr),
+	_anchorMin(0.f), _anchorMax(0.f),
+	_offsetMin(), _offsetMax(),
+	_direction(LayoutDirection::Absolute),
+	_spacing(0), _padding(0),
+	_grow(0.f),
+	_rect{ { Point() }, { Point() } },
+	_userData(nullptr),
+	_visible(true), _solved(false),
+	_dirty(true), _contentDirty(false), _childDirty(false)
+{
+}
+
+void GUILayoutNode::AddChild(GUILayoutNode *child)
+{
+	if (child->_parent)
+		child->_parent->RemoveChild(child);
+
+	child->_parent = this;
+	child->_solved = false;
+	_children.push_back(child);
+
+	child->MarkDirty();
+}
+
+void GUILayoutNode::RemoveChild(GUILayoutNode *child)
+{
+	auto it = find(_children.begin(), _children.end(), child);
+	if (it == _children.end())
+		return;
+
+	_children.erase(it);
+	child->_parent = nullptr;
+
+	// Siblings may move into the freed space and the area it covered must be redrawn
+	_contentDirty = true;
+	MarkDirty();
+}
+
+void GUILayoutNode::ClearChildren()
+{
+	for (GUILayoutNode *child : _children)
+		child->_parent = nullptr;
+	_children.clear();
+
+	_contentDirty = true;
+	MarkDirty();
+}
+
+void GUILayoutNode::SetRect(int x, int y, int width, int height)
+{
+	_anchorMin = _anchorMax = vec2(0.f);
+	_offsetMin = Point(x, y);
+	_offsetMax = Point(x + width, y + height);
+	MarkDirty();
+}
+
+void GUILayoutNode::SetPosition(int x, int y)
+{
+	Point size{ _offsetMax - _offsetMin };
+	_offsetMin = Point(x, y);
+	_offsetMax = _offsetMin + size;
+	MarkDirty();
+}
+
+void GUILayoutNode::SetSize(int width, int height)
+{
+	_offsetMax = _offsetMin + Point(width, height);
+	MarkDirty();
+}
+
+void GUILayoutNode::SetAnchors(vec2 anchorMin, vec2 anchorMax, Point offsetMin, Point offsetMax)
+{
+	_anchorMin = anchorMin;
+	_anchorMax = anchorMax;
+	_offsetMin = offsetMin;
+	_offsetMax = offsetMax;
+	MarkDirty();
+}
+
+void GUILayoutNode::SetDirection(LayoutDirection direction, int spacing, int padding)
+{
+	_direction = direction;
+	_spacing = spacing;
+	_padding = padding;
+	MarkDirty();
+}
+
+void GUILayoutNode::SetGrow(float grow)
+{
+	_grow = grow;
+	MarkDirty();
+}
+
+void GUILayoutNode::SetVisible(bool visible)
+{
+	if (_visible == visible)
+		return;
+
+	_visible = visible;
+	_contentDirty = true;
+	MarkDirty();
+}
+
+void GUILayoutNode::MarkDirty()
+{
+	_dirty = true;
+	_PropagateDirty();
+}
+
+void GUILayoutNode::MarkContentDirty()
+{
+	_contentDirty = true;
+	_PropagateDirty();
+}
+
+void GUILayoutNode::_PropagateDirty()
+{
+	for (GUILayoutNode *node = _parent; node && !node->_childDirty; node = node->_parent)
+		node->_childDirty = true;
+}
+
+GUILayoutNode::~GUILayoutNode()
+{
+	if (_parent)
+		_parent->RemoveChild(this);
+
+	for (GUILayoutNode *child : _children)
+		child->_parent = nullptr;
+}
+
+void GUILayout::Solve(GUILayoutNode *root, const Rect &bounds, GUILayoutResult &result)
+{
+	bool force{ root->_rect != bounds || root->_dirty || !root->_solved };
+
+	result.changed.clear();
+	result.dirtyRects.clear();
+	result.nodesSolved = 0;
+
+	if (root->_rect != bounds)
+		result.dirtyRects.push_back(_gl_Union(root->_rect, bounds));
+
+	root->_rect = bounds;
+	root->_solved = true;
+
+	if (root->_contentDirty)
+		result.dirtyRects.push_back(root->_rect);
+
+	_Arrange(root, force, result);
+
+	root->_dirty = root->_contentDirty = false;
+}
+
+void GUILayout::_Arrange(GUILayoutNode *node, bool force, GUILayoutResult &result)
+{
+	if (!force && !node->_dirty && !node->_childDirty)
+		return;
+
+	const Rect &parent{ node->_rect };
+	int contentX{ parent.x + node->_padding }, contentY{ parent.y + node->_padding };
+	int contentW{ std::max(parent.w - 2 * node->_padding, 0) }, contentH{ std::max(parent.h - 2 * node->_padding, 0) };
+
+	bool row{ node->_direction == LayoutDirection::Row };
+	bool flex{ node->_direction != LayoutDirection::Absolute };
+	float freeSpace{ 0.f }, growSum{ 0.f }, cursor{ 0.f };
+
+	if (flex)
+	{
+		int used{ 0 }, count{ 0 };
+
+		for (GUILayoutNode *child : node->_children)
+		{
+			if (!child->_visible)
+				continue;
+
+			used += row ? child->_offsetMax.x - child->_offsetMin.x : child->_offsetMax.y - child->_offsetMin.y;
+			growSum += child->_grow;
+			++count;
+		}
+
+		if (count)
+			used += node->_spacing * (count - 1);
+
+		freeSpace = (float)std::max((row ? contentW : contentH) - used, 0);
+		cursor = (float)(row ? contentX : contentY);
+	}
+
+	for (GUILayoutNode *child : node->_children)
+	{
+		if (!child->_visible)
+		{
+			// Hidden subtrees keep their flags until they are shown again
+			if (child->_contentDirty && child->_solved)
+			{
+				result.changed.push_back(child);
+				result.dirtyRects.push_back(child->_rect);
+			}
+
+			child->_dirty = child->_contentDirty = false;
+			continue;
+		}
+
+		int x0{ contentX + (int)(child->_anchorMin.x * contentW) + child->_offsetMin.x };
+		int y0{ contentY + (int)(child->_anchorMin.y * contentH) + child->_offsetMin.y };
+		int x1{ contentX + (int)(child->_anchorMax.x * contentW) + child->_offsetMax.x };
+		int y1{ contentY + (int)(child->_anchorMax.y * contentH) + child->_offsetMax.y };
+
+		if (flex)
+		{
+			int preferred{ row ? child->_offsetMax.x - child->_offsetMin.x : child->_offsetMax.y - child->_offsetMin.y };
+			float extent{ (float)preferred + (growSum > 0.f ? freeSpace * child->_grow / growSum : 0.f) };
+
+			// Round the edges, not the sizes, so the children tile the free space without gaps
+			int start{ (int)roundf(cursor) }, end{ (int)roundf(cursor + extent) };
+			cursor += extent + node->_spacing;
+
+			if (row) { x0 = start; x1 = end; }
+			else { y0 = start; y1 = end; }
+		}
+
+		Rect rect{ _gl_MakeRect(x0, y0, std::max(x1 - x0, 0), std::max(y1 - y0, 0)) };
+		bool moved{ !child->_solved || rect != child->_rect };
+
+		if (moved)
+		{
+			result.dirtyRects.push_back(child->_solved ? _gl_Union(child->_rect, rect) : rect);
+			child->_rect = rect;
+			child->_solved = true;
+		}
+		else if (child->_contentDirty)
+			result.dirtyRects.push_back(rect);
+
+		if (moved || child->_contentDirty)
+			result.changed.push_back(child);
+
+		++result.nodesSolved;
+
+		bool childForce{ moved || child->_dirty };
+		child->_dirty = child->_contentDirty = false;
+
+		_Arrange(child, childForce, result);
+	}
+
+	node->_childDirty = false;
+}
+
+void GUIBatcher::Begin()
+{
+	_quads.clear();
+	_quadBounds.clear();
+	_batches.clear();
+	_batchBounds.clear();
+	_quadCount = 0;
+
+	// Keep the per batch lists allocated between frames
+	for (vector<uint32_t> &quads : _batchQuads)
+		quads.clear();
+}
+
+void GUIBatcher::AddQuad(uint32_t pipeline, const void *texture, const GUIVertex *vertices)
+{
+	vec4 bounds{ vertices[0].posAndUV.x, vertices[0].posAndUV.y, vertices[0].posAndUV.x, vertices[0].posAndUV.y };
+	for (int i = 1; i < 4; ++i)
+	{
+		bounds.x = std::min(bounds.x, vertices[i].posAndUV.x);
+		bounds.y = std::min(bounds.y, vertices[i].posAndUV.y);
+		bounds.z = std::max(bounds.z, vertices[i].posAndUV.x);
+		bounds.w = std::max(bounds.w, vertices[i].posAndUV.y);
+	}
+
+	uint32_t target{ (uint32_t)_batches.size() };
+	uint32_t budget{ GUI_BATCH_LOOKBACK };
+	bool blocked{ false };
+
+	// A batch is drawn before every batch created after it, so the quad may only join it
+	// if it overlaps nothing in those later batches
+	for (size_t i = _batches.size(); i > 0 && !blocked; --i)
+	{
+		const GUIBatch &batch{ _batches[i - 1] };
+
+		if (batch.pipeline == pipeline && batch.texture == texture)
+		{
+			target = (uint32_t)(i - 1);
+			break;
+		}
+
+		if (!_gl_Overlaps(_batchBounds[i - 1], bounds))
+			continue;
+
+		for (uint32_t quad : _batchQuads[i - 1])
+		{
+			if (!budget-- || _gl_Overlaps(_quadBounds[quad], bounds))
+			{
+				blocked = true;
+				break;
+			}
+		}
+	}
+
+	if (target == _batches.size())
+	{
+		_batches.push_back({ pipeline, texture, 0, 0 });
+		_batchBounds.push_back(bounds);
+
+		if (_batchQuads.size() < _batches.size())
+			_batchQuads.emplace_back();
+	}
+	else
+	{
+		vec4 &b{ _batchBounds[target] };
+		b = vec4(std::min(b.x, bounds.x), std::min(b.y, bounds.y), std::max(b.z, bounds.z), std::max(b.w, bounds.w));
+	}
+
+	++_batches[target].quadCount;
+	_batchQuads[target].push_back(_quadCount++);
+	_quadBounds.push_back(bounds);
+	_quads.insert(_quads.end(), vertices, vertices + 4);
+}
+
+void GUIBatcher::End()
+{
+	uint32_t first{ 0 };
+
+	_vertices.resize(_quads.size());
+
+	for (size_t i = 0; i < _batches.size(); ++i)
+	{
+		_batches[i].firstQuad = first;
+
+		for (uint32_t quad : _batchQuads[i])
+			memcpy(&_vertices[first++ * 4], &_quads[quad * 4], sizeof(GUIVertex) * 4);
+	}
+}
@@ -41,6 +41,8 @@
 #include <Renderer/NFont.h>
 #include <Renderer/VKUtil.h>
 #include <Renderer/PipelineManager.h>
+#include <Renderer/DebugMarker.h>
+#include <Renderer/RenderPassManager.h>
 #include <Engine/ResourceManager.h>
 #include <Engine/EventManager.h>
 #include <Input/Keycodes.h>
@@ -58,19 +60,42 @@ typedef struct GUI_DATA
 } GUIData;
 
 VkDescriptorPool GUIManager::_descriptorPool = VK_NULL_HANDLE;
+VkDescriptorPool GUIManager::_textureDescriptorPool = VK_NULL_HANDLE;
 VkDescriptorSet GUIManager::_descriptorSet = VK_NULL_HANDLE;
 VkCommandBuffer GUIManager::_commandBuffer = VK_NULL_HANDLE;
 VkSampler GUIManager::_sampler = VK_NULL_HANDLE;
 Buffer *GUIManager::_buffer = nullptr;
 Buffer *GUIManager::_indexBuffer = nullptr;
+Buffer *GUIManager::_vertexBuffer = nullptr;
 NFont *GUIManager::_systemFont = nullptr;
 bool GUIManager::_needUpdate = true;
+bool GUIManager::_rebuildBatches = true;
+bool GUIManager::_rebuildCommandBuffer = false;
 vector<class NFont *> GUIManager::_fonts;
 vector<class Control *> GUIManager::_controls;
+unordered_map<const void *, VkDescriptorSet> GUIManager::_textureSets;
+vector<GUIBatch> GUIManager::_drawnBatches;
+vector<GUIVertex> GUIManager::_uploadedVertices;
+GUILayoutNode GUIManager::_layoutRoot;
+GUILayoutResult GUIManager::_layoutResult;
+GUIBatcher GUIManager::_batcher;
+vector<GUIManager::GUIRetiredObject> GUIManager::_retiredObjects;
+uint64_t GUIManager::_frame{ 0 };
 
 static Control *_focusedControl{ nullptr };
 static GUIData _guiData{};
-static uint32_t _sceneUnloadedEventHandler;
+static uint32_t _sceneUnloadedEventHandler, _textureReleasedEventHandler;
+
+// Largest run of vertices Buffer::UpdateData records inline with vkCmdUpdateBuffer
+static const size_t _gm_uploadChunk{ 65535 / sizeof(GUIVertex) };
+
+static inline bool _gm_IsShown(const GUILayoutNode *node)
+{
+	for (; node; node = node->GetParent())
+		if (!node->IsVisible())
+			return false;
+	return true;
+}
 
 int GUIManager::Initialize()
 {
@@ -93,13 +118,40 @@ int GUIManager::Initialize()
 	if ((_systemFont = (NFont *)ResourceManager::GetResourceByName("fnt_system", ResourceType::RES_FONT)) == nullptr)
 		return ENGINE_FAIL;
 
-	uint16_t indices[6]{ 0, 1, 2, 0, 2, 3 };
-	if ((_indexBuffer = new Buffer(sizeof(uint16_t) * 6, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, (uint8_t *)indices, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) == nullptr)
+	// Batches start at vertexOffset = firstQuad * 4, so one quad pattern serves every draw
+	vector<uint16_t> indices(GUI_MAX_QUADS * 6);
+	for (uint16_t i = 0; i < GUI_MAX_QUADS; ++i)
+	{
+		indices[i * 6] = i * 4;
+		indices[i * 6 + 1] = i * 4 + 1;
+		indices[i * 6 + 2] = i * 4 + 2;
+		indices[i * 6 + 3] = i * 4;
+		indices[i * 6 + 4] = i * 4 + 2;
+		indices[i * 6 + 5] = i * 4 + 3;
+	}
+
+	if ((_indexBuffer = new Buffer(sizeof(uint16_t) * indices.size(), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, (uint8_t *)indices.data(), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) == nullptr)
+	{ DIE("Out of resources"); }
+
+	if ((_vertexBuffer = new Buffer(sizeof(GUIVertex) * 4 * GUI_MAX_QUADS, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, nullptr, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) == nullptr)
 	{ DIE("Out of resources"); }
 
 	_sceneUnloadedEventHandler = EventManager::RegisterHandler(NE_EVT_SCN_UNLOADED, [&](int32_t eventId, void *eventData) {
 		GUIManager::_controls.clear();
+		GUIManager::_layoutRoot.ClearChildren();
 		_focusedControl = nullptr;
+
+		// The scene's textures are gone; drop the descriptor sets that reference them
+		vkDeviceWaitIdle(VKUtil::GetDevice());
+		GUIManager::_ReleaseRetired(true);
+		vkResetDescriptorPool(VKUtil::GetDevice(), GUIManager::_textureDescriptorPool, 0);
+		GUIManager::_textureSets.clear();
+		GUIManager::_drawnBatches.clear();
+		GUIManager::_rebuildBatches = GUIManager::_rebuildCommandBuffer = true;
+	});
+
+	_textureReleasedEventHandler = EventManager::RegisterHandler(NE_EVT_TEX_RELEASED, [&](int32_t eventId, void *eventData) {
+		GUIManager::_TextureReleased((Texture *)eventData);
 	});
 
 	Logger::Log(GUI_MODULE, LOG_INFORMATION, "Initialized");
@@ -120,8 +172,8 @@ void GUIManager::DrawString(glm::vec2 pos, glm::vec3 color, const char *fmt, ...
 {
 	va_list args;
 	char buff[8192];
-	memset(buff, 0x0, 8192);
 
+	// vsnprintf terminates the string; the font hashes it and skips tessellation if it was drawn last frame
 	va_start(args, fmt);
 	vsnprintf(buff, 8192, fmt, args);
 	va_end(args);
@@ -166,7 +218,7 @@ void GUIManager::Update(double deltaTime)
 
 	for (Control *ctl : _controls)
 	{
-		if (!ctl->_visible)
+		if (!_gm_IsShown(&ctl->_layout))
 			continue;
 
 		if (ctl->_controlRect.PtInRect(mousePos))
@@ -219,24 +271,100 @@ void GUIManager::Update(double deltaTime)
 			if (ctl->_onMouseLeave) ctl->_onMouseLeave();
 			ctl->_hovered = false;
 		}
-
-		ctl->_Update(deltaTime);
 	}
 
 	lastMousePos = mousePos;
+
+	// Solve after the handlers ran so anything they moved is drawn this frame
+	GUILayout::Solve(&_layoutRoot, Rect{ { Point() }, { Point(Engine::GetScreenWidth(), Engine::GetScreenHeight()) } }, _layoutResult);
+
+	for (GUILayoutNode *node : _layoutResult.changed)
+	{
+		Control *ctl{ (Control *)node->GetUserData() };
+		ctl->_controlRect = node->GetRect();
+		ctl->_LayoutChanged();
+	}
+
+	if (!_layoutResult.dirtyRects.empty())
+		_rebuildBatches = true;
+
+	for (Control *ctl : _controls)
+		if (_gm_IsShown(&ctl->_layout))
+			ctl->_Update(deltaTime);
 }
 
 void GUIManager::UpdateData(VkCommandBuffer cmdBuffer)
 {
+	++_frame;
+	_ReleaseRetired(false);
+
 	if (_needUpdate)
 	{
 		_buffer->UpdateData((uint8_t *)&_guiData, 0, sizeof(GUIData), cmdBuffer);
 		_needUpdate = false;
 	}
 
-	for (Control *ctl : _controls)
-		if (ctl->_visible)
-			ctl->_UpdateData((void *)&cmdBuffer);
+	if (_rebuildBatches)
+	{
+		_batcher.Begin();
+		_BatchNode(&_layoutRoot);
+		_batcher.End();
+
+		const vector<GUIVertex> &vertices{ _batcher.GetVertices() };
+		size_t count{ vertices.size() };
+
+		if (count > GUI_MAX_QUADS * 4)
+		{
+			Logger::Log(GUI_MODULE, LOG_WARNING, "%u quads submitted, only %d will be drawn", _batcher.GetQuadCount(), GUI_MAX_QUADS);
+			count = GUI_MAX_QUADS * 4;
+		}
+
+		// Only the span that differs from last upload goes to the GPU
+		size_t first{ 0 }, last{ count }, common{ std::min(count, _uploadedVertices.size()) };
+
+		while (first < common && !memcmp(&vertices[first], &_uploadedVertices[first], sizeof(GUIVertex)))
+			++first;
+
+		if (count <= _uploadedVertices.size())
+			while (last > first && !memcmp(&vertices[last - 1], &_uploadedVertices[last - 1], sizeof(GUIVertex)))
+				--last;
+
+		for (size_t offset = first; offset < last; offset += _gm_uploadChunk)
+		{
+			size_t size{ std::min(_gm_uploadChunk, last - offset) * sizeof(GUIVertex) };
+			_vertexBuffer->UpdateData((uint8_t *)&vertices[offset], offset * sizeof(GUIVertex), size, cmdBuffer);
+		}
+
+		_uploadedVertices.assign(vertices.begin(), vertices.begin() + count);
+
+		vector<GUIBatch> batches;
+		for (const GUIBatch &batch : _batcher.GetBatches())
+		{
+			if (batch.firstQuad >= GUI_MAX_QUADS)
+				break;
+
+			batches.push_back(batch);
+			batches.back().quadCount = std::min(batch.quadCount, GUI_MAX_QUADS - batch.firstQuad);
+		}
+
+		// Moving or recolouring controls keeps the batch layout; only a new layout needs new commands
+		if (!equal(batches.begin(), batches.end(), _drawnBatches.begin(), _drawnBatches.end(), [](const GUIBatch &a, const GUIBatch &b) {
+			return a.pipeline == b.pipeline && a.texture == b.texture && a.firstQuad == b.firstQuad && a.quadCount == b.quadCount;
+		}))
+		{
+			_drawnBatches.swap(batches);
+			_rebuildCommandBuffer = true;
+		}
+
+		_rebuildBatches = false;
+	}
+
+	// The previous command buffer is retired, not freed, so frames in flight are not waited for
+	if (_rebuildCommandBuffer)
+	{
+		if (_BuildCommandBuffer() != ENGINE_OK)
+		{ DIE("Failed to build GUI command buffer"); }
+	}
 
 	for (NFont *font : _fonts)
 		font->UpdateData(cmdBuffer);
@@ -244,9 +372,8 @@ void GUIManager::UpdateData(VkCommandBuffer cmdBuffer)
 
 void GUIManager::PrepareCommandBuffers()
 {
-	for (Control *ctl : _controls)
-		if (ctl->_visible && ctl->_commandBuffer != VK_NULL_HANDLE)
-			Renderer::GetInstance()->AddGUICommandBuffer(ctl->_commandBuffer);
+	if (_commandBuffer != VK_NULL_HANDLE)
+		Renderer::GetInstance()->AddGUICommandBuffer(_commandBuffer);
 
 	for (NFont *font : _fonts)
 		Renderer::GetInstance()->AddGUICommandBuffer(font->GetCommandBuffer());
@@ -259,11 +386,8 @@ int GUIManager::RegisterControl(class Control *ctl)
 	if ((ret = ctl->_InitializeControl()) != ENGINE_OK)
 		return ret;
 
-	if ((ret = ctl->_CreateDescriptorSet()) != ENGINE_OK)
-		return ret;
-
-	if ((ret = ctl->_BuildCommandBuffer()) != ENGINE_OK)
-		return ret;
+	if (!ctl->_layout.GetParent())
+		_layoutRoot.AddChild(&ctl->_layout);
 
 	_controls.push_back(ctl);
 
@@ -277,22 +401,43 @@ void GUIManager::RegisterFont(class NFont *font)
 
 void GUIManager::UnregisterControl(class Control *ctl)
 {
-	_controls.erase(remove(_controls.begin(), _controls.end(), ctl), _controls.end());
+	// Children leave the tree with their parent; they must not be hit-tested or updated
+	vector<Control *> removed{ ctl };
+	for (size_t i = 0; i < removed.size(); ++i)
+		for (GUILayoutNode *child : removed[i]->_layout.GetChildren())
+			removed.push_back((Control *)child->GetUserData());
+
+	_controls.erase(remove_if(_controls.begin(), _controls.end(), [&removed](Control *c) {
+		return find(removed.begin(), removed.end(), c) != removed.end();
+	}), _controls.end());
+
+	if (ctl->_layout.GetParent())
+		ctl->_layout.GetParent()->RemoveChild(&ctl->_layout);
+
+	if (find(removed.begin(), removed.end(), _focusedControl) != removed.end())
+		_focusedControl = nullptr;
 }
 
+GUILayoutNode *GUIManager::GetRootNode() noexcept { return &_layoutRoot; }
+const GUILayoutResult &GUIManager::GetLayoutResult() noexcept { return _layoutResult; }
+uint32_t GUIManager::GetBatchCount() noexcept { return (uint32_t)_drawnBatches.size(); }
+uint32_t GUIManager::GetQuadCount() noexcept { return _batcher.GetQuadCount(); }
+
 void GUIManager::ScreenResized()
 {
 	_guiData.ScreenSize = ivec2(Engine::GetScreenWidth(), Engine::GetScreenHeight());
 	_guiData.Projection = ortho(0.f, (float)Engine::GetScreenWidth(), (float)Engine::GetScreenHeight(), 0.f);
 	_needUpdate = true;
 
+	// Vertices are flipped against the screen height, so every quad moves
+	for (Control *ctl : _controls)
+		ctl->_LayoutChanged();
+	_rebuildBatches = true;
+
 	vkDeviceWaitIdle(VKUtil::GetDevice());
 
-	for (Control *ctl : _controls)
-	{
-		if (ctl->_RebuildCommandBuffer() != ENGINE_OK)
-		{ DIE("Failed to recreate command buffers"); }
-	}
+	if (_BuildCommandBuffer() != ENGINE_OK)
+	{ DIE("Failed to recreate GUI command buffer"); }
 
 	vkDeviceWaitIdle(VKUtil::GetDevice());
 }
@@ -347,15 +492,196 @@ bool GUIManager::_CreateDescriptorSet()
 
 	vkUpdateDescriptorSets(VKUtil::GetDevice(), 1, &writeBuffer, 0, nullptr);
 
+	size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	size.descriptorCount = GUI_MAX_TEXTURES;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+	poolInfo.maxSets = GUI_MAX_TEXTURES;
+
+	if (vkCreateDescriptorPool(VKUtil::GetDevice(), &poolInfo, VKUtil::GetAllocator(), &_textureDescriptorPool) != VK_SUCCESS)
+	{
+		Logger::Log(GUI_MODULE, LOG_CRITICAL, "Failed to create texture descriptor pool");
+		return false;
+	}
+
 	return true;
 }
 
+VkDescriptorSet GUIManager::_GetTextureDescriptorSet(Texture *texture)
+{
+	if (!texture)
+		return Renderer::GetInstance()->GetBlankTextureDescriptorSet();
+
+	auto it = _textureSets.find(texture);
+	if (it != _textureSets.end())
+		return it->second;
+
+	VkDescriptorSet set{ VK_NULL_HANDLE };
+	VkDescriptorSetLayout layout{ PipelineManager::GetDescriptorSetLayout(DESC_LYT_OneSampler) };
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = _textureDescriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &layout;
+
+	if (vkAllocateDescriptorSets(VKUtil::GetDevice(), &allocInfo, &set) != VK_SUCCESS)
+	{
+		Logger::Log(GUI_MODULE, LOG_WARNING, "More than %d GUI textures in use, falling back to the blank texture", GUI_MAX_TEXTURES);
+		return Renderer::GetInstance()->GetBlankTextureDescriptorSet();
+	}
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = texture->GetImageView();
+	imageInfo.sampler = _sampler;
+
+	VkWriteDescriptorSet textureDescriptorWrite{};
+	textureDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	textureDescriptorWrite.dstSet = set;
+	textureDescriptorWrite.dstBinding = 0;
+	textureDescriptorWrite.dstArrayElement = 0;
+	textureDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	textureDescriptorWrite.descriptorCount = 1;
+	textureDescriptorWrite.pBufferInfo = nullptr;
+	textureDescriptorWrite.pImageInfo = &imageInfo;
+	textureDescriptorWrite.pTexelBufferView = nullptr;
+
+	vkUpdateDescriptorSets(VKUtil::GetDevice(), 1, &textureDescriptorWrite, 0, nullptr);
+
+	_textureSets.insert(make_pair(texture, set));
+
+	return set;
+}
+
+void GUIManager::_TextureReleased(Texture *texture)
+{
+	auto it = _textureSets.find(texture);
+	if (it == _textureSets.end())
+		return;
+
+	// Another texture may be created at the same address
+	_Retire(VK_NULL_HANDLE, it->second);
+	_textureSets.erase(it);
+
+	if (any_of(_drawnBatches.begin(), _drawnBatches.end(), [texture](const GUIBatch &batch) { return batch.texture == texture; }))
+		_rebuildCommandBuffer = true;
+}
+
+void GUIManager::_BatchNode(GUILayoutNode *node)
+{
+	for (GUILayoutNode *child : node->GetChildren())
+	{
+		if (!child->IsVisible())
+			continue;
+
+		((Control *)child->GetUserData())->_Batch(_batcher);
+		_BatchNode(child);
+	}
+}
+
+int GUIManager::_BuildCommandBuffer()
+{
+	_rebuildCommandBuffer = false;
+
+	if (_commandBuffer != VK_NULL_HANDLE)
+		_Retire(_commandBuffer, VK_NULL_HANDLE);
+	_commandBuffer = VK_NULL_HANDLE;
+
+	if (_drawnBatches.empty())
+		return ENGINE_OK;
+
+	_commandBuffer = VKUtil::CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+	VkCommandBufferInheritanceInfo inheritanceInfo{};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.occlusionQueryEnable = VK_FALSE;
+	inheritanceInfo.renderPass = RenderPassManager::GetRenderPass(RP_GUI);
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = Renderer::GetInstance()->GetGUIFramebuffer();
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	if (vkBeginCommandBuffer(_commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		Logger::Log(GUI_MODULE, LOG_CRITICAL, "vkBeginCommandBuffer call failed");
+		return ENGINE_FAIL;
+	}
+
+	VK_DBG_MARKER_INSERT(_commandBuffer, "GUI", vec4(1.0, 0.5, 0.0, 1.0));
+
+	VkDeviceSize offset{ _vertexBuffer->GetParentOffset() };
+	vkCmdBindVertexBuffers(_commandBuffer, 0, 1, &_vertexBuffer->GetHandle(), &offset);
+	vkCmdBindIndexBuffer(_commandBuffer, _indexBuffer->GetHandle(), _indexBuffer->GetParentOffset(), VK_INDEX_TYPE_UINT16);
+
+	BindDescriptorSet(_commandBuffer);
+
+	uint32_t pipeline{ UINT32_MAX };
+	for (const GUIBatch &batch : _drawnBatches)
+	{
+		if (batch.pipeline != pipeline)
+		{
+			pipeline = batch.pipeline;
+			vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipeline((PipelineId)pipeline));
+		}
+
+		VkDescriptorSet textureSet{ _GetTextureDescriptorSet((Texture *)batch.texture) };
+		vkCmdBindDescriptorSets(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipelineLayout(PIPE_LYT_GUI), 1, 1, &textureSet, 0, nullptr);
+
+		vkCmdDrawIndexed(_commandBuffer, batch.quadCount * 6, 1, 0, batch.firstQuad * 4, 0);
+	}
+
+	if (vkEndCommandBuffer(_commandBuffer) != VK_SUCCESS)
+	{
+		Logger::Log(GUI_MODULE, LOG_CRITICAL, "vkEndCommandBuffer call failed");
+		return ENGINE_FAIL;
+	}
+
+	return ENGINE_OK;
+}
+
+void GUIManager::_Retire(VkCommandBuffer commandBuffer, VkDescriptorSet textureSet)
+{
+	_retiredObjects.push_back({ _frame, commandBuffer, textureSet });
+}
+
+void GUIManager::_ReleaseRetired(bool all)
+{
+	size_t count{ 0 };
+
+	// Retired in frame order
+	for (const GUIRetiredObject &obj : _retiredObjects)
+	{
+		if (!all && obj.frame + MAX_INFLIGHT_COMMAND_BUFFERS > _frame)
+			break;
+
+		if (obj.commandBuffer != VK_NULL_HANDLE)
+			VKUtil::FreeCommandBuffer(obj.commandBuffer);
+
+		if (obj.textureSet != VK_NULL_HANDLE)
+			vkFreeDescriptorSets(VKUtil::GetDevice(), _textureDescriptorPool, 1, &obj.textureSet);
+
+		++count;
+	}
+
+	_retiredObjects.erase(_retiredObjects.begin(), _retiredObjects.begin() + count);
+}
+
 void GUIManager::Release()
 {
 	delete _buffer;
 	delete _indexBuffer;
+	delete _vertexBuffer;
+
+	_ReleaseRetired(true);
+
+	if (_commandBuffer != VK_NULL_HANDLE)
+		VKUtil::FreeCommandBuffer(_commandBuffer);
 
 	EventManager::UnregisterHandler(NE_EVT_SCN_UNLOADED, _sceneUnloadedEventHandler);
+	EventManager::UnregisterHandler(NE_EVT_TEX_RELEASED, _textureReleasedEventHandler);
 
 	if (_sampler != VK_NULL_HANDLE)
 		vkDestroySampler(VKUtil::GetDevice(), _sampler, VKUtil::GetAllocator());
@@ -363,6 +689,9 @@ void GUIManager::Release()
 	if (_descriptorPool != VK_NULL_HANDLE)
 		vkDestroyDescriptorPool(VKUtil::GetDevice(), _descriptorPool, VKUtil::GetAllocator());
 
+	if (_textureDescriptorPool != VK_NULL_HANDLE)
+		vkDestroyDescriptorPool(VKUtil::GetDevice(), _textureDescriptorPool, VKUtil::GetAllocator());
+
 	if (_systemFont)
 	{
 		ResourceManager::UnloadResourceByName("fnt_system", ResourceType::RES_FONT);
@@ -371,13 +700,3 @@ void GUIManager::Release()
 
 	Logger::Log(GUI_MODULE, LOG_INFORMATION, "Released");
 }
-
-Buffer *GUIManager::CreateVertexBuffer(size_t size, uint8_t *data)
-{
-	return new Buffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, data, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-}
-
-void GUIManager::FreeVertexBuffer(Buffer *buff)
-{
-	delete buff;
-}
@@ -75,7 +75,9 @@ void TextBox::_Update(double deltaTime)
 	float x = ((float)_controlRect.w - (float)_font->GetTextLength(_text)) / 2.f;
 	vec2 pos = vec2(_controlRect.x + x, _controlRect.y + y);
 
-	while (_font->GetTextLength(text) > (uint32_t)_controlRect.w - 5) ++text;
+	// Drop whole UTF-8 sequences from the front until the text fits
+	while (*text && _font->GetTextLength(text) > (uint32_t)_controlRect.w - 5)
+		do ++text; while ((*text & 0xC0) == 0x80);
 	
 	_font->Draw(text, pos, _textColor);
 }
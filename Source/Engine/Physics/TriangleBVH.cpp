@@ -0,0 +1,714 @@
+/* NekoEngine
+ *
+ * TriangleBVH.cpp
+ * Author: Alexandru Naiman
+ *
+ * Bounding volume hierarchy over mesh triangles
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+#include <numeric>
+
+#include <System/Logger.h>
+#include <System/VFS/VFS.h>
+#include <Physics/TriangleBVH.h>
+#include <Renderer/StaticMesh.h>
+
+#define BVH_MODULE				"TriangleBVH"
+#define BVH_HEADER				"NBVH1  "
+#define BVH_BINS				16
+#define BVH_MAX_LEAF_SIZE		8
+#define BVH_MAX_DEPTH			46
+#define BVH_MEDIAN_LEVELS		17
+#define BVH_STACK_SIZE			64
+#define BVH_TRAVERSAL_COST		1.f
+#define BVH_EPSILON				1e-12f
+
+using namespace std;
+using namespace glm;
+
+static_assert(sizeof(BVHNode) == 32, "BVHNode must be 32 bytes");
+
+// Past BVH_MAX_DEPTH nodes are split at the median until they fit in a leaf,
+// which takes at most 17 levels for 2^32 triangles. A traversal holds at most
+// depth + 1 nodes on the stack.
+static_assert(BVH_MAX_DEPTH + BVH_MEDIAN_LEVELS + 1 <= BVH_STACK_SIZE, "BVH depth exceeds the traversal stack");
+
+static inline float _bvh_Area(const vec3 &min, const vec3 &max)
+{
+	const vec3 d{ max - min };
+	return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+static inline bool _bvh_RayBox(const vec3 &origin, const vec3 &invDir, const BVHNode &node, float maxT)
+{
+	const vec3 t0{ (node.min - origin) * invDir }, t1{ (node.max - origin) * invDir };
+	const vec3 tmin{ glm::min(t0, t1) }, tmax{ glm::max(t0, t1) };
+
+	return glm::max(glm::max(tmin.x, tmin.y), glm::max(tmin.z, 0.f)) <= glm::min(glm::min(tmax.x, tmax.y), glm::min(tmax.z, maxT));
+}
+
+static inline bool _bvh_BoxBox(const BVHNode &node, const vec3 &min, const vec3 &max)
+{
+	return node.min.x <= max.x && min.x <= node.max.x &&
+		node.min.y <= max.y && min.y <= node.max.y &&
+		node.min.z <= max.z && min.z <= node.max.z;
+}
+
+// Separating axis test (Akenine-Moller, Fast 3D Triangle-Box Overlap Testing)
+static bool _bvh_TriangleBox(const vec3 &center, const vec3 &half, const vec3 *triangle)
+{
+	const vec3 v[3]{ triangle[0] - center, triangle[1] - center, triangle[2] - center };
+	const vec3 e[3]{ v[1] - v[0], v[2] - v[1], v[0] - v[2] };
+
+	for (uint8_t i = 0; i < 3; ++i)
+	{
+		for (uint8_t j = 0; j < 3; ++j)
+		{
+			vec3 unit{ 0.f };
+			unit[i] = 1.f;
+
+			const vec3 axis{ cross(unit, e[j]) };
+			const float p0{ dot(v[0], axis) }, p1{ dot(v[1], axis) }, p2{ dot(v[2], axis) };
+			const float r{ dot(half, abs(axis)) };
+
+			if (glm::min(p0, glm::min(p1, p2)) > r || glm::max(p0, glm::max(p1, p2)) < -r)
+				return false;
+		}
+	}
+
+	for (uint8_t i = 0; i < 3; ++i)
+		if (glm::min(v[0][i], glm::min(v[1][i], v[2][i])) > half[i] || glm::max(v[0][i], glm::max(v[1][i], v[2][i])) < -half[i])
+			return false;
+
+	const vec3 n{ cross(e[0], e[1]) };
+	return fabsf(dot(n, v[0])) <= dot(half, abs(n));
+}
+
+// Closest point on a triangle (Ericson, Real-Time Collision Detection 5.1.5)
+static vec3 _bvh_ClosestPtTriangle(const vec3 &p, const vec3 &a, const vec3 &b, const vec3 &c)
+{
+	const vec3 ab{ b - a }, ac{ c - a }, ap{ p - a };
+	const float d1{ dot(ab, ap) }, d2{ dot(ac, ap) };
+	if (d1 <= 0.f && d2 <= 0.f) return a;
+
+	const vec3 bp{ p - b };
+	const float d3{ dot(ab, bp) }, d4{ dot(ac, bp) };
+	if (d3 >= 0.f && d4 <= d3) return b;
+
+	const float vc{ d1 * d4 - d3 * d2 };
+	if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) return a + ab * (d1 / (d1 - d3));
+
+	const vec3 cp{ p - c };
+	const float d5{ dot(ab, cp) }, d6{ dot(ac, cp) };
+	if (d6 >= 0.f && d5 <= d6) return c;
+
+	const float vb{ d5 * d2 - d1 * d6 };
+	if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) return a + ac * (d2 / (d2 - d6));
+
+	const float va{ d3 * d6 - d5 * d4 };
+	if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	const float denom{ 1.f / (va + vb + vc) };
+	return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+uint64_t TriangleBVH::HashTriangles(const vector<vec3> &triangles) noexcept
+{
+	// FNV-1a
+	uint64_t hash{ 14695981039346656037ull };
+	const uint8_t *data{ (const uint8_t *)triangles.data() };
+
+	for (size_t i = 0; i < triangles.size() * sizeof(vec3); ++i)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+void TriangleBVH::GetMeshTriangles(const StaticMesh *mesh, vector<vec3> &triangles)
+{
+	const vector<Vertex> &vertices{ mesh->GetVertices() };
+	const vector<uint32_t> &indices{ mesh->GetIndices() };
+
+	triangles.clear();
+	triangles.reserve(indices.size());
+
+	// Group indices are relative to the group's first vertex
+	if (mesh->GetGroupCount())
+	{
+		for (uint32_t g = 0; g < mesh->GetGroupCount(); ++g)
+		{
+			const uint32_t vertexOffset{ mesh->GetGroupVertexOffset(g) };
+			const uint32_t indexOffset{ mesh->GetGroupIndexOffset(g) };
+			const uint32_t indexCount{ mesh->GetGroupIndexCount(g) - mesh->GetGroupIndexCount(g) % 3 };
+
+			for (uint32_t i = indexOffset; i < indexOffset + indexCount; ++i)
+				triangles.push_back(vertices[vertexOffset + indices[i]].position);
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			for (size_t j = 0; j < 3; ++j)
+				triangles.push_back(vertices[indices[i + j]].position);
+	}
+}
+
+int TriangleBVH::Build(const StaticMesh *mesh)
+{
+	vector<vec3> triangles{};
+	GetMeshTriangles(mesh, triangles);
+	return Build(triangles);
+}
+
+int TriangleBVH::Build(const vector<vec3> &triangles)
+{
+	const uint32_t count{ (uint32_t)(triangles.size() / 3) };
+
+	_nodes.clear();
+	_vertices.clear();
+	_triangleIds.clear();
+	_sourceHash = HashTriangles(triangles);
+
+	if (!count)
+	{
+		_nodes.push_back(BVHNode{ vec3(0.f), 0, vec3(0.f), 0, 0 });
+		return ENGINE_OK;
+	}
+
+	vector<vec3> lo(count), hi(count), centroids(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const vec3 &a{ triangles[i * 3] }, &b{ triangles[i * 3 + 1] }, &c{ triangles[i * 3 + 2] };
+		lo[i] = glm::min(a, glm::min(b, c));
+		hi[i] = glm::max(a, glm::max(b, c));
+		centroids[i] = (lo[i] + hi[i]) * .5f;
+	}
+
+	_triangleIds.resize(count);
+	iota(_triangleIds.begin(), _triangleIds.end(), 0);
+
+	_nodes.reserve(count * 2);
+	_Build(0, count, _triangleIds, lo, hi, centroids, 0);
+	_nodes.shrink_to_fit();
+
+	_vertices.resize(triangles.size());
+	for (uint32_t i = 0; i < count; ++i)
+		memcpy(&_vertices[i * 3], &triangles[_triangleIds[i] * 3], sizeof(vec3) * 3);
+
+	return ENGINE_OK;
+}
+
+uint32_t TriangleBVH::_Build(uint32_t first, uint32_t count, vector<uint32_t> &ids, const vector<vec3> &lo,
+	const vector<vec3> &hi, const vector<vec3> &centroids, uint32_t depth)
+{
+	struct Bin
+	{
+		vec3 min, max;
+		uint32_t count;
+	};
+
+	const uint32_t index{ (uint32_t)_nodes.size() };
+	_nodes.push_back(BVHNode{});
+
+	vec3 min{ FLT_MAX }, max{ -FLT_MAX }, cmin{ FLT_MAX }, cmax{ -FLT_MAX };
+	for (uint32_t i = first; i < first + count; ++i)
+	{
+		min = glm::min(min, lo[ids[i]]);
+		max = glm::max(max, hi[ids[i]]);
+		cmin = glm::min(cmin, centroids[ids[i]]);
+		cmax = glm::max(cmax, centroids[ids[i]]);
+	}
+
+	int bestAxis{ -1 };
+	uint32_t bestBin{ 0 };
+	float bestCost{ FLT_MAX };
+
+	for (int axis = 0; axis < 3 && count > 1; ++axis)
+	{
+		const float extent{ cmax[axis] - cmin[axis] };
+		if (extent <= 0.f)
+			continue;
+
+		Bin bins[BVH_BINS];
+		for (Bin &b : bins)
+			b = Bin{ vec3(FLT_MAX), vec3(-FLT_MAX), 0 };
+
+		const float scale{ BVH_BINS / extent };
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			const uint32_t id{ ids[i] };
+			Bin &b{ bins[glm::min((int)((centroids[id][axis] - cmin[axis]) * scale), BVH_BINS - 1)] };
+			b.min = glm::min(b.min, lo[id]);
+			b.max = glm::max(b.max, hi[id]);
+			++b.count;
+		}
+
+		// Sweep from the left storing the prefix costs, then from the right
+		float leftCost[BVH_BINS - 1];
+		uint32_t leftCount[BVH_BINS - 1];
+		Bin run{ vec3(FLT_MAX), vec3(-FLT_MAX), 0 };
+
+		for (uint32_t i = 0; i < BVH_BINS - 1; ++i)
+		{
+			run.min = glm::min(run.min, bins[i].min);
+			run.max = glm::max(run.max, bins[i].max);
+			run.count += bins[i].count;
+			leftCount[i] = run.count;
+			leftCost[i] = run.count ? _bvh_Area(run.min, run.max) * run.count : 0.f;
+		}
+
+		run = Bin{ vec3(FLT_MAX), vec3(-FLT_MAX), 0 };
+		for (uint32_t i = BVH_BINS - 1; i > 0; --i)
+		{
+			run.min = glm::min(run.min, bins[i].min);
+			run.max = glm::max(run.max, bins[i].max);
+			run.count += bins[i].count;
+
+			if (!run.count || !leftCount[i - 1])
+				continue;
+
+			const float cost{ leftCost[i - 1] + _bvh_Area(run.min, run.max) * run.count };
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = i;
+			}
+		}
+	}
+
+	// Costs are relative to one triangle intersection
+	const float area{ _bvh_Area(min, max) };
+	const float splitCost{ BVH_TRAVERSAL_COST + (area > 0.f ? bestCost / area : 0.f) };
+	const bool fits{ count <= BVH_MAX_LEAF_SIZE || (depth >= BVH_MAX_DEPTH && count <= UINT16_MAX) };
+
+	if (fits && (bestAxis < 0 || splitCost >= (float)count || depth >= BVH_MAX_DEPTH))
+	{
+		_nodes[index] = BVHNode{ min, first, max, (uint16_t)count, 0 };
+		return index;
+	}
+
+	uint32_t mid{ first + count / 2 };
+	if (depth >= BVH_MAX_DEPTH)
+	{
+		// Halve the node so that the depth stays bounded
+		const vec3 extent{ cmax - cmin };
+		bestAxis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+		nth_element(ids.begin() + first, ids.begin() + mid, ids.begin() + first + count, [&](uint32_t a, uint32_t b) {
+			return centroids[a][bestAxis] < centroids[b][bestAxis];
+		});
+	}
+	else if (bestAxis >= 0)
+	{
+		const float scale{ BVH_BINS / (cmax[bestAxis] - cmin[bestAxis]) };
+		mid = (uint32_t)(partition(ids.begin() + first, ids.begin() + first + count, [&](uint32_t id) {
+			return (uint32_t)glm::min((int)((centroids[id][bestAxis] - cmin[bestAxis]) * scale), BVH_BINS - 1) < bestBin;
+		}) - ids.begin());
+	}
+
+	_Build(first, mid - first, ids, lo, hi, centroids, depth + 1);
+	const uint32_t right{ _Build(mid, first + count - mid, ids, lo, hi, centroids, depth + 1) };
+
+	_nodes[index] = BVHNode{ min, right, max, 0, (uint16_t)(bestAxis < 0 ? 0 : bestAxis) };
+	return index;
+}
+
+bool TriangleBVH::_IntersectTriangle(uint32_t triangle, const vec3 &origin, const vec3 &direction, float maxT, BVHHit &hit) const noexcept
+{
+	// Moller-Trumbore
+	const vec3 &v0{ _vertices[triangle * 3] };
+	const vec3 e1{ _vertices[triangle * 3 + 1] - v0 }, e2{ _vertices[triangle * 3 + 2] - v0 };
+	const vec3 p{ cross(direction, e2) };
+	const float det{ dot(e1, p) };
+
+	if (fabsf(det) < BVH_EPSILON)
+		return false;
+
+	const float invDet{ 1.f / det };
+	const vec3 s{ origin - v0 };
+	const float u{ dot(s, p) * invDet };
+	if (u < 0.f || u > 1.f)
+		return false;
+
+	const vec3 q{ cross(s, e1) };
+	const float v{ dot(direction, q) * invDet };
+	if (v < 0.f || u + v > 1.f)
+		return false;
+
+	const float t{ dot(e2, q) * invDet };
+	if (t < 0.f || t > maxT)
+		return false;
+
+	hit.t = t;
+	hit.u = u;
+	hit.v = v;
+	hit.triangle = triangle;
+
+	return true;
+}
+
+bool TriangleBVH::ClosestHit(const vec3 &origin, const vec3 &direction, float maxT, BVHHit &hit) const noexcept
+{
+	if (_triangleIds.empty())
+		return false;
+
+	const vec3 invDir{ 1.f / direction.x, 1.f / direction.y, 1.f / direction.z };
+	uint32_t stack[BVH_STACK_SIZE];
+	uint32_t top{ 0 };
+	bool found{ false };
+
+	stack[top++] = 0;
+
+	while (top)
+	{
+		const uint32_t index{ stack[--top] };
+		const BVHNode &node{ _nodes[index] };
+
+		if (!_bvh_RayBox(origin, invDir, node, maxT))
+			continue;
+
+		if (node.count)
+		{
+			for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+			{
+				if (_IntersectTriangle(i, origin, direction, maxT, hit))
+				{
+					maxT = hit.t;
+					found = true;
+				}
+			}
+
+			continue;
+		}
+
+		// Push the far child first so the near one is visited next
+		const bool reverse{ direction[node.axis] < 0.f };
+		stack[top++] = reverse ? index + 1 : node.offset;
+		stack[top++] = reverse ? node.offset : index + 1;
+	}
+
+	if (!found)
+		return false;
+
+	const vec3 &v0{ _vertices[hit.triangle * 3] };
+	hit.normal = normalize(cross(_vertices[hit.triangle * 3 + 1] - v0, _vertices[hit.triangle * 3 + 2] - v0));
+	hit.triangle = _triangleIds[hit.triangle];
+
+	return true;
+}
+
+bool TriangleBVH::AnyHit(const vec3 &origin, const vec3 &direction, float maxT) const noexcept
+{
+	if (_triangleIds.empty())
+		return false;
+
+	const vec3 invDir{ 1.f / direction.x, 1.f / direction.y, 1.f / direction.z };
+	uint32_t stack[BVH_STACK_SIZE];
+	uint32_t top{ 0 };
+	BVHHit hit{};
+
+	stack[top++] = 0;
+
+	while (top)
+	{
+		const uint32_t index{ stack[--top] };
+		const BVHNode &node{ _nodes[index] };
+
+		if (!_bvh_RayBox(origin, invDir, node, maxT))
+			continue;
+
+		if (node.count)
+		{
+			for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+				if (_IntersectTriangle(i, origin, direction, maxT, hit))
+					return true;
+
+			continue;
+		}
+
+		stack[top++] = node.offset;
+		stack[top++] = index + 1;
+	}
+
+	return false;
+}
+
+uint32_t TriangleBVH::ClosestHit(const BVHRayPacket &packet, BVHHit *hits) const noexcept
+{
+	const uint32_t count{ glm::min(packet.count, (uint32_t)BVH_PACKET_SIZE) };
+	if (_triangleIds.empty() || !count)
+		return 0;
+
+	vec3 invDir[BVH_PACKET_SIZE];
+	float maxT[BVH_PACKET_SIZE];
+	uint32_t stack[BVH_STACK_SIZE];
+	uint32_t top{ 0 }, mask{ 0 };
+
+	for (uint32_t r = 0; r < count; ++r)
+	{
+		invDir[r] = 1.f / packet.direction[r];
+		maxT[r] = packet.maxT[r];
+	}
+
+	stack[top++] = 0;
+
+	while (top)
+	{
+		const uint32_t index{ stack[--top] };
+		const BVHNode &node{ _nodes[index] };
+
+		uint32_t active{ 0 };
+		for (uint32_t r = 0; r < count; ++r)
+			if (_bvh_RayBox(packet.origin[r], invDir[r], node, maxT[r]))
+				active |= 1 << r;
+
+		if (!active)
+			continue;
+
+		if (node.count)
+		{
+			for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+			{
+				for (uint32_t r = 0; r < count; ++r)
+				{
+					if (!(active & (1 << r)) || !_IntersectTriangle(i, packet.origin[r], packet.direction[r], maxT[r], hits[r]))
+						continue;
+
+					maxT[r] = hits[r].t;
+					mask |= 1 << r;
+				}
+			}
+
+			continue;
+		}
+
+		// Order by the first active ray; the packet is assumed coherent
+		uint32_t first{ 0 };
+		while (!(active & (1 << first))) ++first;
+
+		const bool reverse{ packet.direction[first][node.axis] < 0.f };
+		stack[top++] = reverse ? index + 1 : node.offset;
+		stack[top++] = reverse ? node.offset : index + 1;
+	}
+
+	for (uint32_t r = 0; r < count; ++r)
+	{
+		if (!(mask & (1 << r)))
+			continue;
+
+		const vec3 &v0{ _vertices[hits[r].triangle * 3] };
+		hits[r].normal = normalize(cross(_vertices[hits[r].triangle * 3 + 1] - v0, _vertices[hits[r].triangle * 3 + 2] - v0));
+		hits[r].triangle = _triangleIds[hits[r].triangle];
+	}
+
+	return mask;
+}
+
+uint32_t TriangleBVH::Overlap(const vec3 &min, const vec3 &max, vector<uint32_t> &triangles) const
+{
+	if (_triangleIds.empty())
+		return 0;
+
+	const vec3 center{ (min + max) * .5f }, half{ (max - min) * .5f };
+	const size_t start{ triangles.size() };
+	uint32_t stack[BVH_STACK_SIZE];
+	uint32_t top{ 0 };
+
+	stack[top++] = 0;
+
+	while (top)
+	{
+		const uint32_t index{ stack[--top] };
+		const BVHNode &node{ _nodes[index] };
+
+		if (!_bvh_BoxBox(node, min, max))
+			continue;
+
+		if (node.count)
+		{
+			for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+				if (_bvh_TriangleBox(center, half, &_vertices[i * 3]))
+					triangles.push_back(_triangleIds[i]);
+
+			continue;
+		}
+
+		stack[top++] = node.offset;
+		stack[top++] = index + 1;
+	}
+
+	return (uint32_t)(triangles.size() - start);
+}
+
+uint32_t TriangleBVH::Overlap(const vec3 &center, float radius, vector<uint32_t> &triangles) const
+{
+	if (_triangleIds.empty())
+		return 0;
+
+	const vec3 min{ center - radius }, max{ center + radius };
+	const float radius2{ radius * radius };
+	const size_t start{ triangles.size() };
+	uint32_t stack[BVH_STACK_SIZE];
+	uint32_t top{ 0 };
+
+	stack[top++] = 0;
+
+	while (top)
+	{
+		const uint32_t index{ stack[--top] };
+		const BVHNode &node{ _nodes[index] };
+
+		if (!_bvh_BoxBox(node, min, max))
+			continue;
+
+		if (node.count)
+		{
+			for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+			{
+				const vec3 d{ _bvh_ClosestPtTriangle(center, _vertices[i * 3], _vertices[i * 3 + 1], _vertices[i * 3 + 2]) - center };
+				if (dot(d, d) <= radius2)
+					triangles.push_back(_triangleIds[i]);
+			}
+
+			continue;
+		}
+
+		stack[top++] = node.offset;
+		stack[top++] = index + 1;
+	}
+
+	return (uint32_t)(triangles.size() - start);
+}
+
+int TriangleBVH::Save(VFSFile *file) const
+{
+	const uint32_t nodeCount{ (uint32_t)_nodes.size() }, triangleCount{ (uint32_t)_triangleIds.size() };
+	uint64_t hash{ _sourceHash };
+
+	if (file->Write((void *)BVH_HEADER, sizeof(char), 7) != 7 ||
+		file->Write(&hash, sizeof(uint64_t), 1) != 1 ||
+		file->Write((void *)&nodeCount, sizeof(uint32_t), 1) != 1 ||
+		file->Write((void *)&triangleCount, sizeof(uint32_t), 1) != 1 ||
+		file->Write((void *)_nodes.data(), sizeof(BVHNode), nodeCount) != nodeCount ||
+		file->Write((void *)_triangleIds.data(), sizeof(uint32_t), triangleCount) != triangleCount ||
+		file->Write((void *)_vertices.data(), sizeof(vec3), triangleCount * 3) != triangleCount * 3)
+	{
+		Logger::Log(BVH_MODULE, LOG_CRITICAL, "Failed to write %s", file->GetHeader().name);
+		return ENGINE_IO_FAIL;
+	}
+
+	return ENGINE_OK;
+}
+
+int TriangleBVH::Load(VFSFile *file, uint64_t sourceHash)
+{
+	char idBuff[8]{ 0x0 };
+	uint64_t hash{ 0 };
+	uint32_t nodeCount{ 0 }, triangleCount{ 0 };
+
+	if (file->Read(idBuff, sizeof(char), 7) != 7 || strncmp(idBuff, BVH_HEADER, 7))
+		return ENGINE_INVALID_HEADER;
+
+	if (file->Read(&hash, sizeof(uint64_t), 1) != 1 || hash != sourceHash)
+		return ENGINE_INVALID_HEADER;
+
+	if (file->Read(&nodeCount, sizeof(uint32_t), 1) != 1 || file->Read(&triangleCount, sizeof(uint32_t), 1) != 1 ||
+		!nodeCount || nodeCount > triangleCount * 2 + 1)
+		return ENGINE_INVALID_HEADER;
+
+	_nodes.resize(nodeCount);
+	_triangleIds.resize(triangleCount);
+	_vertices.resize(triangleCount * 3);
+
+	if (file->Read(_nodes.data(), sizeof(BVHNode), nodeCount) != nodeCount ||
+		file->Read(_triangleIds.data(), sizeof(uint32_t), triangleCount) != triangleCount ||
+		file->Read(_vertices.data(), sizeof(vec3), triangleCount * 3) != triangleCount * 3)
+	{
+		_nodes.clear();
+		_triangleIds.clear();
+		_vertices.clear();
+		return ENGINE_IO_FAIL;
+	}
+
+	if (!_Validate())
+	{
+		_nodes.clear();
+		_triangleIds.clear();
+		_vertices.clear();
+		return ENGINE_INVALID_RES;
+	}
+
+	_sourceHash = hash;
+
+	return ENGINE_OK;
+}
+
+bool TriangleBVH::_Validate() const
+{
+	// Children always follow their parent, so one forward pass sees every
+	// parent before its children
+	vector<uint8_t> depth(_nodes.size(), 0);
+	const uint32_t nodeCount{ (uint32_t)_nodes.size() };
+
+	// An empty mesh is stored as a single empty leaf
+	if (_triangleIds.empty())
+		return nodeCount == 1;
+
+	for (uint32_t i = 0; i < nodeCount; ++i)
+	{
+		const BVHNode &node{ _nodes[i] };
+
+		if (node.count)
+		{
+			if ((uint64_t)node.offset + node.count > _triangleIds.size())
+				return false;
+
+			continue;
+		}
+
+		if (node.offset <= i + 1 || node.offset >= nodeCount || depth[i] + 2 > BVH_STACK_SIZE || node.axis > 2)
+			return false;
+
+		depth[i + 1] = depth[node.offset] = depth[i] + 1;
+	}
+
+	return true;
+}
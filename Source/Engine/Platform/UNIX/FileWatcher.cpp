@@ -0,0 +1,367 @@
+/* NekoEngine
+ *
+ * FileWatcher.cpp
+ * Author: Alexandru Naiman
+ *
+ * UNIX directory change notification
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Platform/FileWatcher.h>
+#include <Platform/PlatformDetect.h>
+#include <System/Logger.h>
+
+#if defined(NE_PLATFORM_LINUX)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <dirent.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#include <stack>
+#include <unordered_map>
+
+#define UNIX_FW_MODULE		"UNIX_FileWatcher"
+#define UNIX_FW_BUFF_SIZE	(64 * (sizeof(struct inotify_event) + NAME_MAX + 1))
+#define UNIX_FW_DIR_MASK	(IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE_SELF)
+
+using namespace std;
+
+static int _fd{ -1 };
+static string _root{};
+static unordered_map<int, string> _directories{};
+
+/**
+ * Watch a directory and the directories below it. The prefix is the
+ * directory's path relative to the root. Files already in the tree are
+ * appended to files, if not null.
+ */
+static bool _fw_AddTree(const string &prefix, vector<string> *files)
+{
+	stack<string> directories{};
+	directories.push(prefix);
+
+	// Recursion is evil
+	while (!directories.empty())
+	{
+		const string dirPrefix{ directories.top() };
+		directories.pop();
+
+		const string path{ _root + dirPrefix };
+		const int wd{ inotify_add_watch(_fd, path.c_str(), UNIX_FW_DIR_MASK) };
+		if (wd < 0)
+		{
+			Logger::Log(UNIX_FW_MODULE, LOG_WARNING, "Failed to watch %s, errno: %d", path.c_str(), errno);
+			if (errno == ENOSPC)
+				return false;
+			continue;
+		}
+
+		_directories[wd] = dirPrefix;
+
+		DIR *dir{ opendir(path.c_str()) };
+		if (!dir)
+			continue;
+
+		struct dirent *ent{ nullptr };
+		struct stat st{};
+
+		while ((ent = readdir(dir)) != NULL)
+		{
+			if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
+				continue;
+
+			const string child{ dirPrefix + "/" + ent->d_name };
+			if (stat((_root + child).c_str(), &st) < 0)
+				continue;
+
+			if (S_ISDIR(st.st_mode))
+				directories.push(child);
+			else if (files && S_ISREG(st.st_mode))
+				files->push_back(child);
+		}
+
+		closedir(dir);
+	}
+
+	return true;
+}
+
+int FileWatcher::Initialize(const char *directory)
+{
+	if (_fd >= 0)
+		return ENGINE_OK;
+
+	if ((_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0)
+	{
+		Logger::Log(UNIX_FW_MODULE, LOG_CRITICAL, "inotify_init1() failed, errno: %d", errno);
+		return ENGINE_FAIL;
+	}
+
+	_root = directory;
+	while (_root.length() > 1 && _root.back() == '/')
+		_root.pop_back();
+
+	if (!_fw_AddTree("", nullptr))
+	{
+		Logger::Log(UNIX_FW_MODULE, LOG_CRITICAL, "Watch limit reached; raise fs.inotify.max_user_watches");
+		Release();
+		return ENGINE_FAIL;
+	}
+
+	Logger::Log(UNIX_FW_MODULE, LOG_INFORMATION, "Watching %s (%d directories)", _root.c_str(), (int)_directories.size());
+
+	return ENGINE_OK;
+}
+
+void FileWatcher::Poll(vector<string> &paths)
+{
+	if (_fd < 0)
+		return;
+
+	alignas(struct inotify_event) char buff[UNIX_FW_BUFF_SIZE];
+
+	for (;;)
+	{
+		const ssize_t len{ read(_fd, buff, sizeof(buff)) };
+		if (len <= 0)
+		{
+			if (len < 0 && errno != EAGAIN && errno != EINTR)
+				Logger::Log(UNIX_FW_MODULE, LOG_WARNING, "read() failed, errno: %d", errno);
+			return;
+		}
+
+		for (char *ptr = buff; ptr < buff + len; )
+		{
+			const struct inotify_event *evt{ (const struct inotify_event *)ptr };
+			ptr += sizeof(struct inotify_event) + evt->len;
+
+			if (evt->mask & IN_Q_OVERFLOW)
+			{
+				Logger::Log(UNIX_FW_MODULE, LOG_WARNING, "Event queue overflow, changes were lost");
+				continue;
+			}
+
+			auto it = _directories.find(evt->wd);
+			if (it == _directories.end())
+				continue;
+
+			if (evt->mask & (IN_IGNORED | IN_DELETE_SELF))
+			{
+				if (evt->mask & IN_IGNORED)
+					_directories.erase(it);
+				continue;
+			}
+
+			if (!evt->len)
+				continue;
+
+			string path{ it->second + "/" + evt->name };
+
+			if (evt->mask & IN_ISDIR)
+			{
+				// Files written before the watch was added have no events
+				if (evt->mask & (IN_CREATE | IN_MOVED_TO))
+					_fw_AddTree(path, &paths);
+				continue;
+			}
+
+			// New files are reported when closed after writing
+			if (evt->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+				paths.push_back(move(path));
+		}
+	}
+}
+
+bool FileWatcher::IsActive() noexcept
+{
+	return _fd >= 0;
+}
+
+void FileWatcher::Release()
+{
+	if (_fd < 0)
+		return;
+
+	close(_fd);
+
+	_fd = -1;
+	_directories.clear();
+}
+
+#else
+
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <stack>
+#include <chrono>
+#include <unordered_map>
+
+#define UNIX_FW_MODULE		"UNIX_FileWatcher"
+#define UNIX_FW_SCAN_INTERVAL	1000
+
+using namespace std;
+using namespace std::chrono;
+
+/**
+ * Without inotify the tree is scanned periodically and files whose
+ * modification time or size changed are reported.
+ */
+struct FileStamp
+{
+	time_t mtime;
+	off_t size;
+
+	bool operator ==(const FileStamp &other) const noexcept { return mtime == other.mtime && size == other.size; }
+	bool operator !=(const FileStamp &other) const noexcept { return !(*this == other); }
+};
+
+static bool _active{ false };
+static string _root{};
+static unordered_map<string, FileStamp> _files{};
+static steady_clock::time_point _nextScan{};
+
+/**
+ * Rebuild the file table. Files that are new or differ from the previous
+ * scan are appended to changed, if not null.
+ */
+static void _fw_Scan(vector<string> *changed)
+{
+	unordered_map<string, FileStamp> files{};
+	files.reserve(_files.size());
+
+	stack<string> directories{};
+	directories.push("");
+
+	while (!directories.empty())
+	{
+		const string dirPrefix{ directories.top() };
+		directories.pop();
+
+		DIR *dir{ opendir((_root + dirPrefix).c_str()) };
+		if (!dir)
+			continue;
+
+		struct dirent *ent{ nullptr };
+		struct stat st{};
+
+		while ((ent = readdir(dir)) != NULL)
+		{
+			if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
+				continue;
+
+			string child{ dirPrefix + "/" + ent->d_name };
+			if (stat((_root + child).c_str(), &st) < 0)
+				continue;
+
+			if (S_ISDIR(st.st_mode))
+			{
+				directories.push(move(child));
+				continue;
+			}
+			else if (!S_ISREG(st.st_mode))
+				continue;
+
+			const FileStamp stamp{ st.st_mtime, st.st_size };
+
+			auto it = _files.find(child);
+			if (changed && (it == _files.end() || it->second != stamp))
+				changed->push_back(child);
+
+			files.emplace(move(child), stamp);
+		}
+
+		closedir(dir);
+	}
+
+	_files.swap(files);
+}
+
+int FileWatcher::Initialize(const char *directory)
+{
+	if (_active)
+		return ENGINE_OK;
+
+	_root = directory;
+	while (_root.length() > 1 && _root.back() == '/')
+		_root.pop_back();
+
+	struct stat st{};
+	if (stat(_root.c_str(), &st) < 0 || !S_ISDIR(st.st_mode))
+	{
+		Logger::Log(UNIX_FW_MODULE, LOG_CRITICAL, "%s is not a directory", _root.c_str());
+		return ENGINE_FAIL;
+	}
+
+	_fw_Scan(nullptr);
+	_nextScan = steady_clock::now() + milliseconds(UNIX_FW_SCAN_INTERVAL);
+	_active = true;
+
+	Logger::Log(UNIX_FW_MODULE, LOG_INFORMATION, "Watching %s by scanning every %d ms (%d files)",
+		_root.c_str(), UNIX_FW_SCAN_INTERVAL, (int)_files.size());
+
+	return ENGINE_OK;
+}
+
+void FileWatcher::Poll(vector<string> &paths)
+{
+	if (!_active)
+		return;
+
+	const steady_clock::time_point now{ steady_clock::now() };
+	if (now < _nextScan)
+		return;
+
+	_fw_Scan(&paths);
+	_nextScan = now + milliseconds(UNIX_FW_SCAN_INTERVAL);
+}
+
+bool FileWatcher::IsActive() noexcept
+{
+	return _active;
+}
+
+void FileWatcher::Release()
+{
+	_active = false;
+	_files.clear();
+}
+
+#endif
@@ -0,0 +1,169 @@
+/* NekoEngine
+ *
+ * FileWatcher.cpp
+ * Author: Alexandru Naiman
+ *
+ * Windows directory change notification
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Platform/FileWatcher.h>
+#include <System/Logger.h>
+
+#include <Windows.h>
+
+#include <algorithm>
+
+#define WIN32_FW_MODULE		"Win32_FileWatcher"
+#define WIN32_FW_BUFF_SIZE	(64 * 1024)
+#define WIN32_FW_FILTER		(FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE)
+
+using namespace std;
+
+static HANDLE _dir{ INVALID_HANDLE_VALUE };
+static OVERLAPPED _overlapped{};
+static string _root{};
+
+// ReadDirectoryChangesW requires a DWORD aligned buffer
+static DWORD _buff[WIN32_FW_BUFF_SIZE / sizeof(DWORD)];
+
+static bool _fw_Read()
+{
+	return ReadDirectoryChangesW(_dir, _buff, sizeof(_buff), TRUE, WIN32_FW_FILTER, nullptr, &_overlapped, nullptr) != FALSE;
+}
+
+int FileWatcher::Initialize(const char *directory)
+{
+	if (_dir != INVALID_HANDLE_VALUE)
+		return ENGINE_OK;
+
+	_root = directory;
+	while (_root.length() > 1 && (_root.back() == '/' || _root.back() == '\\'))
+		_root.pop_back();
+
+	_dir = CreateFileA(_root.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (_dir == INVALID_HANDLE_VALUE)
+	{
+		Logger::Log(WIN32_FW_MODULE, LOG_CRITICAL, "Failed to open %s, error: %d", _root.c_str(), (int)GetLastError());
+		return ENGINE_FAIL;
+	}
+
+	_overlapped = {};
+	if ((_overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr)) == NULL || !_fw_Read())
+	{
+		Logger::Log(WIN32_FW_MODULE, LOG_CRITICAL, "ReadDirectoryChangesW() failed, error: %d", (int)GetLastError());
+		Release();
+		return ENGINE_FAIL;
+	}
+
+	Logger::Log(WIN32_FW_MODULE, LOG_INFORMATION, "Watching %s", _root.c_str());
+
+	return ENGINE_OK;
+}
+
+void FileWatcher::Poll(vector<string> &paths)
+{
+	if (_dir == INVALID_HANDLE_VALUE)
+		return;
+
+	DWORD bytes{ 0 };
+	if (!GetOverlappedResult(_dir, &_overlapped, &bytes, FALSE))
+	{
+		if (GetLastError() == ERROR_IO_INCOMPLETE)
+			return;
+
+		Logger::Log(WIN32_FW_MODULE, LOG_WARNING, "GetOverlappedResult() failed, error: %d", (int)GetLastError());
+		bytes = 0;
+	}
+	else if (!bytes)
+	{
+		Logger::Log(WIN32_FW_MODULE, LOG_WARNING, "Change buffer overflow, changes were lost");
+	}
+
+	for (const uint8_t *ptr = (const uint8_t *)_buff; bytes; )
+	{
+		const FILE_NOTIFY_INFORMATION *info{ (const FILE_NOTIFY_INFORMATION *)ptr };
+
+		if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+		{
+			char name[MAX_PATH * 3];
+			const int len{ WideCharToMultiByte(CP_UTF8, 0, info->FileName, (int)(info->FileNameLength / sizeof(WCHAR)),
+				name, sizeof(name), nullptr, nullptr) };
+
+			if (len > 0)
+			{
+				string path{ "/" };
+				path.append(name, len);
+				replace(path.begin(), path.end(), '\\', '/');
+
+				// Directories are reported too; the files inside them have their own entries
+				const DWORD attributes{ GetFileAttributesA((_root + path).c_str()) };
+				if (attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY))
+					paths.push_back(move(path));
+			}
+		}
+
+		if (!info->NextEntryOffset)
+			break;
+
+		ptr += info->NextEntryOffset;
+	}
+
+	ResetEvent(_overlapped.hEvent);
+	if (!_fw_Read())
+	{
+		Logger::Log(WIN32_FW_MODULE, LOG_CRITICAL, "ReadDirectoryChangesW() failed, error: %d", (int)GetLastError());
+		Release();
+	}
+}
+
+bool FileWatcher::IsActive() noexcept
+{
+	return _dir != INVALID_HANDLE_VALUE;
+}
+
+void FileWatcher::Release()
+{
+	if (_dir != INVALID_HANDLE_VALUE)
+	{
+		CancelIo(_dir);
+		CloseHandle(_dir);
+		_dir = INVALID_HANDLE_VALUE;
+	}
+
+	if (_overlapped.hEvent)
+		CloseHandle(_overlapped.hEvent);
+
+	_overlapped = {};
+}
@@ -37,6 +37,7 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <string>
 #include <vector>
 
 #include <Engine/Engine.h>
@@ -62,7 +63,16 @@ struct ProfilerRegion
 	vector<ProfilerMarker> markers;
 };
 
+struct ProfilerCounter
+{
+	string name;
+	double value;
+	const char *unit;
+	vec3 color;
+};
+
 static vector<ProfilerRegion> _regions{};
+static vector<ProfilerCounter> _counters{};
 static ProfilerRegion *_activeRegion{ nullptr };
 
 void Profiler::BeginRegion(const char *name, vec3 color)
@@ -92,6 +102,21 @@ void Profiler::EndRegion()
 	_activeRegion = nullptr;
 }
 
+void Profiler::InsertCounter(const char *name, double value, const char *unit, vec3 color)
+{
+	// Draw only runs while the stats are visible; keep one entry per name
+	for (ProfilerCounter &counter : _counters)
+	{
+		if (counter.name != name)
+			continue;
+
+		counter.value = value;
+		return;
+	}
+
+	_counters.push_back({ name, value, unit, color });
+}
+
 void Profiler::Draw()
 {
 	float y{ 0.f };
@@ -115,5 +140,12 @@ void Profiler::Draw()
 		}
 	}
 
+	for (ProfilerCounter &counter : _counters)
+	{
+		GUIManager::DrawString(vec2(400.f, y), counter.color, "%s %f %s", counter.name.c_str(), counter.value, counter.unit);
+		y += yIncrement;
+	}
+
 	_regions.clear();
+	_counters.clear();
 }
@@ -47,16 +47,20 @@ Buffer::Buffer()
 {
 	_buffer = VK_NULL_HANDLE;
 	_memory = VK_NULL_HANDLE;
-	_offset = _size = 0;
-	_child = _persistent = _ownMemory = false;
+	_offset = _size = _memoryOffset = 0;
+	memset(&_allocation, 0x0, sizeof(_allocation));
+	_mapped = nullptr;
+	_child = _persistent = false;
 }
 
 Buffer::Buffer(size_t size, VkBufferUsageFlags usage, uint8_t *data, VkMemoryPropertyFlags properties)
 {
 	_buffer = VK_NULL_HANDLE;
 	_memory = VK_NULL_HANDLE;
-	_offset = _size = 0;
-	_child = _persistent = _ownMemory = false;
+	_offset = _size = _memoryOffset = 0;
+	memset(&_allocation, 0x0, sizeof(_allocation));
+	_mapped = nullptr;
+	_child = _persistent = false;
 
 	_CreateBuffer(size, usage, data, VK_NULL_HANDLE, 0, properties);
 }
@@ -65,8 +69,10 @@ Buffer::Buffer(size_t size, VkBufferUsageFlags usage, uint8_t *data, VkDeviceMem
 {
 	_buffer = VK_NULL_HANDLE;
 	_memory = VK_NULL_HANDLE;
-	_offset = _size = 0;
-	_child = _persistent = _ownMemory = false;
+	_offset = _size = _memoryOffset = 0;
+	memset(&_allocation, 0x0, sizeof(_allocation));
+	_mapped = nullptr;
+	_child = _persistent = false;
 
 	_CreateBuffer(size, usage, data, memory, offset, properties);
 }
@@ -77,40 +83,49 @@ Buffer::Buffer(Buffer *parent, VkDeviceSize offset, VkDeviceSize size)
 	_memory = parent->GetMemoryHandle();
 	_offset = offset;
 	_size = size;
+	_memoryOffset = parent->_memoryOffset;
+	memset(&_allocation, 0x0, sizeof(_allocation));
+	_mapped = parent->_mapped;
 	_child = true;
 	_persistent = false;
-	_ownMemory = false;
 }
 
 void Buffer::UpdateData(uint8_t *data, VkDeviceSize offset, VkDeviceSize size, VkCommandBuffer cmdBuffer, bool useStagingBuffer)
 {
-	bool submit{ false };
-
-	if (cmdBuffer == VK_NULL_HANDLE)
+	if (size < 65535 && !useStagingBuffer)
 	{
-		submit = true;
+		if (cmdBuffer != VK_NULL_HANDLE)
+		{
+			vkCmdUpdateBuffer(cmdBuffer, _buffer, _offset + offset, size, data);
+			return;
+		}
+
 		cmdBuffer = VKUtil::CreateOneShotCmdBuffer();
+		vkCmdUpdateBuffer(cmdBuffer, _buffer, _offset + offset, size, data);
+		VKUtil::ExecuteOneShotCmdBuffer(cmdBuffer);
+
+		return;
 	}
 
-	if (size < 65535 && !useStagingBuffer)
-		vkCmdUpdateBuffer(cmdBuffer, _buffer, _offset + offset, size, data);
-	else
+	// Batched into the frame; whatever exceeds the frame's staging budget goes out with the next frames
+	if (cmdBuffer != VK_NULL_HANDLE)
 	{
-		Buffer *stagingBuffer{ Renderer::GetInstance()->GetStagingBuffer(size) };
+		Renderer::GetInstance()->UploadBuffer(this, offset, data, size, cmdBuffer);
+		return;
+	}
 
-		uint8_t *ptr{ stagingBuffer->Map(0, size) };
-		if (!ptr)
-		{ DIE("Failed to map buffer"); }
+	Buffer *stagingBuffer{ Renderer::GetInstance()->GetStagingBuffer(size) };
 
-		memcpy(ptr, data, size);
-		stagingBuffer->Unmap();
+	uint8_t *ptr{ stagingBuffer->Map(0, size) };
+	if (!ptr)
+	{ DIE("Failed to map buffer"); }
 
-		VKUtil::CopyBuffer(stagingBuffer->GetHandle(), _buffer, size, 0, _offset + offset);
+	memcpy(ptr, data, size);
+	stagingBuffer->Unmap();
 
-		Renderer::GetInstance()->FreeStagingBuffer(stagingBuffer);
-	}
+	VKUtil::CopyBuffer(stagingBuffer->GetHandle(), _buffer, size, stagingBuffer->GetParentOffset(), _offset + offset);
 
-	if (submit) VKUtil::ExecuteOneShotCmdBuffer(cmdBuffer);
+	Renderer::GetInstance()->FreeStagingBuffer(stagingBuffer);
 }
 
 void Buffer::Copy(Buffer *dst, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkCommandBuffer cmdBuffer)
@@ -125,10 +140,13 @@ void Buffer::Fill(uint32_t value, VkCommandBuffer buffer)
 
 uint8_t *Buffer::Map(VkDeviceSize offset, VkDeviceSize size)
 {
+	if (_mapped)
+		return _mapped + _offset + offset;
+
 	if (!size) size = _size;
 
 	uint8_t *ptr{ nullptr };
-	if (vkMapMemory(VKUtil::GetDevice(), _memory, _offset + offset, size, 0, (void **)&ptr) != VK_SUCCESS)
+	if (vkMapMemory(VKUtil::GetDevice(), _memory, _memoryOffset + _offset + offset, size, 0, (void **)&ptr) != VK_SUCCESS)
 		return nullptr;
 
 	return ptr;
@@ -136,6 +154,10 @@ uint8_t *Buffer::Map(VkDeviceSize offset, VkDeviceSize size)
 
 void Buffer::Unmap()
 {
+	// Host visible allocator memory stays mapped for the lifetime of its block
+	if (_mapped)
+		return;
+
 	vkUnmapMemory(VKUtil::GetDevice(), _memory);
 }
 
@@ -146,11 +168,29 @@ void Buffer::_CreateBuffer(size_t size, VkBufferUsageFlags usage, uint8_t *data,
 	_offset = offset;
 	_size = size;
 
-	if (_memory == VK_NULL_HANDLE)
-		_ownMemory = true;
+	if (_memory != VK_NULL_HANDLE)
+	{
+		if (!VKUtil::CreateBuffer(_buffer, _memory, _size, usage, properties, offset))
+		{ DIE("Failed to create buffer"); }
+	}
+	else
+	{
+		if (!VKUtil::CreateUnboundBuffer(_buffer, _size, usage))
+		{ DIE("Failed to create buffer"); }
+
+		VkMemoryRequirements memReq;
+		vkGetBufferMemoryRequirements(VKUtil::GetDevice(), _buffer, &memReq);
+
+		if (!Renderer::GetInstance()->GetMemoryAllocator()->Allocate(memReq, properties, MemoryResourceType::Linear, _allocation, this))
+		{ DIE("Failed to allocate buffer memory"); }
+
+		_memory = _allocation.memory;
+		_memoryOffset = _allocation.offset;
+		_mapped = _allocation.mapped;
 
-	if (!VKUtil::CreateBuffer(_buffer, _memory, _size, usage, properties, offset))
-	{ DIE("Failed to create buffer"); }
+		if (vkBindBufferMemory(VKUtil::GetDevice(), _buffer, _memory, _memoryOffset) != VK_SUCCESS)
+		{ DIE("Failed to bind buffer memory"); }
+	}
 
 	if (data)
 	{
@@ -163,7 +203,7 @@ void Buffer::_CreateBuffer(size_t size, VkBufferUsageFlags usage, uint8_t *data,
 		memcpy(ptr, data, size);
 		stagingBuffer->Unmap();
 
-		VKUtil::CopyBuffer(stagingBuffer->GetHandle(), _buffer, size, 0, _offset + offset);
+		VKUtil::CopyBuffer(stagingBuffer->GetHandle(), _buffer, size, stagingBuffer->GetParentOffset(), _offset + offset);
 
 		Renderer::GetInstance()->FreeStagingBuffer(stagingBuffer);
 	}
@@ -171,11 +211,12 @@ void Buffer::_CreateBuffer(size_t size, VkBufferUsageFlags usage, uint8_t *data,
 
 Buffer::~Buffer()
 {
+	Renderer::GetInstance()->CancelUploads(this);
+
 	if (_child)
 		return;
 
-	if(_ownMemory)
-		vkFreeMemory(VKUtil::GetDevice(), _memory, VKUtil::GetAllocator());
-
 	vkDestroyBuffer(VKUtil::GetDevice(), _buffer, VKUtil::GetAllocator());
+
+	Renderer::GetInstance()->GetMemoryAllocator()->Free(_allocation);
 }
\ No newline at end of file
@@ -0,0 +1,144 @@
+/* NekoEngine
+ *
+ * DistanceField.cpp
+ * Author: Alexandru Naiman
+ *
+ * Signed distance field generator
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <algorithm>
+
+#include <Renderer/DistanceField.h>
+
+#define DF_INF		1e20f
+
+using namespace std;
+
+/*
+ * Exact euclidean distance transform (Felzenszwalb & Huttenlocher) run on both
+ * sides of the edge. Antialiased pixels seed the transform with their distance
+ * to the edge estimated from coverage, which keeps sub-pixel precision.
+ */
+void DistanceField::Generate(const uint8_t *coverage, int width, int height, int pitch, int spread, vector<uint8_t> &field)
+{
+	int fieldWidth{ width + 2 * spread }, fieldHeight{ height + 2 * spread };
+	size_t size{ (size_t)fieldWidth * fieldHeight };
+
+	vector<float> outer(size, DF_INF);
+	vector<float> inner(size, 0.f);
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			float a{ coverage[y * pitch + x] / 255.f };
+			size_t i{ (size_t)(y + spread) * fieldWidth + x + spread };
+
+			if (a >= 1.f)
+			{
+				outer[i] = 0.f;
+				inner[i] = DF_INF;
+			}
+			else if (a > 0.f)
+			{
+				float d{ .5f - a };
+				outer[i] = d > 0.f ? d * d : 0.f;
+				inner[i] = d < 0.f ? d * d : 0.f;
+			}
+		}
+	}
+
+	_Transform(outer, fieldWidth, fieldHeight);
+	_Transform(inner, fieldWidth, fieldHeight);
+
+	field.resize(size);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		float distance{ sqrtf(outer[i]) - sqrtf(inner[i]) };
+		float value{ 255.f * (.5f - distance / (2.f * spread)) };
+		field[i] = (uint8_t)std::min(std::max(roundf(value), 0.f), 255.f);
+	}
+}
+
+void DistanceField::_Transform(vector<float> &grid, int width, int height)
+{
+	for (int x = 0; x < width; ++x)
+		_Transform1D(grid.data(), x, width, height);
+
+	for (int y = 0; y < height; ++y)
+		_Transform1D(grid.data(), y * width, 1, width);
+}
+
+void DistanceField::_Transform1D(float *grid, int offset, int stride, int length)
+{
+	vector<float> f(length), z(length + 1);
+	vector<int> v(length);
+	int k{ 0 };
+
+	for (int q = 0; q < length; ++q)
+		f[q] = grid[offset + q * stride];
+
+	v[0] = 0;
+	z[0] = -DF_INF;
+	z[1] = DF_INF;
+
+	// Lower envelope of the parabolas rooted at each sample
+	for (int q = 1; q < length; ++q)
+	{
+		float s;
+
+		do
+		{
+			int r{ v[k] };
+			s = (f[q] - f[r] + (float)q * q - (float)r * r) / (2.f * (q - r));
+		} while (s <= z[k] && --k >= 0);
+
+		++k;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = DF_INF;
+	}
+
+	k = 0;
+	for (int q = 0; q < length; ++q)
+	{
+		while (z[k + 1] < q)
+			++k;
+
+		float d{ (float)(q - v[k]) };
+		grid[offset + q * stride] = d * d + f[v[k]];
+	}
+}
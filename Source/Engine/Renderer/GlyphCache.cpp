@@ -0,0 +1,336 @@
+/* NekoEngine
+ *
+ * GlyphCache.cpp
+ * Author: Alexandru Naiman
+ *
+ * Glyph atlas packing and text layout
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <algorithm>
+
+#include <Renderer/GlyphCache.h>
+
+using namespace std;
+using namespace glm;
+
+static inline uint64_t _gc_GlyphKey(uint32_t codepoint, int pixelSize) { return ((uint64_t)pixelSize << 32) | codepoint; }
+static inline uint64_t _gc_KerningKey(uint32_t left, uint32_t right, int pixelSize) { return (uint64_t)left | ((uint64_t)right << 21) | ((uint64_t)pixelSize << 42); }
+
+SkylinePacker::SkylinePacker(uint32_t width, uint32_t height) :
+	_width(width), _height(height)
+{
+	Reset();
+}
+
+bool SkylinePacker::Pack(uint32_t width, uint32_t height, uvec2 &position)
+{
+	size_t bestIndex{ SIZE_MAX };
+	uint32_t bestTop{ UINT32_MAX }, bestWidth{ UINT32_MAX }, y{ 0 };
+
+	for (size_t i = 0; i < _skyline.size(); ++i)
+	{
+		if (!_Fit(i, width, height, y))
+			continue;
+
+		// Lowest top edge first, then the narrowest node to keep the skyline flat
+		if (y + height < bestTop || (y + height == bestTop && _skyline[i].width < bestWidth))
+		{
+			bestIndex = i;
+			bestTop = y + height;
+			bestWidth = _skyline[i].width;
+			position = uvec2(_skyline[i].x, y);
+		}
+	}
+
+	if (bestIndex == SIZE_MAX)
+		return false;
+
+	_skyline.insert(_skyline.begin() + bestIndex, { position.x, position.y + height, width });
+
+	for (size_t i = bestIndex + 1; i < _skyline.size(); ++i)
+	{
+		SkylineNode &prev{ _skyline[i - 1] };
+		SkylineNode &node{ _skyline[i] };
+
+		if (node.x >= prev.x + prev.width)
+			break;
+
+		uint32_t shrink{ prev.x + prev.width - node.x };
+
+		if (node.width > shrink)
+		{
+			node.x += shrink;
+			node.width -= shrink;
+			break;
+		}
+
+		_skyline.erase(_skyline.begin() + i);
+		--i;
+	}
+
+	for (size_t i = 0; i + 1 < _skyline.size(); ++i)
+	{
+		if (_skyline[i].y != _skyline[i + 1].y)
+			continue;
+
+		_skyline[i].width += _skyline[i + 1].width;
+		_skyline.erase(_skyline.begin() + i + 1);
+		--i;
+	}
+
+	_usedArea += (uint64_t)width * height;
+
+	return true;
+}
+
+void SkylinePacker::Reset()
+{
+	_skyline.clear();
+	_skyline.push_back({ 0, 0, _width });
+	_usedArea = 0;
+}
+
+bool SkylinePacker::_Fit(size_t index, uint32_t width, uint32_t height, uint32_t &y) const
+{
+	if (_skyline[index].x + width > _width)
+		return false;
+
+	uint32_t widthLeft{ width };
+	y = _skyline[index].y;
+
+	for (size_t i = index; widthLeft > 0; ++i)
+	{
+		y = std::max(y, _skyline[i].y);
+
+		if (y + height > _height)
+			return false;
+
+		if (_skyline[i].width >= widthLeft)
+			break;
+
+		widthLeft -= _skyline[i].width;
+	}
+
+	return true;
+}
+
+GlyphCache::GlyphCache(GlyphSource *source, uint32_t width, uint32_t height) :
+	_source(source), _packer(width, height), _full(false)
+{
+}
+
+const GlyphInfo *GlyphCache::GetGlyph(uint32_t codepoint, int pixelSize)
+{
+	uint64_t key{ _gc_GlyphKey(codepoint, pixelSize) };
+
+	auto it = _glyphs.find(key);
+	if (it != _glyphs.end())
+		return &it->second;
+
+	GlyphInfo &info{ _glyphs[key] };
+	GlyphBitmap bitmap{};
+
+	// Glyphs that fail to rasterize are cached empty so they are not retried every frame
+	if (!_source->RasterizeGlyph(codepoint, pixelSize, bitmap))
+		return &info;
+
+	info.size = bitmap.size;
+	info.bearing = bitmap.bearing;
+	info.advance = bitmap.advance;
+
+	if (info.size.x <= 0 || info.size.y <= 0)
+		return &info;
+
+	uvec2 position{};
+	if (!_packer.Pack(info.size.x + GLYPH_PADDING, info.size.y + GLYPH_PADDING, position))
+	{
+		// Keep the advance so the layout stays correct; the owner resets the cache
+		_full = true;
+		info.size = ivec2(0);
+		return &info;
+	}
+
+	info.position = ivec2(position);
+
+	GlyphUpload upload{};
+	upload.x = position.x;
+	upload.y = position.y;
+	upload.width = info.size.x;
+	upload.height = info.size.y;
+	upload.offset = (_uploadData.size() + 3) & ~(size_t)3;
+
+	_uploadData.resize(upload.offset + upload.width * upload.height);
+
+	for (uint32_t i = 0; i < upload.height; ++i)
+		memcpy(&_uploadData[upload.offset + i * upload.width], bitmap.data + i * bitmap.pitch, upload.width);
+
+	_uploads.push_back(upload);
+
+	return &info;
+}
+
+int GlyphCache::GetKerning(uint32_t left, uint32_t right, int pixelSize)
+{
+	uint64_t key{ _gc_KerningKey(left, right, pixelSize) };
+
+	auto it = _kerning.find(key);
+	if (it != _kerning.end())
+		return it->second;
+
+	int kerning{ _source->GetKerning(left, right, pixelSize) };
+	_kerning[key] = kerning;
+
+	return kerning;
+}
+
+const FontMetrics &GlyphCache::GetMetrics(int pixelSize)
+{
+	auto it = _metrics.find(pixelSize);
+	if (it != _metrics.end())
+		return it->second;
+
+	FontMetrics &metrics{ _metrics[pixelSize] };
+	_source->GetMetrics(pixelSize, metrics);
+
+	return metrics;
+}
+
+template<typename T>
+int GlyphCache::_Layout(const char *text, size_t length, int pixelSize, T place)
+{
+	const FontMetrics &metrics{ GetMetrics(pixelSize) };
+	const char *end{ text + length };
+	int x{ 0 }, y{ 0 }, width{ 0 };
+	uint32_t prev{ 0 };
+
+	while (text < end)
+	{
+		uint32_t codepoint{ DecodeUTF8(text, end) };
+
+		if (codepoint == '\n')
+		{
+			width = std::max(width, x);
+			x = 0;
+			y += metrics.lineHeight;
+			prev = 0;
+			continue;
+		}
+		else if (codepoint == '\r')
+			continue;
+
+		const GlyphInfo *glyph{ GetGlyph(codepoint, pixelSize) };
+
+		if (prev)
+			x += GetKerning(prev, codepoint, pixelSize);
+
+		place(ivec2(x + glyph->bearing.x, y - glyph->bearing.y), glyph);
+
+		x += glyph->advance;
+		prev = codepoint;
+	}
+
+	return std::max(width, x);
+}
+
+int GlyphCache::Layout(const char *text, size_t length, int pixelSize, vector<PlacedGlyph> &glyphs)
+{
+	return _Layout(text, length, pixelSize, [&glyphs](const ivec2 &position, const GlyphInfo *glyph) {
+		if (glyph->size.x > 0 && glyph->size.y > 0)
+			glyphs.push_back({ position, glyph });
+	});
+}
+
+int GlyphCache::Measure(const char *text, size_t length, int pixelSize)
+{
+	return _Layout(text, length, pixelSize, [](const ivec2 &, const GlyphInfo *) { });
+}
+
+void GlyphCache::ClearPendingUploads()
+{
+	_uploads.clear();
+	_uploadData.clear();
+}
+
+void GlyphCache::Reset()
+{
+	_packer.Reset();
+	_glyphs.clear();
+	ClearPendingUploads();
+	_full = false;
+}
+
+uint32_t GlyphCache::DecodeUTF8(const char *&text, const char *end)
+{
+	uint8_t c{ (uint8_t)*text++ };
+	uint32_t codepoint{ 0 }, min{ 0 };
+	int extra{ 0 };
+
+	if (c < 0x80)
+		return c;
+	else if ((c & 0xE0) == 0xC0)
+	{
+		codepoint = c & 0x1F;
+		min = 0x80;
+		extra = 1;
+	}
+	else if ((c & 0xF0) == 0xE0)
+	{
+		codepoint = c & 0x0F;
+		min = 0x800;
+		extra = 2;
+	}
+	else if ((c & 0xF8) == 0xF0)
+	{
+		codepoint = c & 0x07;
+		min = 0x10000;
+		extra = 3;
+	}
+	else
+		return GLYPH_REPLACEMENT_CHAR;
+
+	// A truncated sequence consumes only its valid prefix
+	for (int i = 0; i < extra; ++i)
+	{
+		if (text >= end || ((uint8_t)*text & 0xC0) != 0x80)
+			return GLYPH_REPLACEMENT_CHAR;
+
+		codepoint = (codepoint << 6) | ((uint8_t)*text++ & 0x3F);
+	}
+
+	if (codepoint < min || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+		return GLYPH_REPLACEMENT_CHAR;
+
+	return codepoint;
+}
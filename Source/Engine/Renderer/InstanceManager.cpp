@@ -0,0 +1,228 @@
+/* NekoEngine
+ *
+ * InstanceManager.cpp
+ * Author: Alexandru Naiman
+ *
+ * Instanced draw data
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Renderer/VKUtil.h>
+#include <Renderer/Renderer.h>
+#include <Renderer/DebugMarker.h>
+#include <Renderer/InstanceManager.h>
+#include <Renderer/PipelineManager.h>
+#include <System/Logger.h>
+
+#define INSTMGR_MODULE			"InstanceManager"
+#define INSTMGR_MAX_COMMANDS	16384
+#define INSTMGR_MAX_INSTANCES	16384
+
+using namespace std;
+
+Buffer *InstanceManager::_buffer{ nullptr };
+VkDescriptorPool InstanceManager::_descriptorPool{ VK_NULL_HANDLE };
+VkDescriptorSet InstanceManager::_descriptorSet{ VK_NULL_HANDLE };
+VkDeviceSize InstanceManager::_instanceOffset{ 0 };
+vector<VkDrawIndexedIndirectCommand> InstanceManager::_commands{};
+vector<int32_t> InstanceManager::_freeCommands{};
+ObjectData *InstanceManager::_instances{ nullptr };
+uint32_t InstanceManager::_commandCount{ 0 };
+uint32_t InstanceManager::_instanceCount{ 0 };
+uint32_t InstanceManager::_dirtyBegin{ UINT32_MAX };
+uint32_t InstanceManager::_dirtyEnd{ 0 };
+
+int InstanceManager::Initialize()
+{
+	if (!PipelineManager::HasInstancing())
+		return ENGINE_OK;
+
+	// The instances are bound as a storage buffer descriptor, so they must start at a valid offset
+	VkPhysicalDeviceProperties props{};
+	vkGetPhysicalDeviceProperties(VKUtil::GetPhysicalDevice(), &props);
+	const VkDeviceSize alignment{ props.limits.minStorageBufferOffsetAlignment ? props.limits.minStorageBufferOffsetAlignment : 1 };
+
+	_instanceOffset = ((sizeof(VkDrawIndexedIndirectCommand) * INSTMGR_MAX_COMMANDS + alignment - 1) / alignment) * alignment;
+	const VkDeviceSize size{ _instanceOffset + sizeof(ObjectData) * INSTMGR_MAX_INSTANCES };
+
+	if ((_buffer = new Buffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, nullptr, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) == nullptr)
+	{
+		Logger::Log(INSTMGR_MODULE, LOG_CRITICAL, "Failed to create instance buffer");
+		return ENGINE_OUT_OF_RESOURCES;
+	}
+	VK_DBG_SET_OBJECT_NAME((uint64_t)_buffer->GetHandle(), VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Instance data");
+
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = 1;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	poolInfo.maxSets = 1;
+
+	if (vkCreateDescriptorPool(VKUtil::GetDevice(), &poolInfo, VKUtil::GetAllocator(), &_descriptorPool) != VK_SUCCESS)
+	{
+		Logger::Log(INSTMGR_MODULE, LOG_CRITICAL, "Failed to create descriptor pool");
+		return ENGINE_DESCRIPTOR_POOL_CREATE_FAIL;
+	}
+	VK_DBG_SET_OBJECT_NAME((uint64_t)_descriptorPool, VK_DEBUG_REPORT_OBJECT_TYPE_DESCRIPTOR_POOL_EXT, "Instance descriptor pool");
+
+	VkDescriptorSetLayout instancesDSL{ PipelineManager::GetDescriptorSetLayout(DESC_LYT_Instances) };
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = _descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &instancesDSL;
+
+	if (vkAllocateDescriptorSets(VKUtil::GetDevice(), &allocInfo, &_descriptorSet) != VK_SUCCESS)
+	{
+		Logger::Log(INSTMGR_MODULE, LOG_CRITICAL, "Failed to allocate descriptor set");
+		return ENGINE_DESCRIPTOR_SET_CREATE_FAIL;
+	}
+
+	VkDescriptorBufferInfo bufferInfo{};
+	bufferInfo.buffer = _buffer->GetHandle();
+	bufferInfo.offset = _buffer->GetParentOffset() + _instanceOffset;
+	bufferInfo.range = sizeof(ObjectData) * INSTMGR_MAX_INSTANCES;
+
+	VkWriteDescriptorSet descriptorWrite{};
+	VKUtil::WriteDS(&descriptorWrite, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &bufferInfo, _descriptorSet, 0);
+	vkUpdateDescriptorSets(VKUtil::GetDevice(), 1, &descriptorWrite, 0, nullptr);
+
+	_commands.resize(INSTMGR_MAX_COMMANDS);
+
+	if ((_instances = new ObjectData[INSTMGR_MAX_INSTANCES]) == nullptr)
+	{
+		Logger::Log(INSTMGR_MODULE, LOG_CRITICAL, "Failed to allocate instances");
+		return ENGINE_OUT_OF_RESOURCES;
+	}
+
+	Logger::Log(INSTMGR_MODULE, LOG_INFORMATION, "Initialized with %d commands and %d instances", INSTMGR_MAX_COMMANDS, INSTMGR_MAX_INSTANCES);
+
+	return ENGINE_OK;
+}
+
+int32_t InstanceManager::AllocateCommand(uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset) noexcept
+{
+	int32_t command{ INST_NO_COMMAND };
+
+	if (!_freeCommands.empty())
+	{
+		command = _freeCommands.back();
+		_freeCommands.pop_back();
+	}
+	else if (_buffer && _commandCount < INSTMGR_MAX_COMMANDS)
+	{
+		command = (int32_t)_commandCount++;
+	}
+	else
+	{
+		return INST_NO_COMMAND;
+	}
+
+	// Written to the buffer with the first batch that uses it
+	_commands[command] = { indexCount, 0, firstIndex, vertexOffset, 0 };
+
+	return command;
+}
+
+void InstanceManager::FreeCommand(int32_t command) noexcept
+{
+	if (command == INST_NO_COMMAND)
+		return;
+
+	_freeCommands.push_back(command);
+}
+
+void InstanceManager::Reset() noexcept
+{
+	_instanceCount = 0;
+}
+
+bool InstanceManager::AddBatch(int32_t command, const void *const *data, uint32_t count) noexcept
+{
+	if (command == INST_NO_COMMAND || _instanceCount + count > INSTMGR_MAX_INSTANCES)
+		return false;
+
+	VkDrawIndexedIndirectCommand &cmd{ _commands[command] };
+	cmd.instanceCount = count;
+	cmd.firstInstance = _instanceCount;
+
+	for (uint32_t i = 0; i < count; ++i)
+		_instances[_instanceCount + i] = *(const ObjectData *)data[i];
+
+	_instanceCount += count;
+
+	if ((uint32_t)command < _dirtyBegin) _dirtyBegin = command;
+	if ((uint32_t)command + 1 > _dirtyEnd) _dirtyEnd = command + 1;
+
+	return true;
+}
+
+void InstanceManager::UpdateData(VkCommandBuffer commandBuffer) noexcept
+{
+	if (_dirtyBegin < _dirtyEnd)
+	{
+		const VkDeviceSize offset{ sizeof(VkDrawIndexedIndirectCommand) * _dirtyBegin };
+		Renderer::GetInstance()->UploadFrameData(_buffer, offset, (uint8_t *)&_commands[_dirtyBegin], sizeof(VkDrawIndexedIndirectCommand) * (_dirtyEnd - _dirtyBegin), commandBuffer);
+	}
+
+	if (_instanceCount)
+		Renderer::GetInstance()->UploadFrameData(_buffer, _instanceOffset, (uint8_t *)_instances, sizeof(ObjectData) * _instanceCount, commandBuffer);
+
+	_dirtyBegin = UINT32_MAX;
+	_dirtyEnd = 0;
+}
+
+void InstanceManager::Release() noexcept
+{
+	if (_descriptorPool != VK_NULL_HANDLE)
+		vkDestroyDescriptorPool(VKUtil::GetDevice(), _descriptorPool, VKUtil::GetAllocator());
+
+	delete _buffer;
+	delete[] _instances;
+
+	_buffer = nullptr;
+	_instances = nullptr;
+	_descriptorPool = VK_NULL_HANDLE;
+	_descriptorSet = VK_NULL_HANDLE;
+
+	_commands.clear();
+	_freeCommands.clear();
+	_commandCount = _instanceCount = 0;
+	_dirtyBegin = UINT32_MAX;
+	_dirtyEnd = 0;
+}
@@ -0,0 +1,341 @@
+/* NekoEngine
+ *
+ * LightClusters.cpp
+ * Author: Alexandru Naiman
+ *
+ * Clustered light assignment
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <Engine/Defs.h>
+#include <Engine/TaskManager.h>
+#include <System/Logger.h>
+#include <Renderer/Renderer.h>
+#include <Renderer/LightClusters.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define LC_SSE
+	#include <emmintrin.h>
+#endif
+
+#define LC_MODULE			"LightClusters"
+#define LC_LIGHT_GRAIN		512
+#define LC_MIN_INTENSITY	.02f
+
+using namespace std;
+using namespace glm;
+
+static inline uint32_t _lc_LowestBit(uint32_t v)
+{
+#if defined(_MSC_VER)
+	unsigned long idx;
+	_BitScanForward(&idx, v);
+	return (uint32_t)idx;
+#else
+	return (uint32_t)__builtin_ctz(v);
+#endif
+}
+
+static inline uint32_t _lc_HighestBit(uint32_t v)
+{
+#if defined(_MSC_VER)
+	unsigned long idx;
+	_BitScanReverse(&idx, v);
+	return (uint32_t)idx;
+#else
+	return 31 - (uint32_t)__builtin_clz(v);
+#endif
+}
+
+static inline bool _lc_IsClustered(const Light &l)
+{
+	return (uint32_t)l.position.w != LT_Directional && l.color.a >= LC_MIN_INTENSITY;
+}
+
+static inline vec4 _lc_Plane(const vec4 &row, const vec4 &w, float ndc)
+{
+	vec4 p{ row - w * ndc };
+	return p / length(vec3(p));
+}
+
+LightClusters::LightClusters(uint32_t tilesX, uint32_t tilesY, uint32_t slices) noexcept :
+	_tilesX{ glm::clamp(tilesX, 1u, (uint32_t)LC_MAX_TILES) },
+	_tilesY{ glm::clamp(tilesY, 1u, (uint32_t)LC_MAX_TILES) },
+	_slices{ glm::clamp(slices, 1u, 255u) },
+	_near{ 0.f }, _far{ 0.f }, _sliceScale{ 0.f }, _sliceBias{ 0.f }
+{
+	_clusters.resize(GetClusterCount());
+}
+
+uint32_t LightClusters::GetSlice(float depth) const noexcept
+{
+	if (depth <= _near)
+		return 0;
+
+	int32_t slice{ (int32_t)(logf(depth) * _sliceScale + _sliceBias) };
+	return (uint32_t)glm::clamp(slice, 0, (int32_t)_slices - 1);
+}
+
+int LightClusters::Build(const mat4 &view, const mat4 &projection, float zNear, float zFar, const Light *lights, uint32_t count)
+{
+	if (count > LC_MAX_LIGHTS || zNear <= 0.f || zFar <= zNear)
+	{
+		Logger::Log(LC_MODULE, LOG_CRITICAL, "Invalid arguments: %u lights, near %f, far %f", count, zNear, zFar);
+		return ENGINE_INVALID_ARGS;
+	}
+
+	_view = view;
+	_near = zNear;
+	_far = zFar;
+	_sliceScale = (float)_slices / logf(zFar / zNear);
+	_sliceBias = -logf(zNear) * _sliceScale;
+
+	// Tile boundaries are the planes through the eye where the clip space
+	// x (or y) equals ndc * w. Normalized, they give true distances.
+	const vec4 row0{ projection[0][0], projection[1][0], projection[2][0], projection[3][0] };
+	const vec4 row1{ projection[0][1], projection[1][1], projection[2][1], projection[3][1] };
+	const vec4 row3{ projection[0][3], projection[1][3], projection[2][3], projection[3][3] };
+
+	for (uint32_t i = 0; i <= _tilesX; ++i)
+		_planesX[i] = _lc_Plane(row0, row3, -1.f + 2.f * (float)i / (float)_tilesX);
+	for (uint32_t i = 0; i <= _tilesY; ++i)
+		_planesY[i] = _lc_Plane(row1, row3, -1.f + 2.f * (float)i / (float)_tilesY);
+
+	_bounds.resize(count);
+	_globalLights.clear();
+
+	TaskManager::ParallelFor(count, LC_LIGHT_GRAIN, [&](uint32_t first, uint32_t last) {
+		_ComputeBounds(lights, first, last);
+	});
+
+	_visibleLights.clear();
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (_bounds[i].visible)
+			_visibleLights.push_back((uint16_t)i);
+		else if ((uint32_t)lights[i].position.w == LT_Directional && lights[i].color.a >= LC_MIN_INTENSITY)
+			_globalLights.push_back((uint16_t)i);
+	}
+
+	// Each slice is owned by one job, so the counts and the index lists
+	// are written without synchronization
+	const uint32_t sliceSize{ _tilesX * _tilesY };
+
+	TaskManager::ParallelFor(_slices, 1, [&](uint32_t first, uint32_t last) {
+		for (uint32_t z = first; z < last; ++z)
+		{
+			LightCluster *clusters{ &_clusters[z * sliceSize] };
+			for (uint32_t i = 0; i < sliceSize; ++i)
+				clusters[i].count = 0;
+
+			for (uint16_t i : _visibleLights)
+			{
+				const LightClusterBounds &b{ _bounds[i] };
+				if (z < b.z0 || z > b.z1)
+					continue;
+
+				for (uint32_t y = b.y0; y <= b.y1; ++y)
+					for (uint32_t x = b.x0; x <= b.x1; ++x)
+						++clusters[y * _tilesX + x].count;
+			}
+		}
+	});
+
+	uint32_t offset{ 0 };
+	for (LightCluster &cluster : _clusters)
+	{
+		cluster.offset = offset;
+		offset += cluster.count;
+		cluster.count = 0;
+	}
+
+	_indices.resize(offset);
+
+	TaskManager::ParallelFor(_slices, 1, [&](uint32_t first, uint32_t last) {
+		for (uint32_t z = first; z < last; ++z)
+		{
+			LightCluster *clusters{ &_clusters[z * sliceSize] };
+
+			for (uint16_t i : _visibleLights)
+			{
+				const LightClusterBounds &b{ _bounds[i] };
+				if (z < b.z0 || z > b.z1)
+					continue;
+
+				for (uint32_t y = b.y0; y <= b.y1; ++y)
+				{
+					for (uint32_t x = b.x0; x <= b.x1; ++x)
+					{
+						LightCluster &c{ clusters[y * _tilesX + x] };
+						_indices[c.offset + c.count++] = i;
+					}
+				}
+			}
+		}
+	});
+
+	return ENGINE_OK;
+}
+
+void LightClusters::ComputeBoundsReference(const Light *lights, uint32_t first, uint32_t last, LightClusterBounds *bounds) const noexcept
+{
+	for (uint32_t i = first; i < last; ++i)
+	{
+		const Light &l{ lights[i] };
+		LightClusterBounds &b{ bounds[i - first] };
+
+		b.visible = false;
+		if (!_lc_IsClustered(l))
+			continue;
+
+		const vec3 p{ _view * vec4(vec3(l.position), 1.f) };
+		const float r{ l.data.y };
+		uint32_t colMask{ 0 }, rowMask{ 0 };
+
+		// The sphere overlaps the tile between two planes if it is not
+		// entirely on the wrong side of either of them
+		for (uint32_t j = 0; j < _tilesX; ++j)
+		{
+			const float s0{ _planesX[j].x * p.x + _planesX[j].y * p.y + _planesX[j].z * p.z + _planesX[j].w };
+			const float s1{ _planesX[j + 1].x * p.x + _planesX[j + 1].y * p.y + _planesX[j + 1].z * p.z + _planesX[j + 1].w };
+			if (s0 >= -r && s1 <= r) colMask |= 1u << j;
+		}
+
+		for (uint32_t j = 0; j < _tilesY; ++j)
+		{
+			const float s0{ _planesY[j].x * p.x + _planesY[j].y * p.y + _planesY[j].z * p.z + _planesY[j].w };
+			const float s1{ _planesY[j + 1].x * p.x + _planesY[j + 1].y * p.y + _planesY[j + 1].z * p.z + _planesY[j + 1].w };
+			if (s0 >= -r && s1 <= r) rowMask |= 1u << j;
+		}
+
+		_RangeFromMasks(colMask, rowMask, -p.z, r, b);
+	}
+}
+
+void LightClusters::_RangeFromMasks(uint32_t colMask, uint32_t rowMask, float depth, float radius, LightClusterBounds &b) const noexcept
+{
+	b.visible = colMask && rowMask && depth + radius >= _near && depth - radius <= _far;
+	if (!b.visible)
+		return;
+
+	b.x0 = (uint8_t)_lc_LowestBit(colMask);
+	b.x1 = (uint8_t)_lc_HighestBit(colMask);
+	b.y0 = (uint8_t)_lc_LowestBit(rowMask);
+	b.y1 = (uint8_t)_lc_HighestBit(rowMask);
+	b.z0 = (uint8_t)GetSlice(depth - radius);
+	b.z1 = (uint8_t)GetSlice(glm::min(depth + radius, _far));
+}
+
+void LightClusters::_ComputeBounds(const Light *lights, uint32_t first, uint32_t last) noexcept
+{
+	uint32_t i{ first };
+
+#ifdef LC_SSE
+	// Four lights at a time: transform to view space and test them against
+	// every tile plane, collecting one bit per overlapped column and row
+	const __m128 v00{ _mm_set1_ps(_view[0][0]) }, v10{ _mm_set1_ps(_view[1][0]) }, v20{ _mm_set1_ps(_view[2][0]) }, v30{ _mm_set1_ps(_view[3][0]) };
+	const __m128 v01{ _mm_set1_ps(_view[0][1]) }, v11{ _mm_set1_ps(_view[1][1]) }, v21{ _mm_set1_ps(_view[2][1]) }, v31{ _mm_set1_ps(_view[3][1]) };
+	const __m128 v02{ _mm_set1_ps(_view[0][2]) }, v12{ _mm_set1_ps(_view[1][2]) }, v22{ _mm_set1_ps(_view[2][2]) }, v32{ _mm_set1_ps(_view[3][2]) };
+
+	for (; i + 4 <= last; i += 4)
+	{
+		const Light *l{ &lights[i] };
+
+		const __m128 x{ _mm_set_ps(l[3].position.x, l[2].position.x, l[1].position.x, l[0].position.x) };
+		const __m128 y{ _mm_set_ps(l[3].position.y, l[2].position.y, l[1].position.y, l[0].position.y) };
+		const __m128 z{ _mm_set_ps(l[3].position.z, l[2].position.z, l[1].position.z, l[0].position.z) };
+		const __m128 r{ _mm_set_ps(l[3].data.y, l[2].data.y, l[1].data.y, l[0].data.y) };
+		const __m128 nr{ _mm_sub_ps(_mm_setzero_ps(), r) };
+
+		const __m128 px{ _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(v00, x), _mm_mul_ps(v10, y)), _mm_mul_ps(v20, z)), v30) };
+		const __m128 py{ _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(v01, x), _mm_mul_ps(v11, y)), _mm_mul_ps(v21, z)), v31) };
+		const __m128 pz{ _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(v02, x), _mm_mul_ps(v12, y)), _mm_mul_ps(v22, z)), v32) };
+
+		uint32_t colMask[4]{}, rowMask[4]{};
+		int prevGe{ 0 };
+
+		for (uint32_t j = 0; j <= _tilesX; ++j)
+		{
+			const vec4 &pl{ _planesX[j] };
+			const __m128 s{ _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl.x), px), _mm_mul_ps(_mm_set1_ps(pl.y), py)), _mm_mul_ps(_mm_set1_ps(pl.z), pz)), _mm_set1_ps(pl.w)) };
+			const int ge{ _mm_movemask_ps(_mm_cmpge_ps(s, nr)) };
+
+			if (j)
+			{
+				const int overlap{ prevGe & _mm_movemask_ps(_mm_cmple_ps(s, r)) };
+				for (uint32_t k = 0; k < 4; ++k)
+					colMask[k] |= (uint32_t)((overlap >> k) & 1) << (j - 1);
+			}
+
+			prevGe = ge;
+		}
+
+		for (uint32_t j = 0; j <= _tilesY; ++j)
+		{
+			const vec4 &pl{ _planesY[j] };
+			const __m128 s{ _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl.x), px), _mm_mul_ps(_mm_set1_ps(pl.y), py)), _mm_mul_ps(_mm_set1_ps(pl.z), pz)), _mm_set1_ps(pl.w)) };
+			const int ge{ _mm_movemask_ps(_mm_cmpge_ps(s, nr)) };
+
+			if (j)
+			{
+				const int overlap{ prevGe & _mm_movemask_ps(_mm_cmple_ps(s, r)) };
+				for (uint32_t k = 0; k < 4; ++k)
+					rowMask[k] |= (uint32_t)((overlap >> k) & 1) << (j - 1);
+			}
+
+			prevGe = ge;
+		}
+
+		float depth[4], radius[4];
+		_mm_storeu_ps(depth, _mm_sub_ps(_mm_setzero_ps(), pz));
+		_mm_storeu_ps(radius, r);
+
+		for (uint32_t k = 0; k < 4; ++k)
+		{
+			LightClusterBounds &b{ _bounds[i + k] };
+
+			if (_lc_IsClustered(l[k]))
+				_RangeFromMasks(colMask[k], rowMask[k], depth[k], radius[k], b);
+			else
+				b.visible = false;
+		}
+	}
+#endif
+
+	if (i < last)
+		ComputeBoundsReference(lights, i, last, &_bounds[i]);
+}
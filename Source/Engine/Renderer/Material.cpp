@@ -238,6 +238,53 @@ int Material::Load()
 	return ENGINE_OK;
 }
 
+int Material::Reload()
+{
+	// Parse into a new material so a broken file leaves this one intact
+	Material material{ GetResourceInfo() };
+
+	int ret = material.Load();
+	if (ret != ENGINE_OK)
+		return ret;
+
+	const bool animated{ _animated };
+	const bool hadDescriptorSet{ _descriptorSet != VK_NULL_HANDLE };
+
+	Unload();
+
+	_transparent = material._transparent;
+	_noCulling = material._noCulling;
+	_data = material._data;
+
+	_diffuseTextureId = material._diffuseTextureId;
+	_normalTextureId = material._normalTextureId;
+	_specularTextureId = material._specularTextureId;
+	_emissionTextureId = material._emissionTextureId;
+
+	_diffuseTexture = material._diffuseTexture;
+	_normalTexture = material._normalTexture;
+	_specularTexture = material._specularTexture;
+	_emissionTexture = material._emissionTexture;
+
+	_pipelineId = material._pipelineId;
+	_pipelineLayoutId = material._pipelineLayoutId;
+	_descriptorSetLayout = material._descriptorSetLayout;
+
+	_descriptorSet = VK_NULL_HANDLE;
+	_normalDescriptorSet = Renderer::GetInstance()->GetBlankTextureDescriptorSet();
+	_descriptorPool = VK_NULL_HANDLE;
+
+	_animated = false;
+	SetAnimated(animated);
+
+	if (hadDescriptorSet && !CreateDescriptorSet())
+		return ENGINE_DESCRIPTOR_SET_CREATE_FAIL;
+
+	Logger::Log(MAT_MODULE, LOG_DEBUG, "Reloaded material %s", _resourceInfo->name.c_str());
+
+	return ENGINE_OK;
+}
+
 void Material::SetAnimated(bool animated)
 {
 	if (_animated == animated)
@@ -257,16 +304,20 @@ void Material::SetAnimated(bool animated)
 	_animated = animated;
 }
 
-void Material::Enable(VkCommandBuffer buffer)
+void Material::Enable(VkCommandBuffer buffer, bool instanced)
 {
-	vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipeline(_pipelineId));
-	vkCmdPushConstants(buffer, PipelineManager::GetPipelineLayout(_pipelineLayoutId), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(MaterialData), &_data);
-	vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipelineLayout(_pipelineLayoutId), 2, 1, &_descriptorSet, 0, nullptr);
+	PipelineId id{ instanced ? (PipelineId)(_pipelineId + PIPE_Instanced_Unlit) : _pipelineId };
+	VkPipelineLayout layout{ GetPipelineLayout(instanced) };
+
+	vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipeline(id));
+	vkCmdPushConstants(buffer, layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(MaterialData), &_data);
+	vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 2, 1, &_descriptorSet, 0, nullptr);
 }
 
-void Material::BindNormal(VkCommandBuffer buffer)
+void Material::BindNormal(VkCommandBuffer buffer, bool instanced)
 {
-	vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipelineLayout(_animated ? PIPE_LYT_Anim_Depth : PIPE_LYT_Depth), 2, 1, &_normalDescriptorSet, 0, nullptr);
+	PipelineLayoutId layout{ _animated ? PIPE_LYT_Anim_Depth : (instanced ? PIPE_LYT_Instanced_Depth : PIPE_LYT_Depth) };
+	vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipelineLayout(layout), 2, 1, &_normalDescriptorSet, 0, nullptr);
 }
 
 bool Material::CreateDescriptorSet()
@@ -0,0 +1,698 @@
+/* NekoEngine
+ *
+ * MemoryAllocator.cpp
+ * Author: Alexandru Naiman
+ *
+ * Device Memory Sub-Allocator
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <algorithm>
+
+#include <System/Logger.h>
+#include <Renderer/MemoryAllocator.h>
+
+#define MEMORY_MODULE	"MemoryAllocator"
+#define MEMORY_SL_COUNT	(1 << MEMORY_TLSF_SL_BITS)
+#define MEMORY_MB(x)	((double)(x) / (1024.0 * 1024.0))
+
+using namespace std;
+
+static inline uint32_t _ma_Log2(VkDeviceSize v)
+{
+#if defined(_MSC_VER)
+	unsigned long idx;
+	_BitScanReverse64(&idx, v);
+	return (uint32_t)idx;
+#else
+	return 63 - (uint32_t)__builtin_clzll(v);
+#endif
+}
+
+static inline uint32_t _ma_LowestBit(uint64_t v)
+{
+#if defined(_MSC_VER)
+	unsigned long idx;
+	_BitScanForward64(&idx, v);
+	return (uint32_t)idx;
+#else
+	return (uint32_t)__builtin_ctzll(v);
+#endif
+}
+
+static inline void _ma_Mapping(VkDeviceSize size, uint32_t &fl, uint32_t &sl)
+{
+	if (size < MEMORY_SL_COUNT)
+	{
+		fl = 0;
+		sl = (uint32_t)size;
+		return;
+	}
+
+	uint32_t log2{ _ma_Log2(size) };
+	fl = log2 - MEMORY_TLSF_SL_BITS + 1;
+	sl = (uint32_t)(size >> (log2 - MEMORY_TLSF_SL_BITS)) ^ MEMORY_SL_COUNT;
+}
+
+static inline VkDeviceSize _ma_AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+TLSFHeap::TLSFHeap(VkDeviceSize size) :
+	_flBitmap(0), _size(size), _used(0), _allocations(0)
+{
+	memset(_slBitmap, 0x0, sizeof(_slBitmap));
+	memset(_heads, 0xFF, sizeof(_heads));
+
+	// Node 0 always starts at offset 0: merges keep the lower node and alignment padding stays in front
+	uint32_t node{ _NewNode() };
+	_nodes[node].offset = 0;
+	_nodes[node].size = size;
+	_InsertFree(node);
+}
+
+uint32_t TLSFHeap::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset, void *userData)
+{
+	if (!size) size = 1;
+
+	uint32_t node{ _FindFree(size) };
+
+	if (node != MEMORY_INVALID_NODE && alignment > 1 &&
+		_ma_AlignUp(_nodes[node].offset, alignment) + size > _nodes[node].offset + _nodes[node].size)
+		node = MEMORY_INVALID_NODE;
+
+	// Any block of this class fits the size, but the alignment may need more
+	if (node == MEMORY_INVALID_NODE && alignment > 1)
+		node = _FindFree(size + alignment - 1);
+
+	if (node == MEMORY_INVALID_NODE)
+		return MEMORY_INVALID_NODE;
+
+	_RemoveFree(node);
+
+	VkDeviceSize aligned{ _ma_AlignUp(_nodes[node].offset, alignment) };
+	if (aligned != _nodes[node].offset)
+	{
+		uint32_t allocated{ _Split(node, aligned - _nodes[node].offset) };
+		_InsertFree(node);
+		node = allocated;
+	}
+
+	if (_nodes[node].size - size >= MEMORY_TLSF_MIN_SPLIT)
+		_InsertFree(_Split(node, size));
+
+	_nodes[node].free = false;
+	_nodes[node].userData = userData;
+	_used += _nodes[node].size;
+	++_allocations;
+
+	offset = aligned;
+	return node;
+}
+
+void TLSFHeap::Free(uint32_t node)
+{
+	_used -= _nodes[node].size;
+	--_allocations;
+
+	_nodes[node].free = true;
+	_nodes[node].userData = nullptr;
+
+	uint32_t next{ _nodes[node].nextPhys };
+	if (next != MEMORY_INVALID_NODE && _nodes[next].free)
+	{
+		_RemoveFree(next);
+		_nodes[node].size += _nodes[next].size;
+		_nodes[node].nextPhys = _nodes[next].nextPhys;
+		if (_nodes[next].nextPhys != MEMORY_INVALID_NODE)
+			_nodes[_nodes[next].nextPhys].prevPhys = node;
+		_unusedNodes.push_back(next);
+	}
+
+	uint32_t prev{ _nodes[node].prevPhys };
+	if (prev != MEMORY_INVALID_NODE && _nodes[prev].free)
+	{
+		_RemoveFree(prev);
+		_nodes[prev].size += _nodes[node].size;
+		_nodes[prev].nextPhys = _nodes[node].nextPhys;
+		if (_nodes[node].nextPhys != MEMORY_INVALID_NODE)
+			_nodes[_nodes[node].nextPhys].prevPhys = prev;
+		_unusedNodes.push_back(node);
+		node = prev;
+	}
+
+	_InsertFree(node);
+}
+
+void TLSFHeap::Walk(const function<void(VkDeviceSize, VkDeviceSize, void *)> &visitor) const
+{
+	for (uint32_t node = 0; node != MEMORY_INVALID_NODE; node = _nodes[node].nextPhys)
+		if (!_nodes[node].free)
+			visitor(_nodes[node].offset, _nodes[node].size, _nodes[node].userData);
+}
+
+VkDeviceSize TLSFHeap::GetLargestFree() const
+{
+	if (!_flBitmap)
+		return 0;
+
+	uint32_t fl{ _ma_Log2(_flBitmap) };
+	uint32_t sl{ _ma_Log2(_slBitmap[fl]) };
+	VkDeviceSize largest{ 0 };
+
+	for (uint32_t node = _heads[fl][sl]; node != MEMORY_INVALID_NODE; node = _nodes[node].nextFree)
+		largest = std::max(largest, _nodes[node].size);
+
+	return largest;
+}
+
+bool TLSFHeap::Validate() const
+{
+	VkDeviceSize offset{ 0 }, used{ 0 };
+	uint32_t allocations{ 0 }, freeNodes{ 0 }, prev{ MEMORY_INVALID_NODE };
+
+	for (uint32_t node = 0; node != MEMORY_INVALID_NODE; node = _nodes[node].nextPhys)
+	{
+		const TLSFNode &n{ _nodes[node] };
+
+		if (n.offset != offset || n.prevPhys != prev || !n.size)
+			return false;
+
+		if (n.free)
+		{
+			if (prev != MEMORY_INVALID_NODE && _nodes[prev].free)
+				return false;
+
+			uint32_t fl, sl;
+			_ma_Mapping(n.size, fl, sl);
+			if (!(_slBitmap[fl] & (1u << sl)) || !(_flBitmap & (1ull << fl)))
+				return false;
+			++freeNodes;
+		}
+		else
+		{
+			used += n.size;
+			++allocations;
+		}
+
+		offset += n.size;
+		prev = node;
+	}
+
+	uint32_t listed{ 0 };
+	for (uint32_t fl = 0; fl < MEMORY_TLSF_FL_COUNT; ++fl)
+	{
+		for (uint32_t sl = 0; sl < MEMORY_SL_COUNT; ++sl)
+		{
+			if (((_slBitmap[fl] >> sl) & 1) != (_heads[fl][sl] != MEMORY_INVALID_NODE))
+				return false;
+
+			for (uint32_t node = _heads[fl][sl]; node != MEMORY_INVALID_NODE; node = _nodes[node].nextFree)
+			{
+				if (!_nodes[node].free)
+					return false;
+				++listed;
+			}
+		}
+	}
+
+	return offset == _size && used == _used && allocations == _allocations && listed == freeNodes;
+}
+
+uint32_t TLSFHeap::_NewNode()
+{
+	uint32_t node;
+
+	if (_unusedNodes.size())
+	{
+		node = _unusedNodes.back();
+		_unusedNodes.pop_back();
+	}
+	else
+	{
+		node = (uint32_t)_nodes.size();
+		_nodes.emplace_back();
+	}
+
+	TLSFNode &n{ _nodes[node] };
+	n.offset = n.size = 0;
+	n.prevPhys = n.nextPhys = n.prevFree = n.nextFree = MEMORY_INVALID_NODE;
+	n.userData = nullptr;
+	n.free = false;
+
+	return node;
+}
+
+void TLSFHeap::_InsertFree(uint32_t node)
+{
+	uint32_t fl, sl;
+	_ma_Mapping(_nodes[node].size, fl, sl);
+
+	TLSFNode &n{ _nodes[node] };
+	n.free = true;
+	n.prevFree = MEMORY_INVALID_NODE;
+	n.nextFree = _heads[fl][sl];
+
+	if (n.nextFree != MEMORY_INVALID_NODE)
+		_nodes[n.nextFree].prevFree = node;
+
+	_heads[fl][sl] = node;
+	_slBitmap[fl] |= 1u << sl;
+	_flBitmap |= 1ull << fl;
+}
+
+void TLSFHeap::_RemoveFree(uint32_t node)
+{
+	uint32_t fl, sl;
+	_ma_Mapping(_nodes[node].size, fl, sl);
+
+	TLSFNode &n{ _nodes[node] };
+
+	if (n.prevFree != MEMORY_INVALID_NODE)
+		_nodes[n.prevFree].nextFree = n.nextFree;
+	else
+		_heads[fl][sl] = n.nextFree;
+
+	if (n.nextFree != MEMORY_INVALID_NODE)
+		_nodes[n.nextFree].prevFree = n.prevFree;
+
+	n.prevFree = n.nextFree = MEMORY_INVALID_NODE;
+
+	if (_heads[fl][sl] == MEMORY_INVALID_NODE)
+	{
+		_slBitmap[fl] &= ~(1u << sl);
+		if (!_slBitmap[fl])
+			_flBitmap &= ~(1ull << fl);
+	}
+}
+
+uint32_t TLSFHeap::_FindFree(VkDeviceSize size)
+{
+	// Round up to the next class so every block in the list found is large enough
+	if (size >= MEMORY_SL_COUNT)
+		size += (1ull << (_ma_Log2(size) - MEMORY_TLSF_SL_BITS)) - 1;
+
+	uint32_t fl, sl;
+	_ma_Mapping(size, fl, sl);
+
+	if (fl >= MEMORY_TLSF_FL_COUNT)
+		return MEMORY_INVALID_NODE;
+
+	uint32_t slMap{ _slBitmap[fl] & (~0u << sl) };
+	if (!slMap)
+	{
+		uint64_t flMap{ fl + 1 < 64 ? _flBitmap & (~0ull << (fl + 1)) : 0 };
+		if (!flMap)
+			return MEMORY_INVALID_NODE;
+
+		fl = _ma_LowestBit(flMap);
+		slMap = _slBitmap[fl];
+	}
+
+	return _heads[fl][_ma_LowestBit(slMap)];
+}
+
+uint32_t TLSFHeap::_Split(uint32_t node, VkDeviceSize size)
+{
+	uint32_t tail{ _NewNode() };
+
+	TLSFNode &n{ _nodes[node] }, &t{ _nodes[tail] };
+	t.offset = n.offset + size;
+	t.size = n.size - size;
+	t.prevPhys = node;
+	t.nextPhys = n.nextPhys;
+	n.size = size;
+	n.nextPhys = tail;
+
+	if (t.nextPhys != MEMORY_INVALID_NODE)
+		_nodes[t.nextPhys].prevPhys = tail;
+
+	return tail;
+}
+
+MemoryAllocator::MemoryAllocator(MemoryDevice *device, VkDeviceSize blockSize) :
+	_device(device), _blockSize(blockSize),
+	_dedicatedCount(0), _defragMoves(0),
+	_dedicatedBytes(0)
+{
+	uint32_t typeCount{ _device->GetMemoryTypeCount() };
+
+	// One pool for linear resources and one for optimal images per memory type
+	_pools.resize(typeCount * 2);
+
+	for (uint32_t i = 0; i < typeCount * 2; ++i)
+	{
+		MemoryPool &pool{ _pools[i] };
+		pool.memoryType = i / 2;
+		pool.hostVisible = (_device->GetMemoryTypeProperties(pool.memoryType) & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+		pool.blockSize = std::min(_blockSize, std::max<VkDeviceSize>(_device->GetMemoryTypeHeapSize(pool.memoryType) / 8, MEMORY_MIN_BLOCK_SIZE));
+	}
+}
+
+bool MemoryAllocator::Allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, MemoryResourceType type, MemoryAllocation &allocation, void *owner)
+{
+	memset(&allocation, 0x0, sizeof(allocation));
+	allocation.node = MEMORY_INVALID_NODE;
+
+	for (uint32_t i = 0; i < _device->GetMemoryTypeCount(); ++i)
+	{
+		if (!(requirements.memoryTypeBits & (1 << i)) || (_device->GetMemoryTypeProperties(i) & properties) != properties)
+			continue;
+
+		uint32_t poolIndex{ i * 2 + (type == MemoryResourceType::Linear ? 0 : 1) };
+		VkDeviceSize blockSize{ _pools[poolIndex].blockSize };
+
+		// Large resources would waste most of a block; large render targets are freed on every resize
+		bool dedicated{ requirements.size > blockSize / 2 || (type == MemoryResourceType::Attachment && requirements.size >= blockSize / 8) };
+
+		if (!dedicated)
+		{
+			if (_AllocateFromPool(poolIndex, requirements, allocation, owner, false) ||
+				_AllocateFromPool(poolIndex, requirements, allocation, owner, true))
+				return true;
+		}
+
+		// Also the fallback when the heap cannot fit another block
+		if (_AllocateDedicated(i, requirements.size, allocation, owner))
+			return true;
+	}
+
+	Logger::Log(MEMORY_MODULE, LOG_CRITICAL, "Failed to allocate %llu bytes (types 0x%x, properties 0x%x)",
+		(unsigned long long)requirements.size, requirements.memoryTypeBits, properties);
+
+	return false;
+}
+
+void MemoryAllocator::Free(MemoryAllocation &allocation)
+{
+	if (allocation.memory == VK_NULL_HANDLE)
+		return;
+
+	if (allocation.dedicated)
+	{
+		if (allocation.mapped)
+			_device->UnmapMemory(allocation.memory);
+		_device->FreeMemory(allocation.memory);
+
+		--_dedicatedCount;
+		_dedicatedBytes -= allocation.size;
+	}
+	else
+	{
+		MemoryPool &pool{ _pools[allocation.pool] };
+		TLSFHeap *heap{ pool.blocks[allocation.block].heap };
+
+		heap->Free(allocation.node);
+
+		if (!heap->GetAllocationCount())
+			_ReleaseEmptyBlocks(pool, true);
+	}
+
+	allocation.memory = VK_NULL_HANDLE;
+	allocation.mapped = nullptr;
+	allocation.node = MEMORY_INVALID_NODE;
+}
+
+uint32_t MemoryAllocator::Defragment(uint32_t maxMoves, const MemoryMoveHandler &handler)
+{
+	uint32_t moves{ 0 };
+
+	for (uint32_t p = 0; p < _pools.size() && moves < maxMoves; ++p)
+	{
+		MemoryPool &pool{ _pools[p] };
+		vector<uint32_t> live;
+
+		for (uint32_t b = 0; b < pool.blocks.size(); ++b)
+			if (pool.blocks[b].heap && pool.blocks[b].heap->GetAllocationCount())
+				live.push_back(b);
+
+		if (live.size() < 2)
+			continue;
+
+		sort(live.begin(), live.end(), [&pool](uint32_t a, uint32_t b) {
+			return pool.blocks[a].heap->GetUsed() < pool.blocks[b].heap->GetUsed();
+		});
+
+		// Drain the emptiest block into the fullest ones first
+		uint32_t source{ live[0] };
+		vector<MemoryAllocation *> allocations;
+		pool.blocks[source].heap->Walk([&allocations](VkDeviceSize, VkDeviceSize, void *userData) {
+			allocations.push_back((MemoryAllocation *)userData);
+		});
+
+		for (MemoryAllocation *src : allocations)
+		{
+			if (moves == maxMoves)
+				break;
+
+			if (!src)
+				continue;
+
+			MemoryAllocation dst{ *src };
+			bool placed{ false };
+
+			for (size_t i = live.size() - 1; i > 0 && !placed; --i)
+			{
+				MemoryBlock &block{ pool.blocks[live[i]] };
+				uint32_t node{ block.heap->Allocate(src->size, src->alignment, dst.offset, src) };
+
+				if (node == MEMORY_INVALID_NODE)
+					continue;
+
+				dst.memory = block.memory;
+				dst.mapped = block.mapped ? block.mapped + dst.offset : nullptr;
+				dst.block = live[i];
+				dst.node = node;
+				placed = true;
+			}
+
+			if (!placed)
+				continue;
+
+			if (!handler(*src, dst))
+			{
+				pool.blocks[dst.block].heap->Free(dst.node);
+				continue;
+			}
+
+			pool.blocks[source].heap->Free(src->node);
+			*src = dst;
+			++moves;
+		}
+
+		// Returning the memory is the point of defragmenting, so no empty block is kept here
+		if (!pool.blocks[source].heap->GetAllocationCount())
+			_ReleaseEmptyBlocks(pool, false);
+	}
+
+	_defragMoves += moves;
+
+	return moves;
+}
+
+void MemoryAllocator::GetStats(MemoryStats &stats) const
+{
+	memset(&stats, 0x0, sizeof(stats));
+
+	for (const MemoryPool &pool : _pools)
+	{
+		for (const MemoryBlock &block : pool.blocks)
+		{
+			if (!block.heap)
+				continue;
+
+			++stats.blockCount;
+			stats.blockBytes += block.heap->GetSize();
+			stats.usedBytes += block.heap->GetUsed();
+			stats.allocationCount += block.heap->GetAllocationCount();
+			stats.largestFree = std::max(stats.largestFree, block.heap->GetLargestFree());
+		}
+	}
+
+	stats.dedicatedCount = _dedicatedCount;
+	stats.dedicatedBytes = _dedicatedBytes;
+	stats.allocationCount += _dedicatedCount;
+	stats.usedBytes += _dedicatedBytes;
+	stats.defragMoves = _defragMoves;
+}
+
+void MemoryAllocator::LogStats() const
+{
+	MemoryStats stats;
+	GetStats(stats);
+
+	Logger::Log(MEMORY_MODULE, LOG_INFORMATION, "%u allocations in %u blocks (%.01f MB) and %u dedicated (%.01f MB), %.01f MB used",
+		stats.allocationCount, stats.blockCount, MEMORY_MB(stats.blockBytes), stats.dedicatedCount, MEMORY_MB(stats.dedicatedBytes), MEMORY_MB(stats.usedBytes));
+}
+
+bool MemoryAllocator::_AllocateFromPool(uint32_t poolIndex, const VkMemoryRequirements &requirements, MemoryAllocation &allocation, void *owner, bool newBlock)
+{
+	MemoryPool &pool{ _pools[poolIndex] };
+	uint32_t blockIndex{ (uint32_t)pool.blocks.size() };
+
+	if (newBlock)
+	{
+		MemoryBlock block{ VK_NULL_HANDLE, nullptr, nullptr };
+
+		if (!_device->AllocateMemory(pool.memoryType, pool.blockSize, block.memory))
+			return false;
+
+		if (pool.hostVisible && (block.mapped = _device->MapMemory(block.memory)) == nullptr)
+		{
+			_device->FreeMemory(block.memory);
+			return false;
+		}
+
+		block.heap = new TLSFHeap(pool.blockSize);
+
+		for (uint32_t i = 0; i < pool.blocks.size(); ++i)
+			if (!pool.blocks[i].heap)
+				blockIndex = i;
+
+		if (blockIndex == pool.blocks.size())
+			pool.blocks.push_back(block);
+		else
+			pool.blocks[blockIndex] = block;
+	}
+
+	uint32_t first{ newBlock ? blockIndex : 0 };
+	uint32_t last{ newBlock ? blockIndex + 1 : (uint32_t)pool.blocks.size() };
+
+	for (uint32_t i = first; i < last; ++i)
+	{
+		MemoryBlock &block{ pool.blocks[i] };
+		if (!block.heap)
+			continue;
+
+		uint32_t node{ block.heap->Allocate(requirements.size, requirements.alignment, allocation.offset, &allocation) };
+		if (node == MEMORY_INVALID_NODE)
+			continue;
+
+		allocation.memory = block.memory;
+		allocation.size = requirements.size;
+		allocation.alignment = requirements.alignment;
+		allocation.mapped = block.mapped ? block.mapped + allocation.offset : nullptr;
+		allocation.memoryType = pool.memoryType;
+		allocation.pool = poolIndex;
+		allocation.block = i;
+		allocation.node = node;
+		allocation.dedicated = false;
+		allocation.owner = owner;
+
+		return true;
+	}
+
+	return false;
+}
+
+bool MemoryAllocator::_AllocateDedicated(uint32_t memoryType, VkDeviceSize size, MemoryAllocation &allocation, void *owner)
+{
+	if (!_device->AllocateMemory(memoryType, size, allocation.memory))
+		return false;
+
+	allocation.mapped = nullptr;
+	if ((_device->GetMemoryTypeProperties(memoryType) & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
+		(allocation.mapped = _device->MapMemory(allocation.memory)) == nullptr)
+	{
+		_device->FreeMemory(allocation.memory);
+		allocation.memory = VK_NULL_HANDLE;
+		return false;
+	}
+
+	allocation.offset = 0;
+	allocation.size = size;
+	allocation.alignment = 0;
+	allocation.memoryType = memoryType;
+	allocation.pool = allocation.block = 0;
+	allocation.node = MEMORY_INVALID_NODE;
+	allocation.dedicated = true;
+	allocation.owner = owner;
+
+	++_dedicatedCount;
+	_dedicatedBytes += size;
+
+	return true;
+}
+
+void MemoryAllocator::_ReleaseEmptyBlocks(MemoryPool &pool, bool keepOne)
+{
+	// Keeping one empty block stops a resource that is freed and recreated every frame from hitting the driver
+	bool keep{ keepOne };
+
+	for (MemoryBlock &block : pool.blocks)
+	{
+		if (!block.heap || block.heap->GetAllocationCount())
+			continue;
+
+		if (keep)
+		{
+			keep = false;
+			continue;
+		}
+
+		if (block.mapped)
+			_device->UnmapMemory(block.memory);
+		_device->FreeMemory(block.memory);
+
+		delete block.heap;
+		block = { VK_NULL_HANDLE, nullptr, nullptr };
+	}
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+	MemoryStats stats;
+	GetStats(stats);
+
+	if (stats.allocationCount)
+		Logger::Log(MEMORY_MODULE, LOG_WARNING, "%u allocations (%.01f MB) still alive at shutdown", stats.allocationCount, MEMORY_MB(stats.usedBytes));
+
+	for (MemoryPool &pool : _pools)
+	{
+		for (MemoryBlock &block : pool.blocks)
+		{
+			if (!block.heap)
+				continue;
+
+			if (block.mapped)
+				_device->UnmapMemory(block.memory);
+			_device->FreeMemory(block.memory);
+
+			delete block.heap;
+		}
+	}
+
+	delete _device;
+}
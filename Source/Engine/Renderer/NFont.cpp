@@ -44,6 +44,7 @@
 #include <Renderer/NFont.h>
 #include <Renderer/VKUtil.h>
 #include <Renderer/Renderer.h>
+#include <Renderer/DistanceField.h>
 #include <Renderer/DebugMarker.h>
 #include <Renderer/PipelineManager.h>
 #include <Renderer/RenderPassManager.h>
@@ -56,9 +57,12 @@
 using namespace std;
 using namespace glm;
 
+// Shared by every font and released with the last one
 static FT_Library _ft = nullptr;
+static int _ftRefCount = 0;
 
-NFont::NFont(FontResource *res)
+NFont::NFont(FontResource *res) :
+	_cache(this, FONT_ATLAS_SIZE, FONT_ATLAS_SIZE)
 {
 	_resourceInfo = res;
 
@@ -68,67 +72,101 @@ NFont::NFont(FontResource *res)
 	_imageMemory = VK_NULL_HANDLE;
 	_view = VK_NULL_HANDLE;
 
-	_texWidth = _texHeight = 0;
 	_bufferSize = 0;
+	_stagingSliceSize = 0;
+	_stagingSlice = 0;
+	_maxChars = 0;
+	_runs = nullptr;
 	_pixelSize = 20;
+	_facePixelSize = 0;
+	_distanceField = Engine::GetConfiguration().Renderer.DistanceFieldText;
+
+	_effects = FontEffects{};
+
+	_face = nullptr;
+	_fontData = nullptr;
 
 	_buffer = _stagingBuffer = nullptr;
 }
 
 uint32_t NFont::GetTextLength(const char *text)
 {
-	uint32_t len{ 0 };
-	size_t textLen{ strlen(text) };
+	return (uint32_t)ceilf(_cache.Measure(text, strlen(text), _LayoutSize()) * _LayoutScale());
+}
 
-	for (unsigned int i = 0; i < textLen; ++i)
-	{
-		CharacterInfo &info{ _characterInfo[(int)text[i]] };
-		len += info.bearing.x + info.size.x;
-	}
+uint32_t NFont::GetTextLength(const NString &text)
+{
+	return (uint32_t)ceilf(_cache.Measure(*text, text.Length(), _LayoutSize()) * _LayoutScale());
+}
+
+int NFont::SetPixelSize(int pixelSize)
+{
+	if (pixelSize <= 0)
+		return ENGINE_INVALID_ARGS;
+
+	_pixelSize = pixelSize;
 
-	return len;
+	return ENGINE_OK;
 }
 
-uint32_t NFont::GetTextLength(const NString &text)
+int NFont::SetDistanceField(bool enable)
 {
-	uint32_t len{ 0 };
+	if (_distanceField == enable)
+		return ENGINE_OK;
 
-	for (unsigned int i = 0; i < text.Length(); ++i)
-	{
-		CharacterInfo &info{ _characterInfo[(int)text[i]] };
-		len += info.bearing.x + info.size.x;
-	}
+	_distanceField = enable;
+	_cache.Reset();
+
+	if (_runs)
+		_runs->Clear();
 
-	return len;
+	if (_cmdBuffer == VK_NULL_HANDLE)
+		return ENGINE_OK;
+
+	return _BuildCommandBuffer();
 }
 
-int NFont::SetPixelSize(int pixelSize)
+int NFont::SetOutline(float width, const vec4 &color)
 {
-	_pixelSize = pixelSize;
+	if (width < 0.f || width > FONT_SDF_SPREAD)
+		return ENGINE_INVALID_ARGS;
 
-	FT_Init_FreeType(&_ft);
+	_effects.outlineWidth = width / (2.f * FONT_SDF_SPREAD);
+	_effects.outlineColor = color;
 
-	int ret = _BuildAtlas();
+	if (_cmdBuffer == VK_NULL_HANDLE)
+		return ENGINE_OK;
 
-	FT_Done_FreeType(_ft);
+	return _BuildCommandBuffer();
+}
 
-	_UpdateDescriptorSet();
+int NFont::SetShadow(const vec2 &offset, const vec4 &color, float softness)
+{
+	// The quads only cover the spread around each glyph
+	if (fabsf(offset.x) > FONT_SDF_SPREAD || fabsf(offset.y) > FONT_SDF_SPREAD || softness < 0.f || softness > FONT_SDF_SPREAD)
+		return ENGINE_INVALID_ARGS;
+
+	_effects.shadowOffset = offset / (float)FONT_ATLAS_SIZE;
+	_effects.shadowColor = color;
+	_effects.softness = softness / (2.f * FONT_SDF_SPREAD);
 
-	if (ret == ENGINE_OK)
-		ret = _BuildCommandBuffer();
+	if (_cmdBuffer == VK_NULL_HANDLE)
+		return ENGINE_OK;
 
-	return ret;
+	return _BuildCommandBuffer();
 }
 
 int NFont::Load()
 {
-	FT_Init_FreeType(&_ft);
+	int ret{ _LoadFace() };
 
-	int ret{ _BuildAtlas() };
+	if (ret != ENGINE_OK)
+		return ret;
 
-	FT_Done_FreeType(_ft);
+	if ((ret = _CreateAtlas()) != ENGINE_OK)
+		return ret;
 
-	if (ret != ENGINE_OK)
+	if ((ret = _CreateBuffers()) != ENGINE_OK)
 		return ret;
 
 	if ((ret = _CreateDescriptorSet()) != ENGINE_OK)
@@ -144,66 +182,148 @@ int NFont::Load()
 
 void NFont::UpdateData(VkCommandBuffer cmdBuffer)
 {
-	uint8_t *data{ _stagingBuffer->Map(0, _bufferSize) };
-	if(!data)
-	{ DIE("Failed to map staging buffer"); }
+	VkDeviceSize sliceOffset{ _stagingSlice * _stagingSliceSize };
+	uint8_t *data{ nullptr };
 
-	_drawCommand.indexCount = (uint32_t)_indices.Count();
-	_drawCommand.instanceCount = 1;
-	_drawCommand.firstIndex = 0;
-	_drawCommand.firstInstance = 0;
-	_drawCommand.vertexOffset = 0;
+	_UploadGlyphs(cmdBuffer);
 
-	memcpy(data, &_drawCommand, sizeof(VkDrawIndexedIndirectCommand));
-	memcpy(data + _vboOffset, *_vertices, _vertices.Count() * sizeof(GUIVertex));
-	memcpy(data + _iboOffset, *_indices, _indices.Count() * sizeof(uint32_t));
+	// Retained runs need no staging memory at all
+	if (_runs->GetDynamicRunCount())
+	{
+		if ((data = _stagingBuffer->Map(sliceOffset, _stagingSliceSize)) == nullptr)
+		{ DIE("Failed to map staging buffer"); }
+	}
 
-	_stagingBuffer->Unmap();
+	_runs->EndFrame(data ? data + sizeof(_drawCommands) : nullptr, data ? _stagingSliceSize - sizeof(_drawCommands) : 0, _runUpdate);
+
+	VkDrawIndexedIndirectCommand drawCommands[2]{};
+	drawCommands[0].indexCount = _runUpdate.persistentQuads * 6;
+	drawCommands[0].instanceCount = 1;
+	drawCommands[1].indexCount = _runUpdate.dynamicQuads * 6;
+	drawCommands[1].instanceCount = 1;
+	drawCommands[1].vertexOffset = _runUpdate.dynamicFirstQuad * 4;
+
+	bool updateCommands{ memcmp(drawCommands, _drawCommands, sizeof(_drawCommands)) != 0 };
+
+	if (updateCommands)
+	{
+		memcpy(_drawCommands, drawCommands, sizeof(_drawCommands));
+
+		if (data)
+			memcpy(data, _drawCommands, sizeof(_drawCommands));
+		else
+			vkCmdUpdateBuffer(cmdBuffer, _buffer->GetHandle(), _buffer->GetParentOffset(), sizeof(_drawCommands), _drawCommands);
+	}
+
+	if (data)
+		_stagingBuffer->Unmap();
 
-	VKUtil::CopyBuffer(_stagingBuffer->GetHandle(), _buffer->GetHandle(), _bufferSize, 0, _buffer->GetParentOffset(), cmdBuffer);
+	for (const TextRunFill &fill : _runUpdate.fills)
+		vkCmdFillBuffer(cmdBuffer, _buffer->GetHandle(), _buffer->GetParentOffset() + _vboOffset + fill.offset, fill.size, 0);
 
-	_vertices.Clear(false);
-	_indices.Clear(false);
+	if (_runUpdate.fills.size() && _runUpdate.copies.size())
+	{
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	if (data)
+	{
+		VkDeviceSize srcOffset{ _stagingBuffer->GetParentOffset() + sliceOffset };
+		VkDeviceSize dstOffset{ _buffer->GetParentOffset() };
+
+		_copyRegions.clear();
+
+		if (updateCommands)
+			_copyRegions.push_back({ srcOffset, dstOffset, sizeof(_drawCommands) });
+
+		for (const TextRunCopy &copy : _runUpdate.copies)
+			_copyRegions.push_back({ srcOffset + sizeof(_drawCommands) + copy.srcOffset, dstOffset + _vboOffset + copy.dstOffset, copy.size });
+
+		if (_copyRegions.size())
+			vkCmdCopyBuffer(cmdBuffer, _stagingBuffer->GetHandle(), _buffer->GetHandle(), (uint32_t)_copyRegions.size(), _copyRegions.data());
+
+		_stagingSlice = (_stagingSlice + 1) % TEXT_RUN_RING_SIZE;
+	}
+
+	// The text of this frame is already laid out; evicting now only costs the next frame a few rasterizations
+	if (_cache.IsFull())
+	{
+		Logger::Log(FONT_MODULE, LOG_WARNING, "Glyph atlas of font %s is full, evicting all glyphs", _resourceInfo->name.c_str());
+		_cache.Reset();
+		_runs->Clear();
+	}
 }
 
-void NFont::Draw(NString text, glm::vec2 &pos, glm::vec3 &color) noexcept
+void NFont::Draw(const char *text, vec2 &pos, vec3 &color) noexcept
 {
-	unsigned int vertexCount{ (unsigned int)_vertices.Count() };
-	uint32_t offset{ Engine::GetConfiguration().Engine.ScreenHeight - _texHeight + 4 };
+	if (!_runs)
+		return;
+
+	size_t length{ strlen(text) };
+	uint32_t screenHeight{ Engine::GetConfiguration().Engine.ScreenHeight };
+	int layoutSize{ _LayoutSize() };
 
-	for (unsigned int i = 0; i < text.Length(); i++)
+	uint64_t key{ TextRunCache::Hash(text, length) };
+	key = TextRunCache::Hash(&pos, sizeof(pos), key);
+	key = TextRunCache::Hash(&color, sizeof(color), key);
+	key = TextRunCache::Hash(&_pixelSize, sizeof(_pixelSize), key);
+	key = TextRunCache::Hash(&layoutSize, sizeof(layoutSize), key);
+	key = TextRunCache::Hash(&screenHeight, sizeof(screenHeight), key);
+
+	TextRun *run{ _runs->Find(key) };
+
+	if (!run)
 	{
-		CharacterInfo &info{ _characterInfo[(int)text[i]] };
+		run = _runs->Add(key);
+		_Tessellate(text, length, pos, color, *run);
+	}
 
-		float x{ pos.x + info.bearing.x };
-		float y{ (offset - pos.y) - (info.size.y - info.bearing.y) };
-		float w{ (float)info.size.x };
-		float h{ (float)info.size.y };
+	pos.x += run->width;
+}
 
-		GUIVertex v{};
-		v.color = vec4(color, 1.0);
+void NFont::_Tessellate(const char *text, size_t length, const vec2 &pos, const vec3 &color, TextRun &run)
+{
+	const FontMetrics &metrics{ _cache.GetMetrics(_pixelSize) };
+	float baseline{ (float)Engine::GetConfiguration().Engine.ScreenHeight - metrics.ascender - pos.y };
+	float scale{ _LayoutScale() };
+
+	_placedGlyphs.clear();
+	run.width = _cache.Layout(text, length, _LayoutSize(), _placedGlyphs) * scale;
+	run.vertices.reserve(_placedGlyphs.size() * 4);
+
+	for (const PlacedGlyph &placed : _placedGlyphs)
+	{
+		const GlyphInfo *glyph{ placed.glyph };
 
-		v.posAndUV = vec4(x, y, info.offset, (float)info.size.y / (float)_texHeight);
-		_vertices.Add(v);
+		float w{ glyph->size.x * scale };
+		float h{ glyph->size.y * scale };
+		float x{ pos.x + placed.position.x * scale };
+		float y{ baseline - placed.position.y * scale - h };
 
-		v.posAndUV = vec4(x, y + h, info.offset, 0.f);
-		_vertices.Add(v);
+		float u0{ (float)glyph->position.x / FONT_ATLAS_SIZE };
+		float u1{ (float)(glyph->position.x + glyph->size.x) / FONT_ATLAS_SIZE };
+		float v0{ (float)glyph->position.y / FONT_ATLAS_SIZE };
+		float v1{ (float)(glyph->position.y + glyph->size.y) / FONT_ATLAS_SIZE };
 
-		v.posAndUV = vec4(x + w, y + h, info.offset + ((float)info.size.x / (float)_texWidth), 0.f);
-		_vertices.Add(v);
+		GUIVertex v{};
+		v.color = vec4(color, 1.0);
+
+		v.posAndUV = vec4(x, y, u0, v1);
+		run.vertices.push_back(v);
 
-		v.posAndUV = vec4(x + w, y, info.offset + ((float)info.size.x / (float)_texWidth), (float)info.size.y / (float)_texHeight);
-		_vertices.Add(v);
+		v.posAndUV = vec4(x, y + h, u0, v0);
+		run.vertices.push_back(v);
 
-		unsigned int indexOffset{ (4 * i) + vertexCount };
-		_indices.Add(indexOffset);
-		_indices.Add(1 + indexOffset);
-		_indices.Add(2 + indexOffset);
-		_indices.Add(indexOffset);
-		_indices.Add(2 + indexOffset);
-		_indices.Add(3 + indexOffset);
+		v.posAndUV = vec4(x + w, y + h, u1, v0);
+		run.vertices.push_back(v);
 
-		pos.x += info.advance;
+		v.posAndUV = vec4(x + w, y, u1, v1);
+		run.vertices.push_back(v);
 	}
 }
 
@@ -212,17 +332,67 @@ void NFont::AddCommandBuffer()
 	Renderer::GetInstance()->AddGUICommandBuffer(_cmdBuffer);
 }
 
-int NFont::_BuildAtlas()
+bool NFont::RasterizeGlyph(uint32_t codepoint, int pixelSize, GlyphBitmap &bitmap)
+{
+	_SetFaceSize(pixelSize);
+
+	if (FT_Load_Char(_face, codepoint, FT_LOAD_RENDER))
+		return false;
+
+	FT_GlyphSlot glyph{ _face->glyph };
+
+	bitmap.size = ivec2(glyph->bitmap.width, glyph->bitmap.rows);
+	bitmap.bearing = ivec2(glyph->bitmap_left, glyph->bitmap_top);
+	bitmap.advance = (int)(glyph->advance.x >> 6);
+	bitmap.pitch = glyph->bitmap.pitch;
+	bitmap.data = glyph->bitmap.buffer;
+
+	if (!_distanceField || !bitmap.size.x || !bitmap.size.y)
+		return true;
+
+	DistanceField::Generate(glyph->bitmap.buffer, bitmap.size.x, bitmap.size.y, glyph->bitmap.pitch, FONT_SDF_SPREAD, _fieldData);
+
+	bitmap.size += ivec2(2 * FONT_SDF_SPREAD);
+	bitmap.bearing += ivec2(-FONT_SDF_SPREAD, FONT_SDF_SPREAD);
+	bitmap.pitch = bitmap.size.x;
+	bitmap.data = _fieldData.data();
+
+	return true;
+}
+
+int NFont::GetKerning(uint32_t left, uint32_t right, int pixelSize)
+{
+	if (!FT_HAS_KERNING(_face))
+		return 0;
+
+	_SetFaceSize(pixelSize);
+
+	FT_Vector delta{};
+	if (FT_Get_Kerning(_face, FT_Get_Char_Index(_face, left), FT_Get_Char_Index(_face, right), FT_KERNING_DEFAULT, &delta))
+		return 0;
+
+	return (int)(delta.x >> 6);
+}
+
+void NFont::GetMetrics(int pixelSize, FontMetrics &metrics)
+{
+	_SetFaceSize(pixelSize);
+
+	metrics.ascender = (int)(_face->size->metrics.ascender >> 6);
+	metrics.lineHeight = (int)((_face->size->metrics.ascender - _face->size->metrics.descender) >> 6);
+}
+
+int NFont::_LoadFace()
 {
-	FT_Face face{};
-	FT_GlyphSlot glyph{};
 	VFSFile *file{ nullptr };
 	size_t size{ 0 };
-	uint8_t *mem{ nullptr };
-	uint32_t x{ 0 }, vboSize{ 0 }, iboSize{ 0 }, maxChars{ 0 };
 
-	VkBuffer stagingBuffer{ VK_NULL_HANDLE };
-	VkDeviceMemory stagingBufferMemory{ VK_NULL_HANDLE };
+	if (!_ft && FT_Init_FreeType(&_ft))
+	{
+		_ft = nullptr;
+		Logger::Log(FONT_MODULE, LOG_CRITICAL, "Failed to initialize FreeType");
+		return ENGINE_FAIL;
+	}
 
 	if ((file = VFS::Open(GetResourceInfo()->filePath)) == nullptr)
 	{
@@ -233,7 +403,7 @@ int NFont::_BuildAtlas()
 	if (file->Seek(0, SEEK_END) == ENGINE_FAIL)
 	{
 		file->Close();
-		Logger::Log(FONT_MODULE, LOG_CRITICAL, "Seek failed for file [%].", *GetResourceInfo()->filePath);
+		Logger::Log(FONT_MODULE, LOG_CRITICAL, "Seek failed for file [%s].", *GetResourceInfo()->filePath);
 		return ENGINE_FAIL;
 	}
 
@@ -242,129 +412,206 @@ int NFont::_BuildAtlas()
 	if (file->Seek(0, SEEK_SET) == ENGINE_FAIL)
 	{
 		file->Close();
-		Logger::Log(FONT_MODULE, LOG_CRITICAL, "Seek failed for file [%].", *GetResourceInfo()->filePath);
+		Logger::Log(FONT_MODULE, LOG_CRITICAL, "Seek failed for file [%s].", *GetResourceInfo()->filePath);
 		return ENGINE_FAIL;
 	}
 
-	mem = (uint8_t*)calloc((size_t)size, sizeof(uint8_t));
-	if (file->Read(mem, sizeof(uint8_t), size) == 0)
+	// FreeType reads from this buffer for as long as the face is alive
+	_fontData = (uint8_t*)calloc((size_t)size, sizeof(uint8_t));
+	if (file->Read(_fontData, sizeof(uint8_t), size) == 0)
 	{
 		file->Close();
-		free(mem);
-		Logger::Log(FONT_MODULE, LOG_CRITICAL, "Failed to read file [%].", *GetResourceInfo()->filePath);
+		Logger::Log(FONT_MODULE, LOG_CRITICAL, "Failed to read file [%s].", *GetResourceInfo()->filePath);
 		return ENGINE_FAIL;
 	}
 
-	if (FT_New_Memory_Face(_ft, mem, (FT_Long)size, 0, &face))
+	file->Close();
+
+	if (FT_New_Memory_Face(_ft, _fontData, (FT_Long)size, 0, &_face))
 	{
-		file->Close();
-		free(mem);
+		_face = nullptr;
+
+		if (!_ftRefCount)
+		{
+			FT_Done_FreeType(_ft);
+			_ft = nullptr;
+		}
+
 		Logger::Log(FONT_MODULE, LOG_CRITICAL, "Failed to load font face for id %s.", GetResourceInfo()->name.c_str());
 		return ENGINE_FAIL;
 	}
 
-	FT_Set_Pixel_Sizes(face, 0, _pixelSize);
-
-	glyph = face->glyph;
-
-	for (int i = 0; i < FONT_NUM_CHARS; ++i)
-	{
-		if (FT_Load_Char(face, i, FT_LOAD_RENDER))
-			continue;
+	++_ftRefCount;
 
-		_texWidth += glyph->bitmap.width;
-		_texHeight = std::max(_texHeight, (uint32_t)glyph->bitmap.rows);
-	}
+	return ENGINE_OK;
+}
 
-	VkDeviceSize buffSize{ _texWidth * _texHeight };
+void NFont::_SetFaceSize(int pixelSize)
+{
+	if (_facePixelSize == pixelSize)
+		return;
 
-	VKUtil::CreateBuffer(stagingBuffer, stagingBufferMemory, buffSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	FT_Set_Pixel_Sizes(_face, 0, pixelSize);
+	_facePixelSize = pixelSize;
+}
 
-	uint8_t *data{ nullptr };
-	vkMapMemory(VKUtil::GetDevice(), stagingBufferMemory, 0, buffSize, 0, (void **)&data);
+int NFont::_CreateAtlas()
+{
+	if (!VKUtil::CreateImage(_image, _imageMemory, FONT_ATLAS_SIZE, FONT_ATLAS_SIZE, 1,
+		VK_MEMORY_HEAP_DEVICE_LOCAL_BIT, VK_FORMAT_R8_UNORM, VK_IMAGE_TYPE_2D,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_IMAGE_TILING_OPTIMAL))
+	{
+		Logger::Log(FONT_MODULE, LOG_CRITICAL, "Failed to create atlas image for font %s", _resourceInfo->name.c_str());
+		return ENGINE_FAIL;
+	}
 
-	for (int i = 0; i < FONT_NUM_CHARS; ++i)
+	if (!VKUtil::CreateImageView(_view, _image, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_R8_UNORM))
 	{
-		if (FT_Load_Char(face, i, FT_LOAD_RENDER)) continue;
+		Logger::Log(FONT_MODULE, LOG_CRITICAL, "Failed to create atlas image view for font %s", _resourceInfo->name.c_str());
+		return ENGINE_FAIL;
+	}
 
-		for (uint32_t j = 0; j < glyph->bitmap.rows; ++j)
-		{
-			uint32_t offset{ x + _texWidth * j };
-			uint32_t size{ glyph->bitmap.width };
-			uint32_t dataOffset{ size * j };
+	// Printable ASCII at the default size is rasterized up front, everything else on first use
+	for (uint32_t i = FONT_PRELOAD_START; i < FONT_PRELOAD_END; ++i)
+		_cache.GetGlyph(i, _LayoutSize());
 
-			memcpy(data + offset, glyph->bitmap.buffer + dataOffset, size);
-		}
+	VkCommandBuffer cmdBuffer{ VKUtil::CreateOneShotCmdBuffer() };
 
-		_characterInfo[i].size = ivec2(glyph->bitmap.width, glyph->bitmap.rows);
-		_characterInfo[i].bearing = ivec2(glyph->bitmap_left, glyph->bitmap_top);
-		_characterInfo[i].advance = (unsigned int)glyph->advance.x >> 6;
-		_characterInfo[i].offset = (float)x / _texWidth;
+	VkClearColorValue clearColor{};
+	VkImageSubresourceRange range{};
+	range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	range.levelCount = 1;
+	range.layerCount = 1;
 
-		x += glyph->bitmap.width;
-	}
+	VKUtil::TransitionImageLayout(_image, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range, cmdBuffer);
+	vkCmdClearColorImage(cmdBuffer, _image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &range);
+	VKUtil::TransitionImageLayout(_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range, cmdBuffer);
 
-	vkUnmapMemory(VKUtil::GetDevice(), stagingBufferMemory);
+	_UploadGlyphs(cmdBuffer);
 
-	VKUtil::CreateImage(_image, _imageMemory, _texWidth, _texHeight, 1,
-		VK_MEMORY_HEAP_DEVICE_LOCAL_BIT, VK_FORMAT_R8_UNORM, VK_IMAGE_TYPE_2D,
-		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_TILING_OPTIMAL);
+	VKUtil::ExecuteOneShotCmdBuffer(cmdBuffer);
 
-	VKUtil::TransitionImageLayout(_image, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	VKUtil::CopyBufferToImage(stagingBuffer, _image, _texWidth, _texHeight);
-	VKUtil::TransitionImageLayout(_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	VK_DBG_SET_OBJECT_NAME((uint64_t)_image, VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, *NString::StringWithFormat(40, "Font %s image", _resourceInfo->name.c_str()));
 
-	VKUtil::CreateImageView(_view, _image, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_R8_UNORM);
+	return ENGINE_OK;
+}
 
-	vkDestroyBuffer(VKUtil::GetDevice(), stagingBuffer, VKUtil::GetAllocator());
-	vkFreeMemory(VKUtil::GetDevice(), stagingBufferMemory, VKUtil::GetAllocator());
+int NFont::_CreateBuffers()
+{
+	VkDeviceSize vboSize{ 0 }, iboSize{ 0 };
+	const FontMetrics &metrics{ _cache.GetMetrics(_pixelSize) };
 
-	maxChars = (int)((1.f / (((float)_texWidth / (float)FONT_NUM_CHARS) * (1.f / Engine::GetScreenWidth()))) * (1.f / (_texHeight * (1.f / Engine::GetScreenHeight()))));
+	// Enough quads to fill the screen with average width characters of the default size
+	_maxChars = (Engine::GetScreenWidth() / std::max(_pixelSize / 2, 1)) * (Engine::GetScreenHeight() / std::max(metrics.lineHeight, 1));
 
-	_vertices.Resize(maxChars * 4);
-	_indices.Resize(maxChars * 6);
+	// One persistent region followed by the dynamic ring
+	_runs = new TextRunCache(_maxChars, _maxChars);
 
-	vboSize = maxChars * 4 * sizeof(GUIVertex);
-	iboSize = maxChars * 6 * sizeof(uint16_t);
+	vboSize = (VkDeviceSize)_maxChars * (1 + TEXT_RUN_RING_SIZE) * TEXT_RUN_QUAD_SIZE;
+	iboSize = (VkDeviceSize)_maxChars * 6 * sizeof(uint32_t);
 
-	_vboOffset = sizeof(VkDrawIndexedIndirectCommand);
+	_vboOffset = sizeof(_drawCommands);
 	_iboOffset = _vboOffset + vboSize;
 	_bufferSize = _iboOffset + iboSize;
+	_stagingSliceSize = sizeof(_drawCommands) + 2 * (VkDeviceSize)_maxChars * TEXT_RUN_QUAD_SIZE;
 
 	_buffer = new Buffer(_bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
 		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
 		VK_BUFFER_USAGE_TRANSFER_DST_BIT, nullptr, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	_stagingBuffer = new Buffer(_bufferSize, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, nullptr, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+	_stagingBuffer = new Buffer(_stagingSliceSize * TEXT_RUN_RING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, nullptr, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 
-	data = (uint8_t *)_stagingBuffer->Map(0, buffSize);
+	uint8_t *data{ _stagingBuffer->Map(0, sizeof(_drawCommands) + iboSize) };
+	if (!data)
+	{
+		Logger::Log(FONT_MODULE, LOG_CRITICAL, "Failed to map staging buffer for font %s", _resourceInfo->name.c_str());
+		return ENGINE_FAIL;
+	}
 
-	_drawCommand.indexCount = (uint32_t)_indices.Count();
-	_drawCommand.instanceCount = 1;
-	_drawCommand.firstIndex = 0;
-	_drawCommand.firstInstance = 0;
-	_drawCommand.vertexOffset = 0;
+	memset(_drawCommands, 0x0, sizeof(_drawCommands));
+	_drawCommands[0].instanceCount = _drawCommands[1].instanceCount = 1;
+	memcpy(data, _drawCommands, sizeof(_drawCommands));
 
-	memcpy(data, &_drawCommand, sizeof(VkDrawIndexedIndirectCommand));
-	memcpy(data + _vboOffset, *_vertices, vboSize);
-	memcpy(data + _iboOffset, *_indices, iboSize);
+	// Every quad uses the same pattern, so the index buffer never changes
+	uint32_t *indices{ (uint32_t *)(data + sizeof(_drawCommands)) };
+	for (uint32_t i = 0; i < _maxChars; ++i)
+	{
+		indices[i * 6] = i * 4;
+		indices[i * 6 + 1] = i * 4 + 1;
+		indices[i * 6 + 2] = i * 4 + 2;
+		indices[i * 6 + 3] = i * 4;
+		indices[i * 6 + 4] = i * 4 + 2;
+		indices[i * 6 + 5] = i * 4 + 3;
+	}
 
 	_stagingBuffer->Unmap();
 
-	VKUtil::CopyBuffer(_stagingBuffer->GetHandle(), _buffer->GetHandle(), _bufferSize);
-
-	FT_Done_Face(face);
+	VkCommandBuffer cmdBuffer{ VKUtil::CreateOneShotCmdBuffer() };
+	VKUtil::CopyBuffer(_stagingBuffer->GetHandle(), _buffer->GetHandle(), sizeof(_drawCommands), _stagingBuffer->GetParentOffset(), _buffer->GetParentOffset(), cmdBuffer);
+	VKUtil::CopyBuffer(_stagingBuffer->GetHandle(), _buffer->GetHandle(), iboSize, _stagingBuffer->GetParentOffset() + sizeof(_drawCommands), _buffer->GetParentOffset() + _iboOffset, cmdBuffer);
+	VKUtil::ExecuteOneShotCmdBuffer(cmdBuffer);
 
 	VK_DBG_SET_OBJECT_NAME((uint64_t)_buffer->GetHandle(), VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, *NString::StringWithFormat(40, "Font %s buffer", _resourceInfo->name.c_str()));
 	VK_DBG_SET_OBJECT_NAME((uint64_t)_stagingBuffer->GetHandle(), VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, *NString::StringWithFormat(40, "Font %s staging buffer", _resourceInfo->name.c_str()));
-	VK_DBG_SET_OBJECT_NAME((uint64_t)_image, VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, *NString::StringWithFormat(40, "Font %s image", _resourceInfo->name.c_str()));
-
-	free(mem);
 
 	return ENGINE_OK;
 }
 
+void NFont::_UploadGlyphs(VkCommandBuffer cmdBuffer)
+{
+	const vector<GlyphUpload> &uploads{ _cache.GetPendingUploads() };
+	size_t size{ _cache.GetUploadDataSize() };
+
+	if (uploads.empty())
+		return;
+
+	VkBuffer stagingBuffer{ VK_NULL_HANDLE };
+	VkDeviceSize stagingOffset{ 0 };
+	Buffer *loadBuffer{ nullptr };
+
+	// Text laid out this frame already references the new glyphs, so they cannot wait for the next one
+	uint8_t *data{ Renderer::GetInstance()->AllocateStaging(size, 4, stagingBuffer, stagingOffset, true) };
+	if (!data)
+	{
+		loadBuffer = Renderer::GetInstance()->GetStagingBuffer(size);
+
+		if ((data = loadBuffer->Map(0, size)) == nullptr)
+		{ DIE("Failed to map buffer"); }
+
+		stagingBuffer = loadBuffer->GetHandle();
+		stagingOffset = loadBuffer->GetParentOffset();
+		cmdBuffer = VKUtil::CreateOneShotCmdBuffer();
+	}
+
+	memcpy(data, _cache.GetUploadData(), size);
+
+	vector<VkBufferImageCopy> regions(uploads.size());
+	for (size_t i = 0; i < uploads.size(); ++i)
+	{
+		VkBufferImageCopy &region{ regions[i] };
+		region.bufferOffset = stagingOffset + uploads[i].offset;
+		region.bufferRowLength = uploads[i].width;
+		region.bufferImageHeight = uploads[i].height;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { (int32_t)uploads[i].x, (int32_t)uploads[i].y, 0 };
+		region.imageExtent = { uploads[i].width, uploads[i].height, 1 };
+	}
+
+	VKUtil::TransitionImageLayout(_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, cmdBuffer);
+	vkCmdCopyBufferToImage(cmdBuffer, stagingBuffer, _image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)regions.size(), regions.data());
+	VKUtil::TransitionImageLayout(_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, cmdBuffer);
+
+	if (loadBuffer)
+	{
+		loadBuffer->Unmap();
+		VKUtil::ExecuteOneShotCmdBuffer(cmdBuffer);
+		Renderer::GetInstance()->FreeStagingBuffer(loadBuffer);
+	}
+
+	_cache.ClearPendingUploads();
+}
+
 int NFont::_CreateDescriptorSet()
 {
 	VkDescriptorPoolSize poolSize{};
@@ -449,11 +696,16 @@ int NFont::_BuildCommandBuffer()
 	vkCmdBindVertexBuffers(_cmdBuffer, 0, 1, &_buffer->GetHandle(), &offset);
 	vkCmdBindIndexBuffer(_cmdBuffer, _buffer->GetHandle(), _iboOffset, VK_INDEX_TYPE_UINT32);
 
-	vkCmdBindPipeline(_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipeline(PIPE_Font));
+	vkCmdBindPipeline(_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipeline(_distanceField ? PIPE_Font_SDF : PIPE_Font));
 	GUIManager::BindDescriptorSet(_cmdBuffer);
 	vkCmdBindDescriptorSets(_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipelineLayout(PIPE_LYT_GUI), 1, 1, &_descriptorSet, 0, nullptr);
 
+	if (_distanceField)
+		vkCmdPushConstants(_cmdBuffer, PipelineManager::GetPipelineLayout(PIPE_LYT_GUI), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(FontEffects), &_effects);
+
+	// Persistent runs, then this frame's slice of the dynamic ring
 	vkCmdDrawIndexedIndirect(_cmdBuffer, _buffer->GetHandle(), 0, 1, 0);
+	vkCmdDrawIndexedIndirect(_cmdBuffer, _buffer->GetHandle(), sizeof(VkDrawIndexedIndirectCommand), 1, 0);
 
 	if (vkEndCommandBuffer(_cmdBuffer) != VK_SUCCESS)
 	{
@@ -486,4 +738,18 @@ NFont::~NFont()
 
 	delete _buffer;
 	delete _stagingBuffer;
+	delete _runs;
+
+	if (_face)
+	{
+		FT_Done_Face(_face);
+
+		if (--_ftRefCount == 0)
+		{
+			FT_Done_FreeType(_ft);
+			_ft = nullptr;
+		}
+	}
+
+	free(_fontData);
 }
@@ -0,0 +1,185 @@
+/* NekoEngine
+ *
+ * PipelineBatch.cpp
+ * Author: Alexandru Naiman
+ *
+ * Parallel graphics pipeline creation
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <chrono>
+#include <assert.h>
+
+#include <Engine/Defs.h>
+#include <Engine/TaskManager.h>
+#include <System/Logger.h>
+#include <Renderer/VKUtil.h>
+#include <Renderer/DebugMarker.h>
+#include <Renderer/PipelineBatch.h>
+
+#define PLBATCH_MODULE	"PipelineBatch"
+
+using namespace std;
+using namespace std::chrono;
+
+template<typename T>
+static inline const T *_pb_Copy(const T *src, T &dst)
+{
+	if (!src)
+		return nullptr;
+
+	dst = *src;
+	return &dst;
+}
+
+template<typename T>
+static inline const T *_pb_CopyArray(const T *src, uint32_t count, vector<T> &dst)
+{
+	if (!src || !count)
+		return nullptr;
+
+	dst.assign(src, src + count);
+	return dst.data();
+}
+
+void PipelineBatch::Add(uint8_t id, const char *name, const VkGraphicsPipelineCreateInfo &info)
+{
+	assert(info.stageCount <= PIPELINE_BATCH_MAX_STAGES);
+
+	_entries.emplace_back();
+	PipelineBatchEntry &e{ _entries.back() };
+
+	e.id = id;
+	e.name = name;
+	e.info = info;
+
+	for (uint32_t i = 0; i < info.stageCount; ++i)
+	{
+		const VkSpecializationInfo *spec{ info.pStages[i].pSpecializationInfo };
+
+		e.stages[i] = info.pStages[i];
+
+		if (!spec)
+			continue;
+
+		e.specInfo[i] = *spec;
+		e.specInfo[i].pMapEntries = _pb_CopyArray(spec->pMapEntries, spec->mapEntryCount, e.specMap[i]);
+		e.specInfo[i].pData = _pb_CopyArray((const uint8_t *)spec->pData, (uint32_t)spec->dataSize, e.specData[i]);
+		e.stages[i].pSpecializationInfo = &e.specInfo[i];
+	}
+	e.info.pStages = info.stageCount ? e.stages : nullptr;
+
+	if ((e.info.pVertexInputState = _pb_Copy(info.pVertexInputState, e.vertexInput)) != nullptr)
+	{
+		e.vertexInput.pVertexBindingDescriptions = _pb_CopyArray(e.vertexInput.pVertexBindingDescriptions, e.vertexInput.vertexBindingDescriptionCount, e.bindings);
+		e.vertexInput.pVertexAttributeDescriptions = _pb_CopyArray(e.vertexInput.pVertexAttributeDescriptions, e.vertexInput.vertexAttributeDescriptionCount, e.attributes);
+	}
+
+	e.info.pInputAssemblyState = _pb_Copy(info.pInputAssemblyState, e.inputAssembly);
+	e.info.pTessellationState = _pb_Copy(info.pTessellationState, e.tessellation);
+
+	if ((e.info.pViewportState = _pb_Copy(info.pViewportState, e.viewport)) != nullptr)
+	{
+		e.viewport.pViewports = _pb_CopyArray(e.viewport.pViewports, e.viewport.viewportCount, e.viewports);
+		e.viewport.pScissors = _pb_CopyArray(e.viewport.pScissors, e.viewport.scissorCount, e.scissors);
+	}
+
+	e.info.pRasterizationState = _pb_Copy(info.pRasterizationState, e.rasterization);
+
+	if ((e.info.pMultisampleState = _pb_Copy(info.pMultisampleState, e.multisample)) != nullptr)
+		e.multisample.pSampleMask = _pb_CopyArray(e.multisample.pSampleMask, ((uint32_t)e.multisample.rasterizationSamples + 31) / 32, e.sampleMask);
+
+	e.info.pDepthStencilState = _pb_Copy(info.pDepthStencilState, e.depthStencil);
+
+	if ((e.info.pColorBlendState = _pb_Copy(info.pColorBlendState, e.colorBlend)) != nullptr)
+		e.colorBlend.pAttachments = _pb_CopyArray(e.colorBlend.pAttachments, e.colorBlend.attachmentCount, e.attachments);
+
+	if ((e.info.pDynamicState = _pb_Copy(info.pDynamicState, e.dynamic)) != nullptr)
+		e.dynamic.pDynamicStates = _pb_CopyArray(e.dynamic.pDynamicStates, e.dynamic.dynamicStateCount, e.dynamicStates);
+}
+
+int PipelineBatch::Create(VkPipelineCache cache, unordered_map<uint8_t, VkPipeline> &pipelines)
+{
+	uint32_t count{ (uint32_t)_entries.size() };
+	vector<VkGraphicsPipelineCreateInfo> infos{};
+	vector<VkPipeline> handles(count, VK_NULL_HANDLE);
+	int ret{ ENGINE_OK };
+
+	infos.reserve(count);
+	for (const PipelineBatchEntry &e : _entries)
+		infos.push_back(e.info);
+
+	high_resolution_clock::time_point start{ high_resolution_clock::now() };
+
+	// Compilation time varies a lot between pipelines, so hand them out one at a time.
+	// The device and the cache are internally synchronized.
+	TaskManager::ParallelFor(count, 1, [&infos, &handles, cache](uint32_t begin, uint32_t end) {
+		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), cache, end - begin, &infos[begin], VKUtil::GetAllocator(), &handles[begin]) != VK_SUCCESS)
+		{
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				if (handles[i] != VK_NULL_HANDLE)
+					vkDestroyPipeline(VKUtil::GetDevice(), handles[i], VKUtil::GetAllocator());
+				handles[i] = VK_NULL_HANDLE;
+			}
+		}
+	});
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (handles[i] != VK_NULL_HANDLE)
+			continue;
+
+		Logger::Log(PLBATCH_MODULE, LOG_CRITICAL, "Failed to create pipeline (%s)", _entries[i].name.c_str());
+		ret = ENGINE_PIPELINE_CREATE_FAIL;
+	}
+
+	if (ret != ENGINE_OK)
+	{
+		for (VkPipeline pipeline : handles)
+			if (pipeline != VK_NULL_HANDLE)
+				vkDestroyPipeline(VKUtil::GetDevice(), pipeline, VKUtil::GetAllocator());
+		return ret;
+	}
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		VK_DBG_SET_OBJECT_NAME((uint64_t)handles[i], VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, _entries[i].name.c_str());
+		pipelines.insert(make_pair(_entries[i].id, handles[i]));
+	}
+
+	Logger::Log(PLBATCH_MODULE, LOG_DEBUG, "Created %u pipelines in %.02f ms", count,
+		duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count());
+
+	return ENGINE_OK;
+}
@@ -0,0 +1,123 @@
+/* NekoEngine
+ *
+ * PipelineCache.cpp
+ * Author: Alexandru Naiman
+ *
+ * Persistent Vulkan pipeline cache
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <System/Logger.h>
+#include <Renderer/VKUtil.h>
+#include <Renderer/PipelineCache.h>
+
+#define PLCACHE_MODULE	"PipelineCache"
+
+using namespace std;
+
+PipelineCache::PipelineCache(const VkPhysicalDeviceProperties &properties) :
+	_properties(properties),
+	_cache(VK_NULL_HANDLE)
+{
+}
+
+bool PipelineCache::Load(const char *path)
+{
+	vector<uint8_t> data{};
+	PipelineCacheStatus status{ PIPE_CACHE_Truncated };
+
+	if (path && ReadFile(path, _properties, data, status))
+	{
+		if (status == PIPE_CACHE_Valid && _Create(data.data(), data.size()))
+		{
+			Logger::Log(PLCACHE_MODULE, LOG_INFORMATION, "Loaded %llu bytes from %s", (unsigned long long)data.size(), path);
+			return true;
+		}
+
+		Logger::Log(PLCACHE_MODULE, LOG_WARNING, "Discarding pipeline cache %s: %s", path, GetStatusString(status));
+	}
+
+	return _Create(nullptr, 0);
+}
+
+bool PipelineCache::Save(const char *path)
+{
+	size_t size{ 0 };
+
+	if (_cache == VK_NULL_HANDLE)
+		return false;
+
+	if (vkGetPipelineCacheData(VKUtil::GetDevice(), _cache, &size, nullptr) != VK_SUCCESS || !size)
+		return false;
+
+	vector<uint8_t> data(size);
+	if (vkGetPipelineCacheData(VKUtil::GetDevice(), _cache, &size, data.data()) != VK_SUCCESS)
+	{
+		Logger::Log(PLCACHE_MODULE, LOG_WARNING, "Failed to retrieve the pipeline cache data");
+		return false;
+	}
+
+	if (!WriteFile(path, _properties, data.data(), size))
+		return false;
+
+	Logger::Log(PLCACHE_MODULE, LOG_DEBUG, "Saved %llu bytes to %s", (unsigned long long)size, path);
+	return true;
+}
+
+bool PipelineCache::_Create(const uint8_t *data, size_t size)
+{
+	VkPipelineCacheCreateInfo info{};
+	info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	info.initialDataSize = size;
+	info.pInitialData = data;
+
+	if (vkCreatePipelineCache(VKUtil::GetDevice(), &info, VKUtil::GetAllocator(), &_cache) == VK_SUCCESS)
+		return true;
+
+	_cache = VK_NULL_HANDLE;
+
+	if (!data)
+	{
+		Logger::Log(PLCACHE_MODULE, LOG_WARNING, "Failed to create pipeline cache");
+		return false;
+	}
+
+	// The driver may still refuse data it wrote itself
+	return _Create(nullptr, 0);
+}
+
+PipelineCache::~PipelineCache()
+{
+	if (_cache != VK_NULL_HANDLE)
+		vkDestroyPipelineCache(VKUtil::GetDevice(), _cache, VKUtil::GetAllocator());
+}
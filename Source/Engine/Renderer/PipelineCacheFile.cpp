@@ -0,0 +1,216 @@
+/* NekoEngine
+ *
+ * PipelineCacheFile.cpp
+ * Author: Alexandru Naiman
+ *
+ * Pipeline cache file format
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+
+#include <System/Logger.h>
+#include <Renderer/PipelineCache.h>
+#include <Platform/PlatformDetect.h>
+
+#if defined(NE_PLATFORM_WINDOWS)
+#include <direct.h>
+#define mkdir(path, mode) _mkdir(path)
+#endif
+
+#define PLCACHE_MODULE	"PipelineCache"
+
+using namespace std;
+
+static uint64_t _plc_Hash(const uint8_t *data, size_t size)
+{
+	uint64_t hash{ 14695981039346656037ull };
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+static void _plc_CreateParentDirectory(const char *path)
+{
+	string dir{ path };
+	size_t pos{ dir.find_last_of("/\\") };
+
+	if (pos == string::npos || !pos)
+		return;
+
+	dir.resize(pos);
+	mkdir(dir.c_str(), 0755);
+}
+
+bool PipelineCache::ReadFile(const char *path, const VkPhysicalDeviceProperties &properties, vector<uint8_t> &data, PipelineCacheStatus &status)
+{
+	vector<uint8_t> file{};
+	FILE *fp{ fopen(path, "rb") };
+
+	data.clear();
+	status = PIPE_CACHE_Truncated;
+
+	if (!fp)
+		return false;
+
+	long size{ 0 };
+	if (!fseek(fp, 0, SEEK_END) && (size = ftell(fp)) > 0 && !fseek(fp, 0, SEEK_SET))
+	{
+		file.resize((size_t)size);
+		if (fread(file.data(), 1, file.size(), fp) != file.size())
+			file.clear();
+	}
+
+	fclose(fp);
+
+	if (file.empty())
+		return false;
+
+	if ((status = Validate(file.data(), file.size(), properties)) == PIPE_CACHE_Valid)
+		data.assign(file.begin() + sizeof(PipelineCacheFileHeader), file.end());
+
+	return true;
+}
+
+bool PipelineCache::WriteFile(const char *path, const VkPhysicalDeviceProperties &properties, const uint8_t *data, size_t size)
+{
+	PipelineCacheFileHeader header{};
+	FillHeader(header, properties, data, size);
+
+	FILE *fp{ fopen(path, "wb") };
+	if (!fp)
+	{
+		// The application data directory is not created until something is saved there
+		_plc_CreateParentDirectory(path);
+		fp = fopen(path, "wb");
+	}
+
+	if (!fp)
+	{
+		Logger::Log(PLCACHE_MODULE, LOG_WARNING, "Failed to open %s for writing", path);
+		return false;
+	}
+
+	bool ret{ fwrite(&header, sizeof(header), 1, fp) == 1 && fwrite(data, 1, size, fp) == size };
+	fclose(fp);
+
+	if (!ret)
+		Logger::Log(PLCACHE_MODULE, LOG_WARNING, "Failed to write %s", path);
+
+	return ret;
+}
+
+void PipelineCache::FillHeader(PipelineCacheFileHeader &header, const VkPhysicalDeviceProperties &properties, const uint8_t *data, size_t size)
+{
+	memset(&header, 0x0, sizeof(header));
+
+	header.magic = PIPELINE_CACHE_MAGIC;
+	header.version = PIPELINE_CACHE_VERSION;
+	header.vendorId = properties.vendorID;
+	header.deviceId = properties.deviceID;
+	header.driverVersion = properties.driverVersion;
+	memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+	header.dataSize = size;
+	header.dataHash = _plc_Hash(data, size);
+}
+
+PipelineCacheStatus PipelineCache::Validate(const uint8_t *file, size_t size, const VkPhysicalDeviceProperties &properties)
+{
+	PipelineCacheFileHeader header{};
+
+	if (!file || size < sizeof(header))
+		return PIPE_CACHE_Truncated;
+
+	memcpy(&header, file, sizeof(header));
+
+	if (header.magic != PIPELINE_CACHE_MAGIC)
+		return PIPE_CACHE_BadMagic;
+
+	if (header.version != PIPELINE_CACHE_VERSION)
+		return PIPE_CACHE_VersionMismatch;
+
+	if (header.vendorId != properties.vendorID || header.deviceId != properties.deviceID ||
+		memcmp(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE))
+		return PIPE_CACHE_DeviceMismatch;
+
+	if (header.driverVersion != properties.driverVersion)
+		return PIPE_CACHE_DriverMismatch;
+
+	if (size - sizeof(header) < header.dataSize)
+		return PIPE_CACHE_Truncated;
+
+	const uint8_t *data{ file + sizeof(header) };
+
+	if (size - sizeof(header) != header.dataSize || _plc_Hash(data, (size_t)header.dataSize) != header.dataHash)
+		return PIPE_CACHE_Corrupt;
+
+	// The driver's header (VkPipelineCacheHeaderVersionOne) must agree with ours
+	uint32_t vkHeader[4]{};
+	if (header.dataSize < sizeof(vkHeader) + VK_UUID_SIZE)
+		return PIPE_CACHE_Corrupt;
+
+	memcpy(vkHeader, data, sizeof(vkHeader));
+
+	if (vkHeader[0] < sizeof(vkHeader) + VK_UUID_SIZE || vkHeader[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+		return PIPE_CACHE_Corrupt;
+
+	if (vkHeader[2] != properties.vendorID || vkHeader[3] != properties.deviceID ||
+		memcmp(data + sizeof(vkHeader), properties.pipelineCacheUUID, VK_UUID_SIZE))
+		return PIPE_CACHE_DeviceMismatch;
+
+	return PIPE_CACHE_Valid;
+}
+
+const char *PipelineCache::GetStatusString(PipelineCacheStatus status)
+{
+	switch (status)
+	{
+		case PIPE_CACHE_Valid: return "valid";
+		case PIPE_CACHE_Truncated: return "truncated";
+		case PIPE_CACHE_BadMagic: return "not a pipeline cache";
+		case PIPE_CACHE_VersionMismatch: return "unsupported version";
+		case PIPE_CACHE_DeviceMismatch: return "created on a different device";
+		case PIPE_CACHE_DriverMismatch: return "created by a different driver version";
+		case PIPE_CACHE_Corrupt: return "corrupt";
+	}
+
+	return "unknown";
+}
@@ -42,30 +42,21 @@
 #include <Engine/Vertex.h>
 #include <Engine/Engine.h>
 #include <Engine/ResourceManager.h>
+#include <Platform/Platform.h>
 #include <Renderer/VKUtil.h>
+#include <Renderer/NFont.h>
 #include <Renderer/Material.h>
 #include <Renderer/DebugMarker.h>
+#include <Renderer/PipelineBatch.h>
+#include <Renderer/PipelineCache.h>
 #include <Renderer/PipelineManager.h>
+#include <Renderer/PipelineVariants.h>
 #include <Renderer/RenderPassManager.h>
 
 #include <array>
 
 #define PLMGR_MODULE				"PipelineManager"
-
-#define SH_VTX						0
-#define SH_VTX_NM					1
-
-#define SH_VTX_STATIC				"main"
-#define SH_VTX_ANIM					"anim_main"
-
-#define SH_FRAG_UNLIT				0
-#define SH_FRAG_PHONG				1
-#define SH_FRAG_PHONG_SPEC			2
-#define SH_FRAG_PHONG_SPEC_EM		3
-#define SH_FRAG_PHONG_NM			4
-#define SH_FRAG_PHONG_SPEC_NM		5
-#define SH_FRAG_PHONG_SPEC_EM_NM	6
-#define SH_FRAG_WF					0
+#define PLMGR_MAX_PATH				1024
 
 using namespace std;
 using namespace glm;
@@ -86,6 +77,8 @@ enum ShaderId : uint8_t
 	SH_Vertex_Billboard,
 	SH_Vertex_Bounds,
 	SH_Vertex_Fullscreen,
+	SH_Vertex_Instanced,
+	SH_Vertex_Depth_Instanced,
 	SH_Geometry_Billboard,
 	SH_Fragment_Phong,
 	SH_Fragment_Depth,
@@ -105,11 +98,46 @@ enum ShaderId : uint8_t
 unordered_map<uint8_t, VkPipeline> PipelineManager::_pipelines;
 unordered_map<uint8_t, VkPipelineLayout> PipelineManager::_pipelineLayouts;
 unordered_map<uint8_t, VkDescriptorSetLayout> PipelineManager::_descriptorSetLayouts;
+bool PipelineManager::_instancing{ false };
 static unordered_map<uint8_t, ShaderModule *> _shaderModules;
 static unordered_map<uint8_t, VkPipeline> _shaderInfo;
+static PipelineCache *_pipelineCache{ nullptr };
 
 static const int _guiFragShader = 0;
 static const int _fontFragShader = 1;
+static const int _fontSDFFragShader = 2;
+
+static bool _plmgr_GetCachePath(char *path, uint32_t size)
+{
+	if (Platform::GetSpecialDirectoryPath(SpecialDirectory::ApplicationData, path, size) != ENGINE_OK)
+		return false;
+
+	size_t len{ strlen(path) };
+	return snprintf(path + len, size - len, "/%s", PIPELINE_CACHE_FILE) < (int)(size - len);
+}
+
+static void _plmgr_LoadCache()
+{
+	char path[PLMGR_MAX_PATH]{};
+	VkPhysicalDeviceProperties properties{};
+
+	vkGetPhysicalDeviceProperties(VKUtil::GetPhysicalDevice(), &properties);
+	_pipelineCache = new PipelineCache(properties);
+
+	// Without a cache file the pipelines are still created, only slower
+	if (!_plmgr_GetCachePath(path, PLMGR_MAX_PATH))
+		path[0] = 0x0;
+
+	_pipelineCache->Load(path[0] ? path : nullptr);
+}
+
+static void _plmgr_SaveCache()
+{
+	char path[PLMGR_MAX_PATH]{};
+
+	if (_pipelineCache && _plmgr_GetCachePath(path, PLMGR_MAX_PATH))
+		_pipelineCache->Save(path);
+}
 
 int PipelineManager::Initialize()
 {
@@ -124,6 +152,8 @@ int PipelineManager::Initialize()
 	if ((ret = _CreatePipelineLayouts()) != ENGINE_OK)
 		return ret;
 
+	_plmgr_LoadCache();
+
 	if ((ret = _CreatePipelines()) != ENGINE_OK)
 		return ret;
 
@@ -139,6 +169,9 @@ int PipelineManager::Initialize()
 	if ((ret = _CreateComputePipelines()) != ENGINE_OK)
 		return ret;
 
+	// Saved right away as well, a crash later on should not cost the next start
+	_plmgr_SaveCache();
+
 	return ENGINE_OK;
 }
 
@@ -219,6 +252,19 @@ int PipelineManager::_LoadShaders()
 		return ENGINE_FAIL;
 	_shaderModules.insert(make_pair(SH_Vertex_Fullscreen, module));
 
+	// Optional; without them every draw is recorded on its own
+	ShaderModule *depthModule{ (ShaderModule *)ResourceManager::GetResourceByName("sh_depth_instanced_vertex", ResourceType::RES_SHADERMODULE) };
+	if ((module = (ShaderModule *)ResourceManager::GetResourceByName("sh_instanced_vertex", ResourceType::RES_SHADERMODULE)) != nullptr && depthModule)
+	{
+		_shaderModules.insert(make_pair(SH_Vertex_Instanced, module));
+		_shaderModules.insert(make_pair(SH_Vertex_Depth_Instanced, depthModule));
+		_instancing = true;
+	}
+	else
+	{
+		Logger::Log(PLMGR_MODULE, LOG_WARNING, "Instanced vertex shaders not found, instancing disabled");
+	}
+
 	// Geometry shaders
 
 	if ((module = (ShaderModule *)ResourceManager::GetResourceByName("sh_billboard_geometry", ResourceType::RES_SHADERMODULE)) == nullptr)
@@ -265,6 +311,8 @@ int PipelineManager::_LoadShaders()
 int PipelineManager::_CreatePipelines()
 {
 	VkPipeline pipeline{ VK_NULL_HANDLE };
+	VkPipelineCache cache{ _pipelineCache ? _pipelineCache->GetHandle() : VK_NULL_HANDLE };
+	PipelineBatch batch{};
 
 	VkSpecializationMapEntry int0MapEntry{};
 	int0MapEntry.constantID = 0;
@@ -315,10 +363,13 @@ int PipelineManager::_CreatePipelines()
 	VkPipelineShaderStageCreateInfo depthVertShaderStageInfo{};
 	VkPipelineShaderStageCreateInfo depthAnimVertShaderStageInfo{};
 	VkPipelineShaderStageCreateInfo depthTerrainVertShaderStageInfo{};
+	VkPipelineShaderStageCreateInfo instancedVertShaderStageInfo{};
+	VkPipelineShaderStageCreateInfo depthInstancedVertShaderStageInfo{};
 	VkPipelineShaderStageCreateInfo depthFragShaderStageInfo{};
 	VkPipelineShaderStageCreateInfo guiVertShaderStageInfo{};
 	VkPipelineShaderStageCreateInfo guiFragShaderStageInfo{};
 	VkPipelineShaderStageCreateInfo fontFragShaderStageInfo{};
+	VkPipelineShaderStageCreateInfo fontSDFFragShaderStageInfo{};
 	VkPipelineShaderStageCreateInfo shadowVertShaderStageInfo{};
 	VkPipelineShaderStageCreateInfo shadowAnimVertShaderStageInfo{};
 	VkPipelineShaderStageCreateInfo shadowTerrainVertShaderStageInfo{};
@@ -333,6 +384,7 @@ int PipelineManager::_CreatePipelines()
 	VkSpecializationInfo fragShaderSpecInfo{};
 	VkSpecializationInfo guiSpecInfo{};
 	VkSpecializationInfo fontSpecInfo{};
+	VkSpecializationInfo fontSDFSpecInfo{};
 	{
 		// Specialization info
 		vtxShaderSpecInfo.mapEntryCount = sizeof(vtxShaderSpecMap) / sizeof(VkSpecializationMapEntry);
@@ -355,6 +407,11 @@ int PipelineManager::_CreatePipelines()
 		fontSpecInfo.dataSize = sizeof(_fontFragShader);
 		fontSpecInfo.pData = &_fontFragShader;
 
+		fontSDFSpecInfo.mapEntryCount = 1;
+		fontSDFSpecInfo.pMapEntries = &int0MapEntry;
+		fontSDFSpecInfo.dataSize = sizeof(_fontSDFFragShader);
+		fontSDFSpecInfo.pData = &_fontSDFFragShader;
+
 		// Vertex
 		VKUtil::InitShaderStage(&vertShaderStageInfo, VK_SHADER_STAGE_VERTEX_BIT, _shaderModules[SH_Vertex]->GetHandle(), &vtxShaderSpecInfo);
 		VKUtil::InitShaderStage(&animVertShaderStageInfo, VK_SHADER_STAGE_VERTEX_BIT, _shaderModules[SH_Vertex_Anim]->GetHandle(), &vtxShaderSpecInfo);
@@ -371,6 +428,12 @@ int PipelineManager::_CreatePipelines()
 		VKUtil::InitShaderStage(&billboardVertShaderStageInfo, VK_SHADER_STAGE_VERTEX_BIT, _shaderModules[SH_Vertex_Billboard]->GetHandle());
 		VKUtil::InitShaderStage(&boundsVertShaderStageInfo, VK_SHADER_STAGE_VERTEX_BIT, _shaderModules[SH_Vertex_Bounds]->GetHandle());
 
+		if (_instancing)
+		{
+			VKUtil::InitShaderStage(&instancedVertShaderStageInfo, VK_SHADER_STAGE_VERTEX_BIT, _shaderModules[SH_Vertex_Instanced]->GetHandle(), &vtxShaderSpecInfo);
+			VKUtil::InitShaderStage(&depthInstancedVertShaderStageInfo, VK_SHADER_STAGE_VERTEX_BIT, _shaderModules[SH_Vertex_Depth_Instanced]->GetHandle(), &vtxShaderSpecInfo);
+		}
+
 		// Geometry
 		VKUtil::InitShaderStage(&billboardGeomShaderStageInfo, VK_SHADER_STAGE_GEOMETRY_BIT, _shaderModules[SH_Geometry_Billboard]->GetHandle());
 
@@ -380,6 +443,7 @@ int PipelineManager::_CreatePipelines()
 		VKUtil::InitShaderStage(&depthFragShaderStageInfo, VK_SHADER_STAGE_FRAGMENT_BIT, _shaderModules[SH_Fragment_Depth]->GetHandle(), &fragShaderSpecInfo);
 		VKUtil::InitShaderStage(&guiFragShaderStageInfo, VK_SHADER_STAGE_FRAGMENT_BIT, _shaderModules[SH_Fragment_GUI]->GetHandle(), &guiSpecInfo);
 		VKUtil::InitShaderStage(&fontFragShaderStageInfo, VK_SHADER_STAGE_FRAGMENT_BIT, _shaderModules[SH_Fragment_GUI]->GetHandle(), &fontSpecInfo);
+		VKUtil::InitShaderStage(&fontSDFFragShaderStageInfo, VK_SHADER_STAGE_FRAGMENT_BIT, _shaderModules[SH_Fragment_GUI]->GetHandle(), &fontSDFSpecInfo);
 		VKUtil::InitShaderStage(&shadowFragShaderStageInfo, VK_SHADER_STAGE_FRAGMENT_BIT, _shaderModules[SH_Fragment_Shadow]->GetHandle());		
 		VKUtil::InitShaderStage(&shadowFilterShaderStageInfo, VK_SHADER_STAGE_FRAGMENT_BIT, _shaderModules[SH_Fragment_ShadowFilter]->GetHandle());
 		VKUtil::InitShaderStage(&billboardFragShaderStageInfo, VK_SHADER_STAGE_FRAGMENT_BIT, _shaderModules[SH_Fragment_Billboard]->GetHandle());
@@ -474,223 +538,65 @@ int PipelineManager::_CreatePipelines()
 		pipelineInfo.basePipelineIndex = -1;
 	}
 
-	//*******************
-	//* Static pipelines
-	//*******************
+	//*********************
+	//* Material pipelines
+	//*********************
 
-	// Opaque
 	{
-		// Unlit
-		VkPipelineShaderStageCreateInfo shaderStages[]{ vertShaderStageInfo, fragShaderStageInfo };
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = shaderStages;
+		vector<PipelineVariant> variants{};
+		uint32_t count{ 0 };
+		const MaterialPipelineDesc *table{ PipelineVariants::GetMaterialTable(count) };
 
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_UNLIT;
-		shaderSpecData.frag.numTextures = 1;
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
+		if (PipelineVariants::Expand(table, count, variants) != ENGINE_OK)
 		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create unlit pipeline");
+			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Invalid material pipeline table");
 			return ENGINE_FAIL;
 		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "unlit");
-		_pipelines.insert(make_pair(PIPE_Unlit, pipeline));
-
-		// All the other pipelines are derivatives
-		pipelineInfo.flags = VK_PIPELINE_CREATE_DERIVATIVE_BIT;
-		pipelineInfo.basePipelineHandle = pipeline;
 
-		// Phong
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_PHONG;
-		shaderSpecData.frag.numTextures = 1;
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create phong pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "phong");
-		_pipelines.insert(make_pair(PIPE_Phong, pipeline));
-
-		// Phong with specular
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC;
-		shaderSpecData.frag.numTextures = 2;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_TwoSamplers];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "phong specular");
-		_pipelines.insert(make_pair(PIPE_PhongSpecular, pipeline));
-
-		// Phong with specular and emission
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC_EM;
-		shaderSpecData.frag.numTextures = 3;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_ThreeSamplers];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "phong specular emissive");
-		_pipelines.insert(make_pair(PIPE_PhongSpecularEmissive, pipeline));
-
-		// Phong with normal map
-		shaderSpecData.vtx.type = SH_VTX_NM;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_NM;
-		shaderSpecData.frag.numTextures = 1;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_OneSampler];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "phong normal");
-		_pipelines.insert(make_pair(PIPE_PhongNormal, pipeline));
-
-		// Phong with specular and normal
-		shaderSpecData.vtx.type = SH_VTX_NM;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC_NM;
-		shaderSpecData.frag.numTextures = 2;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_TwoSamplers];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "phong normal specular");
-		_pipelines.insert(make_pair(PIPE_PhongNormalSpecular, pipeline));
-
-		// Phong with specular, normal and emission
-		shaderSpecData.vtx.type = SH_VTX_NM;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC_EM_NM;
-		shaderSpecData.frag.numTextures = 3;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_ThreeSamplers];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "phong normal specular emissive");
-		_pipelines.insert(make_pair(PIPE_PhongNormalSpecularEmissive, pipeline));
-	}
-
-	// Transparent
-	{
-		pipelineInfo.pColorBlendState = &transparentColorBlending;
-		pipelineInfo.pDepthStencilState = &transparentDepthStencil;
-
-		// Unlit
-		VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+		VkPipelineShaderStageCreateInfo shaderStages[]{ vertShaderStageInfo, fragShaderStageInfo };
 		pipelineInfo.stageCount = 2;
 		pipelineInfo.pStages = shaderStages;
 
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_UNLIT;
-		shaderSpecData.frag.numTextures = 1;
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
+		for (const PipelineVariant &variant : variants)
 		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create unlit pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent unlit");
-		_pipelines.insert(make_pair(PIPE_Transparent_Unlit, pipeline));
+			bool animated{ (variant.flags & PIPE_VAR_Animated) != 0 };
+			bool transparent{ (variant.flags & PIPE_VAR_Transparent) != 0 };
+			bool instanced{ (variant.flags & PIPE_VAR_Instanced) != 0 };
 
-		// Phong
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_PHONG;
-		shaderSpecData.frag.numTextures = 1;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_OneSampler];
+			if (instanced && !_instancing)
+				continue;
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create phong pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent phong");
-		_pipelines.insert(make_pair(PIPE_Transparent_Phong, pipeline));
+			shaderStages[0] = animated ? animVertShaderStageInfo : (instanced ? instancedVertShaderStageInfo : vertShaderStageInfo);
+			pipelineInfo.pVertexInputState = animated ? &animVertexInputInfo : &vertexInputInfo;
+			pipelineInfo.pColorBlendState = transparent ? &transparentColorBlending : &colorBlending;
+			pipelineInfo.pDepthStencilState = transparent ? &transparentDepthStencil : &depthStencil;
+			pipelineInfo.layout = _pipelineLayouts[variant.layout];
 
-		// Phong with specular
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC;
-		shaderSpecData.frag.numTextures = 2;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_TwoSamplers];
+			shaderSpecData.vtx.type = variant.vertexType;
+			shaderSpecData.frag.type = variant.fragmentType;
+			shaderSpecData.frag.numTextures = variant.numTextures;
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent phong specular");
-		_pipelines.insert(make_pair(PIPE_Transparent_PhongSpecular, pipeline));
-
-		// Phong with specular and emission
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC_EM;
-		shaderSpecData.frag.numTextures = 3;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_ThreeSamplers];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent phong specular emissive");
-		_pipelines.insert(make_pair(PIPE_Transparent_PhongSpecularEmissive, pipeline));
-
-		// Phong with normal map
-		shaderSpecData.vtx.type = SH_VTX_NM;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_NM;
-		shaderSpecData.frag.numTextures = 1;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_OneSampler];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent phong normal");
-		_pipelines.insert(make_pair(PIPE_Transparent_PhongNormal, pipeline));
-
-		// Phong with specular and normal
-		shaderSpecData.vtx.type = SH_VTX_NM;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC_NM;
-		shaderSpecData.frag.numTextures = 2;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_TwoSamplers];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent phong normal specular");
-		_pipelines.insert(make_pair(PIPE_Transparent_PhongNormalSpecular, pipeline));
+			if (variant.id != PIPE_Unlit)
+			{
+				batch.Add(variant.id, variant.name, pipelineInfo);
+				continue;
+			}
 
-		// Phong with specular, normal and emission
-		shaderSpecData.vtx.type = SH_VTX_NM;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC_EM_NM;
-		shaderSpecData.frag.numTextures = 3;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_ThreeSamplers];
+			if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), cache, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
+			{
+				Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create unlit pipeline");
+				return ENGINE_FAIL;
+			}
+			VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, variant.name);
+			_pipelines.insert(make_pair(PIPE_Unlit, pipeline));
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
+			// All the other pipelines are derivatives
+			pipelineInfo.flags = VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+			pipelineInfo.basePipelineHandle = pipeline;
 		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent phong normal specular emissive");
-		_pipelines.insert(make_pair(PIPE_Transparent_PhongNormalSpecularEmissive, pipeline));
 
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		pipelineInfo.pColorBlendState = &colorBlending;
 		pipelineInfo.pDepthStencilState = &depthStencil;
 	}
 
@@ -726,13 +632,7 @@ int PipelineManager::_CreatePipelines()
 		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Debug];		
 		pipelineInfo.renderPass = RenderPassManager::GetRenderPass(RP_GUI);
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create bounds pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "Bounds (DEBUG)");
-		_pipelines.insert(make_pair(PIPE_Bounds, pipeline));
+		batch.Add(PIPE_Bounds, "Bounds (DEBUG)", pipelineInfo);
 
 		/*VkPipelineVertexInputStateCreateInfo empty{};
 		VKUtil::InitVertexInput(&empty);
@@ -760,226 +660,6 @@ int PipelineManager::_CreatePipelines()
 		pipelineInfo.pDepthStencilState = oldDSCI;
 	}
 
-	//*********************
-	//* Animated pipelines
-	//*********************
-
-	// Opaque
-	{
-		pipelineInfo.pColorBlendState = &colorBlending;
-		pipelineInfo.pVertexInputState = &animVertexInputInfo;
-
-		// Unlit
-		VkPipelineShaderStageCreateInfo shaderStages[] = { animVertShaderStageInfo, fragShaderStageInfo };
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = shaderStages;
-
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_UNLIT;
-		shaderSpecData.frag.numTextures = 1;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Anim_OneSampler];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated unlit pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "animated unlit");
-		_pipelines.insert(make_pair(PIPE_Anim_Unlit, pipeline));
-
-		// Phong
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_PHONG;
-		shaderSpecData.frag.numTextures = 1;
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated phong pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "animated phong");
-		_pipelines.insert(make_pair(PIPE_Anim_Phong, pipeline));
-
-		// Phong with specular
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC;
-		shaderSpecData.frag.numTextures = 2;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Anim_TwoSamplers];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated phong specular pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "animated phong specular");
-		_pipelines.insert(make_pair(PIPE_Anim_PhongSpecular, pipeline));
-
-		// Phong with specular and emission
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC_EM;
-		shaderSpecData.frag.numTextures = 3;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Anim_ThreeSamplers];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated phong specular emissive pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "animated phong specular emissive");
-		_pipelines.insert(make_pair(PIPE_Anim_PhongSpecularEmissive, pipeline));
-
-		// Phong with normal map
-		shaderSpecData.vtx.type = SH_VTX_NM;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_NM;
-		shaderSpecData.frag.numTextures = 1;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Anim_OneSampler];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "animated phong normal");
-		_pipelines.insert(make_pair(PIPE_Anim_PhongNormal, pipeline));
-
-		// Phong with specular and normal
-		shaderSpecData.vtx.type = SH_VTX_NM;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC_NM;
-		shaderSpecData.frag.numTextures = 2;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Anim_TwoSamplers];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "animated phong normal specular");
-		_pipelines.insert(make_pair(PIPE_Anim_PhongNormalSpecular, pipeline));
-
-		// Phong with specular, normal and emission
-		shaderSpecData.vtx.type = SH_VTX_NM;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC_EM_NM;
-		shaderSpecData.frag.numTextures = 3;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Anim_ThreeSamplers];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "animated phong normal specular emissive");
-		_pipelines.insert(make_pair(PIPE_Anim_PhongNormalSpecularEmissive, pipeline));
-	}
-
-	// Transparent
-	{
-		pipelineInfo.pColorBlendState = &transparentColorBlending;
-		pipelineInfo.pDepthStencilState = &transparentDepthStencil;
-
-		// Unlit
-		VkPipelineShaderStageCreateInfo shaderStages[] = { animVertShaderStageInfo, fragShaderStageInfo };
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = shaderStages;
-
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_UNLIT;
-		shaderSpecData.frag.numTextures = 1;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Anim_OneSampler];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated unlit pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent animated unlit");
-		_pipelines.insert(make_pair(PIPE_Transparent_Anim_Unlit, pipeline));
-
-		// Phong
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_PHONG;
-		shaderSpecData.frag.numTextures = 1;
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated phong pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent animated phong");
-		_pipelines.insert(make_pair(PIPE_Transparent_Anim_Phong, pipeline));
-
-		// Phong with specular
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC;
-		shaderSpecData.frag.numTextures = 2;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Anim_TwoSamplers];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated phong specular pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent animated phong specular");
-		_pipelines.insert(make_pair(PIPE_Transparent_Anim_PhongSpecular, pipeline));
-
-		// Phong with specular and emission
-		shaderSpecData.vtx.type = SH_VTX;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC_EM;
-		shaderSpecData.frag.numTextures = 3;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Anim_ThreeSamplers];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated phong specular emissive pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent animated phong specular emissive");
-		_pipelines.insert(make_pair(PIPE_Transparent_Anim_PhongSpecularEmissive, pipeline));
-
-		// Phong with normal map
-		shaderSpecData.vtx.type = SH_VTX_NM;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_NM;
-		shaderSpecData.frag.numTextures = 1;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Anim_OneSampler];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent animated phong normal");
-		_pipelines.insert(make_pair(PIPE_Transparent_Anim_PhongNormal, pipeline));
-
-		// Phong with specular and normal
-		shaderSpecData.vtx.type = SH_VTX_NM;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC_NM;
-		shaderSpecData.frag.numTextures = 2;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Anim_TwoSamplers];
-	
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent animated phong normal specular");
-		_pipelines.insert(make_pair(PIPE_Transparent_Anim_PhongNormalSpecular, pipeline));
-
-		// Phong with specular, normal and emission
-		shaderSpecData.vtx.type = SH_VTX_NM;
-		shaderSpecData.frag.type = SH_FRAG_PHONG_SPEC_EM_NM;
-		shaderSpecData.frag.numTextures = 3;
-		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Anim_ThreeSamplers];
-
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create animated pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "transparent animated phong normal specular emissive");
-		_pipelines.insert(make_pair(PIPE_Transparent_Anim_PhongNormalSpecularEmissive, pipeline));
-
-		pipelineInfo.pDepthStencilState = &depthStencil;
-	}
-
 	//*********************
 	//* Skysphere pipeline
 	//*********************
@@ -994,13 +674,7 @@ int PipelineManager::_CreatePipelines()
 		pipelineInfo.pStages = skyShaderStages;
 
 		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_OneSampler];
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "skysphere");
-		_pipelines.insert(make_pair(PIPE_Skysphere, pipeline));
+		batch.Add(PIPE_Skysphere, "skysphere", pipelineInfo);
 
 		depthStencil.depthTestEnable = VK_TRUE;
 	}
@@ -1022,13 +696,7 @@ int PipelineManager::_CreatePipelines()
 		
 		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_OneSampler];
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create terrain pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "terrain");
-		_pipelines.insert(make_pair(PIPE_Terrain, pipeline));
+		batch.Add(PIPE_Terrain, "terrain", pipelineInfo);
 	}
 
 	//***************************
@@ -1055,24 +723,29 @@ int PipelineManager::_CreatePipelines()
 		shaderSpecData.vtx.type = SH_VTX;
 		shaderSpecData.frag.type = SH_VTX;
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "depth");
-		_pipelines.insert(make_pair(PIPE_Depth, pipeline));
+		batch.Add(PIPE_Depth, "depth", pipelineInfo);
 
 		shaderSpecData.vtx.type = SH_VTX_NM;
 		shaderSpecData.frag.type = SH_VTX_NM;
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
+		batch.Add(PIPE_DepthNormal, "normal mapped depth", pipelineInfo);
+
+		if (_instancing)
 		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
+			VkPipelineShaderStageCreateInfo depthInstancedShaderStages[]{ depthInstancedVertShaderStageInfo, depthFragShaderStageInfo };
+			pipelineInfo.pStages = depthInstancedShaderStages;
+			pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Instanced_Depth];
+
+			shaderSpecData.vtx.type = SH_VTX;
+			shaderSpecData.frag.type = SH_VTX;
+
+			batch.Add(PIPE_Instanced_Depth, "instanced depth", pipelineInfo);
+
+			shaderSpecData.vtx.type = SH_VTX_NM;
+			shaderSpecData.frag.type = SH_VTX_NM;
+
+			batch.Add(PIPE_Instanced_DepthNormal, "normal mapped instanced depth", pipelineInfo);
 		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "normal mapped depth");
-		_pipelines.insert(make_pair(PIPE_DepthNormal, pipeline));
 
 		VkPipelineShaderStageCreateInfo depthAnimShaderStages[]{ depthAnimVertShaderStageInfo, depthFragShaderStageInfo };
 		pipelineInfo.pStages = depthAnimShaderStages;
@@ -1083,24 +756,12 @@ int PipelineManager::_CreatePipelines()
 		shaderSpecData.vtx.type = SH_VTX;
 		shaderSpecData.frag.type = SH_VTX;
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "animated depth");
-		_pipelines.insert(make_pair(PIPE_Anim_Depth, pipeline));
+		batch.Add(PIPE_Anim_Depth, "animated depth", pipelineInfo);
 
 		shaderSpecData.vtx.type = SH_VTX_NM;
 		shaderSpecData.frag.type = SH_VTX_NM;
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "normal mapped animated depth");
-		_pipelines.insert(make_pair(PIPE_Anim_DepthNormal, pipeline));
+		batch.Add(PIPE_Anim_DepthNormal, "normal mapped animated depth", pipelineInfo);
 
 		VkPipelineShaderStageCreateInfo depthTerrainShaderStages[]{ depthTerrainVertShaderStageInfo, depthFragShaderStageInfo };
 		pipelineInfo.pStages = depthTerrainShaderStages;
@@ -1111,13 +772,7 @@ int PipelineManager::_CreatePipelines()
 		shaderSpecData.vtx.type = SH_VTX;
 		shaderSpecData.frag.type = SH_VTX;
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "terrain depth");
-		_pipelines.insert(make_pair(PIPE_Terrain_Depth, pipeline));
+		batch.Add(PIPE_Terrain_Depth, "terrain depth", pipelineInfo);
 	}
 	
 	//*******************
@@ -1181,38 +836,20 @@ int PipelineManager::_CreatePipelines()
 		rasterizer.cullMode = VK_CULL_MODE_NONE;
 
 		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Shadow];
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "shadow");
-		_pipelines.insert(make_pair(PIPE_Shadow, pipeline));
+		batch.Add(PIPE_Shadow, "shadow", pipelineInfo);
 
 		shadowShaderStages[0] = shadowAnimVertShaderStageInfo;
 		pipelineInfo.pVertexInputState = &animVertexInputInfo;
 
 		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Anim_Shadow];
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "animated shadow");
-		_pipelines.insert(make_pair(PIPE_Anim_Shadow, pipeline));
+		batch.Add(PIPE_Anim_Shadow, "animated shadow", pipelineInfo);
 
 		shadowShaderStages[0] = shadowTerrainVertShaderStageInfo;
 
 		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_Shadow];
 		pipelineInfo.pVertexInputState = &terrainVertexInputInfo;
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "terrain shadow");
-		_pipelines.insert(make_pair(PIPE_Terrain_Shadow, pipeline));
+		batch.Add(PIPE_Terrain_Shadow, "terrain shadow", pipelineInfo);
 
 		rasterizer.depthBiasEnable = VK_FALSE;
 		smDepthStencil.depthTestEnable = VK_FALSE;
@@ -1224,13 +861,7 @@ int PipelineManager::_CreatePipelines()
 		pipelineInfo.pVertexInputState = &smFilterVertexInputInfo;
 		pipelineInfo.renderPass = RenderPassManager::GetRenderPass(RP_ShadowFilter);
 		
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "shadow filter");
-		_pipelines.insert(make_pair(PIPE_ShadowFilter, pipeline));
+		batch.Add(PIPE_ShadowFilter, "shadow filter", pipelineInfo);
 
 		viewportState.pViewports = &viewport;
 		viewportState.pScissors = &scissor;
@@ -1279,13 +910,7 @@ int PipelineManager::_CreatePipelines()
 		pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_GUI];
 		pipelineInfo.pStages = guiShaderStages;
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "gui");
-		_pipelines.insert(make_pair(PIPE_GUI, pipeline));
+		batch.Add(PIPE_GUI, "gui", pipelineInfo);
 
 		// Font
 
@@ -1293,13 +918,13 @@ int PipelineManager::_CreatePipelines()
 
 		pipelineInfo.pStages = fontShaderStages;
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "font");
-		_pipelines.insert(make_pair(PIPE_Font, pipeline));
+		batch.Add(PIPE_Font, "font", pipelineInfo);
+
+		VkPipelineShaderStageCreateInfo fontSDFShaderStages[] = { guiVertShaderStageInfo, fontSDFFragShaderStageInfo };
+
+		pipelineInfo.pStages = fontSDFShaderStages;
+
+		batch.Add(PIPE_Font_SDF, "font sdf", pipelineInfo);
 	}
 
 	//************************
@@ -1356,20 +981,14 @@ int PipelineManager::_CreatePipelines()
 		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
 		depthStencil.depthWriteEnable = VK_TRUE;
 
-		if (vkCreateGraphicsPipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
-		{
-			Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline (particle system draw)");
-			return ENGINE_FAIL;
-		}
-		VK_DBG_SET_OBJECT_NAME((uint64_t)pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "particle system draw");
-		_pipelines.insert(make_pair(PIPE_ParticleDraw, pipeline));
+		batch.Add(PIPE_ParticleDraw, "particle system draw", pipelineInfo);
 
 		depthStencil.depthWriteEnable = VK_FALSE;
 		depthStencil.depthCompareOp = VK_COMPARE_OP_EQUAL;
 		rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
 	}
 
-	return ENGINE_OK;
+	return batch.Create(cache, _pipelines);
 }
 
 int PipelineManager::_CreatePipelineLayouts()
@@ -1498,6 +1117,38 @@ int PipelineManager::_CreatePipelineLayouts()
 		_pipelineLayouts.insert(make_pair(PIPE_LYT_Anim_Depth, layout));
 	}
 
+	// Instanced; the object set holds the instance array instead of a single block
+	{
+		const struct
+		{
+			PipelineLayoutId id;
+			DescriptorLayoutId samplers;
+			const char *name;
+		} instancedLayouts[]
+		{
+			{ PIPE_LYT_Instanced_OneSampler, DESC_LYT_OneSampler, "instanced one sampler" },
+			{ PIPE_LYT_Instanced_TwoSamplers, DESC_LYT_TwoSamplers, "instanced two samplers" },
+			{ PIPE_LYT_Instanced_ThreeSamplers, DESC_LYT_ThreeSamplers, "instanced three samplers" },
+			{ PIPE_LYT_Instanced_FourSamplers, DESC_LYT_FourSamplers, "instanced four samplers" },
+			{ PIPE_LYT_Instanced_Depth, DESC_LYT_OneSampler, "instanced depth" }
+		};
+
+		pipelineLayoutInfo.setLayoutCount = 3;
+
+		for (const auto &info : instancedLayouts)
+		{
+			VkDescriptorSetLayout layouts[]{ _descriptorSetLayouts[DESC_LYT_Scene], _descriptorSetLayouts[DESC_LYT_Instances], _descriptorSetLayouts[info.samplers] };
+			pipelineLayoutInfo.pSetLayouts = layouts;
+			if (vkCreatePipelineLayout(VKUtil::GetDevice(), &pipelineLayoutInfo, VKUtil::GetAllocator(), &layout) != VK_SUCCESS)
+			{
+				Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline layout (%s)", info.name);
+				return ENGINE_PIPELINE_LYT_CREATE_FAIL;
+			}
+			VK_DBG_SET_OBJECT_NAME((uint64_t)layout, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_LAYOUT_EXT, info.name);
+			_pipelineLayouts.insert(make_pair(info.id, layout));
+		}
+	}
+
 	//*****************
 	//* Debug pipeline
 	//*****************
@@ -1526,7 +1177,14 @@ int PipelineManager::_CreatePipelineLayouts()
 	VkDescriptorSetLayout guiLayouts[]{ _descriptorSetLayouts[DESC_LYT_Object], _descriptorSetLayouts[DESC_LYT_OneSampler] };
 	pipelineLayoutInfo.pSetLayouts = guiLayouts;
 	pipelineLayoutInfo.setLayoutCount = 2;
-	pipelineLayoutInfo.pushConstantRangeCount = 0;
+
+	VkPushConstantRange fontRange{};
+	fontRange.offset = 0;
+	fontRange.size = sizeof(FontEffects);
+	fontRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &fontRange;
 	if (vkCreatePipelineLayout(VKUtil::GetDevice(), &pipelineLayoutInfo, VKUtil::GetAllocator(), &layout) != VK_SUCCESS)
 	{
 		Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create pipeline layout (gui)");
@@ -1769,6 +1427,24 @@ int PipelineManager::_CreateDescriptorSetLayouts()
 	VK_DBG_SET_OBJECT_NAME((uint64_t)dsl, VK_DEBUG_REPORT_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT_EXT, "bones");
 	_descriptorSetLayouts.insert(make_pair(DESC_LYT_Anim_Object, dsl));
 
+	VkDescriptorSetLayoutBinding instanceBlockBinding{};
+	instanceBlockBinding.binding = 0;
+	instanceBlockBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	instanceBlockBinding.descriptorCount = 1;
+	instanceBlockBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	instanceBlockBinding.pImmutableSamplers = nullptr;
+
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &instanceBlockBinding;
+
+	if (vkCreateDescriptorSetLayout(VKUtil::GetDevice(), &layoutInfo, VKUtil::GetAllocator(), &dsl) != VK_SUCCESS)
+	{
+		Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create descriptor set layout (instances)");
+		return ENGINE_DESCRIPTOR_SET_LYT_CREATE_FAIL;
+	}
+	VK_DBG_SET_OBJECT_NAME((uint64_t)dsl, VK_DEBUG_REPORT_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT_EXT, "instances");
+	_descriptorSetLayouts.insert(make_pair(DESC_LYT_Instances, dsl));
+
 	//*************************
 	//* 3. Sampler descriptors
 	//*************************
@@ -1946,6 +1622,7 @@ int PipelineManager::_LoadComputeShaders()
 int PipelineManager::_CreateComputePipelines()
 {
 	VkPipeline pipeline{};
+	VkPipelineCache cache{ _pipelineCache ? _pipelineCache->GetHandle() : VK_NULL_HANDLE };
 
 	VkComputePipelineCreateInfo pipelineInfo{};
 	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
@@ -1957,7 +1634,7 @@ int PipelineManager::_CreateComputePipelines()
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	if (vkCreateComputePipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
+	if (vkCreateComputePipelines(VKUtil::GetDevice(), cache, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
 	{
 		Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create compute pipeline");
 		return ENGINE_PIPELINE_CREATE_FAIL;
@@ -1969,7 +1646,7 @@ int PipelineManager::_CreateComputePipelines()
 	pipelineInfo.layout = _pipelineLayouts[PIPE_LYT_ParticleCompute];
 	pipelineInfo.flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
 
-	if (vkCreateComputePipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
+	if (vkCreateComputePipelines(VKUtil::GetDevice(), cache, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
 	{
 		Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create compute pipeline (particle update)");
 		return ENGINE_PIPELINE_CREATE_FAIL;
@@ -1981,7 +1658,7 @@ int PipelineManager::_CreateComputePipelines()
 	pipelineInfo.flags = VK_PIPELINE_CREATE_DERIVATIVE_BIT;
 	pipelineInfo.stage.module = _shaderModules[SH_Compute_ParticleSort]->GetHandle();
 
-	if (vkCreateComputePipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
+	if (vkCreateComputePipelines(VKUtil::GetDevice(), cache, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
 	{
 		Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create compute pipeline (particle sort)");
 		return ENGINE_PIPELINE_CREATE_FAIL;
@@ -1991,7 +1668,7 @@ int PipelineManager::_CreateComputePipelines()
 
 	pipelineInfo.stage.module = _shaderModules[SH_Compute_ParticleEmit]->GetHandle();
 
-	if (vkCreateComputePipelines(VKUtil::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
+	if (vkCreateComputePipelines(VKUtil::GetDevice(), cache, 1, &pipelineInfo, VKUtil::GetAllocator(), &pipeline) != VK_SUCCESS)
 	{
 		Logger::Log(PLMGR_MODULE, LOG_CRITICAL, "Failed to create compute pipeline (particle emit)");
 		return ENGINE_PIPELINE_CREATE_FAIL;
@@ -2139,6 +1816,10 @@ void PipelineManager::Release()
 {
 	_DestroyPipelines();
 
+	_plmgr_SaveCache();
+	delete _pipelineCache;
+	_pipelineCache = nullptr;
+
 	for (pair<uint8_t, VkPipelineLayout> kvp : _pipelineLayouts)
 		vkDestroyPipelineLayout(VKUtil::GetDevice(), kvp.second, VKUtil::GetAllocator());
 	_pipelineLayouts.clear();
@@ -2146,4 +1827,6 @@ void PipelineManager::Release()
 	for (pair<uint8_t, VkDescriptorSetLayout> kvp : _descriptorSetLayouts)
 		vkDestroyDescriptorSetLayout(VKUtil::GetDevice(), kvp.second, VKUtil::GetAllocator());
 	_descriptorSetLayouts.clear();
+
+	_instancing = false;
 }
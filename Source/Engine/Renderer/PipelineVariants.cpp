@@ -0,0 +1,122 @@
+/* NekoEngine
+ *
+ * PipelineVariants.cpp
+ * Author: Alexandru Naiman
+ *
+ * Table driven material pipeline variants
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+
+#include <Engine/Defs.h>
+#include <Renderer/PipelineVariants.h>
+
+using namespace std;
+
+static const MaterialPipelineDesc _materialPipelines[]
+{
+	{ PIPE_Unlit, "unlit", SH_VTX, SH_FRAG_UNLIT, 1 },
+	{ PIPE_Phong, "phong", SH_VTX, SH_FRAG_PHONG, 1 },
+	{ PIPE_PhongSpecular, "phong specular", SH_VTX, SH_FRAG_PHONG_SPEC, 2 },
+	{ PIPE_PhongSpecularEmissive, "phong specular emissive", SH_VTX, SH_FRAG_PHONG_SPEC_EM, 3 },
+	{ PIPE_PhongNormal, "phong normal", SH_VTX_NM, SH_FRAG_PHONG_NM, 1 },
+	{ PIPE_PhongNormalSpecular, "phong normal specular", SH_VTX_NM, SH_FRAG_PHONG_SPEC_NM, 2 },
+	{ PIPE_PhongNormalSpecularEmissive, "phong normal specular emissive", SH_VTX_NM, SH_FRAG_PHONG_SPEC_EM_NM, 3 }
+};
+
+static const uint8_t _variantFlags[]
+{
+	0,
+	PIPE_VAR_Transparent,
+	PIPE_VAR_Animated,
+	PIPE_VAR_Animated | PIPE_VAR_Transparent,
+	PIPE_VAR_Instanced
+};
+
+const MaterialPipelineDesc *PipelineVariants::GetMaterialTable(uint32_t &count) noexcept
+{
+	count = sizeof(_materialPipelines) / sizeof(MaterialPipelineDesc);
+	return _materialPipelines;
+}
+
+int PipelineVariants::Expand(const MaterialPipelineDesc *table, uint32_t count, vector<PipelineVariant> &variants)
+{
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		// Static opaque ids leave room for the animated and transparent offsets
+		if (table[i].id >= PIPE_VAR_ANIM_OFFSET || table[i].numTextures < 1 || table[i].numTextures > 4)
+			return ENGINE_INVALID_ARGS;
+	}
+
+	variants.reserve(variants.size() + count * sizeof(_variantFlags));
+
+	for (uint8_t flags : _variantFlags)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			PipelineVariant variant{};
+			uint32_t id{ table[i].id };
+			uint32_t layout{ (uint32_t)PIPE_LYT_OneSampler + table[i].numTextures - 1 };
+
+			if (flags & PIPE_VAR_Animated)
+			{
+				id += PIPE_VAR_ANIM_OFFSET;
+				layout += PIPE_LYT_Anim_OneSampler - PIPE_LYT_OneSampler;
+			}
+
+			if (flags & PIPE_VAR_Transparent)
+				id += PIPE_VAR_TRANSPARENT_OFFSET;
+
+			if (flags & PIPE_VAR_Instanced)
+			{
+				id += PIPE_VAR_INSTANCED_OFFSET;
+				layout += PIPE_LYT_Instanced_OneSampler - PIPE_LYT_OneSampler;
+			}
+
+			variant.id = (PipelineId)id;
+			variant.layout = (PipelineLayoutId)layout;
+			variant.flags = flags;
+			variant.vertexType = table[i].vertexType;
+			variant.fragmentType = table[i].fragmentType;
+			variant.numTextures = table[i].numTextures;
+
+			snprintf(variant.name, PIPE_VAR_MAX_NAME, "%s%s%s%s", (flags & PIPE_VAR_Transparent) ? "transparent " : "",
+				(flags & PIPE_VAR_Animated) ? "animated " : "", (flags & PIPE_VAR_Instanced) ? "instanced " : "", table[i].name);
+
+			variants.push_back(variant);
+		}
+	}
+
+	return ENGINE_OK;
+}
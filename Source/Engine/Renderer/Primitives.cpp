@@ -391,6 +391,25 @@ void Primitives::DrawPrimitive(PrimitiveID primitive, VkCommandBuffer commandBuf
 	vkCmdDrawIndexed(commandBuffer, _numIndices[(uint8_t)primitive], 1, _indexOffsets[(uint8_t)primitive], 0, 0);
 }
 
+void Primitives::DrawPrimitiveIndirect(PrimitiveID primitive, VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset)
+{
+	VkBuffer buffers[]{ _primitiveBuffer->GetHandle() };
+	VkDeviceSize offsets[]{ 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+	vkCmdBindIndexBuffer(commandBuffer, buffers[0], _indexBufferOffset, VK_INDEX_TYPE_UINT16);
+	vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset, 1, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+uint32_t Primitives::GetIndexCount(PrimitiveID primitive)
+{
+	return _numIndices[(uint8_t)primitive];
+}
+
+uint32_t Primitives::GetFirstIndex(PrimitiveID primitive)
+{
+	return _indexOffsets[(uint8_t)primitive];
+}
+
 void Primitives::Release()
 {
 	delete _primitiveBuffer;
@@ -0,0 +1,177 @@
+/* NekoEngine
+ *
+ * RenderQueue.cpp
+ * Author: Alexandru Naiman
+ *
+ * Render Queue
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <Renderer/RenderQueue.h>
+
+using namespace std;
+
+static inline bool _rq_CanMerge(const Drawable *a, const Drawable *b) noexcept
+{
+	return a->instanceData && b->instanceData &&
+		a->instancedSceneCommandBuffer != VK_NULL_HANDLE && b->instancedSceneCommandBuffer != VK_NULL_HANDLE &&
+		(a->instancedDepthCommandBuffer == VK_NULL_HANDLE) == (b->instancedDepthCommandBuffer == VK_NULL_HANDLE) &&
+		a->transparent == b->transparent && a->pipeline == b->pipeline &&
+		a->material == b->material && a->mesh == b->mesh && a->group == b->group;
+}
+
+uint64_t RenderQueue::MakeKey(RenderQueuePass pass, uint8_t pipeline, uint32_t material, uint32_t mesh, float depth) noexcept
+{
+	// The bit pattern of a positive float grows with its value, so it can be sorted as an integer
+	uint32_t bits{ 0 };
+	if (depth > 0.f)
+		memcpy(&bits, &depth, sizeof(bits));
+
+	uint64_t key{ (uint64_t)pass << RQ_PASS_SHIFT };
+
+	// The hashes are mixed down to their top bits, so those are the ones kept
+	if (pass == RQ_PASS_Transparent)
+	{
+		key |= (uint64_t)((~bits >> 1) & 0x3FFFFFFF) << 32;
+		key |= (uint64_t)pipeline << 24;
+		key |= (uint64_t)(material >> 20) << 12;
+		key |= (uint64_t)(mesh >> 20);
+	}
+	else
+	{
+		key |= (uint64_t)pipeline << 54;
+		key |= (uint64_t)(material >> (32 - RQ_IDENTITY_BITS)) << (RQ_DEPTH_BITS + RQ_IDENTITY_BITS);
+		key |= (uint64_t)(mesh >> (32 - RQ_IDENTITY_BITS)) << RQ_DEPTH_BITS;
+		key |= (uint64_t)(bits >> (32 - RQ_DEPTH_BITS - 1)) & ((1 << RQ_DEPTH_BITS) - 1);
+	}
+
+	return key;
+}
+
+uint32_t RenderQueue::HashIdentity(const void *ptr, uint32_t group) noexcept
+{
+	uint64_t v{ (uint64_t)(uintptr_t)ptr ^ ((uint64_t)group * 0x9E3779B97F4A7C15ull) };
+	v ^= v >> 33;
+	v *= 0xFF51AFD7ED558CCDull;
+	v ^= v >> 33;
+	v *= 0xC4CEB9FE1A85EC53ull;
+	v ^= v >> 33;
+	return (uint32_t)(v >> 32);
+}
+
+RenderQueueItem *RenderQueue::RadixSort(RenderQueueItem *items, RenderQueueItem *scratch, size_t count) noexcept
+{
+	uint32_t hist[RQ_RADIX_PASSES][RQ_RADIX_BUCKETS];
+	memset(hist, 0x0, sizeof(hist));
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint64_t key{ items[i].key };
+		for (uint32_t p = 0; p < RQ_RADIX_PASSES; ++p)
+			++hist[p][(key >> (p * RQ_RADIX_BITS)) & (RQ_RADIX_BUCKETS - 1)];
+	}
+
+	RenderQueueItem *src{ items }, *dst{ scratch };
+
+	for (uint32_t p = 0; p < RQ_RADIX_PASSES; ++p)
+	{
+		uint32_t shift{ p * RQ_RADIX_BITS };
+		uint32_t *h{ hist[p] };
+
+		if (!count || h[(src[0].key >> shift) & (RQ_RADIX_BUCKETS - 1)] == count)
+			continue;
+
+		uint32_t offset{ 0 };
+		for (uint32_t b = 0; b < RQ_RADIX_BUCKETS; ++b)
+		{
+			uint32_t c{ h[b] };
+			h[b] = offset;
+			offset += c;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+			dst[h[(src[i].key >> shift) & (RQ_RADIX_BUCKETS - 1)]++] = src[i];
+
+		RenderQueueItem *tmp{ src };
+		src = dst;
+		dst = tmp;
+	}
+
+	return src;
+}
+
+void RenderQueue::Clear() noexcept
+{
+	_drawables.clear();
+	_items.clear();
+}
+
+void RenderQueue::Add(Drawable *drawable, float depth)
+{
+	RenderQueuePass pass{ drawable->transparent ? RQ_PASS_Transparent : RQ_PASS_Opaque };
+	uint64_t key{ MakeKey(pass, drawable->pipeline, HashIdentity(drawable->material), HashIdentity(drawable->mesh, drawable->group), depth) };
+
+	_items.push_back({ key, (uint32_t)_drawables.size() });
+	_drawables.push_back(drawable);
+}
+
+void RenderQueue::Build()
+{
+	size_t count{ _items.size() };
+
+	_scratch.resize(count);
+	_sorted.resize(count);
+	_instanceData.resize(count);
+	_batches.clear();
+
+	if (!count)
+		return;
+
+	RenderQueueItem *sorted{ RadixSort(_items.data(), _scratch.data(), count) };
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		Drawable *drawable{ _drawables[sorted[i].index] };
+
+		_sorted[i] = drawable;
+		_instanceData[i] = drawable->instanceData;
+
+		// The key only holds part of the state hashes, so merging compares the state itself
+		if (i && _rq_CanMerge(_sorted[i - 1], drawable))
+			++_batches.back().count;
+		else
+			_batches.push_back({ (uint32_t)i, 1 });
+	}
+}
@@ -46,16 +46,21 @@
 #include <Renderer/Renderer.h>
 #include <Renderer/Swapchain.h>
 #include <Renderer/Primitives.h>
+#include <Renderer/StagingRing.h>
 #include <Renderer/DebugMarker.h>
 #include <Renderer/PostProcessor.h>
+#include <Renderer/MemoryAllocator.h>
 #include <Renderer/ShadowRenderer.h>
+#include <Renderer/InstanceManager.h>
 #include <Renderer/PipelineManager.h>
 #include <Renderer/RenderPassManager.h>
 #include <Engine/Engine.h>
 #include <Engine/Version.h>
+#include <Engine/EventManager.h>
 #include <Profiler/Profiler.h>
 #include <Scene/SceneManager.h>
 #include <Scene/CameraManager.h>
+#include <Animation/AnimationManager.h>
 
 #define RENDERER_MODULE "VulkanRenderer"
 
@@ -99,7 +104,17 @@ void Renderer::Release()
 Renderer::Renderer()
 {
 	_buffer = nullptr;
-	_stagingBuffer = nullptr;
+	_stagingRing = _loadStaging = nullptr;
+	_stagingRingBuffer = _loadStagingBuffer = nullptr;
+	_stagingRingData = nullptr;
+	_loadStagingCount = 0;
+	_uploadFrame = 0;
+	_multiDrawIndirect = false;
+	for (uint32_t i = 0; i < STAGING_RING_FRAMES; ++i)
+	{
+		_uploadFences[i] = VK_NULL_HANDLE;
+		_uploadFrames[i] = 0;
+	}
 
 	_instance = VK_NULL_HANDLE;
 	_device = VK_NULL_HANDLE;
@@ -111,6 +126,7 @@ Renderer::Renderer()
 	_debugCB = VK_NULL_HANDLE;
 	memset(&_swapchainInfo, 0x0, sizeof(SwapchainInfo));
 	_swapchain = nullptr;
+	_memoryAllocator = nullptr;
 
 	_colorTarget = _depthTarget = nullptr;
 	_msaaColorTarget = nullptr;
@@ -180,6 +196,12 @@ int Renderer::Initialize(PlatformWindowType window, bool enableValidation, bool
 
 	VKUtil::Initialize(_device, _physicalDevice, _graphicsQueue, _graphicsCommandPool, _computeQueue, _computeCommandPool, _allocator);
 
+	if ((_memoryAllocator = new MemoryAllocator(new VKMemoryDevice())) == nullptr)
+		return ENGINE_OUT_OF_RESOURCES;
+
+	if (!_CreateStagingRing())
+		return ENGINE_OUT_OF_RESOURCES;
+
 	uint8_t blankTexture[4]{ 255, 255, 255, 255 };
 
 	_blankTexture = new Texture(1, 1, 1, VK_FORMAT_R8G8B8A8_UINT, sizeof(uint8_t) * 4, blankTexture);
@@ -290,6 +312,14 @@ int Renderer::Initialize(PlatformWindowType window, bool enableValidation, bool
 	for (uint32_t i = 0; i < _swapchain->GetImageCount(); ++i)
 		VKUtil::TransitionImageLayout(_swapchain->GetImage(i), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 
+	EventManager::RegisterHandler(NE_EVT_RES_RELOADING, [this](int32_t eventId, void *eventData) {
+		WaitIdle();
+	});
+
+	EventManager::RegisterHandler(NE_EVT_RES_RELOADED, [this](int32_t eventId, void *eventData) {
+		_ResourcesReloaded(*(NArray<Resource *> *)eventData);
+	});
+
 	Logger::Log(RENDERER_MODULE, LOG_INFORMATION, "Initialized");
 
 	return ENGINE_OK;
@@ -299,28 +329,72 @@ bool Renderer::_CreateBuffer()
 {
 	VkDeviceSize bufferSize{ sizeof(SceneData) + (sizeof(Light) * Engine::GetConfiguration().Renderer.MaxLights) + (_numTiles * Engine::GetConfiguration().Renderer.MaxLights * sizeof(int32_t)) };
 
-	_stagingBuffer = new Buffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, nullptr, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 	_buffer = new Buffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
 		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, nullptr, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 	VK_DBG_SET_OBJECT_NAME((uint64_t)_buffer->GetHandle(), VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Scene data buffer");
-	VK_DBG_SET_OBJECT_NAME((uint64_t)_stagingBuffer->GetHandle(), VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Scene data staging buffer");
 	VK_DBG_SET_OBJECT_NAME((uint64_t)_buffer->GetMemoryHandle(), VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_MEMORY_EXT, "Scene data buffer memory");
-	VK_DBG_SET_OBJECT_NAME((uint64_t)_stagingBuffer->GetMemoryHandle(), VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_MEMORY_EXT, "Scene data staging buffer memory");
 
 	_sceneData.view = mat4();
 	_sceneData.projection = mat4();
 	_sceneData.screenSize = ivec2(Engine::GetScreenWidth(), Engine::GetScreenHeight());
 	_sceneData.gamma = Engine::GetConfiguration().Renderer.Gamma;
 
-	uint8_t *ptr = _stagingBuffer->Map();
+	Buffer *stagingBuffer{ GetStagingBuffer(bufferSize) };
+
+	uint8_t *ptr = stagingBuffer->Map();
 	{
 		memcpy(ptr, &_sceneData, sizeof(SceneData));
 		memcpy(ptr + sizeof(SceneData), _lights, sizeof(Light) * Engine::GetConfiguration().Renderer.MaxLights);
 	}
-	_stagingBuffer->Unmap();
+	stagingBuffer->Unmap();
+
+	stagingBuffer->Copy(_buffer, bufferSize);
+
+	FreeStagingBuffer(stagingBuffer);
+
+	return true;
+}
+
+bool Renderer::_CreateStagingRing()
+{
+	if ((_stagingRingBuffer = new Buffer(STAGING_RING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, nullptr, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) == nullptr)
+		return false;
+
+	VK_DBG_SET_OBJECT_NAME((uint64_t)_stagingRingBuffer->GetHandle(), VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Staging ring");
+
+	if ((_stagingRingData = _stagingRingBuffer->Map()) == nullptr)
+	{
+		Logger::Log(RENDERER_MODULE, LOG_CRITICAL, "Failed to map the staging ring");
+		return false;
+	}
+
+	// Each frame gets an equal share, so a burst of uploads cannot stall the frames behind it.
+	// Part of the share is kept for the per frame data, which is not budgeted.
+	if ((_stagingRing = new StagingRing(STAGING_RING_SIZE, STAGING_RING_SIZE / STAGING_RING_FRAMES - STAGING_RING_FRAME_DATA)) == nullptr)
+		return false;
+
+	// Synchronous loads complete before they return, so they need no fences, only their own space
+	if ((_loadStagingBuffer = new Buffer(STAGING_LOAD_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, nullptr, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) == nullptr)
+		return false;
+
+	VK_DBG_SET_OBJECT_NAME((uint64_t)_loadStagingBuffer->GetHandle(), VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Load staging buffer");
+
+	if ((_loadStaging = new StagingRing(STAGING_LOAD_SIZE, STAGING_LOAD_SIZE)) == nullptr)
+		return false;
 
-	VKUtil::CopyBuffer(_stagingBuffer->GetHandle(), _buffer->GetHandle(), bufferSize, 0, 0);
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+	for (uint32_t i = 0; i < STAGING_RING_FRAMES; ++i)
+	{
+		if (vkCreateFence(_device, &fenceInfo, _allocator, &_uploadFences[i]) != VK_SUCCESS)
+		{
+			Logger::Log(RENDERER_MODULE, LOG_CRITICAL, "Failed to create upload fence");
+			return false;
+		}
+	}
 
 	return true;
 }
@@ -478,6 +552,15 @@ Buffer *Renderer::GetTemporaryBuffer(VkDeviceSize size)
 
 Buffer *Renderer::GetStagingBuffer(VkDeviceSize size)
 {
+	VkDeviceSize offset{ 0 };
+
+	if (_loadStaging->Allocate(size, STAGING_RING_ALIGNMENT, offset))
+	{
+		++_loadStagingCount;
+		return new Buffer(_loadStagingBuffer, offset, size);
+	}
+
+	// Larger than what is left of the load staging area
 	Buffer *ret{ new Buffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, nullptr, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) };
 	VK_DBG_SET_OBJECT_NAME((uint64_t)ret->GetHandle(), VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Staging buffer");
 	VK_DBG_SET_OBJECT_NAME((uint64_t)ret->GetMemoryHandle(), VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_MEMORY_EXT, "Staging buffer memory");
@@ -486,9 +569,165 @@ Buffer *Renderer::GetStagingBuffer(VkDeviceSize size)
 
 void Renderer::FreeStagingBuffer(Buffer *stagingBuffer)
 {
+	// The copy has completed, so the space can be reused right away
+	if (stagingBuffer->GetHandle() == _loadStagingBuffer->GetHandle() && !--_loadStagingCount)
+		_loadStaging->Reclaim(_loadStaging->GetFrame());
+	else if (stagingBuffer->GetHandle() == _loadStagingBuffer->GetHandle())
+		_loadStaging->Release(stagingBuffer->GetParentOffset(), stagingBuffer->GetSize());
+
 	delete stagingBuffer;
 }
 
+uint8_t *Renderer::AllocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkBuffer &buffer, VkDeviceSize &offset, bool frameData)
+{
+	if (!_stagingRing->Allocate(size, alignment > STAGING_RING_ALIGNMENT ? alignment : STAGING_RING_ALIGNMENT, offset, !frameData))
+		return nullptr;
+
+	buffer = _stagingRingBuffer->GetHandle();
+	return _stagingRingData + offset;
+}
+
+void Renderer::UploadBuffer(Buffer *dst, VkDeviceSize offset, const uint8_t *data, VkDeviceSize size, VkCommandBuffer cmdBuffer)
+{
+	VkDeviceSize copied{ 0 };
+
+	// Uploads queued for the same buffer must land first
+	bool queued{ false };
+	for (const PendingUpload &upload : _pendingUploads)
+		if ((queued = upload.dst == dst))
+			break;
+
+	if (!queued)
+		copied = _StageCopy(dst, offset, data, size, cmdBuffer);
+
+	if (copied == size)
+		return;
+
+	_pendingUploads.push_back({ dst, offset + copied, vector<uint8_t>(data + copied, data + size) });
+}
+
+void Renderer::UploadFrameData(Buffer *dst, VkDeviceSize offset, const uint8_t *data, VkDeviceSize size, VkCommandBuffer cmdBuffer)
+{
+	if (!size)
+		return;
+
+	const VkDeviceSize end{ offset + size };
+
+	// Queued uploads hold older contents; drop the part this write covers so they cannot land on top of it
+	for (size_t i = 0; i < _pendingUploads.size(); ++i)
+	{
+		PendingUpload &upload{ _pendingUploads[i] };
+		const VkDeviceSize uploadEnd{ upload.offset + upload.data.size() };
+
+		if (upload.dst != dst || uploadEnd <= offset || upload.offset >= end)
+			continue;
+
+		if (upload.offset < offset && uploadEnd > end)
+		{
+			PendingUpload tail{ dst, end, vector<uint8_t>(upload.data.end() - (uploadEnd - end), upload.data.end()) };
+			upload.data.resize(offset - upload.offset);
+			_pendingUploads.insert(_pendingUploads.begin() + i + 1, std::move(tail));
+			++i;
+		}
+		else if (upload.offset < offset)
+		{
+			upload.data.resize(offset - upload.offset);
+		}
+		else if (uploadEnd > end)
+		{
+			upload.data.erase(upload.data.begin(), upload.data.begin() + (end - upload.offset));
+			upload.offset = end;
+		}
+		else
+		{
+			_pendingUploads.erase(_pendingUploads.begin() + i--);
+		}
+	}
+
+	VkBufferCopy region{};
+	if (_stagingRing->Allocate(size, STAGING_RING_ALIGNMENT, region.srcOffset, false))
+	{
+		memcpy(_stagingRingData + region.srcOffset, data, size);
+
+		region.dstOffset = dst->GetParentOffset() + offset;
+		region.size = size;
+		vkCmdCopyBuffer(cmdBuffer, _stagingRingBuffer->GetHandle(), dst->GetHandle(), 1, &region);
+
+		return;
+	}
+
+	// The ring is full of frames in flight; inline updates are limited to 64 KB each, but stay in this frame
+	for (VkDeviceSize done = 0; done < size; done += 65536)
+		vkCmdUpdateBuffer(cmdBuffer, dst->GetHandle(), dst->GetParentOffset() + offset + done, std::min<VkDeviceSize>(size - done, 65536), data + done);
+}
+
+void Renderer::CancelUploads(Buffer *dst)
+{
+	if (_pendingUploads.empty())
+		return;
+
+	_pendingUploads.erase(remove_if(_pendingUploads.begin(), _pendingUploads.end(), [dst](const PendingUpload &upload) {
+		return upload.dst == dst;
+	}), _pendingUploads.end());
+}
+
+VkDeviceSize Renderer::_StageCopy(Buffer *dst, VkDeviceSize offset, const uint8_t *data, VkDeviceSize size, VkCommandBuffer cmdBuffer)
+{
+	VkDeviceSize chunk{ std::min(size, _stagingRing->GetAvailable(STAGING_RING_ALIGNMENT)) };
+	VkBufferCopy region{};
+
+	// vkCmdCopyBuffer has no alignment requirements, but keep the split on a 16 byte boundary
+	if (chunk < size)
+		chunk &= ~(VkDeviceSize)15;
+
+	if (!chunk || !_stagingRing->Allocate(chunk, STAGING_RING_ALIGNMENT, region.srcOffset))
+		return 0;
+
+	memcpy(_stagingRingData + region.srcOffset, data, chunk);
+
+	region.dstOffset = dst->GetParentOffset() + offset;
+	region.size = chunk;
+	vkCmdCopyBuffer(cmdBuffer, _stagingRingBuffer->GetHandle(), dst->GetHandle(), 1, &region);
+
+	return chunk;
+}
+
+VkCommandBuffer Renderer::_BeginUploadFrame()
+{
+	uint32_t slot{ (uint32_t)(++_uploadFrame % STAGING_RING_FRAMES) };
+
+	// Uploads complete in submission order, so this fence also covers every earlier frame
+	vkWaitForFences(_device, 1, &_uploadFences[slot], VK_TRUE, UINT64_MAX);
+	vkResetFences(_device, 1, &_uploadFences[slot]);
+
+	_stagingRing->Reclaim(_uploadFrames[slot]);
+	_stagingRing->BeginFrame(_uploadFrame);
+	_uploadFrames[slot] = _uploadFrame;
+
+	return _updateCommandBuffers[slot];
+}
+
+void Renderer::_FlushPendingUploads(VkCommandBuffer cmdBuffer)
+{
+	size_t done{ 0 };
+
+	for (PendingUpload &upload : _pendingUploads)
+	{
+		VkDeviceSize copied{ _StageCopy(upload.dst, upload.offset, upload.data.data(), upload.data.size(), cmdBuffer) };
+
+		if (copied < upload.data.size())
+		{
+			upload.offset += copied;
+			upload.data.erase(upload.data.begin(), upload.data.begin() + copied);
+			break;
+		}
+
+		++done;
+	}
+
+	_pendingUploads.erase(_pendingUploads.begin(), _pendingUploads.begin() + done);
+}
+
 int32_t Renderer::AllocLight()
 {
 	if (_sceneData.lightCount == Engine::GetConfiguration().Renderer.MaxLights)
@@ -519,34 +758,43 @@ void Renderer::Update(double deltaTime)
 	_sceneData.screenSize = ivec2(Engine::GetScreenWidth(), Engine::GetScreenHeight());
 	_sceneData.gamma = Engine::GetConfiguration().Renderer.Gamma;
 
+	VkCommandBuffer updateBuffer{ _BeginUploadFrame() };
+
 	VkCommandBufferBeginInfo beginInfo{};
 	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(updateBuffer, &beginInfo);
 
-	vkBeginCommandBuffer(_updateCommandBuffers[_currentBufferIndex], &beginInfo);
+	VK_DBG_MARKER_BEGIN(updateBuffer, "Update data", vec4(0.83, 0.63, 0.56, 1.0));
 
-	VK_DBG_MARKER_BEGIN(_updateCommandBuffers[_currentBufferIndex], "Update data", vec4(0.83, 0.63, 0.56, 1.0));
+	// The previous frames may still read the buffers written below
+	vkCmdPipelineBarrier(updateBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
 
-	VK_DBG_MARKER_INSERT(_updateCommandBuffers[_currentBufferIndex], "Update objects", vec4(0.83, 0.73, 0.56, 1.0));
+	_FlushPendingUploads(updateBuffer);
+
+	VK_DBG_MARKER_INSERT(updateBuffer, "Update objects", vec4(0.83, 0.73, 0.56, 1.0));
 
 	if (SceneManager::IsSceneLoaded())
-		SceneManager::GetActiveScene()->UpdateData(_updateCommandBuffers[_currentBufferIndex]);
+		SceneManager::GetActiveScene()->UpdateData(updateBuffer);
 
-	uint8_t *ptr = _stagingBuffer->Map();
-	{
-		memcpy(ptr, &_sceneData, sizeof(SceneData));
-		memcpy(ptr + sizeof(SceneData), _lights, sizeof(Light) * Engine::GetConfiguration().Renderer.MaxLights);
-	}
-	_stagingBuffer->Unmap();
+	VK_DBG_MARKER_INSERT(updateBuffer, "Update instances", vec4(0.83, 0.73, 0.56, 1.0));
+
+	InstanceManager::UpdateData(updateBuffer);
+
+	VK_DBG_MARKER_INSERT(updateBuffer, "Update bone palette", vec4(0.83, 0.73, 0.56, 1.0));
 
-	VK_DBG_MARKER_INSERT(_updateCommandBuffers[_currentBufferIndex], "Update scene", vec4(0.83, 0.73, 0.56, 1.0));
+	AnimationManager::UpdateData(updateBuffer);
 
-	VKUtil::CopyBuffer(_stagingBuffer->GetHandle(), _buffer->GetHandle(), sizeof(SceneData) + sizeof(Light) * _sceneData.lightCount, 0, 0, _updateCommandBuffers[_currentBufferIndex]);
+	VK_DBG_MARKER_INSERT(updateBuffer, "Update scene", vec4(0.83, 0.73, 0.56, 1.0));
 
-	VK_DBG_MARKER_INSERT(_updateCommandBuffers[_currentBufferIndex], "Update GUI", vec4(0.83, 0.73, 0.56, 1.0));
+	UploadFrameData(_buffer, 0, (uint8_t *)&_sceneData, sizeof(SceneData), updateBuffer);
+	UploadFrameData(_buffer, sizeof(SceneData), (uint8_t *)_lights, sizeof(Light) * _sceneData.lightCount, updateBuffer);
+
+	VK_DBG_MARKER_INSERT(updateBuffer, "Update GUI", vec4(0.83, 0.73, 0.56, 1.0));
 
 	if (Engine::GetConfiguration().Renderer.SSAO.Enable)
-		SSAO::UpdateData(_updateCommandBuffers[_currentBufferIndex]);
+		SSAO::UpdateData(updateBuffer);
 
 	PROF_END();
 
@@ -554,14 +802,29 @@ void Renderer::Update(double deltaTime)
 		PROF_DRAW();
 
 	//GUIManager::DrawString(vec2(300, 300), vec3(1.f), "Visible objects: %d", _secondarySceneCommandBuffers.Count());
-	GUIManager::UpdateData(_updateCommandBuffers[_currentBufferIndex]);
+	GUIManager::UpdateData(updateBuffer);
 
-	ShadowRenderer::UpdateData(_updateCommandBuffers[_currentBufferIndex]);
+	ShadowRenderer::UpdateData(updateBuffer);
 	
-	VK_DBG_MARKER_END(_updateCommandBuffers[_currentBufferIndex]);
-	vkEndCommandBuffer(_updateCommandBuffers[_currentBufferIndex]);
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+		VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+	vkCmdPipelineBarrier(updateBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
 
-	VKUtil::ExecuteCommandBuffer(_updateCommandBuffers[_currentBufferIndex]);
+	VK_DBG_MARKER_END(updateBuffer);
+	vkEndCommandBuffer(updateBuffer);
+
+	// No wait here; the fence is checked when the staging space of this frame is needed again
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &updateBuffer;
+
+	if (vkQueueSubmit(_graphicsQueue, 1, &submitInfo, _uploadFences[_uploadFrame % STAGING_RING_FRAMES]) != VK_SUCCESS)
+	{ DIE("Failed to submit update command buffer"); }
 }
 
 void Renderer::Draw()
@@ -822,6 +1085,23 @@ void Renderer::_RecreateSwapchain()
 	vkDeviceWaitIdle(_device);
 }
 
+void Renderer::_ResourcesReloaded(NArray<Resource *> &resources)
+{
+	bool shaders{ false }, materials{ false };
+
+	for (Resource *res : resources)
+	{
+		shaders |= res->GetResourceInfo()->type == ResourceType::RES_SHADERMODULE;
+		materials |= res->GetResourceInfo()->type == ResourceType::RES_MATERIAL;
+	}
+
+	// Every pipeline is created again, the same as after a resize
+	if (shaders)
+		_RecreateSwapchain();
+	else if (materials && SceneManager::GetActiveScene() && !SceneManager::GetActiveScene()->RebuildCommandBuffers())
+		Logger::Log(RENDERER_MODULE, LOG_CRITICAL, "Failed to rebuild command buffers after reloading materials");
+}
+
 bool _checkValidationLayerSupport()
 {
 	uint32_t layerCount{ 0 };
@@ -1088,6 +1368,10 @@ bool Renderer::_CreateDevice(bool enableValidation, bool debug)
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
+	VkPhysicalDeviceFeatures supportedFeatures{};
+	vkGetPhysicalDeviceFeatures(_physicalDevice, &supportedFeatures);
+	_multiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+
 	VkPhysicalDeviceFeatures deviceFeatures{};
 	deviceFeatures.independentBlend = VK_TRUE;
 	deviceFeatures.depthBounds = VK_TRUE;
@@ -1096,6 +1380,7 @@ bool Renderer::_CreateDevice(bool enableValidation, bool debug)
 	deviceFeatures.samplerAnisotropy = VK_TRUE;
 	deviceFeatures.textureCompressionBC = VK_TRUE;
 	deviceFeatures.fullDrawIndexUint32 = VK_TRUE;
+	deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
 
 	VkPhysicalDeviceProperties properties{};
 	vkGetPhysicalDeviceProperties(_physicalDevice, &properties);
@@ -2045,9 +2330,18 @@ Renderer::~Renderer()
 
 	delete _temporaryBuffer;
 	delete _buffer;
-	delete _stagingBuffer;
 	delete _blankTexture;
 
+	for (uint32_t i = 0; i < STAGING_RING_FRAMES; ++i)
+		if (_uploadFences[i] != VK_NULL_HANDLE)
+			vkDestroyFence(_device, _uploadFences[i], _allocator);
+
+	_pendingUploads.clear();
+	delete _stagingRing;
+	delete _stagingRingBuffer;
+	delete _loadStaging;
+	delete _loadStagingBuffer;
+
 	vkDestroySemaphore(_device, _imageAvailableSemaphore, _allocator);
 	vkDestroySemaphore(_device, _depthFinishedSemaphore, _allocator);
 	vkDestroySemaphore(_device, _cullingFinishedSemaphore, _allocator);
@@ -2093,6 +2387,13 @@ Renderer::~Renderer()
 		vkDestroyDebugReportCallbackEXT(_instance, _debugCB, _allocator);
 	}
 
+	if (_memoryAllocator)
+	{
+		_memoryAllocator->LogStats();
+		delete _memoryAllocator;
+		_memoryAllocator = nullptr;
+	}
+
 	if (_device != VK_NULL_HANDLE)
 		vkDestroyDevice(_device, _allocator);
 	_device = VK_NULL_HANDLE;
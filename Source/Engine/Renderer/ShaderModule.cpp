@@ -45,6 +45,7 @@
 #include <Platform/Compat.h>
 
 #define SHADER_MODULE		"Shader"
+#define SPV_MAGIC			0x07230203
 
 using namespace std;
 
@@ -55,7 +56,36 @@ ShaderModule::ShaderModule(ShaderModuleResource* res) noexcept
 };
 
 int ShaderModule::Load()
-{	
+{
+	if (_CreateModule(_module) != ENGINE_OK)
+		return ENGINE_FAIL;
+
+	VK_DBG_SET_OBJECT_NAME((uint64_t)_module, VK_DEBUG_REPORT_OBJECT_TYPE_SHADER_MODULE_EXT, GetResourceInfo()->name.c_str());
+
+	return ENGINE_OK;
+}
+
+int ShaderModule::Reload()
+{
+	VkShaderModule module{ VK_NULL_HANDLE };
+
+	// The previous module is kept if the new code fails to load
+	if (_CreateModule(module) != ENGINE_OK)
+		return ENGINE_FAIL;
+
+	// Pipelines created from the old module do not reference it
+	if (_module != VK_NULL_HANDLE)
+		vkDestroyShaderModule(VKUtil::GetDevice(), _module, VKUtil::GetAllocator());
+
+	_module = module;
+
+	VK_DBG_SET_OBJECT_NAME((uint64_t)_module, VK_DEBUG_REPORT_OBJECT_TYPE_SHADER_MODULE_EXT, GetResourceInfo()->name.c_str());
+
+	return ENGINE_OK;
+}
+
+int ShaderModule::_CreateModule(VkShaderModule &module)
+{
 	size_t size{};
 	void *data = nullptr;
 	VFSFile *f = VFS::Open(GetResourceInfo()->filePath);
@@ -70,19 +100,25 @@ int ShaderModule::Load()
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 
 	data = f->ReadAll(size);
+	f->Close();
+
+	if (!data || !size || size % sizeof(uint32_t) || *(uint32_t *)data != SPV_MAGIC)
+	{
+		Logger::Log(SHADER_MODULE, LOG_CRITICAL, "Invalid SPIR-V file: %s", *GetResourceInfo()->filePath);
+		free(data);
+		return ENGINE_INVALID_RES;
+	}
 
 	createInfo.codeSize = size;
 	createInfo.pCode = (uint32_t *)data;
 
-	if (vkCreateShaderModule(VKUtil::GetDevice(), &createInfo, VKUtil::GetAllocator(), &_module) != VK_SUCCESS)
+	if (vkCreateShaderModule(VKUtil::GetDevice(), &createInfo, VKUtil::GetAllocator(), &module) != VK_SUCCESS)
 	{
 		Logger::Log(SHADER_MODULE, LOG_CRITICAL, "vkCreateShaderModule call failed");
 		free(data);
 		return ENGINE_FAIL;
 	}
 
-	VK_DBG_SET_OBJECT_NAME((uint64_t)_module, VK_DEBUG_REPORT_OBJECT_TYPE_SHADER_MODULE_EXT, GetResourceInfo()->name.c_str());
-
 	free(data);
 
 	return ENGINE_OK;
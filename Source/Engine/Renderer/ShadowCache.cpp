@@ -0,0 +1,209 @@
+/* NekoEngine
+ *
+ * ShadowCache.cpp
+ * Author: Alexandru Naiman
+ *
+ * Shadow map caster culling and caching
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <algorithm>
+
+#include <Renderer/ShadowCache.h>
+
+using namespace std;
+using namespace glm;
+
+void ShadowCache::BeginFrame() noexcept
+{
+	++_frame;
+	memset(&_stats, 0x0, sizeof(_stats));
+}
+
+bool ShadowCache::UpdateCaster(const Object *caster, const mat4 &model, const NBounds &bounds, bool animated, bool noCull)
+{
+	unordered_map<const Object *, ShadowCasterRecord>::iterator it{ _casters.find(caster) };
+
+	// New casters start as dynamic, so the faces they enter are rendered
+	if (it == _casters.end())
+	{
+		_casters.insert({ caster, { model, bounds, _frame, 0, true, true, noCull } });
+		return false;
+	}
+
+	ShadowCasterRecord &rec{ it->second };
+	rec.lastSeen = _frame;
+	rec.bounds = bounds;
+	rec.noCull = noCull;
+	rec.moved = animated || memcmp(&rec.model, &model, sizeof(mat4));
+
+	if (rec.moved)
+	{
+		rec.model = model;
+		rec.stillFrames = 0;
+
+		if (!rec.dynamic)
+		{
+			rec.dynamic = true;
+			_Requery(caster);
+		}
+
+		return false;
+	}
+
+	if (!rec.dynamic || noCull || ++rec.stillFrames < SHADOW_CACHE_SETTLE_FRAMES)
+		return false;
+
+	// Settled; the faces that see it pick it up from the spatial index
+	rec.dynamic = false;
+	_Requery(caster);
+
+	return true;
+}
+
+void ShadowCache::EndCasterUpdate()
+{
+	_dynamicCasters.clear();
+
+	for (unordered_map<const Object *, ShadowCasterRecord>::iterator it = _casters.begin(); it != _casters.end();)
+	{
+		if (it->second.lastSeen != _frame)
+		{
+			_Requery(it->first);
+			it = _casters.erase(it);
+			continue;
+		}
+
+		if (it->second.dynamic)
+			_dynamicCasters.push_back(it->first);
+
+		++it;
+	}
+
+	_stats.dynamicCasters = (uint32_t)_dynamicCasters.size();
+}
+
+bool ShadowCache::UpdateFace(uint32_t mapId, const mat4 &viewProjection, const ShadowCasterQuery &query)
+{
+	if (mapId >= _faces.size())
+		_faces.resize(mapId + 1);
+
+	ShadowFace &face{ _faces[mapId] };
+	bool render{ !face.valid || memcmp(&face.viewProjection, &viewProjection, sizeof(mat4)) };
+
+	if (render)
+	{
+		face.viewProjection = viewProjection;
+		face.frustum.FromViewProjection(face.viewProjection);
+		face.requery = true;
+	}
+
+	if (face.requery)
+	{
+		_queryResult.Clear(false);
+		query(face.frustum, _queryResult);
+
+		face.staticCasters.clear();
+		for (const Object *obj : _queryResult)
+		{
+			unordered_map<const Object *, ShadowCasterRecord>::const_iterator it{ _casters.find(obj) };
+			if (it != _casters.end() && !it->second.dynamic)
+				face.staticCasters.push_back(obj);
+		}
+		sort(face.staticCasters.begin(), face.staticCasters.end());
+
+		face.requery = false;
+		++_stats.queries;
+	}
+
+	_faceDynamic.clear();
+	for (const Object *obj : _dynamicCasters)
+	{
+		const ShadowCasterRecord &rec{ _casters[obj] };
+		if (!rec.noCull && !face.frustum.ContainsBounds(rec.bounds))
+			continue;
+
+		_faceDynamic.push_back(obj);
+		render |= rec.moved;
+	}
+	sort(_faceDynamic.begin(), _faceDynamic.end());
+
+	// A caster that left the face or was removed changes the set without moving inside it
+	_faceCasters.clear();
+	merge(face.staticCasters.begin(), face.staticCasters.end(), _faceDynamic.begin(), _faceDynamic.end(), back_inserter(_faceCasters));
+
+	render |= _faceCasters != face.casters;
+	face.casters.swap(_faceCasters);
+	face.valid = true;
+
+	if (render)
+	{
+		++_stats.facesRendered;
+		_stats.castersDrawn += (uint32_t)face.casters.size();
+	}
+	else
+		++_stats.facesCached;
+
+	return render;
+}
+
+void ShadowCache::InvalidateFace(uint32_t mapId) noexcept
+{
+	if (mapId >= _faces.size())
+		return;
+
+	_faces[mapId].valid = false;
+	_faces[mapId].casters.clear();
+	_faces[mapId].staticCasters.clear();
+}
+
+bool ShadowCache::IsDynamic(const Object *caster) const noexcept
+{
+	unordered_map<const Object *, ShadowCasterRecord>::const_iterator it{ _casters.find(caster) };
+	return it == _casters.end() || it->second.dynamic;
+}
+
+void ShadowCache::Clear() noexcept
+{
+	_casters.clear();
+	_dynamicCasters.clear();
+	_faces.clear();
+}
+
+void ShadowCache::_Requery(const Object *caster) noexcept
+{
+	for (ShadowFace &face : _faces)
+		if (binary_search(face.casters.begin(), face.casters.end(), caster))
+			face.requery = true;
+}
@@ -39,7 +39,9 @@
 
 #include <stack>
 
+#include <Engine/EventManager.h>
 #include <Renderer/VKUtil.h>
+#include <Renderer/ShadowCache.h>
 #include <Renderer/DebugMarker.h>
 #include <Renderer/ShadowRenderer.h>
 #include <Renderer/PipelineManager.h>
@@ -68,7 +70,9 @@ static VkFramebuffer *_shadowFramebuffers{ nullptr }, _shadowTargetFramebuffer{
 					 _shadowTargetFilterFramebuffer{ VK_NULL_HANDLE };
 static Buffer *_matricesBuffer{ nullptr };
 static NArray<ShadowCaster> _shadowCasters{};
+static ShadowCache _shadowCache{};
 static stack<int32_t> _freeShadowMaps{};
+static uint32_t _sceneUnloadedEventHandler{ 0 };
 static VkDeviceSize _matricesBufferSize{ 0 };
 static VkDescriptorPool _descriptorPool{ VK_NULL_HANDLE };
 static VkDescriptorSet _matricesDescriptorSet{ VK_NULL_HANDLE }, _biasedMatricesDescriptorSet{ VK_NULL_HANDLE },
@@ -294,6 +298,11 @@ int ShadowRenderer::Initialize()
 		}
 	}
 
+	// The cache is keyed by object address; the next scene may reuse them
+	_sceneUnloadedEventHandler = EventManager::RegisterHandler(NE_EVT_SCN_UNLOADED, [](int32_t eventId, void *eventData) {
+		_shadowCache.Clear();
+	});
+
 	return ENGINE_OK;
 }
 
@@ -321,7 +330,10 @@ void ShadowRenderer::UnregisterShadowCaster(uint8_t id)
 	ShadowCaster &caster{ _shadowCasters[id] };
 
 	for (uint8_t i = 0; i < caster.mapCount; ++i)
+	{
+		_shadowCache.InvalidateFace(caster.mapIds[i]);
 		_freeShadowMaps.push(caster.mapIds[i]);
+	}
 
 	_shadowCasters.Remove(id);
 }
@@ -388,12 +400,19 @@ void ShadowRenderer::BuildCommandBuffer(VkCommandBuffer commandBuffer)
 	VkRect2D scissor{};
 	VKUtil::InitScissor(&scissor, Engine::GetConfiguration().Renderer.ShadowMapSize, Engine::GetConfiguration().Renderer.ShadowMapSize);
 
-	for (ShadowCaster caster : _shadowCasters)
-	{
-		//Light *l{ Renderer::GetInstance()->GetLight(caster.lightId) };
+	Scene *scene{ SceneManager::GetActiveScene() };
+	ShadowCasterQuery query{ [scene](const NFrustum &frustum, NArray<const Object *> &casters) { scene->GetShadowCasters(frustum, casters); } };
 
+	scene->UpdateShadowCasters(&_shadowCache);
+
+	for (const ShadowCaster &caster : _shadowCasters)
+	{
 		for (uint8_t i = 0; i < caster.mapCount; ++i)
 		{
+			// The map keeps its contents while neither the light nor its casters change
+			if (!_shadowCache.UpdateFace(caster.mapIds[i], _matrices[caster.mapIds[i]], query))
+				continue;
+
 			// 1. Render shadow map
 			renderPassInfo.renderPass = RenderPassManager::GetRenderPass(RP_ShadowMap);
 			renderPassInfo.framebuffer = _shadowTargetFramebuffer;
@@ -416,7 +435,8 @@ void ShadowRenderer::BuildCommandBuffer(VkCommandBuffer commandBuffer)
 				vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 				vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-				SceneManager::GetActiveScene()->DrawShadow(commandBuffer, caster.mapIds[i]);
+				for (const Object *obj : _shadowCache.GetFaceCasters(caster.mapIds[i]))
+					obj->DrawShadow(commandBuffer, caster.mapIds[i]);
 			}
 			vkCmdEndRenderPass(commandBuffer);
 
@@ -493,6 +513,9 @@ void ShadowRenderer::UpdateData(VkCommandBuffer cmdBuffer)
 
 void ShadowRenderer::Release()
 {
+	EventManager::UnregisterHandler(NE_EVT_SCN_UNLOADED, _sceneUnloadedEventHandler);
+
+	_shadowCache.Clear();
 	free(_matrices);
 
 	for (int32_t i = 0; i < Engine::GetConfiguration().Renderer.MaxShadowMaps; ++i)
@@ -41,6 +41,7 @@
 #include <Renderer/DebugMarker.h>
 #include <Renderer/SkeletalMesh.h>
 #include <Renderer/ShadowRenderer.h>
+#include <Renderer/InstanceManager.h>
 #include <Renderer/PipelineManager.h>
 #include <Renderer/RenderPassManager.h>
 #include <Engine/Vertex.h>
@@ -68,6 +69,7 @@ Skeleton *SkeletalMesh::CreateSkeleton()
 	
 	if(skel->Load() != ENGINE_OK)
 	{
+		delete skel;
 		Logger::Log(SK_MESH_MODULE, LOG_CRITICAL, "Failed to load skeleton for mesh id=%s", _resourceInfo->name.c_str());
 		return nullptr;
 	}
@@ -178,12 +180,13 @@ bool SkeletalMesh::Upload(Buffer *buffer)
 		_buffer = buffer;
 
 	VkDeviceSize bufferSize = GetRequiredMemorySize();
-	Buffer *stagingBuffer = new Buffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, nullptr, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	Buffer *stagingBuffer = Renderer::GetInstance()->GetStagingBuffer(bufferSize);
 
 	uint8_t *ptr = stagingBuffer->Map();
 	if (!ptr)
 	{
 		Logger::Log(SK_MESH_MODULE, LOG_CRITICAL, "Failed to map memory");
+		Renderer::GetInstance()->FreeStagingBuffer(stagingBuffer);
 		return false;
 	}
 
@@ -194,7 +197,7 @@ bool SkeletalMesh::Upload(Buffer *buffer)
 
 	stagingBuffer->Copy(_buffer, bufferSize);
 
-	delete stagingBuffer;
+	Renderer::GetInstance()->FreeStagingBuffer(stagingBuffer);
 
 	_vertexOffset = _buffer->GetParentOffset();
 	_indexOffset = _vertexOffset + sizeof(_vertices[0]) * _vertices.size();
@@ -253,6 +256,11 @@ bool SkeletalMesh::BuildDrawables(NArray<Material *> &materials, VkDescriptorSet
 		drawable.sceneCommandBuffer = Renderer::GetInstance()->CreateMeshCommandBuffer();
 		drawable.depthCommandBuffer = VK_NULL_HANDLE;
 		drawable.transparent = materials[i]->IsTransparent();
+		drawable.pipeline = materials[i]->GetPipelineId();
+		drawable.material = materials[i];
+		drawable.mesh = this;
+		drawable.group = (uint32_t)i;
+		drawable.instanceCommand = INST_NO_COMMAND;
 
 		if (buildBounds)
 			_BuildBounds((uint32_t)i, drawable.bounds);
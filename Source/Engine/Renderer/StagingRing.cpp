@@ -0,0 +1,163 @@
+/* NekoEngine
+ *
+ * StagingRing.cpp
+ * Author: Alexandru Naiman
+ *
+ * Frame partitioned staging ring
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include <Renderer/StagingRing.h>
+
+using namespace std;
+
+static inline VkDeviceSize _sr_AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+StagingRing::StagingRing(VkDeviceSize size, VkDeviceSize frameBudget) :
+	_size(size), _frameBudget(frameBudget > size ? size : frameBudget),
+	_head(0), _used(0),
+	_lastOffset(0), _lastSize(0), _lastHead(0), _lastBytes(0),
+	_frame(0), _lastBudgeted(false)
+{
+}
+
+void StagingRing::BeginFrame(uint64_t frame)
+{
+	_frame = frame;
+	_lastBytes = 0;
+	_partitions.push_back({ frame, 0, 0 });
+}
+
+bool StagingRing::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset, bool budgeted)
+{
+	VkDeviceSize bytes{ 0 };
+
+	if (_partitions.empty() || _partitions.back().frame != _frame)
+		_partitions.push_back({ _frame, 0, 0 });
+
+	if (!size || !_Fit(size, alignment, offset, bytes, budgeted))
+		return false;
+
+	_lastOffset = offset;
+	_lastSize = size;
+	_lastHead = _head;
+	_lastBytes = bytes;
+	_lastBudgeted = budgeted;
+
+	_head = offset + size;
+	_used += bytes;
+	_partitions.back().bytes += bytes;
+	if (budgeted)
+		_partitions.back().budgeted += bytes;
+
+	return true;
+}
+
+bool StagingRing::Release(VkDeviceSize offset, VkDeviceSize size)
+{
+	if (!_lastBytes || offset != _lastOffset || size != _lastSize)
+		return false;
+
+	_head = _lastHead;
+	_used -= _lastBytes;
+	_partitions.back().bytes -= _lastBytes;
+	if (_lastBudgeted)
+		_partitions.back().budgeted -= _lastBytes;
+	_lastBytes = 0;
+
+	return true;
+}
+
+VkDeviceSize StagingRing::GetAvailable(VkDeviceSize alignment) const
+{
+	VkDeviceSize free{ _size - _used };
+	VkDeviceSize budget{ _frameBudget - GetFrameUsed() };
+	VkDeviceSize available{ 0 };
+
+	if (free > budget)
+		free = budget;
+
+	// In place, after the alignment padding
+	VkDeviceSize aligned{ _sr_AlignUp(_head, alignment) };
+	if (aligned < _size && aligned - _head < free)
+		available = std::min(_size - aligned, free - (aligned - _head));
+
+	// Wrapped to the start, giving up the tail of the ring
+	if (_size - _head < free)
+		available = std::max(available, free - (_size - _head));
+
+	return available;
+}
+
+void StagingRing::Reclaim(uint64_t completedFrame)
+{
+	size_t count{ 0 };
+
+	while (count < _partitions.size() && _partitions[count].frame <= completedFrame)
+		_used -= _partitions[count++].bytes;
+
+	if (!count)
+		return;
+
+	if (count == _partitions.size())
+		_lastBytes = 0;
+
+	_partitions.erase(_partitions.begin(), _partitions.begin() + count);
+
+	// Nothing is in flight; start over to avoid wasting the tail on the next wrap
+	if (!_used)
+		_head = 0;
+}
+
+bool StagingRing::_Fit(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset, VkDeviceSize &bytes, bool budgeted) const
+{
+	VkDeviceSize aligned{ _sr_AlignUp(_head, alignment) };
+
+	if (aligned + size <= _size)
+	{
+		offset = aligned;
+		bytes = aligned - _head + size;
+	}
+	else
+	{
+		offset = 0;
+		bytes = _size - _head + size;
+	}
+
+	return bytes <= _size - _used && (!budgeted || GetFrameUsed() + bytes <= _frameBudget);
+}
@@ -41,10 +41,13 @@
 #include <Renderer/StaticMesh.h>
 #include <Renderer/DebugMarker.h>
 #include <Renderer/ShadowRenderer.h>
+#include <Renderer/InstanceManager.h>
 #include <Renderer/PipelineManager.h>
 #include <Renderer/RenderPassManager.h>
 #include <System/Logger.h>
+#include <System/VFS/VFS.h>
 #include <System/AssetLoader/AssetLoader.h>
+#include <Physics/TriangleBVH.h>
 
 using namespace std;
 using namespace glm;
@@ -60,7 +63,10 @@ StaticMesh::StaticMesh(MeshResource *res) noexcept :
 	_hasOwnBuffer(false),
 	_resident(false),
 	_vertexOffset(0),
-	_indexOffset(0)
+	_indexOffset(0),
+	_bvh(nullptr),
+	_indirectBuffer(nullptr),
+	_indirectDrawCount(0)
 {
 	_resourceInfo = res;
 
@@ -79,7 +85,10 @@ StaticMesh::StaticMesh(PrimitiveID primitiveId) noexcept :
 	_hasOwnBuffer(false),
 	_resident(false),
 	_vertexOffset(0),
-	_indexOffset(0)
+	_indexOffset(0),
+	_bvh(nullptr),
+	_indirectBuffer(nullptr),
+	_indirectDrawCount(0)
 {
 	_resourceInfo = nullptr;
 
@@ -220,14 +229,69 @@ void StaticMesh::UpdateVertices(std::vector<Vertex> &vertices)
 		return;
 }
 
+const TriangleBVH *StaticMesh::GetBVH() const
+{
+	if (_bvh)
+		return _bvh;
+
+	vector<vec3> triangles{};
+	TriangleBVH::GetMeshTriangles(this, triangles);
+
+	_bvh = new TriangleBVH();
+
+	// Cached files are only found through the loose file list, so they
+	// are only used in builds that load loose files
+	char cachePath[VFS_MAX_FILE_NAME]{};
+	if (_primitiveId == PrimitiveID::EndEnum && _resourceInfo && Engine::GetConfiguration().Engine.LoadLooseFiles)
+	{
+		snprintf(cachePath, VFS_MAX_FILE_NAME, "%s", *GetResourceInfo()->filePath);
+
+		char *ext{ strrchr(cachePath, '.') };
+		if (ext && !strchr(ext, '/'))
+			*ext = 0x0;
+		strncat(cachePath, ".nbvh", VFS_MAX_FILE_NAME - strlen(cachePath) - 1);
+
+		NString path{ cachePath };
+		if (VFSFile *f = VFS::Open(path))
+		{
+			int ret{ _bvh->Load(f, TriangleBVH::HashTriangles(triangles)) };
+			f->Close();
+
+			if (ret == ENGINE_OK)
+				return _bvh;
+
+			Logger::Log(SM_MESH_MODULE, LOG_WARNING, "Discarding stale BVH cache %s", cachePath);
+		}
+	}
+
+	_bvh->Build(triangles);
+
+	if (cachePath[0])
+	{
+		NString path{ cachePath };
+		if (VFSFile *f = VFS::Create(path))
+		{
+			_bvh->Save(f);
+			f->Close();
+			delete f;
+		}
+	}
+
+	Logger::Log(SM_MESH_MODULE, LOG_DEBUG, "Built BVH with %u nodes for %u triangles", _bvh->GetNodeCount(), _bvh->GetTriangleCount());
+
+	return _bvh;
+}
+
 void StaticMesh::Release() noexcept
 {
+	delete _indirectBuffer; _indirectBuffer = nullptr;
 	delete _buffer; _buffer = nullptr;
 }
 
 StaticMesh::~StaticMesh() noexcept
 {
 	Release();
+	delete _bvh;
 }
 
 VkDeviceSize StaticMesh::GetRequiredMemorySize()
@@ -261,12 +325,13 @@ bool StaticMesh::Upload(Buffer *buffer)
 		_buffer = buffer;
 
 	VkDeviceSize bufferSize = GetRequiredMemorySize();
-	Buffer *stagingBuffer = new Buffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, nullptr, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	Buffer *stagingBuffer = Renderer::GetInstance()->GetStagingBuffer(bufferSize);
 
 	uint8_t *ptr = stagingBuffer->Map();
 	if (!ptr)
 	{
 		Logger::Log(SM_MESH_MODULE, LOG_CRITICAL, "Failed to map memory");
+		Renderer::GetInstance()->FreeStagingBuffer(stagingBuffer);
 		return false;
 	}
 
@@ -277,7 +342,7 @@ bool StaticMesh::Upload(Buffer *buffer)
 
 	stagingBuffer->Copy(_buffer, bufferSize);
 
-	delete stagingBuffer;
+	Renderer::GetInstance()->FreeStagingBuffer(stagingBuffer);
 
 	_vertexOffset = _buffer->GetParentOffset();
 	_indexOffset = _vertexOffset + sizeof(_vertices[0]) * _vertices.size();
@@ -332,6 +397,10 @@ bool StaticMesh::BuildDrawables(NArray<Material *> &materials, VkDescriptorSet d
 		drawable.sceneCommandBuffer = Renderer::GetInstance()->CreateMeshCommandBuffer();
 		drawable.depthCommandBuffer = VK_NULL_HANDLE;
 		drawable.transparent = materials[i]->IsTransparent();
+		drawable.pipeline = materials[i]->GetPipelineId();
+		drawable.material = materials[i];
+		drawable.mesh = this;
+		drawable.group = (uint32_t)i;
 
 		if (buildBounds)
 		{
@@ -373,7 +442,7 @@ bool StaticMesh::BuildDrawables(NArray<Material *> &materials, VkDescriptorSet d
 			{
 				vkCmdBindVertexBuffers(drawable.depthCommandBuffer, 0, 1, &_buffer->GetHandle(), &_vertexOffset);
 				vkCmdBindIndexBuffer(drawable.depthCommandBuffer, _buffer->GetHandle(), _indexOffset, VK_INDEX_TYPE_UINT32);
-				vkCmdDrawIndexed(drawable.depthCommandBuffer, _groups[i].indexCount, 1, _groups[i].indexOffset, 0, 0);
+				_DrawGroup(drawable.depthCommandBuffer, i);
 			}
 			else
 				Primitives::DrawPrimitive(_primitiveId, drawable.depthCommandBuffer);
@@ -411,7 +480,7 @@ bool StaticMesh::BuildDrawables(NArray<Material *> &materials, VkDescriptorSet d
 		{
 			vkCmdBindVertexBuffers(drawable.sceneCommandBuffer, 0, 1, &_buffer->GetHandle(), &_vertexOffset);
 			vkCmdBindIndexBuffer(drawable.sceneCommandBuffer, _buffer->GetHandle(), _indexOffset, VK_INDEX_TYPE_UINT32);
-			vkCmdDrawIndexed(drawable.sceneCommandBuffer, _groups[i].indexCount, 1, _groups[i].indexOffset, 0, 0);
+			_DrawGroup(drawable.sceneCommandBuffer, i);
 		}
 		else
 			Primitives::DrawPrimitive(_primitiveId, drawable.sceneCommandBuffer);
@@ -422,6 +491,9 @@ bool StaticMesh::BuildDrawables(NArray<Material *> &materials, VkDescriptorSet d
 			return false;
 		}
 
+		if (!_BuildInstancedDrawable(materials[i], drawable, i, buildDepth))
+			return false;
+
 		if (add) drawables.Add(drawable);
 	}
 
@@ -452,6 +524,144 @@ void StaticMesh::DrawShadow(VkCommandBuffer commandBuffer, uint32_t shadowId, Vk
 		Primitives::DrawPrimitive(_primitiveId, commandBuffer);
 }
 
+bool StaticMesh::_BuildInstancedDrawable(Material *material, Drawable &drawable, size_t group, bool buildDepth)
+{
+	drawable.instancedSceneCommandBuffer = VK_NULL_HANDLE;
+	drawable.instancedDepthCommandBuffer = VK_NULL_HANDLE;
+	drawable.instanceCommand = INST_NO_COMMAND;
+
+	// The terrain writes its own indirect commands
+	if (_indirectBuffer || !InstanceManager::IsEnabled() || !material->CanInstance())
+		return true;
+
+	uint32_t indexCount{ 0 }, firstIndex{ 0 };
+	if (_primitiveId == PrimitiveID::EndEnum)
+	{
+		indexCount = _groups[group].indexCount;
+		firstIndex = _groups[group].indexOffset;
+	}
+	else
+	{
+		indexCount = Primitives::GetIndexCount(_primitiveId);
+		firstIndex = Primitives::GetFirstIndex(_primitiveId);
+	}
+
+	// Without a command the drawable is still submitted on its own
+	if ((drawable.instanceCommand = InstanceManager::AllocateCommand(indexCount, firstIndex, 0)) == INST_NO_COMMAND)
+		return true;
+
+	VkDescriptorSet sceneDescriptorSet{ Renderer::GetInstance()->GetSceneDescriptorSet() };
+	VkDescriptorSet instanceDescriptorSet{ InstanceManager::GetDescriptorSet() };
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+
+	if (buildDepth)
+	{
+		drawable.instancedDepthCommandBuffer = Renderer::GetInstance()->CreateMeshCommandBuffer();
+
+		VkCommandBufferInheritanceInfo depthInheritanceInfo{};
+		depthInheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		depthInheritanceInfo.occlusionQueryEnable = VK_FALSE;
+		depthInheritanceInfo.renderPass = RenderPassManager::GetRenderPass(RP_Depth);
+		depthInheritanceInfo.subpass = 0;
+		depthInheritanceInfo.framebuffer = Renderer::GetInstance()->GetDepthFramebuffer();
+
+		beginInfo.pInheritanceInfo = &depthInheritanceInfo;
+
+		if (vkBeginCommandBuffer(drawable.instancedDepthCommandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			Logger::Log(SM_MESH_MODULE, LOG_CRITICAL, "vkBeginCommandBuffer (instanced depth) call failed");
+			return false;
+		}
+
+		VK_DBG_MARKER_INSERT(drawable.instancedDepthCommandBuffer, _resourceInfo ? _resourceInfo->name.c_str() : "generated mesh", vec4(0.0, 0.5, 1.0, 1.0));
+
+		VkPipelineLayout layout{ PipelineManager::GetPipelineLayout(PIPE_LYT_Instanced_Depth) };
+
+		vkCmdBindPipeline(drawable.instancedDepthCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipeline(material->HasNormalMap() ? PIPE_Instanced_DepthNormal : PIPE_Instanced_Depth));
+		vkCmdBindDescriptorSets(drawable.instancedDepthCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &sceneDescriptorSet, 0, nullptr);
+		vkCmdBindDescriptorSets(drawable.instancedDepthCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 1, &instanceDescriptorSet, 0, nullptr);
+
+		material->BindNormal(drawable.instancedDepthCommandBuffer, true);
+
+		_DrawInstances(drawable.instancedDepthCommandBuffer, drawable.instanceCommand);
+
+		if (vkEndCommandBuffer(drawable.instancedDepthCommandBuffer) != VK_SUCCESS)
+		{
+			Logger::Log(SM_MESH_MODULE, LOG_CRITICAL, "vkEndCommandBuffer (instanced depth) call failed");
+			return false;
+		}
+	}
+
+	drawable.instancedSceneCommandBuffer = Renderer::GetInstance()->CreateMeshCommandBuffer();
+
+	VkCommandBufferInheritanceInfo inheritanceInfo{};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.occlusionQueryEnable = VK_FALSE;
+	inheritanceInfo.renderPass = RenderPassManager::GetRenderPass(RP_Graphics);
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = Renderer::GetInstance()->GetDrawFramebuffer();
+
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	if (vkBeginCommandBuffer(drawable.instancedSceneCommandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		Logger::Log(SM_MESH_MODULE, LOG_CRITICAL, "vkBeginCommandBuffer (instanced scene) call failed");
+		return false;
+	}
+
+	VK_DBG_MARKER_INSERT(drawable.instancedSceneCommandBuffer, _resourceInfo ? _resourceInfo->name.c_str() : "generated mesh", vec4(1.0, 0.5, 0.0, 1.0));
+
+	material->Enable(drawable.instancedSceneCommandBuffer, true);
+
+	vkCmdBindDescriptorSets(drawable.instancedSceneCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, material->GetPipelineLayout(true), 0, 1, &sceneDescriptorSet, 0, nullptr);
+	vkCmdBindDescriptorSets(drawable.instancedSceneCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, material->GetPipelineLayout(true), 1, 1, &instanceDescriptorSet, 0, nullptr);
+
+	_DrawInstances(drawable.instancedSceneCommandBuffer, drawable.instanceCommand);
+
+	if (vkEndCommandBuffer(drawable.instancedSceneCommandBuffer) != VK_SUCCESS)
+	{
+		Logger::Log(SM_MESH_MODULE, LOG_CRITICAL, "vkEndCommandBuffer (instanced scene) call failed");
+		return false;
+	}
+
+	return true;
+}
+
+void StaticMesh::_DrawInstances(VkCommandBuffer commandBuffer, int32_t command) const noexcept
+{
+	// The instance count and first instance are written every frame for the batch this draw leads
+	if (_primitiveId != PrimitiveID::EndEnum)
+	{
+		Primitives::DrawPrimitiveIndirect(_primitiveId, commandBuffer, InstanceManager::GetBuffer(), InstanceManager::GetCommandOffset(command));
+		return;
+	}
+
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &_buffer->GetHandle(), &_vertexOffset);
+	vkCmdBindIndexBuffer(commandBuffer, _buffer->GetHandle(), _indexOffset, VK_INDEX_TYPE_UINT32);
+	vkCmdDrawIndexedIndirect(commandBuffer, InstanceManager::GetBuffer(), InstanceManager::GetCommandOffset(command), 1, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void StaticMesh::_DrawGroup(VkCommandBuffer commandBuffer, size_t group) const noexcept
+{
+	if (!_indirectBuffer)
+	{
+		vkCmdDrawIndexed(commandBuffer, _groups[group].indexCount, 1, _groups[group].indexOffset, 0, 0);
+		return;
+	}
+
+	// The commands are rewritten every frame, so the recorded buffer stays valid
+	const uint32_t stride{ sizeof(VkDrawIndexedIndirectCommand) };
+
+	if (Renderer::GetInstance()->HasMultiDrawIndirect())
+		vkCmdDrawIndexedIndirect(commandBuffer, _indirectBuffer->GetHandle(), _indirectBuffer->GetParentOffset(), _indirectDrawCount, stride);
+	else
+		for (uint32_t i = 0; i < _indirectDrawCount; ++i)
+			vkCmdDrawIndexedIndirect(commandBuffer, _indirectBuffer->GetHandle(), _indirectBuffer->GetParentOffset() + i * stride, 1, stride);
+}
+
 void StaticMesh::_CalculateTangents()
 {
 	if (!_vertices.size())
@@ -0,0 +1,228 @@
+/* NekoEngine
+ *
+ * TextRunCache.cpp
+ * Author: Alexandru Naiman
+ *
+ * Retained text geometry
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <algorithm>
+
+#include <Renderer/TextRunCache.h>
+
+using namespace std;
+
+TextRunCache::TextRunCache(uint32_t persistentQuads, uint32_t dynamicQuads) :
+	_persistentCapacity(persistentQuads), _dynamicCapacity(dynamicQuads),
+	_persistentTop(0), _dynamicRuns(0), _frame(0)
+{
+	memset(&_stats, 0x0, sizeof(_stats));
+}
+
+TextRun *TextRunCache::Find(uint64_t key)
+{
+	auto it = _runs.find(key);
+	if (it == _runs.end())
+		return nullptr;
+
+	it->second.lastFrame = _frame;
+	return &it->second;
+}
+
+TextRun *TextRunCache::Add(uint64_t key)
+{
+	TextRun &run{ _runs[key] };
+
+	run.vertices.clear();
+	run.width = 0.f;
+	run.age = 0;
+	run.firstQuad = 0;
+	run.lastFrame = _frame;
+	run.persistent = false;
+
+	++_dynamicRuns;
+	++_stats.tessellations;
+
+	return &run;
+}
+
+void TextRunCache::EndFrame(uint8_t *staging, size_t stagingSize, TextRunUpdate &update)
+{
+	uint32_t slice{ (uint32_t)(_frame % TEXT_RUN_RING_SIZE) };
+	size_t used{ 0 };
+
+	update.copies.clear();
+	update.fills.clear();
+	update.dynamicFirstQuad = _persistentCapacity + slice * _dynamicCapacity;
+	update.dynamicQuads = 0;
+
+	// Evict first so promotions can reuse the space
+	for (auto it = _runs.begin(); it != _runs.end();)
+	{
+		TextRun &run{ it->second };
+
+		if (run.lastFrame == _frame)
+		{
+			++it;
+			continue;
+		}
+
+		if (run.persistent)
+			_Free(run.firstQuad, (uint32_t)run.vertices.size() / 4, update);
+		else
+			--_dynamicRuns;
+
+		++_stats.evictions;
+		it = _runs.erase(it);
+	}
+
+	for (auto &kvp : _runs)
+	{
+		TextRun &run{ kvp.second };
+		uint32_t quads{ (uint32_t)run.vertices.size() / 4 };
+		size_t size{ quads * TEXT_RUN_QUAD_SIZE };
+
+		if (run.persistent || !quads)
+			continue;
+
+		if (used + size > stagingSize)
+			continue;
+
+		if (++run.age >= TEXT_RUN_PROMOTE_FRAMES && _Allocate(quads, run.firstQuad))
+		{
+			run.persistent = true;
+			--_dynamicRuns;
+			++_stats.promotions;
+
+			update.copies.push_back({ used, run.firstQuad * TEXT_RUN_QUAD_SIZE, size });
+		}
+		else if (update.dynamicQuads + quads <= _dynamicCapacity)
+		{
+			update.copies.push_back({ used, (update.dynamicFirstQuad + update.dynamicQuads) * TEXT_RUN_QUAD_SIZE, size });
+			update.dynamicQuads += quads;
+		}
+		else
+			continue;
+
+		memcpy(staging + used, run.vertices.data(), size);
+		used += size;
+	}
+
+	update.persistentQuads = _persistentTop;
+	update.stagingUsed = used;
+
+	_stats.bytesUploaded += used;
+	++_frame;
+}
+
+void TextRunCache::Clear()
+{
+	_runs.clear();
+	_freeRanges.clear();
+	_persistentTop = 0;
+	_dynamicRuns = 0;
+}
+
+uint64_t TextRunCache::Hash(const void *data, size_t size, uint64_t hash) noexcept
+{
+	const uint8_t *bytes{ (const uint8_t *)data };
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+bool TextRunCache::_Allocate(uint32_t count, uint32_t &first)
+{
+	for (size_t i = 0; i < _freeRanges.size(); ++i)
+	{
+		pair<uint32_t, uint32_t> &range{ _freeRanges[i] };
+
+		if (range.second < count)
+			continue;
+
+		first = range.first;
+		range.first += count;
+		range.second -= count;
+
+		if (!range.second)
+			_freeRanges.erase(_freeRanges.begin() + i);
+
+		return true;
+	}
+
+	if (_persistentTop + count > _persistentCapacity)
+		return false;
+
+	first = _persistentTop;
+	_persistentTop += count;
+
+	return true;
+}
+
+void TextRunCache::_Free(uint32_t first, uint32_t count, TextRunUpdate &update)
+{
+	if (!count)
+		return;
+
+	auto it = lower_bound(_freeRanges.begin(), _freeRanges.end(), make_pair(first, count));
+	it = _freeRanges.insert(it, make_pair(first, count));
+
+	if (it + 1 != _freeRanges.end() && it->first + it->second == (it + 1)->first)
+	{
+		it->second += (it + 1)->second;
+		_freeRanges.erase(it + 1);
+	}
+
+	if (it != _freeRanges.begin() && (it - 1)->first + (it - 1)->second == it->first)
+	{
+		(it - 1)->second += it->second;
+		it = _freeRanges.erase(it) - 1;
+	}
+
+	// Space at the top is simply not drawn anymore; holes below it are zeroed into degenerate quads
+	if (it->first + it->second == _persistentTop)
+	{
+		_persistentTop = it->first;
+		_freeRanges.erase(it);
+		return;
+	}
+
+	update.fills.push_back({ first * TEXT_RUN_QUAD_SIZE, count * TEXT_RUN_QUAD_SIZE });
+}
@@ -41,6 +41,7 @@
 #include <string.h>
 
 #include <Engine/Engine.h>
+#include <Engine/EventManager.h>
 #include <Renderer/VKUtil.h>
 #include <Renderer/Texture.h>
 #include <Renderer/DebugMarker.h>
@@ -92,7 +93,7 @@ Texture::Texture(TextureResource *res) noexcept
 	_isAttachment = false;
 	_width = _height = _depth = _mipLevels = 0;
 	_arrayLayers = 1;
-	_ownMemory = true;
+	memset(&_allocation, 0x0, sizeof(_allocation));
 }
 
 Texture::Texture(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, uint64_t dataSize, uint8_t *data)
@@ -110,10 +111,12 @@ Texture::Texture(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat f
 	_depth = 1;
 	_mipLevels = mipLevels;
 	_arrayLayers = 1;
-	_ownMemory = true;
+	memset(&_allocation, 0x0, sizeof(_allocation));
 
-	VKUtil::CreateImage(_image, _imageMemory, _width, _height, _depth, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		_format, _type, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_TILING_OPTIMAL, _mipLevels, 1, 0, VK_SAMPLE_COUNT_1_BIT);
+	if (!VKUtil::CreateUnboundImage(_image, _width, _height, _depth, _format, _type,
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_TILING_OPTIMAL, _mipLevels, 1, 0, VK_SAMPLE_COUNT_1_BIT) ||
+		!_BindMemory(VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_TILING_OPTIMAL))
+	{ DIE("Out of resources"); }
 
 	Buffer *stagingBuffer = Renderer::GetInstance()->GetStagingBuffer(dataSize);
 
@@ -122,8 +125,12 @@ Texture::Texture(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat f
 	memcpy(ptr, data, dataSize);
 	stagingBuffer->Unmap();
 
+	VkImageSubresourceLayers subResource{};
+	subResource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subResource.layerCount = 1;
+
 	VKUtil::TransitionImageLayout(_image, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	VKUtil::CopyBufferToImage(stagingBuffer->GetHandle(), _image, _width, _height);
+	VKUtil::CopyBufferToImage(stagingBuffer->GetHandle(), _image, _width, _height, stagingBuffer->GetParentOffset(), subResource);
 	VKUtil::TransitionImageLayout(_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 	VKUtil::CreateImageView(_view, _image, VK_IMAGE_VIEW_TYPE_2D, _format, VK_IMAGE_ASPECT_COLOR_BIT,
@@ -150,13 +157,13 @@ Texture::Texture(VkFormat format, VkImageType type, VkImageUsageFlags usage, VkI
 	_depth = depth;
 	_mipLevels = mipLevels;
 	_arrayLayers = arrayLayers;
-	_ownMemory = _imageMemory == VK_NULL_HANDLE;
+	memset(&_allocation, 0x0, sizeof(_allocation));
 
 	if (!create)
 		return;
 
-	if (!VKUtil::CreateImage(_image, _imageMemory, _width, _height, _depth, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		_format, _type, usage, tiling, _mipLevels, _arrayLayers, 0, samples))
+	if (!VKUtil::CreateUnboundImage(_image, _width, _height, _depth, _format, _type, usage, tiling, _mipLevels, _arrayLayers, 0, samples) ||
+		!_BindMemory(usage, tiling))
 	{ DIE("Out of resources"); }
 }
 
@@ -278,17 +285,17 @@ int Texture::Load()
 	if ((_mipLevels == 1) && (GetResourceInfo()->textureType != TextureResourceType::TEXTURE_CUBEMAP))
 		_mipLevels = (int)floor(std::log2(std::max(_width, _height))) + 1;
 
-	if (!VKUtil::CreateImage(_image, _imageMemory, _width, _height, 1,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _format, VK_IMAGE_TYPE_2D,
+	if (!VKUtil::CreateUnboundImage(_image, _width, _height, 1, _format, VK_IMAGE_TYPE_2D,
 		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_IMAGE_TILING_OPTIMAL, _mipLevels,
 		GetResourceInfo()->textureType == TextureResourceType::TEXTURE_CUBEMAP ? 6 : 1,
-		GetResourceInfo()->textureType == TextureResourceType::TEXTURE_CUBEMAP ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0))
+		GetResourceInfo()->textureType == TextureResourceType::TEXTURE_CUBEMAP ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0) ||
+		!_BindMemory(VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_TILING_OPTIMAL))
 	{
 		free(mem); if (tga) free(imgData);
 		return ENGINE_OUT_OF_RESOURCES;
 	}
 
-	if ((stagingBuffer = new Buffer(imgDataSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, nullptr, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) == nullptr)
+	if ((stagingBuffer = Renderer::GetInstance()->GetStagingBuffer(imgDataSize)) == nullptr)
 	{
 		free(mem); if (tga) free(imgData);;
 		return ENGINE_OUT_OF_RESOURCES;
@@ -298,6 +305,7 @@ int Texture::Load()
 	if (!ptr)
 	{
 		free(mem); if (tga) free(imgData);
+		Renderer::GetInstance()->FreeStagingBuffer(stagingBuffer);
 		return ENGINE_OUT_OF_RESOURCES;
 	}
 	memcpy(ptr, imgData, imgDataSize);
@@ -316,7 +324,7 @@ int Texture::Load()
 
 	VKUtil::TransitionImageLayout(_image, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range, uploadCmdBuffer);
 
-	VkDeviceSize buffOffset{ 0 };
+	VkDeviceSize buffOffset{ stagingBuffer->GetParentOffset() };
 
 	for (uint32_t i = 0; i < range.layerCount; ++i)
 	{
@@ -342,7 +350,7 @@ int Texture::Load()
 
 	VKUtil::ExecuteOneShotCmdBuffer(uploadCmdBuffer);
 
-	delete stagingBuffer;
+	Renderer::GetInstance()->FreeStagingBuffer(stagingBuffer);
 
 	if (fileMipLevels == 1)
 		GenerateMipmaps();
@@ -498,14 +506,39 @@ Texture *Texture::CreateDepthStencilTarget()
 	return nullptr;
 }
 
+bool Texture::_BindMemory(VkImageUsageFlags usage, VkImageTiling tiling)
+{
+	// Memory supplied by the caller is not owned by the texture
+	if (_imageMemory != VK_NULL_HANDLE)
+		return vkBindImageMemory(VKUtil::GetDevice(), _image, _imageMemory, 0) == VK_SUCCESS;
+
+	VkMemoryRequirements memReq;
+	vkGetImageMemoryRequirements(VKUtil::GetDevice(), _image, &memReq);
+
+	MemoryResourceType type{ MemoryResourceType::Image };
+	if (tiling == VK_IMAGE_TILING_LINEAR)
+		type = MemoryResourceType::Linear;
+	else if (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))
+		type = MemoryResourceType::Attachment;
+
+	if (!Renderer::GetInstance()->GetMemoryAllocator()->Allocate(memReq, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, type, _allocation, this))
+		return false;
+
+	_imageMemory = _allocation.memory;
+
+	return vkBindImageMemory(VKUtil::GetDevice(), _image, _imageMemory, _allocation.offset) == VK_SUCCESS;
+}
+
 Texture::~Texture() noexcept
 {
-	if (_ownMemory && _imageMemory != VK_NULL_HANDLE)
-		vkFreeMemory(VKUtil::GetDevice(), _imageMemory, VKUtil::GetAllocator());
+	// Caches keyed by the texture pointer must drop their entries
+	EventManager::Broadcast(NE_EVT_TEX_RELEASED, this);
 
 	if (_image != VK_NULL_HANDLE)
 		vkDestroyImage(VKUtil::GetDevice(), _image, VKUtil::GetAllocator());
 
+	Renderer::GetInstance()->GetMemoryAllocator()->Free(_allocation);
+
 	if (_view != VK_NULL_HANDLE)
 		vkDestroyImageView(VKUtil::GetDevice(), _view, VKUtil::GetAllocator());
 
@@ -0,0 +1,76 @@
+/* NekoEngine
+ *
+ * VKMemoryDevice.cpp
+ * Author: Alexandru Naiman
+ *
+ * Vulkan backend of the device memory allocator
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Renderer/VKUtil.h>
+#include <Renderer/MemoryAllocator.h>
+
+VKMemoryDevice::VKMemoryDevice()
+{
+	vkGetPhysicalDeviceMemoryProperties(VKUtil::GetPhysicalDevice(), &_properties);
+}
+
+bool VKMemoryDevice::AllocateMemory(uint32_t type, VkDeviceSize size, VkDeviceMemory &memory)
+{
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = type;
+
+	return vkAllocateMemory(VKUtil::GetDevice(), &allocInfo, VKUtil::GetAllocator(), &memory) == VK_SUCCESS;
+}
+
+void VKMemoryDevice::FreeMemory(VkDeviceMemory memory)
+{
+	vkFreeMemory(VKUtil::GetDevice(), memory, VKUtil::GetAllocator());
+}
+
+uint8_t *VKMemoryDevice::MapMemory(VkDeviceMemory memory)
+{
+	uint8_t *ptr{ nullptr };
+
+	if (vkMapMemory(VKUtil::GetDevice(), memory, 0, VK_WHOLE_SIZE, 0, (void **)&ptr) != VK_SUCCESS)
+		return nullptr;
+
+	return ptr;
+}
+
+void VKMemoryDevice::UnmapMemory(VkDeviceMemory memory)
+{
+	vkUnmapMemory(VKUtil::GetDevice(), memory);
+}
@@ -37,16 +37,27 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <atomic>
+
 #include <Scene/Components/AnimatorComponent.h>
 #include <Scene/Components/SkeletalMeshComponent.h>
 #include <Scene/SceneManager.h>
+#include <Scene/CameraManager.h>
 #include <Scene/Object.h>
 #include <Animation/Skeleton.h>
+#include <Animation/AnimationManager.h>
 #include <Renderer/SkeletalMesh.h>
 #include <Engine/ResourceManager.h>
 
+using namespace std;
+using namespace glm;
+
 ENGINE_REGISTER_COMPONENT_CLASS(AnimatorComponent);
 
+// Evaluation interval in frames for each level of detail
+static const uint32_t _lodInterval[ANIM_LOD_COUNT]{ 1, 2, 4, 8 };
+static atomic<uint32_t> _nextFrameOffset{ 0 };
+
 AnimatorComponent::AnimatorComponent(ComponentInitializer *initializer)
 	: ObjectComponent(initializer)
 {
@@ -59,6 +70,12 @@ AnimatorComponent::AnimatorComponent(ComponentInitializer *initializer)
 	_oneShot = false;
 	_prevLoop = false;
 	_prevClip = nullptr;
+	_graph = nullptr;
+	_lod = ANIM_LOD_FULL;
+	
+	// Spread the animators that skip frames evenly over the interval
+	// Components can be created on loader threads
+	_frameOffset = _nextFrameOffset.fetch_add(1, memory_order_relaxed);
 }
 
 int AnimatorComponent::Load()
@@ -84,6 +101,8 @@ int AnimatorComponent::Load()
 	_skeleton = mesh->CreateSkeleton();
 	if(!_skeleton)
 		return ENGINE_FAIL;
+
+	_graph = new AnimationGraph(_skeleton);
 	
 	PlayDefaultAnimation();
 	
@@ -122,11 +141,18 @@ void AnimatorComponent::Update(double deltaTime) noexcept
 {
 	ObjectComponent::Update(deltaTime);
 
-	if (!SceneManager::IsSceneLoaded())
+	if (!SceneManager::IsSceneLoaded() || !_skeleton)
 		return;
 
-	if (_skeleton && _playing)
+	if (_graph && _graph->GetRoot())
 	{
+		_graph->Update(deltaTime);
+	}
+	else
+	{
+		if (!_playing)
+			return;
+
 		_currentTime += deltaTime;
 		
 		if (_currentTime > _skeleton->GetAnimationClip()->GetDuration()) {
@@ -137,17 +163,49 @@ void AnimatorComponent::Update(double deltaTime) noexcept
 				PlayAnimation(_prevClip, _prevLoop);
 			} else {
 				_playing = false;
+				return;
 			}
 		}
+	}
 
-		if (_playing)
-			_skeleton->TransformBones(_currentTime);
+	uint8_t lod{ ANIM_LOD_FULL };
+	Camera *cam{ CameraManager::GetActiveCamera() };
+
+	if (cam)
+	{
+		const AnimationConfig &cfg{ Engine::GetConfiguration().Animation };
+		const float dist{ distance(cam->GetPosition(), _parent->GetPosition()) };
+
+		if (!_parent->GetNoCull() && !cam->GetFrustum().ContainsBounds(_parent->GetTransformedBounds()))
+			lod = ANIM_LOD_HIDDEN;
+		else if (dist > cfg.LOD2Distance)
+			lod = ANIM_LOD_REDUCED;
+		else if (dist > cfg.LOD1Distance)
+			lod = ANIM_LOD_HALF;
 	}
+
+	// Evaluate right away when the detail increases, otherwise wait for this animator's turn
+	const bool due{ lod < _lod || !((AnimationManager::GetFrame() + _frameOffset) % _lodInterval[lod]) };
+	_lod = lod;
+
+	if (!due)
+		return;
+
+	_skeleton->SetReducedDetail(_lod >= ANIM_LOD_REDUCED);
+	AnimationManager::QueueEvaluation(this);
 }
 
-void AnimatorComponent::UpdateData(VkCommandBuffer commandBuffer) noexcept
+void AnimatorComponent::Evaluate() noexcept
 {
-	_skeleton->UpdateData(commandBuffer);
+	if (_graph && _graph->GetRoot())
+	{
+		_graph->Evaluate(_skeleton->GetPose());
+		_skeleton->ComputeTransforms();
+	}
+	else
+	{
+		_skeleton->TransformBones(_currentTime);
+	}
 }
 
 bool AnimatorComponent::Unload()
@@ -158,7 +216,13 @@ bool AnimatorComponent::Unload()
 	if (_defaultAnim)
 		ResourceManager::UnloadResource(_defaultAnim->GetResourceInfo()->id, ResourceType::RES_ANIMCLIP);
 
+	AnimationManager::CancelEvaluation(this);
+
+	delete _graph;
+	_graph = nullptr;
+
 	delete _skeleton;
+	_skeleton = nullptr;
 
 	return true;
 }
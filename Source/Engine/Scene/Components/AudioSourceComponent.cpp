@@ -62,6 +62,13 @@ AudioSourceComponent::AudioSourceComponent(ComponentInitializer *initializer)
 
 	_src->SetGain(Engine::GetConfiguration().Audio.MasterVolume * Engine::GetConfiguration().Audio.EffectsVolume);
 
+	ArgumentMapType::iterator it{};
+	if ((it = initializer->arguments.find("priority")) != initializer->arguments.end())
+		_src->SetPriority((uint8_t)glm::clamp(atoi(it->second.c_str()), ASRC_PRIORITY_LOW, ASRC_PRIORITY_HIGH));
+
+	if ((it = initializer->arguments.find("rolloff")) != initializer->arguments.end())
+		_src->SetRolloffFactor((float)atof(it->second.c_str()));
+
 	_playOnLoad = !initializer->arguments.find("playonload")->second.compare("true") ? true : false;
 }
 
@@ -37,11 +37,10 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <random>
-
 #include <Renderer/VKUtil.h>
 #include <Renderer/DebugMarker.h>
 #include <Renderer/RenderPassManager.h>
+#include <Engine/TaskManager.h>
 #include <Engine/ResourceManager.h>
 #include <Scene/Object.h>
 #include <Scene/CameraManager.h>
@@ -49,17 +48,38 @@
 #include <System/AssetLoader/AssetLoader.h>
 
 #define CPU_PSYSCOMP_MODULE	"CPU_ParticleSystemComponent"
+#define CPU_PSYSCOMP_GRAIN	8192
 
 using namespace glm;
 using namespace std;
 
 ENGINE_REGISTER_COMPONENT_CLASS(CPUParticleSystemComponent);
 
+struct BillboardData
+{
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	vec4 p0;
+};
+
+constexpr VkDeviceSize _billboardDataOffset = 0;
+constexpr VkDeviceSize _drawIndirectCommandOffset = sizeof(BillboardData);
+constexpr VkDeviceSize _vertexBufferOffset = 256;
+
 CPUParticleSystemComponent::CPUParticleSystemComponent(ComponentInitializer *initializer) :
 	ObjectComponent(initializer),
 	_emitter{ nullptr },
-	_particles{},
-	_deadList{}
+	_pool{},
+	_sorter{},
+	_depthSort{ true },
+	_acceleration{ 0.f },
+	_vertices{},
+	_texture{ nullptr },
+	_textureView{ VK_NULL_HANDLE },
+	_particleBuffer{ nullptr },
+	_descriptorPool{ VK_NULL_HANDLE },
+	_descriptorSet{ VK_NULL_HANDLE },
+	_drawCommandBuffer{ VK_NULL_HANDLE }
 {
 	ArgumentMapType::iterator it{};
 	const char *ptr{ nullptr };
@@ -72,8 +92,8 @@ CPUParticleSystemComponent::CPUParticleSystemComponent(ComponentInitializer *ini
 		case EMITTER_CIRCLE: _emitter = new CircleEmitter(); break;
 		case EMITTER_SPHERE: _emitter = new SphereEmitter(); break;
 		case EMITTER_BOX: _emitter = new BoxEmitter(); break;
-		case EMITTER_MESH: _emitter = new BoxEmitter(); break;
-		case EMITTER_POINT: default: _emitter = new SphereEmitter(); break;
+		case EMITTER_MESH: _emitter = new MeshEmitter(); break;
+		case EMITTER_POINT: default: _emitter = new PointEmitter(); break;
 		}
 	}
 
@@ -127,8 +147,17 @@ CPUParticleSystemComponent::CPUParticleSystemComponent(ComponentInitializer *ini
 	if (((it = initializer->arguments.find("colorcurve")) != initializer->arguments.end()) && ((ptr = it->second.c_str()) != nullptr))
 		_emitter->SetColorCurve((uint8_t)atoi(ptr));
 
-	/*if (((it = initializer->arguments.find("particletype")) != initializer->arguments.end()) && ((ptr = it->second.c_str()) != nullptr))
-		_particleType = atoi(ptr);*/
+	if (((it = initializer->arguments.find("acceleration")) != initializer->arguments.end()) && ((ptr = it->second.c_str()) != nullptr))
+		AssetLoader::ReadFloatArray(ptr, 3, &_acceleration.x);
+
+	if (((it = initializer->arguments.find("texture")) != initializer->arguments.end()) && ((ptr = it->second.c_str()) != nullptr))
+		_textureId = ptr;
+
+	if (((it = initializer->arguments.find("seed")) != initializer->arguments.end()) && ((ptr = it->second.c_str()) != nullptr))
+		_emitter->SetSeed(strtoull(ptr, nullptr, 10));
+
+	if (((it = initializer->arguments.find("depthsort")) != initializer->arguments.end()) && ((ptr = it->second.c_str()) != nullptr))
+		_depthSort = atoi(ptr) != 0;
 }
 
 int CPUParticleSystemComponent::Load()
@@ -148,16 +177,165 @@ int CPUParticleSystemComponent::Load()
 	tmp = _parent->GetScale() + _scale;
 	_emitter->SetScale(tmp);
 
-	_emitter->SetParticles(&_particles);
-	_emitter->SetDeadList(&_deadList);
+	_pool.Resize(_emitter->GetMaxParticles());
+	_vertices.reserve(_emitter->GetMaxParticles());
+	_emitter->SetPool(&_pool);
+
+	// The velocity curve eases the speed from the initial velocity to zero
+	_speedCurve.Build(GetCurveFunction(_emitter->GetVelocityCurve()), true);
+	_sizeCurve.Build(GetCurveFunction(_emitter->GetSizeCurve()));
+	_colorCurve.Build(GetCurveFunction(_emitter->GetColorCurve()));
+
+	// Texture
+	{
+		if (!_textureId.empty() && (_texture = (Texture *)ResourceManager::GetResourceByName(_textureId.c_str(), ResourceType::RES_TEXTURE)) == nullptr)
+		{
+			Logger::Log(CPU_PSYSCOMP_MODULE, LOG_CRITICAL, "Failed to load texture %s", _textureId.c_str());
+			return ENGINE_INVALID_RES;
+		}
+
+		// The billboard shader samples a texture array
+		Texture *tex{ _texture ? _texture : Renderer::GetInstance()->GetBlankTexture() };
+		if (!VKUtil::CreateImageView(_textureView, tex->GetImage(), VK_IMAGE_VIEW_TYPE_2D_ARRAY, tex->GetFormat(), VK_IMAGE_ASPECT_COLOR_BIT, 0, tex->GetMipLevels()))
+			return ENGINE_FAIL;
+	}
+
+	// Descriptor pool
+	{
+		VkDescriptorPoolSize poolSizes[2]{};
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSizes[0].descriptorCount = 1;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		poolSizes[1].descriptorCount = 1;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = 2;
+		poolInfo.pPoolSizes = poolSizes;
+		poolInfo.maxSets = 1;
+
+		if (vkCreateDescriptorPool(VKUtil::GetDevice(), &poolInfo, VKUtil::GetAllocator(), &_descriptorPool) != VK_SUCCESS)
+		{
+			Logger::Log(CPU_PSYSCOMP_MODULE, LOG_CRITICAL, "Failed to create descriptor pool");
+			return ENGINE_DESCRIPTOR_POOL_CREATE_FAIL;
+		}
+	}
+
+	// Buffer
+	{
+		VkDeviceSize size{ _vertexBufferOffset + sizeof(ParticleVertex) * glm::max(_pool.GetCapacity(), 1u) };
+		_particleBuffer = new Buffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, nullptr, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		_particleBuffer->Fill(0);
+	}
+
+	// Draw
+	{
+		VkDescriptorSetLayout layout{ PipelineManager::GetDescriptorSetLayout(DESC_LYT_ParticleDraw) };
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = _descriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &layout;
+
+		if (vkAllocateDescriptorSets(VKUtil::GetDevice(), &allocInfo, &_descriptorSet) != VK_SUCCESS)
+		{
+			Logger::Log(CPU_PSYSCOMP_MODULE, LOG_CRITICAL, "Failed to allocate draw descriptor set");
+			return ENGINE_DESCRIPTOR_SET_CREATE_FAIL;
+		}
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = _textureView;
+		imageInfo.sampler = Renderer::GetInstance()->GetNearestSampler();
+
+		VkDescriptorBufferInfo uboInfo{};
+		uboInfo.buffer = _particleBuffer->GetHandle();
+		uboInfo.offset = _billboardDataOffset;
+		uboInfo.range = sizeof(BillboardData);
+
+		VkWriteDescriptorSet descriptorWrites[2]{};
+		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[0].dstSet = _descriptorSet;
+		descriptorWrites[0].dstBinding = 0;
+		descriptorWrites[0].dstArrayElement = 0;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorWrites[0].descriptorCount = 1;
+		descriptorWrites[0].pBufferInfo = &uboInfo;
+		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[1].dstSet = _descriptorSet;
+		descriptorWrites[1].dstBinding = 1;
+		descriptorWrites[1].dstArrayElement = 0;
+		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrites[1].descriptorCount = 1;
+		descriptorWrites[1].pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(VKUtil::GetDevice(), 2, descriptorWrites, 0, nullptr);
+
+		_drawCommandBuffer = VKUtil::CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+		VK_DBG_SET_OBJECT_NAME((uint64_t)_drawCommandBuffer, VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT, "CPU particle system draw command buffer");
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.occlusionQueryEnable = VK_FALSE;
+		inheritanceInfo.renderPass = RenderPassManager::GetRenderPass(RP_Graphics);
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = Renderer::GetInstance()->GetDrawFramebuffer();
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		vkBeginCommandBuffer(_drawCommandBuffer, &beginInfo);
+
+		VkBuffer vb[]{ _particleBuffer->GetHandle() };
+		VkDeviceSize offsets[]{ _vertexBufferOffset };
+		vkCmdBindVertexBuffers(_drawCommandBuffer, 0, 1, vb, offsets);
+
+		int32_t numTextures = 1;
+		vkCmdBindPipeline(_drawCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipeline(PIPE_ParticleDraw));
+		vkCmdPushConstants(_drawCommandBuffer, PipelineManager::GetPipelineLayout(PIPE_LYT_ParticleDraw), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(int32_t), &numTextures);
+		vkCmdBindDescriptorSets(_drawCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineManager::GetPipelineLayout(PIPE_LYT_ParticleDraw), 0, 1, &_descriptorSet, 0, nullptr);
+
+		// The vertex count is written every frame by UpdateData, so the command buffer is recorded once
+		vkCmdDrawIndirect(_drawCommandBuffer, _particleBuffer->GetHandle(), _drawIndirectCommandOffset, 1, 0);
+
+		vkEndCommandBuffer(_drawCommandBuffer);
+	}
+
+	Renderer::GetInstance()->AddParticleDrawCommandBuffer(_drawCommandBuffer);
 
-	return _emitter->InitializeParticles();
+	return ENGINE_OK;
 }
 
 void CPUParticleSystemComponent::Update(double deltaTime) noexcept
 {
 	ObjectComponent::Update(deltaTime);
+
+	if (!_enabled)
+		return;
+
 	_emitter->Update(deltaTime);
+
+	const float dt{ (float)deltaTime };
+	TaskManager::ParallelFor(_pool.GetAliveCount(), CPU_PSYSCOMP_GRAIN, [this, dt](uint32_t begin, uint32_t end) {
+		_pool.Integrate(begin, end, dt, _acceleration, _speedCurve);
+	});
+
+	// Compaction moves particles across chunks; it is serial so the layout
+	// only depends on the simulation, not on the scheduling
+	_pool.RemoveDead();
+
+	Camera *cam{ CameraManager::GetActiveCamera() };
+	const uint32_t *order{ (_depthSort && cam) ? _sorter.Sort(_pool, cam->GetPosition()) : nullptr };
+
+	_vertices.resize(_pool.GetAliveCount());
+	TaskManager::ParallelFor(_pool.GetAliveCount(), CPU_PSYSCOMP_GRAIN, [this, order](uint32_t begin, uint32_t end) {
+		_pool.WriteVertices(begin, end, _vertices.data(),
+			_emitter->GetInitialSize(), _emitter->GetFinalSize(), _sizeCurve,
+			_emitter->GetInitialColor(), _emitter->GetFinalColor(), _colorCurve, order);
+	});
 }
 
 void CPUParticleSystemComponent::UpdatePosition() noexcept
@@ -174,15 +352,25 @@ void CPUParticleSystemComponent::UpdatePosition() noexcept
 
 void CPUParticleSystemComponent::UpdateData(VkCommandBuffer commandBuffer) noexcept
 {
-/*	Camera *cam{ CameraManager::GetActiveCamera() };
+	Camera *cam{ CameraManager::GetActiveCamera() };
+	if (!cam)
+		return;
+
 	BillboardData billboardData
 	{
 		cam->GetProjectionMatrix() * cam->GetView(),
 		vec4(cam->GetPosition(), 1.0)
 	};
 
+	VkDrawIndirectCommand drawCommand{};
+	drawCommand.vertexCount = (uint32_t)_vertices.size();
+	drawCommand.instanceCount = 1;
+
 	_particleBuffer->UpdateData((uint8_t *)&billboardData, _billboardDataOffset, sizeof(BillboardData), commandBuffer);
-	_particleBuffer->UpdateData((uint8_t *)&_emitterData, _emitterDataOffset, sizeof(EmitterData) - sizeof(vec4) - sizeof(vec2), commandBuffer);*/
+	_particleBuffer->UpdateData((uint8_t *)&drawCommand, _drawIndirectCommandOffset, sizeof(VkDrawIndirectCommand), commandBuffer);
+
+	if (!_vertices.empty())
+		_particleBuffer->UpdateData((uint8_t *)_vertices.data(), _vertexBufferOffset, sizeof(ParticleVertex) * _vertices.size(), commandBuffer);
 }
 
 bool CPUParticleSystemComponent::Unload()
@@ -190,6 +378,22 @@ bool CPUParticleSystemComponent::Unload()
 	if (!ObjectComponent::Unload())
 		return false;
 
+	if (_drawCommandBuffer)
+	{
+		Renderer::GetInstance()->RemoveParticleDrawCommandBuffer(_drawCommandBuffer);
+		VKUtil::FreeCommandBuffer(_drawCommandBuffer);
+	}
+
+	if (_descriptorPool != VK_NULL_HANDLE)
+		vkDestroyDescriptorPool(VKUtil::GetDevice(), _descriptorPool, VKUtil::GetAllocator());
+
+	if (_textureView != VK_NULL_HANDLE)
+		vkDestroyImageView(VKUtil::GetDevice(), _textureView, VKUtil::GetAllocator());
+
+	if (_texture)
+		ResourceManager::UnloadResource(_texture->GetResourceId(), ResourceType::RES_TEXTURE);
+
+	delete _particleBuffer;
 	delete _emitter;
 
 	return true;
@@ -494,6 +494,9 @@ void GPUParticleSystemComponent::UpdatePosition() noexcept
 void GPUParticleSystemComponent::UpdateData(VkCommandBuffer commandBuffer) noexcept
 {
 	Camera *cam{ CameraManager::GetActiveCamera() };
+	if (!cam)
+		return;
+
 	BillboardData billboardData
 	{
 		cam->GetProjectionMatrix() * cam->GetView(),
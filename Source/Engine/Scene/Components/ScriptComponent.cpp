@@ -38,15 +38,23 @@
  */
 
 #include <Script/Script.h>
+#include <Script/ScriptScheduler.h>
 #include <System/Logger.h>
 #include <System/VFS/VFS.h>
 #include <Platform/PlatformDetect.h>
 #include <Scene/Components/ScriptComponent.h>
 
+#include <algorithm>
+
 #define SC_COMP_MODULE	"ScriptComponent"
 
+using namespace std;
+
 ENGINE_REGISTER_COMPONENT_CLASS(ScriptComponent);
 
+static vector<ScriptComponent *> _components;
+static mutex _componentsLock;
+
 ScriptComponent::ScriptComponent(ComponentInitializer *initializer)
 	: ObjectComponent(initializer)
 {
@@ -66,12 +74,18 @@ ScriptComponent::ScriptComponent(ComponentInitializer *initializer)
 		unsigned int srcPtr{ (unsigned int)strtoul(ptr, NULL, 10) };
 #endif
 		_scriptSource = (const char *)srcPtr;
+
+		// Sources are named by their content; the address may be reused by another script
+		if (!_scriptFile.Length() && _scriptSource)
+			_scriptFile = NString::StringWithFormat(32, "scriptsrc_%016llx", (unsigned long long)Script::HashSource(_scriptSource, strlen(_scriptSource)));
 	}
 
-	_state = Script::NewState();
+	_state = Script::GetState();
+	_instance = _updateRef = _fixedUpdateRef = _updatePositionRef = LUA_NOREF;
+	_scriptId = ScriptScheduler::RegisterScript(*_scriptFile);
 
-	lua_pushlightuserdata(_state, _parent);
-	lua_setglobal(_state, "parent");
+	lock_guard<mutex> lock{ _componentsLock };
+	_components.push_back(this);
 }
 
 int ScriptComponent::Load()
@@ -80,22 +94,22 @@ int ScriptComponent::Load()
 	if (ret != ENGINE_OK)
 		return ret;
 
-	if (_scriptSource) {
-		if (!Script::LoadSource(_state, _scriptSource))
-			return ENGINE_FAIL;
-	} else {
-		if (!Script::LoadScript(_state, _scriptFile))
-			return ENGINE_FAIL;
-	}
+	const int chunk{ _scriptSource ? Script::LoadSourceChunk(_state, *_scriptFile, _scriptSource) : Script::LoadChunk(_state, _scriptFile) };
+	if (chunk == LUA_NOREF)
+		return ENGINE_FAIL;
 
-	_enabled = true;
+	_instance = Script::NewInstance(_state, chunk, _parent);
+	if (_instance == LUA_NOREF)
+		return ENGINE_FAIL;
+
+	_GetFunctions();
 
-	lua_getglobal(_state, "Load");
+	_enabled = true;
 
-	if (!lua_isfunction(_state, lua_gettop(_state)))
+	if (!_PushFunction("Load"))
 		return ENGINE_OK;
 
-	if (lua_pcall(_state, 0, 1, 0) && lua_gettop(_state))
+	if (_Call(0, 1) && lua_gettop(_state))
 	{
 		Logger::Log(SC_COMP_MODULE, LOG_CRITICAL, "Failed to execute Load() function of script %s: %s", *_scriptFile, lua_tostring(_state, -1));
 		Logger::Log(SC_COMP_MODULE, LOG_DEBUG, "\n%s", *Script::StackDump(_state));
@@ -115,15 +129,10 @@ int ScriptComponent::InitializeComponent()
 	if (ret != ENGINE_OK)
 		return ret;
 
-	lua_getglobal(_state, "InitializeComponent");
-
-	if (!lua_isfunction(_state, lua_gettop(_state)))
-	{
-		lua_pop(_state, 1);
+	if (!_PushFunction("InitializeComponent"))
 		return ENGINE_OK;
-	}
 
-	if (lua_pcall(_state, 0, 1, 0) && lua_gettop(_state))
+	if (_Call(0, 1) && lua_gettop(_state))
 	{
 		Logger::Log(SC_COMP_MODULE, LOG_CRITICAL, "Failed to execute InitializeComponent() function of script %s: %s", *_scriptFile, lua_tostring(_state, -1));
 		Logger::Log(SC_COMP_MODULE, LOG_DEBUG, "\n%s", *Script::StackDump(_state));
@@ -137,6 +146,21 @@ int ScriptComponent::InitializeComponent()
 	return ret;
 }
 
+void ScriptComponent::FixedUpdate() noexcept
+{
+	if (!_enabled || _fixedUpdateRef == LUA_NOREF)
+		return;
+
+	lua_rawgeti(_state, LUA_REGISTRYINDEX, _fixedUpdateRef);
+	lua_pushnumber(_state, Engine::GetFixedDeltaTime());
+	if (_Call(1, 0) && lua_gettop(_state))
+	{
+		Logger::Log(SC_COMP_MODULE, LOG_CRITICAL, "Failed to execute FixedUpdate() function of script %s: %s", *_scriptFile, lua_tostring(_state, -1));
+		Logger::Log(SC_COMP_MODULE, LOG_DEBUG, "\n%s", *Script::StackDump(_state));
+		lua_pop(_state, 1);
+	}
+}
+
 void ScriptComponent::Update(double deltaTime) noexcept
 {
 	if (!_enabled)
@@ -144,19 +168,16 @@ void ScriptComponent::Update(double deltaTime) noexcept
 
 	ObjectComponent::Update(deltaTime);
 
-	lua_getglobal(_state, "Update");
-
-	if (!lua_isfunction(_state, lua_gettop(_state)))
+	if (_updateRef == LUA_NOREF)
 	{
 		Logger::Log(SC_COMP_MODULE, LOG_CRITICAL, "Script %s missing Update() function.", *_scriptFile);
-		Logger::Log(SC_COMP_MODULE, LOG_DEBUG, "\n%s", *Script::StackDump(_state));
-		lua_pop(_state, 1);
 		_enabled = false;
 		return;
 	}
 
+	lua_rawgeti(_state, LUA_REGISTRYINDEX, _updateRef);
 	lua_pushnumber(_state, deltaTime);
-	if (lua_pcall(_state, 1, 0, 0) && lua_gettop(_state))
+	if (_Call(1, 0) && lua_gettop(_state))
 	{
 		Logger::Log(SC_COMP_MODULE, LOG_CRITICAL, "Failed to execute Update() function of script %s: %s", *_scriptFile, lua_tostring(_state, -1));
 		Logger::Log(SC_COMP_MODULE, LOG_DEBUG, "\n%s", *Script::StackDump(_state));
@@ -171,14 +192,11 @@ void ScriptComponent::UpdatePosition() noexcept
 
 	ObjectComponent::UpdatePosition();
 
-	lua_getglobal(_state, "UpdatePosition");
-	if (!lua_isfunction(_state, lua_gettop(_state)))
-	{
-		lua_pop(_state, 1);
+	if (_updatePositionRef == LUA_NOREF)
 		return;
-	}
 
-	if (lua_pcall(_state, 0, 0, 0) && lua_gettop(_state))
+	lua_rawgeti(_state, LUA_REGISTRYINDEX, _updatePositionRef);
+	if (_Call(0, 0) && lua_gettop(_state))
 	{
 		Logger::Log(SC_COMP_MODULE, LOG_CRITICAL, "Failed to execute UpdatePosition() function of script %s: %s", *_scriptFile, lua_tostring(_state, -1));
 		Logger::Log(SC_COMP_MODULE, LOG_DEBUG, "\n%s", *Script::StackDump(_state));
@@ -191,14 +209,10 @@ bool ScriptComponent::Unload()
 	if (!ObjectComponent::Unload())
 		return false;
 
-	lua_getglobal(_state, "Unload");
-	if (!lua_isfunction(_state, lua_gettop(_state)))
-	{
-		lua_pop(_state, 1);
+	if (!_PushFunction("Unload"))
 		return true;
-	}
 
-	if (lua_pcall(_state, 0, 1, 0) && lua_gettop(_state))
+	if (_Call(0, 1) && lua_gettop(_state))
 	{
 		Logger::Log(SC_COMP_MODULE, LOG_CRITICAL, "Failed to execute Unload() function of script %s: %s", *_scriptFile, lua_tostring(_state, -1));
 		Logger::Log(SC_COMP_MODULE, LOG_DEBUG, "\n%s", *Script::StackDump(_state));
@@ -217,14 +231,10 @@ bool ScriptComponent::CanUnload()
 	if (!ObjectComponent::CanUnload())
 		return false;
 
-	lua_getglobal(_state, "CanUnload");
-	if (!lua_isfunction(_state, lua_gettop(_state)))
-	{
-		lua_pop(_state, 1);
+	if (!_PushFunction("CanUnload"))
 		return true;
-	}
 
-	if (lua_pcall(_state, 0, 1, 0) && lua_gettop(_state))
+	if (_Call(0, 1) && lua_gettop(_state))
 	{
 		Logger::Log(SC_COMP_MODULE, LOG_CRITICAL, "Failed to execute CanUnload() function of script %s: %s", *_scriptFile, lua_tostring(_state, -1));
 		Logger::Log(SC_COMP_MODULE, LOG_DEBUG, "\n%s", *Script::StackDump(_state));
@@ -240,14 +250,10 @@ bool ScriptComponent::CanUnload()
 
 bool ScriptComponent::Invoke(const char *name)
 {
-	lua_getglobal(_state, name);
-	if (!lua_isfunction(_state, lua_gettop(_state)))
-	{
-		lua_pop(_state, 1);
+	if (!_PushFunction(name))
 		return false;
-	}
 
-	if (lua_pcall(_state, 0, 1, 0) && lua_gettop(_state))
+	if (_Call(0, 1) && lua_gettop(_state))
 	{
 		Logger::Log(SC_COMP_MODULE, LOG_CRITICAL, "Failed to execute %s() function of script %s: %s", name, *_scriptFile, lua_tostring(_state, -1));
 		Logger::Log(SC_COMP_MODULE, LOG_DEBUG, "\n%s", *Script::StackDump(_state));
@@ -255,16 +261,127 @@ bool ScriptComponent::Invoke(const char *name)
 		return false;
 	}
 
+	lua_pop(_state, 1);
+
 	return true;
 }
 
 void ScriptComponent::SetGlobalInteger(const char *name, int value)
 {
+	if (_instance == LUA_NOREF)
+		return;
+
+	lua_rawgeti(_state, LUA_REGISTRYINDEX, _instance);
 	lua_pushinteger(_state, value);
-	lua_setglobal(_state, name);
+	lua_setfield(_state, -2, name);
+	lua_pop(_state, 1);
+}
+
+static inline bool _sc_SamePath(const char *a, const char *b)
+{
+	while (*a == '/') ++a;
+	while (*b == '/') ++b;
+	return !strcmp(a, b);
+}
+
+int ScriptComponent::ReloadScript(const char *file)
+{
+	lua_State *state{ Script::GetState() };
+	vector<ScriptComponent *> components{};
+
+	{
+		lock_guard<mutex> lock{ _componentsLock };
+		for (ScriptComponent *comp : _components)
+			if (!comp->_scriptSource && comp->_state == state && comp->_instance != LUA_NOREF && _sc_SamePath(*comp->_scriptFile, file))
+				components.push_back(comp);
+	}
+
+	if (components.empty())
+		return 0;
+
+	// Chunks are cached under the name the components loaded them with
+	const int chunk{ Script::ReloadChunk(state, components[0]->_scriptFile) };
+	if (chunk == LUA_NOREF)
+		return 0;
+
+	int count{ 0 };
+	for (ScriptComponent *comp : components)
+		if (comp->_Reload(chunk))
+			++count;
+
+	Logger::Log(SC_COMP_MODULE, LOG_INFORMATION, "Reloaded script %s in %d of %d components", file, count, (int)components.size());
+
+	return count;
+}
+
+bool ScriptComponent::_Reload(int chunk)
+{
+	if (!Script::ReloadInstance(_state, chunk, _instance))
+		return false;
+
+	Script::Unref(_state, _updateRef);
+	Script::Unref(_state, _fixedUpdateRef);
+	Script::Unref(_state, _updatePositionRef);
+
+	_GetFunctions();
+
+	if (_PushFunction("OnReload") && _Call(0, 0) && lua_gettop(_state))
+	{
+		Logger::Log(SC_COMP_MODULE, LOG_CRITICAL, "Failed to execute OnReload() function of script %s: %s", *_scriptFile, lua_tostring(_state, -1));
+		lua_pop(_state, 1);
+	}
+
+	return true;
+}
+
+void ScriptComponent::_GetFunctions()
+{
+	_updateRef = Script::GetFunction(_state, _instance, "Update");
+	_fixedUpdateRef = Script::GetFunction(_state, _instance, "FixedUpdate");
+	_updatePositionRef = Script::GetFunction(_state, _instance, "UpdatePosition");
+}
+
+int ScriptComponent::_Call(int nargs, int nresults)
+{
+	const int ret{ ScriptScheduler::Call(_state, nargs, nresults, _scriptId, this) };
+
+	if (ScriptScheduler::Aborted())
+	{
+		Logger::Log(SC_COMP_MODULE, LOG_CRITICAL, "Script %s exceeded the instruction budget and was disabled", *_scriptFile);
+		_enabled = false;
+	}
+
+	return ret;
+}
+
+bool ScriptComponent::_PushFunction(const char *name)
+{
+	if (_instance == LUA_NOREF)
+		return false;
+
+	lua_rawgeti(_state, LUA_REGISTRYINDEX, _instance);
+	lua_pushstring(_state, name);
+	lua_rawget(_state, -2);
+	lua_remove(_state, -2);
+
+	if (lua_isfunction(_state, -1))
+		return true;
+
+	lua_pop(_state, 1);
+	return false;
 }
 
 ScriptComponent::~ScriptComponent() noexcept
 {
-	lua_close(_state);
+	{
+		lock_guard<mutex> lock{ _componentsLock };
+		_components.erase(remove(_components.begin(), _components.end(), this), _components.end());
+	}
+
+	ScriptScheduler::Cancel(this);
+
+	Script::Unref(_state, _updateRef);
+	Script::Unref(_state, _fixedUpdateRef);
+	Script::Unref(_state, _updatePositionRef);
+	Script::Unref(_state, _instance);
 }
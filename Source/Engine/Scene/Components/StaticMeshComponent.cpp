@@ -42,6 +42,7 @@
 #include <Scene/Components/StaticMeshComponent.h>
 #include <Engine/ResourceManager.h>
 #include <Renderer/Primitives.h>
+#include <Renderer/InstanceManager.h>
 #include <System/Logger.h>
 
 using namespace glm;
@@ -222,12 +223,7 @@ bool StaticMeshComponent::Unload()
 	if(!ObjectComponent::Unload())
 		return false;
 	
-	for (Drawable &drawable : _drawables)
-	{
-		if (drawable.depthCommandBuffer != VK_NULL_HANDLE)
-			Renderer::GetInstance()->FreeMeshCommandBuffer(drawable.depthCommandBuffer);
-		Renderer::GetInstance()->FreeMeshCommandBuffer(drawable.sceneCommandBuffer);
-	}
+	_FreeCommandBuffers();
 
 	for(NString matId : _materialIds)
 		ResourceManager::UnloadResourceByName(*matId, ResourceType::RES_MATERIAL);
@@ -256,12 +252,7 @@ bool StaticMeshComponent::InitDrawables()
 {
 	bool buildDepth = true;
 
-	for (Drawable &drawable : _drawables)
-	{
-		if (drawable.depthCommandBuffer != VK_NULL_HANDLE)
-			Renderer::GetInstance()->FreeMeshCommandBuffer(drawable.depthCommandBuffer);
-		Renderer::GetInstance()->FreeMeshCommandBuffer(drawable.sceneCommandBuffer);
-	}
+	_FreeCommandBuffers();
 
 	if (_materials[0]->GetType() == MT_Skysphere)
 		buildDepth = false;
@@ -287,7 +278,10 @@ bool StaticMeshComponent::InitDrawables()
 		return false;
 
 	for (Drawable &drawable : _drawables)
+	{
 		drawable.visible = &_visible;
+		drawable.instanceData = &_objectData;
+	}
 
 	return true;
 }
@@ -296,17 +290,30 @@ bool StaticMeshComponent::RebuildCommandBuffers()
 {
 	bool buildDepth = true;
 
+	_FreeCommandBuffers();
+
+	if (_materials[0]->GetType() == MT_Skysphere)
+		buildDepth = false;
+
+	return _mesh->BuildDrawables(_materials, _descriptorSet, _drawables, buildDepth, false);
+}
+
+void StaticMeshComponent::_FreeCommandBuffers()
+{
 	for (Drawable &drawable : _drawables)
 	{
 		if (drawable.depthCommandBuffer != VK_NULL_HANDLE)
 			Renderer::GetInstance()->FreeMeshCommandBuffer(drawable.depthCommandBuffer);
 		Renderer::GetInstance()->FreeMeshCommandBuffer(drawable.sceneCommandBuffer);
-	}
 
-	if (_materials[0]->GetType() == MT_Skysphere)
-		buildDepth = false;
+		if (drawable.instancedDepthCommandBuffer != VK_NULL_HANDLE)
+			Renderer::GetInstance()->FreeMeshCommandBuffer(drawable.instancedDepthCommandBuffer);
+		if (drawable.instancedSceneCommandBuffer != VK_NULL_HANDLE)
+			Renderer::GetInstance()->FreeMeshCommandBuffer(drawable.instancedSceneCommandBuffer);
 
-	return _mesh->BuildDrawables(_materials, _descriptorSet, _drawables, buildDepth, false);
+		InstanceManager::FreeCommand(drawable.instanceCommand);
+		drawable.instanceCommand = INST_NO_COMMAND;
+	}
 }
 
 void StaticMeshComponent::_SortGroups()
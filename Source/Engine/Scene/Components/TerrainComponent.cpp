@@ -44,6 +44,7 @@
 #include <Renderer/ShadowRenderer.h>
 #include <Renderer/DebugMarker.h>
 #include <Scene/Object.h>
+#include <Scene/CameraManager.h>
 #include <Scene/Components/TerrainComponent.h>
 
 using namespace glm;
@@ -54,8 +55,12 @@ ENGINE_REGISTER_COMPONENT_CLASS(TerrainComponent);
 
 TerrainComponent::TerrainComponent(ComponentInitializer *initializer) :
 	StaticMeshComponent(initializer),
+	_drawCount(0),
+	_selectionChanged(false),
 	_cellSize(20.f),
 	_numCells(4),
+	_chunkCells(TQT_DEFAULT_CHUNK_CELLS),
+	_lodDistance(TQT_DEFAULT_LOD_DISTANCE),
 	_uvStep(0.f),
 	_heightmapPath(),
 	_heightmapData(nullptr),
@@ -75,6 +80,12 @@ TerrainComponent::TerrainComponent(ComponentInitializer *initializer) :
 
 	ptr = initializer->arguments.find("cellsize")->second.c_str();
 	_cellSize = ptr ? (float)atof(ptr) : 20;
+
+	if (((it = initializer->arguments.find("chunkcells")) != initializer->arguments.end()) && ((ptr = it->second.c_str()) != nullptr))
+		_chunkCells = (uint32_t)atoi(ptr);
+
+	if (((it = initializer->arguments.find("loddistance")) != initializer->arguments.end()) && ((ptr = it->second.c_str()) != nullptr))
+		_lodDistance = (float)atof(ptr);
 	
 	if (((it = initializer->arguments.find("heightmap")) != initializer->arguments.end()) && ((ptr = it->second.c_str()) != nullptr))
 	{
@@ -93,17 +104,28 @@ int TerrainComponent::Load()
 	if (!_GenerateTerrain())
 		return ENGINE_FAIL;
 
+	if (!_materials.Count())
+	{
+		Logger::Log(TERRAIN_COMPONENT_MODULE, LOG_CRITICAL, "No material set");
+		return ENGINE_INVALID_RES;
+	}
+
 	_mesh->_depthPipelineId = PIPE_Terrain_Depth;
-	_mesh->_groups.push_back({ 0, (uint32_t)_terrainVertices.size(), 0, (uint32_t)_terrainIndices.size() });
 
-	_parent->SetNoCull(true);
+	// A single group; the chunks are drawn from the indirect commands
+	_mesh->_groups.push_back({ 0, (uint32_t)_quadtree.GetVertices().size(), 0, (uint32_t)_quadtree.GetIndices().size() });
+	_mesh->_indirectDrawCount = (uint32_t)_quadtree.GetChunks().size();
+	_drawCommands.assign(_quadtree.GetChunks().size(), {});
+
+	_parent->SetBounds(_quadtree.GetBounds());
 
 	return ENGINE_OK;
 }
 
 VkDeviceSize TerrainComponent::GetRequiredMemorySize() const noexcept
 {
-	VkDeviceSize size = sizeof(TerrainVertex) * _terrainVertices.size() + sizeof(uint32_t) * _terrainIndices.size();
+	VkDeviceSize size = sizeof(TerrainVertex) * _quadtree.GetVertices().size() + sizeof(uint32_t) * _quadtree.GetIndices().size() +
+		sizeof(VkDrawIndexedIndirectCommand) * _drawCommands.size();
 	if (size % 256)
 	{
 		size = size / 256;
@@ -120,80 +142,114 @@ bool TerrainComponent::Upload(Buffer *buffer)
 	_mesh->_buffer = buffer;
 
 	VkDeviceSize bufferSize = GetRequiredMemorySize();
-	Buffer *stagingBuffer = new Buffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, nullptr, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	Buffer *stagingBuffer = Renderer::GetInstance()->GetStagingBuffer(bufferSize);
 
 	uint8_t *ptr = stagingBuffer->Map();
 	if (!ptr)
 	{
 		Logger::Log(TERRAIN_COMPONENT_MODULE, LOG_CRITICAL, "Failed to map memory");
+		Renderer::GetInstance()->FreeStagingBuffer(stagingBuffer);
 		return false;
 	}
 
-	memcpy(ptr, _terrainVertices.data(), sizeof(_terrainVertices[0]) * _terrainVertices.size());
-	memcpy(ptr + sizeof(_terrainVertices[0]) * _terrainVertices.size(), _terrainIndices.data(), sizeof(_terrainIndices[0]) * _terrainIndices.size());
+	const std::vector<TerrainVertex> &vertices{ _quadtree.GetVertices() };
+	const std::vector<uint32_t> &indices{ _quadtree.GetIndices() };
+
+	const VkDeviceSize indexOffset{ sizeof(vertices[0]) * vertices.size() };
+	const VkDeviceSize commandOffset{ indexOffset + sizeof(indices[0]) * indices.size() };
+	const VkDeviceSize commandSize{ sizeof(VkDrawIndexedIndirectCommand) * _drawCommands.size() };
+
+	memcpy(ptr, vertices.data(), indexOffset);
+	memcpy(ptr + indexOffset, indices.data(), commandOffset - indexOffset);
+	memset(ptr + commandOffset, 0x0, commandSize);
 
 	stagingBuffer->Unmap();
 
 	stagingBuffer->Copy(_mesh->_buffer, bufferSize);
 
-	delete stagingBuffer;
+	Renderer::GetInstance()->FreeStagingBuffer(stagingBuffer);
 
 	_mesh->_vertexOffset = _mesh->_buffer->GetParentOffset();
-	_mesh->_indexOffset = _mesh->_vertexOffset + sizeof(_terrainVertices[0]) * _terrainVertices.size();
+	_mesh->_indexOffset = _mesh->_vertexOffset + indexOffset;
+
+	delete _mesh->_indirectBuffer;
+	_mesh->_indirectBuffer = new Buffer(_mesh->_buffer, _mesh->_vertexOffset + commandOffset, commandSize);
+	_drawCount = 0;
 
 	_mesh->_resident = true;
 
 	return true;
 }
 
+void TerrainComponent::Update(double deltaTime) noexcept
+{
+	StaticMeshComponent::Update(deltaTime);
+	_SelectChunks();
+}
+
+void TerrainComponent::UpdateData(VkCommandBuffer commandBuffer) noexcept
+{
+	StaticMeshComponent::UpdateData(commandBuffer);
+
+	Camera *cam{ CameraManager::GetActiveCamera() };
+	if (!_mesh->_indirectBuffer || !cam)
+		return;
+
+	// Cull the selected chunks in terrain space
+	mat4 viewProjection{ cam->GetProjectionMatrix() * cam->GetView() * _objectData.model };
+	NFrustum frustum{};
+	frustum.FromViewProjection(viewProjection);
+
+	const std::vector<TerrainChunk> &chunks{ _quadtree.GetChunks() };
+	uint32_t count{ 0 };
+
+	for (uint32_t id : _selectedChunks)
+	{
+		if (!frustum.ContainsBounds(chunks[id].bounds))
+			continue;
+
+		_drawCommands[count++] = { chunks[id].indexCount, 1, chunks[id].indexOffset, 0, 0 };
+	}
+
+	// Clear the commands left over from the last frame
+	const uint32_t uploadCount{ std::max(count, _drawCount) };
+	memset(_drawCommands.data() + count, 0x0, sizeof(VkDrawIndexedIndirectCommand) * (uploadCount - count));
+	_drawCount = count;
+
+	Renderer::GetInstance()->UploadFrameData(_mesh->_indirectBuffer, 0, (uint8_t *)_drawCommands.data(), sizeof(VkDrawIndexedIndirectCommand) * uploadCount, commandBuffer);
+}
+
+bool TerrainComponent::InitDrawables()
+{
+	if (!StaticMeshComponent::InitDrawables())
+		return false;
+
+	_drawables[0].bounds = _quadtree.GetBounds();
+
+	_updateModelMatrix = true;
+	_SelectChunks();
+
+	return true;
+}
+
 bool TerrainComponent::_GenerateTerrain() noexcept
 {
 	_uvStep = 1.f / (float)_numCells;
 
-	TerrainVertex v;
-	v.position = vec3();
-	v.normal = vec3(0.f, 1.f, 0.f);
-	v.tangent = vec3();
-
 	if (_heightmapPath.Length() && !_LoadHeightmap())
 		return false;
 
-	for (int i = 0; i <= _numCells; i++)
-	{
-		for (int j = 0; j <= _numCells; j++)
-		{
-			v.uv.x = (float)j;
-			v.uv.y = (float)i;
-
-			v.heightmapUV.x = _uvStep * j;
-			v.heightmapUV.y = _uvStep * i;
-
-			v.position.x = (j - _numCells / 2.f) * _cellSize;
-			v.position.z = -((_numCells / 2.f) - i) * _cellSize;
-
-			if (_heightmapPath.Length())
-				v.position.y = _ReadHeightmap(v.heightmapUV.x, v.heightmapUV.y) * _maxHeight;
-
-			_terrainVertices.push_back(v);
-
-			if (i < _numCells && j < _numCells)
-			{
-				int indexOffset = j + i * (_numCells + 1);
-				_terrainIndices.push_back(indexOffset + _numCells + 1);
-				_terrainIndices.push_back(indexOffset + 1);
-				_terrainIndices.push_back(indexOffset);
-
-				indexOffset++;
-				_terrainIndices.push_back(indexOffset + _numCells);
-				_terrainIndices.push_back(indexOffset + _numCells + 1);
-				_terrainIndices.push_back(indexOffset);
-			}
-		}
-	}
+	bool ret = _quadtree.Build(_numCells, _chunkCells, _cellSize, [this](uint32_t x, uint32_t z) -> float {
+		return _heightmapData ? _ReadHeightmap(_uvStep * x, _uvStep * z) * _maxHeight : 0.f;
+	});
 
 	free(_heightmapData); _heightmapData = nullptr;
 
-	return true;
+	if (ret)
+		Logger::Log(TERRAIN_COMPONENT_MODULE, LOG_DEBUG, "Generated %d chunks of %d cells, depth %d",
+			(int)_quadtree.GetChunks().size(), _quadtree.GetChunkCells(), _quadtree.GetDepth());
+
+	return ret;
 }
 
 bool TerrainComponent::_LoadHeightmap() noexcept
@@ -235,9 +291,28 @@ bool TerrainComponent::Unload()
 
 	free(_heightmapData); _heightmapData = nullptr;
 
+	_quadtree.Clear();
+	_selectedChunks.clear();
+	_drawCommands.clear();
+	_drawCount = 0;
+
 	return true;
 }
 
+void TerrainComponent::_SelectChunks() noexcept
+{
+	Camera *cam{ CameraManager::GetActiveCamera() };
+	if (_quadtree.GetChunks().empty() || !cam)
+		return;
+
+	// Select in terrain space so the LOD distances follow the object's scale
+	vec3 viewPosition{ inverse(_objectData.model) * vec4(cam->GetPosition(), 1.f) };
+	_quadtree.Select(viewPosition, _lodDistance, nullptr, _nextSelection);
+
+	_selectionChanged = _nextSelection != _selectedChunks;
+	_selectedChunks.swap(_nextSelection);
+}
+
 void TerrainComponent::DrawShadow(VkCommandBuffer commandBuffer, uint32_t shadowId) const noexcept
 {
 	ObjectComponent::DrawShadow(commandBuffer, shadowId);
@@ -256,6 +331,7 @@ void TerrainComponent::DrawShadow(VkCommandBuffer commandBuffer, uint32_t shadow
 
 	VK_DBG_MARKER_INSERT(commandBuffer, "terrain mesh", vec4(0.0, 0.5, 1.0, 1.0));
 
-	for (size_t i = 0; i < _mesh->GetGroupCount(); ++i)
-		vkCmdDrawIndexed(commandBuffer, _mesh->GetGroupIndexCount((uint32_t)i), 1, _mesh->GetGroupIndexOffset((uint32_t)i), 0, 0);
+	const std::vector<TerrainChunk> &chunks{ _quadtree.GetChunks() };
+	for (uint32_t id : _selectedChunks)
+		vkCmdDrawIndexed(commandBuffer, chunks[id].indexCount, 1, chunks[id].indexOffset, 0, 0);
 }
\ No newline at end of file
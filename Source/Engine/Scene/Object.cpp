@@ -91,6 +91,8 @@ Object::Object(ObjectInitializer *initializer) noexcept
 	_updateModelMatrix = false;
 	_haveMesh = false;
 	_visible = true;
+	_fixedFrame = UINT64_MAX;
+	_interpolating = false;
 
 	SetForwardDirection(ForwardDirection::PositiveZ);
 	SetPosition(initializer->position);
@@ -125,18 +127,29 @@ Object::Object(ObjectInitializer *initializer) noexcept
 
 void Object::SetPosition(vec3 &position) noexcept
 {
+	_SavePreviousTransform();
+
 	_position = position;
 	_translationMatrix = translate(mat4(), _position);
 	_updateModelMatrix = true;
 
+	// Changes made outside the simulation are not interpolated
+	if (!Engine::InFixedUpdate())
+		_prevPosition = _position;
+
 	EventManager::Broadcast(NE_EVT_OBJ_MOVED, this);
 }
 
 void Object::SetRotation(vec3 &rotation) noexcept
 {
+	_SavePreviousTransform();
+
 	_rotation = rotation;
 	_rotationQuaternion = rotate(quat(), radians(rotation));
 
+	if (!Engine::InFixedUpdate())
+		_prevRotationQuaternion = _rotationQuaternion;
+
 	SetForwardDirection(_objectForward);
 
 	_updateModelMatrix = true;
@@ -227,14 +240,14 @@ void Object::LookAt(const vec3 &point) noexcept
 
 void Object::MoveForward(float distance) noexcept
 {
-	_position += _forward * distance;
-	SetPosition(_position);
+	vec3 position{ _position + _forward * distance };
+	SetPosition(position);
 }
 
 void Object::MoveRight(float distance) noexcept
 {
-	_position += _right * distance;
-	SetPosition(_position);
+	vec3 position{ _position + _right * distance };
+	SetPosition(position);
 }
 
 size_t Object::GetVertexCount() noexcept
@@ -284,8 +297,8 @@ void Object::FixedUpdate() noexcept
 	if (!_loaded)
 		return;
 
-	/*for (pair<string, ObjectComponent*> kvp : _components)
-		if (kvp.second->IsEnabled()) kvp.second->Update(deltaTime);*/
+	for (pair<string, ObjectComponent*> kvp : _components)
+		if (kvp.second->IsEnabled()) kvp.second->FixedUpdate();
 }
 
 void Object::Update(double deltaTime) noexcept
@@ -403,15 +416,61 @@ void Object::DrawShadow(VkCommandBuffer commandBuffer, uint32_t shadowId) const
 		kvp.second->DrawShadow(commandBuffer, shadowId);
 }
 
+bool Object::HasAnimatedShadow() const noexcept
+{
+	for (const pair<const string, ObjectComponent *> &kvp : _components)
+		if (kvp.second->HasAnimatedShadow())
+			return true;
+
+	return false;
+}
+
 void Object::UpdateData(VkCommandBuffer commandBuffer) noexcept
 {
 	if (_updateModelMatrix)
 		_UpdateModelMatrix();
 
+	// Objects moved by the last fixed step are drawn between their previous
+	// and current state; once they stop, the exact transform is restored
+	if (_fixedFrame == Engine::GetFixedFrame())
+	{
+		_InterpolateModelMatrix(Engine::GetInterpolationFactor());
+		_interpolating = true;
+	}
+	else if (_interpolating)
+	{
+		_InterpolateModelMatrix(1.f);
+		_interpolating = false;
+	}
+
 	for (pair<string, ObjectComponent*> kvp : _components)
 		kvp.second->UpdateData(commandBuffer);
 }
 
+void Object::_SavePreviousTransform() noexcept
+{
+	// The first change made in a fixed step keeps the state of the step before it
+	if (!Engine::InFixedUpdate() || _fixedFrame == Engine::GetFixedFrame())
+		return;
+
+	_prevPosition = _position;
+	_prevRotationQuaternion = _rotationQuaternion;
+	_fixedFrame = Engine::GetFixedFrame();
+}
+
+void Object::_InterpolateModelMatrix(float alpha) noexcept
+{
+	if (!_haveMesh)
+		return;
+
+	if (alpha < 1.f)
+		_modelMatrix = (translate(mat4(), mix(_prevPosition, _position, alpha)) * mat4_cast(slerp(_prevRotationQuaternion, _rotationQuaternion, alpha))) * _scaleMatrix;
+	else
+		_modelMatrix = (_translationMatrix * mat4_cast(_rotationQuaternion)) * _scaleMatrix;
+
+	_UpdateTransformedBounds();
+}
+
 Object::~Object() noexcept
 {
 	Unload();
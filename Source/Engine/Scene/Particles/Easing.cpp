@@ -40,8 +40,44 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 
+#include <System/Logger.h>
 #include <Scene/Particles/Easing.h>
 
+#define EASING_MODULE	"Easing"
+
+CurveFunction GetCurveFunction(uint8_t id)
+{
+	switch (id)
+	{
+		case PART_UPD_CURVE_LINEAR: return &linearEase;
+		case PART_UPD_CURVE_QUADRATIC: return &quadraticEaseInOut;
+		case PART_UPD_CURVE_CUBIC: return &cubicEaseInOut;
+		case PART_UPD_CURVE_QUARTIC: return &quarticEaseInOut;
+		case PART_UPD_CURVE_QUINTIC: return &quinticEaseInOut;
+		case PART_UPD_CURVE_SINE: return &sineEaseInOut;
+		case PART_UPD_CURVE_CIRCULAR: return &circularEaseInOut;
+		case PART_UPD_CURVE_EXPONENTIAL: return &exponentialEaseInOut;
+		case PART_UPD_CURVE_ELASTIC: return &elasticEaseInOut;
+		case PART_UPD_CURVE_BACK: return &backEaseInOut;
+		case PART_UPD_CURVE_BOUNCE: return &bounceEaseInOut;
+	}
+
+	Logger::Log(EASING_MODULE, LOG_WARNING, "Unknown curve specified %d; using linear", id);
+
+	return &linearEase;
+}
+
+void EasingTable::Build(CurveFunction curve, bool invert) noexcept
+{
+	for (int32_t i = 0; i <= EASING_TABLE_SIZE; ++i)
+	{
+		const double v{ curve((double)i / EASING_TABLE_SIZE) };
+		values[i] = (float)(invert ? 1.0 - v : v);
+	}
+
+	values[EASING_TABLE_SIZE + 1] = values[EASING_TABLE_SIZE];
+}
+
 double linearEase(double p)
 {
 	return p;
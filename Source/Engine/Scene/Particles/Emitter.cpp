@@ -40,26 +40,25 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 
-#include <System/Logger.h>
-#include <Scene/SceneManager.h>
+#include <Engine/TaskManager.h>
 #include <Scene/Particles/Emitter.h>
 
-#define EMITTER_MODULE	"Emitter"
+#define EMITTER_MIN_LIFESPAN	.0001
+#define EMITTER_EMIT_GRAIN		4096
 
 using namespace glm;
 
 Emitter::Emitter() :
-	_particles{ nullptr },
+	_pool{ nullptr },
 	_position{ 0.f }, _rotation{ 0.f }, _scale{ 0.f },
 	_maxEmit{ 0 }, _maxParticles{ 0 },
+	_velocityCurve{ PART_UPD_CURVE_LINEAR }, _colorCurve{ PART_UPD_CURVE_LINEAR }, _sizeCurve{ PART_UPD_CURVE_LINEAR },
 	_emitRate{ 0.0 }, _nextEmit{ 0.0 },
 	_initialSize{ 0.0 }, _finalSize{ 0.0 },
 	_lifespan{ 0.0 },
 	_initialVelocity{ 0.f },
 	_initialColor{ 0.f }, _finalColor{ 0.f },
-	_particleClass{ "Particle" },
-	_particleInitializer{},
-	_deadList{ nullptr }
+	_seed{ 0 }, _emission{ 0 }
 { }
 Emitter::~Emitter() { }
 QuadEmitter::QuadEmitter() : Emitter() { }
@@ -75,40 +74,6 @@ PointEmitter::~PointEmitter() { }
 MeshEmitter::MeshEmitter() : Emitter() { }
 MeshEmitter::~MeshEmitter() { }
 
-int Emitter::InitializeParticles()
-{
-	_particleClass = "MeshParticle";
-
-	_particleInitializer.arguments.insert({ "mesh", "stm_m_house" });
-	_particleInitializer.arguments.insert({ "material", "mat_m_house" });
-	
-	for (uint32_t i = 0; i < _maxParticles; ++i)
-	{
-		Particle *p{ (Particle *)Engine::NewObject(*_particleClass, &_particleInitializer) };
-		if (!p)
-		{
-			Logger::Log(EMITTER_MODULE, LOG_CRITICAL, "Failed to create particle %d of type %s", i, *_particleClass);
-			return ENGINE_FAIL;
-		}
-
-		p->SetVelocityCurve(PART_UPD_CURVE_LINEAR);
-		p->SetSizeCurve(PART_UPD_CURVE_LINEAR);
-		p->SetColorCurve(PART_UPD_CURVE_LINEAR);
-
-		if (p->Load())
-		{
-			Logger::Log(EMITTER_MODULE, LOG_CRITICAL, "Failed to load particle %d of type %s", i, *_particleClass);
-			return ENGINE_FAIL;
-		}
-		
-		//SceneManager::GetLoadingScene()->AddObject(p);
-
-		_particles->Add(p);
-		_deadList->Add(i);
-	}
-	return ENGINE_OK;
-}
-
 void Emitter::Update(double deltaTime) noexcept
 {
 	_nextEmit -= deltaTime;
@@ -119,111 +84,94 @@ void Emitter::Update(double deltaTime) noexcept
 
 void Emitter::Emit()
 {
-//	uint32_t firstParticle{ 0 };
+	if (!_pool)
+		return;
 
-	int64_t bound = _maxEmit > (int64_t)_deadList->Count() ? _maxEmit : (int64_t)_deadList->Count();
+	const uint32_t first{ _pool->GetAliveCount() };
+	const uint32_t count{ _pool->Emit(_maxEmit) };
 
-	for (int64_t i = 0; i < bound; ++i)
-	{
-		uint32_t id = (*_deadList)[0];
-		_EmitParticle(id);
-		//_deadList->Remove(0);
-	}
+	ParticleData &data{ _pool->GetData() };
+	const float invLifespan{ (float)(1.0 / glm::max(_lifespan, EMITTER_MIN_LIFESPAN)) };
+	const uint64_t emission{ _emission++ };
+	const uint32_t chunks{ (count + EMITTER_EMIT_GRAIN - 1) / EMITTER_EMIT_GRAIN };
+
+	TaskManager::ParallelFor(chunks, 1, [&](uint32_t firstChunk, uint32_t lastChunk) {
+		for (uint32_t c = firstChunk; c < lastChunk; ++c)
+		{
+			ParticleRandom random{ _seed, (emission << 32) | c };
+			const uint32_t end{ first + glm::min((c + 1) * EMITTER_EMIT_GRAIN, count) };
+
+			for (uint32_t id = first + c * EMITTER_EMIT_GRAIN; id < end; ++id)
+			{
+				data.velocityX[id] = _initialVelocity.x;
+				data.velocityY[id] = _initialVelocity.y;
+				data.velocityZ[id] = _initialVelocity.z;
+				data.age[id] = 0.f;
+				data.invLifespan[id] = invLifespan;
+
+				_EmitParticle(data, id, random);
+			}
+		}
+	});
 }
 
-void QuadEmitter::_EmitParticle(uint32_t id)
+static inline void _em_SetPosition(ParticleData &data, uint32_t id, const vec3 &pos)
 {
-	Particle *p{ (*_particles)[id] };
+	data.positionX[id] = pos.x;
+	data.positionY[id] = pos.y;
+	data.positionZ[id] = pos.z;
+}
 
+void QuadEmitter::_EmitParticle(ParticleData &data, uint32_t id, ParticleRandom &random)
+{
 	vec3 pos{ _position };
 
-	uint32_t x = (uint32_t)(_scale.x / 2.f);
-	uint32_t y = (uint32_t)(_scale.y / 2.f);
+	pos.x += (random.NextFloat() - .5f) * _scale.x;
+	pos.y += (random.NextFloat() - .5f) * _scale.y;
 
-	pos.x += (Platform::Rand() % x) + 1;
-	pos.y += (Platform::Rand() % y) + 1;
-
-	p->SetPosition(pos);
-	p->SetLifespan(_lifespan);
-	p->SetAge(0);
-	p->SetVisible(true);
+	_em_SetPosition(data, id, pos);
 }
 
-void CircleEmitter::_EmitParticle(uint32_t id)
+void CircleEmitter::_EmitParticle(ParticleData &data, uint32_t id, ParticleRandom &random)
 {
-	Particle *p{ (*_particles)[id] };
-
 	vec3 pos{ _position };
 
-	double d = (double)(Platform::Rand() % (uint32_t)_scale.x);
-	double angle = (double)((Platform::Rand() % 360) + 1) / (2.0 * M_PI);
+	const float d{ random.NextFloat() * _scale.x };
+	const float angle{ random.NextFloat() * 2.f * (float)M_PI };
 
-	pos.x += d * cos(angle);
-	pos.y += d * sin(angle);
+	pos.x += d * cosf(angle);
+	pos.y += d * sinf(angle);
 
-	p->SetPosition(pos);
-	p->SetLifespan(_lifespan);
-	p->SetAge(0);
-	p->SetVisible(true);
+	_em_SetPosition(data, id, pos);
 }
 
-void SphereEmitter::_EmitParticle(uint32_t id)
+void SphereEmitter::_EmitParticle(ParticleData &data, uint32_t id, ParticleRandom &random)
 {
-	Particle *p{ (*_particles)[id] };
-
-	vec3 pos{ _position };
-
-	double d1 = (double)(Platform::Rand() % (uint32_t)_scale.x);
-	double d2 = (double)(Platform::Rand() % (uint32_t)_scale.x);
-	double angle = (double)((Platform::Rand() % 360) + 1) / (2.0 * M_PI);
+	const float d{ random.NextFloat() * _scale.x };
+	const float z{ random.NextFloat() * 2.f - 1.f };
+	const float angle{ random.NextFloat() * 2.f * (float)M_PI };
+	const float r{ sqrtf(1.f - z * z) };
 
-	pos.x += d1 * cos(angle);
-	pos.y += d1 * sin(angle);
-	pos.z += d2 * cos(angle);
-
-	p->SetPosition(pos);
-	p->SetLifespan(_lifespan);
-	p->SetAge(0);
-	p->SetVisible(true);
+	_em_SetPosition(data, id, _position + d * vec3(r * cosf(angle), r * sinf(angle), z));
 }
 
-void BoxEmitter::_EmitParticle(uint32_t id)
+void BoxEmitter::_EmitParticle(ParticleData &data, uint32_t id, ParticleRandom &random)
 {
-	Particle *p{ (*_particles)[id] };
-
 	vec3 pos{ _position };
 
-	uint32_t x = (uint32_t)(_scale.x / 2.f);
-	uint32_t y = (uint32_t)(_scale.y / 2.f);
-	uint32_t z = (uint32_t)(_scale.z / 2.f);
-
-	pos.x += (Platform::Rand() % x) + 1;
-	pos.y += (Platform::Rand() % y) + 1;
-	pos.z += (Platform::Rand() % z) + 1;
+	pos.x += (random.NextFloat() - .5f) * _scale.x;
+	pos.y += (random.NextFloat() - .5f) * _scale.y;
+	pos.z += (random.NextFloat() - .5f) * _scale.z;
 
-	p->SetPosition(pos);
-	p->SetLifespan(_lifespan);
-	p->SetAge(0);
-	p->SetVisible(true);
+	_em_SetPosition(data, id, pos);
 }
 
-void PointEmitter::_EmitParticle(uint32_t id)
+void PointEmitter::_EmitParticle(ParticleData &data, uint32_t id, ParticleRandom &random)
 {
-	Particle *p{ (*_particles)[id] };
-	p->SetPosition(_position);
-	p->SetLifespan(_lifespan);
-	p->SetAge(0);
-	p->SetVisible(true);
+	_em_SetPosition(data, id, _position);
 }
 
-void MeshEmitter::_EmitParticle(uint32_t id)
+void MeshEmitter::_EmitParticle(ParticleData &data, uint32_t id, ParticleRandom &random)
 {
-	Particle *p{ (*_particles)[id] };
-
-	vec3 pos{ _position };
-
-	p->SetPosition(pos);
-	p->SetLifespan(_lifespan);
-	p->SetAge(0);
-	p->SetVisible(true);
+	_em_SetPosition(data, id, _position);
 }
@@ -0,0 +1,200 @@
+/* NekoEngine
+ *
+ * ParticlePool.cpp
+ * Author: Alexandru Naiman
+ *
+ * Structure of arrays particle storage
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Scene/Particles/ParticlePool.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define PART_SSE
+	#include <emmintrin.h>
+#endif
+
+#define PART_STREAM_COUNT	8
+
+using namespace glm;
+
+#ifdef PART_SSE
+static inline __m128 _pp_SampleSSE(const EasingTable &table, __m128 t)
+{
+	const __m128 x{ _mm_mul_ps(t, _mm_set1_ps((float)EASING_TABLE_SIZE)) };
+	const __m128i i{ _mm_cvttps_epi32(x) };
+	const __m128 f{ _mm_sub_ps(x, _mm_cvtepi32_ps(i)) };
+
+	alignas(16) int32_t idx[4];
+	_mm_store_si128((__m128i *)idx, i);
+
+	const float *v{ table.values };
+	const __m128 a{ _mm_set_ps(v[idx[3]], v[idx[2]], v[idx[1]], v[idx[0]]) };
+	const __m128 b{ _mm_set_ps(v[idx[3] + 1], v[idx[2] + 1], v[idx[1] + 1], v[idx[0] + 1]) };
+
+	return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), f));
+}
+#endif
+
+ParticlePool::ParticlePool() noexcept :
+	_data{},
+	_capacity{ 0 },
+	_alive{ 0 }
+{
+}
+
+void ParticlePool::Resize(uint32_t capacity)
+{
+	const size_t stride{ ((size_t)capacity + 3) & ~(size_t)3 };
+
+	_streams.assign(stride * PART_STREAM_COUNT, 0.f);
+
+	float *ptr{ _streams.data() };
+	float **streams[PART_STREAM_COUNT]
+	{
+		&_data.positionX, &_data.positionY, &_data.positionZ,
+		&_data.velocityX, &_data.velocityY, &_data.velocityZ,
+		&_data.age, &_data.invLifespan
+	};
+
+	for (uint32_t i = 0; i < PART_STREAM_COUNT; ++i)
+		*streams[i] = ptr + stride * i;
+
+	_capacity = capacity;
+	_alive = 0;
+}
+
+uint32_t ParticlePool::Emit(uint32_t count) noexcept
+{
+	if (count > _capacity - _alive)
+		count = _capacity - _alive;
+
+	_alive += count;
+	return count;
+}
+
+void ParticlePool::Kill(uint32_t id) noexcept
+{
+	const uint32_t last{ --_alive };
+	if (id == last)
+		return;
+
+	_data.positionX[id] = _data.positionX[last];
+	_data.positionY[id] = _data.positionY[last];
+	_data.positionZ[id] = _data.positionZ[last];
+	_data.velocityX[id] = _data.velocityX[last];
+	_data.velocityY[id] = _data.velocityY[last];
+	_data.velocityZ[id] = _data.velocityZ[last];
+	_data.age[id] = _data.age[last];
+	_data.invLifespan[id] = _data.invLifespan[last];
+}
+
+void ParticlePool::Integrate(uint32_t begin, uint32_t end, float deltaTime, const vec3 &acceleration, const EasingTable &speedCurve) noexcept
+{
+	ParticleData &d{ _data };
+	const vec3 dv{ acceleration * deltaTime };
+	uint32_t i{ begin };
+
+#ifdef PART_SSE
+	const __m128 dt{ _mm_set1_ps(deltaTime) }, one{ _mm_set1_ps(1.f) };
+	const __m128 dvx{ _mm_set1_ps(dv.x) }, dvy{ _mm_set1_ps(dv.y) }, dvz{ _mm_set1_ps(dv.z) };
+
+	for (; i + 4 <= end; i += 4)
+	{
+		const __m128 age{ _mm_add_ps(_mm_loadu_ps(d.age + i), dt) };
+		_mm_storeu_ps(d.age + i, age);
+
+		const __m128 t{ _mm_min_ps(_mm_mul_ps(age, _mm_loadu_ps(d.invLifespan + i)), one) };
+		const __m128 step{ _mm_mul_ps(_pp_SampleSSE(speedCurve, t), dt) };
+
+		const __m128 vx{ _mm_add_ps(_mm_loadu_ps(d.velocityX + i), dvx) };
+		const __m128 vy{ _mm_add_ps(_mm_loadu_ps(d.velocityY + i), dvy) };
+		const __m128 vz{ _mm_add_ps(_mm_loadu_ps(d.velocityZ + i), dvz) };
+
+		_mm_storeu_ps(d.velocityX + i, vx);
+		_mm_storeu_ps(d.velocityY + i, vy);
+		_mm_storeu_ps(d.velocityZ + i, vz);
+
+		_mm_storeu_ps(d.positionX + i, _mm_add_ps(_mm_loadu_ps(d.positionX + i), _mm_mul_ps(vx, step)));
+		_mm_storeu_ps(d.positionY + i, _mm_add_ps(_mm_loadu_ps(d.positionY + i), _mm_mul_ps(vy, step)));
+		_mm_storeu_ps(d.positionZ + i, _mm_add_ps(_mm_loadu_ps(d.positionZ + i), _mm_mul_ps(vz, step)));
+	}
+#endif
+
+	for (; i < end; ++i)
+	{
+		d.age[i] += deltaTime;
+
+		const float step{ speedCurve.Sample(glm::min(d.age[i] * d.invLifespan[i], 1.f)) * deltaTime };
+
+		d.velocityX[i] += dv.x;
+		d.velocityY[i] += dv.y;
+		d.velocityZ[i] += dv.z;
+
+		d.positionX[i] += d.velocityX[i] * step;
+		d.positionY[i] += d.velocityY[i] * step;
+		d.positionZ[i] += d.velocityZ[i] * step;
+	}
+}
+
+void ParticlePool::RemoveDead() noexcept
+{
+	uint32_t i{ 0 };
+	while (i < _alive)
+	{
+		if (_data.age[i] * _data.invLifespan[i] >= 1.f)
+			Kill(i);
+		else
+			++i;
+	}
+}
+
+void ParticlePool::WriteVertices(uint32_t begin, uint32_t end, ParticleVertex *vertices,
+	float initialSize, float finalSize, const EasingTable &sizeCurve,
+	const vec4 &initialColor, const vec4 &finalColor, const EasingTable &colorCurve,
+	const uint32_t *order) const noexcept
+{
+	const ParticleData &d{ _data };
+
+	for (uint32_t vertex = begin; vertex < end; ++vertex)
+	{
+		ParticleVertex &v{ vertices[vertex] };
+		const uint32_t i{ order ? order[vertex] : vertex };
+		const float t{ glm::min(d.age[i] * d.invLifespan[i], 1.f) };
+
+		v.positionAndAge = vec4(d.positionX[i], d.positionY[i], d.positionZ[i], d.age[i]);
+		v.velocityAndWeight = vec4(d.velocityX[i], d.velocityY[i], d.velocityZ[i], 0.f);
+		v.destinationAndScale = vec4(0.f, 0.f, 0.f, initialSize + (finalSize - initialSize) * sizeCurve.Sample(t));
+		v.color = mix(initialColor, finalColor, colorCurve.Sample(t));
+	}
+}
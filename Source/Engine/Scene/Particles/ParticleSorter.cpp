@@ -0,0 +1,158 @@
+/* NekoEngine
+ *
+ * ParticleSorter.cpp
+ * Author: Alexandru Naiman
+ *
+ * Parallel depth sort for CPU particles
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <Engine/TaskManager.h>
+#include <Scene/Particles/ParticleSorter.h>
+
+#define PART_SORT_GRAIN		16384
+#define PART_SORT_RADIX		256
+#define PART_SORT_PASSES	4
+
+using namespace std;
+using namespace glm;
+
+ParticleSorter::ParticleSorter() noexcept
+{
+}
+
+const uint32_t *ParticleSorter::Sort(const ParticlePool &pool, const vec3 &eye)
+{
+	const uint32_t count{ pool.GetAliveCount() };
+	const uint32_t chunks{ (count + PART_SORT_GRAIN - 1) / PART_SORT_GRAIN };
+	const ParticleData &d{ pool.GetData() };
+
+	for (uint8_t i = 0; i < 2; ++i)
+	{
+		_keys[i].resize(count);
+		_indices[i].resize(count);
+	}
+	_histograms.resize((size_t)chunks * PART_SORT_RADIX);
+
+	if (!count)
+		return _indices[0].data();
+
+	// The squared distance is positive, so its bit pattern sorts like an
+	// unsigned integer. Inverting it puts the farthest particle first.
+	TaskManager::ParallelFor(chunks, 1, [&](uint32_t first, uint32_t last) {
+		for (uint32_t c = first; c < last; ++c)
+		{
+			const uint32_t end{ glm::min((c + 1) * PART_SORT_GRAIN, count) };
+			for (uint32_t i = c * PART_SORT_GRAIN; i < end; ++i)
+			{
+				const float x{ d.positionX[i] - eye.x }, y{ d.positionY[i] - eye.y }, z{ d.positionZ[i] - eye.z };
+				const float dist{ x * x + y * y + z * z };
+
+				uint32_t bits{};
+				memcpy(&bits, &dist, sizeof(bits));
+
+				_keys[0][i] = ~bits;
+				_indices[0][i] = i;
+			}
+		}
+	});
+
+	for (uint32_t pass = 0; pass < PART_SORT_PASSES; ++pass)
+	{
+		const uint32_t shift{ pass * 8 };
+		const uint32_t *srcKeys{ _keys[0].data() }, *srcIndices{ _indices[0].data() };
+		uint32_t *dstKeys{ _keys[1].data() }, *dstIndices{ _indices[1].data() };
+		uint32_t *histograms{ _histograms.data() };
+
+		TaskManager::ParallelFor(chunks, 1, [&](uint32_t first, uint32_t last) {
+			for (uint32_t c = first; c < last; ++c)
+			{
+				uint32_t *h{ histograms + (size_t)c * PART_SORT_RADIX };
+				memset(h, 0, sizeof(uint32_t) * PART_SORT_RADIX);
+
+				const uint32_t end{ glm::min((c + 1) * PART_SORT_GRAIN, count) };
+				for (uint32_t i = c * PART_SORT_GRAIN; i < end; ++i)
+					++h[(srcKeys[i] >> shift) & (PART_SORT_RADIX - 1)];
+			}
+		});
+
+		// Exclusive prefix sum in digit-major, chunk-minor order gives every
+		// chunk its output slots for each digit. A pass where all keys share
+		// the digit would not move anything.
+		uint32_t offset{ 0 };
+		bool skip{ false };
+		for (uint32_t digit = 0; digit < PART_SORT_RADIX; ++digit)
+		{
+			const uint32_t digitStart{ offset };
+
+			for (uint32_t c = 0; c < chunks; ++c)
+			{
+				uint32_t &h{ histograms[(size_t)c * PART_SORT_RADIX + digit] };
+				const uint32_t n{ h };
+				h = offset;
+				offset += n;
+			}
+
+			if (offset - digitStart == count)
+			{
+				skip = true;
+				break;
+			}
+		}
+
+		if (skip)
+			continue;
+
+		TaskManager::ParallelFor(chunks, 1, [&](uint32_t first, uint32_t last) {
+			for (uint32_t c = first; c < last; ++c)
+			{
+				uint32_t *h{ histograms + (size_t)c * PART_SORT_RADIX };
+
+				const uint32_t end{ glm::min((c + 1) * PART_SORT_GRAIN, count) };
+				for (uint32_t i = c * PART_SORT_GRAIN; i < end; ++i)
+				{
+					const uint32_t dst{ h[(srcKeys[i] >> shift) & (PART_SORT_RADIX - 1)]++ };
+					dstKeys[dst] = srcKeys[i];
+					dstIndices[dst] = srcIndices[i];
+				}
+			}
+		});
+
+		_keys[0].swap(_keys[1]);
+		_indices[0].swap(_indices[1]);
+	}
+
+	return _indices[0].data();
+}
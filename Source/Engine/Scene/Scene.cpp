@@ -52,6 +52,9 @@
 #include <Profiler/Profiler.h>
 #include <Renderer/Renderer.h>
 #include <Renderer/DebugMarker.h>
+#include <Renderer/RenderQueue.h>
+#include <Renderer/ShadowCache.h>
+#include <Renderer/InstanceManager.h>
 #include <System/VFS/VFS.h>
 #include <System/AssetLoader/AssetLoader.h>
 #include <Scene/Scene.h>
@@ -68,6 +71,10 @@
 using namespace std;
 using namespace glm;
 
+// Only the active scene prepares command buffers, so the queue is shared
+static RenderQueue _renderQueue;
+static vector<bool> _instancedBatches;
+
 typedef struct COMPONNENT_INITIALIZER_INFO
 {
 	string name;
@@ -439,7 +446,7 @@ int Scene::Load()
 
 	if (_bufferSize)
 	{
-		_sceneBuffer = new Buffer(_bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, nullptr, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		_sceneBuffer = new Buffer(_bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, nullptr, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 		if (!_sceneBuffer)
 		{ DIE("Out of resources"); }
 		VK_DBG_SET_OBJECT_NAME((uint64_t)_sceneBuffer->GetHandle(), VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Scene vertex/index buffer");
@@ -540,6 +547,16 @@ int Scene::Load()
 	return ENGINE_OK;
 }
 
+void Scene::FixedUpdate() noexcept
+{
+	for (Object *obj : _objects)
+	{
+		if (!obj->GetUpdateWhilePaused() && Engine::IsPaused())
+			continue;
+		obj->FixedUpdate();
+	}
+}
+
 void Scene::Update(double deltaTime) noexcept
 {	
 	for (Object *obj : _objects)
@@ -585,21 +602,35 @@ void Scene::UpdateData(VkCommandBuffer buffer) noexcept
 {
 	for (Object *obj : _objects)
 		obj->UpdateData(buffer);
+
+	// The queue is built here so the instance data of the batches is uploaded with the rest of the frame
+	_BuildRenderQueue();
 }
 
-void Scene::DrawShadow(VkCommandBuffer buffer, uint32_t shadowId) noexcept
+void Scene::UpdateShadowCasters(ShadowCache *cache) noexcept
 {
-	for (const Object *obj : _objects)
-		obj->DrawShadow(buffer, shadowId);
+	cache->BeginFrame();
+
+	for (Object *obj : _objects)
+	{
+		if (!obj->IsVisible())
+			continue;
+
+		bool noCull{ obj->GetNoCull() || !obj->GetTransformedBounds().IsValid() };
+
+		// The octree is only filled when objects are added, so a caster that
+		// stopped moving is placed again before the faces look it up
+		if (cache->UpdateCaster(obj, obj->GetModelMatrix(), obj->GetTransformedBounds(), obj->HasAnimatedShadow(), noCull) && _ocTree->Remove(obj))
+			_ocTree->Add(obj);
+	}
+
+	cache->EndCasterUpdate();
 }
 
-void Scene::PrepareCommandBuffers()
+void Scene::_BuildRenderQueue() noexcept
 {
 	NArray<const Object *> visibleObjects(_objects.size());
-	vector<Drawable *> opaqueDrawables{};
-	vector<Drawable *> transparentDrawables{};
 	Camera *cam{ CameraManager::GetActiveCamera() };
-	float minDistance = FLT_MAX;
 	
 	PROF_BEGIN("Culling", vec3(1.f, 0.f, 0.f));
 
@@ -608,6 +639,8 @@ void Scene::PrepareCommandBuffers()
 
 	_ocTree->GetVisible(cam->GetFrustum(), visibleObjects);
 	PROF_MARKER("Objects", vec3(1.f, 0.f, 0.f));
+
+	_renderQueue.Clear();
 	
 	for (const Object *obj : visibleObjects)
 	{
@@ -624,49 +657,71 @@ void Scene::PrepareCommandBuffers()
 			if (!obj->GetNoCull() && !cam->GetFrustum().ContainsBounds(drawable.transformedBounds))
 				continue;
 
-			if (drawable.transparent)
-			{
-				float dist = distance(drawable.bounds.GetCenter(), cam->GetPosition());
-
-				if (dist < minDistance)
-				{
-					minDistance = dist;
-					transparentDrawables.insert(transparentDrawables.begin(), &drawable);
-				}
-				else
-					transparentDrawables.push_back(&drawable);
-			}
-			else
-				opaqueDrawables.push_back(&drawable);
+			_renderQueue.Add(&drawable, distance(drawable.transformedBounds.GetCenter(), cam->GetPosition()));
 		}
 	}
 
 	PROF_MARKER("Drawables", vec3(1.f, 0.f, 0.f));
-	PROF_END();
 
-	for (Drawable *drawable : opaqueDrawables)
+	_renderQueue.Build();
+
+	PROF_MARKER("Sort", vec3(1.f, 0.f, 0.f));
+
+	// Batches of one keep their own command buffers; the rest fall back to
+	// them too when the instance buffer is full
+	const vector<RenderQueueBatch> &batches{ _renderQueue.GetBatches() };
+
+	InstanceManager::Reset();
+	_instancedBatches.assign(batches.size(), false);
+
+	for (size_t i = 0; i < batches.size(); ++i)
 	{
-		if (drawable->depthCommandBuffer != VK_NULL_HANDLE)
-			Renderer::GetInstance()->AddDepthCommandBuffer(drawable->depthCommandBuffer);
-		Renderer::GetInstance()->AddSceneCommandBuffer(drawable->sceneCommandBuffer);
-
-		#if defined(NE_CONFIG_DEBUG) || defined(NE_CONFIG_DEVELOPMENT)
-		if (Engine::GetDebugVariables().DrawBounds)
-			Renderer::GetInstance()->DrawBounds(drawable->transformedBounds);
-		#endif
+		const RenderQueueBatch &batch{ batches[i] };
+
+		if (batch.count > 1)
+			_instancedBatches[i] = InstanceManager::AddBatch(_renderQueue.GetDrawable(batch.first)->instanceCommand,
+				_renderQueue.GetInstanceData(batch), batch.count);
 	}
 
-	for (Drawable *drawable : reverse(transparentDrawables))
+	PROF_MARKER("Batch", vec3(1.f, 0.f, 0.f));
+	PROF_END();
+}
+
+void Scene::PrepareCommandBuffers()
+{
+	const vector<RenderQueueBatch> &batches{ _renderQueue.GetBatches() };
+
+	for (size_t i = 0; i < batches.size(); ++i)
 	{
-		if (drawable->depthCommandBuffer != VK_NULL_HANDLE)
-			Renderer::GetInstance()->AddDepthCommandBuffer(drawable->depthCommandBuffer);
-		Renderer::GetInstance()->AddSceneCommandBuffer(drawable->sceneCommandBuffer);
-
-		#if defined(NE_CONFIG_DEBUG) || defined(NE_CONFIG_DEVELOPMENT)
-		if (Engine::GetDebugVariables().DrawBounds)
-			Renderer::GetInstance()->DrawBounds(drawable->transformedBounds);
-		#endif
+		const RenderQueueBatch &batch{ batches[i] };
+
+		// The first drawable of an instanced batch draws the whole batch
+		if (_instancedBatches[i])
+		{
+			Drawable *drawable{ _renderQueue.GetDrawable(batch.first) };
+
+			if (drawable->instancedDepthCommandBuffer != VK_NULL_HANDLE)
+				Renderer::GetInstance()->AddDepthCommandBuffer(drawable->instancedDepthCommandBuffer);
+			Renderer::GetInstance()->AddSceneCommandBuffer(drawable->instancedSceneCommandBuffer);
+
+			continue;
+		}
+
+		for (uint32_t j = batch.first; j < batch.first + batch.count; ++j)
+		{
+			Drawable *drawable{ _renderQueue.GetDrawable(j) };
+
+			if (drawable->depthCommandBuffer != VK_NULL_HANDLE)
+				Renderer::GetInstance()->AddDepthCommandBuffer(drawable->depthCommandBuffer);
+			Renderer::GetInstance()->AddSceneCommandBuffer(drawable->sceneCommandBuffer);
+		}
 	}
+
+	#if defined(NE_CONFIG_DEBUG) || defined(NE_CONFIG_DEVELOPMENT)
+	if (Engine::GetDebugVariables().DrawBounds)
+		for (size_t i = 0; i < _renderQueue.GetCount(); ++i)
+			Renderer::GetInstance()->DrawBounds(_renderQueue.GetDrawable(i)->transformedBounds);
+	#endif
 }
 
 bool Scene::RebuildCommandBuffers()
@@ -161,6 +161,12 @@ void SceneManager::UpdateScene(double deltaTime) noexcept
 		_activeScene->Update(deltaTime);
 }
 
+void SceneManager::FixedUpdateScene() noexcept
+{
+	if (_activeScene && _activeScene->IsLoaded())
+		_activeScene->FixedUpdate();
+}
+
 void SceneManager::_UnloadScene() noexcept
 {
 	if (_activeScene == nullptr)
@@ -0,0 +1,280 @@
+/* NekoEngine
+ *
+ * TerrainQuadtree.cpp
+ * Author: Alexandru Naiman
+ *
+ * Terrain chunk quadtree
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <float.h>
+
+#include <Engine/TaskManager.h>
+#include <System/Logger.h>
+#include <Scene/TerrainQuadtree.h>
+
+#define TQT_MODULE			"TerrainQuadtree"
+#define TQT_SKIRT_BIAS		.1f
+
+using namespace std;
+using namespace glm;
+
+static inline uint32_t _tqt_EdgeCount(uint8_t edges)
+{
+	return (edges & 1) + ((edges >> 1) & 1) + ((edges >> 2) & 1) + ((edges >> 3) & 1);
+}
+
+bool TerrainQuadtree::Build(uint32_t numCells, uint32_t chunkCells, float cellSize, const TerrainHeightFunc &height)
+{
+	Clear();
+
+	if (!numCells || !chunkCells)
+	{
+		Logger::Log(TQT_MODULE, LOG_CRITICAL, "Invalid terrain size: %d cells, %d cells per chunk", numCells, chunkCells);
+		return false;
+	}
+
+	while (_depth < TQT_MAX_DEPTH)
+	{
+		uint32_t next{ _depth + 1 };
+		if ((numCells % (1u << next)) || ((numCells >> next) < chunkCells))
+			break;
+		_depth = next;
+	}
+
+	_numCells = numCells;
+	_chunkCells = numCells >> _depth;
+	_cellSize = cellSize;
+
+	size_t chunkCount{ 0 };
+	for (uint32_t i = 0; i <= _depth; ++i)
+		chunkCount += (size_t)1 << (2 * i);
+	_chunks.reserve(chunkCount);
+
+	TerrainChunk root{};
+	root.step = 1u << _depth;
+	root.firstChild = TQT_NO_CHILDREN;
+	_chunks.push_back(root);
+
+	for (size_t i = 0; i < _chunks.size(); ++i)
+	{
+		if (_chunks[i].level == _depth)
+			continue;
+
+		TerrainChunk child{ _chunks[i] };
+		const uint32_t half{ _chunkCells * child.step / 2 };
+
+		++child.level;
+		child.step /= 2;
+
+		_chunks[i].firstChild = (uint32_t)_chunks.size();
+
+		for (uint32_t j = 0; j < 4; ++j)
+		{
+			TerrainChunk c{ child };
+			c.x += (j & 1) * half;
+			c.z += (j >> 1) * half;
+			_chunks.push_back(c);
+		}
+	}
+
+	const uint32_t vertexCount{ GetChunkVertexCount() };
+	const uint32_t gridIndexCount{ _chunkCells * _chunkCells * 6 }, skirtIndexCount{ _chunkCells * 6 };
+	uint32_t indexCount{ 0 };
+
+	for (size_t i = 0; i < _chunks.size(); ++i)
+	{
+		TerrainChunk &chunk{ _chunks[i] };
+		const uint32_t size{ _chunkCells * chunk.step };
+
+		// Skirts are only needed where the chunk can meet a neighbour of a different level
+		chunk.skirtEdges = 0;
+		if (chunk.z > 0) chunk.skirtEdges |= TQT_EDGE_NORTH;
+		if (chunk.z + size < _numCells) chunk.skirtEdges |= TQT_EDGE_SOUTH;
+		if (chunk.x > 0) chunk.skirtEdges |= TQT_EDGE_WEST;
+		if (chunk.x + size < _numCells) chunk.skirtEdges |= TQT_EDGE_EAST;
+
+		chunk.vertexOffset = (uint32_t)i * vertexCount;
+		chunk.indexOffset = indexCount;
+		chunk.indexCount = gridIndexCount + _tqt_EdgeCount(chunk.skirtEdges) * skirtIndexCount;
+		indexCount += chunk.indexCount;
+	}
+
+	_vertices.resize(_chunks.size() * vertexCount);
+	_indices.resize(indexCount);
+
+	TaskManager::ParallelFor((uint32_t)_chunks.size(), 1, [&](uint32_t first, uint32_t last) {
+		for (uint32_t i = first; i < last; ++i)
+			_BuildChunk(_chunks[i], height);
+	});
+
+	return true;
+}
+
+void TerrainQuadtree::Select(const vec3 &viewPosition, float lodDistance, const NFrustum *frustum, vector<uint32_t> &selected) const
+{
+	selected.clear();
+
+	if (_chunks.empty())
+		return;
+
+	_Select(0, viewPosition, lodDistance, frustum, selected);
+}
+
+void TerrainQuadtree::Clear() noexcept
+{
+	_numCells = _chunkCells = _depth = 0;
+	_chunks.clear();
+	_vertices.clear();
+	_indices.clear();
+}
+
+void TerrainQuadtree::_BuildChunk(TerrainChunk &chunk, const TerrainHeightFunc &height) noexcept
+{
+	const uint32_t row{ _chunkCells + 1 }, gridSize{ row * row };
+	const float half{ _numCells / 2.f };
+	TerrainVertex *vertices{ &_vertices[chunk.vertexOffset] };
+	float minY{ FLT_MAX }, maxY{ -FLT_MAX };
+
+	for (uint32_t i = 0; i <= _chunkCells; ++i)
+	{
+		for (uint32_t j = 0; j <= _chunkCells; ++j)
+		{
+			const uint32_t x{ chunk.x + j * chunk.step }, z{ chunk.z + i * chunk.step };
+			TerrainVertex &v{ vertices[i * row + j] };
+
+			v.position.x = (x - half) * _cellSize;
+			v.position.y = height(x, z);
+			v.position.z = (z - half) * _cellSize;
+			v.uv = vec2((float)x, (float)z);
+			v.normal = vec3(0.f, 1.f, 0.f);
+			v.tangent = vec3(0.f);
+			v.heightmapUV = vec2((float)x, (float)z) / (float)_numCells;
+
+			minY = std::min(minY, v.position.y);
+			maxY = std::max(maxY, v.position.y);
+		}
+	}
+
+	// A skirt as deep as the chunk's height range covers any crack against a coarser neighbour
+	const float skirtDepth{ (maxY - minY) + chunk.step * _cellSize * TQT_SKIRT_BIAS };
+	TerrainVertex *skirt{ vertices + gridSize };
+
+	for (uint32_t k = 0; k <= _chunkCells; ++k)
+	{
+		skirt[k] = vertices[k];
+		skirt[row + k] = vertices[_chunkCells * row + k];
+		skirt[2 * row + k] = vertices[k * row];
+		skirt[3 * row + k] = vertices[k * row + _chunkCells];
+	}
+
+	for (uint32_t k = 0; k < 4 * row; ++k)
+		skirt[k].position.y -= skirtDepth;
+
+	uint32_t *indices{ &_indices[chunk.indexOffset] };
+	const uint32_t base{ chunk.vertexOffset };
+
+	for (uint32_t i = 0; i < _chunkCells; ++i)
+	{
+		for (uint32_t j = 0; j < _chunkCells; ++j)
+		{
+			const uint32_t v{ base + i * row + j };
+
+			*indices++ = v + row;
+			*indices++ = v + 1;
+			*indices++ = v;
+
+			*indices++ = v + row;
+			*indices++ = v + row + 1;
+			*indices++ = v + 1;
+		}
+	}
+
+	for (uint32_t e = 0; e < 4; ++e)
+	{
+		if (!(chunk.skirtEdges & (1 << e)))
+			continue;
+
+		// Walk the edge so the skirt faces away from the chunk
+		const bool forward{ e == 0 || e == 3 };
+
+		for (uint32_t k = 0; k < _chunkCells; ++k)
+		{
+			const uint32_t a{ forward ? k : k + 1 }, b{ forward ? k + 1 : k };
+			uint32_t topA, topB;
+
+			switch (e)
+			{
+				case 0: topA = a; topB = b; break;
+				case 1: topA = _chunkCells * row + a; topB = _chunkCells * row + b; break;
+				case 2: topA = a * row; topB = b * row; break;
+				default: topA = a * row + _chunkCells; topB = b * row + _chunkCells; break;
+			}
+
+			const uint32_t bottomA{ base + gridSize + e * row + a }, bottomB{ base + gridSize + e * row + b };
+			topA += base;
+			topB += base;
+
+			*indices++ = topA;
+			*indices++ = topB;
+			*indices++ = bottomA;
+
+			*indices++ = topB;
+			*indices++ = bottomB;
+			*indices++ = bottomA;
+		}
+	}
+
+	const float size{ GetChunkSize(chunk) };
+	vec3 min{ (chunk.x - half) * _cellSize, minY - skirtDepth, (chunk.z - half) * _cellSize };
+	vec3 max{ min.x + size, maxY, min.z + size };
+	chunk.bounds.Init((min + max) * .5f, min, max, glm::length(max - min) * .5f);
+}
+
+void TerrainQuadtree::_Select(uint32_t id, const vec3 &viewPosition, float lodDistance, const NFrustum *frustum, vector<uint32_t> &selected) const
+{
+	const TerrainChunk &chunk{ _chunks[id] };
+
+	if (frustum && !frustum->ContainsBounds(chunk.bounds))
+		return;
+
+	const float limit{ GetChunkSize(chunk) * lodDistance };
+	if (chunk.firstChild == TQT_NO_CHILDREN || chunk.bounds.GetBox().SquaredDistanceToPoint(viewPosition) > limit * limit)
+	{
+		selected.push_back(id);
+		return;
+	}
+
+	for (uint32_t i = 0; i < 4; ++i)
+		_Select(chunk.firstChild + i, viewPosition, lodDistance, frustum, selected);
+}
@@ -44,6 +44,34 @@ void AnimatorComponentInterface::Register(lua_State *state)
 {
 	lua_register(state, "AC_PlayDefaultAnimation", PlayDefaultAnimation);
 	lua_register(state, "AC_PlayAnimation", PlayAnimation);
+
+	lua_register(state, "AC_AddClipNode", AddClipNode);
+	lua_register(state, "AC_AddLerpNode", AddLerpNode);
+	lua_register(state, "AC_AddAdditiveNode", AddAdditiveNode);
+	lua_register(state, "AC_AddMaskNode", AddMaskNode);
+	lua_register(state, "AC_AddStateMachine", AddStateMachine);
+	lua_register(state, "AC_SetGraphRoot", SetGraphRoot);
+	lua_register(state, "AC_SetParameter", SetParameter);
+	lua_register(state, "AC_GetParameter", GetParameter);
+
+	lua_register(state, "AC_AddState", AddState);
+	lua_register(state, "AC_AddTransition", AddTransition);
+	lua_register(state, "AC_SetState", SetState);
+	lua_register(state, "AC_GetState", GetState);
+}
+
+/*
+ * Raises an argument error instead of handing a null pointer to the engine
+ */
+template<typename T>
+static inline T *_ToPointer(lua_State *state, int arg)
+{
+	T *ptr{ (T *)lua_touserdata(state, arg) };
+
+	if (!ptr)
+		luaL_argerror(state, arg, "expected a non-null pointer");
+
+	return ptr;
 }
 
 int AnimatorComponentInterface::PlayDefaultAnimation(lua_State *state)
@@ -53,7 +81,7 @@ int AnimatorComponentInterface::PlayDefaultAnimation(lua_State *state)
 	if (args != 1)
 		return luaL_error(state, "Invalid arguments");
 
-	((AnimatorComponent *)lua_touserdata(state, 1))->PlayDefaultAnimation();
+	_ToPointer<AnimatorComponent>(state, 1)->PlayDefaultAnimation();
 
 	return 0;
 }
@@ -65,7 +93,256 @@ int AnimatorComponentInterface::PlayAnimation(lua_State *state)
 	if (args != 2)
 		return luaL_error(state, "Invalid arguments");
 
-	((AnimatorComponent *)lua_touserdata(state, 1))->PlayAnimation((AnimationClip *)lua_touserdata(state, 2));
+	_ToPointer<AnimatorComponent>(state, 1)->PlayAnimation(_ToPointer<AnimationClip>(state, 2));
 
 	return 0;
-}
\ No newline at end of file
+}
+
+static inline AnimationGraph *_GetGraph(lua_State *state)
+{
+	return _ToPointer<AnimatorComponent>(state, 1)->GetGraph();
+}
+
+int AnimatorComponentInterface::AddClipNode(lua_State *state)
+{
+	int args{ lua_gettop(state) };
+
+	if (args < 2 || args > 4)
+		return luaL_error(state, "Invalid arguments");
+
+	AnimationGraph *graph{ _GetGraph(state) };
+	if (!graph)
+		return luaL_error(state, "Component not loaded");
+
+	bool loop{ args > 2 ? lua_toboolean(state, 3) != 0 : true };
+	float speed{ args > 3 ? (float)lua_tonumber(state, 4) : 1.f };
+
+	lua_pushlightuserdata(state, graph->AddClip(_ToPointer<AnimationClip>(state, 2), loop, speed));
+
+	return 1;
+}
+
+int AnimatorComponentInterface::AddLerpNode(lua_State *state)
+{
+	int args{ lua_gettop(state) };
+
+	if (args < 3 || args > 4)
+		return luaL_error(state, "Invalid arguments");
+
+	AnimationGraph *graph{ _GetGraph(state) };
+	if (!graph)
+		return luaL_error(state, "Component not loaded");
+
+	lua_pushlightuserdata(state, graph->AddLerp(_ToPointer<AnimationGraphNode>(state, 2),
+		_ToPointer<AnimationGraphNode>(state, 3), args > 3 ? lua_tostring(state, 4) : nullptr));
+
+	return 1;
+}
+
+int AnimatorComponentInterface::AddAdditiveNode(lua_State *state)
+{
+	int args{ lua_gettop(state) };
+
+	if (args < 3 || args > 4)
+		return luaL_error(state, "Invalid arguments");
+
+	AnimationGraph *graph{ _GetGraph(state) };
+	if (!graph)
+		return luaL_error(state, "Component not loaded");
+
+	lua_pushlightuserdata(state, graph->AddAdditive(_ToPointer<AnimationGraphNode>(state, 2),
+		_ToPointer<AnimationGraphNode>(state, 3), args > 3 ? lua_tostring(state, 4) : nullptr));
+
+	return 1;
+}
+
+int AnimatorComponentInterface::AddMaskNode(lua_State *state)
+{
+	int args{ lua_gettop(state) };
+
+	if (args < 4 || args > 5)
+		return luaL_error(state, "Invalid arguments");
+
+	AnimationGraph *graph{ _GetGraph(state) };
+	if (!graph)
+		return luaL_error(state, "Component not loaded");
+
+	AnimationMaskNode *node{ graph->AddMask(_ToPointer<AnimationGraphNode>(state, 2),
+		_ToPointer<AnimationGraphNode>(state, 3), lua_tostring(state, 4), args > 4 ? lua_tostring(state, 5) : nullptr) };
+	if (!node)
+		return luaL_argerror(state, 4, "no such node in the skeleton");
+
+	lua_pushlightuserdata(state, node);
+
+	return 1;
+}
+
+int AnimatorComponentInterface::AddStateMachine(lua_State *state)
+{
+	int args{ lua_gettop(state) };
+
+	if (args != 1)
+		return luaL_error(state, "Invalid arguments");
+
+	AnimationGraph *graph{ _GetGraph(state) };
+	if (!graph)
+		return luaL_error(state, "Component not loaded");
+
+	lua_pushlightuserdata(state, graph->AddStateMachine());
+
+	return 1;
+}
+
+int AnimatorComponentInterface::SetGraphRoot(lua_State *state)
+{
+	int args{ lua_gettop(state) };
+
+	if (args != 2)
+		return luaL_error(state, "Invalid arguments");
+
+	AnimationGraph *graph{ _GetGraph(state) };
+	if (!graph)
+		return luaL_error(state, "Component not loaded");
+
+	graph->SetRoot(_ToPointer<AnimationGraphNode>(state, 2));
+
+	return 0;
+}
+
+int AnimatorComponentInterface::SetParameter(lua_State *state)
+{
+	int args{ lua_gettop(state) };
+
+	if (args != 3)
+		return luaL_error(state, "Invalid arguments");
+
+	AnimationGraph *graph{ _GetGraph(state) };
+	if (!graph)
+		return luaL_error(state, "Component not loaded");
+
+	graph->SetParameter(graph->GetParameterId(lua_tostring(state, 2)), (float)lua_tonumber(state, 3));
+
+	return 0;
+}
+
+int AnimatorComponentInterface::GetParameter(lua_State *state)
+{
+	int args{ lua_gettop(state) };
+
+	if (args != 2)
+		return luaL_error(state, "Invalid arguments");
+
+	AnimationGraph *graph{ _GetGraph(state) };
+	if (!graph)
+		return luaL_error(state, "Component not loaded");
+
+	lua_pushnumber(state, graph->GetParameter(graph->GetParameterId(lua_tostring(state, 2))));
+
+	return 1;
+}
+
+/*
+ * AC_AddState(comp, sm, name, node)
+ */
+int AnimatorComponentInterface::AddState(lua_State *state)
+{
+	int args{ lua_gettop(state) };
+
+	if (args != 4)
+		return luaL_error(state, "Invalid arguments");
+
+	if (!_GetGraph(state))
+		return luaL_error(state, "Component not loaded");
+
+	lua_pushinteger(state, _ToPointer<AnimationStateMachine>(state, 2)->AddState(lua_tostring(state, 3), _ToPointer<AnimationGraphNode>(state, 4)));
+
+	return 1;
+}
+
+/*
+ * AC_AddTransition(comp, sm, from, to, duration [, exitTime [, parameter, condition, threshold]])
+ * from may be "*" for any state; condition is ">" or "<"
+ */
+int AnimatorComponentInterface::AddTransition(lua_State *state)
+{
+	int args{ lua_gettop(state) };
+
+	if (args != 5 && args != 6 && args != 9)
+		return luaL_error(state, "Invalid arguments");
+
+	AnimationGraph *graph{ _GetGraph(state) };
+	if (!graph)
+		return luaL_error(state, "Component not loaded");
+
+	AnimationStateMachine *sm{ _ToPointer<AnimationStateMachine>(state, 2) };
+	const char *from{ lua_tostring(state, 3) };
+	AnimationTransition t{};
+
+	t.from = (from && !strcmp(from, "*")) ? ANIM_ANY_STATE : sm->GetStateIndex(from);
+	t.to = sm->GetStateIndex(lua_tostring(state, 4));
+	t.duration = (float)lua_tonumber(state, 5);
+	t.exitTime = args > 5 ? (float)lua_tonumber(state, 6) : -1.f;
+	t.parameter = ANIM_NO_PARAMETER;
+
+	if (args > 6)
+	{
+		const char *cond{ lua_tostring(state, 8) };
+
+		t.parameter = graph->GetParameterId(lua_tostring(state, 7));
+		t.condition = (cond && cond[0] == '<') ? ANIM_COND_LESS : ANIM_COND_GREATER;
+		t.threshold = (float)lua_tonumber(state, 9);
+	}
+
+	if (t.from == ANIM_NO_STATE || t.to == ANIM_NO_STATE)
+		return luaL_error(state, "Invalid state");
+
+	sm->AddTransition(t);
+
+	return 0;
+}
+
+/*
+ * AC_SetState(comp, sm, name [, crossfade])
+ */
+int AnimatorComponentInterface::SetState(lua_State *state)
+{
+	int args{ lua_gettop(state) };
+
+	if (args < 3 || args > 4)
+		return luaL_error(state, "Invalid arguments");
+
+	if (!_GetGraph(state))
+		return luaL_error(state, "Component not loaded");
+
+	AnimationStateMachine *sm{ _ToPointer<AnimationStateMachine>(state, 2) };
+	const int16_t id{ sm->GetStateIndex(lua_tostring(state, 3)) };
+	if (id == ANIM_NO_STATE)
+		return luaL_argerror(state, 3, "no such state");
+
+	sm->SetState(id, args > 3 ? (float)lua_tonumber(state, 4) : 0.f);
+
+	return 0;
+}
+
+/*
+ * AC_GetState(comp, sm)
+ */
+int AnimatorComponentInterface::GetState(lua_State *state)
+{
+	int args{ lua_gettop(state) };
+
+	if (args != 2)
+		return luaL_error(state, "Invalid arguments");
+
+	if (!_GetGraph(state))
+		return luaL_error(state, "Component not loaded");
+
+	const char *name{ _ToPointer<AnimationStateMachine>(state, 2)->GetCurrentStateName() };
+
+	if (name)
+		lua_pushstring(state, name);
+	else
+		lua_pushnil(state);
+
+	return 1;
+}
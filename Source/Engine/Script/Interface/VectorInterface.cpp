@@ -0,0 +1,673 @@
+/* NekoEngine
+ *
+ * VectorInterface.cpp
+ * Author: Alexandru Naiman
+ *
+ * Vector and matrix script types
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <System/Logger.h>
+#include <Script/Interface/VectorInterface.h>
+
+#define VEC_IFACE_MODULE	"VectorInterface"
+
+/*
+ * The types are FFI metatypes over the structs declared with the script types,
+ * so the JIT compiles the operators and sinks temporaries that do not escape.
+ * Matrices are column major like glm and angles are in radians.
+ */
+static const char *_vectorTypes =
+R"lua(
+local ffi = require('ffi')
+local sqrt, acos, sin, cos = math.sqrt, math.acos, math.sin, math.cos
+local type, select = type, select
+local istype, new = ffi.istype, ffi.new
+
+local vec2_t, vec3_t, vec4_t = ffi.typeof('vec2'), ffi.typeof('vec3'), ffi.typeof('vec4')
+local quat_t, mat4_t = ffi.typeof('quat'), ffi.typeof('mat4')
+local vec2, vec3, vec4, quat, mat4
+
+-- Free lists used by acquire() and release(); values past the limit are left to the GC
+local POOL_SIZE = 1024
+
+local function pool(ctor)
+	local free, count = {}, 0
+
+	local function acquire(...)
+		if count == 0 then return ctor(...) end
+		local v = free[count]
+		free[count] = nil
+		count = count - 1
+		if select('#', ...) > 0 then v:set(...) end
+		return v
+	end
+
+	local function release(v)
+		if count < POOL_SIZE then
+			count = count + 1
+			free[count] = v
+		end
+	end
+
+	return acquire, release
+end
+
+-- Swizzles: v.xy, v.zyx, v.rgba; component names past the type's size are rejected.
+-- Each key is parsed once into an accessor that builds the result directly.
+local swizzleIndex = { x = 1, y = 2, z = 3, w = 4, r = 1, g = 2, b = 3, a = 4 }
+local components = { 'x', 'y', 'z', 'w' }
+local swizzles = { {}, {}, {}, {} }
+
+local function newSwizzle(key, size)
+	local n = #key
+	if n == 0 or n > 4 then return nil end
+
+	local f = {}
+	for i = 1, n do
+		local c = swizzleIndex[key:sub(i, i)]
+		if not c or c > size then return nil end
+		f[i] = components[c]
+	end
+
+	local a, b, c, d = f[1], f[2], f[3], f[4]
+	if n == 1 then return function(v) return v[a] end
+	elseif n == 2 then return function(v) return vec2_t(v[a], v[b]) end
+	elseif n == 3 then return function(v) return vec3_t(v[a], v[b], v[c]) end end
+	return function(v) return vec4_t(v[a], v[b], v[c], v[d]) end
+end
+
+local function swizzle(v, key, size)
+	if type(key) ~= 'string' then return nil end
+
+	local cache = swizzles[size]
+	local fn = cache[key]
+	if fn == nil then
+		fn = newSwizzle(key, size)
+		if fn == nil then return nil end
+		cache[key] = fn
+	end
+
+	return fn(v)
+end
+
+local function index(methods, size)
+	return function(v, key)
+		local m = methods[key]
+		if m ~= nil then return m end
+		return swizzle(v, key, size)
+	end
+end
+
+---------------------------------------------------------------------- vec2
+
+local vec2_methods = {}
+local vec2_mt = { __index = index(vec2_methods, 2) }
+
+function vec2_mt.__new(ct, x, y)
+	if x == nil then return new(ct, 0, 0) end
+	if y == nil then
+		if type(x) == 'number' then return new(ct, x, x) end
+		return new(ct, x.x, x.y)
+	end
+	return new(ct, x, y)
+end
+
+function vec2_mt.__add(a, b) return vec2_t(a.x + b.x, a.y + b.y) end
+function vec2_mt.__sub(a, b) return vec2_t(a.x - b.x, a.y - b.y) end
+function vec2_mt.__mul(a, b)
+	if type(a) == 'number' then return vec2_t(a * b.x, a * b.y) end
+	if type(b) == 'number' then return vec2_t(a.x * b, a.y * b) end
+	return vec2_t(a.x * b.x, a.y * b.y)
+end
+function vec2_mt.__div(a, b)
+	if type(b) == 'number' then return vec2_t(a.x / b, a.y / b) end
+	return vec2_t(a.x / b.x, a.y / b.y)
+end
+function vec2_mt.__unm(a) return vec2_t(-a.x, -a.y) end
+function vec2_mt.__eq(a, b) return istype(vec2_t, b) and a.x == b.x and a.y == b.y end
+function vec2_mt.__len(a) return sqrt(a.x * a.x + a.y * a.y) end
+function vec2_mt.__tostring(a) return string.format('vec2(%g, %g)', a.x, a.y) end
+
+function vec2_methods.set(v, x, y)
+	if y == nil then
+		if type(x) == 'number' then y = x else x, y = x.x, x.y end
+	end
+	v.x, v.y = x, y
+	return v
+end
+function vec2_methods.clone(v) return vec2_t(v.x, v.y) end
+function vec2_methods.dot(a, b) return a.x * b.x + a.y * b.y end
+function vec2_methods.length(a) return sqrt(a.x * a.x + a.y * a.y) end
+function vec2_methods.length2(a) return a.x * a.x + a.y * a.y end
+function vec2_methods.distance(a, b) local x, y = a.x - b.x, a.y - b.y return sqrt(x * x + y * y) end
+function vec2_methods.normalized(a) local l = sqrt(a.x * a.x + a.y * a.y) return l > 0 and vec2_t(a.x / l, a.y / l) or vec2_t(0, 0) end
+function vec2_methods.lerp(a, b, t) return vec2_t(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t) end
+function vec2_methods.reflect(i, n) local d = 2 * (n.x * i.x + n.y * i.y) return vec2_t(i.x - d * n.x, i.y - d * n.y) end
+function vec2_methods.refract(i, n, eta)
+	local d = n.x * i.x + n.y * i.y
+	local k = 1 - eta * eta * (1 - d * d)
+	if k < 0 then return vec2_t(0, 0) end
+	local s = eta * d + sqrt(k)
+	return vec2_t(eta * i.x - s * n.x, eta * i.y - s * n.y)
+end
+
+-- In-place versions return the receiver and do not allocate
+function vec2_methods.add(a, b) a.x, a.y = a.x + b.x, a.y + b.y return a end
+function vec2_methods.sub(a, b) a.x, a.y = a.x - b.x, a.y - b.y return a end
+function vec2_methods.scale(a, s) a.x, a.y = a.x * s, a.y * s return a end
+function vec2_methods.normalize(a) local l = sqrt(a.x * a.x + a.y * a.y) if l > 0 then a.x, a.y = a.x / l, a.y / l end return a end
+)lua"
+R"lua(
+---------------------------------------------------------------------- vec3
+
+local vec3_methods = {}
+local vec3_mt = { __index = index(vec3_methods, 3) }
+
+function vec3_mt.__new(ct, x, y, z)
+	if x == nil then return new(ct, 0, 0, 0) end
+	if y == nil then
+		if type(x) == 'number' then return new(ct, x, x, x) end
+		return new(ct, x.x, x.y, x.z)
+	end
+	if z == nil then return new(ct, x.x, x.y, y) end
+	return new(ct, x, y, z)
+end
+
+function vec3_mt.__add(a, b) return vec3_t(a.x + b.x, a.y + b.y, a.z + b.z) end
+function vec3_mt.__sub(a, b) return vec3_t(a.x - b.x, a.y - b.y, a.z - b.z) end
+function vec3_mt.__mul(a, b)
+	if type(a) == 'number' then return vec3_t(a * b.x, a * b.y, a * b.z) end
+	if type(b) == 'number' then return vec3_t(a.x * b, a.y * b, a.z * b) end
+	return vec3_t(a.x * b.x, a.y * b.y, a.z * b.z)
+end
+function vec3_mt.__div(a, b)
+	if type(b) == 'number' then return vec3_t(a.x / b, a.y / b, a.z / b) end
+	return vec3_t(a.x / b.x, a.y / b.y, a.z / b.z)
+end
+function vec3_mt.__unm(a) return vec3_t(-a.x, -a.y, -a.z) end
+function vec3_mt.__eq(a, b) return istype(vec3_t, b) and a.x == b.x and a.y == b.y and a.z == b.z end
+function vec3_mt.__len(a) return sqrt(a.x * a.x + a.y * a.y + a.z * a.z) end
+function vec3_mt.__tostring(a) return string.format('vec3(%g, %g, %g)', a.x, a.y, a.z) end
+
+function vec3_methods.set(v, x, y, z)
+	if y == nil then
+		if type(x) == 'number' then y, z = x, x else x, y, z = x.x, x.y, x.z end
+	end
+	v.x, v.y, v.z = x, y, z
+	return v
+end
+function vec3_methods.clone(v) return vec3_t(v.x, v.y, v.z) end
+function vec3_methods.dot(a, b) return a.x * b.x + a.y * b.y + a.z * b.z end
+function vec3_methods.cross(a, b) return vec3_t(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x) end
+function vec3_methods.length(a) return sqrt(a.x * a.x + a.y * a.y + a.z * a.z) end
+function vec3_methods.length2(a) return a.x * a.x + a.y * a.y + a.z * a.z end
+function vec3_methods.distance(a, b) local x, y, z = a.x - b.x, a.y - b.y, a.z - b.z return sqrt(x * x + y * y + z * z) end
+function vec3_methods.normalized(a)
+	local l = sqrt(a.x * a.x + a.y * a.y + a.z * a.z)
+	return l > 0 and vec3_t(a.x / l, a.y / l, a.z / l) or vec3_t(0, 0, 0)
+end
+function vec3_methods.lerp(a, b, t) return vec3_t(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t) end
+function vec3_methods.reflect(i, n)
+	local d = 2 * (n.x * i.x + n.y * i.y + n.z * i.z)
+	return vec3_t(i.x - d * n.x, i.y - d * n.y, i.z - d * n.z)
+end
+function vec3_methods.refract(i, n, eta)
+	local d = n.x * i.x + n.y * i.y + n.z * i.z
+	local k = 1 - eta * eta * (1 - d * d)
+	if k < 0 then return vec3_t(0, 0, 0) end
+	local s = eta * d + sqrt(k)
+	return vec3_t(eta * i.x - s * n.x, eta * i.y - s * n.y, eta * i.z - s * n.z)
+end
+
+function vec3_methods.add(a, b) a.x, a.y, a.z = a.x + b.x, a.y + b.y, a.z + b.z return a end
+function vec3_methods.sub(a, b) a.x, a.y, a.z = a.x - b.x, a.y - b.y, a.z - b.z return a end
+function vec3_methods.scale(a, s) a.x, a.y, a.z = a.x * s, a.y * s, a.z * s return a end
+function vec3_methods.normalize(a)
+	local l = sqrt(a.x * a.x + a.y * a.y + a.z * a.z)
+	if l > 0 then a.x, a.y, a.z = a.x / l, a.y / l, a.z / l end
+	return a
+end
+function vec3_methods.crossWith(a, b)
+	a.x, a.y, a.z = a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x
+	return a
+end
+
+---------------------------------------------------------------------- vec4
+
+local vec4_methods = {}
+local vec4_mt = { __index = index(vec4_methods, 4) }
+
+function vec4_mt.__new(ct, x, y, z, w)
+	if x == nil then return new(ct, 0, 0, 0, 0) end
+	if y == nil then
+		if type(x) == 'number' then return new(ct, x, x, x, x) end
+		return new(ct, x.x, x.y, x.z, x.w)
+	end
+	if z == nil then return new(ct, x.x, x.y, x.z, y) end
+	return new(ct, x, y, z, w)
+end
+
+function vec4_mt.__add(a, b) return vec4_t(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w) end
+function vec4_mt.__sub(a, b) return vec4_t(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w) end
+function vec4_mt.__mul(a, b)
+	if type(a) == 'number' then return vec4_t(a * b.x, a * b.y, a * b.z, a * b.w) end
+	if type(b) == 'number' then return vec4_t(a.x * b, a.y * b, a.z * b, a.w * b) end
+	return vec4_t(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w)
+end
+function vec4_mt.__div(a, b)
+	if type(b) == 'number' then return vec4_t(a.x / b, a.y / b, a.z / b, a.w / b) end
+	return vec4_t(a.x / b.x, a.y / b.y, a.z / b.z, a.w / b.w)
+end
+function vec4_mt.__unm(a) return vec4_t(-a.x, -a.y, -a.z, -a.w) end
+function vec4_mt.__eq(a, b) return istype(vec4_t, b) and a.x == b.x and a.y == b.y and a.z == b.z and a.w == b.w end
+function vec4_mt.__len(a) return sqrt(a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w) end
+function vec4_mt.__tostring(a) return string.format('vec4(%g, %g, %g, %g)', a.x, a.y, a.z, a.w) end
+
+function vec4_methods.set(v, x, y, z, w)
+	if y == nil then
+		if type(x) == 'number' then y, z, w = x, x, x else x, y, z, w = x.x, x.y, x.z, x.w end
+	end
+	v.x, v.y, v.z, v.w = x, y, z, w
+	return v
+end
+function vec4_methods.clone(v) return vec4_t(v.x, v.y, v.z, v.w) end
+function vec4_methods.dot(a, b) return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w end
+function vec4_methods.length(a) return sqrt(a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w) end
+function vec4_methods.length2(a) return a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w end
+function vec4_methods.distance(a, b)
+	local x, y, z, w = a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w
+	return sqrt(x * x + y * y + z * z + w * w)
+end
+function vec4_methods.normalized(a)
+	local l = sqrt(a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w)
+	return l > 0 and vec4_t(a.x / l, a.y / l, a.z / l, a.w / l) or vec4_t(0, 0, 0, 0)
+end
+function vec4_methods.lerp(a, b, t)
+	return vec4_t(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t)
+end
+function vec4_methods.reflect(i, n)
+	local d = 2 * (n.x * i.x + n.y * i.y + n.z * i.z + n.w * i.w)
+	return vec4_t(i.x - d * n.x, i.y - d * n.y, i.z - d * n.z, i.w - d * n.w)
+end
+function vec4_methods.refract(i, n, eta)
+	local d = n.x * i.x + n.y * i.y + n.z * i.z + n.w * i.w
+	local k = 1 - eta * eta * (1 - d * d)
+	if k < 0 then return vec4_t(0, 0, 0, 0) end
+	local s = eta * d + sqrt(k)
+	return vec4_t(eta * i.x - s * n.x, eta * i.y - s * n.y, eta * i.z - s * n.z, eta * i.w - s * n.w)
+end
+
+function vec4_methods.add(a, b) a.x, a.y, a.z, a.w = a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w return a end
+function vec4_methods.sub(a, b) a.x, a.y, a.z, a.w = a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w return a end
+function vec4_methods.scale(a, s) a.x, a.y, a.z, a.w = a.x * s, a.y * s, a.z * s, a.w * s return a end
+function vec4_methods.normalize(a)
+	local l = sqrt(a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w)
+	if l > 0 then a.x, a.y, a.z, a.w = a.x / l, a.y / l, a.z / l, a.w / l end
+	return a
+end
+)lua"
+R"lua(
+---------------------------------------------------------------------- quat
+
+local quat_methods = {}
+local quat_mt = { __index = quat_methods }
+
+-- quat(), quat(x, y, z, w), quat(angle, axis) or quat(euler angles in radians)
+function quat_mt.__new(ct, x, y, z, w)
+	if x == nil then return new(ct, 0, 0, 0, 1) end
+	if istype(quat_t, x) then return new(ct, x.x, x.y, x.z, x.w) end
+	if type(x) == 'number' and y ~= nil and z == nil then
+		local l = sqrt(y.x * y.x + y.y * y.y + y.z * y.z)
+		local s = sin(x * 0.5) / l
+		return new(ct, y.x * s, y.y * s, y.z * s, cos(x * 0.5))
+	end
+	if y == nil then
+		local cx, cy, cz = cos(x.x * 0.5), cos(x.y * 0.5), cos(x.z * 0.5)
+		local sx, sy, sz = sin(x.x * 0.5), sin(x.y * 0.5), sin(x.z * 0.5)
+		return new(ct, sx * cy * cz - cx * sy * sz, cx * sy * cz + sx * cy * sz, cx * cy * sz - sx * sy * cz, cx * cy * cz + sx * sy * sz)
+	end
+	return new(ct, x, y, z, w)
+end
+
+local function quat_rotate(q, v)
+	-- v + 2w(q x v) + 2q x (q x v)
+	local qx, qy, qz, qw = q.x, q.y, q.z, q.w
+	local tx, ty, tz = 2 * (qy * v.z - qz * v.y), 2 * (qz * v.x - qx * v.z), 2 * (qx * v.y - qy * v.x)
+	return vec3_t(v.x + qw * tx + (qy * tz - qz * ty), v.y + qw * ty + (qz * tx - qx * tz), v.z + qw * tz + (qx * ty - qy * tx))
+end
+
+function quat_mt.__mul(a, b)
+	if type(b) == 'number' then return quat_t(a.x * b, a.y * b, a.z * b, a.w * b) end
+	if istype(vec3_t, b) then return quat_rotate(a, b) end
+	return quat_t(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		a.w * b.y + a.y * b.w + a.z * b.x - a.x * b.z,
+		a.w * b.z + a.z * b.w + a.x * b.y - a.y * b.x,
+		a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z)
+end
+function quat_mt.__unm(a) return quat_t(-a.x, -a.y, -a.z, -a.w) end
+function quat_mt.__eq(a, b) return istype(quat_t, b) and a.x == b.x and a.y == b.y and a.z == b.z and a.w == b.w end
+function quat_mt.__tostring(a) return string.format('quat(%g, %g, %g, %g)', a.x, a.y, a.z, a.w) end
+
+function quat_methods.set(q, x, y, z, w)
+	if y == nil then x, y, z, w = x.x, x.y, x.z, x.w end
+	q.x, q.y, q.z, q.w = x, y, z, w
+	return q
+end
+function quat_methods.clone(q) return quat_t(q.x, q.y, q.z, q.w) end
+function quat_methods.dot(a, b) return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w end
+function quat_methods.length(q) return sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w) end
+function quat_methods.conjugate(q) return quat_t(-q.x, -q.y, -q.z, q.w) end
+function quat_methods.inverse(q)
+	local d = q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w
+	return quat_t(-q.x / d, -q.y / d, -q.z / d, q.w / d)
+end
+function quat_methods.normalized(q)
+	local l = sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w)
+	return l > 0 and quat_t(q.x / l, q.y / l, q.z / l, q.w / l) or quat_t(0, 0, 0, 1)
+end
+function quat_methods.normalize(q)
+	local l = sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w)
+	if l > 0 then q.x, q.y, q.z, q.w = q.x / l, q.y / l, q.z / l, q.w / l end
+	return q
+end
+quat_methods.rotate = quat_rotate
+function quat_methods.slerp(a, b, t)
+	local bx, by, bz, bw = b.x, b.y, b.z, b.w
+	local d = a.x * bx + a.y * by + a.z * bz + a.w * bw
+	if d < 0 then d, bx, by, bz, bw = -d, -bx, -by, -bz, -bw end
+
+	local s0, s1
+	if d > 0.9995 then
+		s0, s1 = 1 - t, t
+	else
+		local theta = acos(d)
+		local s = sin(theta)
+		s0, s1 = sin((1 - t) * theta) / s, sin(t * theta) / s
+	end
+
+	return quat_t(a.x * s0 + bx * s1, a.y * s0 + by * s1, a.z * s0 + bz * s1, a.w * s0 + bw * s1)
+end
+function quat_methods.toMat4(q)
+	local x, y, z, w = q.x, q.y, q.z, q.w
+	local m = mat4_t()
+	m.d[0], m.d[1], m.d[2] = 1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w)
+	m.d[4], m.d[5], m.d[6] = 2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w)
+	m.d[8], m.d[9], m.d[10] = 2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y)
+	m.d[15] = 1
+	return m
+end
+)lua"
+R"lua(
+---------------------------------------------------------------------- mat4
+
+-- Column major, like glm: d[column * 4 + row]
+local mat4_methods = {}
+local mat4_mt = { __index = mat4_methods }
+
+function mat4_mt.__new(ct, s)
+	local m = new(ct)
+	if s == nil then s = 1 end
+	if type(s) == 'number' then
+		m.d[0], m.d[5], m.d[10], m.d[15] = s, s, s, s
+	else
+		ffi.copy(m, s, 64)
+	end
+	return m
+end
+
+local function mat4_mul(a, b)
+	local r = mat4_t(0)
+	local ad, bd, rd = a.d, b.d, r.d
+	for c = 0, 12, 4 do
+		local b0, b1, b2, b3 = bd[c], bd[c + 1], bd[c + 2], bd[c + 3]
+		rd[c] = ad[0] * b0 + ad[4] * b1 + ad[8] * b2 + ad[12] * b3
+		rd[c + 1] = ad[1] * b0 + ad[5] * b1 + ad[9] * b2 + ad[13] * b3
+		rd[c + 2] = ad[2] * b0 + ad[6] * b1 + ad[10] * b2 + ad[14] * b3
+		rd[c + 3] = ad[3] * b0 + ad[7] * b1 + ad[11] * b2 + ad[15] * b3
+	end
+	return r
+end
+
+function mat4_mt.__mul(a, b)
+	if type(b) == 'number' then
+		local r = mat4_t(0)
+		for i = 0, 15 do r.d[i] = a.d[i] * b end
+		return r
+	end
+	local d = a.d
+	if istype(vec4_t, b) then
+		return vec4_t(d[0] * b.x + d[4] * b.y + d[8] * b.z + d[12] * b.w,
+			d[1] * b.x + d[5] * b.y + d[9] * b.z + d[13] * b.w,
+			d[2] * b.x + d[6] * b.y + d[10] * b.z + d[14] * b.w,
+			d[3] * b.x + d[7] * b.y + d[11] * b.z + d[15] * b.w)
+	end
+	if istype(vec3_t, b) then
+		-- Transforms a point
+		return vec3_t(d[0] * b.x + d[4] * b.y + d[8] * b.z + d[12],
+			d[1] * b.x + d[5] * b.y + d[9] * b.z + d[13],
+			d[2] * b.x + d[6] * b.y + d[10] * b.z + d[14])
+	end
+	return mat4_mul(a, b)
+end
+function mat4_mt.__eq(a, b)
+	if not istype(mat4_t, b) then return false end
+	for i = 0, 15 do if a.d[i] ~= b.d[i] then return false end end
+	return true
+end
+function mat4_mt.__tostring(m)
+	local d = m.d
+	return string.format('mat4((%g, %g, %g, %g), (%g, %g, %g, %g), (%g, %g, %g, %g), (%g, %g, %g, %g))',
+		d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8], d[9], d[10], d[11], d[12], d[13], d[14], d[15])
+end
+
+function mat4_methods.clone(m) return mat4_t(m) end
+function mat4_methods.get(m, column, row) return m.d[column * 4 + row] end
+function mat4_methods.setElement(m, column, row, v) m.d[column * 4 + row] = v return m end
+function mat4_methods.set(m, s) ffi.copy(m, s, 64) return m end
+function mat4_methods.identity(m)
+	ffi.fill(m, 64)
+	m.d[0], m.d[5], m.d[10], m.d[15] = 1, 1, 1, 1
+	return m
+end
+function mat4_methods.transpose(m)
+	local r, d = mat4_t(0), m.d
+	for c = 0, 3 do for r_ = 0, 3 do r.d[c * 4 + r_] = d[r_ * 4 + c] end end
+	return r
+end
+function mat4_methods.translate(m, v)
+	local t = mat4_t()
+	t.d[12], t.d[13], t.d[14] = v.x, v.y, v.z
+	return mat4_mul(m, t)
+end
+function mat4_methods.scale(m, v)
+	local s = mat4_t()
+	s.d[0], s.d[5], s.d[10] = v.x, v.y, v.z
+	return mat4_mul(m, s)
+end
+function mat4_methods.rotate(m, angle, axis) return mat4_mul(m, quat_t(angle, axis):toMat4()) end
+function mat4_methods.determinant(m)
+	local d = m.d
+	local s0 = d[0] * d[5] - d[4] * d[1]
+	local s1 = d[0] * d[6] - d[4] * d[2]
+	local s2 = d[0] * d[7] - d[4] * d[3]
+	local s3 = d[1] * d[6] - d[5] * d[2]
+	local s4 = d[1] * d[7] - d[5] * d[3]
+	local s5 = d[2] * d[7] - d[6] * d[3]
+	local c5 = d[10] * d[15] - d[14] * d[11]
+	local c4 = d[9] * d[15] - d[13] * d[11]
+	local c3 = d[9] * d[14] - d[13] * d[10]
+	local c2 = d[8] * d[15] - d[12] * d[11]
+	local c1 = d[8] * d[14] - d[12] * d[10]
+	local c0 = d[8] * d[13] - d[12] * d[9]
+	return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0
+end
+function mat4_methods.inverse(m)
+	local d = m.d
+	local s0 = d[0] * d[5] - d[4] * d[1]
+	local s1 = d[0] * d[6] - d[4] * d[2]
+	local s2 = d[0] * d[7] - d[4] * d[3]
+	local s3 = d[1] * d[6] - d[5] * d[2]
+	local s4 = d[1] * d[7] - d[5] * d[3]
+	local s5 = d[2] * d[7] - d[6] * d[3]
+	local c5 = d[10] * d[15] - d[14] * d[11]
+	local c4 = d[9] * d[15] - d[13] * d[11]
+	local c3 = d[9] * d[14] - d[13] * d[10]
+	local c2 = d[8] * d[15] - d[12] * d[11]
+	local c1 = d[8] * d[14] - d[12] * d[10]
+	local c0 = d[8] * d[13] - d[12] * d[9]
+	local det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0
+	if det == 0 then return mat4_t(0) end
+	local i = 1 / det
+
+	local r = mat4_t(0)
+	local o = r.d
+	o[0] = (d[5] * c5 - d[6] * c4 + d[7] * c3) * i
+	o[4] = (-d[4] * c5 + d[6] * c2 - d[7] * c1) * i
+	o[8] = (d[4] * c4 - d[5] * c2 + d[7] * c0) * i
+	o[12] = (-d[4] * c3 + d[5] * c1 - d[6] * c0) * i
+	o[1] = (-d[1] * c5 + d[2] * c4 - d[3] * c3) * i
+	o[5] = (d[0] * c5 - d[2] * c2 + d[3] * c1) * i
+	o[9] = (-d[0] * c4 + d[1] * c2 - d[3] * c0) * i
+	o[13] = (d[0] * c3 - d[1] * c1 + d[2] * c0) * i
+	o[2] = (d[13] * s5 - d[14] * s4 + d[15] * s3) * i
+	o[6] = (-d[12] * s5 + d[14] * s2 - d[15] * s1) * i
+	o[10] = (d[12] * s4 - d[13] * s2 + d[15] * s0) * i
+	o[14] = (-d[12] * s3 + d[13] * s1 - d[14] * s0) * i
+	o[3] = (-d[9] * s5 + d[10] * s4 - d[11] * s3) * i
+	o[7] = (d[8] * s5 - d[10] * s2 + d[11] * s1) * i
+	o[11] = (-d[8] * s4 + d[9] * s2 - d[11] * s0) * i
+	o[15] = (d[8] * s3 - d[9] * s1 + d[10] * s0) * i
+	return r
+end
+function mat4_methods.mul(a, b)
+	local r = mat4_mul(a, b)
+	ffi.copy(a, r, 64)
+	return a
+end
+
+vec2 = ffi.metatype(vec2_t, vec2_mt)
+vec3 = ffi.metatype(vec3_t, vec3_mt)
+vec4 = ffi.metatype(vec4_t, vec4_mt)
+quat = ffi.metatype(quat_t, quat_mt)
+mat4 = ffi.metatype(mat4_t, mat4_mt)
+)lua"
+R"lua(
+-- Pools, conversions and pointer access live on the types as well: vec3.acquire(), vec3.from(ptr), v:store(ptr)
+local function statics(ct, ptr, methods, size)
+	local acquire, release = pool(ct)
+	methods.acquire = acquire
+	methods.release = release
+	methods.from = function(p) return ct(ffi.cast(ptr, p)[0]) end
+	methods.store = function(v, p) ffi.copy(ffi.cast(ptr, p), v, size) return v end
+end
+
+statics(vec2, 'vec2 *', vec2_methods, 8)
+statics(vec3, 'vec3 *', vec3_methods, 12)
+statics(vec4, 'vec4 *', vec4_methods, 16)
+statics(quat, 'quat *', quat_methods, 16)
+statics(mat4, 'mat4 *', mat4_methods, 64)
+
+_G.vec2, _G.vec3, _G.vec4, _G.quat, _G.mat4 = vec2, vec3, vec4, quat, mat4
+)lua"
+R"lua(
+-- Compatibility shims for the M_ functions. Engine pointers still go to the C implementations,
+-- which are faster than casting light userdata here (the JIT cannot compile that conversion);
+-- calls involving any of the types above are handled in Lua.
+local vec2p, vec3p, vec4p, mat4p = ffi.typeof('vec2 *'), ffi.typeof('vec3 *'), ffi.typeof('vec4 *'), ffi.typeof('mat4 *')
+local cast = ffi.cast
+
+local function iscdata(v) return type(v) == 'cdata' end
+
+-- The C functions check the argument count, so each shim forwards exactly what it was registered with
+local forward = {
+	function(c, f) return function(a) if iscdata(a) then return f(a) end return c(a) end end,
+	function(c, f) return function(a, b) if iscdata(a) or iscdata(b) then return f(a, b) end return c(a, b) end end,
+	function(c, f)
+		return function(a, b, d)
+			if iscdata(a) or iscdata(b) or iscdata(d) then return f(a, b, d) end
+			return c(a, b, d)
+		end
+	end,
+	function(c, f)
+		return function(a, b, d, e)
+			if iscdata(a) or iscdata(b) or iscdata(d) or iscdata(e) then return f(a, b, d, e) end
+			return c(a, b, d, e)
+		end
+	end
+}
+
+local function shim(name, argc, f)
+	local c = _G[name]
+	_G[name] = c and forward[argc](c, f) or f
+end
+
+shim('M_vec2_Distance', 2, function(a, b) return vec2_methods.distance(cast(vec2p, a)[0], cast(vec2p, b)[0]) end)
+shim('M_vec2_Dot', 2, function(a, b) return vec2_methods.dot(cast(vec2p, a)[0], cast(vec2p, b)[0]) end)
+shim('M_vec2_Length', 1, function(a) return vec2_methods.length(cast(vec2p, a)[0]) end)
+shim('M_vec2_Reflect', 3, function(i, n, out) cast(vec2p, out)[0] = vec2_methods.reflect(cast(vec2p, i)[0], cast(vec2p, n)[0]) end)
+shim('M_vec2_Refract', 4, function(i, n, eta, out) cast(vec2p, out)[0] = vec2_methods.refract(cast(vec2p, i)[0], cast(vec2p, n)[0], eta) end)
+
+shim('M_vec3_Distance', 2, function(a, b) return vec3_methods.distance(cast(vec3p, a)[0], cast(vec3p, b)[0]) end)
+shim('M_vec3_Cross', 3, function(a, b, out) cast(vec3p, out)[0] = vec3_methods.cross(cast(vec3p, a)[0], cast(vec3p, b)[0]) end)
+shim('M_vec3_Dot', 2, function(a, b) return vec3_methods.dot(cast(vec3p, a)[0], cast(vec3p, b)[0]) end)
+shim('M_vec3_Length', 1, function(a) return vec3_methods.length(cast(vec3p, a)[0]) end)
+shim('M_vec3_Reflect', 3, function(i, n, out) cast(vec3p, out)[0] = vec3_methods.reflect(cast(vec3p, i)[0], cast(vec3p, n)[0]) end)
+shim('M_vec3_Refract', 4, function(i, n, eta, out) cast(vec3p, out)[0] = vec3_methods.refract(cast(vec3p, i)[0], cast(vec3p, n)[0], eta) end)
+
+shim('M_vec4_Distance', 2, function(a, b) return vec4_methods.distance(cast(vec4p, a)[0], cast(vec4p, b)[0]) end)
+shim('M_vec4_Dot', 2, function(a, b) return vec4_methods.dot(cast(vec4p, a)[0], cast(vec4p, b)[0]) end)
+shim('M_vec4_Length', 1, function(a) return vec4_methods.length(cast(vec4p, a)[0]) end)
+shim('M_vec4_Reflect', 3, function(i, n, out) cast(vec4p, out)[0] = vec4_methods.reflect(cast(vec4p, i)[0], cast(vec4p, n)[0]) end)
+shim('M_vec4_Refract', 4, function(i, n, eta, out) cast(vec4p, out)[0] = vec4_methods.refract(cast(vec4p, i)[0], cast(vec4p, n)[0], eta) end)
+
+shim('M_mat4_Identity', 1, function(out) mat4_methods.identity(cast(mat4p, out)[0]) end)
+shim('M_mat4_Translate', 3, function(m, v, out) cast(mat4p, out)[0] = mat4_methods.translate(cast(mat4p, m)[0], cast(vec3p, v)[0]) end)
+shim('M_mat4_Rotate', 4, function(m, angle, axis, out) cast(mat4p, out)[0] = mat4_methods.rotate(cast(mat4p, m)[0], angle, cast(vec3p, axis)[0]) end)
+shim('M_mat4_Scale', 3, function(m, v, out) cast(mat4p, out)[0] = mat4_methods.scale(cast(mat4p, m)[0], cast(vec3p, v)[0]) end)
+shim('M_mat4_Determinant', 1, function(m) return mat4_methods.determinant(cast(mat4p, m)[0]) end)
+shim('M_mat4_Inverse', 2, function(m, out) cast(mat4p, out)[0] = mat4_methods.inverse(cast(mat4p, m)[0]) end)
+shim('M_mat4_Transpose', 2, function(m, out) cast(mat4p, out)[0] = mat4_methods.transpose(cast(mat4p, m)[0]) end)
+shim('M_mat4_Mul', 3, function(a, b, out) cast(mat4p, out)[0] = mat4_mul(cast(mat4p, a)[0], cast(mat4p, b)[0]) end)
+)lua";
+
+void VectorInterface::Register(lua_State *state)
+{
+	if (luaL_loadbuffer(state, _vectorTypes, strlen(_vectorTypes), "=VectorInterface") || lua_pcall(state, 0, 0, 0))
+	{
+		Logger::Log(VEC_IFACE_MODULE, LOG_CRITICAL, "Failed to register vector types: %s", lua_tostring(state, -1));
+		lua_pop(state, 1);
+	}
+}
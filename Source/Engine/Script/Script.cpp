@@ -37,10 +37,18 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <Engine/Engine.h>
 #include <System/Logger.h>
 #include <System/VFS/VFS.h>
 
 #include <Script/Script.h>
+#include <Script/ScriptScheduler.h>
 #include <Script/Interface/VFSInterface.h>
 #include <Script/Interface/GUIInterface.h>
 #include <Script/Interface/MathInterface.h>
@@ -48,6 +56,7 @@
 #include <Script/Interface/DebugInterface.h>
 #include <Script/Interface/SceneInterface.h>
 #include <Script/Interface/ObjectInterface.h>
+#include <Script/Interface/VectorInterface.h>
 #include <Script/Interface/EngineInterface.h>
 #include <Script/Interface/LoggerInterface.h>
 #include <Script/Interface/CameraInterface.h>
@@ -70,7 +79,75 @@
 #include <Script/Interface/AudioSourceComponentInterface.h>
 #include <Script/Interface/SkeletalMeshComponentInterface.h>
 
-#define SCRIPT_MODULE	"Script"
+#define SCRIPT_MODULE			"Script"
+#define SCRIPT_BYTECODE_HEADER	"NLUABC1"
+
+// Kept on the first line so error messages report the right line numbers
+#define SCRIPT_CHUNK_PREFIX		"local ffi = require('ffi') "
+
+using namespace std;
+
+struct ScriptVM
+{
+	lua_State *state;
+	int instanceMetatable;
+	unordered_map<string, int> chunks;
+};
+
+// Data types
+static const char *_scriptTypes =
+	"local ffi = require('ffi')	\n\
+		ffi.cdef([[					\n\
+		typedef struct				\n\
+		{							\n\
+			float x, y;				\n\
+		} vec2;						\n\
+		typedef struct				\n\
+		{							\n\
+			float x, y, z;			\n\
+		} vec3;						\n\
+		typedef struct				\n\
+		{							\n\
+			float x, y, z, w;		\n\
+		} vec4;						\n\
+		typedef struct				\n\
+		{							\n\
+			float x, y, z, w;		\n\
+		} quat;						\n\
+		typedef struct				\n\
+		{							\n\
+			float d[4];				\n\
+		} mat2;						\n\
+		typedef struct				\n\
+		{							\n\
+			float d[9];				\n\
+		} mat3;						\n\
+		typedef struct				\n\
+		{							\n\
+			float d[16];			\n\
+		} mat4;						\n\
+		typedef struct				\n\
+		{							\n\
+			mat4 position;			\n\
+			mat4 direction;			\n\
+			mat4 color;				\n\
+			mat4 data;				\n\
+		} Light;					\n\
+		typedef struct				\n\
+		{							\n\
+			int vertexOffset;		\n\
+			int vertexCount;		\n\
+			int indexOffset;		\n\
+			int indexCount;			\n\
+		} MeshGroup;				\n\
+	]])\n\n";
+
+static vector<ScriptVM *> _vms;
+static unordered_map<string, vector<char>> _bytecode;
+static mutex _vmLock;
+static atomic<uint32_t> _vmGeneration{ 1 };
+static thread_local ScriptVM *_threadVM{ nullptr };
+static thread_local uint32_t _threadVMGeneration{ 0 };
 
 lua_State *Script::NewState()
 {
@@ -137,50 +214,7 @@ bool Script::LoadScript(lua_State *state, NString &scriptFile)
 
 bool Script::LoadSource(lua_State *state, const char *src)
 {
-	// Data types
-	NString script =
-		"local ffi = require('ffi')	\n\
-		ffi.cdef([[					\n\
-		typedef struct				\n\
-		{							\n\
-			float x, y;				\n\
-		} vec2;						\n\
-		typedef struct				\n\
-		{							\n\
-			float x, y, z;			\n\
-		} vec3;						\n\
-		typedef struct				\n\
-		{							\n\
-			float x, y, z, w;		\n\
-		} vec4;						\n\
-		typedef struct				\n\
-		{							\n\
-			float d[4];				\n\
-		} mat2;						\n\
-		typedef struct				\n\
-		{							\n\
-			float d[9];				\n\
-		} mat3;						\n\
-		typedef struct				\n\
-		{							\n\
-			float d[16];			\n\
-		} mat4;						\n\
-		typedef struct				\n\
-		{							\n\
-			mat4 position;			\n\
-			mat4 direction;			\n\
-			mat4 color;				\n\
-			mat4 data;				\n\
-		} Light;					\n\
-		typedef struct				\n\
-		{							\n\
-			int vertexOffset;		\n\
-			int vertexCount;		\n\
-			int indexOffset;		\n\
-			int indexCount;			\n\
-		} MeshGroup;				\n\
-	]])\n\n";
-
+	NString script{ _scriptTypes };
 	script.Append(src);
 
 	if (luaL_dostring(state, *script) && lua_gettop(state))
@@ -227,4 +261,461 @@ NString Script::StackDump(lua_State *state)
 	dump.Append("\nEnd");
 
 	return dump;
-}
\ No newline at end of file
+}
+
+static ScriptVM *_script_GetVM(lua_State *state)
+{
+	if (_threadVM && _threadVMGeneration == _vmGeneration && _threadVM->state == state)
+		return _threadVM;
+
+	lock_guard<mutex> lock{ _vmLock };
+	for (ScriptVM *vm : _vms)
+		if (vm->state == state)
+			return vm;
+
+	return nullptr;
+}
+
+static int _script_Writer(lua_State *state, const void *p, size_t size, void *ud)
+{
+	(void)state;
+	vector<char> *bytecode{ (vector<char> *)ud };
+	bytecode->insert(bytecode->end(), (const char *)p, (const char *)p + size);
+	return 0;
+}
+
+static uint64_t _script_Hash(const char *src, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= (uint8_t)src[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+/**
+ * Hash of everything the bytecode depends on: the LuaJIT build, the prefix
+ * compiled with the source and the source itself
+ */
+static uint64_t _script_CacheHash(lua_State *state, const char *src, size_t size)
+{
+	uint64_t hash{ _script_Hash(SCRIPT_CHUNK_PREFIX, sizeof(SCRIPT_CHUNK_PREFIX) - 1) };
+
+	lua_getglobal(state, "jit");
+	if (lua_istable(state, -1))
+	{
+		for (const char *field : { "version", "arch" })
+		{
+			lua_getfield(state, -1, field);
+
+			size_t length{ 0 };
+			const char *value{ lua_tolstring(state, -1, &length) };
+			if (value)
+				hash = _script_Hash(value, length, hash);
+
+			lua_pop(state, 1);
+		}
+	}
+	lua_pop(state, 1);
+
+	return _script_Hash(src, size, hash);
+}
+
+static bool _script_ReadCache(const char *path, uint64_t hash, vector<char> &bytecode)
+{
+	NString cachePath{ path };
+	VFSFile *file{ VFS::Open(cachePath) };
+	if (!file)
+		return false;
+
+	char header[7]{};
+	uint64_t fileHash{ 0 };
+	uint32_t size{ 0 };
+	bool ret{ false };
+
+	if (file->Read(header, sizeof(char), 7) == 7 && !strncmp(header, SCRIPT_BYTECODE_HEADER, 7) &&
+		file->Read(&fileHash, sizeof(uint64_t), 1) == 1 && fileHash == hash &&
+		file->Read(&size, sizeof(uint32_t), 1) == 1 && size)
+	{
+		bytecode.resize(size);
+		ret = file->Read(bytecode.data(), sizeof(char), size) == size;
+	}
+
+	file->Close();
+
+	return ret;
+}
+
+static void _script_WriteCache(const char *path, uint64_t hash, const vector<char> &bytecode)
+{
+	NString cachePath{ path };
+	VFSFile *file{ VFS::Create(cachePath) };
+	if (!file)
+		return;
+
+	uint32_t size{ (uint32_t)bytecode.size() };
+
+	if (file->Write((void *)SCRIPT_BYTECODE_HEADER, sizeof(char), 7) != 7 ||
+		file->Write(&hash, sizeof(uint64_t), 1) != 1 ||
+		file->Write(&size, sizeof(uint32_t), 1) != 1 ||
+		file->Write((void *)bytecode.data(), sizeof(char), size) != size)
+		Logger::Log(SCRIPT_MODULE, LOG_WARNING, "Failed to write bytecode cache %s", path);
+
+	file->Close();
+	delete file;
+}
+
+/**
+ * Push the compiled chunk. Uses the process-wide bytecode if another VM
+ * loaded the script before, then the cache file, then compiles the source.
+ */
+static bool _script_LoadChunk(lua_State *state, const char *name, const char *chunkName, const char *src, size_t size, const char *cachePath)
+{
+	vector<char> bytecode{};
+	{
+		lock_guard<mutex> lock{ _vmLock };
+		auto it = _bytecode.find(name);
+		if (it != _bytecode.end())
+			bytecode = it->second;
+	}
+
+	if (!bytecode.empty() && !luaL_loadbuffer(state, bytecode.data(), bytecode.size(), chunkName))
+		return true;
+
+	if (!src)
+		return false;
+
+	const uint64_t hash{ _script_CacheHash(state, src, size) };
+
+	bytecode.clear();
+	if (cachePath && _script_ReadCache(cachePath, hash, bytecode) && !luaL_loadbuffer(state, bytecode.data(), bytecode.size(), chunkName))
+	{
+		lock_guard<mutex> lock{ _vmLock };
+		_bytecode[name] = move(bytecode);
+		return true;
+	}
+
+	string source{ SCRIPT_CHUNK_PREFIX };
+	source.append(src, size);
+
+	if (luaL_loadbuffer(state, source.data(), source.size(), chunkName))
+	{
+		Logger::Log(SCRIPT_MODULE, LOG_CRITICAL, "Script load error: %s", lua_tostring(state, -1));
+		lua_pop(state, 1);
+		return false;
+	}
+
+	bytecode.clear();
+	lua_dump(state, _script_Writer, &bytecode);
+
+	if (cachePath)
+		_script_WriteCache(cachePath, hash, bytecode);
+
+	lock_guard<mutex> lock{ _vmLock };
+	_bytecode[name] = move(bytecode);
+
+	return true;
+}
+
+lua_State *Script::GetState()
+{
+	if (_threadVM && _threadVMGeneration == _vmGeneration)
+		return _threadVM->state;
+
+	lua_State *state{ NewState() };
+
+	if (luaL_dostring(state, _scriptTypes) && lua_gettop(state))
+	{
+		Logger::Log(SCRIPT_MODULE, LOG_CRITICAL, "Failed to declare script types: %s", lua_tostring(state, -1));
+		lua_pop(state, 1);
+	}
+
+	VectorInterface::Register(state);
+	ScriptScheduler::Register(state);
+
+	// Instances read the VM's globals and keep their own writes
+	lua_newtable(state);
+	lua_pushvalue(state, LUA_GLOBALSINDEX);
+	lua_setfield(state, -2, "__index");
+
+	ScriptVM *vm{ new ScriptVM{ state, luaL_ref(state, LUA_REGISTRYINDEX), {} } };
+
+	{
+		lock_guard<mutex> lock{ _vmLock };
+		_vms.push_back(vm);
+	}
+
+	_threadVM = vm;
+	_threadVMGeneration = _vmGeneration;
+
+	return state;
+}
+
+/**
+ * Push the compiled chunk of a script file, reading the source if the
+ * bytecode is not cached in memory.
+ */
+static bool _script_LoadFile(lua_State *state, NString &scriptFile, const char *chunkName)
+{
+	if (_script_LoadChunk(state, *scriptFile, chunkName, nullptr, 0, nullptr))
+		return true;
+
+	size_t size{ 0 };
+	VFSFile *file{ VFS::Open(scriptFile) };
+	if (!file)
+	{
+		Logger::Log(SCRIPT_MODULE, LOG_CRITICAL, "Cannot open script file %s", *scriptFile);
+		return false;
+	}
+
+	// The size returned includes the terminator
+	char *src{ (char *)file->ReadAll(size, true) };
+	file->Close();
+
+	// Cached files are only found through the loose file list
+	char cachePath[VFS_MAX_FILE_NAME]{};
+	if (Engine::GetConfiguration().Engine.LoadLooseFiles)
+	{
+		snprintf(cachePath, VFS_MAX_FILE_NAME, "%s", *scriptFile);
+
+		char *ext{ strrchr(cachePath, '.') };
+		if (ext && !strchr(ext, '/'))
+			*ext = 0x0;
+		strncat(cachePath, ".luac", VFS_MAX_FILE_NAME - strlen(cachePath) - 1);
+	}
+
+	const bool loaded{ src && size && _script_LoadChunk(state, *scriptFile, chunkName, src, size - 1, cachePath[0] ? cachePath : nullptr) };
+	free(src);
+
+	return loaded;
+}
+
+int Script::LoadChunk(lua_State *state, NString &scriptFile)
+{
+	ScriptVM *vm{ _script_GetVM(state) };
+	if (!vm)
+		return LUA_NOREF;
+
+	auto it = vm->chunks.find(*scriptFile);
+	if (it != vm->chunks.end())
+		return it->second;
+
+	NString chunkName{ "@" };
+	chunkName.Append(*scriptFile);
+
+	if (!_script_LoadFile(state, scriptFile, *chunkName))
+	{
+		Logger::Log(SCRIPT_MODULE, LOG_CRITICAL, "Failed to load script %s", *scriptFile);
+		return LUA_NOREF;
+	}
+
+	const int ref{ luaL_ref(state, LUA_REGISTRYINDEX) };
+	vm->chunks.insert({ *scriptFile, ref });
+
+	return ref;
+}
+
+int Script::ReloadChunk(lua_State *state, NString &scriptFile)
+{
+	ScriptVM *vm{ _script_GetVM(state) };
+	if (!vm)
+		return LUA_NOREF;
+
+	NString chunkName{ "@" };
+	chunkName.Append(*scriptFile);
+
+	// Compile from the source; the old bytecode stays if that fails
+	vector<char> bytecode{};
+	{
+		lock_guard<mutex> lock{ _vmLock };
+		auto it = _bytecode.find(*scriptFile);
+		if (it != _bytecode.end())
+		{
+			bytecode = move(it->second);
+			_bytecode.erase(it);
+		}
+	}
+
+	if (!_script_LoadFile(state, scriptFile, *chunkName))
+	{
+		if (!bytecode.empty())
+		{
+			lock_guard<mutex> lock{ _vmLock };
+			_bytecode.insert({ *scriptFile, move(bytecode) });
+		}
+
+		Logger::Log(SCRIPT_MODULE, LOG_CRITICAL, "Failed to reload script %s", *scriptFile);
+		return LUA_NOREF;
+	}
+
+	const int ref{ luaL_ref(state, LUA_REGISTRYINDEX) };
+
+	auto it = vm->chunks.find(*scriptFile);
+	if (it != vm->chunks.end())
+	{
+		luaL_unref(state, LUA_REGISTRYINDEX, it->second);
+		it->second = ref;
+	}
+	else
+	{
+		vm->chunks.insert({ *scriptFile, ref });
+	}
+
+	return ref;
+}
+
+int Script::LoadSourceChunk(lua_State *state, const char *name, const char *src)
+{
+	ScriptVM *vm{ _script_GetVM(state) };
+	if (!vm || !src)
+		return LUA_NOREF;
+
+	auto it = vm->chunks.find(name);
+	if (it != vm->chunks.end())
+		return it->second;
+
+	NString chunkName{ "=" };
+	chunkName.Append(name);
+
+	if (!_script_LoadChunk(state, name, *chunkName, src, strlen(src), nullptr))
+		return LUA_NOREF;
+
+	const int ref{ luaL_ref(state, LUA_REGISTRYINDEX) };
+	vm->chunks.insert({ name, ref });
+
+	return ref;
+}
+
+uint64_t Script::HashSource(const char *src, size_t size)
+{
+	return _script_Hash(src, size);
+}
+
+int Script::NewInstance(lua_State *state, int chunk, void *parent)
+{
+	ScriptVM *vm{ _script_GetVM(state) };
+	if (!vm || chunk == LUA_NOREF)
+		return LUA_NOREF;
+
+	lua_newtable(state);
+	lua_rawgeti(state, LUA_REGISTRYINDEX, vm->instanceMetatable);
+	lua_setmetatable(state, -2);
+
+	lua_pushlightuserdata(state, parent);
+	lua_setfield(state, -2, "parent");
+
+	// Functions created by the chunk keep the environment it ran in, so
+	// the chunk can be shared by all instances
+	lua_rawgeti(state, LUA_REGISTRYINDEX, chunk);
+	lua_pushvalue(state, -2);
+	lua_setfenv(state, -2);
+
+	if (lua_pcall(state, 0, 0, 0))
+	{
+		Logger::Log(SCRIPT_MODULE, LOG_CRITICAL, "Script load error: %s", lua_tostring(state, -1));
+		lua_pop(state, 2);
+		return LUA_NOREF;
+	}
+
+	return luaL_ref(state, LUA_REGISTRYINDEX);
+}
+
+bool Script::ReloadInstance(lua_State *state, int chunk, int instance)
+{
+	if (chunk == LUA_NOREF || instance == LUA_NOREF)
+		return false;
+
+	// Keep a copy of the instance's values, the chunk assigns its defaults
+	lua_newtable(state);
+	lua_rawgeti(state, LUA_REGISTRYINDEX, instance);
+
+	lua_pushnil(state);
+	while (lua_next(state, -2))
+	{
+		if (lua_isfunction(state, -1))
+		{
+			lua_pop(state, 1);
+			continue;
+		}
+
+		lua_pushvalue(state, -2);
+		lua_insert(state, -2);
+		lua_rawset(state, -5);
+	}
+
+	// Run the new code in the same environment so every function it defines,
+	// local ones included, sees the instance's state
+	lua_rawgeti(state, LUA_REGISTRYINDEX, chunk);
+	lua_pushvalue(state, -2);
+	lua_setfenv(state, -2);
+
+	const bool ret{ lua_pcall(state, 0, 0, 0) == 0 };
+	if (!ret)
+	{
+		Logger::Log(SCRIPT_MODULE, LOG_CRITICAL, "Script reload error: %s", lua_tostring(state, -1));
+		lua_pop(state, 1);
+	}
+
+	// Restore the state, new fields keep the value the chunk gave them
+	lua_pushnil(state);
+	while (lua_next(state, -3))
+	{
+		lua_pushvalue(state, -2);
+		lua_insert(state, -2);
+		lua_rawset(state, -4);
+	}
+
+	lua_pop(state, 2);
+
+	return ret;
+}
+
+int Script::GetFunction(lua_State *state, int instance, const char *name)
+{
+	if (instance == LUA_NOREF)
+		return LUA_NOREF;
+
+	lua_rawgeti(state, LUA_REGISTRYINDEX, instance);
+	lua_pushstring(state, name);
+	lua_rawget(state, -2);
+
+	if (!lua_isfunction(state, -1))
+	{
+		lua_pop(state, 2);
+		return LUA_NOREF;
+	}
+
+	const int ref{ luaL_ref(state, LUA_REGISTRYINDEX) };
+	lua_pop(state, 1);
+
+	return ref;
+}
+
+void Script::Unref(lua_State *state, int ref)
+{
+	if (ref == LUA_NOREF || ref == LUA_REFNIL || !_script_GetVM(state))
+		return;
+
+	luaL_unref(state, LUA_REGISTRYINDEX, ref);
+}
+
+void Script::Release()
+{
+	lock_guard<mutex> lock{ _vmLock };
+
+	ScriptScheduler::Release();
+
+	for (ScriptVM *vm : _vms)
+	{
+		lua_close(vm->state);
+		delete vm;
+	}
+
+	_vms.clear();
+	_bytecode.clear();
+
+	// Invalidates the VM pointers of all threads
+	++_vmGeneration;
+}
@@ -0,0 +1,461 @@
+/* NekoEngine
+ *
+ * ScriptScheduler.cpp
+ * Author: Alexandru Naiman
+ *
+ * Script execution budgets, coroutines and garbage collection
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include <Engine/Engine.h>
+#include <System/Logger.h>
+#include <Profiler/Profiler.h>
+#include <Script/ScriptScheduler.h>
+
+#define SCHED_MODULE		"ScriptScheduler"
+#define SCHED_HOOK_INTERVAL	1000
+
+// Heap size in KB below which the collector never falls back to running on allocation
+#define SCHED_MIN_HEAP_LIMIT	(16 * 1024)
+
+using namespace std;
+using namespace glm;
+using namespace std::chrono;
+
+struct ScriptCoroutine
+{
+	int id;
+	lua_State *vm;
+	lua_State *thread;
+	int ref;
+	void *owner;
+	int script;
+	double wakeTime;
+	uint64_t wakeFrame;
+	bool dead;
+};
+
+// State of the call being executed, saved and restored around nested calls
+struct ScriptCallState
+{
+	ScriptCoroutine *running;
+	void *owner;
+	int script;
+	int64_t instructions;
+	bool metering;
+};
+
+static vector<ScriptCoroutine *> _coroutines;
+static vector<string> _scriptNames;
+static unordered_map<string, int> _scriptIds;
+static vector<ScriptStats> _stats, _frameStats;
+static ScriptCallState _call{ nullptr, nullptr, -1, 0, false };
+static bool _aborted{ false }, _updating{ false };
+static double _time{ 0.0 }, _gcTime{ 0.0 };
+static uint64_t _frame{ 0 };
+static int _nextCoroutineId{ 1 };
+static size_t _liveHeap{ 0 }, _cycleMinHeap{ SIZE_MAX };
+
+static inline size_t _sched_Memory(lua_State *state)
+{
+	return (size_t)lua_gc(state, LUA_GCCOUNT, 0) * 1024 + (size_t)lua_gc(state, LUA_GCCOUNTB, 0);
+}
+
+static inline void _sched_Account(int script, high_resolution_clock::time_point start, size_t memory, size_t memoryAfter, bool aborted)
+{
+	if (script < 0)
+		return;
+
+	ScriptStats &stats{ _stats[script] };
+	stats.time += duration<double>(high_resolution_clock::now() - start).count();
+	stats.allocated += memoryAfter > memory ? memoryAfter - memory : 0;
+	++stats.calls;
+
+	if (aborted)
+		++stats.aborts;
+}
+
+static void _sched_Hook(lua_State *state, lua_Debug *ar)
+{
+	(void)ar;
+
+	if (!_call.metering)
+		return;
+
+	const int budget{ Engine::GetConfiguration().Engine.ScriptInstructionBudget };
+
+	// Armed to run at once by an aborted nested call, see _sched_Leave
+	if (lua_gethookcount(state) != SCHED_HOOK_INTERVAL)
+		lua_sethook(state, _sched_Hook, LUA_MASKCOUNT, SCHED_HOOK_INTERVAL);
+	else
+		_call.instructions += SCHED_HOOK_INTERVAL;
+
+	if (_call.instructions <= budget)
+		return;
+
+	_aborted = true;
+	luaL_error(state, "instruction budget of %d exceeded", budget);
+}
+
+/**
+ * Make a call the current one. A call made while another one runs counts
+ * against the instructions left to the outer call.
+ */
+static inline ScriptCallState _sched_Enter(ScriptCoroutine *co, void *owner, int script)
+{
+	const ScriptCallState prev{ _call };
+	_call = { co, owner, script, prev.metering ? prev.instructions : 0, true };
+	_aborted = false;
+
+	return prev;
+}
+
+/**
+ * Restore the outer call. If the budget ran out in a nested call, the outer
+ * call is stopped at its next instruction; it would otherwise only be checked
+ * when the hook happens to fire outside the nested calls.
+ */
+static inline void _sched_Leave(ScriptCallState prev, lua_State *vm)
+{
+	if (prev.metering)
+	{
+		prev.instructions = _call.instructions;
+
+		if (_aborted)
+			lua_sethook(prev.running ? prev.running->thread : vm, _sched_Hook, LUA_MASKCOUNT, 1);
+	}
+
+	_call = prev;
+}
+
+static void _sched_Resume(ScriptCoroutine *co, int nargs)
+{
+	const ScriptCallState prev{ _sched_Enter(co, co->owner, co->script) };
+
+	// A plain coroutine.yield() waits for the next frame
+	co->wakeFrame = _frame + 1;
+	co->wakeTime = 0.0;
+
+	const size_t memory{ _sched_Memory(co->vm) };
+	const high_resolution_clock::time_point start{ high_resolution_clock::now() };
+
+	const int ret{ lua_resume(co->thread, nargs) };
+
+	_sched_Account(co->script, start, memory, _sched_Memory(co->vm), _aborted);
+
+	if (ret == LUA_YIELD)
+	{
+		lua_settop(co->thread, 0);
+	}
+	else
+	{
+		if (ret)
+		{
+			const char *script{ co->script < 0 ? "(none)" : _scriptNames[co->script].c_str() };
+			Logger::Log(SCHED_MODULE, LOG_CRITICAL, "Coroutine %d of script %s failed: %s", co->id, script, lua_tostring(co->thread, -1));
+		}
+
+		co->dead = true;
+	}
+
+	_sched_Leave(prev, co->vm);
+}
+
+static void _sched_RemoveDead()
+{
+	_coroutines.erase(remove_if(_coroutines.begin(), _coroutines.end(), [](ScriptCoroutine *co) {
+		if (!co->dead)
+			return false;
+
+		Script::Unref(co->vm, co->ref);
+		delete co;
+
+		return true;
+	}), _coroutines.end());
+}
+
+static ScriptCoroutine *_sched_Running(lua_State *state, const char *function)
+{
+	if (!_call.running || _call.running->thread != state)
+	{
+		luaL_error(state, "%s() must be called from a coroutine started with StartCoroutine()", function);
+		return nullptr;
+	}
+
+	return _call.running;
+}
+
+static int _sched_StartCoroutine(lua_State *state)
+{
+	luaL_checktype(state, 1, LUA_TFUNCTION);
+
+	const int nargs{ lua_gettop(state) - 1 };
+	lua_State *thread{ lua_newthread(state) };
+
+	lua_insert(state, 1);
+	lua_xmove(state, thread, nargs + 1);
+
+	ScriptCoroutine *co{ new ScriptCoroutine{ _nextCoroutineId++, Script::GetState(), thread, luaL_ref(state, LUA_REGISTRYINDEX),
+		_call.owner, _call.script, 0.0, 0, false } };
+	_coroutines.push_back(co);
+
+	const int id{ co->id };
+	_sched_Resume(co, nargs);
+
+	lua_pushinteger(state, id);
+	return 1;
+}
+
+static int _sched_StopCoroutine(lua_State *state)
+{
+	const int id{ (int)luaL_checkinteger(state, 1) };
+
+	for (ScriptCoroutine *co : _coroutines)
+		if (co->id == id)
+			co->dead = true;
+
+	if (!_updating && !_call.running)
+		_sched_RemoveDead();
+
+	return 0;
+}
+
+static int _sched_Wait(lua_State *state)
+{
+	ScriptCoroutine *co{ _sched_Running(state, "Wait") };
+	co->wakeTime = _time + luaL_checknumber(state, 1);
+	return lua_yield(state, 0);
+}
+
+static int _sched_WaitFrames(lua_State *state)
+{
+	ScriptCoroutine *co{ _sched_Running(state, "WaitFrames") };
+	co->wakeFrame = _frame + std::max<lua_Integer>(luaL_checkinteger(state, 1), 1);
+	return lua_yield(state, 0);
+}
+
+static int _sched_Yield(lua_State *state)
+{
+	_sched_Running(state, "Yield");
+	return lua_yield(state, 0);
+}
+
+static void _sched_CollectGarbage(lua_State *state)
+{
+	const double budget{ Engine::GetConfiguration().Engine.ScriptGCBudget / 1000.0 };
+
+	if (budget <= 0.0)
+	{
+		_gcTime = 0.0;
+		return;
+	}
+
+	const high_resolution_clock::time_point start{ high_resolution_clock::now() };
+	bool cycleDone{ false };
+
+	do
+	{
+		if ((cycleDone = lua_gc(state, LUA_GCSTEP, 0) != 0))
+			break;
+	} while (duration<double>(high_resolution_clock::now() - start).count() < budget);
+
+	_gcTime = duration<double>(high_resolution_clock::now() - start).count();
+
+	// The smallest heap seen during a cycle is the closest to the live size
+	const size_t heap{ (size_t)lua_gc(state, LUA_GCCOUNT, 0) };
+	_cycleMinHeap = std::min(_cycleMinHeap, heap);
+
+	if (cycleDone)
+	{
+		_liveHeap = _cycleMinHeap;
+		_cycleMinHeap = SIZE_MAX;
+	}
+
+	// If allocation outpaces the budget, the collector keeps running on
+	// allocation until the heap is back in bounds instead of letting it grow
+	if (heap > std::max<size_t>(_liveHeap * 2, SCHED_MIN_HEAP_LIMIT))
+		return;
+
+	lua_gc(state, LUA_GCSTOP, 0);
+}
+
+static void _sched_ReportStats()
+{
+#if defined(NE_CONFIG_DEBUG) || defined(NE_CONFIG_DEVELOPMENT)
+	for (size_t i = 0; i < _stats.size(); ++i)
+	{
+		const ScriptStats &stats{ _stats[i] };
+		if (!stats.calls)
+			continue;
+
+		PROF_COUNTER(_scriptNames[i].c_str(), stats.time * 1000.0, "ms", vec3(0.f, 1.f, 1.f));
+		PROF_COUNTER((_scriptNames[i] + " alloc").c_str(), stats.allocated / 1024.0, "KB", vec3(0.f, 1.f, 1.f));
+	}
+
+	PROF_COUNTER("Script GC", _gcTime * 1000.0, "ms", vec3(0.f, 1.f, 1.f));
+#endif
+
+	_frameStats = _stats;
+	fill(_stats.begin(), _stats.end(), ScriptStats{ 0.0, 0, 0, 0 });
+}
+
+void ScriptScheduler::Register(lua_State *state)
+{
+	lua_register(state, "StartCoroutine", _sched_StartCoroutine);
+	lua_register(state, "StopCoroutine", _sched_StopCoroutine);
+	lua_register(state, "Wait", _sched_Wait);
+	lua_register(state, "WaitFrames", _sched_WaitFrames);
+	lua_register(state, "Yield", _sched_Yield);
+
+	if (Engine::GetConfiguration().Engine.ScriptGCBudget > 0.f)
+		lua_gc(state, LUA_GCSTOP, 0);
+
+	if (Engine::GetConfiguration().Engine.ScriptInstructionBudget > 0)
+	{
+		// Compiled code does not run hooks, so a budget requires the interpreter
+		if (luaL_dostring(state, "if jit then jit.off() jit.flush() end"))
+			lua_pop(state, 1);
+
+		lua_sethook(state, _sched_Hook, LUA_MASKCOUNT, SCHED_HOOK_INTERVAL);
+	}
+}
+
+int ScriptScheduler::RegisterScript(const char *name)
+{
+	unordered_map<string, int>::iterator it{ _scriptIds.find(name) };
+	if (it != _scriptIds.end())
+		return it->second;
+
+	const int id{ (int)_scriptNames.size() };
+
+	_scriptIds.insert({ name, id });
+	_scriptNames.push_back(name);
+	_stats.push_back({ 0.0, 0, 0, 0 });
+
+	return id;
+}
+
+int ScriptScheduler::Call(lua_State *state, int nargs, int nresults, int script, void *owner)
+{
+	const ScriptCallState prev{ _sched_Enter(nullptr, owner, script) };
+
+	const size_t memory{ _sched_Memory(state) };
+	const high_resolution_clock::time_point start{ high_resolution_clock::now() };
+
+	const int ret{ lua_pcall(state, nargs, nresults, 0) };
+
+	const bool aborted{ _aborted };
+	_sched_Account(script, start, memory, _sched_Memory(state), aborted);
+
+	_sched_Leave(prev, state);
+	_aborted = aborted;
+
+	return ret;
+}
+
+bool ScriptScheduler::Aborted() noexcept
+{
+	return _aborted;
+}
+
+void ScriptScheduler::Update(double deltaTime)
+{
+	lua_State *state{ Script::GetState() };
+
+	// Coroutines started or rescheduled here wake in a later frame
+	_updating = true;
+	for (size_t i = 0; i < _coroutines.size(); ++i)
+	{
+		ScriptCoroutine *co{ _coroutines[i] };
+
+		if (co->dead || co->vm != state || co->wakeFrame > _frame || co->wakeTime > _time)
+			continue;
+
+		_sched_Resume(co, 0);
+	}
+	_updating = false;
+
+	_sched_RemoveDead();
+	_sched_CollectGarbage(state);
+	_sched_ReportStats();
+
+	++_frame;
+	_time += deltaTime;
+}
+
+void ScriptScheduler::Cancel(void *owner)
+{
+	for (ScriptCoroutine *co : _coroutines)
+		if (co->owner == owner)
+			co->dead = true;
+
+	if (!_updating && !_call.running)
+		_sched_RemoveDead();
+}
+
+size_t ScriptScheduler::GetCoroutineCount() noexcept
+{
+	return count_if(_coroutines.begin(), _coroutines.end(), [](const ScriptCoroutine *co) { return !co->dead; });
+}
+
+const ScriptStats *ScriptScheduler::GetFrameStats(const char *name)
+{
+	unordered_map<string, int>::iterator it{ _scriptIds.find(name) };
+	if (it == _scriptIds.end() || it->second >= (int)_frameStats.size())
+		return nullptr;
+
+	return &_frameStats[it->second];
+}
+
+double ScriptScheduler::GetGCTime() noexcept
+{
+	return _gcTime;
+}
+
+void ScriptScheduler::Release()
+{
+	// The VMs are closed right after this, which frees the threads
+	for (ScriptCoroutine *co : _coroutines)
+		delete co;
+
+	_coroutines.clear();
+	_call = { nullptr, nullptr, -1, 0, false };
+	_liveHeap = 0;
+	_cycleMinHeap = SIZE_MAX;
+}
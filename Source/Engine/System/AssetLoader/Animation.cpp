@@ -0,0 +1,295 @@
+/* NekoEngine
+ *
+ * Animation.cpp
+ * Author: Alexandru Naiman
+ *
+ * Animation clip loader
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <System/Logger.h>
+#include <System/VFS/VFS.h>
+#include <System/AssetLoader/AssetLoader.h>
+
+#define AL_MODULE	"AssetLoader"
+
+using namespace std;
+
+int AssetLoader::LoadAnimation(NString &file,
+						 std::string &name,
+						 double *duration,
+						 double *ticksPerSecond,
+						 vector<AnimationNode> &channels)
+{
+	char idBuff[8]{ 0x0 };
+	int ret{ ENGINE_FAIL };
+	memset(idBuff, 0x0, 8);
+
+	if (VFSFile *f = VFS::Open(file))
+	{
+		f->Read(idBuff, sizeof(char), 7);
+		idBuff[7] = 0x0;
+
+		if (!strncmp(idBuff, NANIM2_HEADER, 7))
+			ret = _LoadAnimationV2(f, name, duration, ticksPerSecond, channels);
+		else if (!strncmp(idBuff, NANIM3_HEADER, 7))
+			ret = _LoadAnimationV3(f, name, duration, ticksPerSecond, channels);
+		else
+		{
+			f->Close();
+			Logger::Log(AL_MODULE, LOG_CRITICAL, "File %s is not a valid animation", *file);
+			return ENGINE_INVALID_HEADER;
+		}
+
+		f->Close();
+
+		return ret;
+	}
+
+	Logger::Log(AL_MODULE, LOG_CRITICAL, "Failed to open AnimationClip file %s", *file);
+	return ENGINE_IO_FAIL;
+}
+
+int AssetLoader::_LoadAnimationV2(VFSFile *file,
+	std::string &name,
+	double *duration,
+	double *ticksPerSecond,
+	std::vector<AnimationNode> &channels)
+{
+	char idBuff[8]{ 0x0 };
+	uint32_t num{ 0 }, numChannels{ 0 }, numKeys{ 0 };
+	NString str{};
+
+	file->Read(&num, sizeof(uint32_t), 1);
+	str.Resize(num + 1);
+	file->Read(*str, sizeof(char), num);
+	str[num] = 0x0;
+	name = *str;
+
+	file->Read(duration, sizeof(double), 1);
+	file->Read(ticksPerSecond, sizeof(double), 1);
+
+	file->Read(&numChannels, sizeof(uint32_t), 1);
+	channels.resize(numChannels);
+	for (uint32_t i = 0; i < numChannels; ++i)
+	{
+		file->Read(&num, sizeof(uint32_t), 1);
+		channels[i].name.Resize(num + 1);
+		file->Read(*channels[i].name, sizeof(char), num);
+		channels[i].name[num] = 0x0;
+
+		file->Read(&numKeys, sizeof(uint32_t), 1);
+		channels[i].positionKeys.resize(numKeys);
+		for (uint32_t j = 0; j < numKeys; ++j)
+		{
+			file->Read(&channels[i].positionKeys[j].value.x, sizeof(double), 3);
+			file->Read(&channels[i].positionKeys[j].time, sizeof(double), 1);
+		}
+
+		file->Read(&numKeys, sizeof(uint32_t), 1);
+		channels[i].rotationKeys.resize(numKeys);
+		for (uint32_t j = 0; j < numKeys; ++j)
+		{
+			file->Read(&channels[i].rotationKeys[j].value.x, sizeof(double), 4);
+			file->Read(&channels[i].rotationKeys[j].time, sizeof(double), 1);
+		}
+
+		file->Read(&numKeys, sizeof(uint32_t), 1);
+		channels[i].scalingKeys.resize(numKeys);
+		for (uint32_t j = 0; j < numKeys; ++j)
+		{
+			file->Read(&channels[i].scalingKeys[j].value.x, sizeof(double), 3);
+			file->Read(&channels[i].scalingKeys[j].time, sizeof(double), 1);
+		}
+	}
+
+	file->Read(idBuff, sizeof(char), 7);
+	idBuff[7] = 0x0;
+
+	if (strncmp(idBuff, NANIM2_FOOTER, 7))
+		Logger::Log(AL_MODULE, LOG_WARNING, "Extra data in AnimationClip file %s", file->GetHeader().name);
+
+	return ENGINE_OK;
+}
+
+/**
+ * Returns true if the file has at least bytes left before end.
+ */
+static inline bool _al_Fits(VFSFile *file, size_t end, uint64_t bytes)
+{
+	size_t pos{ file->Tell() };
+	return pos <= end && bytes <= end - pos;
+}
+
+static inline bool _al_ReadVectorTrack(VFSFile *file, size_t end, CompressedVectorTrack &track)
+{
+	uint32_t numKeys{ 0 };
+
+	if (file->Read(&track.type, sizeof(uint8_t), 1) != 1)
+		return false;
+
+	if (track.type == ANIM_TRACK_DEFAULT)
+	{
+		return true;
+	}
+	else if (track.type == ANIM_TRACK_CONSTANT)
+	{
+		return file->Read(&track.min.x, sizeof(float), 3) == 3;
+	}
+	else if (track.type == ANIM_TRACK_QUANTIZED)
+	{
+		if (file->Read(&numKeys, sizeof(uint32_t), 1) != 1 ||
+			file->Read(&track.min.x, sizeof(float), 3) != 3 ||
+			file->Read(&track.extent.x, sizeof(float), 3) != 3)
+			return false;
+
+		if (!_al_Fits(file, end, (uint64_t)numKeys * (sizeof(float) + sizeof(uint16_t) * 3)))
+			return false;
+
+		track.times.resize(numKeys);
+		track.values.resize((size_t)numKeys * 3);
+		file->Read(track.times.data(), sizeof(float), numKeys);
+		file->Read(track.values.data(), sizeof(uint16_t), (size_t)numKeys * 3);
+
+		if (!numKeys)
+			track.type = ANIM_TRACK_DEFAULT;
+
+		return true;
+	}
+
+	return false;
+}
+
+static inline bool _al_ReadQuatTrack(VFSFile *file, size_t end, CompressedQuatTrack &track)
+{
+	uint32_t numKeys{ 0 };
+	float q[4]{ 0.f, 0.f, 0.f, 1.f };
+
+	if (file->Read(&track.type, sizeof(uint8_t), 1) != 1)
+		return false;
+
+	if (track.type == ANIM_TRACK_DEFAULT)
+	{
+		return true;
+	}
+	else if (track.type == ANIM_TRACK_CONSTANT)
+	{
+		if (file->Read(q, sizeof(float), 4) != 4)
+			return false;
+		track.constant = glm::quat(q[3], q[0], q[1], q[2]);
+		return true;
+	}
+	else if (track.type == ANIM_TRACK_QUANTIZED)
+	{
+		if (file->Read(&numKeys, sizeof(uint32_t), 1) != 1)
+			return false;
+
+		if (!_al_Fits(file, end, (uint64_t)numKeys * (sizeof(float) + sizeof(uint16_t) * 3)))
+			return false;
+
+		track.times.resize(numKeys);
+		track.values.resize((size_t)numKeys * 3);
+		file->Read(track.times.data(), sizeof(float), numKeys);
+		file->Read(track.values.data(), sizeof(uint16_t), (size_t)numKeys * 3);
+
+		if (!numKeys)
+			track.type = ANIM_TRACK_DEFAULT;
+
+		return true;
+	}
+
+	return false;
+}
+
+int AssetLoader::_LoadAnimationV3(VFSFile *file,
+	std::string &name,
+	double *duration,
+	double *ticksPerSecond,
+	std::vector<AnimationNode> &channels)
+{
+	char idBuff[8]{ 0x0 };
+	uint32_t num{ 0 }, numChannels{ 0 };
+	NString str{};
+	size_t start{ file->Tell() }, end{ 0 };
+
+	file->Seek(0, SEEK_END);
+	end = file->Tell();
+	file->Seek(start, SEEK_SET);
+
+	if (file->Read(&num, sizeof(uint32_t), 1) != 1 || !_al_Fits(file, end, num))
+		goto invalid;
+
+	str.Resize(num + 1);
+	file->Read(*str, sizeof(char), num);
+	str[num] = 0x0;
+	name = *str;
+
+	if (file->Read(duration, sizeof(double), 1) != 1 || file->Read(ticksPerSecond, sizeof(double), 1) != 1)
+		goto invalid;
+
+	// every channel needs at least a name length and three track types
+	if (file->Read(&numChannels, sizeof(uint32_t), 1) != 1 ||
+		!_al_Fits(file, end, (uint64_t)numChannels * (sizeof(uint32_t) + 3)))
+		goto invalid;
+
+	channels.resize(numChannels);
+	for (uint32_t i = 0; i < numChannels; ++i)
+	{
+		if (file->Read(&num, sizeof(uint32_t), 1) != 1 || !_al_Fits(file, end, num))
+			goto invalid;
+
+		channels[i].name.Resize(num + 1);
+		file->Read(*channels[i].name, sizeof(char), num);
+		channels[i].name[num] = 0x0;
+
+		if (!_al_ReadVectorTrack(file, end, channels[i].positionTrack) ||
+			!_al_ReadQuatTrack(file, end, channels[i].rotationTrack) ||
+			!_al_ReadVectorTrack(file, end, channels[i].scalingTrack))
+			goto invalid;
+	}
+
+	file->Read(idBuff, sizeof(char), 7);
+	idBuff[7] = 0x0;
+
+	if (strncmp(idBuff, NANIM2_FOOTER, 7))
+		Logger::Log(AL_MODULE, LOG_WARNING, "Extra data in AnimationClip file %s", file->GetHeader().name);
+
+	return ENGINE_OK;
+
+invalid:
+	channels.clear();
+	Logger::Log(AL_MODULE, LOG_CRITICAL, "AnimationClip file %s is truncated or has an invalid track", file->GetHeader().name);
+	return ENGINE_INVALID_RES;
+}
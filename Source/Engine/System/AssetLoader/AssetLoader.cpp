@@ -519,101 +519,6 @@ int AssetLoader::_LoadSkeletalMeshV2B(VFSFile *file,
 	return ENGINE_OK;
 }
 
-int AssetLoader::LoadAnimation(NString &file,
-						 std::string &name,
-						 double *duration,
-						 double *ticksPerSecond,
-						 vector<AnimationNode> &channels)
-{
-	char idBuff[8]{ 0x0 };
-	int ret{ ENGINE_FAIL };
-	memset(idBuff, 0x0, 8);
-
-	if (VFSFile *f = VFS::Open(file))
-	{
-		f->Read(idBuff, sizeof(char), 7);
-		idBuff[7] = 0x0;
-
-		if (!strncmp(idBuff, NANIM2_HEADER, 7))
-			ret = _LoadAnimationV2(f, name, duration, ticksPerSecond, channels);
-		else
-		{
-			f->Close();
-			Logger::Log(AL_MODULE, LOG_CRITICAL, "File %s is not a valid animation", *file);
-			return ENGINE_INVALID_HEADER;
-		}
-
-		f->Close();
-
-		return ret;
-	}
-
-	Logger::Log(AL_MODULE, LOG_CRITICAL, "Failed to open AnimationClip file %s", *file);
-	return ENGINE_IO_FAIL;
-}
-
-int AssetLoader::_LoadAnimationV2(VFSFile *file,
-	std::string &name,
-	double *duration,
-	double *ticksPerSecond,
-	std::vector<AnimationNode> &channels)
-{
-	char idBuff[8]{ 0x0 };
-	uint32_t num{ 0 }, numChannels{ 0 }, numKeys{ 0 };
-	NString str{};
-
-	file->Read(&num, sizeof(uint32_t), 1);
-	str.Resize(num + 1);
-	file->Read(*str, sizeof(char), num);
-	str[num] = 0x0;
-	name = *str;
-
-	file->Read(duration, sizeof(double), 1);
-	file->Read(ticksPerSecond, sizeof(double), 1);
-
-	file->Read(&numChannels, sizeof(uint32_t), 1);
-	channels.resize(numChannels);
-	for (uint32_t i = 0; i < numChannels; ++i)
-	{
-		file->Read(&num, sizeof(uint32_t), 1);
-		channels[i].name.Resize(num + 1);
-		file->Read(*channels[i].name, sizeof(char), num);
-		channels[i].name[num] = 0x0;
-
-		file->Read(&numKeys, sizeof(uint32_t), 1);
-		channels[i].positionKeys.resize(numKeys);
-		for (uint32_t j = 0; j < numKeys; ++j)
-		{
-			file->Read(&channels[i].positionKeys[j].value.x, sizeof(double), 3);
-			file->Read(&channels[i].positionKeys[j].time, sizeof(double), 1);
-		}
-
-		file->Read(&numKeys, sizeof(uint32_t), 1);
-		channels[i].rotationKeys.resize(numKeys);
-		for (uint32_t j = 0; j < numKeys; ++j)
-		{
-			file->Read(&channels[i].rotationKeys[j].value.x, sizeof(double), 4);
-			file->Read(&channels[i].rotationKeys[j].time, sizeof(double), 1);
-		}
-
-		file->Read(&numKeys, sizeof(uint32_t), 1);
-		channels[i].scalingKeys.resize(numKeys);
-		for (uint32_t j = 0; j < numKeys; ++j)
-		{
-			file->Read(&channels[i].scalingKeys[j].value.x, sizeof(double), 3);
-			file->Read(&channels[i].scalingKeys[j].time, sizeof(double), 1);
-		}
-	}
-
-	file->Read(idBuff, sizeof(char), 7);
-	idBuff[7] = 0x0;
-
-	if (strncmp(idBuff, NANIM2_FOOTER, 7))
-		Logger::Log(AL_MODULE, LOG_WARNING, "Extra data in AnimationClip file %s", file->GetHeader().name);
-
-	return ENGINE_OK;
-}
-
 int AssetLoader::LoadWAV(NString &file, AudioFormat *format, void **data, size_t *size, size_t *freq)
 {
 	wave_fmt_t wave_fmt{};
@@ -133,6 +133,12 @@ void FMODAudioSource::SetReferenceDistance(float referenceDistance) noexcept
 		Logger::Log(FMOD_ASRC, LOG_WARNING, "Failed to set 3D min/max distance");
 }
 
+void FMODAudioSource::SetRolloffFactor(float rolloff) noexcept
+{
+	// FMOD only has a global rolloff scale, set with FMOD_System_Set3DSettings
+	(void)rolloff;
+}
+
 int FMODAudioSource::SetClip(AudioClip *clip) noexcept
 {
 	if (!clip)
@@ -61,6 +61,7 @@ public:
 
 	virtual void SetMaxDistance(float maxDistance) noexcept override;
 	virtual void SetReferenceDistance(float referenceDistance) noexcept override;
+	virtual void SetRolloffFactor(float rolloff) noexcept override;
 
 	virtual int SetClip(AudioClip *clip) noexcept override;
 
@@ -0,0 +1,103 @@
+/* NekoEngine
+ *
+ * InstanceManager.h
+ * Author: Alexandru Naiman
+ *
+ * Instanced draw data
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include <Renderer/Buffer.h>
+
+#define INST_NO_COMMAND			-1
+
+typedef struct OBJECT_DATA ObjectData;
+
+/**
+ * Owns the buffer the instanced draws read from. It holds one indirect
+ * command per instanceable drawable, recorded once in its command buffer,
+ * followed by the object data of the instances drawn this frame.
+ * Every frame the render queue points the command of the first drawable of
+ * a batch at the object data of the whole batch, so the run is drawn with
+ * a single vkCmdDrawIndexedIndirect.
+ */
+class InstanceManager
+{
+public:
+	static int Initialize();
+
+	static bool IsEnabled() noexcept { return _buffer != nullptr; }
+
+	/**
+	 * Reserve the indirect command of one mesh group.
+	 * Returns its index or INST_NO_COMMAND if full.
+	 */
+	static int32_t AllocateCommand(uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset) noexcept;
+	static void FreeCommand(int32_t command) noexcept;
+
+	static VkBuffer GetBuffer() noexcept { return _buffer->GetHandle(); }
+	static VkDeviceSize GetCommandOffset(int32_t command) noexcept { return _buffer->GetParentOffset() + sizeof(VkDrawIndexedIndirectCommand) * command; }
+	static VkDescriptorSet GetDescriptorSet() noexcept { return _descriptorSet; }
+
+	/** Start a new frame; the instances are written again from the start */
+	static void Reset() noexcept;
+
+	/**
+	 * Make the command draw count instances, copying their ObjectData from data.
+	 * Returns false when there is no room left; the draws must then be
+	 * submitted one by one.
+	 */
+	static bool AddBatch(int32_t command, const void *const *data, uint32_t count) noexcept;
+
+	static void UpdateData(VkCommandBuffer commandBuffer) noexcept;
+
+	static void Release() noexcept;
+
+private:
+	static Buffer *_buffer;
+	static VkDescriptorPool _descriptorPool;
+	static VkDescriptorSet _descriptorSet;
+	static VkDeviceSize _instanceOffset;
+	static std::vector<VkDrawIndexedIndirectCommand> _commands;
+	static std::vector<int32_t> _freeCommands;
+	static ObjectData *_instances;
+	static uint32_t _commandCount, _instanceCount;
+	static uint32_t _dirtyBegin, _dirtyEnd;
+};
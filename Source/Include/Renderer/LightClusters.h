@@ -0,0 +1,125 @@
+/* NekoEngine
+ *
+ * LightClusters.h
+ * Author: Alexandru Naiman
+ *
+ * Clustered light assignment
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+#define LC_DEFAULT_TILES_X		16
+#define LC_DEFAULT_TILES_Y		9
+#define LC_DEFAULT_SLICES		24
+#define LC_MAX_TILES			32
+#define LC_MAX_LIGHTS			65535
+
+struct LIGHT;
+
+/**
+ * Light list of one cluster: the light indices are
+ * indices[offset, offset + count).
+ */
+typedef struct LIGHT_CLUSTER
+{
+	uint32_t offset;
+	uint32_t count;
+} LightCluster;
+
+/**
+ * Bounds of a light in the cluster grid, inclusive. Empty when the light
+ * does not touch the view volume.
+ */
+typedef struct LIGHT_CLUSTER_BOUNDS
+{
+	uint8_t x0, x1, y0, y1, z0, z1;
+	bool visible;
+} LightClusterBounds;
+
+/**
+ * Assigns lights to view space clusters (froxels) on the CPU. The screen is
+ * split in tilesX * tilesY tiles and the depth range in exponentially
+ * spaced slices. Point and spot lights are bounded by their radius
+ * (data.y); directional lights reach every cluster, so they are kept in a
+ * separate global list instead of being repeated everywhere.
+ *
+ * The cluster index is (z * tilesY + y) * tilesX + x, with y = 0 at the
+ * bottom of the screen (NDC -1). Index lists are sorted by light index,
+ * so the output is the same no matter how the work is split.
+ */
+class LightClusters
+{
+public:
+	LightClusters(uint32_t tilesX = LC_DEFAULT_TILES_X, uint32_t tilesY = LC_DEFAULT_TILES_Y, uint32_t slices = LC_DEFAULT_SLICES) noexcept;
+
+	int Build(const glm::mat4 &view, const glm::mat4 &projection, float zNear, float zFar, const struct LIGHT *lights, uint32_t count);
+
+	uint32_t GetTilesX() const noexcept { return _tilesX; }
+	uint32_t GetTilesY() const noexcept { return _tilesY; }
+	uint32_t GetSlices() const noexcept { return _slices; }
+	uint32_t GetClusterCount() const noexcept { return _tilesX * _tilesY * _slices; }
+	uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t z) const noexcept { return (z * _tilesY + y) * _tilesX + x; }
+
+	/** Slice that holds the view space depth (distance along -Z) */
+	uint32_t GetSlice(float depth) const noexcept;
+
+	const LightCluster *GetClusters() const noexcept { return _clusters.data(); }
+	const uint16_t *GetIndices() const noexcept { return _indices.data(); }
+	size_t GetIndexCount() const noexcept { return _indices.size(); }
+	const std::vector<uint16_t> &GetGlobalLights() const noexcept { return _globalLights; }
+	const LightClusterBounds *GetBounds() const noexcept { return _bounds.data(); }
+
+	/** Scalar version of the bounds computation, used as a reference for the SIMD path */
+	void ComputeBoundsReference(const struct LIGHT *lights, uint32_t first, uint32_t last, LightClusterBounds *bounds) const noexcept;
+
+private:
+	uint32_t _tilesX, _tilesY, _slices;
+	float _near, _far, _sliceScale, _sliceBias;
+	glm::mat4 _view;
+	glm::vec4 _planesX[LC_MAX_TILES + 1], _planesY[LC_MAX_TILES + 1];
+
+	std::vector<LightCluster> _clusters;
+	std::vector<uint16_t> _indices;
+	std::vector<uint16_t> _globalLights;
+	std::vector<uint16_t> _visibleLights;
+	std::vector<LightClusterBounds> _bounds;
+
+	void _ComputeBounds(const struct LIGHT *lights, uint32_t first, uint32_t last) noexcept;
+	void _RangeFromMasks(uint32_t colMask, uint32_t rowMask, float depth, float radius, LightClusterBounds &b) const noexcept;
+};
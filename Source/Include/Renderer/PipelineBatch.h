@@ -0,0 +1,106 @@
+/* NekoEngine
+ *
+ * PipelineBatch.h
+ * Author: Alexandru Naiman
+ *
+ * Parallel graphics pipeline creation
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+
+#define PIPELINE_BATCH_MAX_STAGES	5
+
+/**
+ * Collects graphics pipeline create infos and creates them on the task manager's
+ * workers. Add copies everything the create info points to (pNext chains excepted),
+ * so the caller can keep changing its state structures between pipelines.
+ */
+class PipelineBatch
+{
+public:
+	PipelineBatch() { }
+
+	void Add(uint8_t id, const char *name, const VkGraphicsPipelineCreateInfo &info);
+
+	size_t GetCount() const noexcept { return _entries.size(); }
+	uint8_t GetId(size_t i) const noexcept { return _entries[i].id; }
+	const char *GetName(size_t i) const noexcept { return _entries[i].name.c_str(); }
+	const VkGraphicsPipelineCreateInfo &GetCreateInfo(size_t i) const noexcept { return _entries[i].info; }
+
+	/**
+	 * Create every pipeline in the batch and add them to pipelines. If any of
+	 * them fails, the ones that were created are destroyed and nothing is added.
+	 */
+	int Create(VkPipelineCache cache, std::unordered_map<uint8_t, VkPipeline> &pipelines);
+
+	void Clear() { _entries.clear(); }
+
+private:
+	typedef struct PIPELINE_BATCH_ENTRY
+	{
+		uint8_t id;
+		std::string name;
+		VkGraphicsPipelineCreateInfo info;
+		VkPipelineShaderStageCreateInfo stages[PIPELINE_BATCH_MAX_STAGES];
+		VkSpecializationInfo specInfo[PIPELINE_BATCH_MAX_STAGES];
+		std::vector<VkSpecializationMapEntry> specMap[PIPELINE_BATCH_MAX_STAGES];
+		std::vector<uint8_t> specData[PIPELINE_BATCH_MAX_STAGES];
+		VkPipelineVertexInputStateCreateInfo vertexInput;
+		std::vector<VkVertexInputBindingDescription> bindings;
+		std::vector<VkVertexInputAttributeDescription> attributes;
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly;
+		VkPipelineTessellationStateCreateInfo tessellation;
+		VkPipelineViewportStateCreateInfo viewport;
+		std::vector<VkViewport> viewports;
+		std::vector<VkRect2D> scissors;
+		VkPipelineRasterizationStateCreateInfo rasterization;
+		VkPipelineMultisampleStateCreateInfo multisample;
+		std::vector<VkSampleMask> sampleMask;
+		VkPipelineDepthStencilStateCreateInfo depthStencil;
+		VkPipelineColorBlendStateCreateInfo colorBlend;
+		std::vector<VkPipelineColorBlendAttachmentState> attachments;
+		VkPipelineDynamicStateCreateInfo dynamic;
+		std::vector<VkDynamicState> dynamicStates;
+	} PipelineBatchEntry;
+
+	// Entries hold pointers into themselves, so they must not move
+	std::deque<PipelineBatchEntry> _entries;
+};
@@ -0,0 +1,111 @@
+/* NekoEngine
+ *
+ * PipelineCache.h
+ * Author: Alexandru Naiman
+ *
+ * Persistent Vulkan pipeline cache
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#define PIPELINE_CACHE_MAGIC		0x434C504E	// NPLC
+#define PIPELINE_CACHE_VERSION		1
+#define PIPELINE_CACHE_FILE			"NekoEngine.PipelineCache"
+
+/**
+ * Written in front of the driver's cache data. The driver's own header only
+ * identifies the device, so the driver version and a hash of the data are
+ * kept here to reject caches from an updated driver or a truncated write.
+ */
+typedef struct PIPELINE_CACHE_FILE_HEADER
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vendorId;
+	uint32_t deviceId;
+	uint32_t driverVersion;
+	uint8_t uuid[VK_UUID_SIZE];
+	uint32_t padding;
+	uint64_t dataSize;
+	uint64_t dataHash;
+} PipelineCacheFileHeader;
+
+enum PipelineCacheStatus : uint8_t
+{
+	PIPE_CACHE_Valid = 0,
+	PIPE_CACHE_Truncated,
+	PIPE_CACHE_BadMagic,
+	PIPE_CACHE_VersionMismatch,
+	PIPE_CACHE_DeviceMismatch,
+	PIPE_CACHE_DriverMismatch,
+	PIPE_CACHE_Corrupt
+};
+
+class PipelineCache
+{
+public:
+	PipelineCache(const VkPhysicalDeviceProperties &properties);
+
+	/** Create the cache, seeded from the file (if any) when it is valid for this device */
+	bool Load(const char *path);
+	bool Save(const char *path);
+
+	VkPipelineCache GetHandle() const noexcept { return _cache; }
+
+	/** Build the file header for the given cache data */
+	static void FillHeader(PipelineCacheFileHeader &header, const VkPhysicalDeviceProperties &properties, const uint8_t *data, size_t size);
+
+	/**
+	 * Read a cache file and check it against the device; data receives the driver's part
+	 * when the file is valid. Returns false if there is no file to read.
+	 */
+	static bool ReadFile(const char *path, const VkPhysicalDeviceProperties &properties, std::vector<uint8_t> &data, PipelineCacheStatus &status);
+	static bool WriteFile(const char *path, const VkPhysicalDeviceProperties &properties, const uint8_t *data, size_t size);
+
+	/** Check a whole cache file (header and driver data) against the device */
+	static PipelineCacheStatus Validate(const uint8_t *file, size_t size, const VkPhysicalDeviceProperties &properties);
+	static const char *GetStatusString(PipelineCacheStatus status);
+
+	virtual ~PipelineCache();
+
+private:
+	VkPhysicalDeviceProperties _properties;
+	VkPipelineCache _cache;
+
+	bool _Create(const uint8_t *data, size_t size);
+};
@@ -0,0 +1,106 @@
+/* NekoEngine
+ *
+ * PipelineVariants.h
+ * Author: Alexandru Naiman
+ *
+ * Table driven material pipeline variants
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <Renderer/PipelineManager.h>
+
+#define SH_VTX						0
+#define SH_VTX_NM					1
+
+#define SH_VTX_STATIC				"main"
+#define SH_VTX_ANIM					"anim_main"
+
+#define SH_FRAG_UNLIT				0
+#define SH_FRAG_PHONG				1
+#define SH_FRAG_PHONG_SPEC			2
+#define SH_FRAG_PHONG_SPEC_EM		3
+#define SH_FRAG_PHONG_NM			4
+#define SH_FRAG_PHONG_SPEC_NM		5
+#define SH_FRAG_PHONG_SPEC_EM_NM	6
+#define SH_FRAG_WF					0
+
+#define PIPE_VAR_ANIM_OFFSET		10
+#define PIPE_VAR_TRANSPARENT_OFFSET	20
+#define PIPE_VAR_INSTANCED_OFFSET	40
+#define PIPE_VAR_MAX_NAME			64
+
+enum PipelineVariantFlags : uint8_t
+{
+	PIPE_VAR_Animated = 1,
+	PIPE_VAR_Transparent = 2,
+	PIPE_VAR_Instanced = 4
+};
+
+/** One material shader combination; the ids of its variants are derived from the static opaque id */
+typedef struct MATERIAL_PIPELINE_DESC
+{
+	PipelineId id;
+	const char *name;
+	int32_t vertexType;
+	int32_t fragmentType;
+	int32_t numTextures;
+} MaterialPipelineDesc;
+
+typedef struct PIPELINE_VARIANT
+{
+	PipelineId id;
+	PipelineLayoutId layout;
+	uint8_t flags;
+	int32_t vertexType;
+	int32_t fragmentType;
+	int32_t numTextures;
+	char name[PIPE_VAR_MAX_NAME];
+} PipelineVariant;
+
+class PipelineVariants
+{
+public:
+	static const MaterialPipelineDesc *GetMaterialTable(uint32_t &count) noexcept;
+
+	/**
+	 * Expand each description into its static, animated, transparent and instanced variants.
+	 * The static opaque variants come first, in table order, followed by the
+	 * transparent, animated, transparent animated and instanced ones. Only
+	 * static opaque draws are instanced.
+	 */
+	static int Expand(const MaterialPipelineDesc *table, uint32_t count, std::vector<PipelineVariant> &variants);
+};
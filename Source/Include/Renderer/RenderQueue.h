@@ -0,0 +1,124 @@
+/* NekoEngine
+ *
+ * RenderQueue.h
+ * Author: Alexandru Naiman
+ *
+ * Render Queue
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <Renderer/Drawable.h>
+
+/*
+ * Sort key layout, most significant bits first:
+ *
+ * Opaque:      pass (2) | pipeline (8) | material (20) | mesh (20) | depth (14)
+ * Transparent: pass (2) | inverted depth (30) | pipeline (8) | material (12) | mesh (12)
+ *
+ * Opaque draws are grouped by state and drawn front to back inside each
+ * group; transparent draws are drawn strictly back to front. Materials and
+ * meshes are identified by the top bits of a 32 bit hash of their address.
+ */
+#define RQ_PASS_SHIFT			62
+#define RQ_IDENTITY_BITS		20
+#define RQ_DEPTH_BITS			14
+#define RQ_RADIX_BITS			11
+#define RQ_RADIX_BUCKETS		(1 << RQ_RADIX_BITS)
+#define RQ_RADIX_PASSES			((64 + RQ_RADIX_BITS - 1) / RQ_RADIX_BITS)
+
+enum RenderQueuePass : uint8_t
+{
+	RQ_PASS_Opaque = 0,
+	RQ_PASS_Transparent = 1
+};
+
+typedef struct RENDER_QUEUE_ITEM
+{
+	uint64_t key;
+	uint32_t index;
+} RenderQueueItem;
+
+/*
+ * A run of sorted draws [first, first + count) that share pipeline, material,
+ * mesh and group and can all be drawn instanced. Draws that can't be merged
+ * form batches of one.
+ */
+typedef struct RENDER_QUEUE_BATCH
+{
+	uint32_t first;
+	uint32_t count;
+} RenderQueueBatch;
+
+class RenderQueue
+{
+public:
+	RenderQueue() { }
+
+	static uint64_t MakeKey(RenderQueuePass pass, uint8_t pipeline, uint32_t material, uint32_t mesh, float depth) noexcept;
+	static uint32_t HashIdentity(const void *ptr, uint32_t group = 0) noexcept;
+
+	/**
+	 * Stable LSD radix sort on the 64 bit keys. Digits that are the same for
+	 * every key are skipped, so the pass bits cost nothing when all draws
+	 * are opaque. Returns the buffer that holds the result.
+	 */
+	static RenderQueueItem *RadixSort(RenderQueueItem *items, RenderQueueItem *scratch, size_t count) noexcept;
+
+	void Clear() noexcept;
+	void Add(Drawable *drawable, float depth);
+
+	/**
+	 * Sort the queued draws; GetDrawable then returns them in submission order.
+	 * Neighbouring draws with the same state are merged into batches and
+	 * their instance data is packed in the same order.
+	 */
+	void Build();
+
+	size_t GetCount() const noexcept { return _drawables.size(); }
+	Drawable *GetDrawable(size_t i) const noexcept { return _sorted[i]; }
+
+	const std::vector<RenderQueueBatch> &GetBatches() const noexcept { return _batches; }
+	const void *const *GetInstanceData(const RenderQueueBatch &batch) const noexcept { return _instanceData.data() + batch.first; }
+
+private:
+	std::vector<Drawable *> _drawables, _sorted;
+	std::vector<RenderQueueItem> _items, _scratch;
+	std::vector<RenderQueueBatch> _batches;
+	std::vector<const void *> _instanceData;
+};
@@ -0,0 +1,138 @@
+/* NekoEngine
+ *
+ * ShadowCache.h
+ * Author: Alexandru Naiman
+ *
+ * Shadow map caster culling and caching
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include <Runtime/Runtime.h>
+#include <Runtime/NFrustum.h>
+
+#define SHADOW_CACHE_SETTLE_FRAMES	30
+
+class Object;
+
+/** Spatial index query: add the culled casters inside the frustum to casters */
+typedef std::function<void(const NFrustum &frustum, NArray<const Object *> &casters)> ShadowCasterQuery;
+
+typedef struct SHADOW_CACHE_STATS
+{
+	uint32_t facesRendered;
+	uint32_t facesCached;
+	uint32_t castersDrawn;
+	uint32_t queries;
+	uint32_t dynamicCasters;
+} ShadowCacheStats;
+
+/**
+ * Decides which shadow map faces have to be rendered again and with which
+ * casters.
+ *
+ * Casters that have not moved for SHADOW_CACHE_SETTLE_FRAMES frames are
+ * static: each face keeps the static casters found by the spatial index
+ * and only queries it again when its matrix changes or one of its static
+ * casters starts moving. Dynamic casters (moving, animated or not
+ * cullable) are tested against every face each frame.
+ *
+ * A face is rendered when its matrix changed, when one of its casters
+ * moved or when its set of casters changed; otherwise the map from the
+ * last time it was rendered is still valid.
+ */
+class ShadowCache
+{
+public:
+	ShadowCache() : _frame{ 0 }, _stats{} { }
+
+	/** Start a frame; UpdateCaster must then be called for every caster */
+	void BeginFrame() noexcept;
+
+	/**
+	 * Record the state of a caster for this frame. Returns true when the
+	 * caster has just settled, so the spatial index can place it again.
+	 */
+	bool UpdateCaster(const Object *caster, const glm::mat4 &model, const NBounds &bounds, bool animated, bool noCull);
+
+	/** Forget the casters that were not updated this frame */
+	void EndCasterUpdate();
+
+	/**
+	 * Cull the casters of a face and check if it must be rendered. Returns
+	 * false when the cached map is still valid.
+	 */
+	bool UpdateFace(uint32_t mapId, const glm::mat4 &viewProjection, const ShadowCasterQuery &query);
+
+	const std::vector<const Object *> &GetFaceCasters(uint32_t mapId) const noexcept { return _faces[mapId].casters; }
+	void InvalidateFace(uint32_t mapId) noexcept;
+
+	bool IsDynamic(const Object *caster) const noexcept;
+	size_t GetCasterCount() const noexcept { return _casters.size(); }
+	const ShadowCacheStats &GetStats() const noexcept { return _stats; }
+
+	void Clear() noexcept;
+
+private:
+	typedef struct SHADOW_CASTER_RECORD
+	{
+		glm::mat4 model;
+		NBounds bounds;
+		uint64_t lastSeen;
+		uint32_t stillFrames;
+		bool dynamic, moved, noCull;
+	} ShadowCasterRecord;
+
+	typedef struct SHADOW_FACE
+	{
+		glm::mat4 viewProjection;
+		NFrustum frustum;
+		std::vector<const Object *> staticCasters, casters;
+		bool valid{ false }, requery{ false };
+	} ShadowFace;
+
+	uint64_t _frame;
+	ShadowCacheStats _stats;
+	std::unordered_map<const Object *, ShadowCasterRecord> _casters;
+	std::vector<const Object *> _dynamicCasters;
+	std::vector<ShadowFace> _faces;
+	NArray<const Object *> _queryResult;
+	std::vector<const Object *> _faceDynamic, _faceCasters;
+
+	void _Requery(const Object *caster) noexcept;
+};
@@ -0,0 +1,95 @@
+/* NekoEngine
+ *
+ * StagingRing.h
+ * Author: Alexandru Naiman
+ *
+ * Frame partitioned staging ring
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+/**
+ * Bookkeeping for a ring of staging memory shared by all uploads of a frame.
+ * Each frame appends to the ring and may stream at most frameBudget bytes; the space
+ * is returned when the fence of that frame is known to have signaled. Allocations
+ * outside the budget are for data that must arrive whole in the frame, like uniforms.
+ * The ring only deals with offsets, so it can be driven by a simulated fence timeline.
+ */
+class StagingRing
+{
+public:
+	StagingRing(VkDeviceSize size, VkDeviceSize frameBudget);
+
+	/** Start a new partition; frame numbers must increase */
+	void BeginFrame(uint64_t frame);
+
+	/** Returns false if the frame budget or the free space is exhausted; unbudgeted allocations only need free space */
+	bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset, bool budgeted = true);
+
+	/** Return the most recent allocation early, once the GPU is done with it */
+	bool Release(VkDeviceSize offset, VkDeviceSize size);
+
+	/** Largest budgeted allocation that would succeed right now */
+	VkDeviceSize GetAvailable(VkDeviceSize alignment) const;
+
+	/** Free the partitions of every frame up to and including completedFrame */
+	void Reclaim(uint64_t completedFrame);
+
+	VkDeviceSize GetSize() const noexcept { return _size; }
+	VkDeviceSize GetUsed() const noexcept { return _used; }
+	VkDeviceSize GetFrameBudget() const noexcept { return _frameBudget; }
+	/** Budgeted bytes of the current frame */
+	VkDeviceSize GetFrameUsed() const noexcept { return _partitions.size() && _partitions.back().frame == _frame ? _partitions.back().budgeted : 0; }
+	uint64_t GetFrame() const noexcept { return _frame; }
+
+private:
+	typedef struct STAGING_PARTITION
+	{
+		uint64_t frame;
+		VkDeviceSize bytes, budgeted;
+	} StagingPartition;
+
+	std::vector<StagingPartition> _partitions;
+	VkDeviceSize _size, _frameBudget;
+	VkDeviceSize _head, _used;
+	VkDeviceSize _lastOffset, _lastSize, _lastHead, _lastBytes;
+	uint64_t _frame;
+	bool _lastBudgeted;
+
+	bool _Fit(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset, VkDeviceSize &bytes, bool budgeted) const;
+};
@@ -72,6 +72,7 @@ public:
 	}
 
 	static inline VkDevice GetDevice() { return _device; }
+	static inline VkPhysicalDevice GetPhysicalDevice() { return _physicalDevice; }
 	static inline VkAllocationCallbacks *GetAllocator() { return _allocator; }
 	static inline VkCommandPool GetGraphicsCommandPool() { return _graphicsCommandPool; }
 	static inline VkCommandPool GetComputeCommandPool() { return _computeCommandPool; }
@@ -346,7 +347,7 @@ public:
 
 	// Buffers 
 
-	static inline bool CreateBuffer(VkBuffer &buffer, VkDeviceMemory &memory, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VkDeviceSize offset = 0, VkSharingMode sharingMode = VK_SHARING_MODE_EXCLUSIVE)
+	static inline bool CreateUnboundBuffer(VkBuffer &buffer, VkDeviceSize size, VkBufferUsageFlags usage, VkSharingMode sharingMode = VK_SHARING_MODE_EXCLUSIVE)
 	{
 		VkBufferCreateInfo bufferInfo = {};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -357,6 +358,14 @@ public:
 		if (vkCreateBuffer(_device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
 			VKUTIL_ERR("Failed to create buffer");
 
+		return true;
+	}
+
+	static inline bool CreateBuffer(VkBuffer &buffer, VkDeviceMemory &memory, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VkDeviceSize offset = 0, VkSharingMode sharingMode = VK_SHARING_MODE_EXCLUSIVE)
+	{
+		if (!CreateUnboundBuffer(buffer, size, usage, sharingMode))
+			return false;
+
 		if (memory == VK_NULL_HANDLE)
 		{
 			VkMemoryRequirements memReq;
@@ -411,8 +420,7 @@ public:
 
 	// Images
 
-	static inline bool CreateImage(VkImage &image, VkDeviceMemory &memory, int width, int height, int depth,
-		VkMemoryPropertyFlags properties,
+	static inline bool CreateUnboundImage(VkImage &image, int width, int height, int depth,
 		VkFormat format = VK_FORMAT_R8G8B8A8_UNORM,
 		VkImageType type = VK_IMAGE_TYPE_2D,
 		VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT,
@@ -441,6 +449,23 @@ public:
 		if (vkCreateImage(_device, &imgCreateInfo, _allocator, &image) != VK_SUCCESS)
 			VKUTIL_ERR("Failed to create image");
 
+		return true;
+	}
+
+	static inline bool CreateImage(VkImage &image, VkDeviceMemory &memory, int width, int height, int depth,
+		VkMemoryPropertyFlags properties,
+		VkFormat format = VK_FORMAT_R8G8B8A8_UNORM,
+		VkImageType type = VK_IMAGE_TYPE_2D,
+		VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+		VkImageTiling tiling = VK_IMAGE_TILING_LINEAR,
+		uint32_t mipLevels = 1,
+		uint32_t arrayLayers = 1,
+		VkImageCreateFlags createFlags = 0,
+		VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT)
+	{
+		if (!CreateUnboundImage(image, width, height, depth, format, type, usage, tiling, mipLevels, arrayLayers, createFlags, samples))
+			return false;
+
 		VkMemoryRequirements memReq;
 		vkGetImageMemoryRequirements(_device, image, &memReq);
 
@@ -48,4 +48,18 @@ public:
 
 	static int PlayDefaultAnimation(lua_State *state);
 	static int PlayAnimation(lua_State *state);
+
+	static int AddClipNode(lua_State *state);
+	static int AddLerpNode(lua_State *state);
+	static int AddAdditiveNode(lua_State *state);
+	static int AddMaskNode(lua_State *state);
+	static int AddStateMachine(lua_State *state);
+	static int SetGraphRoot(lua_State *state);
+	static int SetParameter(lua_State *state);
+	static int GetParameter(lua_State *state);
+
+	static int AddState(lua_State *state);
+	static int AddTransition(lua_State *state);
+	static int SetState(lua_State *state);
+	static int GetState(lua_State *state);
 };
\ No newline at end of file
@@ -1,9 +1,9 @@
 /* NekoEngine
  *
- * Particle.h
+ * VectorInterface.h
  * Author: Alexandru Naiman
  *
- * CPU mesh particles
+ * Vector and matrix script types
  *
  * -----------------------------------------------------------------------------
  *
@@ -39,19 +39,14 @@
 
 #pragma once
 
-#include <Scene/Particles/Particle.h>
-#include <Scene/Components/StaticMeshComponent.h>
+#include <Script/Script.h>
 
-class MeshParticle : public Particle
+/**
+ * Defines vec2, vec3, vec4, quat and mat4 as FFI types with operators, swizzles,
+ * in-place methods and object pools. Requires the script types to be declared.
+ */
+class VectorInterface
 {
 public:
-	ENGINE_API MeshParticle(ObjectInitializer *initializer);
-
-	ENGINE_API virtual int Load() override;
-
-	ENGINE_API ~MeshParticle();
-
-protected:
-	ComponentInitializer _smcInitializer;
-	StaticMeshComponent *_smc;
-};
\ No newline at end of file
+	static void Register(lua_State *state);
+};
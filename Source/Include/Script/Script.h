@@ -63,4 +63,55 @@ public:
 	static bool LoadScript(lua_State *state, NString &scriptFile);
 	static bool LoadSource(lua_State *state, const char *src);
 	static NString StackDump(lua_State *state);
+
+	/**
+	 * Shared VM of the calling thread, created on first use. Script
+	 * instances live in the VM of the thread that created them and must
+	 * only be called from that thread.
+	 */
+	static lua_State *GetState();
+
+	/**
+	 * Compiled chunk of a script, as a registry reference. Each script is
+	 * compiled once per process and loaded once per VM; the bytecode is
+	 * cached next to the script file. Returns LUA_NOREF on failure.
+	 */
+	static int LoadChunk(lua_State *state, NString &scriptFile);
+	static int LoadSourceChunk(lua_State *state, const char *name, const char *src);
+
+	/**
+	 * Hash of a script's source, used to name scripts that have no file
+	 */
+	static uint64_t HashSource(const char *src, size_t size);
+
+	/**
+	 * Compile a script file again and replace its chunk in the VM. Returns
+	 * the new chunk or LUA_NOREF, in which case the old chunk is kept.
+	 */
+	static int ReloadChunk(lua_State *state, NString &scriptFile);
+
+	/**
+	 * Run a chunk in a new environment table whose globals fall back to the
+	 * VM's globals. Returns a registry reference to the environment or
+	 * LUA_NOREF if the chunk failed.
+	 */
+	static int NewInstance(lua_State *state, int chunk, void *parent);
+
+	/**
+	 * Run a new version of a chunk in an existing instance. Functions are
+	 * replaced; the other values the instance holds are kept.
+	 */
+	static bool ReloadInstance(lua_State *state, int chunk, int instance);
+
+	/**
+	 * Registry reference to a function defined by an instance, or LUA_NOREF
+	 */
+	static int GetFunction(lua_State *state, int instance, const char *name);
+
+	/**
+	 * Release a reference; does nothing once the VM is closed
+	 */
+	static void Unref(lua_State *state, int ref);
+
+	static void Release();
 };
@@ -0,0 +1,100 @@
+/* NekoEngine
+ *
+ * ScriptScheduler.h
+ * Author: Alexandru Naiman
+ *
+ * Script execution budgets, coroutines and garbage collection
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <Script/Script.h>
+
+/**
+ * Script activity of one frame, per script
+ */
+struct ScriptStats
+{
+	double time;
+	size_t allocated;
+	uint32_t calls;
+	uint32_t aborts;
+};
+
+/**
+ * Runs script functions and coroutines of the main thread's shared VM.
+ * The garbage collector only runs in Update, for at most the configured
+ * budget, and calls that exceed the instruction budget are aborted.
+ */
+class ScriptScheduler
+{
+public:
+	/**
+	 * Register the coroutine functions and apply the budgets to a VM
+	 */
+	static void Register(lua_State *state);
+
+	/**
+	 * Identifier the statistics of a script are kept under
+	 */
+	static int RegisterScript(const char *name);
+
+	/**
+	 * lua_pcall with accounting. The owner is recorded for coroutines
+	 * started by the call.
+	 */
+	static int Call(lua_State *state, int nargs, int nresults, int script, void *owner);
+
+	/**
+	 * True if the last Call was stopped by the instruction budget
+	 */
+	static bool Aborted() noexcept;
+
+	/**
+	 * Resume the coroutines that are due, run a garbage collection step
+	 * and report the frame's statistics.
+	 */
+	static void Update(double deltaTime);
+
+	/**
+	 * Stop the coroutines started on behalf of an owner
+	 */
+	static void Cancel(void *owner);
+
+	static size_t GetCoroutineCount() noexcept;
+	static const ScriptStats *GetFrameStats(const char *name);
+	static double GetGCTime() noexcept;
+
+	static void Release();
+};
@@ -37,51 +37,284 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+
+#include <System/Logger.h>
+
 #include "NullAudio.h"
 
+#define NA_MODULE				"NullAudio"
+#define NA_OFFLINE_BLOCK_DIV	60
+
+using namespace std;
 using namespace glm;
 
-NullAudioBuffer::NullAudioBuffer(size_t size) : AudioBuffer(size) { }
-void NullAudioBuffer::SetData(AudioFormat format, size_t frequency, size_t size, void *data) { (void)format; (void)frequency, (void)size, (void)data; }
-NullAudioBuffer::~NullAudioBuffer() { }
-
-NullAudioSource::NullAudioSource() noexcept { }
-void NullAudioSource::SetPitch(float p) noexcept { (void)p; }
-void NullAudioSource::SetGain(float g) noexcept { (void)g; }
-void NullAudioSource::SetConeInnerAngle(float a) noexcept { (void)a; }
-void NullAudioSource::SetConeOuterAngle(float a) noexcept { (void)a; }
-void NullAudioSource::SetConeOuterGain(float g) noexcept { (void)g; }
-void NullAudioSource::SetDirection(vec3 &dir) noexcept { (void)dir; }
-void NullAudioSource::SetPosition(vec3 &pos) noexcept { (void)pos; }
-void NullAudioSource::SetVelocity(vec3 &v) noexcept { (void)v; }
-void NullAudioSource::SetLooping(bool looping) noexcept { (void)looping; }
-void NullAudioSource::SetMaxDistance(float maxDistance) noexcept { (void)maxDistance; }
-void NullAudioSource::SetReferenceDistance(float referenceDistance) noexcept { (void)referenceDistance; }
-int NullAudioSource::SetClip(AudioClip *clip) noexcept { (void)clip; return ENGINE_OK; }
-bool NullAudioSource::Play() noexcept { return true; }
-void NullAudioSource::Pause() noexcept { }
-void NullAudioSource::Stop() noexcept { }
-void NullAudioSource::Rewind() noexcept { }
-bool NullAudioSource::IsPlaying() noexcept { return false; }
-NullAudioSource::~NullAudioSource() { }
-
-int NullAudio::Initialize() { return ENGINE_OK; }
+NullAudio::NullAudio() :
+	_nextSourceId(0),
+	_distanceModel(AudioDistanceModel::LinearClamped),
+	_listenerPosition(0.f), _listenerVelocity(0.f),
+	_listenerFront(0.f, 0.f, -1.f), _listenerUp(0.f, 1.f, 0.f),
+	_mixRate(48000), _maxVoices(32),
+	_realVoices(0), _virtualVoices(0),
+	_offline(false), _captureFull(false),
+	_pendingFrames(0.0)
+{
+}
+
+int NullAudio::Initialize()
+{
+	AudioConfig &cfg{ Engine::GetConfiguration().Audio };
+
+	if (cfg.MixRate > 0)
+		_mixRate = (uint32_t)cfg.MixRate;
+
+	if (cfg.MaxVoices > 0)
+		_maxVoices = (uint32_t)cfg.MaxVoices;
+
+	_offline = cfg.OfflineRender;
+
+	if (cfg.OutputFile[0] && !_wav.Open(cfg.OutputFile, _mixRate))
+		Logger::Log(NA_MODULE, LOG_WARNING, "Failed to open output file %s", cfg.OutputFile);
+
+	Logger::Log(NA_MODULE, LOG_INFORMATION, "Initialized: %d Hz, %d voices%s", _mixRate, _maxVoices, _offline ? ", offline" : "");
+
+	return ENGINE_OK;
+}
+
 const char *NullAudio::GetName() { return "NullAudio"; }
-const char *NullAudio::GetVersion() { return "0.4.0.1"; }
+const char *NullAudio::GetVersion() { return NULL_AUDIO_VERSION_STRING; }
 AudioBuffer *NullAudio::CreateBuffer(size_t size) { return (AudioBuffer *)new NullAudioBuffer(size); }
-AudioSource *NullAudio::CreateSource() { return (AudioSource *)new NullAudioSource(); }
-void NullAudio::SetDistanceModel(AudioDistanceModel model) { (void)model; }
-void NullAudio::SetListenerPosition(glm::vec3 &position) { (void)position; }
-void NullAudio::SetListenerVelocity(glm::vec3 &velocity) { (void)velocity; }
-void NullAudio::SetListenerOrientation(glm::vec3 &front, glm::vec3 &up) { (void)front; (void)up; }
-void NullAudio::Update(double deltaTime) { (void)deltaTime; }
-void NullAudio::Release() { }
+
+AudioSource *NullAudio::CreateSource()
+{
+	lock_guard<mutex> lock(_sourceMutex);
+
+	NullAudioSource *src{ new NullAudioSource(this, _nextSourceId++) };
+	_sources.push_back(src);
+
+	return (AudioSource *)src;
+}
+
+void NullAudio::SetDistanceModel(AudioDistanceModel model) { _distanceModel = model; }
+void NullAudio::SetListenerPosition(vec3 &position) { _listenerPosition = position; }
+void NullAudio::SetListenerVelocity(vec3 &velocity) { _listenerVelocity = velocity; }
+void NullAudio::SetListenerOrientation(vec3 &front, vec3 &up) { _listenerFront = front; _listenerUp = up; }
+
+void NullAudio::Update(double deltaTime)
+{
+	if (_offline)
+	{
+		// Fixed block size so the output does not depend on the frame time
+		Render(_mixRate / NA_OFFLINE_BLOCK_DIV);
+		return;
+	}
+
+	_pendingFrames += deltaTime * _mixRate;
+
+	if (_pendingFrames > _mixRate)
+		_pendingFrames = _mixRate;
+
+	uint32_t frames{ (uint32_t)_pendingFrames };
+	_pendingFrames -= frames;
+
+	if (frames)
+		Render(frames);
+}
+
+void NullAudio::Render(uint32_t frames)
+{
+	lock_guard<mutex> lock(_sourceMutex);
+
+	for (int i = 0; i < NA_OUT_CHANNELS; ++i)
+	{
+		_mix[i].assign(frames, 0.f);
+		_voice[i].resize(frames);
+	}
+
+	_mixList.clear();
+	for (NullAudioSource *src : _sources)
+	{
+		if (src->_state != NullAudioSourceState::Playing || !src->_cursor.frameCount)
+			continue;
+
+		_Spatialize(src);
+		_mixList.push_back(src);
+	}
+
+	// Highest priority first, then loudest; the id keeps the order stable between runs
+	sort(_mixList.begin(), _mixList.end(), [](const NullAudioSource *a, const NullAudioSource *b) -> bool {
+		if (a->_priority != b->_priority)
+			return a->_priority > b->_priority;
+		if (a->_audibility != b->_audibility)
+			return a->_audibility > b->_audibility;
+		return a->_id < b->_id;
+	});
+
+	_realVoices = _virtualVoices = 0;
+
+	for (NullAudioSource *src : _mixList)
+	{
+		NullAudioBuffer *buffer{ (NullAudioBuffer *)src->_clip->GetBuffer() };
+		double ratio{ (double)buffer->GetFrequency() / (double)_mixRate * (double)glm::max(src->_pitch, .01f) };
+
+		src->_cursor.step = (uint64_t)(ratio * (double)NA_FRAC_ONE);
+		src->_cursor.loop = src->_looping;
+
+		if (_realVoices == _maxVoices || src->_audibility <= 0.f)
+		{
+			// Virtual voices keep their position so they resume in sync when they become audible
+			src->_virtual = true;
+			src->_lastGain[0] = src->_lastGain[1] = 0.f;
+
+			if (!NA_Advance(src->_cursor, frames))
+			{
+				src->_state = NullAudioSourceState::Stopped;
+				src->_cursor.position = 0;
+			}
+
+			++_virtualVoices;
+			continue;
+		}
+
+		uint32_t rendered{ NA_Resample(src->_cursor, _voice[0].data(), _voice[1].data(), frames) };
+		const float *right{ src->_cursor.channels == 2 ? _voice[1].data() : _voice[0].data() };
+
+		for (int i = 0; i < NA_OUT_CHANNELS; ++i)
+		{
+			float step{ (src->_targetGain[i] - src->_lastGain[i]) / (float)frames };
+			NA_MixRamp(_mix[i].data(), i ? right : _voice[0].data(), rendered, src->_lastGain[i], step);
+			src->_lastGain[i] = src->_targetGain[i];
+		}
+
+		src->_virtual = false;
+
+		if (rendered < frames)
+		{
+			src->_state = NullAudioSourceState::Stopped;
+			src->_cursor.position = 0;
+		}
+
+		++_realVoices;
+	}
+
+	size_t offset{ 0 };
+	if (_offline && !_wav.IsOpen())
+	{
+		if (_output.size() / NA_OUT_CHANNELS + frames > (size_t)_mixRate * NA_MAX_CAPTURE_SECONDS)
+		{
+			if (!_captureFull)
+				Logger::Log(NA_MODULE, LOG_WARNING, "Offline capture limit of %d seconds reached, further output is discarded", NA_MAX_CAPTURE_SECONDS);
+			_captureFull = true;
+			return;
+		}
+
+		offset = _output.size();
+	}
+
+	_output.resize(offset + (size_t)frames * NA_OUT_CHANNELS);
+	NA_ConvertS16(_output.data() + offset, _mix[0].data(), _mix[1].data(), frames);
+
+	if (_wav.IsOpen())
+		_wav.Write(_output.data(), frames);
+}
+
+void NullAudio::Release()
+{
+	_wav.Close();
+
+	lock_guard<mutex> lock(_sourceMutex);
+
+	for (NullAudioSource *src : _sources)
+		src->_system = nullptr;
+	_sources.clear();
+}
+
 NullAudio::~NullAudio() { }
 
+void NullAudio::_RemoveSource(NullAudioSource *src)
+{
+	lock_guard<mutex> lock(_sourceMutex);
+	_sources.erase(remove(_sources.begin(), _sources.end(), src), _sources.end());
+}
+
+void NullAudio::_Spatialize(NullAudioSource *src)
+{
+	float gain{ src->_gain };
+
+	// Stereo clips are not positioned, same as OpenAL
+	if (src->_cursor.channels == 2)
+	{
+		src->_targetGain[0] = src->_targetGain[1] = gain;
+		src->_audibility = gain;
+		return;
+	}
+
+	vec3 toSource{ src->_position - _listenerPosition };
+	float distance{ length(toSource) };
+
+	gain *= _DistanceGain(src, distance);
+
+	if (src->_coneInner < 360.f && length(src->_direction) > 0.f && distance > 0.f)
+	{
+		float angle{ degrees(acos(glm::clamp(dot(normalize(src->_direction), -toSource / distance), -1.f, 1.f))) * 2.f };
+
+		if (angle >= src->_coneOuter)
+			gain *= src->_coneOuterGain;
+		else if (angle > src->_coneInner)
+			gain *= mix(1.f, src->_coneOuterGain, (angle - src->_coneInner) / (src->_coneOuter - src->_coneInner));
+	}
+
+	float pan{ 0.f };
+	vec3 right{ cross(_listenerFront, _listenerUp) };
+	if (distance > 0.f && length(right) > 0.f)
+		pan = glm::clamp(dot(toSource / distance, normalize(right)), -1.f, 1.f);
+
+	// Equal power panning
+	float theta{ (pan + 1.f) * quarter_pi<float>() };
+	src->_targetGain[0] = gain * cos(theta);
+	src->_targetGain[1] = gain * sin(theta);
+	src->_audibility = gain;
+}
+
+float NullAudio::_DistanceGain(const NullAudioSource *src, float distance) const
+{
+	float ref{ src->_referenceDistance }, max{ src->_maxDistance }, rolloff{ src->_rolloff };
+	float gain{ 1.f };
+
+	switch (_distanceModel)
+	{
+		case AudioDistanceModel::InverseClamped:
+		case AudioDistanceModel::LinearClamped:
+		case AudioDistanceModel::ExponentClamped:
+			distance = glm::clamp(distance, ref, glm::max(ref, max));
+		break;
+		default:
+		break;
+	}
+
+	switch (_distanceModel)
+	{
+		case AudioDistanceModel::Inverse:
+		case AudioDistanceModel::InverseClamped:
+			gain = (ref + rolloff * (distance - ref)) > 0.f ? ref / (ref + rolloff * (distance - ref)) : 1.f;
+		break;
+		case AudioDistanceModel::Linear:
+		case AudioDistanceModel::LinearClamped:
+			gain = max > ref ? 1.f - rolloff * (distance - ref) / (max - ref) : 1.f;
+		break;
+		case AudioDistanceModel::Exponent:
+		case AudioDistanceModel::ExponentClamped:
+			gain = (distance > 0.f && ref > 0.f) ? pow(distance / ref, -rolloff) : 1.f;
+		break;
+	}
+
+	return glm::clamp(gain, 0.f, 1.f);
+}
+
 #if defined(_WIN32) || defined(_WIN64)
 	#define EXPORT __declspec(dllexport)
 #else
 	#define EXPORT
 #endif
 
-extern "C" EXPORT AudioSystem *createAudioSystem() { return (AudioSystem *)new NullAudio(); }
\ No newline at end of file
+extern "C" EXPORT AudioSystem *createAudioSystem() { return (AudioSystem *)new NullAudio(); }
@@ -40,29 +40,55 @@
 #pragma once
 
 #define	NULL_AUDIO_VERSION_MAJOR		0
-#define NULL_AUDIO_VERSION_MINOR		4
+#define NULL_AUDIO_VERSION_MINOR		5
 #define NULL_AUDIO_VERSION_REVISION		0
-#define NULL_AUDIO_VERSION_BUILD		1
+#define NULL_AUDIO_VERSION_BUILD		0
 #define NULL_AUDIO_VERSION_PATCH		0
 
-#define NULL_AUDIO_VERSION_STRING		"0.4.0.1"
+#define NULL_AUDIO_VERSION_STRING		"0.5.0.0"
 
 #ifndef RC_INVOKED
 
+#include <mutex>
+#include <vector>
+
 #include <Audio/AudioSystem.h>
 
+#include "NullAudioMixer.h"
+
+#define NA_MAX_CAPTURE_SECONDS	600
+
 class NullAudioBuffer : public AudioBuffer
 {
 public:
 	NullAudioBuffer(size_t size);
 	virtual void SetData(AudioFormat format, size_t frequency, size_t size, void *data);
+
+	const float *GetSamples() const { return _samples.data(); }
+	uint32_t GetChannels() const { return _channels; }
+	uint32_t GetFrameCount() const { return _frameCount; }
+	uint32_t GetFrequency() const { return _frequency; }
+
 	virtual ~NullAudioBuffer();
+
+private:
+	std::vector<float> _samples;
+	uint32_t _channels;
+	uint32_t _frameCount;
+	uint32_t _frequency;
+};
+
+enum class NullAudioSourceState : uint8_t
+{
+	Stopped,
+	Playing,
+	Paused
 };
 
 class NullAudioSource : public AudioSource
 {
 public:
-	NullAudioSource() noexcept;
+	NullAudioSource(class NullAudio *system, uint32_t id) noexcept;
 	virtual void SetPitch(float p) noexcept override;
 	virtual void SetGain(float g) noexcept override;
 	virtual void SetConeInnerAngle(float a) noexcept override;
@@ -74,6 +100,7 @@ public:
 	virtual void SetLooping(bool looping) noexcept override;
 	virtual void SetMaxDistance(float maxDistance) noexcept override;
 	virtual void SetReferenceDistance(float referenceDistance) noexcept override;
+	virtual void SetRolloffFactor(float rolloff) noexcept override;
 	virtual int SetClip(AudioClip *clip) noexcept override;
 	virtual bool Play() noexcept override;
 	virtual void Pause() noexcept override;
@@ -81,11 +108,34 @@ public:
 	virtual void Rewind() noexcept override;
 	virtual bool IsPlaying() noexcept override;
 	virtual ~NullAudioSource();
+
+private:
+	friend class NullAudio;
+
+	class NullAudio *_system;
+	uint32_t _id;
+	NullAudioSourceState _state;
+
+	float _pitch, _gain;
+	float _coneInner, _coneOuter, _coneOuterGain;
+	float _maxDistance, _referenceDistance, _rolloff;
+	bool _looping;
+	glm::vec3 _position, _direction, _velocity;
+
+	NAResampleState _cursor;
+
+	// Mixer state, owned by NullAudio::Render
+	float _audibility;
+	float _targetGain[NA_OUT_CHANNELS];
+	float _lastGain[NA_OUT_CHANNELS];
+	bool _virtual;
 };
 
 class NullAudio : public AudioSystem
 {
 public:
+	NullAudio();
+
 	virtual int Initialize() override;
 	virtual const char *GetName() override;
 	virtual const char *GetVersion() override;
@@ -97,7 +147,49 @@ public:
 	virtual void SetListenerOrientation(glm::vec3 &front, glm::vec3 &up) override;
 	virtual void Update(double deltaTime) override;
 	virtual void Release() override;
+
+	/**
+	 * Mix frames frames of output. Called by Update; can be called directly for offline rendering.
+	 */
+	void Render(uint32_t frames);
+
+	uint32_t GetMixRate() const { return _mixRate; }
+	uint32_t GetRealVoiceCount() const { return _realVoices; }
+	uint32_t GetVirtualVoiceCount() const { return _virtualVoices; }
+
+	/**
+	 * Interleaved 16 bit stereo output. In offline mode without an output file this
+	 * holds everything rendered since initialization, up to NA_MAX_CAPTURE_SECONDS;
+	 * otherwise only the last block.
+	 */
+	const std::vector<int16_t> &GetOutput() const { return _output; }
+
 	virtual ~NullAudio();
+
+private:
+	friend class NullAudioSource;
+
+	std::mutex _sourceMutex;
+	std::vector<NullAudioSource *> _sources;
+	std::vector<NullAudioSource *> _mixList;
+	uint32_t _nextSourceId;
+
+	AudioDistanceModel _distanceModel;
+	glm::vec3 _listenerPosition, _listenerVelocity, _listenerFront, _listenerUp;
+
+	uint32_t _mixRate, _maxVoices;
+	uint32_t _realVoices, _virtualVoices;
+	bool _offline, _captureFull;
+	double _pendingFrames;
+
+	std::vector<float> _mix[NA_OUT_CHANNELS];
+	std::vector<float> _voice[NA_OUT_CHANNELS];
+	std::vector<int16_t> _output;
+	NAWavWriter _wav;
+
+	void _RemoveSource(NullAudioSource *src);
+	void _Spatialize(NullAudioSource *src);
+	float _DistanceGain(const NullAudioSource *src, float distance) const;
 };
 
 #endif
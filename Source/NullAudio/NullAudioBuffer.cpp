@@ -0,0 +1,75 @@
+/* NekoEngine
+ *
+ * NullAudioBuffer.cpp
+ * Author: Alexandru Naiman
+ *
+ * NekoEngine NullAudio System
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NullAudio.h"
+
+NullAudioBuffer::NullAudioBuffer(size_t size) :
+	AudioBuffer(size),
+	_samples{},
+	_channels{ 1 },
+	_frameCount{ 0 },
+	_frequency{ 0 }
+{ }
+
+void NullAudioBuffer::SetData(AudioFormat format, size_t frequency, size_t size, void *data)
+{
+	bool is16Bit{ format == AudioFormat::Mono_16Bit || format == AudioFormat::Stereo_16Bit };
+
+	_channels = (format == AudioFormat::Stereo_8Bit || format == AudioFormat::Stereo_16Bit) ? 2 : 1;
+	_frequency = (uint32_t)frequency;
+	_frameCount = (uint32_t)(size / ((is16Bit ? 2 : 1) * _channels));
+
+	// Samples are converted to float once so the mixer only deals with one format
+	_samples.resize((size_t)_frameCount * _channels);
+
+	if (is16Bit)
+	{
+		const int16_t *src{ (const int16_t *)data };
+		for (size_t i = 0; i < _samples.size(); ++i)
+			_samples[i] = (float)src[i] * (1.f / 32768.f);
+	}
+	else
+	{
+		const uint8_t *src{ (const uint8_t *)data };
+		for (size_t i = 0; i < _samples.size(); ++i)
+			_samples[i] = ((float)src[i] - 128.f) * (1.f / 128.f);
+	}
+}
+
+NullAudioBuffer::~NullAudioBuffer() { }
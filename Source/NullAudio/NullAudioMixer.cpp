@@ -0,0 +1,275 @@
+/* NekoEngine
+ *
+ * NullAudioMixer.cpp
+ * Author: Alexandru Naiman
+ *
+ * NekoEngine NullAudio System
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "NullAudioMixer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define NA_SSE
+	#include <emmintrin.h>
+#endif
+
+#define NA_FRAC_TO_FLOAT(x)		((float)(int32_t)(((x) & NA_FRAC_MASK) >> 8) * (1.f / (float)(1 << 24)))
+
+#ifdef NA_SSE
+static inline uint32_t _NA_ResampleSSE(NAResampleState &state, float *left, float *right, uint32_t frames)
+{
+	const uint32_t ch{ state.channels };
+	const float *s{ state.samples };
+	const __m128 fracScale{ _mm_set1_ps(1.f / (float)(1 << 24)) };
+	uint32_t i{ 0 };
+
+	while (i + 4 <= frames)
+	{
+		// All four frames and their right neighbours must lie inside the buffer
+		if (((state.position + state.step * 3) >> NA_FRAC_BITS) + 1 >= state.frameCount)
+			break;
+
+		uint32_t idx[4];
+		int32_t frac[4];
+		for (int k = 0; k < 4; ++k)
+		{
+			idx[k] = (uint32_t)(state.position >> NA_FRAC_BITS) * ch;
+			frac[k] = (int32_t)((state.position & NA_FRAC_MASK) >> 8);
+			state.position += state.step;
+		}
+
+		__m128 t{ _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)frac)), fracScale) };
+
+		__m128 a{ _mm_set_ps(s[idx[3]], s[idx[2]], s[idx[1]], s[idx[0]]) };
+		__m128 b{ _mm_set_ps(s[idx[3] + ch], s[idx[2] + ch], s[idx[1] + ch], s[idx[0] + ch]) };
+		_mm_storeu_ps(left + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t)));
+
+		if (ch == 2)
+		{
+			a = _mm_set_ps(s[idx[3] + 1], s[idx[2] + 1], s[idx[1] + 1], s[idx[0] + 1]);
+			b = _mm_set_ps(s[idx[3] + 3], s[idx[2] + 3], s[idx[1] + 3], s[idx[0] + 3]);
+			_mm_storeu_ps(right + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t)));
+		}
+
+		i += 4;
+	}
+
+	return i;
+}
+#endif
+
+uint32_t NA_Resample(NAResampleState &state, float *left, float *right, uint32_t frames)
+{
+	const uint32_t ch{ state.channels };
+	const float *s{ state.samples };
+	const uint64_t end{ (uint64_t)state.frameCount << NA_FRAC_BITS };
+	uint32_t i{ 0 };
+
+	if (!state.frameCount || !s)
+		return 0;
+
+	while (i < frames)
+	{
+#ifdef NA_SSE
+		i += _NA_ResampleSSE(state, left + i, right + i, frames - i);
+		if (i == frames)
+			break;
+#endif
+
+		if (state.position >= end)
+		{
+			if (!state.loop)
+				break;
+			state.position %= end;
+		}
+
+		uint32_t f{ (uint32_t)(state.position >> NA_FRAC_BITS) };
+		uint32_t n{ f + 1 < state.frameCount ? f + 1 : (state.loop ? 0 : f) };
+		float t{ NA_FRAC_TO_FLOAT(state.position) };
+
+		left[i] = s[f * ch] + (s[n * ch] - s[f * ch]) * t;
+		if (ch == 2)
+			right[i] = s[f * ch + 1] + (s[n * ch + 1] - s[f * ch + 1]) * t;
+
+		state.position += state.step;
+		++i;
+	}
+
+	return i;
+}
+
+bool NA_Advance(NAResampleState &state, uint32_t frames)
+{
+	const uint64_t end{ (uint64_t)state.frameCount << NA_FRAC_BITS };
+
+	if (!end)
+		return false;
+
+	state.position += state.step * frames;
+
+	if (state.position < end)
+		return true;
+
+	if (!state.loop)
+	{
+		state.position = end;
+		return false;
+	}
+
+	state.position %= end;
+	return true;
+}
+
+void NA_MixRamp(float *out, const float *in, uint32_t frames, float gain, float gainStep)
+{
+	uint32_t i{ 0 };
+
+#ifdef NA_SSE
+	__m128 g{ _mm_set_ps(gain + gainStep * 3.f, gain + gainStep * 2.f, gain + gainStep, gain) };
+	const __m128 gs{ _mm_set1_ps(gainStep * 4.f) };
+
+	for (; i + 4 <= frames; i += 4)
+	{
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), g)));
+		g = _mm_add_ps(g, gs);
+	}
+#endif
+
+	for (; i < frames; ++i)
+		out[i] += in[i] * (gain + gainStep * (float)i);
+}
+
+void NA_ConvertS16(int16_t *out, const float *left, const float *right, uint32_t frames)
+{
+	uint32_t i{ 0 };
+
+#ifdef NA_SSE
+	const __m128 one{ _mm_set1_ps(1.f) }, minusOne{ _mm_set1_ps(-1.f) }, scale{ _mm_set1_ps(32767.f) };
+
+	for (; i + 4 <= frames; i += 4)
+	{
+		__m128 l{ _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(left + i), one), minusOne), scale) };
+		__m128 r{ _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(right + i), one), minusOne), scale) };
+
+		__m128i li{ _mm_cvtps_epi32(l) }, ri{ _mm_cvtps_epi32(r) };
+		__m128i packed{ _mm_packs_epi32(_mm_unpacklo_epi32(li, ri), _mm_unpackhi_epi32(li, ri)) };
+
+		_mm_storeu_si128((__m128i *)(out + i * 2), packed);
+	}
+#endif
+
+	for (; i < frames; ++i)
+	{
+		float l{ left[i] < -1.f ? -1.f : (left[i] > 1.f ? 1.f : left[i]) };
+		float r{ right[i] < -1.f ? -1.f : (right[i] > 1.f ? 1.f : right[i]) };
+
+		out[i * 2] = (int16_t)lrintf(l * 32767.f);
+		out[i * 2 + 1] = (int16_t)lrintf(r * 32767.f);
+	}
+}
+
+static inline void _NA_Put16(uint8_t *p, uint16_t v) { p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; }
+static inline void _NA_Put32(uint8_t *p, uint32_t v) { _NA_Put16(p, v & 0xFFFF); _NA_Put16(p + 2, v >> 16); }
+
+bool NAWavWriter::Open(const char *file, uint32_t rate)
+{
+	Close();
+
+	if ((_fp = fopen(file, "wb")) == nullptr)
+		return false;
+
+	_rate = rate;
+	_dataSize = 0;
+	_WriteHeader();
+
+	return true;
+}
+
+void NAWavWriter::Write(const int16_t *frames, uint32_t count)
+{
+	if (!_fp)
+		return;
+
+	uint8_t buff[4096];
+	uint32_t done{ 0 };
+
+	// Write little endian regardless of the host
+	while (done < count)
+	{
+		uint32_t n{ 0 };
+		for (; n < sizeof(buff) / 4 && done < count; ++n, ++done)
+		{
+			_NA_Put16(buff + n * 4, (uint16_t)frames[done * 2]);
+			_NA_Put16(buff + n * 4 + 2, (uint16_t)frames[done * 2 + 1]);
+		}
+		fwrite(buff, 4, n, _fp);
+	}
+
+	_dataSize += count * 4;
+}
+
+void NAWavWriter::Close()
+{
+	if (!_fp)
+		return;
+
+	fseek(_fp, 0, SEEK_SET);
+	_WriteHeader();
+
+	fclose(_fp);
+	_fp = nullptr;
+}
+
+void NAWavWriter::_WriteHeader()
+{
+	uint8_t hdr[44];
+
+	memcpy(hdr, "RIFF", 4);
+	_NA_Put32(hdr + 4, 36 + _dataSize);
+	memcpy(hdr + 8, "WAVEfmt ", 8);
+	_NA_Put32(hdr + 16, 16);
+	_NA_Put16(hdr + 20, 1);
+	_NA_Put16(hdr + 22, NA_OUT_CHANNELS);
+	_NA_Put32(hdr + 24, _rate);
+	_NA_Put32(hdr + 28, _rate * NA_OUT_CHANNELS * 2);
+	_NA_Put16(hdr + 32, NA_OUT_CHANNELS * 2);
+	_NA_Put16(hdr + 34, 16);
+	memcpy(hdr + 36, "data", 4);
+	_NA_Put32(hdr + 40, _dataSize);
+
+	fwrite(hdr, sizeof(hdr), 1, _fp);
+}
@@ -0,0 +1,106 @@
+/* NekoEngine
+ *
+ * NullAudioMixer.h
+ * Author: Alexandru Naiman
+ *
+ * NekoEngine NullAudio System
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Source cursor is 32.32 fixed point so the resampler is deterministic
+#define NA_FRAC_BITS		32
+#define NA_FRAC_ONE			((uint64_t)1 << NA_FRAC_BITS)
+#define NA_FRAC_MASK		(NA_FRAC_ONE - 1)
+
+#define NA_OUT_CHANNELS		2
+
+struct NAResampleState
+{
+	const float *samples;	// interleaved source samples
+	uint32_t channels;		// 1 or 2
+	uint32_t frameCount;
+	uint64_t position;		// 32.32 fixed point
+	uint64_t step;			// 32.32 fixed point
+	bool loop;
+};
+
+/**
+ * Resample up to frames frames from the source into the planar left/right buffers
+ * using linear interpolation. Mono sources are written to left only.
+ * Returns the number of frames written; less than frames when a non-looping
+ * source reaches the end.
+ */
+uint32_t NA_Resample(NAResampleState &state, float *left, float *right, uint32_t frames);
+
+/**
+ * Advance the cursor as if frames frames had been rendered. Used for virtual voices.
+ * Returns false if a non-looping source reached the end.
+ */
+bool NA_Advance(NAResampleState &state, uint32_t frames);
+
+/**
+ * out[i] += in[i] * (gain + i * gainStep)
+ */
+void NA_MixRamp(float *out, const float *in, uint32_t frames, float gain, float gainStep);
+
+/**
+ * Convert planar float to interleaved 16 bit stereo, clamping to [-1, 1]
+ */
+void NA_ConvertS16(int16_t *out, const float *left, const float *right, uint32_t frames);
+
+class NAWavWriter
+{
+public:
+	NAWavWriter() : _fp(nullptr), _dataSize(0), _rate(0) { }
+
+	bool Open(const char *file, uint32_t rate);
+	void Write(const int16_t *frames, uint32_t count);
+	void Close();
+
+	bool IsOpen() const { return _fp != nullptr; }
+
+	~NAWavWriter() { Close(); }
+
+private:
+	FILE *_fp;
+	uint32_t _dataSize;
+	uint32_t _rate;
+
+	void _WriteHeader();
+};
@@ -0,0 +1,154 @@
+/* NekoEngine
+ *
+ * NullAudioSource.cpp
+ * Author: Alexandru Naiman
+ *
+ * NekoEngine NullAudio System
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <float.h>
+
+#include "NullAudio.h"
+
+using namespace std;
+using namespace glm;
+
+NullAudioSource::NullAudioSource(NullAudio *system, uint32_t id) noexcept :
+	_system(system),
+	_id(id),
+	_state(NullAudioSourceState::Stopped),
+	_pitch(1.f), _gain(1.f),
+	_coneInner(360.f), _coneOuter(360.f), _coneOuterGain(0.f),
+	_maxDistance(FLT_MAX), _referenceDistance(1.f), _rolloff(1.f),
+	_looping(false),
+	_position(0.f), _direction(0.f), _velocity(0.f),
+	_cursor{},
+	_audibility(0.f),
+	_targetGain{ 0.f, 0.f },
+	_lastGain{ 0.f, 0.f },
+	_virtual(false)
+{
+}
+
+void NullAudioSource::SetPitch(float p) noexcept { _pitch = p; }
+void NullAudioSource::SetGain(float g) noexcept { _gain = g; }
+void NullAudioSource::SetConeInnerAngle(float a) noexcept { _coneInner = a; }
+void NullAudioSource::SetConeOuterAngle(float a) noexcept { _coneOuter = a; }
+void NullAudioSource::SetConeOuterGain(float g) noexcept { _coneOuterGain = g; }
+void NullAudioSource::SetDirection(vec3 &dir) noexcept { _direction = dir; }
+void NullAudioSource::SetPosition(vec3 &pos) noexcept { _position = pos; }
+void NullAudioSource::SetVelocity(vec3 &v) noexcept { _velocity = v; }
+void NullAudioSource::SetLooping(bool looping) noexcept { _looping = looping; }
+void NullAudioSource::SetMaxDistance(float maxDistance) noexcept { _maxDistance = maxDistance; }
+void NullAudioSource::SetReferenceDistance(float referenceDistance) noexcept { _referenceDistance = referenceDistance; }
+void NullAudioSource::SetRolloffFactor(float rolloff) noexcept { _rolloff = rolloff; }
+
+int NullAudioSource::SetClip(AudioClip *clip) noexcept
+{
+	if (!clip)
+		return ENGINE_INVALID_ARGS;
+
+	// The audio system was released before this source
+	if (!_system)
+		return ENGINE_FAIL;
+
+	NullAudioBuffer *buffer{ (NullAudioBuffer *)clip->GetBuffer() };
+
+	lock_guard<mutex> lock(_system->_sourceMutex);
+
+	_clip = clip;
+	_state = NullAudioSourceState::Stopped;
+
+	_cursor = {};
+	_cursor.samples = buffer->GetSamples();
+	_cursor.channels = buffer->GetChannels();
+	_cursor.frameCount = buffer->GetFrameCount();
+
+	return ENGINE_OK;
+}
+
+bool NullAudioSource::Play() noexcept
+{
+	if (!_clip || !_system)
+		return false;
+
+	lock_guard<mutex> lock(_system->_sourceMutex);
+
+	if (_state == NullAudioSourceState::Stopped)
+		_cursor.position = 0;
+
+	_state = NullAudioSourceState::Playing;
+	_virtual = false;
+	_lastGain[0] = _lastGain[1] = 0.f;
+
+	return true;
+}
+
+void NullAudioSource::Pause() noexcept
+{
+	if (_state == NullAudioSourceState::Playing)
+		_state = NullAudioSourceState::Paused;
+}
+
+void NullAudioSource::Stop() noexcept
+{
+	if (!_system)
+		return;
+
+	lock_guard<mutex> lock(_system->_sourceMutex);
+
+	_state = NullAudioSourceState::Stopped;
+	_cursor.position = 0;
+}
+
+void NullAudioSource::Rewind() noexcept
+{
+	if (!_system)
+		return;
+
+	lock_guard<mutex> lock(_system->_sourceMutex);
+
+	_state = NullAudioSourceState::Stopped;
+	_cursor.position = 0;
+}
+
+bool NullAudioSource::IsPlaying() noexcept { return _state == NullAudioSourceState::Playing; }
+
+NullAudioSource::~NullAudioSource()
+{
+	if (_system)
+		_system->_RemoveSource(this);
+
+	_clip = nullptr;
+}
@@ -0,0 +1,475 @@
+/* NekoEngine
+ *
+ * NullBroadphase.cpp
+ * Author: Alexandru Naiman
+ *
+ * NekoEngine NullPhysics Module
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+#include "NullBroadphase.h"
+
+#define NULL_MBP_GRID_SIZE		8
+#define NULL_SAP_NO_PROXY		0xFFFFFFFF
+
+using namespace std;
+using namespace glm;
+
+static inline uint64_t _sap_PairKey(uint32_t a, uint32_t b)
+{
+	return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+/*
+ * Endpoint order for both the full and the incremental sort: min endpoints
+ * go first on ties so touching boxes overlap
+ */
+static inline bool _sap_Less(float aValue, uint32_t aData, float bValue, uint32_t bData)
+{
+	return aValue < bValue || (aValue == bValue && (aData & 1) < (bData & 1));
+}
+
+static inline bool _sap_Overlap(const NullProxy &a, const NullProxy &b)
+{
+	return a.min.x <= b.max.x && b.min.x <= a.max.x &&
+		a.min.y <= b.max.y && b.min.y <= a.max.y &&
+		a.min.z <= b.max.z && b.min.z <= a.max.z;
+}
+
+/*********************
+ * Sweep and prune
+ *********************/
+
+uint32_t NullSAP::Add(uint32_t proxy, const vec3 &min, const vec3 &max)
+{
+	uint32_t handle{};
+
+	if (_freeHandles.empty())
+	{
+		handle = (uint32_t)_handles.size();
+		_handles.push_back(Handle{});
+	}
+	else
+	{
+		handle = _freeHandles.back();
+		_freeHandles.pop_back();
+	}
+
+	Handle &h{ _handles[handle] };
+	h.proxy = proxy;
+
+	for (uint8_t axis = 0; axis < 3; ++axis)
+	{
+		_maxExtent[axis] = glm::max(_maxExtent[axis], max[axis] - min[axis]);
+		h.min[axis] = (uint32_t)_axes[axis].size();
+		_axes[axis].push_back(Endpoint{ min[axis], handle << 1 });
+		h.max[axis] = (uint32_t)_axes[axis].size();
+		_axes[axis].push_back(Endpoint{ max[axis], (handle << 1) | 1 });
+	}
+
+	_rebuild = true;
+	return handle;
+}
+
+void NullSAP::Move(uint32_t handle, const vec3 &min, const vec3 &max)
+{
+	const Handle &h{ _handles[handle] };
+
+	for (uint8_t axis = 0; axis < 3; ++axis)
+	{
+		_maxExtent[axis] = glm::max(_maxExtent[axis], max[axis] - min[axis]);
+		_axes[axis][h.min[axis]].value = min[axis];
+		_axes[axis][h.max[axis]].value = max[axis];
+	}
+
+	_moved = true;
+}
+
+void NullSAP::Remove(uint32_t handle)
+{
+	_handles[handle].proxy = NULL_SAP_NO_PROXY;
+	_freeHandles.push_back(handle);
+	_rebuild = true;
+}
+
+void NullSAP::Update(const vector<NullProxy> &proxies)
+{
+	if (_rebuild)
+	{
+		_Rebuild(proxies);
+	}
+	else if (_moved)
+	{
+		for (uint8_t axis = 0; axis < 3; ++axis)
+			_SortAxis(axis, proxies);
+	}
+
+	_moved = false;
+}
+
+void NullSAP::_Rebuild(const vector<NullProxy> &proxies)
+{
+	for (uint8_t axis = 0; axis < 3; ++axis)
+	{
+		vector<Endpoint> &endpoints{ _axes[axis] };
+		endpoints.clear();
+		_maxExtent[axis] = 0.f;
+
+		for (uint32_t i = 0; i < _handles.size(); ++i)
+		{
+			if (_handles[i].proxy == NULL_SAP_NO_PROXY)
+				continue;
+
+			const NullProxy &p{ proxies[_handles[i].proxy] };
+			_maxExtent[axis] = glm::max(_maxExtent[axis], p.max[axis] - p.min[axis]);
+			endpoints.push_back(Endpoint{ p.min[axis], i << 1 });
+			endpoints.push_back(Endpoint{ p.max[axis], (i << 1) | 1 });
+		}
+
+		sort(endpoints.begin(), endpoints.end(), [](const Endpoint &a, const Endpoint &b) {
+			return _sap_Less(a.value, a.data, b.value, b.data);
+		});
+
+		for (uint32_t i = 0; i < endpoints.size(); ++i)
+		{
+			Handle &h{ _handles[endpoints[i].data >> 1] };
+			(endpoints[i].data & 1 ? h.max : h.min)[axis] = i;
+		}
+	}
+
+	// Sweep the x axis keeping the list of open intervals
+	vector<uint32_t> active, activeIndex(_handles.size());
+	_pairs.clear();
+
+	for (const Endpoint &e : _axes[0])
+	{
+		const uint32_t handle{ e.data >> 1 };
+		const NullProxy &p{ proxies[_handles[handle].proxy] };
+
+		if (e.data & 1)
+		{
+			const uint32_t index{ activeIndex[handle] };
+			active[index] = active.back();
+			activeIndex[active[index]] = index;
+			active.pop_back();
+			continue;
+		}
+
+		for (uint32_t other : active)
+		{
+			const NullProxy &o{ proxies[_handles[other].proxy] };
+			if (p.min.y <= o.max.y && o.min.y <= p.max.y && p.min.z <= o.max.z && o.min.z <= p.max.z)
+				_pairs.insert(_sap_PairKey(_handles[handle].proxy, _handles[other].proxy));
+		}
+
+		activeIndex[handle] = (uint32_t)active.size();
+		active.push_back(handle);
+	}
+
+	_rebuild = false;
+}
+
+void NullSAP::_SortAxis(uint8_t axis, const vector<NullProxy> &proxies)
+{
+	vector<Endpoint> &endpoints{ _axes[axis] };
+
+	for (uint32_t i = 1; i < endpoints.size(); ++i)
+	{
+		const Endpoint key{ endpoints[i] };
+		if (!_sap_Less(key.value, key.data, endpoints[i - 1].value, endpoints[i - 1].data))
+			continue;
+
+		const Handle &keyHandle{ _handles[key.data >> 1] };
+		uint32_t j{ i };
+
+		while (j > 0 && _sap_Less(key.value, key.data, endpoints[j - 1].value, endpoints[j - 1].data))
+		{
+			const Endpoint prev{ endpoints[j - 1] };
+			const Handle &prevHandle{ _handles[prev.data >> 1] };
+
+			// A min moving below a max may start an overlap,
+			// a max moving below a min always ends one
+			if ((key.data & 1) != (prev.data & 1))
+			{
+				if (!(key.data & 1))
+				{
+					if (_sap_Overlap(proxies[keyHandle.proxy], proxies[prevHandle.proxy]))
+						_pairs.insert(_sap_PairKey(keyHandle.proxy, prevHandle.proxy));
+				}
+				else
+				{
+					_pairs.erase(_sap_PairKey(keyHandle.proxy, prevHandle.proxy));
+				}
+			}
+
+			endpoints[j] = prev;
+			Handle &moved{ _handles[prev.data >> 1] };
+			(prev.data & 1 ? moved.max : moved.min)[axis] = j;
+			--j;
+		}
+
+		endpoints[j] = key;
+		Handle &h{ _handles[key.data >> 1] };
+		(key.data & 1 ? h.max : h.min)[axis] = j;
+	}
+}
+
+void NullSAP::Query(const vec3 &min, const vec3 &max, const vector<NullProxy> &proxies, vector<uint32_t> &out) const
+{
+	// A proxy overlapping [min, max] has its min endpoint in [min - extent, max],
+	// where extent is the largest proxy size on the axis; scan the shortest range
+	uint8_t axis{ 0 };
+	size_t begin{ 0 }, end{ 0 }, best{ SIZE_MAX };
+
+	for (uint8_t i = 0; i < 3; ++i)
+	{
+		const vector<Endpoint> &endpoints{ _axes[i] };
+
+		const size_t lower{ (size_t)(lower_bound(endpoints.begin(), endpoints.end(), min[i] - _maxExtent[i], [](const Endpoint &e, float v) {
+			return e.value < v;
+		}) - endpoints.begin()) };
+		const size_t upper{ (size_t)(upper_bound(endpoints.begin(), endpoints.end(), max[i], [](float v, const Endpoint &e) {
+			return v < e.value;
+		}) - endpoints.begin()) };
+
+		if (upper - lower < best)
+		{
+			best = upper - lower;
+			axis = i;
+			begin = lower;
+			end = upper;
+		}
+	}
+
+	const vector<Endpoint> &endpoints{ _axes[axis] };
+
+	for (size_t i = begin; i < end; ++i)
+	{
+		if (endpoints[i].data & 1)
+			continue;
+
+		const uint32_t id{ _handles[endpoints[i].data >> 1].proxy };
+		if (id == NULL_SAP_NO_PROXY)
+			continue;
+
+		const NullProxy &p{ proxies[id] };
+		if (p.min.x <= max.x && min.x <= p.max.x && p.min.y <= max.y && min.y <= p.max.y && p.min.z <= max.z && min.z <= p.max.z)
+			out.push_back(id);
+	}
+}
+
+/*********************
+ * Broadphase
+ *********************/
+
+void NullBroadphase::Initialize(BroadphaseType type, float sceneSize)
+{
+	_gridSize = type == BroadphaseType::MBP ? NULL_MBP_GRID_SIZE : 1;
+	_sceneSize = sceneSize;
+	_cellSize = sceneSize * 2.f / (float)_gridSize;
+
+	_regions.clear();
+	_regions.resize(_gridSize * _gridSize);
+	_proxies.clear();
+	_freeProxies.clear();
+	_pairs.clear();
+}
+
+void NullBroadphase::_GetCells(const vec3 &min, const vec3 &max, int32_t *cellMin, int32_t *cellMax) const noexcept
+{
+	if (_gridSize == 1)
+	{
+		cellMin[0] = cellMin[1] = cellMax[0] = cellMax[1] = 0;
+		return;
+	}
+
+	const float mins[2]{ min.x, min.z }, maxs[2]{ max.x, max.z };
+
+	// Proxies outside the scene bounds are kept in the border cells
+	for (uint8_t i = 0; i < 2; ++i)
+	{
+		cellMin[i] = glm::clamp((int32_t)floorf((mins[i] + _sceneSize) / _cellSize), 0, _gridSize - 1);
+		cellMax[i] = glm::clamp((int32_t)floorf((maxs[i] + _sceneSize) / _cellSize), 0, _gridSize - 1);
+	}
+}
+
+void NullBroadphase::_Insert(NullProxy &proxy, uint32_t id)
+{
+	for (int32_t z = proxy.cellMin[1]; z <= proxy.cellMax[1]; ++z)
+	{
+		for (int32_t x = proxy.cellMin[0]; x <= proxy.cellMax[0]; ++x)
+		{
+			const uint32_t region{ (uint32_t)(z * _gridSize + x) };
+			proxy.handles.push_back(make_pair(region, _regions[region].Add(id, proxy.min, proxy.max)));
+		}
+	}
+}
+
+uint32_t NullBroadphase::AddProxy(const vec3 &min, const vec3 &max, void *user)
+{
+	uint32_t id{};
+
+	if (_freeProxies.empty())
+	{
+		id = (uint32_t)_proxies.size();
+		_proxies.push_back(NullProxy{});
+	}
+	else
+	{
+		id = _freeProxies.back();
+		_freeProxies.pop_back();
+	}
+
+	NullProxy &proxy{ _proxies[id] };
+	proxy.min = min;
+	proxy.max = max;
+	proxy.user = user;
+	proxy.alive = true;
+	++proxy.generation;
+	proxy.handles.clear();
+
+	_GetCells(min, max, proxy.cellMin, proxy.cellMax);
+	_Insert(proxy, id);
+
+	return id;
+}
+
+void NullBroadphase::UpdateProxy(uint32_t id, const vec3 &min, const vec3 &max)
+{
+	NullProxy &proxy{ _proxies[id] };
+	proxy.min = min;
+	proxy.max = max;
+
+	int32_t cellMin[2]{}, cellMax[2]{};
+	_GetCells(min, max, cellMin, cellMax);
+
+	if (cellMin[0] == proxy.cellMin[0] && cellMin[1] == proxy.cellMin[1] &&
+		cellMax[0] == proxy.cellMax[0] && cellMax[1] == proxy.cellMax[1])
+	{
+		for (const pair<uint32_t, uint32_t> &h : proxy.handles)
+			_regions[h.first].Move(h.second, min, max);
+		return;
+	}
+
+	// Keep the regions the proxy still overlaps and add or remove the others
+	vector<pair<uint32_t, uint32_t>> handles;
+	for (const pair<uint32_t, uint32_t> &h : proxy.handles)
+	{
+		const int32_t x{ (int32_t)h.first % _gridSize }, z{ (int32_t)h.first / _gridSize };
+
+		if (x >= cellMin[0] && x <= cellMax[0] && z >= cellMin[1] && z <= cellMax[1])
+		{
+			_regions[h.first].Move(h.second, min, max);
+			handles.push_back(h);
+		}
+		else
+		{
+			_regions[h.first].Remove(h.second);
+		}
+	}
+
+	for (int32_t z = cellMin[1]; z <= cellMax[1]; ++z)
+	{
+		for (int32_t x = cellMin[0]; x <= cellMax[0]; ++x)
+		{
+			if (x >= proxy.cellMin[0] && x <= proxy.cellMax[0] && z >= proxy.cellMin[1] && z <= proxy.cellMax[1])
+				continue;
+
+			const uint32_t region{ (uint32_t)(z * _gridSize + x) };
+			handles.push_back(make_pair(region, _regions[region].Add(id, min, max)));
+		}
+	}
+
+	proxy.handles.swap(handles);
+	memcpy(proxy.cellMin, cellMin, sizeof(cellMin));
+	memcpy(proxy.cellMax, cellMax, sizeof(cellMax));
+}
+
+void NullBroadphase::RemoveProxy(uint32_t id)
+{
+	NullProxy &proxy{ _proxies[id] };
+
+	for (const pair<uint32_t, uint32_t> &h : proxy.handles)
+		_regions[h.first].Remove(h.second);
+
+	proxy.handles.clear();
+	proxy.user = nullptr;
+	proxy.alive = false;
+	_freeProxies.push_back(id);
+}
+
+const vector<uint64_t> &NullBroadphase::Update()
+{
+	_pairs.clear();
+
+	for (NullSAP &region : _regions)
+	{
+		region.Update(_proxies);
+		_pairs.insert(_pairs.end(), region.GetPairs().begin(), region.GetPairs().end());
+	}
+
+	// Proxies spanning several regions are reported by each of them
+	sort(_pairs.begin(), _pairs.end());
+	if (_regions.size() > 1)
+		_pairs.erase(unique(_pairs.begin(), _pairs.end()), _pairs.end());
+
+	return _pairs;
+}
+
+void NullBroadphase::Query(const vec3 &min, const vec3 &max, vector<uint32_t> &out)
+{
+	int32_t cellMin[2]{}, cellMax[2]{};
+	_GetCells(min, max, cellMin, cellMax);
+
+	out.clear();
+
+	for (int32_t z = cellMin[1]; z <= cellMax[1]; ++z)
+	{
+		for (int32_t x = cellMin[0]; x <= cellMax[0]; ++x)
+		{
+			NullSAP &region{ _regions[z * _gridSize + x] };
+			region.Update(_proxies);
+			region.Query(min, max, _proxies, out);
+		}
+	}
+
+	if (cellMin[0] != cellMax[0] || cellMin[1] != cellMax[1])
+	{
+		sort(out.begin(), out.end());
+		out.erase(unique(out.begin(), out.end()), out.end());
+	}
+}
@@ -0,0 +1,147 @@
+/* NekoEngine
+ *
+ * NullBroadphase.h
+ * Author: Alexandru Naiman
+ *
+ * NekoEngine NullPhysics Module
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <unordered_set>
+
+#include <Physics/Physics.h>
+
+struct NullProxy
+{
+	glm::vec3 min, max;
+	void *user;
+	int32_t cellMin[2], cellMax[2];
+	std::vector<std::pair<uint32_t, uint32_t>> handles;	// (region, handle)
+	uint32_t generation;	// incremented every time the slot is reused
+	bool alive;
+};
+
+/**
+ * Incremental sweep and prune over the three axes. Endpoints stay sorted
+ * between frames, so moving a proxy only costs the insertion sort swaps it
+ * causes; a swap of a min and a max endpoint adds or removes a pair. Adding
+ * or removing proxies marks the region for a full rebuild on the next update.
+ */
+class NullSAP
+{
+public:
+	NullSAP() : _maxExtent{ 0.f, 0.f, 0.f }, _rebuild{ false }, _moved{ false } { }
+
+	uint32_t Add(uint32_t proxy, const glm::vec3 &min, const glm::vec3 &max);
+	void Move(uint32_t handle, const glm::vec3 &min, const glm::vec3 &max);
+	void Remove(uint32_t handle);
+
+	void Update(const std::vector<NullProxy> &proxies);
+
+	/**
+	 * Append the proxies that overlap [min, max]. The endpoints must be
+	 * sorted, ie. Update was called after the last change.
+	 */
+	void Query(const glm::vec3 &min, const glm::vec3 &max, const std::vector<NullProxy> &proxies, std::vector<uint32_t> &out) const;
+
+	const std::unordered_set<uint64_t> &GetPairs() const noexcept { return _pairs; }
+
+private:
+	struct Endpoint
+	{
+		float value;
+		uint32_t data;	// handle << 1 | max
+	};
+
+	struct Handle
+	{
+		uint32_t proxy;
+		uint32_t min[3], max[3];
+	};
+
+	std::vector<Endpoint> _axes[3];
+	std::vector<Handle> _handles;
+	std::vector<uint32_t> _freeHandles;
+	std::unordered_set<uint64_t> _pairs;
+	float _maxExtent[3];	// largest proxy size per axis, shrinks only on rebuild
+	bool _rebuild, _moved;
+
+	void _Rebuild(const std::vector<NullProxy> &proxies);
+	void _SortAxis(uint8_t axis, const std::vector<NullProxy> &proxies);
+};
+
+/**
+ * SAP uses a single region for the whole scene. MBP splits the scene on the
+ * XZ plane into a grid of regions, each with its own sweep and prune, so
+ * moving proxies only disturb the endpoints of their own regions.
+ */
+class NullBroadphase
+{
+public:
+	NullBroadphase() : _cellSize{ 0.f }, _sceneSize{ 0.f }, _gridSize{ 1 } { }
+
+	void Initialize(BroadphaseType type, float sceneSize);
+
+	uint32_t AddProxy(const glm::vec3 &min, const glm::vec3 &max, void *user);
+	void UpdateProxy(uint32_t id, const glm::vec3 &min, const glm::vec3 &max);
+	void RemoveProxy(uint32_t id);
+
+	/**
+	 * Resolve the pending changes. The overlapping pairs are returned sorted,
+	 * as (low id << 32 | high id).
+	 */
+	const std::vector<uint64_t> &Update();
+
+	/**
+	 * Find the proxies that overlap [min, max]. The regions touched by the
+	 * query are brought up to date first.
+	 */
+	void Query(const glm::vec3 &min, const glm::vec3 &max, std::vector<uint32_t> &out);
+
+	const std::vector<NullProxy> &GetProxies() const noexcept { return _proxies; }
+	uint32_t GetRegionCount() const noexcept { return (uint32_t)_regions.size(); }
+
+private:
+	std::vector<NullSAP> _regions;
+	std::vector<NullProxy> _proxies;
+	std::vector<uint32_t> _freeProxies;
+	std::vector<uint64_t> _pairs;
+	float _cellSize, _sceneSize;
+	int32_t _gridSize;
+
+	void _GetCells(const glm::vec3 &min, const glm::vec3 &max, int32_t *cellMin, int32_t *cellMax) const noexcept;
+	void _Insert(NullProxy &proxy, uint32_t id);
+};
@@ -0,0 +1,301 @@
+/* NekoEngine
+ *
+ * NullColliders.cpp
+ * Author: Alexandru Naiman
+ *
+ * NekoEngine NullPhysics Module
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Physics/TriangleBVH.h>
+#include <Renderer/StaticMesh.h>
+
+#include "NullPhysics.h"
+#include "NullColliders.h"
+
+using namespace glm;
+
+static inline NullPhysics *_GetPhysics() { return (NullPhysics *)Physics::GetInstance(); }
+
+static inline float _MaxComponent(const vec3 &v) { return glm::max(glm::max(v.x, v.y), v.z); }
+
+void NullShape::Update() noexcept
+{
+	const vec3 absScale{ abs(scale) };
+
+	axes = mat3_cast(rotation);
+
+	switch (type)
+	{
+		case NullShapeType::Box:
+		{
+			extents = halfExtents * absScale;
+		}
+		break;
+		case NullShapeType::Sphere:
+		{
+			worldRadius = radius * _MaxComponent(absScale);
+			extents = vec3(worldRadius);
+		}
+		break;
+		case NullShapeType::Capsule:
+		{
+			worldRadius = radius * glm::max(absScale.x, absScale.z);
+			worldHalfHeight = halfHeight * absScale.y;
+			extents = vec3(worldRadius, worldHalfHeight + worldRadius, worldRadius);
+		}
+		break;
+		case NullShapeType::Mesh:
+		{
+			if (!bvh)
+			{
+				aabbMin = aabbMax = position;
+				return;
+			}
+
+			// Bounds of the transformed mesh space box
+			const vec3 center{ (bvh->GetMin() + bvh->GetMax()) * .5f * scale };
+			extents = (bvh->GetMax() - bvh->GetMin()) * .5f * absScale;
+
+			const mat3 absAxes{ abs(axes[0]), abs(axes[1]), abs(axes[2]) };
+			const vec3 worldCenter{ position + axes * center };
+			const vec3 worldExtents{ absAxes * extents };
+
+			aabbMin = worldCenter - worldExtents;
+			aabbMax = worldCenter + worldExtents;
+		}
+		return;
+	}
+
+	if (type == NullShapeType::Sphere)
+	{
+		aabbMin = position - extents;
+		aabbMax = position + extents;
+		return;
+	}
+
+	// Capsules are bounded by their box along the local y axis
+	const mat3 absAxes{ abs(axes[0]), abs(axes[1]), abs(axes[2]) };
+	const vec3 worldExtents{ absAxes * extents };
+
+	aabbMin = position - worldExtents;
+	aabbMax = position + worldExtents;
+}
+
+/*********************
+ * Box Collider
+ *********************/
+
+NullBoxCollider::NullBoxCollider(Object *parent, const vec3 &halfExtents) :
+	BoxCollider(parent, halfExtents),
+	_shape(NullShapeType::Box, parent)
+{
+	_shape.halfExtents = halfExtents;
+	_shape.Update();
+	_GetPhysics()->AddShape(&_shape);
+}
+
+void NullBoxCollider::SetHalfExtents(const vec3 &halfExtents)
+{
+	BoxCollider::SetHalfExtents(halfExtents);
+	_shape.halfExtents = halfExtents;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullBoxCollider::SetPosition(const vec3 &position)
+{
+	_shape.position = position;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullBoxCollider::SetRotation(const quat &rotation)
+{
+	_shape.rotation = rotation;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullBoxCollider::SetScale(const vec3 &scale)
+{
+	_shape.scale = scale;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+NullBoxCollider::~NullBoxCollider()
+{
+	_GetPhysics()->RemoveShape(&_shape);
+}
+
+/*********************
+ * Sphere Collider
+ *********************/
+
+NullSphereCollider::NullSphereCollider(Object *parent, double radius) :
+	SphereCollider(parent, radius),
+	_shape(NullShapeType::Sphere, parent)
+{
+	_shape.radius = (float)radius;
+	_shape.Update();
+	_GetPhysics()->AddShape(&_shape);
+}
+
+void NullSphereCollider::SetRadius(double radius)
+{
+	SphereCollider::SetRadius(radius);
+	_shape.radius = (float)radius;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullSphereCollider::SetPosition(const vec3 &position)
+{
+	_shape.position = position;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullSphereCollider::SetRotation(const quat &rotation)
+{
+	_shape.rotation = rotation;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullSphereCollider::SetScale(const vec3 &scale)
+{
+	_shape.scale = scale;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+NullSphereCollider::~NullSphereCollider()
+{
+	_GetPhysics()->RemoveShape(&_shape);
+}
+
+/*********************
+ * Capsule Collider
+ *********************/
+
+NullCapsuleCollider::NullCapsuleCollider(Object *parent, double radius, double height) :
+	CapsuleCollider(parent, radius, height),
+	_shape(NullShapeType::Capsule, parent)
+{
+	_shape.radius = (float)radius;
+	_shape.halfHeight = (float)height * .5f;
+	_shape.Update();
+	_GetPhysics()->AddShape(&_shape);
+}
+
+void NullCapsuleCollider::SetRadius(double radius)
+{
+	CapsuleCollider::SetRadius(radius);
+	_shape.radius = (float)radius;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullCapsuleCollider::SetHeight(double height)
+{
+	CapsuleCollider::SetHeight(height);
+	_shape.halfHeight = (float)height * .5f;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullCapsuleCollider::SetRadiusAndHeight(double radius, double height)
+{
+	CapsuleCollider::SetRadiusAndHeight(radius, height);
+	_shape.radius = (float)radius;
+	_shape.halfHeight = (float)height * .5f;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullCapsuleCollider::SetPosition(const vec3 &position)
+{
+	_shape.position = position;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullCapsuleCollider::SetRotation(const quat &rotation)
+{
+	_shape.rotation = rotation;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullCapsuleCollider::SetScale(const vec3 &scale)
+{
+	_shape.scale = scale;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+NullCapsuleCollider::~NullCapsuleCollider()
+{
+	_GetPhysics()->RemoveShape(&_shape);
+}
+
+/*********************
+ * Mesh Collider
+ *********************/
+
+NullMeshCollider::NullMeshCollider(Object *parent, const StaticMesh *mesh) :
+	MeshCollider(parent, mesh),
+	_shape(NullShapeType::Mesh, parent)
+{
+	_shape.bvh = mesh ? mesh->GetBVH() : nullptr;
+	_shape.Update();
+	_GetPhysics()->AddShape(&_shape);
+}
+
+void NullMeshCollider::SetMesh(const StaticMesh *mesh)
+{
+	MeshCollider::SetMesh(mesh);
+	_shape.bvh = mesh ? mesh->GetBVH() : nullptr;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullMeshCollider::SetPosition(const vec3 &position)
+{
+	_shape.position = position;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullMeshCollider::SetRotation(const quat &rotation)
+{
+	_shape.rotation = rotation;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+void NullMeshCollider::SetScale(const vec3 &scale)
+{
+	_shape.scale = scale;
+	_GetPhysics()->UpdateShape(&_shape);
+}
+
+NullMeshCollider::~NullMeshCollider()
+{
+	_GetPhysics()->RemoveShape(&_shape);
+}
@@ -0,0 +1,170 @@
+/* NekoEngine
+ *
+ * NullColliders.h
+ * Author: Alexandru Naiman
+ *
+ * NekoEngine NullPhysics Module
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <Physics/Collider.h>
+
+class TriangleBVH;
+
+enum class NullShapeType : uint8_t
+{
+	Box,
+	Sphere,
+	Capsule,
+	Mesh
+};
+
+/**
+ * World space description of a collider, shared by the broadphase, the
+ * narrowphase and the ray queries. The collider classes own one and refresh
+ * the derived fields whenever the transform or the dimensions change.
+ */
+struct NullShape
+{
+	NullShapeType type;
+	Object *object;
+	uint32_t proxy;
+
+	glm::vec3 position;
+	glm::quat rotation;
+	glm::vec3 scale;
+
+	// Local dimensions
+	glm::vec3 halfExtents;
+	float radius, halfHeight;
+	const TriangleBVH *bvh;
+
+	// Derived world space data
+	glm::mat3 axes;
+	glm::vec3 extents;
+	float worldRadius, worldHalfHeight;
+	glm::vec3 aabbMin, aabbMax;
+
+	NullShape(NullShapeType shapeType, Object *parent) :
+		type{ shapeType }, object{ parent }, proxy{ 0 },
+		position{ 0.f }, rotation{ 1.f, 0.f, 0.f, 0.f }, scale{ 1.f },
+		halfExtents{ 0.f }, radius{ 0.f }, halfHeight{ 0.f }, bvh{ nullptr },
+		axes{ 1.f }, extents{ 0.f }, worldRadius{ 0.f }, worldHalfHeight{ 0.f },
+		aabbMin{ 0.f }, aabbMax{ 0.f }
+	{ }
+
+	/**
+	 * Recompute the world space data and the bounding box
+	 */
+	void Update() noexcept;
+};
+
+class NullBoxCollider : public BoxCollider
+{
+public:
+	NullBoxCollider(Object *parent, const glm::vec3 &halfExtents);
+
+	NullShape *GetShape() { return &_shape; }
+
+	virtual void SetHalfExtents(const glm::vec3 &halfExtents) override;
+
+	virtual void SetPosition(const glm::vec3 &position) override;
+	virtual void SetRotation(const glm::quat &rotation) override;
+	virtual void SetScale(const glm::vec3 &scale) override;
+
+	virtual ~NullBoxCollider();
+
+private:
+	NullShape _shape;
+};
+
+class NullSphereCollider : public SphereCollider
+{
+public:
+	NullSphereCollider(Object *parent, double radius);
+
+	NullShape *GetShape() { return &_shape; }
+
+	virtual void SetRadius(double radius) override;
+
+	virtual void SetPosition(const glm::vec3 &position) override;
+	virtual void SetRotation(const glm::quat &rotation) override;
+	virtual void SetScale(const glm::vec3 &scale) override;
+
+	virtual ~NullSphereCollider();
+
+private:
+	NullShape _shape;
+};
+
+class NullCapsuleCollider : public CapsuleCollider
+{
+public:
+	NullCapsuleCollider(Object *parent, double radius, double height);
+
+	NullShape *GetShape() { return &_shape; }
+
+	virtual void SetRadius(double radius) override;
+	virtual void SetHeight(double height) override;
+	virtual void SetRadiusAndHeight(double radius, double height) override;
+
+	virtual void SetPosition(const glm::vec3 &position) override;
+	virtual void SetRotation(const glm::quat &rotation) override;
+	virtual void SetScale(const glm::vec3 &scale) override;
+
+	virtual ~NullCapsuleCollider();
+
+private:
+	NullShape _shape;
+};
+
+class NullMeshCollider : public MeshCollider
+{
+public:
+	NullMeshCollider(Object *parent, const StaticMesh *mesh);
+
+	NullShape *GetShape() { return &_shape; }
+
+	virtual void SetMesh(const StaticMesh *mesh) override;
+
+	virtual void SetPosition(const glm::vec3 &position) override;
+	virtual void SetRotation(const glm::quat &rotation) override;
+	virtual void SetScale(const glm::vec3 &scale) override;
+
+	virtual ~NullMeshCollider();
+
+private:
+	NullShape _shape;
+};
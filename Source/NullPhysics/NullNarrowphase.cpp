@@ -0,0 +1,454 @@
+/* NekoEngine
+ *
+ * NullNarrowphase.cpp
+ * Author: Alexandru Naiman
+ *
+ * NekoEngine NullPhysics Module
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <float.h>
+
+#include <Physics/TriangleBVH.h>
+
+#include "NullNarrowphase.h"
+
+#define NULL_NP_EPSILON		1e-6f
+
+using namespace glm;
+
+// Closest points of segments p1q1 and p2q2 (Ericson, Real-Time Collision Detection 5.1.9)
+static inline void _np_ClosestPtSegmentSegment(const vec3 &p1, const vec3 &q1, const vec3 &p2, const vec3 &q2, vec3 &c1, vec3 &c2)
+{
+	const vec3 d1{ q1 - p1 }, d2{ q2 - p2 }, r{ p1 - p2 };
+	const float a{ dot(d1, d1) }, e{ dot(d2, d2) }, f{ dot(d2, r) };
+	float s{ 0.f }, t{ 0.f };
+
+	if (a <= NULL_NP_EPSILON && e <= NULL_NP_EPSILON)
+	{
+		c1 = p1;
+		c2 = p2;
+		return;
+	}
+
+	if (a <= NULL_NP_EPSILON)
+	{
+		t = glm::clamp(f / e, 0.f, 1.f);
+	}
+	else
+	{
+		const float c{ dot(d1, r) };
+
+		if (e <= NULL_NP_EPSILON)
+		{
+			s = glm::clamp(-c / a, 0.f, 1.f);
+		}
+		else
+		{
+			const float b{ dot(d1, d2) };
+			const float denom{ a * e - b * b };
+
+			s = denom != 0.f ? glm::clamp((b * f - c * e) / denom, 0.f, 1.f) : 0.f;
+			t = (b * s + f) / e;
+
+			if (t < 0.f)
+			{
+				t = 0.f;
+				s = glm::clamp(-c / a, 0.f, 1.f);
+			}
+			else if (t > 1.f)
+			{
+				t = 1.f;
+				s = glm::clamp((b - c) / a, 0.f, 1.f);
+			}
+		}
+	}
+
+	c1 = p1 + d1 * s;
+	c2 = p2 + d2 * t;
+}
+
+static inline vec3 _np_ToBox(const NullShape &box, const vec3 &p) { return transpose(box.axes) * (p - box.position); }
+static inline vec3 _np_FromBox(const NullShape &box, const vec3 &p) { return box.position + box.axes * p; }
+
+/**
+ * Spheres and capsules are both a segment with a radius
+ */
+static inline void _np_Segment(const NullShape &s, vec3 &a, vec3 &b)
+{
+	if (s.type == NullShapeType::Capsule)
+	{
+		a = s.position - s.axes[1] * s.worldHalfHeight;
+		b = s.position + s.axes[1] * s.worldHalfHeight;
+	}
+	else
+	{
+		a = b = s.position;
+	}
+}
+
+static bool _np_SegmentSegment(const NullShape &sa, const NullShape &sb, vec3 &pointA, vec3 &pointB)
+{
+	vec3 a0, a1, b0, b1, ca, cb;
+	_np_Segment(sa, a0, a1);
+	_np_Segment(sb, b0, b1);
+	_np_ClosestPtSegmentSegment(a0, a1, b0, b1, ca, cb);
+
+	const vec3 d{ cb - ca };
+	const float r{ sa.worldRadius + sb.worldRadius };
+	const float dist2{ dot(d, d) };
+
+	if (dist2 > r * r)
+		return false;
+
+	const vec3 n{ dist2 > NULL_NP_EPSILON ? d / sqrtf(dist2) : vec3(0.f, 1.f, 0.f) };
+	pointA = ca + n * sa.worldRadius;
+	pointB = cb - n * sb.worldRadius;
+
+	return true;
+}
+
+static inline float _np_BoxDistance2(const vec3 &p, const vec3 &e)
+{
+	const vec3 d{ p - glm::clamp(p, -e, e) };
+	return dot(d, d);
+}
+
+/*
+ * Parameter of the point of a + t * d, t in [0, 1], closest to the box [-e, e].
+ * The squared distance is convex and quadratic between the parameters where
+ * the segment crosses a face plane, so the minimum is the clamped stationary
+ * point of one of these intervals.
+ */
+static float _np_ClosestPtSegmentBox(const vec3 &a, const vec3 &d, const vec3 &e)
+{
+	float splits[8]{ 0.f };
+	uint32_t count{ 1 };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		if (fabsf(d[i]) <= NULL_NP_EPSILON)
+			continue;
+
+		for (float plane : { -e[i], e[i] })
+		{
+			const float t{ (plane - a[i]) / d[i] };
+			if (t <= 0.f || t >= 1.f)
+				continue;
+
+			uint32_t j{ count++ };
+			for (; splits[j - 1] > t; --j)
+				splits[j] = splits[j - 1];
+			splits[j] = t;
+		}
+	}
+
+	splits[count++] = 1.f;
+
+	float best{ 0.f }, bestDist2{ FLT_MAX };
+	for (uint32_t i = 1; i < count; ++i)
+	{
+		const float t0{ splits[i - 1] }, t1{ splits[i] };
+		const vec3 mid{ a + d * ((t0 + t1) * .5f) };
+		float qa{ 0.f }, qb{ 0.f };
+
+		// Only the axes outside the slab contribute on this interval
+		for (int j = 0; j < 3; ++j)
+		{
+			if (mid[j] > e[j] || mid[j] < -e[j])
+			{
+				qa += d[j] * d[j];
+				qb += d[j] * (a[j] - (mid[j] > 0.f ? e[j] : -e[j]));
+			}
+		}
+
+		const float t{ qa > NULL_NP_EPSILON ? glm::clamp(-qb / qa, t0, t1) : t0 };
+		const float dist2{ _np_BoxDistance2(a + d * t, e) };
+
+		if (dist2 < bestDist2)
+		{
+			best = t;
+			bestDist2 = dist2;
+		}
+	}
+
+	return best;
+}
+
+static bool _np_BoxSegment(const NullShape &box, const NullShape &s, vec3 &pointA, vec3 &pointB)
+{
+	vec3 a, b;
+	_np_Segment(s, a, b);
+	a = _np_ToBox(box, a);
+	b = _np_ToBox(box, b);
+
+	const vec3 segPt{ a + (b - a) * _np_ClosestPtSegmentBox(a, b - a, box.extents) };
+	const vec3 boxPt{ glm::clamp(segPt, -box.extents, box.extents) };
+
+	const vec3 d{ boxPt - segPt };
+	const float dist2{ dot(d, d) };
+
+	if (dist2 > s.worldRadius * s.worldRadius)
+		return false;
+
+	pointA = _np_FromBox(box, boxPt);
+	pointB = dist2 > NULL_NP_EPSILON ? _np_FromBox(box, segPt + d * (s.worldRadius / sqrtf(dist2))) : pointA;
+
+	return true;
+}
+
+// Separating axis test (Ericson, Real-Time Collision Detection 4.4.1)
+static bool _np_BoxBox(const NullShape &a, const NullShape &b, vec3 &pointA, vec3 &pointB)
+{
+	mat3 r, absR;
+	const vec3 d{ b.position - a.position };
+	const vec3 t{ dot(d, a.axes[0]), dot(d, a.axes[1]), dot(d, a.axes[2]) };
+	const vec3 &ea{ a.extents }, &eb{ b.extents };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			r[i][j] = dot(a.axes[i], b.axes[j]);
+			absR[i][j] = fabsf(r[i][j]) + NULL_NP_EPSILON;
+		}
+	}
+
+	for (int i = 0; i < 3; ++i)
+		if (fabsf(t[i]) > ea[i] + eb[0] * absR[i][0] + eb[1] * absR[i][1] + eb[2] * absR[i][2])
+			return false;
+
+	for (int j = 0; j < 3; ++j)
+		if (fabsf(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) > ea[0] * absR[0][j] + ea[1] * absR[1][j] + ea[2] * absR[2][j] + eb[j])
+			return false;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const int i1{ (i + 1) % 3 }, i2{ (i + 2) % 3 };
+
+		for (int j = 0; j < 3; ++j)
+		{
+			const int j1{ (j + 1) % 3 }, j2{ (j + 2) % 3 };
+			const float ra{ ea[i1] * absR[i2][j] + ea[i2] * absR[i1][j] };
+			const float rb{ eb[j1] * absR[i][j2] + eb[j2] * absR[i][j1] };
+
+			if (fabsf(t[i2] * r[i1][j] - t[i1] * r[i2][j]) > ra + rb)
+				return false;
+		}
+	}
+
+	pointA = _np_FromBox(a, glm::clamp(_np_ToBox(a, b.position), -ea, ea));
+	pointB = _np_FromBox(b, glm::clamp(_np_ToBox(b, a.position), -eb, eb));
+
+	return true;
+}
+
+bool NullOverlap(const NullShape &a, const NullShape &b, vec3 &pointA, vec3 &pointB) noexcept
+{
+	if (a.type == NullShapeType::Mesh || b.type == NullShapeType::Mesh)
+		return false;
+
+	if (a.type == NullShapeType::Box)
+	{
+		if (b.type == NullShapeType::Box)
+			return _np_BoxBox(a, b, pointA, pointB);
+
+		return _np_BoxSegment(a, b, pointA, pointB);
+	}
+
+	if (b.type == NullShapeType::Box)
+		return _np_BoxSegment(b, a, pointB, pointA);
+
+	return _np_SegmentSegment(a, b, pointA, pointB);
+}
+
+static bool _np_RaySphere(const vec3 &center, float radius, const vec3 &origin, const vec3 &direction, float &t)
+{
+	const vec3 m{ origin - center };
+	const float b{ dot(m, direction) };
+	const float c{ dot(m, m) - radius * radius };
+
+	if (c > 0.f && b > 0.f)
+		return false;
+
+	const float disc{ b * b - c };
+	if (disc < 0.f)
+		return false;
+
+	t = glm::max(-b - sqrtf(disc), 0.f);
+	return true;
+}
+
+static bool _np_RayBox(const NullShape &box, const vec3 &origin, const vec3 &direction, float &t, vec3 &normal)
+{
+	const vec3 o{ _np_ToBox(box, origin) }, d{ transpose(box.axes) * direction };
+	float tmin{ 0.f }, tmax{ FLT_MAX };
+	int axis{ -1 };
+	float sign{ 0.f };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		if (fabsf(d[i]) < NULL_NP_EPSILON)
+		{
+			if (o[i] < -box.extents[i] || o[i] > box.extents[i])
+				return false;
+			continue;
+		}
+
+		const float inv{ 1.f / d[i] };
+		float t0{ (-box.extents[i] - o[i]) * inv }, t1{ (box.extents[i] - o[i]) * inv };
+		float s{ -1.f };
+
+		if (t0 > t1)
+		{
+			std::swap(t0, t1);
+			s = 1.f;
+		}
+
+		if (t0 > tmin)
+		{
+			tmin = t0;
+			axis = i;
+			sign = s;
+		}
+
+		tmax = glm::min(tmax, t1);
+		if (tmin > tmax)
+			return false;
+	}
+
+	t = tmin;
+	normal = axis < 0 ? -direction : box.axes[axis] * sign;
+
+	return true;
+}
+
+static bool _np_RayCapsule(const NullShape &capsule, const vec3 &origin, const vec3 &direction, float &t, vec3 &normal)
+{
+	// Capsule space, with the segment on the y axis
+	const vec3 o{ _np_ToBox(capsule, origin) }, d{ transpose(capsule.axes) * direction };
+	const float r{ capsule.worldRadius }, h{ capsule.worldHalfHeight };
+	float best{ FLT_MAX }, tt{};
+	vec3 center{ 0.f };
+	bool hit{ false };
+
+	// Side of the cylinder
+	const float a{ d.x * d.x + d.z * d.z };
+	if (a > NULL_NP_EPSILON)
+	{
+		const float b{ o.x * d.x + o.z * d.z };
+		const float c{ o.x * o.x + o.z * o.z - r * r };
+		const float disc{ b * b - a * c };
+
+		if (disc >= 0.f)
+		{
+			tt = glm::max((-b - sqrtf(disc)) / a, 0.f);
+			const float y{ o.y + d.y * tt };
+
+			if (y >= -h && y <= h && (c <= 0.f || b < 0.f))
+			{
+				best = tt;
+				center = vec3(0.f, y, 0.f);
+				hit = true;
+			}
+		}
+	}
+
+	for (float cap : { -h, h })
+	{
+		if (_np_RaySphere(vec3(0.f, cap, 0.f), r, o, d, tt) && tt < best)
+		{
+			best = tt;
+			center = vec3(0.f, cap, 0.f);
+			hit = true;
+		}
+	}
+
+	if (!hit)
+		return false;
+
+	t = best;
+	const vec3 n{ o + d * best - center };
+	normal = dot(n, n) > NULL_NP_EPSILON ? capsule.axes * normalize(n) : -direction;
+
+	return true;
+}
+
+bool NullRayCast(const NullShape &shape, const vec3 &origin, const vec3 &direction, float maxT, float &t, vec3 &normal) noexcept
+{
+	bool hit{ false };
+
+	switch (shape.type)
+	{
+		case NullShapeType::Sphere:
+		{
+			hit = _np_RaySphere(shape.position, shape.worldRadius, origin, direction, t);
+			if (hit)
+			{
+				const vec3 n{ origin + direction * t - shape.position };
+				normal = dot(n, n) > NULL_NP_EPSILON ? normalize(n) : -direction;
+			}
+		}
+		break;
+		case NullShapeType::Box:
+			hit = _np_RayBox(shape, origin, direction, t, normal);
+		break;
+		case NullShapeType::Capsule:
+			hit = _np_RayCapsule(shape, origin, direction, t, normal);
+		break;
+		case NullShapeType::Mesh:
+		{
+			if (!shape.bvh)
+				return false;
+
+			// Casting in mesh space with an unnormalized direction keeps t in world units
+			const vec3 invScale{ 1.f / shape.scale };
+			const vec3 o{ _np_ToBox(shape, origin) * invScale };
+			const vec3 d{ transpose(shape.axes) * direction * invScale };
+			BVHHit bvhHit{};
+
+			hit = shape.bvh->ClosestHit(o, d, maxT, bvhHit);
+			if (hit)
+			{
+				t = bvhHit.t;
+
+				// Normals transform with the inverse transpose
+				vec3 n{ shape.axes * (bvhHit.normal * invScale) };
+				normal = normalize(dot(n, direction) > 0.f ? -n : n);
+			}
+		}
+		break;
+	}
+
+	return hit && t <= maxT;
+}
@@ -37,18 +37,204 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <float.h>
+
+#include <Engine/Engine.h>
+#include <System/Logger.h>
+#include <Scene/Object.h>
+#include <Scene/CameraManager.h>
+
 #include "NullPhysics.h"
+#include "NullColliders.h"
+#include "NullNarrowphase.h"
+
+#define NULL_PHYS_MODULE			"NullPhysics"
+#define NULL_PHYS_DEFAULT_SIZE		4000.f
+
+using namespace std;
+using namespace glm;
+
+int NullPhysics::Initialize()
+{
+	_broadphase.Initialize(BroadphaseType::SAP, NULL_PHYS_DEFAULT_SIZE);
+
+	Logger::Log(NULL_PHYS_MODULE, LOG_INFORMATION, "Initialized");
+	Logger::Log(NULL_PHYS_MODULE, LOG_INFORMATION, "Module version: %s", NULL_PHYSICS_VERSION_STRING);
+
+	return ENGINE_OK;
+}
+
+int NullPhysics::InitScene(BroadphaseType broadphase, double sceneSize, uint32_t maxObjects)
+{
+	if (_shapeCount)
+	{
+		Logger::Log(NULL_PHYS_MODULE, LOG_CRITICAL, "InitScene called with %u colliders alive", _shapeCount);
+		return ENGINE_FAIL;
+	}
+
+	_broadphase.Initialize(broadphase, (float)sceneSize);
+	_maxObjects = maxObjects;
+
+	Logger::Log(NULL_PHYS_MODULE, LOG_DEBUG, "Scene initialized with %s broadphase, %u regions",
+		broadphase == BroadphaseType::MBP ? "MBP" : "SAP", _broadphase.GetRegionCount());
+
+	return ENGINE_OK;
+}
+
+BoxCollider *NullPhysics::CreateBoxCollider(Object *parent, const vec3 &halfExtents)
+{
+	if (_maxObjects && _shapeCount >= _maxObjects) return nullptr;
+	return new NullBoxCollider(parent, halfExtents);
+}
+
+SphereCollider *NullPhysics::CreateSphereCollider(Object *parent, double radius)
+{
+	if (_maxObjects && _shapeCount >= _maxObjects) return nullptr;
+	return new NullSphereCollider(parent, radius);
+}
+
+CapsuleCollider *NullPhysics::CreateCapsuleCollider(Object *parent, double radius, double height)
+{
+	if (_maxObjects && _shapeCount >= _maxObjects) return nullptr;
+	return new NullCapsuleCollider(parent, radius, height);
+}
+
+MeshCollider *NullPhysics::CreateMeshCollider(Object *parent, const StaticMesh *mesh)
+{
+	if (_maxObjects && _shapeCount >= _maxObjects) return nullptr;
+	return new NullMeshCollider(parent, mesh);
+}
+
+void NullPhysics::AddShape(NullShape *shape)
+{
+	shape->proxy = _broadphase.AddProxy(shape->aabbMin, shape->aabbMax, shape);
+	++_shapeCount;
+}
+
+void NullPhysics::UpdateShape(NullShape *shape)
+{
+	shape->Update();
+	_broadphase.UpdateProxy(shape->proxy, shape->aabbMin, shape->aabbMax);
+}
+
+void NullPhysics::RemoveShape(NullShape *shape)
+{
+	_broadphase.RemoveProxy(shape->proxy);
+	--_shapeCount;
+}
+
+bool NullPhysics::RayCast(Ray *ray)
+{
+	vec3 direction{ ray->end - ray->start };
+	float best{ length(direction) };
+
+	if (best <= 0.f)
+		return false;
+
+	direction /= best;
+
+	const vec3 invDir{ 1.f / direction.x, 1.f / direction.y, 1.f / direction.z };
+	const NullShape *hitShape{ nullptr };
+	vec3 hitNormal{};
+
+	// Only the proxies overlapping the bounds of the segment can be hit
+	_broadphase.Query(glm::min(ray->start, ray->end), glm::max(ray->start, ray->end), _rayCandidates);
+	const vector<NullProxy> &proxies{ _broadphase.GetProxies() };
+
+	for (uint32_t id : _rayCandidates)
+	{
+		const NullProxy &proxy{ proxies[id] };
+
+		const vec3 t0{ (proxy.min - ray->start) * invDir }, t1{ (proxy.max - ray->start) * invDir };
+		const vec3 tmin{ glm::min(t0, t1) }, tmax{ glm::max(t0, t1) };
+		const float tEnter{ glm::max(glm::max(tmin.x, tmin.y), glm::max(tmin.z, 0.f)) };
+		const float tExit{ glm::min(glm::min(tmax.x, tmax.y), glm::min(tmax.z, best)) };
+
+		if (tEnter > tExit)
+			continue;
+
+		const NullShape *shape{ (const NullShape *)proxy.user };
+		float t{};
+		vec3 normal{};
+
+		if (!NullRayCast(*shape, ray->start, direction, best, t, normal))
+			continue;
+
+		best = t;
+		hitShape = shape;
+		hitNormal = normal;
+	}
+
+	if (!hitShape)
+		return false;
+
+	ray->hitPoint = ray->start + direction * best;
+	ray->hitNormal = hitNormal;
+	ray->hitObject = hitShape->object;
+
+	return true;
+}
+
+bool NullPhysics::ScreenRayCast(Ray *ray, vec2 &screenCoords, float distance)
+{
+	vec3 coords = vec3(screenCoords, 0.f);
+	vec4 viewport = vec4(0.f, 0.f, Engine::GetScreenWidth(), Engine::GetScreenHeight());
+
+	ray->start = unProject(coords, CameraManager::GetActiveCamera()->GetView(), CameraManager::GetActiveCamera()->GetProjectionMatrix(), viewport);
+	ray->end = ray->start + distance * CameraManager::GetActiveCamera()->GetForward();
+
+	return RayCast(ray);
+}
+
+bool NullPhysics::_IsCurrent(uint32_t proxy, uint32_t generation, const NullShape *shape) const noexcept
+{
+	const NullProxy &p{ _broadphase.GetProxies()[proxy] };
+	return p.alive && p.generation == generation && p.user == shape;
+}
+
+void NullPhysics::Update(double deltaTime)
+{
+	(void)deltaTime;
+
+	// Run the narrowphase before any callback. OnHit may add or remove
+	// colliders, which reallocates the proxies and reuses their slots.
+	const vector<NullProxy> &proxies{ _broadphase.GetProxies() };
+	_contacts.clear();
+
+	for (uint64_t pair : _broadphase.Update())
+	{
+		NullContact c{};
+		c.proxyA = (uint32_t)(pair >> 32);
+		c.proxyB = (uint32_t)pair;
+		c.generationA = proxies[c.proxyA].generation;
+		c.generationB = proxies[c.proxyB].generation;
+		c.a = (const NullShape *)proxies[c.proxyA].user;
+		c.b = (const NullShape *)proxies[c.proxyB].user;
+
+		if (!c.a || !c.b || c.a->object == c.b->object)
+			continue;
+
+		if (NullOverlap(*c.a, *c.b, c.pointA, c.pointB))
+			_contacts.push_back(c);
+	}
+
+	for (NullContact &c : _contacts)
+	{
+		// Colliders removed by an earlier callback are skipped
+		if (!_IsCurrent(c.proxyA, c.generationA, c.a) || !_IsCurrent(c.proxyB, c.generationB, c.b))
+			continue;
+
+		if (c.a->object) c.a->object->OnHit(c.b->object, c.pointA);
+
+		if (!_IsCurrent(c.proxyB, c.generationB, c.b) || !_IsCurrent(c.proxyA, c.generationA, c.a))
+			continue;
+
+		if (c.b->object) c.b->object->OnHit(c.a->object, c.pointB);
+	}
+}
 
-int NullPhysics::Initialize() { return ENGINE_OK; }
-int NullPhysics::InitScene(BroadphaseType broadphase, double sceneSize, uint32_t maxObjects) { return ENGINE_OK; }
-BoxCollider *NullPhysics::CreateBoxCollider(Object *parent, const glm::vec3 &halfExtents) { return new BoxCollider(parent, halfExtents); }
-SphereCollider *NullPhysics::CreateSphereCollider(Object *parent, double radius) { return new SphereCollider(parent, radius); }
-CapsuleCollider *NullPhysics::CreateCapsuleCollider(Object *parent, double radius, double height) { return new CapsuleCollider(parent, radius, height); }
-MeshCollider *NullPhysics::CreateMeshCollider(Object *parent, const StaticMesh *mesh) { return new MeshCollider(parent, mesh); }
-bool NullPhysics::RayCast(Ray *ray) { (void)ray; return false; }
-bool NullPhysics::ScreenRayCast(Ray *ray, glm::vec2 &screenCoords, float distance) { (void)ray; (void)screenCoords; (void)distance; return false; }
-void NullPhysics::Update(double deltaTime) { (void)deltaTime; }
 void NullPhysics::Release() { }
+
 NullPhysics::~NullPhysics() { }
 
 #if defined(_WIN32) || defined(_WIN64)
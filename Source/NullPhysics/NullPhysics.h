@@ -51,9 +51,28 @@
 
 #include <Physics/Physics.h>
 
+#include "NullBroadphase.h"
+
+struct NullShape;
+
+struct NullContact
+{
+	uint32_t proxyA, proxyB;
+	uint32_t generationA, generationB;
+	const NullShape *a, *b;
+	glm::vec3 pointA, pointB;
+};
+
+/**
+ * Built-in collision detection: sweep and prune broadphase, overlap tests
+ * for boxes, spheres and capsules and ray casts against every collider type.
+ * Overlapping colliders are reported through Object::OnHit every update.
+ */
 class NullPhysics : public Physics
 {
 public:
+	NullPhysics() : _shapeCount{ 0 }, _maxObjects{ 0 } { }
+
 	virtual int Initialize() override;
 	virtual int InitScene(BroadphaseType broadphase, double sceneSize, uint32_t maxObjects) override;
 	virtual BoxCollider *CreateBoxCollider(Object *parent, const glm::vec3 &halfExtents) override;
@@ -64,7 +83,20 @@ public:
 	virtual bool ScreenRayCast(Ray *ray, glm::vec2 &screenCoords, float distance) override;
 	virtual void Update(double deltaTime) override;
 	virtual void Release() override;
+
+	void AddShape(NullShape *shape);
+	void UpdateShape(NullShape *shape);
+	void RemoveShape(NullShape *shape);
+
 	virtual ~NullPhysics();
+
+private:
+	NullBroadphase _broadphase;
+	uint32_t _shapeCount, _maxObjects;
+	std::vector<NullContact> _contacts;
+	std::vector<uint32_t> _rayCandidates;
+
+	bool _IsCurrent(uint32_t proxy, uint32_t generation, const NullShape *shape) const noexcept;
 };
 
 #endif
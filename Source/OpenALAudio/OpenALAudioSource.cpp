@@ -104,6 +104,11 @@ void OpenALAudioSource::SetReferenceDistance(float referenceDistance) noexcept
 	alSourcef(_src, AL_REFERENCE_DISTANCE, referenceDistance);
 }
 
+void OpenALAudioSource::SetRolloffFactor(float rolloff) noexcept
+{
+	alSourcef(_src, AL_ROLLOFF_FACTOR, rolloff);
+}
+
 int OpenALAudioSource::SetClip(AudioClip *clip) noexcept
 {
 	if (!clip)
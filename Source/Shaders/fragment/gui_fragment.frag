@@ -47,12 +47,41 @@ layout(location = 0) out vec4 o_FragColor;
 
 layout(set = 1, binding = 0) uniform sampler2D u_texture;
 
+layout(push_constant) uniform FontEffects
+{
+	vec4 outlineColor;
+	vec4 shadowColor;
+	vec2 shadowOffset;
+	float outlineWidth;
+	float softness;
+} effects;
+
 layout(constant_id = 0) const int shaderType = 0;
 
 void main()
 {
 	if(shaderType == 0)
 		o_FragColor = texture(u_texture, v_uv) + v_color;
-	else
+	else if(shaderType == 1)
 		o_FragColor = vec4(v_color.xyz, texture(u_texture, v_uv).r);
+	else
+	{
+		// Distance field: 0.5 is the edge, antialiased over one screen pixel
+		float dist = texture(u_texture, v_uv).r;
+		float aa = fwidth(dist) * 0.5;
+
+		float fill = smoothstep(0.5 - aa, 0.5 + aa, dist);
+		float outline = smoothstep(0.5 - effects.outlineWidth - aa, 0.5 - effects.outlineWidth + aa, dist);
+
+		vec3 color = mix(effects.outlineColor.rgb, v_color.rgb, fill);
+		float alpha = mix(outline * effects.outlineColor.a, 1.0, fill);
+
+		float shadowDist = texture(u_texture, v_uv - effects.shadowOffset).r;
+		float shadow = smoothstep(0.5 - effects.softness - aa, 0.5 + aa, shadowDist) * effects.shadowColor.a;
+
+		float outAlpha = alpha + shadow * (1.0 - alpha);
+		vec3 outColor = (color * alpha + effects.shadowColor.rgb * shadow * (1.0 - alpha)) / max(outAlpha, 0.0001);
+
+		o_FragColor = vec4(outColor, outAlpha);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,155 @@
+/* NekoEngine
+ *
+ * AnimationCompressorRuntime.cpp
+ * Author: Alexandru Naiman
+ *
+ * Runtime side of the animation compressor test
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <memory>
+#include <string.h>
+
+#include <System/VFS/VFS.h>
+#include <System/AssetLoader/AssetLoader.h>
+#include <Animation/AnimationSampler.h>
+
+#include "AnimationTest.h"
+#include "AnimationCompressorTest.h"
+
+using namespace std;
+using namespace glm;
+
+/**
+ * Served by the VFS::Open stub below, holding the file as GZipFile would
+ * return it
+ */
+class TestRuntimeFile : public VFSFile
+{
+public:
+	TestRuntimeFile() : VFSFile(FileType::Loose), _pos{ 0 } { }
+
+	virtual bool IsOpen() override { return true; }
+	virtual bool IsReadonly() override { return true; }
+	virtual int Open() override { _pos = 0; return ENGINE_OK; }
+	virtual int Create() override { return ENGINE_FAIL; }
+
+	virtual size_t Read(void *buffer, size_t size, size_t count) override
+	{
+		const size_t n{ glm::min(count, (_data.size() - _pos) / size) };
+		memcpy(buffer, _data.data() + _pos, n * size);
+		_pos += n * size;
+		return n;
+	}
+
+	virtual char *Gets(char *str, int num) override { return nullptr; }
+	virtual size_t Write(void *buffer, size_t size, size_t count) override { return 0; }
+
+	virtual int Seek(size_t offset, int origin) override
+	{
+		if (origin == SEEK_END)
+			_pos = _data.size() + offset;
+		else if (origin == SEEK_CUR)
+			_pos += offset;
+		else
+			_pos = offset;
+
+		_pos = glm::min(_pos, _data.size());
+		return ENGINE_OK;
+	}
+
+	virtual size_t Tell() override { return _pos; }
+	virtual bool EoF() override { return _pos >= _data.size(); }
+	virtual void Close() override { }
+
+	vector<uint8_t> &Data() noexcept { return _data; }
+
+private:
+	vector<uint8_t> _data;
+	size_t _pos;
+};
+
+static TestRuntimeFile _acr_file;
+static unique_ptr<Skeleton> _acr_skeleton;
+static unique_ptr<TestClip> _acr_clip;
+static AnimationSampler _acr_sampler;
+static SkeletonPose _acr_pose;
+
+VFSFile *VFS::Open(NString &path)
+{
+	_acr_file.Open();
+	return &_acr_file;
+}
+
+int TestRuntimeLoad(const vector<uint8_t> &data, uint32_t &channelCount)
+{
+	NString path{ "test.nanim" };
+	string name;
+	double duration{ 0.0 }, ticksPerSecond{ 0.0 };
+	vector<AnimationNode> channels;
+
+	_acr_file.Data() = data;
+	_acr_sampler.Bind(nullptr, nullptr);
+
+	const int ret{ AssetLoader::LoadAnimation(path, name, &duration, &ticksPerSecond, channels) };
+
+	channelCount = (uint32_t)channels.size();
+	if (ret != ENGINE_OK || !channelCount)
+		return ret;
+
+	vector<Bone> bones;
+	vector<TransformNode> nodes;
+	dmat4 globalInverse{ 1.0 };
+
+	TestBuildHierarchy((uint16_t)channelCount, bones, nodes);
+	_acr_skeleton.reset(new Skeleton(bones, nodes, globalInverse));
+
+	_acr_clip.reset(new TestClip(duration, ticksPerSecond));
+	_acr_clip->Channels() = move(channels);
+
+	_acr_sampler.Bind(_acr_skeleton.get(), _acr_clip.get());
+
+	return ret;
+}
+
+void TestRuntimeSample(uint32_t channel, double time, vec3 &position, quat &rotation, vec3 &scaling)
+{
+	const int16_t node{ _acr_skeleton->GetNodeIndex(*_acr_clip->Channels()[channel].name) };
+
+	_acr_pose.CopyFrom(_acr_skeleton->GetBindPose());
+	_acr_sampler.Sample(time, _acr_pose);
+
+	position = _acr_pose.translations[node];
+	rotation = _acr_pose.rotations[node];
+	scaling = _acr_pose.scales[node];
+}
@@ -0,0 +1,400 @@
+/* NekoEngine
+ *
+ * AnimationCompressorTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * ModelImporter animation compressor tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <random>
+#include <string>
+#include <zlib.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <AnimationCompressor.h>
+
+#include "AnimationCompressorTest.h"
+#include "Test.h"
+
+#define ACT_KEYS			241
+#define ACT_ROUND_TRIPS		10000
+#define ACT_QUAT_ERROR		2e-4
+#define ACT_SLACK			1.01
+
+using namespace std;
+using namespace glm;
+
+static mt19937 _act_rng{ 28 };
+
+static double _act_Random(double min, double max)
+{
+	return uniform_real_distribution<double>(min, max)(_act_rng);
+}
+
+static double _act_Angle(const dquat &a, const dquat &b)
+{
+	return 2.0 * acos(glm::min(fabs(dot(normalize(a), normalize(b))), 1.0));
+}
+
+/**
+ * Smooth motion sampled once per tick, as the importer receives it
+ */
+static AnimationNode _act_Channel(const string &name, double phase)
+{
+	AnimationNode channel;
+	channel.name = name;
+
+	for (uint32_t k = 0; k < ACT_KEYS; ++k)
+	{
+		const double t{ (double)k };
+		channel.positionKeys.push_back({ dvec3(sin(t * .005 + phase) * 2.0, t * .01, cos(t * .004 + phase)), t });
+		channel.rotationKeys.push_back({ angleAxis(sin(t * .005 + phase) * 2.0, normalize(dvec3(1.0, phase, .5))), t });
+		channel.scalingKeys.push_back({ dvec3(1.0 + .2 * sin(t * .004 + phase)), t });
+	}
+
+	return channel;
+}
+
+static vector<uint8_t> _act_Inflate(const string &file)
+{
+	vector<uint8_t> data;
+	uint8_t buff[4096];
+	int read{ 0 };
+
+	gzFile fp{ gzopen(file.c_str(), "rb") };
+	if (!fp)
+		return data;
+
+	while ((read = gzread(fp, buff, sizeof(buff))) > 0)
+		data.insert(data.end(), buff, buff + read);
+
+	gzclose(fp);
+	return data;
+}
+
+/**
+ * Write channels with the importer's NANIM3 writer and read the file back
+ */
+static vector<uint8_t> _act_Export(const vector<AnimationNode> &channels, vector<ChannelError> &errors)
+{
+	char root[] = "/tmp/animcompressor_XXXXXX";
+	TEST_CHECK(mkdtemp(root) != nullptr);
+
+	const string file{ string(root) + "/clip.nanim" };
+
+	AnimationCompressor().Export(file.c_str(), ACT_KEYS - 1, 25.0, channels, errors);
+	vector<uint8_t> data{ _act_Inflate(file) };
+
+	unlink(file.c_str());
+	rmdir(root);
+
+	return data;
+}
+
+static void _act_TestVectorRoundTrip()
+{
+	for (uint32_t i = 0; i < ACT_ROUND_TRIPS; ++i)
+	{
+		const vec3 min{ _act_Random(-100.0, 100.0), _act_Random(-1.0, 1.0), 0.f };
+		const vec3 extent{ _act_Random(.001, 200.0), _act_Random(.001, 2.0), 0.f };
+		const vec3 v{ min + extent * vec3(_act_Random(0.0, 1.0), _act_Random(0.0, 1.0), 0.f) };
+		uint16_t encoded[3];
+
+		AnimEncodeVector(v, min, extent, encoded);
+		const vec3 decoded{ AnimDecodeVector(encoded, min, extent) };
+
+		// Half a quantization step, plus float rounding
+		for (int c = 0; c < 2; ++c)
+			TEST_CHECK(fabsf(decoded[c] - v[c]) <= extent[c] / ANIM_RANGE_MAX * .51f + fabsf(v[c]) * 1e-6f);
+
+		// Axes without extent decode to min
+		TEST_CHECK(encoded[2] == 0 && decoded[2] == min[2]);
+	}
+}
+
+static void _act_TestQuatRoundTrip()
+{
+	for (uint32_t i = 0; i < ACT_ROUND_TRIPS; ++i)
+	{
+		const quat q{ normalize(quat((float)_act_Random(-1.0, 1.0), (float)_act_Random(-1.0, 1.0), (float)_act_Random(-1.0, 1.0), (float)_act_Random(-1.0, 1.0))) };
+		uint16_t a[3], b[3];
+
+		AnimEncodeQuat(q, a);
+		AnimEncodeQuat(-q, b);
+
+		// q and -q are the same rotation and encode the same
+		TEST_CHECK(a[0] == b[0] && a[1] == b[1] && a[2] == b[2]);
+
+		const quat decoded{ AnimDecodeQuat(a) };
+		TEST_CHECK(fabsf(length(decoded) - 1.f) < 1e-4f);
+		TEST_CHECK(_act_Angle(decoded, q) < ACT_QUAT_ERROR);
+	}
+}
+
+/**
+ * Every source key is reproduced within tolerance by sampling the
+ * compressed tracks, with a cursor that plays forward and with a fresh one
+ */
+static void _act_CheckChannel(const AnimationNode &source, const CompressedChannel &compressed)
+{
+	uint32_t position{ 0 }, rotation{ 0 }, scaling{ 0 };
+
+	for (uint32_t k = 0; k < ACT_KEYS; ++k)
+	{
+		const double t{ source.positionKeys[k].time };
+		uint32_t fresh{ 0 };
+
+		TEST_CHECK(distance((dvec3)AnimSampleTrack(compressed.position, t, position), source.positionKeys[k].value) <= ANIM_POSITION_ERROR * ACT_SLACK);
+		TEST_CHECK(_act_Angle((dquat)AnimSampleTrack(compressed.rotation, t, rotation), source.rotationKeys[k].value) <= ANIM_ROTATION_ERROR * ACT_SLACK);
+		TEST_CHECK(distance((dvec3)AnimSampleTrack(compressed.scaling, t, scaling), source.scalingKeys[k].value) <= ANIM_SCALE_ERROR * ACT_SLACK);
+		TEST_CHECK(AnimSampleTrack(compressed.position, t, fresh) == AnimSampleTrack(compressed.position, t, position));
+	}
+}
+
+static void _act_TestReduction()
+{
+	const AnimationNode source{ _act_Channel("n0", .3) };
+	CompressedChannel out;
+	ChannelError error;
+
+	AnimationCompressor().Compress(source, out, error);
+
+	TEST_CHECK(out.position.type == ANIM_TRACK_QUANTIZED);
+	TEST_CHECK(out.rotation.type == ANIM_TRACK_QUANTIZED);
+	TEST_CHECK(out.scaling.type == ANIM_TRACK_QUANTIZED);
+
+	// Smooth motion needs far fewer keys than one per tick
+	TEST_CHECK(out.position.times.size() > 2 && out.position.times.size() < ACT_KEYS / 2);
+	TEST_CHECK(out.rotation.times.size() > 2 && out.rotation.times.size() < ACT_KEYS / 2);
+	TEST_CHECK(out.scaling.times.size() > 2 && out.scaling.times.size() < ACT_KEYS / 2);
+	TEST_CHECK(error.sourceKeys == ACT_KEYS * 3);
+	TEST_CHECK(error.keys == out.position.times.size() + out.rotation.times.size() + out.scaling.times.size());
+
+	// The reported error is measured the way the engine samples
+	TEST_CHECK(error.position <= ANIM_POSITION_ERROR * ACT_SLACK);
+	TEST_CHECK(error.rotation <= ANIM_ROTATION_ERROR * ACT_SLACK);
+	TEST_CHECK(error.scaling <= ANIM_SCALE_ERROR * ACT_SLACK);
+
+	_act_CheckChannel(source, out);
+
+	// Looser tolerances keep fewer keys
+	CompressedChannel loose;
+	AnimationCompressor(ANIM_POSITION_ERROR * 100.0, ANIM_ROTATION_ERROR * 100.0, ANIM_SCALE_ERROR * 100.0).Compress(source, loose, error);
+	TEST_CHECK(loose.position.times.size() < out.position.times.size());
+	TEST_CHECK(loose.rotation.times.size() < out.rotation.times.size());
+	TEST_CHECK(error.position <= ANIM_POSITION_ERROR * 100.0 * ACT_SLACK);
+
+	// Uniform motion along a line only needs its end points
+	AnimationNode line{ source };
+	for (uint32_t k = 0; k < ACT_KEYS; ++k)
+		line.positionKeys[k].value = dvec3(k * .01, 1.0 - k * .002, .5);
+
+	AnimationCompressor().Compress(line, out, error);
+	TEST_CHECK(out.position.type == ANIM_TRACK_QUANTIZED && out.position.times.size() == 2);
+	TEST_CHECK(error.position <= ANIM_POSITION_ERROR);
+}
+
+static void _act_TestConstantTracks()
+{
+	AnimationNode source{ _act_Channel("n1", 1.1) };
+	CompressedChannel out;
+	ChannelError error;
+
+	// Noise below the tolerance is a constant track
+	for (VectorKey &key : source.positionKeys)
+		key.value = dvec3(1.0, 2.0, 3.0) + dvec3(_act_Random(-1.0, 1.0), _act_Random(-1.0, 1.0), 0.0) * ANIM_POSITION_ERROR * .4;
+
+	// Tracks at the bind pose are stripped
+	for (VectorKey &key : source.scalingKeys)
+		key.value = dvec3(1.0);
+
+	AnimationCompressor compressor;
+	compressor.SetBindPose("n1", { dvec3(0.0), dquat(1.0, 0.0, 0.0, 0.0), dvec3(1.0) });
+	compressor.Compress(source, out, error);
+
+	TEST_CHECK(out.position.type == ANIM_TRACK_CONSTANT && out.position.times.empty());
+	TEST_CHECK(distance((dvec3)out.position.min, dvec3(1.0, 2.0, 3.0)) <= ANIM_POSITION_ERROR);
+	TEST_CHECK(out.rotation.type == ANIM_TRACK_QUANTIZED);
+	TEST_CHECK(out.scaling.type == ANIM_TRACK_DEFAULT);
+	TEST_CHECK(error.position <= ANIM_POSITION_ERROR && error.scaling == 0.0);
+
+	// Without a bind pose the same track is kept as a constant
+	AnimationCompressor().Compress(source, out, error);
+	TEST_CHECK(out.scaling.type == ANIM_TRACK_CONSTANT && out.scaling.min == vec3(1.f));
+
+	// A channel without keys leaves the node at its bind pose
+	AnimationNode empty;
+	empty.name = "n2";
+	AnimationCompressor().Compress(empty, out, error);
+	TEST_CHECK(out.position.type == ANIM_TRACK_DEFAULT && out.rotation.type == ANIM_TRACK_DEFAULT && out.scaling.type == ANIM_TRACK_DEFAULT);
+}
+
+/**
+ * The engine loads the file the importer writes and AnimationSampler
+ * reproduces the importer's own sampling of the compressed tracks
+ */
+static void _act_TestRuntime()
+{
+	vector<AnimationNode> channels{ _act_Channel("n0", .3), _act_Channel("n1", 2.0) };
+	vector<ChannelError> errors;
+
+	for (VectorKey &key : channels[1].positionKeys)
+		key.value = dvec3(0.0, 1.0, 0.0);
+
+	const vector<uint8_t> data{ _act_Export(channels, errors) };
+	TEST_CHECK(errors.size() == channels.size());
+
+	uint32_t count{ 0 };
+	TEST_CHECK(TestRuntimeLoad(data, count) == ENGINE_OK);
+	TEST_CHECK(count == channels.size());
+
+	if (count != channels.size())
+		return;
+
+	for (uint32_t c = 0; c < count; ++c)
+	{
+		CompressedChannel compressed;
+		ChannelError error;
+		uint32_t position{ 0 }, rotation{ 0 }, scaling{ 0 };
+
+		AnimationCompressor().Compress(channels[c], compressed, error);
+
+		// Between and on the keys, forward then once more from the start
+		for (double t = 0.0; t < 2.0 * (ACT_KEYS - 1); t += .37)
+		{
+			const double time{ fmod(t, ACT_KEYS - 1.0) };
+			vec3 p, s;
+			quat r;
+
+			TestRuntimeSample(c, time, p, r, s);
+
+			if (compressed.position.type == ANIM_TRACK_CONSTANT)
+				TEST_CHECK(p == compressed.position.min);
+			else
+				TEST_CHECK(p == AnimSampleTrack(compressed.position, time, position));
+
+			TEST_CHECK(r == AnimSampleTrack(compressed.rotation, time, rotation));
+			TEST_CHECK(s == AnimSampleTrack(compressed.scaling, time, scaling));
+		}
+
+		for (uint32_t k = 0; k < ACT_KEYS; ++k)
+		{
+			vec3 p, s;
+			quat r;
+
+			TestRuntimeSample(c, k, p, r, s);
+			TEST_CHECK(distance((dvec3)p, channels[c].positionKeys[k].value) <= ANIM_POSITION_ERROR * ACT_SLACK);
+			TEST_CHECK(_act_Angle((dquat)r, channels[c].rotationKeys[k].value) <= ANIM_ROTATION_ERROR * ACT_SLACK);
+			TEST_CHECK(distance((dvec3)s, channels[c].scalingKeys[k].value) <= ANIM_SCALE_ERROR * ACT_SLACK);
+		}
+	}
+}
+
+static int _act_Load(vector<uint8_t> data)
+{
+	uint32_t count{ 0 };
+	const int ret{ TestRuntimeLoad(data, count) };
+
+	// Rejected files leave no channels behind
+	if (ret != ENGINE_OK)
+		TEST_CHECK(count == 0);
+
+	return ret;
+}
+
+static void _act_TestValidation()
+{
+	// A short clip, so that every truncation can be tried
+	AnimationNode channel;
+	vector<ChannelError> errors;
+
+	channel.name = "n0";
+	for (uint32_t k = 0; k < 4; ++k)
+	{
+		channel.positionKeys.push_back({ dvec3(k * k, 0.0, 0.0), (double)k });
+		channel.rotationKeys.push_back({ angleAxis(k * k * .1, dvec3(0.0, 1.0, 0.0)), (double)k });
+	}
+	channel.scalingKeys.push_back({ dvec3(2.0), 0.0 });
+
+	const vector<uint8_t> data{ _act_Export({ channel }, errors) };
+
+	// magic, name length, duration, ticks per second, channel count, channel name length, "n0"
+	const size_t channelsOffset{ 7 + 4 + 8 + 8 }, positionOffset{ channelsOffset + 4 + 4 + 2 };
+
+	TEST_CHECK(data.size() > positionOffset + 5);
+	TEST_CHECK(!memcmp(data.data(), ANIM_COMPRESSED_HEADER, 7));
+	TEST_CHECK(data[positionOffset] == ANIM_TRACK_QUANTIZED);
+	TEST_CHECK(_act_Load(data) == ENGINE_OK);
+
+	vector<uint8_t> bad{ data };
+	bad[0] = 'X';
+	TEST_CHECK(_act_Load(bad) == ENGINE_INVALID_HEADER);
+
+	// Unknown track type
+	bad = data;
+	bad[positionOffset] = ANIM_TRACK_QUANTIZED + 1;
+	TEST_CHECK(_act_Load(bad) == ENGINE_INVALID_RES);
+
+	// Key and channel counts larger than the file
+	bad = data;
+	memset(&bad[positionOffset + 1], 0xFF, sizeof(uint32_t));
+	TEST_CHECK(_act_Load(bad) == ENGINE_INVALID_RES);
+
+	bad = data;
+	memset(&bad[channelsOffset], 0xFF, sizeof(uint32_t));
+	TEST_CHECK(_act_Load(bad) == ENGINE_INVALID_RES);
+
+	// Only a missing footer is accepted, with a warning
+	for (size_t size = 0; size < data.size() - 7; ++size)
+		TEST_CHECK(_act_Load(vector<uint8_t>(data.begin(), data.begin() + size)) != ENGINE_OK);
+
+	const uint32_t warnings{ Test::GetLogCount(LOG_WARNING) };
+	TEST_CHECK(_act_Load(vector<uint8_t>(data.begin(), data.end() - 7)) == ENGINE_OK);
+	TEST_CHECK(Test::GetLogCount(LOG_WARNING) == warnings + 1);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_act_TestVectorRoundTrip();
+	_act_TestQuatRoundTrip();
+	_act_TestReduction();
+	_act_TestConstantTracks();
+	_act_TestRuntime();
+	_act_TestValidation();
+
+	return Test::Result();
+}
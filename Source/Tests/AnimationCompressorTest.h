@@ -0,0 +1,63 @@
+/* NekoEngine
+ *
+ * AnimationCompressorTest.h
+ * Author: Alexandru Naiman
+ *
+ * Runtime side of the animation compressor test
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <Engine/Defs.h>
+
+/*
+ * The importer and the engine both define AnimationClip and AnimationNode, so
+ * the engine side lives in AnimationCompressorRuntime.cpp and only plain
+ * types cross between the two.
+ */
+
+/**
+ * Load an inflated animation file with AssetLoader::LoadAnimation and bind
+ * its channels to a skeleton whose nodes are named n0, n1...
+ * Returns the loader's result; channelCount is 0 if the file was rejected.
+ */
+int TestRuntimeLoad(const std::vector<uint8_t> &data, uint32_t &channelCount);
+
+/**
+ * Sample the loaded clip with AnimationSampler at time (in ticks) and
+ * return the local transform of node n<channel>.
+ */
+void TestRuntimeSample(uint32_t channel, double time, glm::vec3 &position, glm::quat &rotation, glm::vec3 &scaling);
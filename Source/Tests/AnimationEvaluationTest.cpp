@@ -0,0 +1,283 @@
+/* NekoEngine
+ *
+ * AnimationEvaluationTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Animator scheduling and parallel evaluation tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <memory>
+#include <algorithm>
+
+#include <Engine/Engine.h>
+#include <Engine/TaskManager.h>
+#include <Scene/Camera.h>
+#include <Animation/AnimationManager.h>
+
+#include "AnimatorTest.h"
+#include "Test.h"
+
+#define AET_NODES			60
+#define AET_DURATION		100.0
+#define AET_TICKS			25.0
+#define AET_DELTA			(1.0 / 60.0)
+#define AET_LOD1			20.f
+#define AET_LOD2			40.f
+#define AET_ANIMATORS		64
+#define AET_WINDOW			8
+#define AET_CHARACTERS		1000
+#define AET_FRAMES			100
+
+using namespace std;
+using namespace glm;
+
+// The camera looks down +X; the last level is behind it
+static const float _aet_distance[ANIM_LOD_COUNT]{ 10.f, 30.f, 60.f, -30.f };
+
+struct AetRig
+{
+	AetRig() : globalInverse{ 1.0 }, clip{ AET_DURATION, AET_TICKS }
+	{
+		TestBuildHierarchy(AET_NODES, bones, nodes);
+		TestBuildClip(clip, nodes, 5);
+	}
+
+	Skeleton *NewSkeleton()
+	{
+		Skeleton *skeleton{ new Skeleton(bones, nodes, globalInverse) };
+		skeleton->Load();
+		return skeleton;
+	}
+
+	vector<Bone> bones;
+	vector<TransformNode> nodes;
+	dmat4 globalInverse;
+	TestClip clip;
+};
+
+struct AetCharacters
+{
+	~AetCharacters()
+	{
+		for (Object *obj : objects)
+			delete obj;
+	}
+
+	void Add(AetRig &rig, float distance)
+	{
+		TestAnimator *animator{ nullptr };
+		objects.push_back(TestNewAnimatedObject(vec3(distance, 0.f, 0.f), rig.NewSkeleton(), &rig.clip, &animator));
+		animators.push_back(animator);
+	}
+
+	vector<Object *> objects;
+	vector<TestAnimator *> animators;
+};
+
+// Same order as the engine: scene update, evaluation, upload
+static void _aet_Frame(AetCharacters &characters)
+{
+	for (Object *obj : characters.objects)
+		obj->Update(AET_DELTA);
+
+	AnimationManager::Update();
+	AnimationManager::UpdateData(VK_NULL_HANDLE);
+}
+
+/*
+ * Animators are placed at each level of detail in blocks of consecutive frame
+ * offsets. Over AET_WINDOW frames each one must be evaluated once per interval,
+ * spread evenly over the frames, and write what serial evaluation writes.
+ */
+static void _aet_TestScheduling()
+{
+	const uint32_t perLevel{ AET_ANIMATORS / ANIM_LOD_COUNT };
+
+	AetRig rig;
+	AetCharacters characters;
+
+	for (uint32_t i = 0; i < AET_ANIMATORS; ++i)
+		characters.Add(rig, _aet_distance[i / perLevel]);
+
+	unique_ptr<Skeleton> full{ rig.NewSkeleton() }, reduced{ rig.NewSkeleton() };
+	full->SetAnimationClip(&rig.clip);
+	reduced->SetAnimationClip(&rig.clip);
+	reduced->SetReducedDetail(true);
+
+	for (uint32_t f = 0; f < AET_WINDOW; ++f)
+		_aet_Frame(characters);
+
+	vector<TrMat> previous(AET_NODES * AET_ANIMATORS);
+	vector<uint32_t> evaluations(AET_ANIMATORS);
+
+	for (uint32_t f = 0; f < AET_WINDOW; ++f)
+	{
+		for (uint32_t i = 0; i < AET_ANIMATORS; ++i)
+			memcpy(&previous[AET_NODES * i], TestGetBones(*characters.animators[i]->GetSkeleton()), sizeof(TrMat) * AET_NODES);
+
+		const uint32_t uploads{ TestGetUpload().count };
+		_aet_Frame(characters);
+
+		uint32_t dirtyBegin{ UINT32_MAX }, dirtyEnd{ 0 };
+		uint32_t evaluated[ANIM_LOD_COUNT]{};
+
+		for (uint32_t i = 0; i < AET_ANIMATORS; ++i)
+		{
+			TestAnimator *animator{ characters.animators[i] };
+			const Skeleton *skeleton{ animator->GetSkeleton() };
+			const uint8_t lod{ (uint8_t)(i / perLevel) };
+
+			TEST_CHECK(animator->GetLOD() == lod);
+
+			if (!memcmp(&previous[AET_NODES * i], TestGetBones(*skeleton), sizeof(TrMat) * AET_NODES))
+				continue;
+
+			Skeleton *reference{ lod >= ANIM_LOD_REDUCED ? reduced.get() : full.get() };
+			reference->TransformBones(animator->GetTime());
+			TEST_CHECK(!memcmp(TestGetBones(*reference), TestGetBones(*skeleton), sizeof(TrMat) * AET_NODES));
+
+			dirtyBegin = std::min(dirtyBegin, skeleton->GetPaletteOffset());
+			dirtyEnd = std::max(dirtyEnd, skeleton->GetPaletteOffset() + skeleton->GetBoneCount());
+
+			++evaluations[i];
+			++evaluated[lod];
+		}
+
+		for (uint8_t lod = 0; lod < ANIM_LOD_COUNT; ++lod)
+			TEST_CHECK(evaluated[lod] == perLevel >> lod);
+
+		// One upload of the range covering the evaluated skeletons
+		const TestUpload &upload{ TestGetUpload() };
+		TEST_CHECK(upload.count == uploads + 1);
+		TEST_CHECK(upload.buffer == AnimationManager::GetPaletteBuffer());
+		TEST_CHECK(upload.offset == sizeof(TrMat) * dirtyBegin);
+		TEST_CHECK(upload.size == sizeof(TrMat) * (dirtyEnd - dirtyBegin));
+	}
+
+	for (uint32_t i = 0; i < AET_ANIMATORS; ++i)
+	{
+		TEST_CHECK(evaluations[i] == (uint32_t)AET_WINDOW >> (i / perLevel));
+		TEST_CHECK(!(characters.animators[i]->GetSkeleton()->GetPaletteOffset() % 4));
+	}
+
+	// Nothing left to upload
+	const uint32_t uploads{ TestGetUpload().count };
+	AnimationManager::UpdateData(VK_NULL_HANDLE);
+	TEST_CHECK(TestGetUpload().count == uploads);
+
+	// Hidden animators that come into view are evaluated on the next frame,
+	// not on their turn at the new level
+	for (uint32_t i = perLevel * ANIM_LOD_HIDDEN; i < AET_ANIMATORS; ++i)
+	{
+		memcpy(&previous[AET_NODES * i], TestGetBones(*characters.animators[i]->GetSkeleton()), sizeof(TrMat) * AET_NODES);
+
+		vec3 position{ _aet_distance[ANIM_LOD_HALF], 0.f, 0.f };
+		NBounds bounds{};
+		bounds.InitBox(position - vec3(1.f), position + vec3(1.f));
+
+		characters.objects[i]->SetPosition(position);
+		characters.objects[i]->SetBounds(bounds);
+	}
+
+	_aet_Frame(characters);
+
+	for (uint32_t i = perLevel * ANIM_LOD_HIDDEN; i < AET_ANIMATORS; ++i)
+	{
+		TEST_CHECK(characters.animators[i]->GetLOD() == ANIM_LOD_HALF);
+		TEST_CHECK(memcmp(&previous[AET_NODES * i], TestGetBones(*characters.animators[i]->GetSkeleton()), sizeof(TrMat) * AET_NODES));
+	}
+}
+
+static void _aet_Benchmark()
+{
+	const struct { const char *name; bool lod; } runs[]
+	{
+		{ "full detail", false },
+		{ "lod", true }
+	};
+
+	printf("%d characters of %d nodes, %u workers\n", AET_CHARACTERS, AET_NODES, TaskManager::GetWorkerCount());
+
+	for (const auto &run : runs)
+	{
+		AetRig rig;
+		AetCharacters characters;
+
+		for (uint32_t i = 0; i < AET_CHARACTERS; ++i)
+			characters.Add(rig, _aet_distance[run.lod ? i % ANIM_LOD_COUNT : ANIM_LOD_FULL]);
+
+		double start{ Test::Time() };
+
+		for (uint32_t f = 0; f < AET_FRAMES; ++f)
+			_aet_Frame(characters);
+
+		printf("\t%-16s %.3f ms per frame\n", run.name, (Test::Time() - start) / AET_FRAMES);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	Configuration &config{ Engine::GetConfiguration() };
+	config.Engine.ScreenWidth = 1280;
+	config.Engine.ScreenHeight = 720;
+	config.Animation.MaxBones = 1 << 17;
+	config.Animation.LOD1Distance = AET_LOD1;
+	config.Animation.LOD2Distance = AET_LOD2;
+
+	// Use workers even on single core machines so evaluation runs threaded
+	config.Engine.WorkerThreads = 4;
+	TaskManager::Initialize();
+
+	if (AnimationManager::Initialize() != ENGINE_OK)
+		return 1;
+
+	Camera camera{};
+	camera.UpdateProjection();
+	camera.UpdateView();
+
+	TestLoadScene();
+
+	_aet_TestScheduling();
+
+	if (Test::Benchmark())
+		_aet_Benchmark();
+
+	AnimationManager::Release();
+	TaskManager::Release();
+
+	return Test::Result();
+}
@@ -0,0 +1,272 @@
+/* NekoEngine
+ *
+ * AnimationGraphTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Animation graph tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <Animation/AnimationGraph.h>
+
+#include "AnimationTest.h"
+#include "Test.h"
+
+#define AGT_TOLERANCE	1e-4f
+
+using namespace std;
+using namespace glm;
+
+// Chain n0 -> n1 -> n2 with identity bind transforms
+static void _agt_BuildChain(vector<Bone> &bones, vector<TransformNode> &nodes)
+{
+	bones.resize(3);
+	nodes.resize(3);
+
+	for (uint16_t i = 0; i < 3; ++i)
+	{
+		nodes[i].name = "n" + to_string(i);
+		nodes[i].parentId = (int16_t)i - 1;
+		nodes[i].transform = dmat4(1.0);
+
+		if (i < 2)
+		{
+			nodes[i].childrenIds.push_back(i + 1);
+			nodes[i].numChildren = 1;
+		}
+
+		bones[i].name = nodes[i].name;
+		bones[i].offset = dmat4(1.0);
+	}
+}
+
+// Constant pose: node i at position * (i + 1), rotated by angle around Y
+static void _agt_BuildPose(TestClip &clip, vec3 position, float angle)
+{
+	vector<AnimationNode> &channels{ clip.Channels() };
+	channels.resize(3);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const string name{ "n" + to_string(i) };
+		channels[i].name = name.c_str();
+		channels[i].positionKeys.push_back({ dvec3(position) * (double)(i + 1), 0.0 });
+		channels[i].positionKeys.push_back({ dvec3(position) * (double)(i + 1), clip.GetDuration() });
+		channels[i].rotationKeys.push_back({ angleAxis((double)angle, dvec3(0.0, 1.0, 0.0)), 0.0 });
+		channels[i].scalingKeys.push_back({ dvec3(1.0), 0.0 });
+	}
+}
+
+static bool _agt_Near(const vec3 &a, const vec3 &b)
+{
+	return length(a - b) < AGT_TOLERANCE;
+}
+
+static void _agt_TestBlendNodes()
+{
+	vector<Bone> bones;
+	vector<TransformNode> nodes;
+	_agt_BuildChain(bones, nodes);
+
+	dmat4 globalInverse{ 1.0 };
+	Skeleton skeleton{ bones, nodes, globalInverse };
+	TEST_CHECK(skeleton.Load() == ENGINE_OK);
+
+	TestClip a{ 10.0, 1.0 }, b{ 10.0, 1.0 };
+	_agt_BuildPose(a, vec3(1.f, 0.f, 0.f), 0.f);
+	_agt_BuildPose(b, vec3(0.f, 2.f, 0.f), 1.f);
+
+	AnimationGraph graph{ &skeleton };
+	SkeletonPose pose;
+	pose.Resize(3);
+
+	// Lerp at 25%; rotation is the normalized lerp of the two quaternions
+	AnimationLerpNode *lerp{ graph.AddLerp(graph.AddClip(&a), graph.AddClip(&b), "w") };
+	graph.SetRoot(lerp);
+	graph.SetParameter(graph.GetParameterId("w"), .25f);
+	graph.Update(.1);
+	graph.Evaluate(pose);
+
+	TEST_CHECK(_agt_Near(pose.translations[0], vec3(.75f, .5f, 0.f)));
+	TEST_CHECK(_agt_Near(pose.translations[2], vec3(2.25f, 1.5f, 0.f)));
+	TEST_CHECK(fabsf(angle(pose.rotations[0]) - 2.f * atanf(.25f * sinf(.5f) / (.75f + .25f * cosf(.5f)))) < AGT_TOLERANCE);
+
+	// Additive: a plus the difference between b and the identity bind pose
+	graph.SetRoot(graph.AddAdditive(graph.AddClip(&a), graph.AddClip(&b)));
+	graph.Evaluate(pose);
+
+	TEST_CHECK(_agt_Near(pose.translations[1], vec3(2.f, 4.f, 0.f)));
+	TEST_CHECK(fabsf(angle(pose.rotations[1]) - 1.f) < 1e-3f);
+
+	// Mask from n1: n0 keeps a, n1 and n2 take b
+	AnimationMaskNode *mask{ graph.AddMask(graph.AddClip(&a), graph.AddClip(&b), "n1") };
+	TEST_CHECK(mask != nullptr);
+	graph.SetRoot(mask);
+	graph.Evaluate(pose);
+
+	TEST_CHECK(_agt_Near(pose.translations[0], vec3(1.f, 0.f, 0.f)));
+	TEST_CHECK(_agt_Near(pose.translations[1], vec3(0.f, 4.f, 0.f)));
+	TEST_CHECK(_agt_Near(pose.translations[2], vec3(0.f, 6.f, 0.f)));
+
+	TEST_CHECK(graph.AddMask(graph.AddClip(&a), graph.AddClip(&b), "missing") == nullptr);
+	TEST_CHECK(graph.AddMask(graph.AddClip(&a), graph.AddClip(&b), nullptr) == nullptr);
+}
+
+static void _agt_TestStateMachine()
+{
+	vector<Bone> bones;
+	vector<TransformNode> nodes;
+	_agt_BuildChain(bones, nodes);
+
+	dmat4 globalInverse{ 1.0 };
+	Skeleton skeleton{ bones, nodes, globalInverse };
+	TEST_CHECK(skeleton.Load() == ENGINE_OK);
+
+	TestClip a{ 10.0, 1.0 }, b{ 10.0, 1.0 };
+	_agt_BuildPose(a, vec3(1.f, 0.f, 0.f), 0.f);
+	_agt_BuildPose(b, vec3(0.f, 2.f, 0.f), 1.f);
+
+	AnimationGraph graph{ &skeleton };
+	SkeletonPose pose;
+	pose.Resize(3);
+
+	// Parameter condition with a one second crossfade
+	AnimationStateMachine *sm{ graph.AddStateMachine() };
+	sm->AddState("idle", graph.AddClip(&a));
+	sm->AddState("run", graph.AddClip(&b));
+
+	AnimationTransition t{};
+	t.from = 0;
+	t.to = 1;
+	t.duration = 1.f;
+	t.exitTime = -1.f;
+	t.parameter = graph.GetParameterId("speed");
+	t.condition = ANIM_COND_GREATER;
+	t.threshold = .5f;
+	sm->AddTransition(t);
+
+	graph.SetRoot(sm);
+	graph.Update(.1);
+	graph.Evaluate(pose);
+	TEST_CHECK(_agt_Near(pose.translations[0], vec3(1.f, 0.f, 0.f)));
+	TEST_CHECK(!strcmp(sm->GetCurrentStateName(), "idle"));
+
+	graph.SetParameter(graph.GetParameterId("speed"), 1.f);
+	graph.Update(.1);
+	TEST_CHECK(sm->IsInTransition());
+
+	graph.Update(.5);
+	graph.Evaluate(pose);
+	TEST_CHECK(_agt_Near(pose.translations[0], vec3(.5f, 1.f, 0.f)));
+
+	graph.Update(.6);
+	graph.Evaluate(pose);
+	TEST_CHECK(!sm->IsInTransition());
+	TEST_CHECK(!strcmp(sm->GetCurrentStateName(), "run"));
+	TEST_CHECK(_agt_Near(pose.translations[0], vec3(0.f, 2.f, 0.f)));
+
+	// Exit time on a clip that does not loop, from any state
+	AnimationStateMachine *once{ graph.AddStateMachine() };
+	once->AddState("once", graph.AddClip(&a, false));
+	once->AddState("after", graph.AddClip(&b));
+
+	AnimationTransition e{};
+	e.from = ANIM_ANY_STATE;
+	e.to = 1;
+	e.duration = 0.f;
+	e.exitTime = 1.f;
+	e.parameter = ANIM_NO_PARAMETER;
+	once->AddTransition(e);
+
+	graph.SetRoot(once);
+	graph.Update(5.0);
+	TEST_CHECK(once->GetCurrentState() == 0);
+	graph.Update(6.0);
+	TEST_CHECK(once->GetCurrentState() == 1);
+}
+
+// A graph holding a single clip must match plain single clip playback
+static void _agt_TestSingleClipParity()
+{
+	vector<Bone> bones;
+	vector<TransformNode> nodes;
+	TestBuildHierarchy(40, bones, nodes);
+
+	TestClip clip{ 100.0, 25.0 };
+	TestBuildClip(clip, nodes, 4);
+
+	dmat4 globalInverse{ 1.0 };
+	Skeleton reference{ bones, nodes, globalInverse }, graphSkeleton{ bones, nodes, globalInverse };
+	TEST_CHECK(reference.Load() == ENGINE_OK);
+	TEST_CHECK(graphSkeleton.Load() == ENGINE_OK);
+	reference.SetAnimationClip(&clip);
+
+	AnimationGraph graph{ &graphSkeleton };
+	graph.SetRoot(graph.AddClip(&clip));
+
+	// Accumulate the time like the graph does, so both wrap on the same frame
+	const double step{ 1.0 / 30.0 };
+	double time{ 0.0 };
+	float error{ 0.f };
+
+	for (int f = 1; f <= 200; ++f)
+	{
+		time += step;
+		reference.TransformBones(time);
+
+		graph.Update(step);
+		graph.Evaluate(graphSkeleton.GetPose());
+		graphSkeleton.ComputeTransforms();
+
+		const TrMat *expected{ TestGetBones(reference) }, *actual{ TestGetBones(graphSkeleton) };
+		for (uint16_t i = 0; i < reference.GetBoneCount(); ++i)
+			for (int j = 0; j < 16; ++j)
+				error = glm::max(error, fabsf(expected[i].m[j] - actual[i].m[j]));
+	}
+
+	TEST_CHECK(error < 1e-3f);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_agt_TestBlendNodes();
+	_agt_TestStateMachine();
+	_agt_TestSingleClipParity();
+
+	return Test::Result();
+}
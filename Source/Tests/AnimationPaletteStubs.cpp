@@ -0,0 +1,65 @@
+/* NekoEngine
+ *
+ * AnimationPaletteStubs.cpp
+ * Author: Alexandru Naiman
+ *
+ * Bone palette for the tests that do not link AnimationManager
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <vector>
+
+#include <Animation/AnimationManager.h>
+
+#define ANIM_TEST_PALETTE_SIZE	(1 << 20)
+
+using namespace std;
+
+static vector<TrMat> _at_palette(ANIM_TEST_PALETTE_SIZE);
+static uint32_t _at_paletteTop{ 0 };
+
+TrMat *AnimationManager::_palette{ _at_palette.data() };
+Buffer *AnimationManager::_paletteBuffer{ nullptr };
+
+uint32_t AnimationManager::AllocatePalette(uint32_t count) noexcept
+{
+	if (_at_paletteTop + count > _at_palette.size())
+		return ANIM_NO_PALETTE;
+
+	uint32_t offset{ _at_paletteTop };
+	_at_paletteTop += count;
+	return offset;
+}
+
+void AnimationManager::FreePalette(uint32_t offset, uint32_t count) noexcept { }
+void AnimationManager::Invalidate(uint32_t offset, uint32_t count) noexcept { }
@@ -0,0 +1,81 @@
+/* NekoEngine
+ *
+ * AnimationTest.h
+ * Author: Alexandru Naiman
+ *
+ * Animation test helpers
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <Animation/Bone.h>
+#include <Animation/Skeleton.h>
+#include <Animation/AnimationClip.h>
+#include <Animation/TransformNode.h>
+
+/**
+ * Clip built in memory; AnimationTestStubs.cpp replaces AnimationClip.cpp
+ * and the GPU buffers, AnimationPaletteStubs.cpp AnimationManager's palette
+ * for the tests that do not link AnimationManager.cpp.
+ */
+class TestClip : public AnimationClip
+{
+public:
+	TestClip(double duration, double ticksPerSecond) : AnimationClip(nullptr)
+	{
+		_duration = duration;
+		_ticksPerSecond = ticksPerSecond;
+	}
+
+	std::vector<AnimationNode> &Channels() noexcept { return _channels; }
+};
+
+/**
+ * Binary tree of count nodes named n0, n1... with one bone per node
+ * and a slightly different bind transform for each node.
+ */
+void TestBuildHierarchy(uint16_t count, std::vector<Bone> &bones, std::vector<TransformNode> &nodes);
+
+/**
+ * One channel per node with a key for every tick in [0, duration].
+ * Every node gets different motion, derived from seed.
+ */
+void TestBuildClip(TestClip &clip, const std::vector<TransformNode> &nodes, uint32_t seed);
+
+/**
+ * Bone matrices of the skeleton, as written to the palette
+ */
+const TrMat *TestGetBones(const Skeleton &skeleton);
@@ -0,0 +1,115 @@
+/* NekoEngine
+ *
+ * AnimationTestStubs.cpp
+ * Author: Alexandru Naiman
+ *
+ * Animation test helpers
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+
+#include <Renderer/Buffer.h>
+#include <Animation/AnimationManager.h>
+
+#include "AnimationTest.h"
+
+using namespace std;
+using namespace glm;
+
+Buffer::Buffer(Buffer *parent, VkDeviceSize offset, VkDeviceSize size) { }
+Buffer::~Buffer() { }
+
+AnimationClip::AnimationClip(AnimationClipResource *res) noexcept :
+	_duration(0.0),
+	_ticksPerSecond(0.0)
+{
+	_resourceInfo = (ResourceInfo *)res;
+}
+
+int AnimationClip::Load() { return ENGINE_OK; }
+void AnimationClip::Release() noexcept { }
+AnimationClip::~AnimationClip() noexcept { }
+
+void TestBuildHierarchy(uint16_t count, vector<Bone> &bones, vector<TransformNode> &nodes)
+{
+	bones.resize(count);
+	nodes.resize(count);
+
+	for (uint16_t i = 0; i < count; ++i)
+	{
+		TransformNode &node{ nodes[i] };
+
+		node.name = "n" + to_string(i);
+		node.parentId = i ? (int16_t)((i - 1) / 2) : -1;
+		node.transform = translate(dmat4(1.0), dvec3(.1 * i, 1.0, 0.0)) * mat4_cast(angleAxis(.01 * i, dvec3(0.0, 0.0, 1.0)));
+
+		bones[i].name = node.name;
+		bones[i].offset = inverse(translate(dmat4(1.0), dvec3(0.0, i, 0.0)));
+
+		if (i)
+		{
+			nodes[node.parentId].childrenIds.push_back(i);
+			++nodes[node.parentId].numChildren;
+		}
+	}
+}
+
+void TestBuildClip(TestClip &clip, const vector<TransformNode> &nodes, uint32_t seed)
+{
+	const uint32_t keys{ (uint32_t)clip.GetDuration() + 1 };
+	vector<AnimationNode> &channels{ clip.Channels() };
+
+	channels.resize(nodes.size());
+
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		AnimationNode &channel{ channels[i] };
+		const double phase{ (double)((i * 7 + seed * 13) % 29) };
+
+		channel.name = nodes[i].name.c_str();
+
+		for (uint32_t k = 0; k < keys; ++k)
+		{
+			const double t{ (double)k };
+			channel.positionKeys.push_back({ dvec3(sin(t * .1 + phase) * .2, 1.0, cos(t * .07 + phase) * .1), t });
+			channel.rotationKeys.push_back({ angleAxis(sin(t * .05 + phase), normalize(dvec3(1.0, phase, 1.0))), t });
+			channel.scalingKeys.push_back({ dvec3(1.0 + .1 * sin(t * .03 + phase)), t });
+		}
+	}
+}
+
+const TrMat *TestGetBones(const Skeleton &skeleton)
+{
+	return AnimationManager::GetPalette(skeleton.GetPaletteOffset());
+}
@@ -0,0 +1,77 @@
+/* NekoEngine
+ *
+ * AnimatorTest.h
+ * Author: Alexandru Naiman
+ *
+ * Animator test helpers
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <Scene/Object.h>
+#include <Scene/Components/AnimatorComponent.h>
+
+#include "ObjectTest.h"
+#include "AnimationTest.h"
+
+/**
+ * Animator looping a clip on a skeleton built in memory. Load looks up the
+ * skeletal mesh and the clip resource, so the constructor sets them up instead.
+ * The animator owns the skeleton.
+ */
+class TestAnimator : public AnimatorComponent
+{
+public:
+	TestAnimator(ComponentInitializer *initializer, Skeleton *skeleton, AnimationClip *clip);
+
+	double GetTime() const noexcept { return _currentTime; }
+};
+
+/**
+ * Palette upload recorded by the Renderer stub
+ */
+struct TestUpload
+{
+	Buffer *buffer;
+	VkDeviceSize offset, size;
+	uint32_t count;
+};
+
+/**
+ * Loaded object at position with a 2 unit box around it and one animator.
+ * Deleting the object deletes the animator.
+ */
+Object *TestNewAnimatedObject(const glm::vec3 &position, Skeleton *skeleton, AnimationClip *clip, TestAnimator **animator);
+
+TestUpload &TestGetUpload();
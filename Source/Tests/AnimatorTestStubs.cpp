@@ -0,0 +1,144 @@
+/* NekoEngine
+ *
+ * AnimatorTestStubs.cpp
+ * Author: Alexandru Naiman
+ *
+ * Scene and renderer services for the animator tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Engine/ResourceManager.h>
+#include <Renderer/VKUtil.h>
+#include <Renderer/Renderer.h>
+#include <Renderer/DebugMarker.h>
+#include <Renderer/SkeletalMesh.h>
+#include <Scene/Components/SkeletalMeshComponent.h>
+
+#include "AnimatorTest.h"
+
+using namespace std;
+using namespace glm;
+
+static TestUpload _at_upload{};
+
+// Vulkan and the renderer; AnimationManager creates the palette buffer and
+// uploads the dirty range, the tests check the range
+VkPhysicalDevice VKUtil::_physicalDevice{ VK_NULL_HANDLE };
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties *pProperties)
+{
+	// Common storage buffer alignment, four matrices
+	pProperties->limits.minStorageBufferOffsetAlignment = 256;
+}
+
+void DebugMarker::SetObjectName(uint64_t object, VkDebugReportObjectTypeEXT type, const char *name) { }
+
+Buffer::Buffer(size_t size, VkBufferUsageFlags usage, uint8_t *data, VkMemoryPropertyFlags properties) { }
+
+// The stub below does not use the instance
+Renderer *Renderer::GetInstance() { return nullptr; }
+
+void Renderer::UploadFrameData(Buffer *dst, VkDeviceSize offset, const uint8_t *data, VkDeviceSize size, VkCommandBuffer cmdBuffer)
+{
+	_at_upload = { dst, offset, size, _at_upload.count + 1 };
+}
+
+Resource *ResourceManager::GetResourceByName(const char *name, ResourceType type) { return nullptr; }
+int ResourceManager::UnloadResource(int id, ResourceType type) noexcept { return ENGINE_OK; }
+
+Skeleton *SkeletalMesh::CreateSkeleton() { return nullptr; }
+VkDeviceSize SkeletalMesh::GetRequiredMemorySize() { return 0; }
+int StaticMesh::CreateBuffer(bool dynamic) { return ENGINE_OK; }
+VkDeviceSize StaticMesh::GetRequiredMemorySize() { return 0; }
+
+// AnimatorComponent::Load looks for the skeletal mesh component; the tests
+// create the skeleton instead, so the mesh components are never constructed
+void StaticMeshComponent::SetPosition(vec3 &position) noexcept { }
+void StaticMeshComponent::SetRotation(vec3 &rotation) noexcept { }
+void StaticMeshComponent::SetScale(vec3 &scale) noexcept { }
+int StaticMeshComponent::Load() { return ENGINE_OK; }
+bool StaticMeshComponent::Upload(Buffer *buffer) { return true; }
+void StaticMeshComponent::Update(double deltaTime) noexcept { }
+void StaticMeshComponent::UpdatePosition() noexcept { }
+bool StaticMeshComponent::InitDrawables() { return true; }
+bool StaticMeshComponent::RebuildCommandBuffers() { return true; }
+bool StaticMeshComponent::Unload() { return true; }
+void StaticMeshComponent::UpdateData(VkCommandBuffer commandBuffer) noexcept { }
+void StaticMeshComponent::DrawShadow(VkCommandBuffer commandBuffer, uint32_t shadowId) const noexcept { }
+
+int SkeletalMeshComponent::Load() { return ENGINE_OK; }
+bool SkeletalMeshComponent::Upload(Buffer *buffer) { return true; }
+int SkeletalMeshComponent::InitializeComponent() { return ENGINE_OK; }
+void SkeletalMeshComponent::Update(double deltaTime) noexcept { }
+bool SkeletalMeshComponent::InitDrawables() { return true; }
+bool SkeletalMeshComponent::RebuildCommandBuffers() { return true; }
+bool SkeletalMeshComponent::Unload() { return true; }
+void SkeletalMeshComponent::UpdateData(VkCommandBuffer commandBuffer) noexcept { }
+void SkeletalMeshComponent::DrawShadow(VkCommandBuffer commandBuffer, uint32_t shadowId) const noexcept { }
+
+TestAnimator::TestAnimator(ComponentInitializer *initializer, Skeleton *skeleton, AnimationClip *clip) :
+	AnimatorComponent(initializer)
+{
+	_skeleton = skeleton;
+	_loaded = true;
+
+	PlayAnimation(clip);
+}
+
+Object *TestNewAnimatedObject(const vec3 &position, Skeleton *skeleton, AnimationClip *clip, TestAnimator **animator)
+{
+	ObjectInitializer objInitializer{};
+	objInitializer.position = position;
+
+	Object *obj{ new Object(&objInitializer) };
+
+	ComponentInitializer initializer{};
+	initializer.parent = obj;
+	initializer.arguments.insert({ "defaultanim", "" });
+	initializer.arguments.insert({ "targetmesh", "" });
+
+	*animator = new TestAnimator(&initializer, skeleton, clip);
+	obj->AddComponent("animator", *animator);
+	obj->Load();
+
+	NBounds bounds{};
+	bounds.InitBox(position - vec3(1.f), position + vec3(1.f));
+	obj->SetBounds(bounds);
+
+	return obj;
+}
+
+TestUpload &TestGetUpload()
+{
+	return _at_upload;
+}
@@ -0,0 +1,370 @@
+/* NekoEngine
+ *
+ * DistanceFieldTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Distance field generator tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+#include <algorithm>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_MODULE_H
+
+#include <Renderer/NFont.h>
+#include <Renderer/DistanceField.h>
+
+#include "Test.h"
+
+#define DFT_GOLDEN			"DistanceFieldGlyphs.bin"
+#define DFT_GOLDEN_MAGIC	"NSDF"
+#define DFT_GOLDEN_FONT		"/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf"
+#define DFT_GOLDEN_GLYPHS	"AgQ@&%"
+#define DFT_DISK_SIZE		64
+#define DFT_DISK_RADIUS		20.f
+#define DFT_DISK_SPREAD		8
+#define DFT_DISK_SAMPLES	8
+#define DFT_BENCH_RUNS		200
+
+using namespace std;
+
+/**
+ * Coverage bitmap of a glyph and FreeType's distance field of the same
+ * glyph (FT_RENDER_MODE_SDF) at FONT_SDF_SIZE and FONT_SDF_SPREAD. The
+ * offset is the position of the reference in the padded field. Run with
+ * --update-golden to render them again from DFT_GOLDEN_FONT.
+ */
+struct DFTGlyph
+{
+	uint32_t codepoint;
+	int32_t width, height;
+	vector<uint8_t> coverage;
+	int32_t refWidth, refHeight, refX, refY;
+	vector<uint8_t> reference;
+};
+
+/**
+ * Signed distance in pixels stored in a field texel, positive inside
+ */
+static inline float _dft_Distance(uint8_t value, int spread)
+{
+	return (value / 255.f - .5f) * 2.f * spread;
+}
+
+static void _dft_TestDisk()
+{
+	const float cx{ 31.3f }, cy{ 30.7f }, r2{ DFT_DISK_RADIUS * DFT_DISK_RADIUS };
+	const int samples{ DFT_DISK_SAMPLES * DFT_DISK_SAMPLES };
+	vector<uint8_t> coverage(DFT_DISK_SIZE * DFT_DISK_SIZE);
+
+	for (int y = 0; y < DFT_DISK_SIZE; ++y)
+	{
+		for (int x = 0; x < DFT_DISK_SIZE; ++x)
+		{
+			int inside{ 0 };
+			for (int i = 0; i < samples; ++i)
+			{
+				const float px{ x + (i % DFT_DISK_SAMPLES + .5f) / DFT_DISK_SAMPLES - cx };
+				const float py{ y + (i / DFT_DISK_SAMPLES + .5f) / DFT_DISK_SAMPLES - cy };
+				inside += px * px + py * py < r2;
+			}
+			coverage[y * DFT_DISK_SIZE + x] = (uint8_t)roundf(inside * 255.f / samples);
+		}
+	}
+
+	vector<uint8_t> field{};
+	DistanceField::Generate(coverage.data(), DFT_DISK_SIZE, DFT_DISK_SIZE, DFT_DISK_SIZE, DFT_DISK_SPREAD, field);
+
+	const int fieldSize{ DFT_DISK_SIZE + 2 * DFT_DISK_SPREAD };
+	TEST_CHECK(field.size() == (size_t)(fieldSize * fieldSize));
+
+	double sum{ 0.0 }, maxError{ 0.0 };
+	int count{ 0 };
+
+	for (int y = 0; y < fieldSize; ++y)
+	{
+		for (int x = 0; x < fieldSize; ++x)
+		{
+			const float px{ x - DFT_DISK_SPREAD + .5f - cx }, py{ y - DFT_DISK_SPREAD + .5f - cy };
+			const float expected{ DFT_DISK_RADIUS - sqrtf(px * px + py * py) };
+
+			// Values saturate at the spread
+			if (fabsf(expected) > DFT_DISK_SPREAD - 1)
+				continue;
+
+			const double error{ fabs(_dft_Distance(field[y * fieldSize + x], DFT_DISK_SPREAD) - expected) };
+			maxError = max(maxError, error);
+			sum += error;
+			++count;
+		}
+	}
+
+	TEST_CHECK(count > 0);
+	TEST_CHECK(sum / count < .26);
+	TEST_CHECK(maxError < .65);
+
+	// Saturated far away, in and out
+	TEST_CHECK(field[0] == 0);
+	TEST_CHECK(field[(fieldSize / 2) * fieldSize + fieldSize / 2] == 255);
+}
+
+static void _dft_TestEmpty()
+{
+	// Glyphs without pixels, like the space, produce a field that is all outside
+	const uint8_t coverage[4]{ 0 };
+	vector<uint8_t> field{};
+
+	DistanceField::Generate(coverage, 2, 2, 2, 3, field);
+	TEST_CHECK(field.size() == 64);
+	TEST_CHECK(all_of(field.begin(), field.end(), [](uint8_t v) { return v == 0; }));
+}
+
+static bool _dft_RenderGolden(vector<DFTGlyph> &glyphs)
+{
+	FT_Library library{ nullptr };
+	FT_Face face{ nullptr };
+
+	if (FT_Init_FreeType(&library))
+		return false;
+
+	if (FT_New_Face(library, DFT_GOLDEN_FONT, 0, &face))
+	{
+		fprintf(stderr, "Failed to load %s\n", DFT_GOLDEN_FONT);
+		FT_Done_FreeType(library);
+		return false;
+	}
+
+	FT_Int spread{ FONT_SDF_SPREAD };
+	FT_Property_Set(library, "sdf", "spread", &spread);
+	FT_Set_Pixel_Sizes(face, 0, FONT_SDF_SIZE);
+
+	bool ret{ true };
+	for (const char *c = DFT_GOLDEN_GLYPHS; *c && ret; ++c)
+	{
+		DFTGlyph glyph{};
+		glyph.codepoint = (uint32_t)*c;
+
+		if (FT_Load_Char(face, glyph.codepoint, FT_LOAD_DEFAULT) || FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL))
+		{
+			ret = false;
+			break;
+		}
+
+		const FT_Bitmap &bitmap{ face->glyph->bitmap };
+		const int left{ face->glyph->bitmap_left }, top{ face->glyph->bitmap_top };
+
+		glyph.width = bitmap.width;
+		glyph.height = bitmap.rows;
+		for (int y = 0; y < glyph.height; ++y)
+			glyph.coverage.insert(glyph.coverage.end(), bitmap.buffer + y * bitmap.pitch, bitmap.buffer + y * bitmap.pitch + glyph.width);
+
+		if (FT_Load_Char(face, glyph.codepoint, FT_LOAD_DEFAULT) || FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF))
+		{
+			ret = false;
+			break;
+		}
+
+		const FT_Bitmap &reference{ face->glyph->bitmap };
+
+		glyph.refWidth = reference.width;
+		glyph.refHeight = reference.rows;
+		glyph.refX = face->glyph->bitmap_left - (left - FONT_SDF_SPREAD);
+		glyph.refY = (top + FONT_SDF_SPREAD) - face->glyph->bitmap_top;
+		for (int y = 0; y < glyph.refHeight; ++y)
+			glyph.reference.insert(glyph.reference.end(), reference.buffer + y * reference.pitch, reference.buffer + y * reference.pitch + glyph.refWidth);
+
+		glyphs.push_back(glyph);
+	}
+
+	FT_Done_Face(face);
+	FT_Done_FreeType(library);
+
+	return ret;
+}
+
+static bool _dft_WriteGolden(const char *file, const vector<DFTGlyph> &glyphs)
+{
+	FILE *fp{ fopen(file, "wb") };
+	if (!fp)
+		return false;
+
+	const uint32_t count{ (uint32_t)glyphs.size() };
+	fwrite(DFT_GOLDEN_MAGIC, 1, 4, fp);
+	fwrite(&count, sizeof(count), 1, fp);
+
+	for (const DFTGlyph &glyph : glyphs)
+	{
+		fwrite(&glyph.codepoint, sizeof(uint32_t), 1, fp);
+		fwrite(&glyph.width, sizeof(int32_t), 2, fp);
+		fwrite(glyph.coverage.data(), 1, glyph.coverage.size(), fp);
+		fwrite(&glyph.refWidth, sizeof(int32_t), 4, fp);
+		fwrite(glyph.reference.data(), 1, glyph.reference.size(), fp);
+	}
+
+	return fclose(fp) == 0;
+}
+
+static bool _dft_ReadGolden(const char *file, vector<DFTGlyph> &glyphs)
+{
+	FILE *fp{ fopen(file, "rb") };
+	if (!fp)
+		return false;
+
+	char magic[4];
+	uint32_t count{ 0 };
+	bool ret{ fread(magic, 1, 4, fp) == 4 && !memcmp(magic, DFT_GOLDEN_MAGIC, 4) && fread(&count, sizeof(count), 1, fp) == 1 };
+
+	for (uint32_t i = 0; i < count && ret; ++i)
+	{
+		DFTGlyph glyph{};
+
+		ret = fread(&glyph.codepoint, sizeof(uint32_t), 1, fp) == 1 && fread(&glyph.width, sizeof(int32_t), 2, fp) == 2 &&
+			glyph.width >= 0 && glyph.height >= 0;
+		if (!ret)
+			break;
+
+		glyph.coverage.resize((size_t)glyph.width * glyph.height);
+		ret = fread(glyph.coverage.data(), 1, glyph.coverage.size(), fp) == glyph.coverage.size() &&
+			fread(&glyph.refWidth, sizeof(int32_t), 4, fp) == 4 && glyph.refWidth >= 0 && glyph.refHeight >= 0;
+		if (!ret)
+			break;
+
+		glyph.reference.resize((size_t)glyph.refWidth * glyph.refHeight);
+		ret = fread(glyph.reference.data(), 1, glyph.reference.size(), fp) == glyph.reference.size();
+
+		glyphs.push_back(glyph);
+	}
+
+	fclose(fp);
+	return ret;
+}
+
+static void _dft_TestGlyphs()
+{
+	vector<DFTGlyph> glyphs{};
+
+	if (Test::HasArgument("--update-golden"))
+	{
+		TEST_CHECK(_dft_RenderGolden(glyphs));
+		TEST_CHECK(_dft_WriteGolden(Test::DataPath(DFT_GOLDEN), glyphs));
+		return;
+	}
+
+	TEST_CHECK(_dft_ReadGolden(Test::DataPath(DFT_GOLDEN), glyphs));
+	TEST_CHECK(glyphs.size() == strlen(DFT_GOLDEN_GLYPHS));
+
+	double totalSum{ 0.0 };
+	int totalCount{ 0 };
+
+	for (const DFTGlyph &glyph : glyphs)
+	{
+		vector<uint8_t> field{};
+		DistanceField::Generate(glyph.coverage.data(), glyph.width, glyph.height, glyph.width, FONT_SDF_SPREAD, field);
+
+		const int fieldWidth{ glyph.width + 2 * FONT_SDF_SPREAD }, fieldHeight{ glyph.height + 2 * FONT_SDF_SPREAD };
+		double sum{ 0.0 }, maxError{ 0.0 };
+		int count{ 0 };
+
+		for (int y = 0; y < glyph.refHeight; ++y)
+		{
+			for (int x = 0; x < glyph.refWidth; ++x)
+			{
+				const int fx{ x + glyph.refX }, fy{ y + glyph.refY };
+				if (fx < 0 || fy < 0 || fx >= fieldWidth || fy >= fieldHeight)
+					continue;
+
+				// FreeType maps the edge to 128 and the spread to 128 steps
+				const float expected{ ((int)glyph.reference[y * glyph.refWidth + x] - 128) / 128.f * FONT_SDF_SPREAD };
+				if (fabsf(expected) > FONT_SDF_SPREAD - 1)
+					continue;
+
+				const double error{ fabs(_dft_Distance(field[fy * fieldWidth + fx], FONT_SDF_SPREAD) - expected) };
+				maxError = max(maxError, error);
+				sum += error;
+				++count;
+			}
+		}
+
+		TEST_CHECK(count > 0);
+		if (!count)
+			continue;
+
+		// Coverage only approximates the outline, so corners are off by up to a pixel
+		TEST_CHECK(sum / count < .3);
+		TEST_CHECK(maxError < .85);
+
+		totalSum += sum;
+		totalCount += count;
+	}
+
+	if (totalCount)
+		TEST_CHECK(totalSum / totalCount < .25);
+}
+
+static void _dft_Benchmark()
+{
+	vector<DFTGlyph> glyphs{};
+	if (!_dft_ReadGolden(Test::DataPath(DFT_GOLDEN), glyphs) || glyphs.empty())
+		return;
+
+	vector<uint8_t> field{};
+	const double start{ Test::Time() };
+
+	for (int i = 0; i < DFT_BENCH_RUNS; ++i)
+		for (const DFTGlyph &glyph : glyphs)
+			DistanceField::Generate(glyph.coverage.data(), glyph.width, glyph.height, glyph.width, FONT_SDF_SPREAD, field);
+
+	const double time{ Test::Time() - start };
+	printf("Generate: %.3f ms per %dpx glyph\n", time / (DFT_BENCH_RUNS * glyphs.size()), FONT_SDF_SIZE);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_dft_TestDisk();
+	_dft_TestEmpty();
+	_dft_TestGlyphs();
+
+	if (Test::Benchmark())
+		_dft_Benchmark();
+
+	return Test::Result();
+}
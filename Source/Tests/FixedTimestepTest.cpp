@@ -0,0 +1,251 @@
+/* NekoEngine
+ *
+ * FixedTimestepTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Fixed timestep tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <vector>
+#include <random>
+
+#include <Engine/FixedTimestep.h>
+
+#include "Test.h"
+
+#define FTT_BODIES			64
+#define FTT_STEP			(1.0 / 60.0)
+#define FTT_MAX_SUBSTEPS	5
+#define FTT_DURATION		10.0
+
+using namespace std;
+
+/**
+ * Damped bodies bouncing on a floor; small enough to hash every state
+ */
+struct TestSimulation
+{
+	double x[FTT_BODIES], v[FTT_BODIES];
+	uint32_t steps{ 0 };
+
+	TestSimulation()
+	{
+		for (int i = 0; i < FTT_BODIES; ++i)
+		{
+			x[i] = 10.0 + i * .37;
+			v[i] = i * .11 - 3.0;
+		}
+	}
+
+	void Step(double dt)
+	{
+		for (int i = 0; i < FTT_BODIES; ++i)
+		{
+			v[i] += -9.81 * dt - .1 * v[i] * dt;
+			x[i] += v[i] * dt;
+
+			if (x[i] < 0.0)
+			{
+				x[i] = -x[i];
+				v[i] = -v[i] * .8;
+			}
+		}
+
+		++steps;
+	}
+
+	uint64_t Hash() const
+	{
+		uint64_t hash{ 1469598103934665603ull };
+		const uint8_t *p{ (const uint8_t *)x };
+
+		for (size_t i = 0; i < sizeof(x) + sizeof(v); ++i)
+		{
+			hash ^= p[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+};
+
+struct TestRun
+{
+	vector<uint64_t> states;
+	uint32_t maxSubsteps{ 0 };
+	float minAlpha{ 1.f }, maxAlpha{ 0.f };
+	double maxLag{ 0.0 };
+};
+
+static TestRun _ftt_RunFixed(const vector<double> &frames)
+{
+	TestRun run{};
+	TestSimulation sim{};
+	FixedTimestep timestep{ FTT_STEP, FTT_MAX_SUBSTEPS };
+	double wallTime{ 0.0 }, simTime{ 0.0 }, prevSimTime{ 0.0 };
+
+	for (double dt : frames)
+	{
+		wallTime += dt;
+
+		const uint32_t steps{ timestep.Advance(dt) };
+		run.maxSubsteps = max(run.maxSubsteps, steps);
+
+		for (uint32_t i = 0; i < steps; ++i)
+		{
+			prevSimTime = simTime;
+			sim.Step(timestep.GetStep());
+			simTime += timestep.GetStep();
+			run.states.push_back(sim.Hash());
+		}
+
+		const float alpha{ timestep.GetAlpha() };
+		run.minAlpha = min(run.minAlpha, alpha);
+		run.maxAlpha = max(run.maxAlpha, alpha);
+
+		// The interpolated state trails the wall clock by one step
+		if (sim.steps)
+		{
+			const double shown{ prevSimTime + (simTime - prevSimTime) * alpha };
+			const double expected{ wallTime - timestep.GetDroppedTime() - timestep.GetStep() };
+			run.maxLag = max(run.maxLag, fabs(expected - shown));
+		}
+	}
+
+	return run;
+}
+
+static uint64_t _ftt_RunVariable(const vector<double> &frames)
+{
+	TestSimulation sim{};
+
+	for (double dt : frames)
+		sim.Step(dt);
+
+	return sim.Hash();
+}
+
+static vector<double> _ftt_Constant(double dt)
+{
+	return vector<double>((size_t)llround(FTT_DURATION / dt), dt);
+}
+
+static vector<double> _ftt_Random(uint32_t seed, bool spikes)
+{
+	mt19937 rng{ seed };
+	uniform_real_distribution<double> jitter{ .005, .040 }, chance{ 0.0, 1.0 };
+	vector<double> frames;
+	double total{ 0.0 };
+
+	while (total < FTT_DURATION)
+	{
+		const double dt{ spikes ? (chance(rng) < .05 ? .07 : .004) : jitter(rng) };
+		frames.push_back(dt);
+		total += dt;
+	}
+
+	return frames;
+}
+
+static void _ftt_TestDeterminism()
+{
+	const vector<vector<double>> sequences
+	{
+		_ftt_Constant(1.0 / 60.0),
+		_ftt_Constant(1.0 / 144.0),
+		_ftt_Constant(1.0 / 30.0),
+		_ftt_Random(7, false),
+		_ftt_Random(7, true)
+	};
+
+	vector<TestRun> runs;
+	size_t common{ SIZE_MAX };
+
+	for (const vector<double> &frames : sequences)
+	{
+		runs.push_back(_ftt_RunFixed(frames));
+		common = min(common, runs.back().states.size());
+	}
+
+	// All sequences cover the same 10 s and differ by at most one step
+	TEST_CHECK(common + 1 >= (size_t)(FTT_DURATION / FTT_STEP));
+
+	for (const TestRun &run : runs)
+	{
+		TEST_CHECK(equal(run.states.begin(), run.states.begin() + common, runs[0].states.begin()));
+		TEST_CHECK(run.maxSubsteps <= FTT_MAX_SUBSTEPS);
+		TEST_CHECK(run.minAlpha >= 0.f && run.maxAlpha <= 1.f);
+		TEST_CHECK(run.maxLag < 1e-6);
+	}
+
+	// Stepping with the frame time does depend on the frame rate
+	const uint64_t reference{ _ftt_RunVariable(sequences[0]) };
+	for (size_t i = 1; i < sequences.size(); ++i)
+		TEST_CHECK(_ftt_RunVariable(sequences[i]) != reference);
+}
+
+static void _ftt_TestSubstepClamp()
+{
+	FixedTimestep timestep{ FTT_STEP, FTT_MAX_SUBSTEPS };
+
+	// A one second hitch runs the maximum number of steps and drops the rest
+	TEST_CHECK(timestep.Advance(1.0) == FTT_MAX_SUBSTEPS);
+	TEST_CHECK(fabs(timestep.GetDroppedTime() - (1.0 - FTT_MAX_SUBSTEPS * FTT_STEP - fmod(1.0, FTT_STEP))) < 1e-9);
+	TEST_CHECK(timestep.GetAlpha() < 1.f);
+
+	// The next frame is not slowed down by it
+	TEST_CHECK(timestep.Advance(FTT_STEP) <= 1);
+
+	// Zero and negative frame times do not advance
+	timestep.Reset();
+	TEST_CHECK(timestep.Advance(0.0) == 0);
+	TEST_CHECK(timestep.Advance(-1.0) == 0);
+	TEST_CHECK(timestep.GetAlpha() == 0.f);
+
+	// Changing the rate clamps the substeps to at least one
+	timestep.SetStep(.01, 0);
+	TEST_CHECK(timestep.GetMaxSubsteps() == 1);
+	TEST_CHECK(timestep.Advance(.5) == 1);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_ftt_TestDeterminism();
+	_ftt_TestSubstepClamp();
+
+	return Test::Result();
+}
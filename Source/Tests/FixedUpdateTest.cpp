@@ -0,0 +1,233 @@
+/* NekoEngine
+ *
+ * FixedUpdateTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Engine fixed update and transform interpolation tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <vector>
+#include <string>
+
+#include <Engine/Engine.h>
+#include <Scene/Object.h>
+#include <Scene/SceneManager.h>
+#include <Physics/Physics.h>
+
+#include "ObjectTest.h"
+#include "Test.h"
+
+#define FUT_TOLERANCE		1e-5f
+
+using namespace std;
+using namespace glm;
+
+/**
+ * Records the fixed steps it runs in
+ */
+class TestPhysics : public Physics
+{
+public:
+	virtual int Initialize() override { return ENGINE_OK; }
+	virtual int InitScene(BroadphaseType broadphase, double sceneSize, uint32_t maxObjects) override { return ENGINE_OK; }
+
+	virtual BoxCollider *CreateBoxCollider(Object *parent, const vec3 &halfExtents) override { return nullptr; }
+	virtual SphereCollider *CreateSphereCollider(Object *parent, double radius) override { return nullptr; }
+	virtual CapsuleCollider *CreateCapsuleCollider(Object *parent, double radius, double height) override { return nullptr; }
+	virtual MeshCollider *CreateMeshCollider(Object *parent, const StaticMesh *mesh) override { return nullptr; }
+
+	virtual bool RayCast(Ray *ray) override { return false; }
+	virtual bool ScreenRayCast(Ray *ray, vec2 &screenCoords, float distance) override { return false; }
+
+	virtual void Update(double deltaTime) override
+	{
+		steps.push_back(deltaTime);
+		order += Engine::InFixedUpdate() ? "p" : "-";
+	}
+
+	virtual void Release() override { }
+
+	vector<double> steps;
+	string order;
+};
+
+/**
+ * Moves one unit along X and turns 90 degrees around Y in each fixed step.
+ * The move is made in two halves so the step changes the transform twice.
+ */
+class TestFixedObject : public Object
+{
+public:
+	TestFixedObject(ObjectInitializer &&initializer = ObjectInitializer()) : Object(&initializer)
+	{
+		_haveMesh = true;
+	}
+
+	virtual void FixedUpdate() noexcept override
+	{
+		if (!moving)
+			return;
+
+		for (int i = 0; i < 2; ++i)
+		{
+			vec3 position{ _position + vec3(.5f, 0.f, 0.f) };
+			SetPosition(position);
+
+			vec3 rotation{ _rotation + vec3(0.f, 45.f, 0.f) };
+			SetRotation(rotation);
+		}
+	}
+
+	const mat4 &Interpolate(float alpha)
+	{
+		_InterpolateModelMatrix(alpha);
+		return _modelMatrix;
+	}
+
+	bool moving{ true };
+};
+
+static TestPhysics _fut_physics;
+static vector<Object *> _fut_objects;
+
+Physics *Physics::GetInstance() { return &_fut_physics; }
+Physics::~Physics() { }
+
+void SceneManager::FixedUpdateScene() noexcept
+{
+	_fut_physics.order += Engine::InFixedUpdate() ? "s" : "-";
+
+	for (Object *obj : _fut_objects)
+		obj->FixedUpdate();
+}
+
+static mat4 _fut_Transform(const vec3 &position, float yaw, const vec3 &scale)
+{
+	return translate(mat4(), position) * mat4_cast(angleAxis(radians(yaw), vec3(0.f, 1.f, 0.f))) * glm::scale(mat4(), scale);
+}
+
+static bool _fut_Equal(const mat4 &a, const mat4 &b)
+{
+	for (int i = 0; i < 4; ++i)
+		for (int j = 0; j < 4; ++j)
+			if (fabsf(a[i][j] - b[i][j]) > FUT_TOLERANCE)
+				return false;
+
+	return true;
+}
+
+// Objects moved in a fixed step are drawn between the state before it and the one after
+static void _fut_TestInterpolation()
+{
+	const double step{ Engine::GetFixedDeltaTime() };
+	const vec3 start{ 2.f, 1.f, 0.f }, end{ 3.f, 1.f, 0.f };
+
+	ObjectInitializer initializer{};
+	initializer.position = start;
+	initializer.scale = vec3(2.f);
+
+	TestFixedObject obj{ move(initializer) };
+	_fut_objects.push_back(&obj);
+
+	TEST_CHECK(Engine::StepFixedUpdate(step * 1.5) == 1);
+	TEST_CHECK(fabsf(Engine::GetInterpolationFactor() - .5f) < FUT_TOLERANCE);
+
+	// Both changes in the step keep the state from before it
+	TEST_CHECK(_fut_Equal(obj.Interpolate(0.f), _fut_Transform(start, 0.f, vec3(2.f))));
+	TEST_CHECK(_fut_Equal(obj.Interpolate(.5f), _fut_Transform((start + end) * .5f, 45.f, vec3(2.f))));
+	TEST_CHECK(_fut_Equal(obj.Interpolate(1.f), _fut_Transform(end, 90.f, vec3(2.f))));
+
+	obj.UpdateData(VK_NULL_HANDLE);
+	TEST_CHECK(_fut_Equal(obj.GetModelMatrix(), _fut_Transform((start + end) * .5f, 45.f, vec3(2.f))));
+
+	// The next step starts from where the last one ended
+	TEST_CHECK(Engine::StepFixedUpdate(step) == 1);
+	TEST_CHECK(_fut_Equal(obj.Interpolate(0.f), _fut_Transform(end, 90.f, vec3(2.f))));
+	TEST_CHECK(_fut_Equal(obj.Interpolate(1.f), _fut_Transform(end + vec3(1.f, 0.f, 0.f), 180.f, vec3(2.f))));
+
+	// Changes made outside the fixed step are not interpolated
+	vec3 teleport{ -5.f, 0.f, 0.f };
+	obj.SetPosition(teleport);
+	obj.UpdateData(VK_NULL_HANDLE);
+	TEST_CHECK(_fut_Equal(obj.GetModelMatrix(), _fut_Transform(teleport, 135.f, vec3(2.f))));
+
+	// Once it stops moving it is drawn where it is
+	obj.moving = false;
+	TEST_CHECK(Engine::StepFixedUpdate(step) == 1);
+	obj.UpdateData(VK_NULL_HANDLE);
+	TEST_CHECK(_fut_Equal(obj.GetModelMatrix(), _fut_Transform(teleport, 180.f, vec3(2.f))));
+
+	_fut_objects.clear();
+}
+
+// A long frame runs at most the configured number of steps, with physics before the scene
+static void _fut_TestStepClamp()
+{
+	const double step{ Engine::GetFixedDeltaTime() };
+	const uint32_t maxSubsteps{ FixedTimestep().GetMaxSubsteps() };
+	const uint64_t frame{ Engine::GetFixedFrame() };
+
+	_fut_physics.steps.clear();
+	_fut_physics.order.clear();
+
+	TEST_CHECK(Engine::StepFixedUpdate(1.0) == maxSubsteps);
+	TEST_CHECK(Engine::GetFixedFrame() == frame + maxSubsteps);
+	TEST_CHECK(_fut_physics.steps.size() == maxSubsteps);
+	TEST_CHECK(!Engine::InFixedUpdate());
+	TEST_CHECK(Engine::GetInterpolationFactor() < 1.f);
+
+	for (double dt : _fut_physics.steps)
+		TEST_CHECK(dt == step);
+
+	string order{};
+	for (uint32_t i = 0; i < maxSubsteps; ++i)
+		order += "ps";
+	TEST_CHECK(_fut_physics.order == order);
+
+	// The dropped time does not carry over into the next frame
+	TEST_CHECK(Engine::StepFixedUpdate(step) <= 1);
+	TEST_CHECK(Engine::StepFixedUpdate(0.0) == 0);
+	TEST_CHECK(Engine::StepFixedUpdate(-1.0) == 0);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+	TestLoadScene();
+
+	_fut_TestInterpolation();
+	_fut_TestStepClamp();
+
+	return Test::Result();
+}
@@ -0,0 +1,291 @@
+/* NekoEngine
+ *
+ * GUILayoutTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * GUI layout solver and batcher tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <GUI/GUILayout.h>
+
+#include "Test.h"
+
+#define GLT_PIPELINE		1
+#define GLT_BENCH_ROWS		25
+#define GLT_BENCH_COLUMNS	40
+#define GLT_BENCH_FRAMES	1000
+
+using namespace glm;
+
+static inline Rect _glt_Rect(int x, int y, int w, int h)
+{
+	return Rect{ { Point(x, y) }, { Point(w, h) } };
+}
+
+static void _glt_AddQuad(GUIBatcher &batcher, float x, float y, float w, float h, const void *texture)
+{
+	GUIVertex v[4]{};
+	v[0].posAndUV = vec4(x, y, 0.f, 0.f);
+	v[1].posAndUV = vec4(x, y + h, 0.f, 1.f);
+	v[2].posAndUV = vec4(x + w, y + h, 1.f, 1.f);
+	v[3].posAndUV = vec4(x + w, y, 1.f, 0.f);
+	batcher.AddQuad(GLT_PIPELINE, texture, v);
+}
+
+static void _glt_TestLayout()
+{
+	GUILayoutNode root{}, panel{}, a{}, b{}, c{}, absolute{};
+	GUILayoutResult result{};
+
+	root.AddChild(&panel);
+	root.AddChild(&absolute);
+
+	// Right half of the screen with a 10px margin; a padded row with one fixed and two growing children
+	panel.SetAnchors(vec2(.5f, 0.f), vec2(1.f, 1.f), Point(10, 10), Point(-10, -10));
+	panel.SetDirection(LayoutDirection::Row, 5, 4);
+
+	a.SetAnchors(vec2(0.f, 0.f), vec2(0.f, 1.f), Point(0, 0), Point(100, 0));
+	b.SetSize(50, 30);
+	b.SetGrow(1.f);
+	c.SetSize(50, 30);
+	c.SetGrow(3.f);
+
+	panel.AddChild(&a);
+	panel.AddChild(&b);
+	panel.AddChild(&c);
+
+	absolute.SetRect(20, 30, 75, 24);
+
+	GUILayout::Solve(&root, _glt_Rect(0, 0, 1280, 720), result);
+
+	// Every node below the root
+	TEST_CHECK(result.nodesSolved == 5);
+	TEST_CHECK(panel.GetRect() == _glt_Rect(650, 10, 620, 700));
+	TEST_CHECK(absolute.GetRect() == _glt_Rect(20, 30, 75, 24));
+
+	// 612px of content from x = 654; the free space is shared 1:3 and the last child ends at the padding
+	TEST_CHECK(a.GetRect() == _glt_Rect(654, 14, 100, 692));
+	TEST_CHECK(b.GetRect().x == 759);
+	TEST_CHECK(c.GetRect().x == b.GetRect().x + b.GetRect().w + 5);
+	TEST_CHECK(c.GetRect().x + c.GetRect().w == 654 + 612);
+	TEST_CHECK(c.GetRect().w - 50 > 2 * (b.GetRect().w - 50));
+
+	// Nothing changed, nothing is visited
+	GUILayout::Solve(&root, _glt_Rect(0, 0, 1280, 720), result);
+	TEST_CHECK(result.nodesSolved == 0);
+	TEST_CHECK(result.changed.empty() && result.dirtyRects.empty());
+
+	// A move dirties the old and new area
+	absolute.SetPosition(40, 30);
+	GUILayout::Solve(&root, _glt_Rect(0, 0, 1280, 720), result);
+	TEST_CHECK(result.changed.size() == 1 && result.changed[0] == &absolute);
+	TEST_CHECK(result.dirtyRects.size() == 1 && result.dirtyRects[0] == _glt_Rect(20, 30, 95, 24));
+
+	// Hidden children leave their space to the others
+	const int cWidth{ c.GetRect().w };
+	b.SetVisible(false);
+	GUILayout::Solve(&root, _glt_Rect(0, 0, 1280, 720), result);
+	TEST_CHECK(c.GetRect().x == 759);
+	TEST_CHECK(c.GetRect().w > cWidth);
+	TEST_CHECK(!result.dirtyRects.empty());
+
+	// Resizing the screen re-anchors the panel
+	GUILayout::Solve(&root, _glt_Rect(0, 0, 1920, 1080), result);
+	TEST_CHECK(panel.GetRect() == _glt_Rect(970, 10, 940, 1060));
+	TEST_CHECK(absolute.GetRect() == _glt_Rect(40, 30, 75, 24));
+
+	// A recolour keeps the rect and only reports the node
+	c.MarkContentDirty();
+	GUILayout::Solve(&root, _glt_Rect(0, 0, 1920, 1080), result);
+	TEST_CHECK(result.changed.size() == 1 && result.changed[0] == &c);
+	TEST_CHECK(result.dirtyRects.size() == 1 && result.dirtyRects[0] == c.GetRect());
+
+	// Removed nodes are not solved with their old parent
+	panel.RemoveChild(&c);
+	TEST_CHECK(c.GetParent() == nullptr);
+	TEST_CHECK(panel.GetChildren().size() == 2);
+}
+
+static void _glt_TestDestroyedParent()
+{
+	GUILayoutNode root{}, child{};
+	GUILayoutResult result{};
+
+	{
+		GUILayoutNode parent{};
+		root.AddChild(&parent);
+		parent.AddChild(&child);
+
+		GUILayout::Solve(&root, _glt_Rect(0, 0, 640, 480), result);
+		TEST_CHECK(child.GetParent() == &parent);
+	}
+
+	// The child is detached and the root no longer reaches it
+	TEST_CHECK(child.GetParent() == nullptr);
+	TEST_CHECK(root.GetChildren().empty());
+
+	GUILayout::Solve(&root, _glt_Rect(0, 0, 640, 480), result);
+	TEST_CHECK(result.changed.empty());
+}
+
+static void _glt_TestBatching()
+{
+	GUIBatcher batcher{};
+	int blank{ 0 }, icon{ 0 };
+
+	// Boxes without a texture are drawn in one batch
+	batcher.Begin();
+	for (int i = 0; i < 300; ++i)
+		_glt_AddQuad(batcher, (i % 20) * 64.f, (i / 20) * 40.f, 60.f, 36.f, &blank);
+	batcher.End();
+
+	TEST_CHECK(batcher.GetBatches().size() == 1);
+	TEST_CHECK(batcher.GetQuadCount() == 300);
+	TEST_CHECK(batcher.GetVertices().size() == 1200);
+
+	// Quads that do not overlap are grouped by texture
+	batcher.Begin();
+	for (int i = 0; i < 300; ++i)
+		_glt_AddQuad(batcher, (i % 20) * 64.f, (i / 20) * 40.f, 60.f, 36.f, (i & 1) ? (const void *)&icon : (const void *)&blank);
+	batcher.End();
+
+	TEST_CHECK(batcher.GetBatches().size() == 2);
+	TEST_CHECK(batcher.GetBatches()[0].quadCount == 150 && batcher.GetBatches()[1].quadCount == 150);
+
+	// Icons on panels, then a panel over the first icon: it must stay on top
+	batcher.Begin();
+	_glt_AddQuad(batcher, 0.f, 0.f, 100.f, 100.f, &blank);
+	_glt_AddQuad(batcher, 10.f, 10.f, 20.f, 20.f, &icon);
+	_glt_AddQuad(batcher, 200.f, 0.f, 100.f, 100.f, &blank);
+	_glt_AddQuad(batcher, 210.f, 10.f, 20.f, 20.f, &icon);
+	_glt_AddQuad(batcher, 5.f, 5.f, 30.f, 30.f, &blank);
+	batcher.End();
+
+	const std::vector<GUIBatch> &batches{ batcher.GetBatches() };
+	TEST_CHECK(batches.size() == 3);
+	if (batches.size() == 3)
+	{
+		TEST_CHECK(batches[0].texture == &blank && batches[0].firstQuad == 0 && batches[0].quadCount == 2);
+		TEST_CHECK(batches[1].texture == &icon && batches[1].firstQuad == 2 && batches[1].quadCount == 2);
+		TEST_CHECK(batches[2].texture == &blank && batches[2].firstQuad == 4 && batches[2].quadCount == 1);
+	}
+
+	// Vertices follow the batch order
+	TEST_CHECK(batcher.GetVertices().size() == 20);
+	TEST_CHECK(batcher.GetVertices()[4].posAndUV.x == 200.f);
+	TEST_CHECK(batcher.GetVertices()[16].posAndUV.x == 5.f);
+
+	// Nothing submitted, nothing drawn
+	batcher.Begin();
+	batcher.End();
+	TEST_CHECK(batcher.GetBatches().empty() && batcher.GetVertices().empty());
+}
+
+static void _glt_Benchmark()
+{
+	static GUILayoutNode root, rows[GLT_BENCH_ROWS], cells[GLT_BENCH_ROWS][GLT_BENCH_COLUMNS];
+	GUILayoutResult result{};
+	const Rect bounds{ _glt_Rect(0, 0, 1920, 1080) };
+
+	root.SetDirection(LayoutDirection::Column, 2, 8);
+	for (int r = 0; r < GLT_BENCH_ROWS; ++r)
+	{
+		root.AddChild(&rows[r]);
+		rows[r].SetAnchors(vec2(0.f), vec2(1.f, 0.f), Point(0, 0), Point(0, 24));
+		rows[r].SetGrow(1.f);
+		rows[r].SetDirection(LayoutDirection::Row, 2, 0);
+
+		for (int c = 0; c < GLT_BENCH_COLUMNS; ++c)
+		{
+			rows[r].AddChild(&cells[r][c]);
+			cells[r][c].SetAnchors(vec2(0.f), vec2(0.f, 1.f), Point(0, 0), Point(20, 0));
+			cells[r][c].SetGrow(1.f);
+		}
+	}
+
+	double start{ Test::Time() };
+	GUILayout::Solve(&root, bounds, result);
+	const double initial{ Test::Time() - start };
+	const uint32_t nodes{ result.nodesSolved };
+
+	start = Test::Time();
+	for (int i = 0; i < GLT_BENCH_FRAMES; ++i)
+		GUILayout::Solve(&root, bounds, result);
+	const double idle{ Test::Time() - start };
+
+	start = Test::Time();
+	for (int i = 0; i < GLT_BENCH_FRAMES; ++i)
+	{
+		cells[7][3].MarkContentDirty();
+		GUILayout::Solve(&root, bounds, result);
+	}
+	const double recolour{ Test::Time() - start };
+
+	GUIBatcher batcher{};
+	int textures[3]{};
+
+	start = Test::Time();
+	for (int i = 0; i < 100; ++i)
+	{
+		batcher.Begin();
+		for (int r = 0; r < GLT_BENCH_ROWS; ++r)
+		{
+			for (int c = 0; c < GLT_BENCH_COLUMNS; ++c)
+			{
+				const Rect &rect{ cells[r][c].GetRect() };
+				_glt_AddQuad(batcher, (float)rect.x, (float)rect.y, (float)rect.w, (float)rect.h, &textures[(r + c) % 3]);
+			}
+		}
+		batcher.End();
+	}
+	const double batching{ Test::Time() - start };
+
+	printf("Solve %u nodes: %.1f us, idle %.3f us, one recolour %.3f us (%u nodes)\n", nodes, initial * 1000.0,
+		idle * 1000.0 / GLT_BENCH_FRAMES, recolour * 1000.0 / GLT_BENCH_FRAMES, result.nodesSolved);
+	printf("Batch %u quads over 3 textures: %d batches, %.1f us\n", batcher.GetQuadCount(), (int)batcher.GetBatches().size(), batching * 10.0);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_glt_TestLayout();
+	_glt_TestDestroyedParent();
+	_glt_TestBatching();
+
+	if (Test::Benchmark())
+		_glt_Benchmark();
+
+	return Test::Result();
+}
@@ -0,0 +1,308 @@
+/* NekoEngine
+ *
+ * GlyphCacheTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Glyph atlas packer, UTF-8 decoding and text layout tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+#include <Renderer/GlyphCache.h>
+
+#include "Test.h"
+
+#define GCT_ATLAS_SIZE		256
+#define GCT_PACKER_SIZE		512
+#define GCT_PACKER_RECTS	5000
+#define GCT_KERNING			-3
+#define GCT_BENCH_STRINGS	20000
+
+using namespace std;
+using namespace glm;
+
+/**
+ * Glyph source with predictable bitmaps: each pixel holds the low byte of
+ * the codepoint and the rows are padded to twice the width.
+ */
+class TestGlyphSource : public GlyphSource
+{
+public:
+	int rasterized{ 0 };
+
+	bool RasterizeGlyph(uint32_t codepoint, int pixelSize, GlyphBitmap &bitmap) override
+	{
+		++rasterized;
+
+		if (codepoint == ' ')
+		{
+			bitmap.size = ivec2(0);
+			bitmap.advance = pixelSize / 3;
+			return true;
+		}
+
+		const int width{ pixelSize / 2 + (int)(codepoint % 5) };
+		_data.assign(width * pixelSize * 2, (uint8_t)codepoint);
+
+		bitmap.size = ivec2(width, pixelSize);
+		bitmap.bearing = ivec2(1, pixelSize * 3 / 4);
+		bitmap.advance = width + 2;
+		bitmap.pitch = width * 2;
+		bitmap.data = _data.data();
+
+		return true;
+	}
+
+	int GetKerning(uint32_t left, uint32_t right, int pixelSize) override
+	{
+		return (left == 'A' && right == 'V') ? GCT_KERNING : 0;
+	}
+
+	void GetMetrics(int pixelSize, FontMetrics &metrics) override
+	{
+		metrics.ascender = pixelSize * 3 / 4;
+		metrics.lineHeight = pixelSize + pixelSize / 4;
+	}
+
+private:
+	vector<uint8_t> _data;
+};
+
+static bool _gct_Overlap(const uvec4 &a, const uvec4 &b)
+{
+	return a.x < b.x + b.z && b.x < a.x + a.z && a.y < b.y + b.w && b.y < a.y + a.w;
+}
+
+static void _gct_TestPacker()
+{
+	SkylinePacker packer{ GCT_PACKER_SIZE, GCT_PACKER_SIZE };
+	mt19937 rng{ 1 };
+	vector<uvec4> rects{};
+
+	for (int i = 0; i < GCT_PACKER_RECTS; ++i)
+	{
+		const uint32_t width{ 4 + (uint32_t)(rng() % 28) }, height{ 8 + (uint32_t)(rng() % 24) };
+		uvec2 pos{};
+
+		if (!packer.Pack(width, height, pos))
+			break;
+
+		rects.push_back(uvec4(pos, width, height));
+	}
+
+	bool inside{ true }, disjoint{ true };
+	for (size_t i = 0; i < rects.size(); ++i)
+	{
+		const uvec4 &r{ rects[i] };
+		if (r.x + r.z > GCT_PACKER_SIZE || r.y + r.w > GCT_PACKER_SIZE)
+			inside = false;
+
+		for (size_t j = i + 1; j < rects.size(); ++j)
+			if (_gct_Overlap(r, rects[j]))
+				disjoint = false;
+	}
+
+	TEST_CHECK(inside);
+	TEST_CHECK(disjoint);
+	TEST_CHECK(rects.size() > 500);
+	TEST_CHECK(packer.GetOccupancy() > .85f);
+
+	// A rectangle larger than the atlas never fits
+	uvec2 pos{};
+	packer.Reset();
+	TEST_CHECK(packer.GetOccupancy() == 0.f);
+	TEST_CHECK(!packer.Pack(GCT_PACKER_SIZE + 1, 1, pos));
+	TEST_CHECK(packer.Pack(GCT_PACKER_SIZE, GCT_PACKER_SIZE, pos) && pos == uvec2(0));
+	TEST_CHECK(!packer.Pack(1, 1, pos));
+}
+
+static void _gct_TestUTF8()
+{
+	// 1 to 4 byte sequences, a truncated sequence, a surrogate and an overlong encoding
+	const char *text{ "A\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\xC3\x41\xED\xA0\x80\xC0\xAF" };
+	const char *end{ text + strlen(text) };
+
+	vector<uint32_t> codepoints{};
+	while (text < end)
+		codepoints.push_back(GlyphCache::DecodeUTF8(text, end));
+
+	const vector<uint32_t> expected{ 'A', 0xE9, 0x20AC, 0x1F600, GLYPH_REPLACEMENT_CHAR, 'A', GLYPH_REPLACEMENT_CHAR, GLYPH_REPLACEMENT_CHAR };
+	TEST_CHECK(codepoints == expected);
+	TEST_CHECK(text == end);
+}
+
+static void _gct_TestLayout()
+{
+	TestGlyphSource source{};
+	GlyphCache cache{ &source, GCT_ATLAS_SIZE, GCT_ATLAS_SIZE };
+	vector<PlacedGlyph> glyphs{};
+
+	// Spaces advance without a glyph; AV is kerned
+	const int width{ cache.Layout("AV A", 4, 20, glyphs) };
+	TEST_CHECK(glyphs.size() == 3);
+	if (glyphs.size() != 3)
+		return;
+
+	const GlyphInfo *a{ cache.GetGlyph('A', 20) };
+	TEST_CHECK(glyphs[1].position.x == glyphs[0].position.x + a->advance + GCT_KERNING);
+	TEST_CHECK(glyphs[2].position.x == glyphs[1].position.x + cache.GetGlyph('V', 20)->advance + cache.GetGlyph(' ', 20)->advance);
+	TEST_CHECK(width == glyphs[2].position.x - a->bearing.x + a->advance);
+	TEST_CHECK(glyphs[0].position.y == -a->bearing.y);
+
+	// Glyphs are rasterized once per size
+	const int rasterized{ source.rasterized };
+	TEST_CHECK(cache.Measure("AV A", 4, 20) == width);
+	TEST_CHECK(source.rasterized == rasterized);
+
+	cache.Measure("AV A", 4, 32);
+	TEST_CHECK(source.rasterized == rasterized + 3);
+	TEST_CHECK(cache.GetGlyph('A', 20) != cache.GetGlyph('A', 32));
+	TEST_CHECK(cache.GetGlyph('A', 32)->size.y == 32);
+
+	// New lines return to the origin and advance by the line height
+	glyphs.clear();
+	cache.Layout("A\nA", 3, 20, glyphs);
+	TEST_CHECK(glyphs.size() == 2);
+	if (glyphs.size() == 2)
+	{
+		TEST_CHECK(glyphs[1].position.x == glyphs[0].position.x);
+		TEST_CHECK(glyphs[1].position.y - glyphs[0].position.y == cache.GetMetrics(20).lineHeight);
+	}
+}
+
+static void _gct_TestUploads()
+{
+	TestGlyphSource source{};
+	GlyphCache cache{ &source, GCT_ATLAS_SIZE, GCT_ATLAS_SIZE };
+
+	cache.Measure("ABC", 3, 20);
+
+	const vector<GlyphUpload> &uploads{ cache.GetPendingUploads() };
+	TEST_CHECK(uploads.size() == 3);
+
+	// Rows are copied without the source padding
+	bool aligned{ true }, copied{ true };
+	for (const GlyphUpload &upload : uploads)
+	{
+		if (upload.offset % 4)
+			aligned = false;
+
+		const uint8_t *data{ cache.GetUploadData() + upload.offset };
+		const uint8_t value{ data[0] };
+		for (uint32_t i = 0; i < upload.width * upload.height; ++i)
+			if (data[i] != value)
+				copied = false;
+
+		TEST_CHECK(value == 'A' || value == 'B' || value == 'C');
+	}
+
+	TEST_CHECK(aligned);
+	TEST_CHECK(copied);
+
+	const GlyphInfo *a{ cache.GetGlyph('A', 20) };
+	TEST_CHECK(uploads[0].x == (uint32_t)a->position.x && uploads[0].y == (uint32_t)a->position.y);
+	TEST_CHECK(uploads[0].width == (uint32_t)a->size.x && uploads[0].height == (uint32_t)a->size.y);
+
+	cache.ClearPendingUploads();
+	TEST_CHECK(cache.GetPendingUploads().empty());
+	TEST_CHECK(cache.GetUploadDataSize() == 0);
+
+	// Cached glyphs are not uploaded again
+	cache.Measure("CAB", 3, 20);
+	TEST_CHECK(cache.GetPendingUploads().empty());
+}
+
+static void _gct_TestOverflow()
+{
+	TestGlyphSource source{};
+	GlyphCache cache{ &source, GCT_ATLAS_SIZE, GCT_ATLAS_SIZE };
+
+	uint32_t codepoint{ 0x4E00 };
+	while (!cache.IsFull() && codepoint < 0x9FFF)
+		cache.GetGlyph(codepoint++, 40);
+
+	TEST_CHECK(cache.IsFull());
+
+	// The glyph that did not fit keeps its advance and is not drawn
+	const GlyphInfo *last{ cache.GetGlyph(codepoint - 1, 40) };
+	TEST_CHECK(last->size.x == 0 && last->advance > 0);
+
+	cache.Reset();
+	TEST_CHECK(!cache.IsFull());
+	TEST_CHECK(cache.GetGlyphCount() == 0);
+	TEST_CHECK(cache.GetPendingUploads().empty());
+	TEST_CHECK(cache.GetGlyph(codepoint - 1, 40)->size.x > 0);
+}
+
+static void _gct_Benchmark()
+{
+	TestGlyphSource source{};
+	GlyphCache cache{ &source, 1024, 1024 };
+
+	const char *text{ "The quick brown fox jumps over the lazy dog 0123456789" };
+	const size_t length{ strlen(text) };
+	vector<PlacedGlyph> glyphs{};
+	glyphs.reserve(length);
+
+	cache.Layout(text, length, 16, glyphs);
+
+	const double start{ Test::Time() };
+	for (int i = 0; i < GCT_BENCH_STRINGS; ++i)
+	{
+		glyphs.clear();
+		cache.Layout(text, length, 16, glyphs);
+	}
+	const double layout{ Test::Time() - start };
+
+	printf("Layout: %.3f us per string of %d glyphs\n", layout * 1000.0 / GCT_BENCH_STRINGS, (int)glyphs.size());
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_gct_TestPacker();
+	_gct_TestUTF8();
+	_gct_TestLayout();
+	_gct_TestUploads();
+	_gct_TestOverflow();
+
+	if (Test::Benchmark())
+		_gct_Benchmark();
+
+	return Test::Result();
+}
@@ -0,0 +1,310 @@
+/* NekoEngine
+ *
+ * HotReloadTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * File watcher, reload queue and script reload tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <thread>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <Engine/Engine.h>
+#include <Engine/EventManager.h>
+#include <Engine/ResourceManager.h>
+#include <Platform/FileWatcher.h>
+#include <Resource/ShaderModuleResource.h>
+
+#include "Test.h"
+#include "ScriptTest.h"
+
+#define HRT_DELAY		100
+
+using namespace std;
+
+/**
+ * Shader module that counts its reloads; ResourceManager::GetResourcesOfType
+ * below returns it in place of the resources loaded by the engine.
+ */
+struct TestShaderModule : public Resource
+{
+	int reloads{ 0 };
+	bool fail{ false };
+
+	TestShaderModule(const char *path)
+	{
+		ShaderModuleResource *ri{ new ShaderModuleResource() };
+		ri->name = "test_shader";
+		ri->filePath = path;
+		_resourceInfo = ri;
+	}
+
+	int Load() override { return ENGINE_OK; }
+	int Reload() override { ++reloads; return fail ? ENGINE_FAIL : ENGINE_OK; }
+
+	~TestShaderModule() noexcept { delete _resourceInfo; }
+};
+
+static string _hrt_root{};
+static TestShaderModule *_hrt_shader{ nullptr };
+
+NArray<Resource *> ResourceManager::GetResourcesOfType(ResourceType type) noexcept
+{
+	NArray<Resource *> ret{};
+
+	if (_hrt_shader && type == ResourceType::RES_SHADERMODULE)
+		ret.Add(_hrt_shader);
+
+	return ret;
+}
+
+static void _hrt_Write(const char *file, const char *data)
+{
+	FILE *fp{ fopen((_hrt_root + file).c_str(), "w") };
+	TEST_CHECK(fp != nullptr);
+	if (!fp)
+		return;
+
+	fputs(data, fp);
+	fclose(fp);
+}
+
+static void _hrt_Sleep(int ms)
+{
+	this_thread::sleep_for(chrono::milliseconds(ms));
+}
+
+static bool _hrt_Reported(const vector<string> &paths, const char *path)
+{
+	return count(paths.begin(), paths.end(), path) == 1;
+}
+
+static void _hrt_TestWatcher()
+{
+	TEST_CHECK(FileWatcher::Initialize(_hrt_root.c_str()) == ENGINE_OK);
+	TEST_CHECK(FileWatcher::IsActive());
+
+	_hrt_Write("/scripts/a.lua", "a");
+
+	// Files written to a new directory before its watch is added are found by scanning it
+	TEST_CHECK(mkdir((_hrt_root + "/new").c_str(), 0755) == 0);
+	_hrt_Write("/new/b.lua", "b");
+
+	// Moving a file in is a change, the old name is not
+	_hrt_Write("/c.tmp", "c");
+	TEST_CHECK(rename((_hrt_root + "/c.tmp").c_str(), (_hrt_root + "/scripts/c.lua").c_str()) == 0);
+
+	vector<string> paths{};
+	FileWatcher::Poll(paths);
+
+	TEST_CHECK(_hrt_Reported(paths, "/scripts/a.lua"));
+	TEST_CHECK(_hrt_Reported(paths, "/new/b.lua"));
+	TEST_CHECK(_hrt_Reported(paths, "/scripts/c.lua"));
+	TEST_CHECK(_hrt_Reported(paths, "/c.tmp"));
+	TEST_CHECK(paths.size() == 4);
+
+	// Files in the new directory are watched
+	paths.clear();
+	_hrt_Write("/new/b.lua", "bb");
+	FileWatcher::Poll(paths);
+	TEST_CHECK(paths.size() == 1 && paths[0] == "/new/b.lua");
+
+	paths.clear();
+	FileWatcher::Poll(paths);
+	TEST_CHECK(paths.empty());
+}
+
+static void _hrt_TestQueue()
+{
+	string order{};
+	int reloadedCount{ -1 };
+
+	EventManager::RegisterHandler(NE_EVT_RES_RELOADING, [&](int32_t, void *) { order += "begin;"; });
+	EventManager::RegisterHandler(NE_EVT_RES_RELOADED, [&](int32_t, void *args) {
+		order += "end;";
+		reloadedCount = (int)((NArray<Resource *> *)args)->Count();
+	});
+
+	_hrt_shader = new TestShaderModule("/shaders/test.spv");
+
+	// Repeated writes are reloaded once, after the file has not changed for the delay
+	for (int i = 0; i < 5; ++i)
+	{
+		_hrt_Write("/shaders/test.spv", "spv");
+		ResourceManager::Update();
+		_hrt_Sleep(HRT_DELAY / 4);
+	}
+
+	TEST_CHECK(_hrt_shader->reloads == 0);
+	TEST_CHECK(ResourceManager::GetPendingReloadCount() == 1);
+
+	_hrt_Sleep(HRT_DELAY + 20);
+	ResourceManager::Update();
+
+	TEST_CHECK(_hrt_shader->reloads == 1);
+	TEST_CHECK(ResourceManager::GetPendingReloadCount() == 0);
+	TEST_CHECK(order == "begin;end;");
+	TEST_CHECK(reloadedCount == 1);
+
+	// A failed reload is logged and the resource is not reported as reloaded
+	const uint32_t errors{ Test::GetLogCount(LOG_CRITICAL) };
+	_hrt_shader->fail = true;
+	_hrt_Write("/shaders/test.spv", "bad");
+	ResourceManager::Update();
+	_hrt_Sleep(HRT_DELAY + 20);
+	ResourceManager::Update();
+
+	TEST_CHECK(_hrt_shader->reloads == 2);
+	TEST_CHECK(Test::GetLogCount(LOG_CRITICAL) == errors + 1);
+	TEST_CHECK(reloadedCount == 0);
+
+	// Files no resource uses are ignored
+	order.clear();
+	_hrt_Write("/shaders/other.spv", "spv");
+	ResourceManager::Update();
+	_hrt_Sleep(HRT_DELAY + 20);
+	ResourceManager::Update();
+
+	TEST_CHECK(_hrt_shader->reloads == 2);
+	TEST_CHECK(order.empty());
+
+	delete _hrt_shader;
+	_hrt_shader = nullptr;
+}
+
+static void _hrt_TestScripts()
+{
+	TestWriteFile("/scripts/s.lua",
+		"count = 0\n"
+		"local step = 1\n"
+		"local function inc() count = count + step end\n"
+		"function Update(dt) inc() end\n");
+
+	TestScriptComponent *a{ TestNewScript("/scripts/s.lua") };
+	TestScriptComponent *b{ TestNewScript("/scripts/s.lua") };
+	TEST_CHECK(a && b);
+	if (!a || !b)
+		return;
+
+	for (int i = 0; i < 3; ++i)
+		a->Update(.1);
+	b->Update(.1);
+
+	// The new chunk runs on the existing instance tables
+	TestWriteFile("/scripts/s.lua",
+		"count = 0\n"
+		"extra = 5\n"
+		"local step = 10\n"
+		"local function inc() count = count + step end\n"
+		"function Update(dt) inc() end\n"
+		"function OnReload() reloaded = (reloaded or 0) + 1 end\n");
+
+	// Scripts are reloaded through the queue, after the delay
+	ResourceManager::QueueReload("scripts/s.lua");
+	ResourceManager::Update();
+	TEST_CHECK(isnan(TestGetNumber(a, "reloaded")));
+
+	_hrt_Sleep(HRT_DELAY + 20);
+	ResourceManager::Update();
+
+	a->Update(.1);
+	b->Update(.1);
+
+	TEST_CHECK(TestGetNumber(a, "count") == 13.0);
+	TEST_CHECK(TestGetNumber(b, "count") == 11.0);
+	TEST_CHECK(TestGetNumber(a, "extra") == 5.0);
+	TEST_CHECK(TestGetNumber(a, "reloaded") == 1.0);
+	TEST_CHECK(TestGetNumber(b, "reloaded") == 1.0);
+
+	// A script that does not compile keeps the previous code
+	const uint32_t errors{ Test::GetLogCount(LOG_CRITICAL) };
+	TestWriteFile("/scripts/s.lua", "function Update(dt) count = count + \n");
+
+	TEST_CHECK(ScriptComponent::ReloadScript("/scripts/s.lua") == 0);
+	TEST_CHECK(Test::GetLogCount(LOG_CRITICAL) > errors);
+
+	a->Update(.1);
+	TEST_CHECK(TestGetNumber(a, "count") == 23.0);
+	TEST_CHECK(lua_gettop(Script::GetState()) == 0);
+
+	// Components loaded after the failed reload use the last good version
+	TestScriptComponent *c{ TestNewScript("/scripts/s.lua") };
+	TEST_CHECK(c != nullptr);
+	if (c)
+	{
+		c->Update(.1);
+		TEST_CHECK(TestGetNumber(c, "count") == 10.0);
+	}
+
+	delete a;
+	delete b;
+	delete c;
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	EngineConfig &config{ Engine::GetConfiguration().Engine };
+	config.HotReloadDelay = HRT_DELAY;
+
+	char root[] = "/tmp/hotreload_XXXXXX";
+	TEST_CHECK(mkdtemp(root) != nullptr);
+	_hrt_root = root;
+
+	TEST_CHECK(mkdir((_hrt_root + "/scripts").c_str(), 0755) == 0);
+	TEST_CHECK(mkdir((_hrt_root + "/shaders").c_str(), 0755) == 0);
+
+	_hrt_TestWatcher();
+	_hrt_TestQueue();
+	_hrt_TestScripts();
+
+	FileWatcher::Release();
+	TEST_CHECK(!FileWatcher::IsActive());
+
+	Script::Release();
+
+	system(("rm -rf " + _hrt_root).c_str());
+
+	return Test::Result();
+}
@@ -0,0 +1,319 @@
+/* NekoEngine
+ *
+ * LightClustersTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Clustered light assignment tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <Engine/Defs.h>
+#include <Engine/TaskManager.h>
+#include <Renderer/Renderer.h>
+#include <Renderer/LightClusters.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Test.h"
+
+#define LCT_SEED			3
+#define LCT_LIGHTS			10000
+#define LCT_NEAR			.1f
+#define LCT_FAR				500.f
+#define LCT_SAMPLES			20
+#define LCT_BENCH_RUNS		50
+
+using namespace std;
+using namespace glm;
+
+static mat4 _lct_View()
+{
+	return lookAt(vec3(10.f, 5.f, 20.f), vec3(0.f, 0.f, -100.f), vec3(0.f, 1.f, 0.f));
+}
+
+static mat4 _lct_Projection()
+{
+	return perspective(radians(60.f), 16.f / 9.f, LCT_NEAR, LCT_FAR);
+}
+
+// Mostly point and spot lights spread around the camera, with a few
+// directional lights, dim lights and lights that cross the near plane
+static void _lct_MakeLights(vector<Light> &lights, uint32_t count, uint32_t seed)
+{
+	mt19937 rng{ seed };
+	uniform_real_distribution<float> pos{ -300.f, 300.f }, radius{ .5f, 40.f }, unit{ 0.f, 1.f };
+
+	lights.resize(count);
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		Light &l{ lights[i] };
+		const float kind{ unit(rng) };
+
+		l.position = vec4(pos(rng), pos(rng) * .2f, pos(rng), (float)(rng() % 2 ? LT_Point : LT_Spot));
+		l.direction = vec4(0.f, -1.f, 0.f, 0.f);
+		l.color = vec4(1.f, 1.f, 1.f, 1.f);
+		l.data = vec4(1.f, radius(rng), 0.f, 0.f);
+
+		if (kind < .01f)
+			l.position.w = (float)LT_Directional;
+		else if (kind < .02f)
+			l.color.a = .01f;
+		else if (kind < .03f)
+			l.position = vec4(10.f + unit(rng), 5.f + unit(rng), 20.f + unit(rng), (float)LT_Point);
+	}
+}
+
+static bool _lct_SameBounds(const LightClusterBounds &a, const LightClusterBounds &b)
+{
+	if (a.visible != b.visible)
+		return false;
+
+	return !a.visible || (a.x0 == b.x0 && a.x1 == b.x1 && a.y0 == b.y0 && a.y1 == b.y1 && a.z0 == b.z0 && a.z1 == b.z1);
+}
+
+static void _lct_TestArguments()
+{
+	LightClusters clusters;
+	Light light{};
+
+	TEST_CHECK(clusters.Build(_lct_View(), _lct_Projection(), 0.f, LCT_FAR, &light, 1) == ENGINE_INVALID_ARGS);
+	TEST_CHECK(clusters.Build(_lct_View(), _lct_Projection(), LCT_FAR, LCT_NEAR, &light, 1) == ENGINE_INVALID_ARGS);
+	TEST_CHECK(clusters.Build(_lct_View(), _lct_Projection(), LCT_NEAR, LCT_FAR, &light, LC_MAX_LIGHTS + 1) == ENGINE_INVALID_ARGS);
+	TEST_CHECK(Test::GetLogCount(LOG_CRITICAL) == 3);
+
+	TEST_CHECK(clusters.Build(_lct_View(), _lct_Projection(), LCT_NEAR, LCT_FAR, nullptr, 0) == ENGINE_OK);
+	TEST_CHECK(clusters.GetIndexCount() == 0 && clusters.GetGlobalLights().empty());
+
+	// The grid size is clamped
+	LightClusters large{ 100, 0, 1000 };
+	TEST_CHECK(large.GetTilesX() == LC_MAX_TILES && large.GetTilesY() == 1 && large.GetSlices() == 255);
+}
+
+static void _lct_TestSlices()
+{
+	LightClusters clusters;
+	TEST_CHECK(clusters.Build(_lct_View(), _lct_Projection(), LCT_NEAR, LCT_FAR, nullptr, 0) == ENGINE_OK);
+
+	TEST_CHECK(clusters.GetSlice(0.f) == 0);
+	TEST_CHECK(clusters.GetSlice(LCT_NEAR) == 0);
+	TEST_CHECK(clusters.GetSlice(LCT_FAR * 2.f) == clusters.GetSlices() - 1);
+
+	bool monotonic{ true };
+	for (float d = LCT_NEAR; d < LCT_FAR; d *= 1.01f)
+		monotonic &= clusters.GetSlice(d) <= clusters.GetSlice(d * 1.01f);
+	TEST_CHECK(monotonic);
+
+	// Exponential spacing: every slice covers the same depth ratio
+	const float ratio{ powf(LCT_FAR / LCT_NEAR, 1.f / clusters.GetSlices()) };
+	TEST_CHECK(clusters.GetSlice(LCT_NEAR * powf(ratio, 5.5f)) == 5);
+	TEST_CHECK(clusters.GetSlice(LCT_NEAR * powf(ratio, 20.5f)) == 20);
+}
+
+// The SSE path and the scalar reference must produce the same bounds,
+// including for the tail that does not fill a group of four
+static void _lct_TestEquivalence()
+{
+	vector<Light> lights;
+	LightClusters clusters;
+
+	TaskManager::Initialize();
+
+	for (uint32_t count : { 1u, 3u, 4u, 7u, 513u, (uint32_t)LCT_LIGHTS })
+	{
+		_lct_MakeLights(lights, count, LCT_SEED + count);
+		TEST_CHECK(clusters.Build(_lct_View(), _lct_Projection(), LCT_NEAR, LCT_FAR, lights.data(), count) == ENGINE_OK);
+
+		vector<LightClusterBounds> reference(count);
+		clusters.ComputeBoundsReference(lights.data(), 0, count, reference.data());
+
+		uint32_t mismatches{ 0 }, visible{ 0 };
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (!_lct_SameBounds(clusters.GetBounds()[i], reference[i]))
+				++mismatches;
+			if (reference[i].visible)
+				++visible;
+		}
+
+		TEST_CHECK(mismatches == 0);
+		TEST_CHECK(count < 500 || visible > count / 10);
+	}
+
+	TaskManager::Release();
+}
+
+static void _lct_TestAssignment()
+{
+	vector<Light> lights;
+	LightClusters clusters;
+	const mat4 view{ _lct_View() }, projection{ _lct_Projection() };
+
+	_lct_MakeLights(lights, LCT_LIGHTS, LCT_SEED);
+
+	TaskManager::Initialize();
+	TEST_CHECK(clusters.Build(view, projection, LCT_NEAR, LCT_FAR, lights.data(), LCT_LIGHTS) == ENGINE_OK);
+	TaskManager::Release();
+
+	const LightCluster *c{ clusters.GetClusters() };
+	const uint16_t *indices{ clusters.GetIndices() };
+
+	// Lists are packed back to back and sorted by light index
+	uint32_t offset{ 0 };
+	bool packed{ true }, sorted{ true };
+	for (uint32_t i = 0; i < clusters.GetClusterCount(); ++i)
+	{
+		packed &= c[i].offset == offset;
+		offset += c[i].count;
+		for (uint32_t j = 1; j < c[i].count; ++j)
+			sorted &= indices[c[i].offset + j - 1] < indices[c[i].offset + j];
+	}
+	TEST_CHECK(packed && offset == clusters.GetIndexCount());
+	TEST_CHECK(sorted);
+
+	// Directional lights are global, dim lights are nowhere
+	size_t directional{ 0 };
+	bool dimSkipped{ true };
+	for (uint32_t i = 0; i < LCT_LIGHTS; ++i)
+	{
+		if ((uint32_t)lights[i].position.w == LT_Directional)
+			++directional;
+		else if (lights[i].color.a < 1.f)
+			dimSkipped &= !clusters.GetBounds()[i].visible;
+	}
+	TEST_CHECK(directional > 0 && clusters.GetGlobalLights().size() == directional);
+	TEST_CHECK(dimSkipped);
+
+	// Every point inside a light's sphere and inside the view volume lies
+	// in a cluster that lists the light
+	mt19937 rng{ LCT_SEED };
+	uniform_real_distribution<float> unit{ -1.f, 1.f };
+	uint32_t tested{ 0 }, missing{ 0 };
+
+	for (uint32_t i = 0; i < LCT_LIGHTS; ++i)
+	{
+		const Light &l{ lights[i] };
+		if ((uint32_t)l.position.w == LT_Directional || l.color.a < 1.f)
+			continue;
+
+		for (uint32_t s = 0; s < LCT_SAMPLES; ++s)
+		{
+			vec3 d{ unit(rng), unit(rng), unit(rng) };
+			if (dot(d, d) > 1.f)
+				continue;
+
+			const vec4 v{ view * vec4(vec3(l.position) + d * l.data.y, 1.f) };
+			const vec4 clip{ projection * v };
+			const float depth{ -v.z };
+
+			if (depth < LCT_NEAR || depth > LCT_FAR || fabsf(clip.x) > clip.w || fabsf(clip.y) > clip.w)
+				continue;
+
+			const uint32_t x{ std::min((uint32_t)((clip.x / clip.w * .5f + .5f) * clusters.GetTilesX()), clusters.GetTilesX() - 1) };
+			const uint32_t y{ std::min((uint32_t)((clip.y / clip.w * .5f + .5f) * clusters.GetTilesY()), clusters.GetTilesY() - 1) };
+			const LightCluster &cluster{ c[clusters.GetClusterIndex(x, y, clusters.GetSlice(depth))] };
+
+			++tested;
+			if (!binary_search(indices + cluster.offset, indices + cluster.offset + cluster.count, (uint16_t)i))
+				++missing;
+		}
+	}
+
+	TEST_CHECK(tested > LCT_LIGHTS);
+	TEST_CHECK(missing == 0);
+
+	// Same result no matter how the work is split
+	LightClusters serial;
+	TEST_CHECK(serial.Build(view, projection, LCT_NEAR, LCT_FAR, lights.data(), LCT_LIGHTS) == ENGINE_OK);
+	TEST_CHECK(serial.GetIndexCount() == clusters.GetIndexCount());
+	TEST_CHECK(equal(indices, indices + clusters.GetIndexCount(), serial.GetIndices()));
+}
+
+static void _lct_Benchmark()
+{
+	vector<Light> lights;
+	LightClusters clusters;
+	vector<LightClusterBounds> reference(LCT_LIGHTS);
+	double build{ 0.0 }, buildParallel{ 0.0 }, scalar{ 0.0 };
+
+	_lct_MakeLights(lights, LCT_LIGHTS, LCT_SEED);
+
+	for (uint32_t r = 0; r < LCT_BENCH_RUNS; ++r)
+	{
+		double start{ Test::Time() };
+		clusters.Build(_lct_View(), _lct_Projection(), LCT_NEAR, LCT_FAR, lights.data(), LCT_LIGHTS);
+		build += Test::Time() - start;
+
+		start = Test::Time();
+		clusters.ComputeBoundsReference(lights.data(), 0, LCT_LIGHTS, reference.data());
+		scalar += Test::Time() - start;
+	}
+
+	TaskManager::Initialize();
+	for (uint32_t r = 0; r < LCT_BENCH_RUNS; ++r)
+	{
+		double start{ Test::Time() };
+		clusters.Build(_lct_View(), _lct_Projection(), LCT_NEAR, LCT_FAR, lights.data(), LCT_LIGHTS);
+		buildParallel += Test::Time() - start;
+	}
+
+	uint32_t visible{ 0 };
+	for (uint32_t i = 0; i < LCT_LIGHTS; ++i)
+		if (clusters.GetBounds()[i].visible)
+			++visible;
+
+	printf("LightClusters: %d lights (%u in view), %u indices; build %.3f ms serial, %.3f ms on %u workers; scalar bounds %.3f ms\n",
+		LCT_LIGHTS, visible, (uint32_t)clusters.GetIndexCount(), build / LCT_BENCH_RUNS, buildParallel / LCT_BENCH_RUNS,
+		TaskManager::GetWorkerCount(), scalar / LCT_BENCH_RUNS);
+
+	TaskManager::Release();
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_lct_TestArguments();
+	_lct_TestSlices();
+	_lct_TestEquivalence();
+	_lct_TestAssignment();
+
+	if (Test::Benchmark())
+		_lct_Benchmark();
+
+	return Test::Result();
+}
@@ -0,0 +1,602 @@
+/* NekoEngine
+ *
+ * MemoryAllocatorTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * TLSF heap and device memory allocator tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include <Renderer/MemoryAllocator.h>
+
+#include "Test.h"
+
+#define MAT_HEAP_SIZE			(64 * 1024 * 1024)
+#define MAT_BLOCK_SIZE			(4 * 1024 * 1024)
+#define MAT_DEVICE_HEAP_SIZE	(256 * 1024 * 1024)
+#define MAT_FUZZ_SEED			7
+#define MAT_FUZZ_STEPS			100000
+#define MAT_FUZZ_LONG_SEEDS		32
+#define MAT_FUZZ_LONG_STEPS		1000000
+#define MAT_FUZZ_VALIDATE		997
+#define MAT_BENCH_OPS			1000000
+
+using namespace std;
+
+typedef struct MAT_DEVICE_COUNTERS
+{
+	uint32_t allocations, live, maps;
+	VkDeviceSize used, limit;
+} MatDeviceCounters;
+
+/**
+ * Two memory types on one heap: device local and host visible. Host memory is
+ * real so the tests can check what Defragment copies.
+ */
+class TestMemoryDevice : public MemoryDevice
+{
+public:
+	TestMemoryDevice(MatDeviceCounters *counters) : _counters(counters), _next(1) { }
+
+	virtual uint32_t GetMemoryTypeCount() override { return 2; }
+
+	virtual VkMemoryPropertyFlags GetMemoryTypeProperties(uint32_t type) override
+	{
+		return type ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	}
+
+	virtual VkDeviceSize GetMemoryTypeHeapSize(uint32_t type) override { return MAT_DEVICE_HEAP_SIZE; }
+
+	virtual bool AllocateMemory(uint32_t type, VkDeviceSize size, VkDeviceMemory &memory) override
+	{
+		if (_counters->used + size > _counters->limit)
+			return false;
+
+		uint64_t id{ _next++ };
+		_memory[id].size = size;
+
+		_counters->used += size;
+		++_counters->allocations;
+		++_counters->live;
+
+		memory = (VkDeviceMemory)id;
+		return true;
+	}
+
+	virtual void FreeMemory(VkDeviceMemory memory) override
+	{
+		_counters->used -= _memory[(uint64_t)memory].size;
+		--_counters->live;
+
+		_memory.erase((uint64_t)memory);
+	}
+
+	virtual uint8_t *MapMemory(VkDeviceMemory memory) override
+	{
+		TestMemory &mem{ _memory[(uint64_t)memory] };
+		mem.data.resize(mem.size);
+
+		++_counters->maps;
+		return mem.data.data();
+	}
+
+	virtual void UnmapMemory(VkDeviceMemory memory) override { --_counters->maps; }
+
+private:
+	struct TestMemory
+	{
+		VkDeviceSize size;
+		vector<uint8_t> data;
+	};
+
+	MatDeviceCounters *_counters;
+	map<uint64_t, TestMemory> _memory;
+	uint64_t _next;
+};
+
+static MemoryAllocator *_mat_NewAllocator(MatDeviceCounters &counters, VkDeviceSize limit = MAT_DEVICE_HEAP_SIZE)
+{
+	memset(&counters, 0x0, sizeof(counters));
+	counters.limit = limit;
+
+	return new MemoryAllocator(new TestMemoryDevice(&counters), MAT_BLOCK_SIZE);
+}
+
+static VkMemoryRequirements _mat_Requirements(VkDeviceSize size, VkDeviceSize alignment, uint32_t types = 3)
+{
+	VkMemoryRequirements req{};
+	req.size = size;
+	req.alignment = alignment;
+	req.memoryTypeBits = types;
+	return req;
+}
+
+static void _mat_TestHeap()
+{
+	TLSFHeap heap{ MAT_HEAP_SIZE };
+	VkDeviceSize a, b, c, d;
+
+	TEST_CHECK(heap.Validate());
+	TEST_CHECK(heap.GetLargestFree() == MAT_HEAP_SIZE);
+
+	uint32_t na{ heap.Allocate(1000, 1, a) };
+	uint32_t nb{ heap.Allocate(4096, 4096, b) };
+	uint32_t nc{ heap.Allocate(300, 256, c) };
+
+	TEST_CHECK(na != MEMORY_INVALID_NODE && nb != MEMORY_INVALID_NODE && nc != MEMORY_INVALID_NODE);
+	TEST_CHECK(a == 0);
+	TEST_CHECK(b % 4096 == 0 && b >= a + 1000);
+	TEST_CHECK(c % 256 == 0 && (c >= b + 4096 || c + 300 <= b));
+	TEST_CHECK(heap.GetAllocationCount() == 3);
+	TEST_CHECK(heap.Validate());
+
+	// The padding in front of an aligned allocation goes back to the free lists
+	TEST_CHECK(heap.GetUsed() < MEMORY_TLSF_MIN_SPLIT * 3 + 1000 + 4096 + 300);
+
+	uint32_t nd{ heap.Allocate(10, 1, d) };
+	TEST_CHECK(nd != MEMORY_INVALID_NODE);
+
+	// Remainders smaller than the split threshold stay with the allocation
+	TLSFHeap small{ 4096 };
+	uint32_t whole{ small.Allocate(4096 - MEMORY_TLSF_MIN_SPLIT + 1, 1, d) };
+	TEST_CHECK(whole != MEMORY_INVALID_NODE && small.GetUsed() == 4096);
+	small.Free(whole);
+	TEST_CHECK(small.Allocate(4096 - MEMORY_TLSF_MIN_SPLIT, 1, d) != MEMORY_INVALID_NODE && small.GetUsed() == 4096 - MEMORY_TLSF_MIN_SPLIT);
+	TEST_CHECK(small.Validate());
+
+	// Freeing the middle then both neighbours must coalesce back to one range
+	heap.Free(nb);
+	TEST_CHECK(heap.Validate());
+	heap.Free(na);
+	TEST_CHECK(heap.Validate());
+	heap.Free(nd);
+	TEST_CHECK(heap.Validate());
+	heap.Free(nc);
+	TEST_CHECK(heap.Validate());
+
+	TEST_CHECK(heap.GetUsed() == 0);
+	TEST_CHECK(heap.GetAllocationCount() == 0);
+	TEST_CHECK(heap.GetLargestFree() == MAT_HEAP_SIZE);
+
+	// Whole heap, then nothing more
+	uint32_t all{ heap.Allocate(MAT_HEAP_SIZE, 1, a) };
+	TEST_CHECK(all != MEMORY_INVALID_NODE && a == 0);
+	TEST_CHECK(heap.Allocate(1, 1, b) == MEMORY_INVALID_NODE);
+	TEST_CHECK(heap.GetLargestFree() == 0);
+	heap.Free(all);
+
+	TEST_CHECK(heap.Allocate(MAT_HEAP_SIZE + 1, 1, a) == MEMORY_INVALID_NODE);
+	TEST_CHECK(heap.Validate());
+
+	// Walk reports allocations in address order with their user data
+	int tags[4]{};
+	uint32_t nodes[4];
+	for (int i = 0; i < 4; ++i)
+		nodes[i] = heap.Allocate(1024, 256, a, &tags[i]);
+
+	heap.Free(nodes[1]);
+
+	vector<void *> walked{};
+	VkDeviceSize last{ 0 };
+	bool ordered{ true };
+	heap.Walk([&walked, &last, &ordered](VkDeviceSize offset, VkDeviceSize size, void *userData) {
+		ordered = ordered && offset >= last;
+		last = offset + size;
+		walked.push_back(userData);
+	});
+
+	TEST_CHECK(ordered);
+	TEST_CHECK(walked.size() == 3 && walked[0] == &tags[0] && walked[1] == &tags[2] && walked[2] == &tags[3]);
+
+	heap.Free(nodes[0]);
+	heap.Free(nodes[2]);
+	heap.Free(nodes[3]);
+	TEST_CHECK(heap.Validate() && heap.GetLargestFree() == MAT_HEAP_SIZE);
+}
+
+/**
+ * Random allocations and frees against a shadow map of the live ranges.
+ * Returns false on the first step that breaks an invariant.
+ */
+static bool _mat_Fuzz(uint32_t seed, uint32_t steps)
+{
+	mt19937 rng{ seed };
+	TLSFHeap heap{ MAT_HEAP_SIZE };
+
+	struct Live { VkDeviceSize end; uint32_t node; };
+	map<VkDeviceSize, Live> live{};
+	VkDeviceSize requested{ 0 };
+
+	for (uint32_t step = 0; step < steps; ++step)
+	{
+		const uint32_t op{ (uint32_t)(rng() % 100) };
+
+		if (op == 0)
+		{
+			// Occasionally empty the heap so every merge path runs
+			for (auto &it : live)
+				heap.Free(it.second.node);
+			live.clear();
+			requested = 0;
+
+			if (heap.GetUsed() || heap.GetLargestFree() != MAT_HEAP_SIZE)
+			{
+				fprintf(stderr, "Fuzz seed %u step %u: heap not empty after freeing everything\n", seed, step);
+				return false;
+			}
+		}
+		else if (live.empty() || op < 55)
+		{
+			const uint32_t kind{ (uint32_t)(rng() % 16) };
+			VkDeviceSize size;
+
+			if (kind == 0)
+				size = rng() % (4 * 1024 * 1024) + 1;
+			else if (kind < 4)
+				size = rng() % (256 * 1024) + 1;
+			else
+				size = rng() % 4096 + 1;
+
+			const VkDeviceSize alignment{ 1ull << (rng() % 13) };
+			VkDeviceSize offset;
+			uint32_t node{ heap.Allocate(size, alignment, offset) };
+
+			if (node == MEMORY_INVALID_NODE)
+				continue;
+
+			auto next{ live.lower_bound(offset) };
+			bool overlap{ next != live.end() && next->first < offset + size };
+			if (next != live.begin())
+				overlap = overlap || prev(next)->second.end > offset;
+
+			if (offset % alignment || offset + size > MAT_HEAP_SIZE || overlap)
+			{
+				fprintf(stderr, "Fuzz seed %u step %u: bad range [%llu, %llu) alignment %llu\n", seed, step,
+					(unsigned long long)offset, (unsigned long long)(offset + size), (unsigned long long)alignment);
+				return false;
+			}
+
+			live[offset] = { offset + size, node };
+			requested += size;
+		}
+		else
+		{
+			auto it{ live.begin() };
+			advance(it, rng() % live.size());
+
+			heap.Free(it->second.node);
+			requested -= it->second.end - it->first;
+			live.erase(it);
+		}
+
+		if (heap.GetAllocationCount() != live.size() || heap.GetUsed() < requested)
+		{
+			fprintf(stderr, "Fuzz seed %u step %u: %u allocations, %llu bytes used; expected %u, at least %llu\n", seed, step,
+				heap.GetAllocationCount(), (unsigned long long)heap.GetUsed(), (uint32_t)live.size(), (unsigned long long)requested);
+			return false;
+		}
+
+		if (step % MAT_FUZZ_VALIDATE)
+			continue;
+
+		bool match{ heap.Validate() };
+		auto it{ live.begin() };
+		heap.Walk([&match, &it, &live](VkDeviceSize offset, VkDeviceSize size, void *) {
+			match = match && it != live.end() && it->first == offset && it->second.end <= offset + size;
+			if (it != live.end()) ++it;
+		});
+
+		if (!match || it != live.end())
+		{
+			fprintf(stderr, "Fuzz seed %u step %u: heap does not match the live ranges\n", seed, step);
+			return false;
+		}
+	}
+
+	for (auto &it : live)
+		heap.Free(it.second.node);
+
+	if (!heap.Validate() || heap.GetUsed() || heap.GetLargestFree() != MAT_HEAP_SIZE)
+	{
+		fprintf(stderr, "Fuzz seed %u: heap not empty at the end\n", seed);
+		return false;
+	}
+
+	return true;
+}
+
+static void _mat_TestFuzz()
+{
+	TEST_CHECK(_mat_Fuzz(MAT_FUZZ_SEED, MAT_FUZZ_STEPS));
+
+	// --fuzz runs more seeds for longer; a failing seed is printed and can be rerun
+	if (!Test::HasArgument("--fuzz"))
+		return;
+
+	for (uint32_t seed = 1; seed <= MAT_FUZZ_LONG_SEEDS; ++seed)
+		TEST_CHECK(_mat_Fuzz(seed, MAT_FUZZ_LONG_STEPS));
+}
+
+static void _mat_TestPools()
+{
+	MatDeviceCounters counters;
+	MemoryAllocator *allocator{ _mat_NewAllocator(counters) };
+	vector<MemoryAllocation> linear(200), images(4), host(8);
+
+	for (size_t i = 0; i < linear.size(); ++i)
+	{
+		TEST_CHECK(allocator->Allocate(_mat_Requirements(4096 + (i % 4) * 4096, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			MemoryResourceType::Linear, linear[i], &linear[i]));
+		TEST_CHECK(linear[i].offset % 256 == 0 && !linear[i].dedicated && linear[i].memoryType == 0 && !linear[i].mapped);
+		TEST_CHECK(linear[i].owner == &linear[i]);
+	}
+
+	// Small buffers share one block
+	TEST_CHECK(counters.allocations == 1);
+	for (size_t i = 1; i < linear.size(); ++i)
+		TEST_CHECK(linear[i].memory == linear[0].memory);
+
+	// Optimal images never share a block with buffers
+	for (MemoryAllocation &image : images)
+	{
+		TEST_CHECK(allocator->Allocate(_mat_Requirements(64 * 1024, 4096), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryResourceType::Image, image));
+		TEST_CHECK(image.memory != linear[0].memory && image.offset % 4096 == 0);
+	}
+	TEST_CHECK(counters.allocations == 2);
+
+	// Host visible memory is mapped once per block
+	for (MemoryAllocation &mem : host)
+	{
+		TEST_CHECK(allocator->Allocate(_mat_Requirements(1000, 64), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, MemoryResourceType::Linear, mem));
+		TEST_CHECK(mem.memoryType == 1 && mem.mapped);
+		TEST_CHECK(mem.mapped - host[0].mapped == (ptrdiff_t)mem.offset - (ptrdiff_t)host[0].offset);
+	}
+	TEST_CHECK(counters.allocations == 3 && counters.maps == 1);
+
+	// No type in the mask has the properties
+	const uint32_t critical{ Test::GetLogCount(LOG_CRITICAL) };
+	MemoryAllocation none;
+	TEST_CHECK(!allocator->Allocate(_mat_Requirements(1000, 64, 1), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, MemoryResourceType::Linear, none));
+	TEST_CHECK(Test::GetLogCount(LOG_CRITICAL) == critical + 1);
+	TEST_CHECK(none.memory == VK_NULL_HANDLE);
+
+	MemoryStats stats;
+	allocator->GetStats(stats);
+	TEST_CHECK(stats.blockCount == 3 && stats.allocationCount == 212 && stats.dedicatedCount == 0);
+	TEST_CHECK(stats.blockBytes == 3 * MAT_BLOCK_SIZE);
+
+	for (MemoryAllocation &mem : linear)
+		allocator->Free(mem);
+	for (MemoryAllocation &mem : images)
+		allocator->Free(mem);
+	for (MemoryAllocation &mem : host)
+		allocator->Free(mem);
+
+	TEST_CHECK(linear[0].memory == VK_NULL_HANDLE && host[0].mapped == nullptr);
+
+	// One empty block is kept per pool so freeing and recreating a resource does not reach the driver
+	allocator->GetStats(stats);
+	TEST_CHECK(stats.allocationCount == 0 && stats.usedBytes == 0);
+	TEST_CHECK(stats.blockCount == 3 && counters.live == 3);
+
+	MemoryAllocation again;
+	TEST_CHECK(allocator->Allocate(_mat_Requirements(4096, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryResourceType::Linear, again));
+	TEST_CHECK(counters.allocations == 3);
+	allocator->Free(again);
+
+	// Double free is ignored
+	allocator->Free(again);
+
+	delete allocator;
+	TEST_CHECK(counters.live == 0 && counters.used == 0 && counters.maps == 0);
+}
+
+static void _mat_TestDedicated()
+{
+	MatDeviceCounters counters;
+	MemoryAllocator *allocator{ _mat_NewAllocator(counters) };
+	MemoryAllocation big, target, small, mapped;
+
+	// Larger than half a block
+	TEST_CHECK(allocator->Allocate(_mat_Requirements(MAT_BLOCK_SIZE / 2 + 1, 4096), 0, MemoryResourceType::Image, big));
+	TEST_CHECK(big.dedicated && big.offset == 0);
+
+	// Render targets are recreated on resize, so even an eighth of a block gets its own memory
+	TEST_CHECK(allocator->Allocate(_mat_Requirements(MAT_BLOCK_SIZE / 8, 4096), 0, MemoryResourceType::Attachment, target));
+	TEST_CHECK(target.dedicated);
+
+	TEST_CHECK(allocator->Allocate(_mat_Requirements(MAT_BLOCK_SIZE / 8 - 4096, 4096), 0, MemoryResourceType::Attachment, small));
+	TEST_CHECK(!small.dedicated);
+
+	TEST_CHECK(allocator->Allocate(_mat_Requirements(MAT_BLOCK_SIZE, 64, 2), 0, MemoryResourceType::Linear, mapped));
+	TEST_CHECK(mapped.dedicated && mapped.mapped && mapped.memoryType == 1);
+
+	MemoryStats stats;
+	allocator->GetStats(stats);
+	TEST_CHECK(stats.dedicatedCount == 3);
+	TEST_CHECK(stats.dedicatedBytes == MAT_BLOCK_SIZE / 2 + 1 + MAT_BLOCK_SIZE / 8 + MAT_BLOCK_SIZE);
+	TEST_CHECK(stats.allocationCount == 4);
+
+	allocator->Free(big);
+	allocator->Free(target);
+	allocator->Free(mapped);
+	allocator->GetStats(stats);
+	TEST_CHECK(stats.dedicatedCount == 0 && stats.dedicatedBytes == 0);
+	TEST_CHECK(counters.live == 1 && counters.maps == 0);
+
+	allocator->Free(small);
+	delete allocator;
+	TEST_CHECK(counters.live == 0);
+
+	// A heap too full for another block still fits the resource on its own
+	allocator = _mat_NewAllocator(counters, MAT_BLOCK_SIZE / 2);
+
+	MemoryAllocation fallback, failed;
+	TEST_CHECK(allocator->Allocate(_mat_Requirements(1024 * 1024, 256), 0, MemoryResourceType::Linear, fallback));
+	TEST_CHECK(fallback.dedicated && fallback.size == 1024 * 1024);
+
+	const uint32_t critical{ Test::GetLogCount(LOG_CRITICAL) };
+	TEST_CHECK(!allocator->Allocate(_mat_Requirements(MAT_BLOCK_SIZE / 2, 256), 0, MemoryResourceType::Linear, failed));
+	TEST_CHECK(Test::GetLogCount(LOG_CRITICAL) == critical + 1);
+
+	allocator->Free(fallback);
+	delete allocator;
+	TEST_CHECK(counters.live == 0);
+}
+
+static void _mat_TestDefragment()
+{
+	MatDeviceCounters counters;
+	MemoryAllocator *allocator{ _mat_NewAllocator(counters) };
+
+	// Allocations are tracked by address, so the storage must not move
+	const uint32_t count{ 64 }, size{ 256 * 1024 };
+	vector<MemoryAllocation> allocations(count);
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		TEST_CHECK(allocator->Allocate(_mat_Requirements(size, 256), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, MemoryResourceType::Linear, allocations[i], &allocations[i]));
+		memset(allocations[i].mapped, (int)i, size);
+	}
+
+	MemoryStats stats;
+	allocator->GetStats(stats);
+	const uint32_t blocks{ stats.blockCount };
+	TEST_CHECK(blocks == count * size / MAT_BLOCK_SIZE);
+
+	for (uint32_t i = 0; i < count; ++i)
+		if (i % 8)
+			allocator->Free(allocations[i]);
+
+	// A handler that cannot move the resource leaves everything in place
+	MemoryAllocation before{ allocations[0] };
+	TEST_CHECK(allocator->Defragment(count, [](const MemoryAllocation &, const MemoryAllocation &) { return false; }) == 0);
+	TEST_CHECK(allocations[0].memory == before.memory && allocations[0].offset == before.offset);
+
+	allocator->GetStats(stats);
+	TEST_CHECK(stats.blockCount == blocks && stats.usedBytes == count / 8 * size);
+
+	uint32_t moves{ 0 }, passes{ 0 }, n;
+	while ((n = allocator->Defragment(count, [](const MemoryAllocation &src, const MemoryAllocation &dst) {
+		memcpy(dst.mapped, src.mapped, src.size);
+		return true;
+	})) != 0 && passes < blocks)
+	{
+		moves += n;
+		++passes;
+	}
+
+	// Each pass empties the least used block into the others
+	allocator->GetStats(stats);
+	TEST_CHECK(moves == (blocks - 1) * 2);
+	TEST_CHECK(stats.blockCount == 1 && counters.live == 1);
+	TEST_CHECK(stats.defragMoves == moves && stats.usedBytes == count / 8 * size);
+
+	for (uint32_t i = 0; i < count; i += 8)
+	{
+		TEST_CHECK(allocations[i].memory == allocations[0].memory);
+		TEST_CHECK(allocations[i].owner == &allocations[i]);
+		TEST_CHECK(allocations[i].mapped[0] == (uint8_t)i && allocations[i].mapped[size - 1] == (uint8_t)i);
+	}
+
+	// Nothing left to move
+	TEST_CHECK(allocator->Defragment(count, [](const MemoryAllocation &, const MemoryAllocation &) { return true; }) == 0);
+
+	// Leaked allocations are reported and their memory released
+	const uint32_t warnings{ Test::GetLogCount(LOG_WARNING) };
+	delete allocator;
+	TEST_CHECK(Test::GetLogCount(LOG_WARNING) == warnings + 1);
+	TEST_CHECK(counters.live == 0 && counters.maps == 0);
+}
+
+static void _mat_Benchmark()
+{
+	TLSFHeap heap{ MAT_HEAP_SIZE };
+	vector<uint32_t> nodes{};
+	nodes.reserve(MAT_BENCH_OPS);
+	VkDeviceSize offset;
+
+	double start{ Test::Time() };
+	for (uint32_t i = 0; i < MAT_BENCH_OPS; ++i)
+	{
+		uint32_t node{ heap.Allocate(256 + (i % 97) * 16, 256, offset) };
+		if (node != MEMORY_INVALID_NODE)
+			nodes.push_back(node);
+		else
+			break;
+	}
+	for (uint32_t node : nodes)
+		heap.Free(node);
+	const double tlsf{ Test::Time() - start };
+
+	MatDeviceCounters counters;
+	MemoryAllocator *allocator{ _mat_NewAllocator(counters) };
+	vector<MemoryAllocation> allocations(1024);
+
+	start = Test::Time();
+	for (uint32_t i = 0; i < MAT_BENCH_OPS / allocations.size(); ++i)
+	{
+		for (MemoryAllocation &mem : allocations)
+			allocator->Allocate(_mat_Requirements(1024, 256), 0, MemoryResourceType::Linear, mem);
+		for (MemoryAllocation &mem : allocations)
+			allocator->Free(mem);
+	}
+	const double pool{ Test::Time() - start };
+
+	delete allocator;
+
+	printf("TLSF: %.1f ns per allocation and free (%u allocations)\n", tlsf * 1000000.0 / nodes.size(), (uint32_t)nodes.size());
+	printf("Allocator: %.1f ns per allocation and free\n", pool * 1000000.0 / MAT_BENCH_OPS);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_mat_TestHeap();
+	_mat_TestFuzz();
+	_mat_TestPools();
+	_mat_TestDedicated();
+	_mat_TestDefragment();
+
+	if (Test::Benchmark())
+		_mat_Benchmark();
+
+	return Test::Result();
+}
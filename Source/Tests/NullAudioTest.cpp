@@ -0,0 +1,351 @@
+/* NekoEngine
+ *
+ * NullAudioTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * NullAudio mixer tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include <Audio/AudioClip.h>
+
+#include "../NullAudio/NullAudio.h"
+#include "Test.h"
+
+#define NA_TEST_RATE		8000
+#define NA_TEST_GOLDEN		"NullAudioGolden.wav"
+#define NA_TEST_TOLERANCE	2
+
+using namespace std;
+using namespace glm;
+
+// Clips are created from memory instead of AudioClip::Load
+static AudioBuffer *_na_nextBuffer{ nullptr };
+
+AudioSystem::~AudioSystem() { }
+AudioClip::AudioClip(AudioClipResource *res) noexcept : _buffer(nullptr) { _resourceInfo = (ResourceInfo *)res; }
+int AudioClip::Load() { _buffer = _na_nextBuffer; return ENGINE_OK; }
+AudioClip::~AudioClip() noexcept { delete _buffer; }
+
+static AudioClip *_na_CreateClip(NullAudio &audio, const vector<int16_t> &samples, bool stereo, uint32_t frequency)
+{
+	size_t size{ samples.size() * sizeof(int16_t) };
+
+	_na_nextBuffer = audio.CreateBuffer(size);
+	_na_nextBuffer->SetData(stereo ? AudioFormat::Stereo_16Bit : AudioFormat::Mono_16Bit, frequency, size, (void *)samples.data());
+
+	AudioClip *clip{ new AudioClip(nullptr) };
+	clip->Load();
+	return clip;
+}
+
+static vector<int16_t> _na_Tone(float frequency, uint32_t rate, uint32_t frames, bool stereo)
+{
+	vector<int16_t> samples;
+	for (uint32_t i = 0; i < frames; ++i)
+	{
+		float v{ sinf(two_pi<float>() * frequency * i / rate) * .5f };
+		samples.push_back((int16_t)(v * 32767.f));
+		if (stereo)
+			samples.push_back((int16_t)(-v * 16383.f));
+	}
+	return samples;
+}
+
+static void _na_Init(NullAudio &audio, AudioDistanceModel model, int maxVoices)
+{
+	AudioConfig &cfg{ Engine::GetConfiguration().Audio };
+	cfg.MixRate = NA_TEST_RATE;
+	cfg.MaxVoices = maxVoices;
+	cfg.OfflineRender = true;
+	cfg.OutputFile[0] = 0x0;
+
+	audio.Initialize();
+	audio.SetDistanceModel(model);
+}
+
+// Output gain of a DC mono source straight ahead of the listener after the gain ramp settled
+static float _na_MeasureGain(AudioDistanceModel model, float distance, float ref, float max, float rolloff)
+{
+	NullAudio audio;
+	_na_Init(audio, model, 4);
+
+	vector<int16_t> dc(NA_TEST_RATE, 16384);
+	AudioClip *clip{ _na_CreateClip(audio, dc, false, NA_TEST_RATE) };
+	AudioSource *src{ audio.CreateSource() };
+
+	vec3 pos{ 0.f, 0.f, -distance };
+	src->SetPosition(pos);
+	src->SetReferenceDistance(ref);
+	src->SetMaxDistance(max);
+	src->SetRolloffFactor(rolloff);
+	src->SetLooping(true);
+	src->SetClip(clip);
+	src->Play();
+
+	audio.Render(64);
+	audio.Render(64);
+
+	// Centered sources get cos(pi / 4) on each side
+	float gain{ audio.GetOutput()[audio.GetOutput().size() - 2] / 32767.f / .5f / cosf(quarter_pi<float>()) };
+
+	delete src;
+	audio.Release();
+	delete clip;
+
+	return gain;
+}
+
+static void _na_TestDistanceModels()
+{
+	const float e{ .002f };
+
+	TEST_CHECK(fabsf(_na_MeasureGain(AudioDistanceModel::Inverse, 4.f, 1.f, 100.f, 1.f) - .25f) < e);
+	TEST_CHECK(fabsf(_na_MeasureGain(AudioDistanceModel::Inverse, 4.f, 1.f, 100.f, 2.f) - 1.f / 7.f) < e);
+	TEST_CHECK(fabsf(_na_MeasureGain(AudioDistanceModel::InverseClamped, 400.f, 1.f, 100.f, 1.f) - .01f) < e);
+	TEST_CHECK(fabsf(_na_MeasureGain(AudioDistanceModel::Linear, 5.f, 1.f, 9.f, 1.f) - .5f) < e);
+	TEST_CHECK(fabsf(_na_MeasureGain(AudioDistanceModel::Linear, 3.f, 1.f, 9.f, 2.f) - .5f) < e);
+	TEST_CHECK(fabsf(_na_MeasureGain(AudioDistanceModel::Exponent, 4.f, 1.f, 100.f, 1.f) - .25f) < e);
+	TEST_CHECK(fabsf(_na_MeasureGain(AudioDistanceModel::Exponent, 4.f, 1.f, 100.f, 2.f) - 1.f / 16.f) < e);
+	TEST_CHECK(fabsf(_na_MeasureGain(AudioDistanceModel::ExponentClamped, .5f, 1.f, 100.f, 2.f) - 1.f) < e);
+}
+
+static void _na_TestReleasedSystem()
+{
+	NullAudio audio;
+	_na_Init(audio, AudioDistanceModel::InverseClamped, 4);
+
+	vector<int16_t> tone{ _na_Tone(440.f, NA_TEST_RATE, 800, false) };
+	AudioClip *clip{ _na_CreateClip(audio, tone, false, NA_TEST_RATE) };
+	AudioSource *src{ audio.CreateSource() };
+
+	TEST_CHECK(src->SetClip(clip) == ENGINE_OK);
+	TEST_CHECK(src->Play());
+
+	audio.Release();
+
+	// Sources that outlive the system must not touch it
+	TEST_CHECK(!src->Play());
+	TEST_CHECK(src->SetClip(clip) != ENGINE_OK);
+	src->Stop();
+	src->Rewind();
+	src->Pause();
+	TEST_CHECK(!src->IsPlaying());
+
+	delete src;
+	delete clip;
+}
+
+static void _na_TestCaptureLimit()
+{
+	NullAudio audio;
+	_na_Init(audio, AudioDistanceModel::InverseClamped, 4);
+
+	const uint32_t limit{ NA_TEST_RATE * NA_MAX_CAPTURE_SECONDS };
+	for (uint32_t i = 0; i < NA_MAX_CAPTURE_SECONDS + 10; ++i)
+		audio.Render(NA_TEST_RATE);
+
+	TEST_CHECK(audio.GetOutput().size() == (size_t)limit * NA_OUT_CHANNELS);
+
+	audio.Release();
+}
+
+// Six sources with four voices, panning, cones, pitch and a looping stereo clip
+static vector<int16_t> _na_RenderScene()
+{
+	NullAudio audio;
+	_na_Init(audio, AudioDistanceModel::InverseClamped, 4);
+
+	vector<AudioClip *> clips;
+	vector<AudioSource *> sources;
+
+	for (int i = 0; i < 6; ++i)
+	{
+		bool stereo{ i == 5 };
+		vector<int16_t> tone{ _na_Tone(220.f * (i + 1), 11025, 11025 / 4, stereo) };
+		clips.push_back(_na_CreateClip(audio, tone, stereo, 11025));
+
+		AudioSource *src{ audio.CreateSource() };
+		vec3 pos{ (i - 2.5f) * 3.f, 0.f, -2.f - i };
+		vec3 dir{ 0.f, 0.f, i == 3 ? -1.f : 1.f };
+
+		src->SetPosition(pos);
+		src->SetDirection(dir);
+		src->SetConeInnerAngle(90.f);
+		src->SetConeOuterAngle(180.f);
+		src->SetConeOuterGain(.25f);
+		src->SetReferenceDistance(1.f);
+		src->SetMaxDistance(50.f);
+		src->SetPitch(1.f + .1f * i);
+		src->SetLooping(i % 2 == 1);
+		src->SetPriority(i == 0 ? ASRC_PRIORITY_HIGH : ASRC_PRIORITY_NORMAL);
+		src->SetClip(clips.back());
+		src->Play();
+
+		sources.push_back(src);
+	}
+
+	for (int i = 0; i < 30; ++i)
+	{
+		if (i == 10)
+		{
+			vec3 pos{ 0.f, 0.f, -1.f };
+			sources[4]->SetPosition(pos);
+		}
+
+		audio.Update(1.0 / 60.0);
+	}
+
+	vector<int16_t> output{ audio.GetOutput() };
+
+	for (AudioSource *src : sources)
+		delete src;
+	audio.Release();
+	for (AudioClip *clip : clips)
+		delete clip;
+
+	return output;
+}
+
+static bool _na_ReadWav(const char *file, vector<int16_t> &samples)
+{
+	FILE *fp{ fopen(file, "rb") };
+	if (!fp)
+		return false;
+
+	uint8_t header[44];
+	bool ret{ fread(header, 1, sizeof(header), fp) == sizeof(header) && !memcmp(header, "RIFF", 4) && !memcmp(header + 36, "data", 4) };
+
+	if (ret)
+	{
+		uint32_t size;
+		memcpy(&size, header + 40, sizeof(size));
+
+		samples.resize(size / sizeof(int16_t));
+		ret = fread(samples.data(), 1, size, fp) == size;
+	}
+
+	fclose(fp);
+	return ret;
+}
+
+static void _na_TestGolden()
+{
+	vector<int16_t> output{ _na_RenderScene() };
+	TEST_CHECK(output.size() == (size_t)(NA_TEST_RATE / 60) * 30 * NA_OUT_CHANNELS);
+
+	// Same input, same output
+	TEST_CHECK(output == _na_RenderScene());
+
+	if (Test::HasArgument("--update-golden"))
+	{
+		NAWavWriter wav;
+		TEST_CHECK(wav.Open(Test::DataPath(NA_TEST_GOLDEN), NA_TEST_RATE));
+		wav.Write(output.data(), (uint32_t)(output.size() / NA_OUT_CHANNELS));
+		wav.Close();
+		return;
+	}
+
+	vector<int16_t> golden;
+	TEST_CHECK(_na_ReadWav(Test::DataPath(NA_TEST_GOLDEN), golden));
+	TEST_CHECK(golden.size() == output.size());
+
+	// Allow for rounding differences between the SSE and scalar paths
+	int maxError{ 0 };
+	for (size_t i = 0; i < golden.size() && i < output.size(); ++i)
+		maxError = glm::max(maxError, abs(golden[i] - output[i]));
+
+	TEST_CHECK(maxError <= NA_TEST_TOLERANCE);
+}
+
+static void _na_Benchmark()
+{
+	AudioConfig &cfg{ Engine::GetConfiguration().Audio };
+	cfg.MixRate = 48000;
+	cfg.MaxVoices = 64;
+	cfg.OfflineRender = false;
+	cfg.OutputFile[0] = 0x0;
+
+	NullAudio audio;
+	audio.Initialize();
+
+	vector<int16_t> tone{ _na_Tone(440.f, 44100, 44100, false) };
+	AudioClip *clip{ _na_CreateClip(audio, tone, false, 44100) };
+	vector<AudioSource *> sources;
+
+	for (int i = 0; i < 256; ++i)
+	{
+		AudioSource *src{ audio.CreateSource() };
+		vec3 pos{ (float)(i % 16) - 8.f, 0.f, (float)(i / 16) - 8.f };
+
+		src->SetPosition(pos);
+		src->SetPitch(.5f + (i % 7) * .25f);
+		src->SetLooping(true);
+		src->SetClip(clip);
+		src->Play();
+		sources.push_back(src);
+	}
+
+	const uint32_t seconds{ 10 }, block{ 48000 / 60 };
+	double start{ Test::Time() };
+
+	for (uint32_t i = 0; i < seconds * 60; ++i)
+		audio.Render(block);
+
+	double ms{ Test::Time() - start };
+	printf("256 sources, 64 voices, %u s at 48 kHz: %.1f ms (%.0fx realtime)\n", seconds, ms, seconds * 1000.0 / ms);
+
+	for (AudioSource *src : sources)
+		delete src;
+	audio.Release();
+	delete clip;
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_na_TestDistanceModels();
+	_na_TestReleasedSystem();
+	_na_TestCaptureLimit();
+	_na_TestGolden();
+
+	if (Test::Benchmark())
+		_na_Benchmark();
+
+	return Test::Result();
+}
@@ -0,0 +1,243 @@
+/* NekoEngine
+ *
+ * NullBroadphaseTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * NullPhysics broadphase tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <random>
+#include <algorithm>
+
+#include "../NullPhysics/NullBroadphase.h"
+
+#include "Test.h"
+
+#define NBT_COUNT			2000
+#define NBT_FRAMES			20
+#define NBT_WORLD			100.f
+#define NBT_BENCH_COUNT		50000
+#define NBT_BENCH_FRAMES	30
+#define NBT_BENCH_WORLD		2000.f
+#define NBT_BENCH_HEIGHT	50.f
+#define NBT_BENCH_QUERIES	10000
+
+using namespace std;
+using namespace glm;
+
+static mt19937 _nbt_rng{ 7 };
+
+static float _nbt_Random(float min, float max)
+{
+	return uniform_real_distribution<float>(min, max)(_nbt_rng);
+}
+
+static bool _nbt_Overlap(const NullProxy &a, const vec3 &min, const vec3 &max)
+{
+	return a.min.x <= max.x && min.x <= a.max.x &&
+		a.min.y <= max.y && min.y <= a.max.y &&
+		a.min.z <= max.z && min.z <= a.max.z;
+}
+
+static vector<uint64_t> _nbt_BrutePairs(const NullBroadphase &broadphase)
+{
+	const vector<NullProxy> &p{ broadphase.GetProxies() };
+	vector<uint64_t> pairs;
+
+	for (uint32_t i = 0; i < p.size(); ++i)
+		for (uint32_t j = i + 1; j < p.size(); ++j)
+			if (p[i].alive && p[j].alive && _nbt_Overlap(p[i], p[j].min, p[j].max))
+				pairs.push_back(((uint64_t)i << 32) | j);
+
+	return pairs;
+}
+
+static void _nbt_AddRandom(NullBroadphase &broadphase, uint32_t count, float world, float height = 10.f)
+{
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const vec3 center{ _nbt_Random(-world, world), _nbt_Random(-height, height), _nbt_Random(-world, world) };
+		const vec3 half{ _nbt_Random(.2f, 2.f), _nbt_Random(.2f, 2.f), _nbt_Random(.2f, 2.f) };
+		broadphase.AddProxy(center - half, center + half, (void *)(uintptr_t)(i + 1));
+	}
+}
+
+static void _nbt_Move(NullBroadphase &broadphase, uint32_t stride, float step)
+{
+	const vector<NullProxy> &proxies{ broadphase.GetProxies() };
+
+	for (uint32_t i = 0; i < proxies.size(); i += stride)
+	{
+		if (!proxies[i].alive)
+			continue;
+
+		const vec3 d{ _nbt_Random(-step, step), _nbt_Random(-step, step), _nbt_Random(-step, step) };
+		broadphase.UpdateProxy(i, proxies[i].min + d, proxies[i].max + d);
+	}
+}
+
+// Incremental updates, rebuilds and region changes must match brute force
+static void _nbt_TestPairs(BroadphaseType type)
+{
+	NullBroadphase broadphase;
+	broadphase.Initialize(type, NBT_WORLD);
+	_nbt_AddRandom(broadphase, NBT_COUNT, NBT_WORLD);
+
+	TEST_CHECK(broadphase.Update() == _nbt_BrutePairs(broadphase));
+
+	for (uint32_t f = 0; f < NBT_FRAMES; ++f)
+	{
+		_nbt_Move(broadphase, 3, 5.f);
+
+		// Remove and re-add a few to mix rebuilds with incremental frames
+		if (f % 5 == 4)
+		{
+			broadphase.RemoveProxy(f);
+			_nbt_AddRandom(broadphase, 1, NBT_WORLD);
+		}
+
+		TEST_CHECK(broadphase.Update() == _nbt_BrutePairs(broadphase));
+	}
+}
+
+// Touching boxes overlap whether the pair was found by a rebuild or by the incremental sort
+static void _nbt_TestTouching()
+{
+	NullBroadphase broadphase;
+	broadphase.Initialize(BroadphaseType::SAP, NBT_WORLD);
+
+	const uint32_t a{ broadphase.AddProxy(vec3(0.f), vec3(1.f), (void *)1) };
+	const uint32_t b{ broadphase.AddProxy(vec3(3.f, 0.f, 0.f), vec3(4.f, 1.f, 1.f), (void *)2) };
+	TEST_CHECK(broadphase.Update().empty());
+
+	broadphase.UpdateProxy(b, vec3(1.f, 0.f, 0.f), vec3(2.f, 1.f, 1.f));
+	TEST_CHECK(broadphase.Update().size() == 1);
+
+	broadphase.UpdateProxy(b, vec3(1.5f, 0.f, 0.f), vec3(2.5f, 1.f, 1.f));
+	TEST_CHECK(broadphase.Update().empty());
+
+	broadphase.UpdateProxy(a, vec3(.5f, 0.f, 0.f), vec3(1.5f, 1.f, 1.f));
+	TEST_CHECK(broadphase.Update().size() == 1);
+}
+
+static void _nbt_TestQuery(BroadphaseType type)
+{
+	NullBroadphase broadphase;
+	broadphase.Initialize(type, NBT_WORLD);
+	_nbt_AddRandom(broadphase, NBT_COUNT, NBT_WORLD);
+	broadphase.Update();
+
+	// Queries right after moves must see the new bounds
+	_nbt_Move(broadphase, 2, 3.f);
+
+	vector<uint32_t> found, expected;
+	for (uint32_t q = 0; q < 200; ++q)
+	{
+		const vec3 a{ _nbt_Random(-NBT_WORLD, NBT_WORLD), _nbt_Random(-12.f, 12.f), _nbt_Random(-NBT_WORLD, NBT_WORLD) };
+		const vec3 b{ a + vec3(_nbt_Random(-40.f, 40.f), _nbt_Random(-5.f, 5.f), _nbt_Random(-40.f, 40.f)) };
+		const vec3 min{ glm::min(a, b) }, max{ glm::max(a, b) };
+
+		broadphase.Query(min, max, found);
+		sort(found.begin(), found.end());
+
+		expected.clear();
+		const vector<NullProxy> &proxies{ broadphase.GetProxies() };
+		for (uint32_t i = 0; i < proxies.size(); ++i)
+			if (proxies[i].alive && _nbt_Overlap(proxies[i], min, max))
+				expected.push_back(i);
+
+		TEST_CHECK(found == expected);
+	}
+
+	// The incremental pair set stays correct after queries sorted the regions
+	TEST_CHECK(broadphase.Update() == _nbt_BrutePairs(broadphase));
+}
+
+static void _nbt_Benchmark(BroadphaseType type)
+{
+	NullBroadphase broadphase;
+	broadphase.Initialize(type, NBT_BENCH_WORLD);
+
+	double start{ Test::Time() };
+	_nbt_AddRandom(broadphase, NBT_BENCH_COUNT, NBT_BENCH_WORLD, NBT_BENCH_HEIGHT);
+	size_t pairs{ broadphase.Update().size() };
+	const double build{ Test::Time() - start };
+
+	double update{ 0.0 };
+	for (uint32_t f = 0; f < NBT_BENCH_FRAMES; ++f)
+	{
+		// A quarter of the proxies move every frame
+		_nbt_Move(broadphase, 4, .3f);
+
+		start = Test::Time();
+		pairs = broadphase.Update().size();
+		update += Test::Time() - start;
+	}
+
+	vector<uint32_t> found;
+	size_t candidates{ 0 };
+	start = Test::Time();
+	for (uint32_t q = 0; q < NBT_BENCH_QUERIES; ++q)
+	{
+		const vec3 a{ _nbt_Random(-NBT_BENCH_WORLD, NBT_BENCH_WORLD), _nbt_Random(-NBT_BENCH_HEIGHT, NBT_BENCH_HEIGHT), _nbt_Random(-NBT_BENCH_WORLD, NBT_BENCH_WORLD) };
+		const vec3 b{ a + vec3(_nbt_Random(-50.f, 50.f), _nbt_Random(-5.f, 5.f), _nbt_Random(-50.f, 50.f)) };
+
+		broadphase.Query(glm::min(a, b), glm::max(a, b), found);
+		candidates += found.size();
+	}
+	const double query{ (Test::Time() - start) * 1000.0 / NBT_BENCH_QUERIES };
+
+	printf("%s, %d proxies: build %.2f ms, update %.3f ms per frame (%zu pairs), ray bounds query %.2f us (%.1f candidates)\n",
+		type == BroadphaseType::MBP ? "MBP" : "SAP", NBT_BENCH_COUNT, build, update / NBT_BENCH_FRAMES, pairs,
+		query, (double)candidates / NBT_BENCH_QUERIES);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_nbt_TestPairs(BroadphaseType::SAP);
+	_nbt_TestPairs(BroadphaseType::MBP);
+	_nbt_TestTouching();
+	_nbt_TestQuery(BroadphaseType::SAP);
+	_nbt_TestQuery(BroadphaseType::MBP);
+
+	if (Test::Benchmark())
+	{
+		_nbt_Benchmark(BroadphaseType::SAP);
+		_nbt_Benchmark(BroadphaseType::MBP);
+	}
+
+	return Test::Result();
+}
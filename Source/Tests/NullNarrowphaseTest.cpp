@@ -0,0 +1,487 @@
+/* NekoEngine
+ *
+ * NullNarrowphaseTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * NullPhysics overlap, ray cast and contact dispatch tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <float.h>
+#include <random>
+#include <memory>
+#include <functional>
+
+#include <Scene/Object.h>
+#include <Physics/TriangleBVH.h>
+#include <Renderer/StaticMesh.h>
+
+#include "../NullPhysics/NullPhysics.h"
+#include "../NullPhysics/NullColliders.h"
+#include "../NullPhysics/NullNarrowphase.h"
+
+#include "ObjectTest.h"
+#include "Test.h"
+
+#define NNT_PAIRS			2000
+#define NNT_RAYS			2000
+#define NNT_SAMPLES			24
+#define NNT_MAX_T			100.f
+#define NNT_TOLERANCE		1e-3f
+
+using namespace std;
+using namespace glm;
+
+static mt19937 _nnt_rng{ 11 };
+static NullPhysics *_nnt_physics{ nullptr };
+
+// The colliders register with the instance; mesh colliders are built in the test
+Physics *Physics::GetInstance() { return _nnt_physics; }
+Physics::~Physics() { }
+const TriangleBVH *StaticMesh::GetBVH() const { return nullptr; }
+
+/**
+ * Records the contacts reported through OnHit
+ */
+class TestHitObject : public Object
+{
+public:
+	struct Hit
+	{
+		Object *other;
+		vec3 position;
+	};
+
+	TestHitObject(ObjectInitializer &&initializer = ObjectInitializer()) : Object(&initializer) { }
+
+	virtual void OnHit(Object *other, vec3 &position) override
+	{
+		hits.push_back({ other, position });
+
+		if (onHit)
+			onHit(other);
+	}
+
+	vector<Hit> hits;
+	function<void(Object *)> onHit;
+};
+
+static float _nnt_Random(float min, float max)
+{
+	return uniform_real_distribution<float>(min, max)(_nnt_rng);
+}
+
+static vec3 _nnt_RandomVec(float min, float max)
+{
+	return vec3(_nnt_Random(min, max), _nnt_Random(min, max), _nnt_Random(min, max));
+}
+
+static NullShape _nnt_RandomShape(NullShapeType type)
+{
+	NullShape shape{ type, nullptr };
+
+	shape.position = _nnt_RandomVec(-1.5f, 1.5f);
+	shape.rotation = normalize(quat(_nnt_Random(-1.f, 1.f), _nnt_RandomVec(-1.f, 1.f)));
+	shape.scale = _nnt_RandomVec(.5f, 1.5f);
+	shape.halfExtents = _nnt_RandomVec(.1f, 1.f);
+	shape.radius = _nnt_Random(.1f, .8f);
+	shape.halfHeight = _nnt_Random(.1f, 1.f);
+	shape.Update();
+
+	return shape;
+}
+
+// Exact distance from a point to the shape, zero inside
+static float _nnt_Distance(const NullShape &s, const vec3 &p)
+{
+	const vec3 local{ transpose(s.axes) * (p - s.position) };
+
+	if (s.type == NullShapeType::Box)
+		return length(local - glm::clamp(local, -s.extents, s.extents));
+
+	const float h{ s.type == NullShapeType::Capsule ? s.worldHalfHeight : 0.f };
+	return glm::max(length(local - vec3(0.f, glm::clamp(local.y, -h, h), 0.f)) - s.worldRadius, 0.f);
+}
+
+// Largest extent of the shape along n
+static float _nnt_Support(const NullShape &s, const vec3 &n)
+{
+	const vec3 local{ transpose(s.axes) * n };
+
+	if (s.type == NullShapeType::Box)
+		return dot(s.position, n) + dot(abs(local), s.extents);
+
+	const float h{ s.type == NullShapeType::Capsule ? s.worldHalfHeight : 0.f };
+	return dot(s.position, n) + fabsf(local.y) * h + s.worldRadius;
+}
+
+/*
+ * Distance between two shapes from samples of a, and the largest error of
+ * the sampling. Spheres and capsules are sampled along their segment and
+ * inflated by their radius, boxes on a grid through their volume.
+ */
+static float _nnt_BruteDistance(const NullShape &a, const NullShape &b, float &error)
+{
+	float best{ FLT_MAX };
+
+	if (a.type == NullShapeType::Box)
+	{
+		const vec3 step{ a.extents * (2.f / (NNT_SAMPLES - 1)) };
+		error = length(step) * .5f;
+
+		for (int x = 0; x < NNT_SAMPLES; ++x)
+			for (int y = 0; y < NNT_SAMPLES; ++y)
+				for (int z = 0; z < NNT_SAMPLES; ++z)
+					best = glm::min(best, _nnt_Distance(b, a.position + a.axes * (step * vec3(x, y, z) - a.extents)));
+
+		return best;
+	}
+
+	const int count{ NNT_SAMPLES * NNT_SAMPLES };
+	const float h{ a.type == NullShapeType::Capsule ? a.worldHalfHeight : 0.f };
+	error = h / (count - 1);
+
+	for (int i = 0; i < count; ++i)
+		best = glm::min(best, _nnt_Distance(b, a.position + a.axes[1] * (h * (2.f * i / (count - 1) - 1.f))));
+
+	return glm::max(best - a.worldRadius, 0.f);
+}
+
+// Every pair that sampling finds overlapping or clearly apart must agree
+static void _nnt_TestOverlap(NullShapeType ta, NullShapeType tb)
+{
+	uint32_t checked{ 0 }, overlapping{ 0 };
+
+	for (uint32_t i = 0; i < NNT_PAIRS; ++i)
+	{
+		const NullShape a{ _nnt_RandomShape(ta) }, b{ _nnt_RandomShape(tb) };
+
+		float error{};
+		const float distance{ _nnt_BruteDistance(a, b, error) };
+
+		vec3 pointA{}, pointB{};
+		const bool hit{ NullOverlap(a, b, pointA, pointB) };
+
+		// Closer than the sampling error either answer is right
+		if (distance > 0.f && distance <= error + NNT_TOLERANCE)
+			continue;
+
+		++checked;
+		TEST_CHECK(hit == (distance == 0.f));
+
+		if (!hit)
+			continue;
+
+		++overlapping;
+		TEST_CHECK(_nnt_Distance(a, pointA) <= NNT_TOLERANCE);
+		TEST_CHECK(_nnt_Distance(b, pointB) <= NNT_TOLERANCE);
+	}
+
+	// Both outcomes are covered and few pairs are left out
+	TEST_CHECK(checked > NNT_PAIRS * 9 / 10);
+	TEST_CHECK(overlapping > checked / 10 && overlapping < checked * 9 / 10);
+}
+
+// Thin capsules through a point of a flat box overlap it, even with the
+// middle of the segment far from the box
+static void _nnt_TestSegmentThroughBox()
+{
+	uint32_t separated{ 0 };
+
+	for (uint32_t i = 0; i < NNT_PAIRS; ++i)
+	{
+		NullShape box{ _nnt_RandomShape(NullShapeType::Box) }, capsule{ NullShapeType::Capsule, nullptr };
+		box.halfExtents.y = .05f;
+		box.Update();
+
+		const vec3 inside{ box.position + box.axes * (_nnt_RandomVec(-.95f, .95f) * box.extents) };
+		const vec3 direction{ normalize(_nnt_RandomVec(-1.f, 1.f)) };
+		const float before{ _nnt_Random(.2f, 4.f) }, after{ _nnt_Random(.2f, 4.f) };
+
+		capsule.radius = .001f;
+		capsule.halfHeight = (before + after) * .5f;
+		capsule.position = inside + direction * ((after - before) * .5f);
+		capsule.rotation = rotation(vec3(0.f, 1.f, 0.f), direction);
+		capsule.Update();
+
+		vec3 pointA{}, pointB{};
+		if (!NullOverlap(box, capsule, pointA, pointB) || !NullOverlap(capsule, box, pointB, pointA))
+			++separated;
+	}
+
+	TEST_CHECK(separated == 0);
+}
+
+/*
+ * Sphere tracing with the exact distance walks up to the first hit.
+ * closest is the smallest distance seen, to leave out grazing rays.
+ */
+static bool _nnt_BruteRay(const NullShape &s, const vec3 &origin, const vec3 &direction, float &t, float &closest)
+{
+	t = 0.f;
+	closest = FLT_MAX;
+
+	for (uint32_t i = 0; i < 10000 && t <= NNT_MAX_T; ++i)
+	{
+		const float distance{ _nnt_Distance(s, origin + direction * t) };
+		closest = glm::min(closest, distance);
+
+		if (distance < 1e-5f)
+			return true;
+
+		t += distance;
+	}
+
+	return false;
+}
+
+static void _nnt_CheckRayHit(const NullShape &s, const vec3 &origin, const vec3 &direction, float t, const vec3 &normal, float expected)
+{
+	// Sphere tracing stops early on rays grazing the surface, so a later hit is
+	// accepted when the ray stays on the surface between the two
+	const float grazing{ _nnt_Distance(s, origin + direction * ((t + expected) * .5f)) };
+	TEST_CHECK(fabsf(t - expected) <= NNT_TOLERANCE || (t > expected && grazing <= NNT_TOLERANCE));
+	TEST_CHECK(_nnt_Distance(s, origin + direction * t) <= NNT_TOLERANCE);
+	TEST_CHECK(fabsf(length(normal) - 1.f) <= NNT_TOLERANCE);
+
+	// The normal of a convex shape gives a plane through the hit point with the shape behind it
+	if (expected > NNT_TOLERANCE)
+	{
+		TEST_CHECK(dot(normal, direction) < 0.f);
+		TEST_CHECK(_nnt_Support(s, normal) - dot(origin + direction * t, normal) <= NNT_TOLERANCE);
+	}
+}
+
+static void _nnt_TestRayCast(NullShapeType type)
+{
+	uint32_t checked{ 0 }, hits{ 0 };
+
+	for (uint32_t i = 0; i < NNT_RAYS; ++i)
+	{
+		const NullShape s{ _nnt_RandomShape(type) };
+		const vec3 origin{ _nnt_RandomVec(-4.f, 4.f) };
+		const vec3 direction{ normalize(s.position + _nnt_RandomVec(-1.f, 1.f) - origin) };
+
+		float expected{}, closest{};
+		const bool brute{ _nnt_BruteRay(s, origin, direction, expected, closest) };
+
+		if (!brute && closest <= NNT_TOLERANCE)
+			continue;
+
+		float t{};
+		vec3 normal{};
+		const bool hit{ NullRayCast(s, origin, direction, NNT_MAX_T, t, normal) };
+
+		++checked;
+		TEST_CHECK(hit == brute);
+
+		if (!hit || !brute)
+			continue;
+
+		++hits;
+		_nnt_CheckRayHit(s, origin, direction, t, normal, expected);
+
+		// Rays stop at maxT
+		if (expected > NNT_TOLERANCE)
+			TEST_CHECK(!NullRayCast(s, origin, direction, expected * .5f, t, normal));
+	}
+
+	TEST_CHECK(checked > NNT_RAYS * 9 / 10);
+	TEST_CHECK(hits > checked / 10 && hits < checked * 9 / 10);
+}
+
+// A mesh collider of a cube hits where the box of the same transform does
+static void _nnt_TestMeshRayCast()
+{
+	const vec3 corners[8]
+	{
+		{ -1.f, -1.f, -1.f }, { 1.f, -1.f, -1.f }, { 1.f, 1.f, -1.f }, { -1.f, 1.f, -1.f },
+		{ -1.f, -1.f, 1.f }, { 1.f, -1.f, 1.f }, { 1.f, 1.f, 1.f }, { -1.f, 1.f, 1.f }
+	};
+	const int faces[6][4]{ { 0, 3, 2, 1 }, { 4, 5, 6, 7 }, { 0, 1, 5, 4 }, { 3, 7, 6, 2 }, { 0, 4, 7, 3 }, { 1, 2, 6, 5 } };
+
+	vector<vec3> triangles;
+	for (const auto &f : faces)
+		for (int v : { f[0], f[1], f[2], f[0], f[2], f[3] })
+			triangles.push_back(corners[v]);
+
+	TriangleBVH bvh;
+	TEST_CHECK(bvh.Build(triangles) == ENGINE_OK);
+
+	uint32_t hits{ 0 };
+	for (uint32_t i = 0; i < NNT_RAYS; ++i)
+	{
+		NullShape box{ _nnt_RandomShape(NullShapeType::Box) }, mesh{ NullShapeType::Mesh, nullptr };
+		box.halfExtents = vec3(1.f);
+		box.Update();
+
+		mesh.position = box.position;
+		mesh.rotation = box.rotation;
+		mesh.scale = box.scale;
+		mesh.bvh = &bvh;
+		mesh.Update();
+
+		// Inside the mesh the ray hits the far side
+		const vec3 origin{ _nnt_RandomVec(-4.f, 4.f) };
+		if (_nnt_Distance(box, origin) <= NNT_TOLERANCE)
+			continue;
+
+		const vec3 direction{ normalize(box.position + _nnt_RandomVec(-1.f, 1.f) - origin) };
+		float expected{}, closest{};
+		const bool brute{ _nnt_BruteRay(box, origin, direction, expected, closest) };
+
+		if (!brute && closest <= NNT_TOLERANCE)
+			continue;
+
+		float t{};
+		vec3 normal{};
+		const bool hit{ NullRayCast(mesh, origin, direction, NNT_MAX_T, t, normal) };
+
+		TEST_CHECK(hit == brute);
+
+		if (hit && brute)
+		{
+			++hits;
+			_nnt_CheckRayHit(box, origin, direction, t, normal, expected);
+		}
+	}
+
+	TEST_CHECK(hits > NNT_RAYS / 10);
+}
+
+static void _nnt_TestDispatch()
+{
+	NullPhysics physics;
+	_nnt_physics = &physics;
+	physics.Initialize();
+
+	TestHitObject a, b, c, far;
+
+	// Colliders of the same object never hit each other
+	unique_ptr<BoxCollider> boxA{ physics.CreateBoxCollider(&a, vec3(1.f)) };
+	unique_ptr<SphereCollider> sphereA{ physics.CreateSphereCollider(&a, .5) };
+
+	unique_ptr<SphereCollider> sphereB{ physics.CreateSphereCollider(&b, .5) };
+	sphereB->SetPosition(vec3(1.2f, 0.f, 0.f));
+
+	unique_ptr<CapsuleCollider> capsuleFar{ physics.CreateCapsuleCollider(&far, .5, 2.) };
+	capsuleFar->SetPosition(vec3(10.f, 0.f, 0.f));
+
+	physics.Update(0.0);
+
+	TEST_CHECK(a.hits.size() == 1 && a.hits[0].other == &b);
+	TEST_CHECK(b.hits.size() == 1 && b.hits[0].other == &a);
+	TEST_CHECK(far.hits.empty());
+
+	if (a.hits.size() == 1 && b.hits.size() == 1)
+	{
+		TEST_CHECK(_nnt_Distance(*((NullBoxCollider *)boxA.get())->GetShape(), a.hits[0].position) <= NNT_TOLERANCE);
+		TEST_CHECK(_nnt_Distance(*((NullSphereCollider *)sphereB.get())->GetShape(), b.hits[0].position) <= NNT_TOLERANCE);
+	}
+
+	// A collider removed by a callback is not reported, and neither is the
+	// one that reuses its slot until the next update
+	unique_ptr<SphereCollider> sphereC{ physics.CreateSphereCollider(&c, .5) };
+	sphereC->SetPosition(vec3(-1.2f, 0.f, 0.f));
+
+	unique_ptr<SphereCollider> replacement;
+	b.onHit = [&](Object *other) {
+		sphereC.reset();
+		replacement.reset(physics.CreateSphereCollider(&c, .5));
+		replacement->SetPosition(vec3(-1.2f, 0.f, 0.f));
+		b.onHit = nullptr;
+	};
+
+	a.hits.clear();
+	b.hits.clear();
+	physics.Update(0.0);
+
+	TEST_CHECK(b.hits.size() == 1);
+	TEST_CHECK(c.hits.empty());
+	TEST_CHECK(a.hits.size() == 1 && a.hits[0].other == &b);
+
+	a.hits.clear();
+	physics.Update(0.0);
+
+	TEST_CHECK(c.hits.size() == 1 && c.hits[0].other == &a);
+	TEST_CHECK(a.hits.size() == 2);
+
+	// Ray casts go through the broadphase and return the nearest collider
+	Ray ray{};
+	ray.start = vec3(-20.f, 0.f, 0.f);
+	ray.end = vec3(20.f, 0.f, 0.f);
+
+	TEST_CHECK(physics.RayCast(&ray));
+	TEST_CHECK(ray.hitObject == &c);
+	TEST_CHECK(fabsf(ray.hitPoint.x + 1.7f) <= NNT_TOLERANCE);
+
+	ray.start = vec3(20.f, 0.f, 0.f);
+	ray.end = vec3(-20.f, 0.f, 0.f);
+
+	TEST_CHECK(physics.RayCast(&ray));
+	TEST_CHECK(ray.hitObject == &far);
+	TEST_CHECK(fabsf(ray.hitPoint.x - 10.5f) <= NNT_TOLERANCE);
+
+	ray.start = vec3(0.f, 5.f, 0.f);
+	ray.end = vec3(20.f, 5.f, 0.f);
+	TEST_CHECK(!physics.RayCast(&ray));
+
+	boxA.reset();
+	sphereA.reset();
+	sphereB.reset();
+	capsuleFar.reset();
+	replacement.reset();
+
+	_nnt_physics = nullptr;
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	const NullShapeType types[]{ NullShapeType::Box, NullShapeType::Sphere, NullShapeType::Capsule };
+
+	for (NullShapeType a : types)
+		for (NullShapeType b : types)
+			_nnt_TestOverlap(a, b);
+
+	_nnt_TestSegmentThroughBox();
+
+	for (NullShapeType type : types)
+		_nnt_TestRayCast(type);
+
+	_nnt_TestMeshRayCast();
+	_nnt_TestDispatch();
+
+	return Test::Result();
+}
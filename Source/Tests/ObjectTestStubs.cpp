@@ -0,0 +1,76 @@
+/* NekoEngine
+ *
+ * ObjectTestStubs.cpp
+ * Author: Alexandru Naiman
+ *
+ * Scene services for the tests that link Object
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Engine/EventManager.h>
+#include <Engine/EngineClassFactory.h>
+#include <Scene/SceneManager.h>
+#include <Scene/Components/CameraComponent.h>
+
+#include "ObjectTest.h"
+
+using namespace glm;
+
+static Scene _ot_scene{ 0, "" };
+
+vec2 Engine::_scaleFactor{ 1.f, 1.f };
+bool Engine::_inFixedUpdate{ false };
+uint64_t Engine::_fixedFrame{ 0 };
+FixedTimestep Engine::_fixedTimestep{};
+
+ObjectClassMapType *EngineClassFactory::_objectClassMap{ nullptr };
+ComponentClassMapType *EngineClassFactory::_componentClassMap{ nullptr };
+
+Scene *SceneManager::_activeScene{ &_ot_scene };
+Scene *SceneManager::_loadingScene{ nullptr };
+
+int Scene::Load() { _loaded = true; return ENGINE_OK; }
+void Scene::AddObject(Object *obj) noexcept { }
+void Scene::RemoveObject(Object *obj) noexcept { }
+Scene::~Scene() noexcept { }
+
+void EventManager::Broadcast(int32_t id, void *eventArgs) { }
+
+// ObjectComponent looks for camera components
+int CameraComponent::Load() { return ENGINE_OK; }
+void CameraComponent::_UpdateView() noexcept { }
+
+void TestLoadScene()
+{
+	_ot_scene.Load();
+}
@@ -0,0 +1,205 @@
+/* NekoEngine
+ *
+ * ParticlePoolTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Particle pool tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <vector>
+
+#include <Scene/Particles/ParticlePool.h>
+
+#include "Test.h"
+
+#define PPT_COUNT			1003
+#define PPT_BENCH_COUNT		1000000
+#define PPT_BENCH_FRAMES	60
+
+using namespace std;
+using namespace glm;
+
+static void _ppt_Fill(ParticlePool &pool, uint32_t count)
+{
+	ParticleData &d{ pool.GetData() };
+	const uint32_t first{ pool.GetAliveCount() };
+	const uint32_t emitted{ pool.Emit(count) };
+
+	for (uint32_t i = first; i < first + emitted; ++i)
+	{
+		d.positionX[i] = (float)(i % 17);
+		d.positionY[i] = (float)(i % 5) * .5f;
+		d.positionZ[i] = -(float)(i % 11);
+		d.velocityX[i] = sinf((float)i);
+		d.velocityY[i] = 1.f + (float)(i % 3);
+		d.velocityZ[i] = cosf((float)i);
+		d.age[i] = (float)(i % 7) * .1f;
+		d.invLifespan[i] = 1.f / (.5f + (float)(i % 13) * .1f);
+	}
+}
+
+static void _ppt_TestPacking()
+{
+	ParticlePool pool;
+	pool.Resize(10);
+
+	TEST_CHECK(pool.Emit(6) == 6);
+	TEST_CHECK(pool.Emit(6) == 4);
+	TEST_CHECK(pool.GetAliveCount() == 10);
+	TEST_CHECK(pool.Emit(1) == 0);
+
+	ParticleData &d{ pool.GetData() };
+	for (uint32_t i = 0; i < 10; ++i)
+		d.positionX[i] = (float)i;
+
+	// The last alive particle moves into the hole
+	pool.Kill(2);
+	TEST_CHECK(pool.GetAliveCount() == 9);
+	TEST_CHECK(d.positionX[2] == 9.f);
+
+	pool.Kill(8);
+	TEST_CHECK(pool.GetAliveCount() == 8);
+	TEST_CHECK(d.positionX[7] == 7.f);
+}
+
+// The vector path must match the scalar formula for every lane and the tail
+static void _ppt_TestIntegrate()
+{
+	EasingTable speed;
+	speed.Build(GetCurveFunction(PART_UPD_CURVE_CUBIC), true);
+
+	ParticlePool pool;
+	pool.Resize(PPT_COUNT);
+	_ppt_Fill(pool, PPT_COUNT);
+
+	const ParticleData &d{ pool.GetData() };
+	vector<vec3> position(PPT_COUNT), velocity(PPT_COUNT);
+	vector<float> age(PPT_COUNT);
+
+	for (uint32_t i = 0; i < PPT_COUNT; ++i)
+	{
+		position[i] = vec3(d.positionX[i], d.positionY[i], d.positionZ[i]);
+		velocity[i] = vec3(d.velocityX[i], d.velocityY[i], d.velocityZ[i]);
+		age[i] = d.age[i];
+	}
+
+	const vec3 acceleration{ 0.f, -9.8f, 0.f };
+	const float dt{ 1.f / 60.f };
+
+	// Odd range bounds exercise both the vector loop and the scalar tail
+	pool.Integrate(0, 501, dt, acceleration, speed);
+	pool.Integrate(501, PPT_COUNT, dt, acceleration, speed);
+
+	float error{ 0.f };
+	for (uint32_t i = 0; i < PPT_COUNT; ++i)
+	{
+		age[i] += dt;
+		velocity[i] += acceleration * dt;
+		position[i] += velocity[i] * speed.Sample(glm::min(age[i] * d.invLifespan[i], 1.f)) * dt;
+
+		error = glm::max(error, length(position[i] - vec3(d.positionX[i], d.positionY[i], d.positionZ[i])));
+		error = glm::max(error, length(velocity[i] - vec3(d.velocityX[i], d.velocityY[i], d.velocityZ[i])));
+		error = glm::max(error, fabsf(age[i] - d.age[i]));
+	}
+
+	TEST_CHECK(error < 1e-5f);
+}
+
+static void _ppt_TestRemoveDead()
+{
+	ParticlePool pool;
+	pool.Resize(PPT_COUNT);
+	_ppt_Fill(pool, PPT_COUNT);
+
+	const ParticleData &d{ pool.GetData() };
+	uint32_t expected{ 0 };
+
+	for (uint32_t i = 0; i < PPT_COUNT; ++i)
+		if ((d.age[i] + .3f) * d.invLifespan[i] < 1.f)
+			++expected;
+
+	for (uint32_t i = 0; i < PPT_COUNT; ++i)
+		pool.GetData().age[i] += .3f;
+
+	pool.RemoveDead();
+	TEST_CHECK(pool.GetAliveCount() == expected);
+
+	for (uint32_t i = 0; i < pool.GetAliveCount(); ++i)
+		TEST_CHECK(d.age[i] * d.invLifespan[i] < 1.f);
+}
+
+static void _ppt_Benchmark()
+{
+	EasingTable speed, size, color;
+	speed.Build(GetCurveFunction(PART_UPD_CURVE_CUBIC), true);
+	size.Build(GetCurveFunction(PART_UPD_CURVE_LINEAR));
+	color.Build(GetCurveFunction(PART_UPD_CURVE_SINE));
+
+	ParticlePool pool;
+	pool.Resize(PPT_BENCH_COUNT);
+	vector<ParticleVertex> vertices(PPT_BENCH_COUNT);
+
+	double integrate{ 0.0 }, write{ 0.0 };
+
+	for (uint32_t f = 0; f < PPT_BENCH_FRAMES; ++f)
+	{
+		_ppt_Fill(pool, PPT_BENCH_COUNT);
+
+		double start{ Test::Time() };
+		pool.Update(1.f / 60.f, vec3(0.f, -9.8f, 0.f), speed);
+		integrate += Test::Time() - start;
+
+		start = Test::Time();
+		pool.WriteVertices(0, pool.GetAliveCount(), vertices.data(), 1.f, 2.f, size, vec4(1.f), vec4(0.f), color);
+		write += Test::Time() - start;
+	}
+
+	printf("%d particles: %.3f ms integrate and compact, %.3f ms write vertices per frame\n",
+		PPT_BENCH_COUNT, integrate / PPT_BENCH_FRAMES, write / PPT_BENCH_FRAMES);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_ppt_TestPacking();
+	_ppt_TestIntegrate();
+	_ppt_TestRemoveDead();
+
+	if (Test::Benchmark())
+		_ppt_Benchmark();
+
+	return Test::Result();
+}
@@ -0,0 +1,189 @@
+/* NekoEngine
+ *
+ * ParticleSimulationTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Parallel particle simulation tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <Engine/Engine.h>
+#include <Engine/TaskManager.h>
+#include <Scene/Particles/Emitter.h>
+#include <Scene/Particles/ParticleSorter.h>
+
+#include "Test.h"
+
+#define PST_COUNT			50000
+#define PST_FRAMES			60
+#define PST_GRAIN			8192
+#define PST_BENCH_COUNT		300000
+#define PST_BENCH_FRAMES	120
+
+using namespace std;
+using namespace glm;
+
+static const vec3 _pst_eye{ 3.f, 4.f, -20.f };
+
+/*
+ * Runs the same kernels as CPUParticleSystemComponent and returns a FNV-1a
+ * hash of the vertices written every frame.
+ */
+static uint64_t _pst_Run(uint32_t count, uint32_t frames, bool sort, vector<ParticleVertex> &vertices, double *ms = nullptr)
+{
+	ParticlePool pool;
+	ParticleSorter sorter;
+	SphereEmitter emitter;
+	EasingTable speed, size, color;
+
+	pool.Resize(count);
+	vertices.resize(count);
+
+	vec3 velocity{ 0.f, 1.f, 0.f }, scale{ 10.f, 10.f, 10.f };
+	emitter.SetPool(&pool);
+	emitter.SetMaxEmit(count / 15);
+	emitter.SetMaxParticles(count);
+	emitter.SetLifespan(1.0);
+	emitter.SetSeed(42);
+	emitter.SetInitialVelocity(velocity);
+	emitter.SetScale(scale);
+
+	speed.Build(GetCurveFunction(PART_UPD_CURVE_CUBIC), true);
+	size.Build(GetCurveFunction(PART_UPD_CURVE_LINEAR));
+	color.Build(GetCurveFunction(PART_UPD_CURVE_LINEAR));
+
+	uint64_t hash{ 1469598103934665603ull };
+	double time{ 0.0 };
+
+	for (uint32_t f = 0; f < frames; ++f)
+	{
+		const double start{ Test::Time() };
+
+		emitter.Emit();
+
+		TaskManager::ParallelFor(pool.GetAliveCount(), PST_GRAIN, [&](uint32_t begin, uint32_t end) {
+			pool.Integrate(begin, end, 1.f / 60.f, vec3(0.f, -9.8f, 0.f), speed);
+		});
+		pool.RemoveDead();
+
+		const uint32_t *order{ sort ? sorter.Sort(pool, _pst_eye) : nullptr };
+		TaskManager::ParallelFor(pool.GetAliveCount(), PST_GRAIN, [&](uint32_t begin, uint32_t end) {
+			pool.WriteVertices(begin, end, vertices.data(), 1.f, 2.f, size, vec4(1.f), vec4(0.f), color, order);
+		});
+
+		time += Test::Time() - start;
+
+		const uint8_t *bytes{ (const uint8_t *)vertices.data() };
+		for (size_t i = 0; i < pool.GetAliveCount() * sizeof(ParticleVertex); ++i)
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+
+	vertices.resize(pool.GetAliveCount());
+
+	if (ms)
+		*ms = time / frames;
+
+	return hash;
+}
+
+static float _pst_Distance(const ParticleVertex &v)
+{
+	const vec3 d{ vec3(v.positionAndAge) - _pst_eye };
+	return dot(d, d);
+}
+
+// The output must not depend on the worker count or on scheduling
+static void _pst_TestDeterminism()
+{
+	vector<ParticleVertex> vertices;
+
+	const uint64_t serial{ _pst_Run(PST_COUNT, PST_FRAMES, true, vertices) };
+	TEST_CHECK(!vertices.empty());
+
+	TaskManager::Initialize();
+	const uint64_t first{ _pst_Run(PST_COUNT, PST_FRAMES, true, vertices) };
+	const uint64_t second{ _pst_Run(PST_COUNT, PST_FRAMES, true, vertices) };
+	TaskManager::Release();
+
+	TEST_CHECK(serial == first);
+	TEST_CHECK(first == second);
+}
+
+static void _pst_TestSortOrder()
+{
+	vector<ParticleVertex> vertices;
+
+	TaskManager::Initialize();
+	_pst_Run(PST_COUNT, 30, true, vertices);
+	TaskManager::Release();
+
+	bool ordered{ true };
+	for (size_t i = 1; i < vertices.size(); ++i)
+		ordered &= _pst_Distance(vertices[i - 1]) >= _pst_Distance(vertices[i]);
+
+	TEST_CHECK(ordered);
+}
+
+static void _pst_Benchmark()
+{
+	vector<ParticleVertex> vertices;
+	double sorted{ 0.0 }, unsorted{ 0.0 };
+
+	TaskManager::Initialize();
+	_pst_Run(PST_BENCH_COUNT, PST_BENCH_FRAMES, true, vertices, &sorted);
+	_pst_Run(PST_BENCH_COUNT, PST_BENCH_FRAMES, false, vertices, &unsorted);
+
+	printf("%d particles, %u workers: %.3f ms per frame sorted, %.3f ms unsorted\n",
+		PST_BENCH_COUNT, TaskManager::GetWorkerCount(), sorted, unsorted);
+
+	TaskManager::Release();
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	// Use workers even on single core machines so the parallel paths run threaded
+	const_cast<Configuration &>(Engine::GetConfiguration()).Engine.WorkerThreads = 4;
+
+	_pst_TestDeterminism();
+	_pst_TestSortOrder();
+
+	if (Test::Benchmark())
+		_pst_Benchmark();
+
+	return Test::Result();
+}
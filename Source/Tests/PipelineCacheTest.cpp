@@ -0,0 +1,276 @@
+/* NekoEngine
+ *
+ * PipelineCacheTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Pipeline cache file validation tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <Renderer/PipelineCache.h>
+
+#include "Test.h"
+
+#define PCT_VENDOR		0x10DE
+#define PCT_DEVICE		0x1B80
+#define PCT_DRIVER		0x17A34000
+#define PCT_PAYLOAD		4000
+
+using namespace std;
+
+static VkPhysicalDeviceProperties _pct_Properties()
+{
+	VkPhysicalDeviceProperties properties{};
+
+	properties.vendorID = PCT_VENDOR;
+	properties.deviceID = PCT_DEVICE;
+	properties.driverVersion = PCT_DRIVER;
+
+	for (uint32_t i = 0; i < VK_UUID_SIZE; ++i)
+		properties.pipelineCacheUUID[i] = (uint8_t)(i * 7 + 3);
+
+	return properties;
+}
+
+/**
+ * What vkGetPipelineCacheData returns: VkPipelineCacheHeaderVersionOne
+ * followed by the driver's opaque data.
+ */
+static vector<uint8_t> _pct_DriverData(const VkPhysicalDeviceProperties &properties)
+{
+	uint32_t header[4]{ 16 + VK_UUID_SIZE, VK_PIPELINE_CACHE_HEADER_VERSION_ONE, properties.vendorID, properties.deviceID };
+	vector<uint8_t> data(sizeof(header) + VK_UUID_SIZE + PCT_PAYLOAD);
+
+	memcpy(data.data(), header, sizeof(header));
+	memcpy(data.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+	for (size_t i = sizeof(header) + VK_UUID_SIZE; i < data.size(); ++i)
+		data[i] = (uint8_t)(i * 31);
+
+	return data;
+}
+
+static vector<uint8_t> _pct_File(const VkPhysicalDeviceProperties &properties, const vector<uint8_t> &data)
+{
+	PipelineCacheFileHeader header;
+	PipelineCache::FillHeader(header, properties, data.data(), data.size());
+
+	vector<uint8_t> file(sizeof(header) + data.size());
+	memcpy(file.data(), &header, sizeof(header));
+	memcpy(file.data() + sizeof(header), data.data(), data.size());
+
+	return file;
+}
+
+static PipelineCacheStatus _pct_Validate(const vector<uint8_t> &file, const VkPhysicalDeviceProperties &properties)
+{
+	return PipelineCache::Validate(file.data(), file.size(), properties);
+}
+
+static void _pct_TestHeader()
+{
+	const VkPhysicalDeviceProperties properties{ _pct_Properties() };
+	const vector<uint8_t> data{ _pct_DriverData(properties) };
+	const vector<uint8_t> file{ _pct_File(properties, data) };
+
+	TEST_CHECK(_pct_Validate(file, properties) == PIPE_CACHE_Valid);
+
+	PipelineCacheFileHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	TEST_CHECK(header.magic == PIPELINE_CACHE_MAGIC && header.version == PIPELINE_CACHE_VERSION);
+	TEST_CHECK(header.vendorId == PCT_VENDOR && header.deviceId == PCT_DEVICE && header.driverVersion == PCT_DRIVER);
+	TEST_CHECK(header.dataSize == data.size());
+	TEST_CHECK(!memcmp(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE));
+
+	// Fields of our header
+	vector<uint8_t> bad{ file };
+	((PipelineCacheFileHeader *)bad.data())->magic ^= 1;
+	TEST_CHECK(_pct_Validate(bad, properties) == PIPE_CACHE_BadMagic);
+
+	bad = file;
+	((PipelineCacheFileHeader *)bad.data())->version = PIPELINE_CACHE_VERSION + 1;
+	TEST_CHECK(_pct_Validate(bad, properties) == PIPE_CACHE_VersionMismatch);
+
+	// A cache from another device or driver
+	VkPhysicalDeviceProperties other{ properties };
+	other.vendorID = 0x1002;
+	TEST_CHECK(_pct_Validate(file, other) == PIPE_CACHE_DeviceMismatch);
+
+	other = properties;
+	other.deviceID ^= 1;
+	TEST_CHECK(_pct_Validate(file, other) == PIPE_CACHE_DeviceMismatch);
+
+	other = properties;
+	other.pipelineCacheUUID[VK_UUID_SIZE - 1] ^= 0x80;
+	TEST_CHECK(_pct_Validate(file, other) == PIPE_CACHE_DeviceMismatch);
+
+	other = properties;
+	other.driverVersion += 1;
+	TEST_CHECK(_pct_Validate(file, other) == PIPE_CACHE_DriverMismatch);
+
+	// Truncated writes
+	TEST_CHECK(PipelineCache::Validate(nullptr, 0, properties) == PIPE_CACHE_Truncated);
+	TEST_CHECK(PipelineCache::Validate(file.data(), sizeof(PipelineCacheFileHeader) - 1, properties) == PIPE_CACHE_Truncated);
+	TEST_CHECK(PipelineCache::Validate(file.data(), sizeof(PipelineCacheFileHeader), properties) == PIPE_CACHE_Truncated);
+	TEST_CHECK(PipelineCache::Validate(file.data(), file.size() - 1, properties) == PIPE_CACHE_Truncated);
+
+	// Trailing bytes and any changed byte of the driver data
+	bad = file;
+	bad.push_back(0);
+	TEST_CHECK(_pct_Validate(bad, properties) == PIPE_CACHE_Corrupt);
+
+	uint32_t detected{ 0 }, flipped{ 0 };
+	for (size_t i = sizeof(PipelineCacheFileHeader); i < file.size(); i += 37, ++flipped)
+	{
+		bad = file;
+		bad[i] ^= 1 << (i % 8);
+		if (_pct_Validate(bad, properties) == PIPE_CACHE_Corrupt)
+			++detected;
+	}
+	TEST_CHECK(detected == flipped);
+
+	bad = file;
+	((PipelineCacheFileHeader *)bad.data())->dataHash ^= 1;
+	TEST_CHECK(_pct_Validate(bad, properties) == PIPE_CACHE_Corrupt);
+}
+
+/**
+ * The driver's header must agree with ours even when our hash matches,
+ * as it does for a file written by another build with the same header.
+ */
+static void _pct_TestDriverHeader()
+{
+	const VkPhysicalDeviceProperties properties{ _pct_Properties() };
+	vector<uint8_t> data;
+
+	auto validate = [&properties](const vector<uint8_t> &driverData) {
+		return _pct_Validate(_pct_File(properties, driverData), properties);
+	};
+
+	data = _pct_DriverData(properties);
+	((uint32_t *)data.data())[0] = 16;
+	TEST_CHECK(validate(data) == PIPE_CACHE_Corrupt);
+
+	data = _pct_DriverData(properties);
+	((uint32_t *)data.data())[1] = VK_PIPELINE_CACHE_HEADER_VERSION_ONE + 1;
+	TEST_CHECK(validate(data) == PIPE_CACHE_Corrupt);
+
+	data = _pct_DriverData(properties);
+	((uint32_t *)data.data())[2] = 0x8086;
+	TEST_CHECK(validate(data) == PIPE_CACHE_DeviceMismatch);
+
+	data = _pct_DriverData(properties);
+	((uint32_t *)data.data())[3] ^= 1;
+	TEST_CHECK(validate(data) == PIPE_CACHE_DeviceMismatch);
+
+	data = _pct_DriverData(properties);
+	data[16] ^= 1;
+	TEST_CHECK(validate(data) == PIPE_CACHE_DeviceMismatch);
+
+	// Too short to hold the driver's header
+	data = _pct_DriverData(properties);
+	data.resize(16 + VK_UUID_SIZE - 1);
+	TEST_CHECK(validate(data) == PIPE_CACHE_Corrupt);
+
+	data = _pct_DriverData(properties);
+	data.resize(16 + VK_UUID_SIZE);
+	TEST_CHECK(validate(data) == PIPE_CACHE_Valid);
+
+	// Every status has its own message
+	for (uint8_t i = PIPE_CACHE_Valid; i <= PIPE_CACHE_Corrupt; ++i)
+	{
+		TEST_CHECK(strcmp(PipelineCache::GetStatusString((PipelineCacheStatus)i), "unknown"));
+		for (uint8_t j = PIPE_CACHE_Valid; j < i; ++j)
+			TEST_CHECK(strcmp(PipelineCache::GetStatusString((PipelineCacheStatus)i), PipelineCache::GetStatusString((PipelineCacheStatus)j)));
+	}
+}
+
+static void _pct_TestFiles()
+{
+	const VkPhysicalDeviceProperties properties{ _pct_Properties() };
+	const vector<uint8_t> data{ _pct_DriverData(properties) };
+	vector<uint8_t> read;
+	PipelineCacheStatus status;
+
+	char root[] = "/tmp/pipelinecache_XXXXXX";
+	TEST_CHECK(mkdtemp(root) != nullptr);
+
+	// The application data directory may not exist yet
+	const string path{ string(root) + "/NekoEngine/" PIPELINE_CACHE_FILE };
+
+	TEST_CHECK(!PipelineCache::ReadFile(path.c_str(), properties, read, status));
+	TEST_CHECK(PipelineCache::WriteFile(path.c_str(), properties, data.data(), data.size()));
+
+	TEST_CHECK(PipelineCache::ReadFile(path.c_str(), properties, read, status));
+	TEST_CHECK(status == PIPE_CACHE_Valid);
+	TEST_CHECK(read == data);
+
+	VkPhysicalDeviceProperties updated{ properties };
+	updated.driverVersion += 1;
+	TEST_CHECK(PipelineCache::ReadFile(path.c_str(), updated, read, status));
+	TEST_CHECK(status == PIPE_CACHE_DriverMismatch && read.empty());
+
+	// A write interrupted half way
+	TEST_CHECK(truncate(path.c_str(), sizeof(PipelineCacheFileHeader) + data.size() / 2) == 0);
+	TEST_CHECK(PipelineCache::ReadFile(path.c_str(), properties, read, status));
+	TEST_CHECK(status == PIPE_CACHE_Truncated && read.empty());
+
+	TEST_CHECK(truncate(path.c_str(), 0) == 0);
+	TEST_CHECK(!PipelineCache::ReadFile(path.c_str(), properties, read, status));
+
+	// Nowhere to write
+	const uint32_t warnings{ Test::GetLogCount(LOG_WARNING) };
+	TEST_CHECK(!PipelineCache::WriteFile((string(root) + "/missing/dir/" PIPELINE_CACHE_FILE).c_str(), properties, data.data(), data.size()));
+	TEST_CHECK(Test::GetLogCount(LOG_WARNING) == warnings + 1);
+
+	system((string("rm -rf ") + root).c_str());
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_pct_TestHeader();
+	_pct_TestDriverHeader();
+	_pct_TestFiles();
+
+	return Test::Result();
+}
@@ -0,0 +1,179 @@
+/* NekoEngine
+ *
+ * PipelineVariantsTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Material pipeline variant table tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <set>
+#include <vector>
+
+#include <Engine/Defs.h>
+#include <Renderer/PipelineVariants.h>
+
+#include "Test.h"
+
+#define PVT_VARIANTS	5
+
+using namespace std;
+
+/** The ids and layouts the material pipelines had before they were table driven */
+static const struct
+{
+	PipelineId id;
+	PipelineLayoutId layout;
+	const char *name;
+} _pvt_expected[]
+{
+	{ PIPE_Unlit, PIPE_LYT_OneSampler, "unlit" },
+	{ PIPE_Phong, PIPE_LYT_OneSampler, "phong" },
+	{ PIPE_PhongSpecular, PIPE_LYT_TwoSamplers, "phong specular" },
+	{ PIPE_PhongSpecularEmissive, PIPE_LYT_ThreeSamplers, "phong specular emissive" },
+	{ PIPE_PhongNormal, PIPE_LYT_OneSampler, "phong normal" },
+	{ PIPE_PhongNormalSpecular, PIPE_LYT_TwoSamplers, "phong normal specular" },
+	{ PIPE_PhongNormalSpecularEmissive, PIPE_LYT_ThreeSamplers, "phong normal specular emissive" },
+	{ PIPE_Transparent_Unlit, PIPE_LYT_OneSampler, "transparent unlit" },
+	{ PIPE_Transparent_Phong, PIPE_LYT_OneSampler, "transparent phong" },
+	{ PIPE_Transparent_PhongSpecular, PIPE_LYT_TwoSamplers, "transparent phong specular" },
+	{ PIPE_Transparent_PhongSpecularEmissive, PIPE_LYT_ThreeSamplers, "transparent phong specular emissive" },
+	{ PIPE_Transparent_PhongNormal, PIPE_LYT_OneSampler, "transparent phong normal" },
+	{ PIPE_Transparent_PhongNormalSpecular, PIPE_LYT_TwoSamplers, "transparent phong normal specular" },
+	{ PIPE_Transparent_PhongNormalSpecularEmissive, PIPE_LYT_ThreeSamplers, "transparent phong normal specular emissive" },
+	{ PIPE_Anim_Unlit, PIPE_LYT_Anim_OneSampler, "animated unlit" },
+	{ PIPE_Anim_Phong, PIPE_LYT_Anim_OneSampler, "animated phong" },
+	{ PIPE_Anim_PhongSpecular, PIPE_LYT_Anim_TwoSamplers, "animated phong specular" },
+	{ PIPE_Anim_PhongSpecularEmissive, PIPE_LYT_Anim_ThreeSamplers, "animated phong specular emissive" },
+	{ PIPE_Anim_PhongNormal, PIPE_LYT_Anim_OneSampler, "animated phong normal" },
+	{ PIPE_Anim_PhongNormalSpecular, PIPE_LYT_Anim_TwoSamplers, "animated phong normal specular" },
+	{ PIPE_Anim_PhongNormalSpecularEmissive, PIPE_LYT_Anim_ThreeSamplers, "animated phong normal specular emissive" },
+	{ PIPE_Transparent_Anim_Unlit, PIPE_LYT_Anim_OneSampler, "transparent animated unlit" },
+	{ PIPE_Transparent_Anim_Phong, PIPE_LYT_Anim_OneSampler, "transparent animated phong" },
+	{ PIPE_Transparent_Anim_PhongSpecular, PIPE_LYT_Anim_TwoSamplers, "transparent animated phong specular" },
+	{ PIPE_Transparent_Anim_PhongSpecularEmissive, PIPE_LYT_Anim_ThreeSamplers, "transparent animated phong specular emissive" },
+	{ PIPE_Transparent_Anim_PhongNormal, PIPE_LYT_Anim_OneSampler, "transparent animated phong normal" },
+	{ PIPE_Transparent_Anim_PhongNormalSpecular, PIPE_LYT_Anim_TwoSamplers, "transparent animated phong normal specular" },
+	{ PIPE_Transparent_Anim_PhongNormalSpecularEmissive, PIPE_LYT_Anim_ThreeSamplers, "transparent animated phong normal specular emissive" },
+	{ PIPE_Instanced_Unlit, PIPE_LYT_Instanced_OneSampler, "instanced unlit" },
+	{ PIPE_Instanced_Phong, PIPE_LYT_Instanced_OneSampler, "instanced phong" },
+	{ PIPE_Instanced_PhongSpecular, PIPE_LYT_Instanced_TwoSamplers, "instanced phong specular" },
+	{ PIPE_Instanced_PhongSpecularEmissive, PIPE_LYT_Instanced_ThreeSamplers, "instanced phong specular emissive" },
+	{ PIPE_Instanced_PhongNormal, PIPE_LYT_Instanced_OneSampler, "instanced phong normal" },
+	{ PIPE_Instanced_PhongNormalSpecular, PIPE_LYT_Instanced_TwoSamplers, "instanced phong normal specular" },
+	{ PIPE_Instanced_PhongNormalSpecularEmissive, PIPE_LYT_Instanced_ThreeSamplers, "instanced phong normal specular emissive" }
+};
+
+static void _pvt_TestExpand()
+{
+	uint32_t count{ 0 };
+	const MaterialPipelineDesc *table{ PipelineVariants::GetMaterialTable(count) };
+	vector<PipelineVariant> variants{};
+
+	TEST_CHECK(table && count == 7);
+	TEST_CHECK(PipelineVariants::Expand(table, count, variants) == ENGINE_OK);
+	TEST_CHECK(variants.size() == count * PVT_VARIANTS);
+	TEST_CHECK(variants.size() == sizeof(_pvt_expected) / sizeof(_pvt_expected[0]));
+
+	set<uint32_t> ids{};
+	for (size_t i = 0; i < variants.size() && i < sizeof(_pvt_expected) / sizeof(_pvt_expected[0]); ++i)
+	{
+		const PipelineVariant &variant{ variants[i] };
+		const MaterialPipelineDesc &desc{ table[i % count] };
+
+		TEST_CHECK(variant.id == _pvt_expected[i].id);
+		TEST_CHECK(variant.layout == _pvt_expected[i].layout);
+		TEST_CHECK(!strcmp(variant.name, _pvt_expected[i].name));
+
+		// Shaders come from the entry; the flags follow the id offsets
+		TEST_CHECK(variant.vertexType == desc.vertexType && variant.fragmentType == desc.fragmentType);
+		TEST_CHECK(variant.numTextures == desc.numTextures);
+		TEST_CHECK(((variant.flags & PIPE_VAR_Animated) != 0) == ((variant.id % PIPE_VAR_TRANSPARENT_OFFSET) >= PIPE_VAR_ANIM_OFFSET));
+		TEST_CHECK(((variant.flags & PIPE_VAR_Transparent) != 0) == (variant.id >= PIPE_VAR_TRANSPARENT_OFFSET && variant.id < PIPE_VAR_INSTANCED_OFFSET));
+		TEST_CHECK(((variant.flags & PIPE_VAR_Instanced) != 0) == (variant.id >= PIPE_VAR_INSTANCED_OFFSET));
+
+		ids.insert(variant.id);
+	}
+
+	TEST_CHECK(ids.size() == variants.size());
+
+	// The special pipelines keep their own ids
+	for (PipelineId id : { PIPE_Depth, PIPE_DepthNormal, PIPE_Shadow, PIPE_Anim_Depth, PIPE_Anim_DepthNormal, PIPE_Anim_Shadow,
+		PIPE_Instanced_Depth, PIPE_Instanced_DepthNormal, PIPE_Skysphere, PIPE_GUI, PIPE_Font })
+		TEST_CHECK(!ids.count(id));
+}
+
+static void _pvt_TestTables()
+{
+	vector<PipelineVariant> variants(1);
+	variants[0].id = PIPE_GUI;
+
+	// Appends to what is already there
+	const MaterialPipelineDesc one[]{ { PIPE_PhongSpecular, "custom", SH_VTX, SH_FRAG_PHONG_SPEC, 4 } };
+	TEST_CHECK(PipelineVariants::Expand(one, 1, variants) == ENGINE_OK);
+	TEST_CHECK(variants.size() == 1 + PVT_VARIANTS);
+	TEST_CHECK(variants[0].id == PIPE_GUI);
+	TEST_CHECK(variants[1].layout == PIPE_LYT_FourSamplers && variants[3].layout == PIPE_LYT_Anim_FourSamplers);
+	TEST_CHECK(!strcmp(variants[4].name, "transparent animated custom"));
+	TEST_CHECK(variants[5].id == PIPE_Instanced_PhongSpecular && variants[5].layout == PIPE_LYT_Instanced_FourSamplers);
+
+	// Invalid entries reject the whole table and add nothing
+	const MaterialPipelineDesc badId[]{ one[0], { PIPE_Anim_Phong, "animated", SH_VTX, SH_FRAG_PHONG, 1 } };
+	const MaterialPipelineDesc noTextures[]{ { PIPE_Phong, "none", SH_VTX, SH_FRAG_PHONG, 0 } };
+	const MaterialPipelineDesc tooMany[]{ { PIPE_Phong, "five", SH_VTX, SH_FRAG_PHONG, 5 } };
+
+	TEST_CHECK(PipelineVariants::Expand(badId, 2, variants) == ENGINE_INVALID_ARGS);
+	TEST_CHECK(PipelineVariants::Expand(noTextures, 1, variants) == ENGINE_INVALID_ARGS);
+	TEST_CHECK(PipelineVariants::Expand(tooMany, 1, variants) == ENGINE_INVALID_ARGS);
+	TEST_CHECK(variants.size() == 1 + PVT_VARIANTS);
+
+	TEST_CHECK(PipelineVariants::Expand(nullptr, 0, variants) == ENGINE_OK);
+	TEST_CHECK(variants.size() == 1 + PVT_VARIANTS);
+
+	// Long names are cut to fit
+	const MaterialPipelineDesc longName[]{ { PIPE_Phong, "a material name that is much longer than the space left for it after the prefixes", SH_VTX, SH_FRAG_PHONG, 1 } };
+	TEST_CHECK(PipelineVariants::Expand(longName, 1, variants) == ENGINE_OK);
+	TEST_CHECK(strlen(variants.back().name) == PIPE_VAR_MAX_NAME - 1);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_pvt_TestExpand();
+	_pvt_TestTables();
+
+	return Test::Result();
+}
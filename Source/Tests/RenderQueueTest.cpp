@@ -0,0 +1,478 @@
+/* NekoEngine
+ *
+ * RenderQueueTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Render queue sort key and ordering tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <map>
+#include <tuple>
+#include <random>
+#include <vector>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#include <Renderer/RenderQueue.h>
+
+#include "Test.h"
+
+#define RQT_SEED			5
+#define RQT_SORT_COUNT		50000
+#define RQT_HASH_COUNT		65536
+#define RQT_MATERIALS		32
+#define RQT_MESHES			64
+#define RQT_PIPELINES		8
+#define RQT_DRAWABLES		2000
+#define RQT_INSTANCES		100
+#define RQT_BENCH_DRAWABLES	100000
+
+using namespace std;
+
+typedef tuple<uint8_t, const void *, const void *, uint32_t> RqtState;
+
+static inline uint32_t _rqt_FloatBits(float f)
+{
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+static inline const void *_rqt_Address(uint32_t i)
+{
+	// Spaced like heap allocations of a small object
+	return (const void *)(uintptr_t)(0x10000000ull + i * 96ull);
+}
+
+static bool _rqt_CheckSort(vector<RenderQueueItem> &items)
+{
+	vector<RenderQueueItem> expected{ items }, scratch(items.size());
+
+	stable_sort(expected.begin(), expected.end(), [](const RenderQueueItem &a, const RenderQueueItem &b) { return a.key < b.key; });
+	RenderQueueItem *sorted{ RenderQueue::RadixSort(items.data(), scratch.data(), items.size()) };
+
+	for (size_t i = 0; i < items.size(); ++i)
+		if (sorted[i].key != expected[i].key || sorted[i].index != expected[i].index)
+			return false;
+
+	return true;
+}
+
+static void _rqt_TestRadixSort()
+{
+	mt19937_64 rng{ RQT_SEED };
+	vector<RenderQueueItem> items(RQT_SORT_COUNT);
+
+	// Full width keys
+	for (uint32_t i = 0; i < RQT_SORT_COUNT; ++i)
+		items[i] = { rng(), i };
+	TEST_CHECK(_rqt_CheckSort(items));
+
+	// Few distinct keys; equal keys must keep their order
+	for (uint32_t i = 0; i < RQT_SORT_COUNT; ++i)
+		items[i] = { (rng() % 16) << 40, i };
+	TEST_CHECK(_rqt_CheckSort(items));
+
+	// Digits that are the same for every key are skipped
+	for (uint32_t i = 0; i < RQT_SORT_COUNT; ++i)
+		items[i] = { 0xABCD000000000000ull | (rng() & 0xFFFFFF), i };
+	TEST_CHECK(_rqt_CheckSort(items));
+
+	for (uint32_t i = 0; i < RQT_SORT_COUNT; ++i)
+		items[i] = { 42, i };
+	TEST_CHECK(_rqt_CheckSort(items));
+
+	items.resize(1);
+	TEST_CHECK(_rqt_CheckSort(items));
+
+	items.clear();
+	TEST_CHECK(_rqt_CheckSort(items));
+}
+
+static void _rqt_TestHashIdentity()
+{
+	vector<uint32_t> top(RQT_HASH_COUNT);
+
+	for (uint32_t i = 0; i < RQT_HASH_COUNT; ++i)
+		top[i] = RenderQueue::HashIdentity(_rqt_Address(i)) >> (32 - RQ_IDENTITY_BITS);
+
+	TEST_CHECK(RenderQueue::HashIdentity(_rqt_Address(1)) == RenderQueue::HashIdentity(_rqt_Address(1)));
+	TEST_CHECK(RenderQueue::HashIdentity(_rqt_Address(1), 1) != RenderQueue::HashIdentity(_rqt_Address(1)));
+	TEST_CHECK(RenderQueue::HashIdentity(_rqt_Address(1), 1) != RenderQueue::HashIdentity(_rqt_Address(1), 2));
+
+	// The materials and meshes of a scene must not share a key
+	{
+		vector<uint32_t> scene{ top.begin(), top.begin() + RQT_MESHES * 4 };
+		sort(scene.begin(), scene.end());
+		TEST_CHECK(adjacent_find(scene.begin(), scene.end()) == scene.end());
+	}
+
+	// Over the whole set the kept bits collide no more than a random function would
+	sort(top.begin(), top.end());
+	size_t distinct{ (size_t)(unique(top.begin(), top.end()) - top.begin()) };
+	double n{ RQT_HASH_COUNT }, buckets{ 1 << RQ_IDENTITY_BITS };
+	double expected{ buckets * (1.0 - exp(-n / buckets)) };
+	TEST_CHECK(distinct > expected * 0.99);
+}
+
+static void _rqt_TestKeys()
+{
+	// Opaque before transparent
+	TEST_CHECK(RenderQueue::MakeKey(RQ_PASS_Opaque, 255, ~0u, ~0u, 1e30f) < RenderQueue::MakeKey(RQ_PASS_Transparent, 0, 0, 0, 0.f));
+
+	// Opaque: state first, then front to back
+	TEST_CHECK(RenderQueue::MakeKey(RQ_PASS_Opaque, 0, 0, 0, 1000.f) < RenderQueue::MakeKey(RQ_PASS_Opaque, 1, 0, 0, 1.f));
+	TEST_CHECK(RenderQueue::MakeKey(RQ_PASS_Opaque, 1, 0, ~0u, 1000.f) < RenderQueue::MakeKey(RQ_PASS_Opaque, 1, 1u << 12, 0, 1.f));
+	TEST_CHECK(RenderQueue::MakeKey(RQ_PASS_Opaque, 1, 1u << 12, 0, 1000.f) < RenderQueue::MakeKey(RQ_PASS_Opaque, 1, 1u << 12, 1u << 12, 1.f));
+	TEST_CHECK(RenderQueue::MakeKey(RQ_PASS_Opaque, 1, 2, 3, 1.f) < RenderQueue::MakeKey(RQ_PASS_Opaque, 1, 2, 3, 1.1f));
+	TEST_CHECK(RenderQueue::MakeKey(RQ_PASS_Opaque, 1, 2, 3, 0.5f) < RenderQueue::MakeKey(RQ_PASS_Opaque, 1, 2, 3, 3.f));
+	TEST_CHECK(RenderQueue::MakeKey(RQ_PASS_Opaque, 1, 2, 3, 100.f) < RenderQueue::MakeKey(RQ_PASS_Opaque, 1, 2, 3, 1e30f));
+
+	// Negative depth is clamped to the near plane
+	TEST_CHECK(RenderQueue::MakeKey(RQ_PASS_Opaque, 1, 2, 3, -5.f) == RenderQueue::MakeKey(RQ_PASS_Opaque, 1, 2, 3, 0.f));
+
+	// Transparent: back to front regardless of state
+	TEST_CHECK(RenderQueue::MakeKey(RQ_PASS_Transparent, 255, ~0u, ~0u, 10.f) < RenderQueue::MakeKey(RQ_PASS_Transparent, 0, 0, 0, 9.99f));
+	TEST_CHECK(RenderQueue::MakeKey(RQ_PASS_Transparent, 0, 0, 0, 0.5f) < RenderQueue::MakeKey(RQ_PASS_Transparent, 0, 0, 0, 0.f));
+}
+
+static void _rqt_Fill(vector<Drawable> &drawables, vector<float> &depths, size_t count, mt19937 &rng)
+{
+	uniform_real_distribution<float> depth{ 0.1f, 500.f };
+
+	drawables.resize(count);
+	depths.resize(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		Drawable &d{ drawables[i] };
+		d = {};
+
+		d.pipeline = (uint8_t)(rng() % RQT_PIPELINES);
+		d.material = _rqt_Address(rng() % RQT_MATERIALS);
+		d.mesh = _rqt_Address(RQT_MATERIALS + rng() % RQT_MESHES);
+		d.group = rng() % 4;
+		d.transparent = rng() % 10 == 0;
+
+		depths[i] = depth(rng);
+	}
+}
+
+static void _rqt_TestOrdering()
+{
+	mt19937 rng{ RQT_SEED };
+	vector<Drawable> drawables;
+	vector<float> depths;
+	map<const Drawable *, size_t> position;
+	RenderQueue queue;
+
+	_rqt_Fill(drawables, depths, RQT_DRAWABLES, rng);
+
+	// Two identical draws keep their submission order
+	drawables.push_back(drawables[0]);
+	depths.push_back(depths[0]);
+
+	for (size_t i = 0; i < drawables.size(); ++i)
+	{
+		queue.Add(&drawables[i], depths[i]);
+		position[&drawables[i]] = i;
+	}
+	queue.Build();
+
+	TEST_CHECK(queue.GetCount() == drawables.size());
+
+	map<RqtState, size_t> runs;
+	size_t transparentStart{ queue.GetCount() }, lastOriginal{ 0 }, lastCopy{ 0 };
+	bool opaqueAfterTransparent{ false }, frontToBack{ true }, backToFront{ true };
+
+	for (size_t i = 0; i < queue.GetCount(); ++i)
+	{
+		const Drawable *d{ queue.GetDrawable(i) };
+		size_t pos{ position[d] };
+		const Drawable *prev{ i ? queue.GetDrawable(i - 1) : nullptr };
+		float prevDepth{ prev ? depths[position[prev]] : 0.f };
+
+		if (pos == 0)
+			lastOriginal = i;
+		else if (pos == drawables.size() - 1)
+			lastCopy = i;
+
+		if (d->transparent)
+		{
+			if (transparentStart == queue.GetCount())
+				transparentStart = i;
+			else if ((_rqt_FloatBits(depths[pos]) >> 1) > (_rqt_FloatBits(prevDepth) >> 1))
+				backToFront = false;
+			continue;
+		}
+
+		if (transparentStart != queue.GetCount())
+			opaqueAfterTransparent = true;
+
+		RqtState state{ d->pipeline, d->material, d->mesh, d->group };
+		bool sameRun{ prev && RqtState{ prev->pipeline, prev->material, prev->mesh, prev->group } == state };
+
+		if (!sameRun)
+			++runs[state];
+		else if ((_rqt_FloatBits(depths[pos]) >> (32 - RQ_DEPTH_BITS - 1)) < (_rqt_FloatBits(prevDepth) >> (32 - RQ_DEPTH_BITS - 1)))
+			frontToBack = false;
+	}
+
+	TEST_CHECK(!opaqueAfterTransparent);
+	TEST_CHECK(transparentStart < queue.GetCount());
+	TEST_CHECK(frontToBack);
+	TEST_CHECK(backToFront);
+	TEST_CHECK(lastOriginal < lastCopy);
+
+	// Each opaque state is drawn as a single contiguous run
+	bool contiguous{ true };
+	for (const pair<const RqtState, size_t> &run : runs)
+		if (run.second != 1)
+			contiguous = false;
+	TEST_CHECK(contiguous);
+
+	// The queue is reusable after Clear
+	queue.Clear();
+	queue.Build();
+	TEST_CHECK(queue.GetCount() == 0);
+
+	queue.Add(&drawables[1], 1.f);
+	queue.Build();
+	TEST_CHECK(queue.GetCount() == 1 && queue.GetDrawable(0) == &drawables[1]);
+}
+
+static inline Drawable _rqt_Instanceable(const void *mesh, uint32_t group, uint32_t id)
+{
+	Drawable d{};
+
+	d.pipeline = 1;
+	d.material = _rqt_Address(0);
+	d.mesh = mesh;
+	d.group = group;
+	d.sceneCommandBuffer = (VkCommandBuffer)(uintptr_t)(0x1000 + id);
+	d.instancedSceneCommandBuffer = (VkCommandBuffer)(uintptr_t)0x2000;
+	d.instanceData = _rqt_Address(1000 + id);
+
+	return d;
+}
+
+static void _rqt_TestBatches()
+{
+	mt19937 rng{ RQT_SEED };
+	uniform_real_distribution<float> depth{ 0.1f, 500.f };
+	vector<Drawable> drawables;
+	RenderQueue queue;
+
+	// RQT_INSTANCES draws of one mesh, 20 of another, 15 of the first mesh in
+	// another group, 10 that can't be instanced and 5 transparent ones. The
+	// first three sets share pipeline and material, so they sort next to each other
+	for (uint32_t i = 0; i < RQT_INSTANCES; ++i)
+		drawables.push_back(_rqt_Instanceable(_rqt_Address(1), 0, i));
+
+	for (uint32_t i = 0; i < 20; ++i)
+		drawables.push_back(_rqt_Instanceable(_rqt_Address(2), 0, RQT_INSTANCES + i));
+
+	for (uint32_t i = 0; i < 15; ++i)
+		drawables.push_back(_rqt_Instanceable(_rqt_Address(1), 1, RQT_INSTANCES + 20 + i));
+
+	for (uint32_t i = 0; i < 10; ++i)
+	{
+		drawables.push_back(_rqt_Instanceable(_rqt_Address(1), 0, RQT_INSTANCES + 35 + i));
+		drawables.back().material = _rqt_Address(5 + i % 2);
+
+		if (i % 2)
+			drawables.back().instanceData = nullptr;
+		else
+			drawables.back().instancedSceneCommandBuffer = VK_NULL_HANDLE;
+	}
+
+	for (uint32_t i = 0; i < 5; ++i)
+	{
+		Drawable d{};
+		d.transparent = true;
+		d.material = _rqt_Address(3);
+		d.mesh = _rqt_Address(4);
+		drawables.push_back(d);
+	}
+
+	shuffle(drawables.begin(), drawables.end(), rng);
+
+	for (Drawable &d : drawables)
+		queue.Add(&d, depth(rng));
+	queue.Build();
+
+	const vector<RenderQueueBatch> &batches{ queue.GetBatches() };
+
+	// The batches cover the sorted draws in order
+	uint32_t next{ 0 };
+	bool covered{ true }, sameState{ true }, instanceData{ true };
+	vector<uint32_t> counts;
+
+	for (const RenderQueueBatch &batch : batches)
+	{
+		if (batch.first != next || !batch.count)
+			covered = false;
+		next = batch.first + batch.count;
+
+		const Drawable *leader{ queue.GetDrawable(batch.first) };
+		const void *const *data{ queue.GetInstanceData(batch) };
+
+		for (uint32_t i = 0; i < batch.count; ++i)
+		{
+			const Drawable *d{ queue.GetDrawable(batch.first + i) };
+
+			if (d->mesh != leader->mesh || d->group != leader->group || d->material != leader->material)
+				sameState = false;
+
+			if (data[i] != d->instanceData)
+				instanceData = false;
+		}
+
+		counts.push_back(batch.count);
+	}
+
+	TEST_CHECK(covered && next == queue.GetCount());
+	TEST_CHECK(sameState);
+	TEST_CHECK(instanceData);
+
+	// The same key draws become one draw each; the rest are drawn one by one
+	sort(counts.begin(), counts.end());
+	TEST_CHECK(batches.size() == 3 + 10 + 5);
+	TEST_CHECK(counts[counts.size() - 1] == RQT_INSTANCES);
+	TEST_CHECK(counts[counts.size() - 2] == 20);
+	TEST_CHECK(counts[counts.size() - 3] == 15);
+	TEST_CHECK(counts[counts.size() - 4] == 1);
+
+	// Draws with and without a depth pass are not merged
+	queue.Clear();
+	drawables.clear();
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		drawables.push_back(_rqt_Instanceable(_rqt_Address(1), 0, i));
+		if (i % 2)
+			drawables.back().instancedDepthCommandBuffer = (VkCommandBuffer)(uintptr_t)0x3000;
+	}
+
+	for (Drawable &d : drawables)
+		queue.Add(&d, depth(rng));
+	queue.Build();
+
+	bool split{ true };
+	for (const RenderQueueBatch &batch : queue.GetBatches())
+		for (uint32_t i = 1; i < batch.count; ++i)
+			if (queue.GetDrawable(batch.first + i)->instancedDepthCommandBuffer != queue.GetDrawable(batch.first)->instancedDepthCommandBuffer)
+				split = false;
+	TEST_CHECK(split && queue.GetBatches().size() >= 2);
+
+	// Nothing is batched in an empty queue
+	queue.Clear();
+	queue.Build();
+	TEST_CHECK(queue.GetBatches().empty());
+}
+
+static void _rqt_Benchmark()
+{
+	mt19937 rng{ RQT_SEED };
+	vector<Drawable> drawables;
+	vector<float> depths;
+	RenderQueue queue;
+
+	_rqt_Fill(drawables, depths, RQT_BENCH_DRAWABLES, rng);
+
+	double addTime{ 0.0 }, buildTime{ 0.0 }, radixTime{ 0.0 }, stdTime{ 0.0 };
+	const uint32_t runs{ 20 };
+	vector<RenderQueueItem> items(RQT_BENCH_DRAWABLES), copy, scratch(RQT_BENCH_DRAWABLES);
+
+	for (uint32_t i = 0; i < RQT_BENCH_DRAWABLES; ++i)
+	{
+		const Drawable &d{ drawables[i] };
+		items[i].key = RenderQueue::MakeKey(d.transparent ? RQ_PASS_Transparent : RQ_PASS_Opaque, d.pipeline,
+			RenderQueue::HashIdentity(d.material), RenderQueue::HashIdentity(d.mesh, d.group), depths[i]);
+		items[i].index = i;
+	}
+
+	for (uint32_t r = 0; r < runs; ++r)
+	{
+		double start{ Test::Time() };
+
+		queue.Clear();
+		for (size_t i = 0; i < drawables.size(); ++i)
+			queue.Add(&drawables[i], depths[i]);
+
+		double added{ Test::Time() };
+		queue.Build();
+		double built{ Test::Time() };
+
+		addTime += added - start;
+		buildTime += built - added;
+
+		copy = items;
+		start = Test::Time();
+		RenderQueue::RadixSort(copy.data(), scratch.data(), copy.size());
+		radixTime += Test::Time() - start;
+
+		copy = items;
+		start = Test::Time();
+		sort(copy.begin(), copy.end(), [](const RenderQueueItem &a, const RenderQueueItem &b) { return a.key < b.key; });
+		stdTime += Test::Time() - start;
+	}
+
+	uint32_t stateChanges{ 0 };
+	for (size_t i = 1; i < queue.GetCount(); ++i)
+	{
+		const Drawable *a{ queue.GetDrawable(i - 1) }, *b{ queue.GetDrawable(i) };
+		if (a->pipeline != b->pipeline || a->material != b->material || a->mesh != b->mesh)
+			++stateChanges;
+	}
+
+	printf("RenderQueue: %u drawables, add %.2f ms, build %.2f ms, radix sort %.2f ms, std::sort %.2f ms, %u state changes\n",
+		RQT_BENCH_DRAWABLES, addTime / runs, buildTime / runs, radixTime / runs, stdTime / runs, stateChanges);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_rqt_TestRadixSort();
+	_rqt_TestHashIdentity();
+	_rqt_TestKeys();
+	_rqt_TestOrdering();
+	_rqt_TestBatches();
+
+	if (Test::Benchmark())
+		_rqt_Benchmark();
+
+	return Test::Result();
+}
@@ -0,0 +1,209 @@
+/* NekoEngine
+ *
+ * ScriptSchedulerTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Script scheduler tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+
+#include <Engine/Engine.h>
+#include <Script/ScriptScheduler.h>
+
+#include "Test.h"
+#include "ScriptTest.h"
+
+#define SST_BUDGET			1000000
+#define SST_NESTED_LIMIT	100000
+#define SST_DT				.1
+
+static TestScriptComponent *_sst_inner{ nullptr };
+static uint32_t _sst_nestedCalls{ 0 };
+
+// Calls into another script from a running one, like the component interfaces do
+static int _sst_Invoke(lua_State *state)
+{
+	if (++_sst_nestedCalls > SST_NESTED_LIMIT)
+		return luaL_error(state, "outer call was not stopped");
+
+	_sst_inner->Invoke("Work");
+	return 0;
+}
+
+static void _sst_Frame(TestScriptComponent *comp)
+{
+	comp->Update(SST_DT);
+	ScriptScheduler::Update(SST_DT);
+}
+
+static void _sst_TestCoroutines()
+{
+	TestWriteFile("/co.lua",
+		"log = ''\n"
+		"frame = 0\n"
+		"function Load()\n"
+		"	StartCoroutine(function(a)\n"
+		"		log = log .. 'start' .. a .. ';' Yield()\n"
+		"		log = log .. 'f' .. frame .. ';' Wait(0.5)\n"
+		"		log = log .. 'w' .. frame .. ';' WaitFrames(3)\n"
+		"		log = log .. 'wf' .. frame .. ';' coroutine.yield()\n"
+		"		log = log .. 'y' .. frame .. ';'\n"
+		"	end, 7)\n"
+		"	forever = StartCoroutine(function() while true do ticks = (ticks or 0) + 1 Yield() end end)\n"
+		"	return 0\n"
+		"end\n"
+		"function Update(dt) frame = frame + 1 if frame == 12 then StopCoroutine(forever) end end\n"
+		"function BadWait() Wait(1) end\n");
+
+	TestScriptComponent *comp{ TestNewScript("/co.lua") };
+	TEST_CHECK(comp != nullptr);
+	if (!comp)
+		return;
+
+	TEST_CHECK(ScriptScheduler::GetCoroutineCount() == 2);
+
+	for (int i = 0; i < 15; ++i)
+		_sst_Frame(comp);
+
+	lua_State *state{ Script::GetState() };
+	lua_rawgeti(state, LUA_REGISTRYINDEX, comp->GetInstance());
+	lua_getfield(state, -1, "log");
+	const char *log{ lua_tostring(state, -1) };
+	// Coroutines resume after the components update, which count the frames
+	// from 1: Yield() in Load waits for the second frame, Wait(0.5) five more
+	TEST_CHECK(log && !strcmp(log, "start7;f2;w7;wf10;y11;"));
+	lua_pop(state, 2);
+
+	// Started in Load, resumed in frames 2 to 11 and stopped in frame 12
+	TEST_CHECK(TestGetNumber(comp, "ticks") == 11.0);
+	TEST_CHECK(ScriptScheduler::GetCoroutineCount() == 0);
+
+	// Waiting outside a coroutine is an error
+	const uint32_t errors{ Test::GetLogCount(LOG_CRITICAL) };
+	TEST_CHECK(!comp->Invoke("BadWait"));
+	TEST_CHECK(Test::GetLogCount(LOG_CRITICAL) == errors + 1);
+
+	// Coroutines are cancelled with their component
+	TestWriteFile("/owner.lua", "function Load() StartCoroutine(function() while true do Yield() end end) return 0 end");
+	TestScriptComponent *owner{ TestNewScript("/owner.lua") };
+	TEST_CHECK(ScriptScheduler::GetCoroutineCount() == 1);
+	delete owner;
+	TEST_CHECK(ScriptScheduler::GetCoroutineCount() == 0);
+
+	delete comp;
+	TEST_CHECK(lua_gettop(state) == 0);
+}
+
+static void _sst_TestBudget()
+{
+	TestWriteFile("/spin.lua", "function Load() return 0 end function Update(dt) while true do end end");
+	TestWriteFile("/ok.lua", "count = 0 function Load() return 0 end function Update(dt) count = count + 1 end");
+
+	TestScriptComponent *spin{ TestNewScript("/spin.lua") };
+	TestScriptComponent *ok{ TestNewScript("/ok.lua") };
+	TEST_CHECK(spin && ok);
+	if (!spin || !ok)
+		return;
+
+	const uint32_t errors{ Test::GetLogCount(LOG_CRITICAL) };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		spin->Update(SST_DT);
+		ok->Update(SST_DT);
+		ScriptScheduler::Update(SST_DT);
+	}
+
+	// Aborted once and disabled; the other script keeps running
+	TEST_CHECK(!spin->IsEnabled());
+	TEST_CHECK(ok->IsEnabled() && TestGetNumber(ok, "count") == 3.0);
+	TEST_CHECK(Test::GetLogCount(LOG_CRITICAL) > errors);
+
+	const ScriptStats *stats{ ScriptScheduler::GetFrameStats("/spin.lua") };
+	TEST_CHECK(stats != nullptr);
+
+	delete spin;
+	delete ok;
+	TEST_CHECK(lua_gettop(Script::GetState()) == 0);
+}
+
+static void _sst_TestNestedBudget()
+{
+	// Most of the outer call's instructions run in nested calls, which used
+	// to start counting from zero and discard their count on return
+	TestWriteFile("/inner.lua", "function Load() return 0 end function Work() local s = 0 for i = 1, 500 do s = s + i end end");
+	TestWriteFile("/outer.lua", "function Load() return 0 end function Update(dt) while true do TestInvoke() end end");
+
+	lua_register(Script::GetState(), "TestInvoke", _sst_Invoke);
+
+	_sst_inner = TestNewScript("/inner.lua");
+	TestScriptComponent *outer{ TestNewScript("/outer.lua") };
+	TEST_CHECK(_sst_inner && outer);
+	if (!_sst_inner || !outer)
+		return;
+
+	_sst_nestedCalls = 0;
+	outer->Update(SST_DT);
+
+	TEST_CHECK(!outer->IsEnabled());
+	TEST_CHECK(_sst_nestedCalls < SST_NESTED_LIMIT);
+
+	// One nested call is far below the budget
+	_sst_nestedCalls = 0;
+	TEST_CHECK(_sst_inner->Invoke("Work"));
+
+	delete outer;
+	delete _sst_inner;
+	_sst_inner = nullptr;
+	TEST_CHECK(lua_gettop(Script::GetState()) == 0);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	// The budgets are applied when the VM is created
+	EngineConfig &config{ Engine::GetConfiguration().Engine };
+	config.ScriptGCBudget = 1.f;
+	config.ScriptInstructionBudget = SST_BUDGET;
+
+	_sst_TestCoroutines();
+	_sst_TestBudget();
+	_sst_TestNestedBudget();
+
+	Script::Release();
+
+	return Test::Result();
+}
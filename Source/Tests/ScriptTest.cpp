@@ -0,0 +1,267 @@
+/* NekoEngine
+ *
+ * ScriptTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Script VM and bytecode cache tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include <Engine/Engine.h>
+#include <Script/ScriptScheduler.h>
+
+#include "Test.h"
+#include "ScriptTest.h"
+
+#define SCT_BYTECODE_HEADER		"NLUABC1"
+#define SCT_BENCH_COMPONENTS	10000
+#define SCT_BENCH_FRAMES		100
+
+using namespace std;
+
+static const char *_sct_counter =
+	"local step = 2\n"
+	"count = 0\n"
+	"function Load() count = 1 return 0 end\n"
+	"function Update(dt) count = count + step end";
+
+static int _sct_Writer(lua_State *state, const void *p, size_t size, void *ud)
+{
+	vector<char> *out{ (vector<char> *)ud };
+	out->insert(out->end(), (const char *)p, (const char *)p + size);
+	return 0;
+}
+
+static uint64_t _sct_Fnv(const char *data, size_t size)
+{
+	uint64_t hash{ 14695981039346656037ull };
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= (uint8_t)data[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+// Cache file in the engine's layout holding the bytecode of src
+static void _sct_WriteCache(const char *path, uint64_t hash, const char *src)
+{
+	lua_State *state{ luaL_newstate() };
+	vector<char> bytecode, file;
+
+	luaL_loadstring(state, src);
+	lua_dump(state, _sct_Writer, &bytecode);
+	lua_close(state);
+
+	const uint32_t size{ (uint32_t)bytecode.size() };
+	file.insert(file.end(), SCT_BYTECODE_HEADER, SCT_BYTECODE_HEADER + 7);
+	file.insert(file.end(), (const char *)&hash, (const char *)&hash + sizeof(hash));
+	file.insert(file.end(), (const char *)&size, (const char *)&size + sizeof(size));
+	file.insert(file.end(), bytecode.begin(), bytecode.end());
+
+	TestWriteFile(path, file.data(), file.size());
+}
+
+static void _sct_TestInstances()
+{
+	TestWriteFile("/Scripts/counter.lua", _sct_counter);
+
+	TestScriptComponent *a{ TestNewScript("/Scripts/counter.lua") };
+	TestScriptComponent *b{ TestNewScript("/Scripts/counter.lua") };
+	TEST_CHECK(a && b);
+	if (!a || !b)
+		return;
+
+	for (int i = 0; i < 3; ++i)
+		a->Update(.016);
+	b->Update(.016);
+
+	// Instances share the chunk but not their globals
+	TEST_CHECK(TestGetNumber(a, "count") == 7.0);
+	TEST_CHECK(TestGetNumber(b, "count") == 3.0);
+
+	lua_State *state{ Script::GetState() };
+	lua_getglobal(state, "count");
+	TEST_CHECK(lua_isnil(state, -1));
+	lua_pop(state, 1);
+	TEST_CHECK(lua_gettop(state) == 0);
+
+	delete a;
+	delete b;
+}
+
+static void _sct_TestCache()
+{
+	Engine::GetConfiguration().Engine.LoadLooseFiles = true;
+
+	TestWriteFile("/Scripts/cached.lua", _sct_counter);
+	TestDeleteFile("/Scripts/cached.luac");
+
+	TestScriptComponent *comp{ TestNewScript("/Scripts/cached.lua") };
+	TEST_CHECK(comp && TestReadFile("/Scripts/cached.luac"));
+	delete comp;
+
+	// After a restart the cache is used as long as the source matches; the
+	// bytecode is replaced to see which one ran
+	const vector<char> cache{ *TestReadFile("/Scripts/cached.luac") };
+	uint64_t hash{ 0 };
+	memcpy(&hash, cache.data() + 7, sizeof(hash));
+
+	Script::Release();
+	_sct_WriteCache("/Scripts/cached.luac", hash, "count = 99 function Load() return 0 end");
+
+	comp = TestNewScript("/Scripts/cached.lua");
+	TEST_CHECK(comp && TestGetNumber(comp, "count") == 99.0);
+	delete comp;
+
+	// An edited source is compiled again
+	Script::Release();
+	TestWriteFile("/Scripts/cached.lua", "count = 42 function Load() return 0 end");
+
+	comp = TestNewScript("/Scripts/cached.lua");
+	TEST_CHECK(comp && TestGetNumber(comp, "count") == 42.0);
+	delete comp;
+
+	// Bytecode keyed on the source alone may come from another LuaJIT build
+	// or another prefix and is not used
+	Script::Release();
+	const char *src{ "count = 5 function Load() return 0 end" };
+	TestWriteFile("/Scripts/cached.lua", src);
+	_sct_WriteCache("/Scripts/cached.luac", _sct_Fnv(src, strlen(src)), "count = 6 function Load() return 0 end");
+
+	comp = TestNewScript("/Scripts/cached.lua");
+	TEST_CHECK(comp && TestGetNumber(comp, "count") == 5.0);
+	delete comp;
+
+	// The terminator ReadAll adds is not part of the source
+	src = "count = 8 function Load() return 0 end";
+	const vector<char> *file{ nullptr };
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		Script::Release();
+		TestWriteFile("/Scripts/cached.lua", src);
+		if (!pass)
+			TestDeleteFile("/Scripts/cached.luac");
+
+		comp = TestNewScript("/Scripts/cached.lua");
+		TEST_CHECK(comp && TestGetNumber(comp, "count") == 8.0);
+		delete comp;
+
+		file = TestReadFile("/Scripts/cached.luac");
+		TEST_CHECK(file != nullptr);
+	}
+
+	Engine::GetConfiguration().Engine.LoadLooseFiles = false;
+	Script::Release();
+}
+
+static void _sct_TestSources()
+{
+	// Sources without a file are named by their content, so a buffer that is
+	// reused for another script gets that script
+	char buffer[64]{};
+
+	strcpy(buffer, "value = 1 function Load() return 0 end");
+	TestScriptComponent *a{ TestNewSourceScript(buffer) };
+
+	strcpy(buffer, "value = 2 function Load() return 0 end");
+	TestScriptComponent *b{ TestNewSourceScript(buffer) };
+
+	TEST_CHECK(a && TestGetNumber(a, "value") == 1.0);
+	TEST_CHECK(b && TestGetNumber(b, "value") == 2.0);
+
+	// The same source at another address shares the chunk
+	const char *copy{ "value = 1 function Load() return 0 end" };
+	TestScriptComponent *c{ TestNewSourceScript(copy) };
+	TEST_CHECK(c && TestGetNumber(c, "value") == 1.0);
+
+	delete a;
+	delete b;
+	delete c;
+}
+
+static void _sct_Benchmark()
+{
+	TestWriteFile("/Scripts/bench.lua",
+		"local speed = 2\n"
+		"count = 0\n"
+		"function Load() count = 0 return 0 end\n"
+		"function Update(dt) count = count + 1 total = (total or 0) + math.sin(count * dt) * speed end\n");
+
+	vector<TestScriptComponent *> components;
+	components.reserve(SCT_BENCH_COMPONENTS);
+
+	double start{ Test::Time() };
+	for (uint32_t i = 0; i < SCT_BENCH_COMPONENTS; ++i)
+		components.push_back(TestNewScript("/Scripts/bench.lua"));
+	const double create{ Test::Time() - start };
+
+	start = Test::Time();
+	for (uint32_t f = 0; f < SCT_BENCH_FRAMES; ++f)
+		for (TestScriptComponent *comp : components)
+			comp->Update(.016);
+	const double update{ (Test::Time() - start) * 1000.0 / (SCT_BENCH_FRAMES * SCT_BENCH_COMPONENTS) };
+
+	lua_State *state{ Script::GetState() };
+	lua_gc(state, LUA_GCCOLLECT, 0);
+
+	printf("%u components: %.1f ms to create, %.2f us per update, %d KB Lua heap\n",
+		SCT_BENCH_COMPONENTS, create, update, lua_gc(state, LUA_GCCOUNT, 0));
+
+	for (TestScriptComponent *comp : components)
+		delete comp;
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_sct_TestInstances();
+	_sct_TestCache();
+	_sct_TestSources();
+
+	if (Test::Benchmark())
+		_sct_Benchmark();
+
+	Script::Release();
+
+	TEST_CHECK(Test::GetLogCount(LOG_CRITICAL) == 0);
+
+	return Test::Result();
+}
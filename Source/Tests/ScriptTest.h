@@ -0,0 +1,85 @@
+/* NekoEngine
+ *
+ * ScriptTest.h
+ * Author: Alexandru Naiman
+ *
+ * Script test helpers
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <Script/Script.h>
+#include <Scene/Components/ScriptComponent.h>
+
+/**
+ * Script component with access to its VM state; ScriptTestStubs.cpp
+ * replaces the VFS with files held in memory and stubs the interfaces
+ * that need the rest of the engine.
+ */
+class TestScriptComponent : public ScriptComponent
+{
+public:
+	TestScriptComponent(ComponentInitializer *initializer) : ScriptComponent(initializer) { }
+
+	int GetInstance() const noexcept { return _instance; }
+	bool IsEnabled() const noexcept { return _enabled; }
+};
+
+/**
+ * Create a file in the in-memory VFS, replacing an existing one
+ */
+void TestWriteFile(const char *path, const char *data, size_t size);
+void TestWriteFile(const char *path, const char *src);
+
+/**
+ * Contents of a file in the in-memory VFS, nullptr if it does not exist
+ */
+const std::vector<char> *TestReadFile(const char *path);
+
+void TestDeleteFile(const char *path);
+
+/**
+ * Create and load a component running a script file, nullptr if Load fails
+ */
+TestScriptComponent *TestNewScript(const char *file);
+
+/**
+ * Create and load a component running the source at src
+ */
+TestScriptComponent *TestNewSourceScript(const char *src);
+
+/**
+ * Number field of the component's instance table, NAN if not a number
+ */
+double TestGetNumber(TestScriptComponent *comp, const char *name);
@@ -0,0 +1,247 @@
+/* NekoEngine
+ *
+ * ScriptTestStubs.cpp
+ * Author: Alexandru Naiman
+ *
+ * Script test stubs
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <System/VFS/VFS.h>
+#include <Scene/Components/CameraComponent.h>
+#include <Script/Interface/VFSInterface.h>
+#include <Script/Interface/GUIInterface.h>
+#include <Script/Interface/InputInterface.h>
+#include <Script/Interface/DebugInterface.h>
+#include <Script/Interface/SceneInterface.h>
+#include <Script/Interface/ObjectInterface.h>
+#include <Script/Interface/EngineInterface.h>
+#include <Script/Interface/LoggerInterface.h>
+#include <Script/Interface/CameraInterface.h>
+#include <Script/Interface/SystemInterface.h>
+#include <Script/Interface/ConsoleInterface.h>
+#include <Script/Interface/PlatformInterface.h>
+#include <Script/Interface/MaterialInterface.h>
+#include <Script/Interface/AudioSourceInterface.h>
+#include <Script/Interface/EventManagerInterface.h>
+#include <Script/Interface/SoundManagerInterface.h>
+#include <Script/Interface/AnimationClipInterface.h>
+#include <Script/Interface/CameraManagerInterface.h>
+#include <Script/Interface/LightComponentInterface.h>
+#include <Script/Interface/ObjectComponentInterface.h>
+#include <Script/Interface/ResourceManagerInterface.h>
+#include <Script/Interface/CameraComponentInterface.h>
+#include <Script/Interface/ScriptComponentInterface.h>
+#include <Script/Interface/AnimatorComponentInterface.h>
+#include <Script/Interface/StaticMeshComponentInterface.h>
+#include <Script/Interface/AudioSourceComponentInterface.h>
+#include <Script/Interface/SkeletalMeshComponentInterface.h>
+
+#include "ScriptTest.h"
+
+using namespace std;
+
+static map<string, vector<char>> _st_files;
+
+/**
+ * File of the in-memory VFS. Reads work on a copy; writes replace the
+ * file when it is closed.
+ */
+class TestScriptFile : public VFSFile
+{
+public:
+	TestScriptFile(const char *path, bool write) : VFSFile(FileType::Loose), _path{ path }, _pos{ 0 }, _write{ write }
+	{
+		if (!write)
+			_data = _st_files[path];
+	}
+
+	virtual bool IsOpen() override { return true; }
+	virtual bool IsReadonly() override { return !_write; }
+	virtual int Open() override { _pos = 0; return ENGINE_OK; }
+	virtual int Create() override { _data.clear(); _pos = 0; return ENGINE_OK; }
+
+	virtual size_t Read(void *buffer, size_t size, size_t count) override
+	{
+		const size_t n{ std::min(count, (_data.size() - _pos) / size) };
+		memcpy(buffer, _data.data() + _pos, n * size);
+		_pos += n * size;
+		return n;
+	}
+
+	virtual char *Gets(char *str, int num) override { return nullptr; }
+
+	virtual size_t Write(void *buffer, size_t size, size_t count) override
+	{
+		_data.insert(_data.begin() + _pos, (char *)buffer, (char *)buffer + size * count);
+		_pos += size * count;
+		return count;
+	}
+
+	virtual int Seek(size_t offset, int origin) override
+	{
+		_pos = origin == SEEK_END ? _data.size() + offset : (origin == SEEK_CUR ? _pos + offset : offset);
+		return ENGINE_OK;
+	}
+
+	virtual size_t Tell() override { return _pos; }
+	virtual bool EoF() override { return _pos >= _data.size(); }
+
+	// The engine does not delete files it opened for reading
+	virtual void Close() override
+	{
+		if (_write)
+			_st_files[_path] = _data;
+	}
+
+private:
+	string _path;
+	vector<char> _data;
+	size_t _pos;
+	bool _write;
+};
+
+VFSFile *VFS::Open(NString &path)
+{
+	return _st_files.find(*path) == _st_files.end() ? nullptr : new TestScriptFile(*path, false);
+}
+
+VFSFile *VFS::Create(NString &path, bool compress)
+{
+	return new TestScriptFile(*path, true);
+}
+
+bool VFS::Exists(NString &path)
+{
+	return _st_files.find(*path) != _st_files.end();
+}
+
+void TestWriteFile(const char *path, const char *data, size_t size)
+{
+	_st_files[path] = vector<char>(data, data + size);
+}
+
+void TestWriteFile(const char *path, const char *src)
+{
+	TestWriteFile(path, src, strlen(src));
+}
+
+const vector<char> *TestReadFile(const char *path)
+{
+	auto it = _st_files.find(path);
+	return it == _st_files.end() ? nullptr : &it->second;
+}
+
+void TestDeleteFile(const char *path)
+{
+	_st_files.erase(path);
+}
+
+static TestScriptComponent *_st_NewScript(const char *key, const char *value)
+{
+	ComponentInitializer initializer{};
+	initializer.arguments.insert({ key, value });
+
+	TestScriptComponent *comp{ new TestScriptComponent(&initializer) };
+	if (comp->Load() != ENGINE_OK)
+	{
+		delete comp;
+		return nullptr;
+	}
+
+	return comp;
+}
+
+TestScriptComponent *TestNewScript(const char *file)
+{
+	return _st_NewScript("script", file);
+}
+
+TestScriptComponent *TestNewSourceScript(const char *src)
+{
+	return _st_NewScript("scriptptr", to_string((uintptr_t)src).c_str());
+}
+
+double TestGetNumber(TestScriptComponent *comp, const char *name)
+{
+	lua_State *state{ Script::GetState() };
+
+	lua_rawgeti(state, LUA_REGISTRYINDEX, comp->GetInstance());
+	lua_getfield(state, -1, name);
+	const double value{ lua_isnumber(state, -1) ? lua_tonumber(state, -1) : NAN };
+	lua_pop(state, 2);
+
+	return value;
+}
+
+// Tests link the script VM, the vector and math interfaces and the scheduler;
+// the other interfaces need the rest of the engine.
+void AnimationClipInterface::Register(lua_State *state) { }
+void AnimatorComponentInterface::Register(lua_State *state) { }
+void AudioSourceComponentInterface::Register(lua_State *state) { }
+void AudioSourceInterface::Register(lua_State *state) { }
+void CameraComponentInterface::Register(lua_State *state) { }
+void CameraInterface::Register(lua_State *state) { }
+void CameraManagerInterface::Register(lua_State *state) { }
+void ConsoleInterface::Register(lua_State *state) { }
+void DebugInterface::Register(lua_State *state) { }
+void EngineInterface::Register(lua_State *state) { }
+void EventManagerInterface::Register(lua_State *state) { }
+void GUIInterface::Register(lua_State *state) { }
+void InputInterface::Register(lua_State *state) { }
+void LightComponentInterface::Register(lua_State *state) { }
+void LoggerInterface::Register(lua_State *state) { }
+void MaterialInterface::Register(lua_State *state) { }
+void ObjectComponentInterface::Register(lua_State *state) { }
+void ObjectInterface::Register(lua_State *state) { }
+void PlatformInterface::Register(lua_State *state) { }
+void ResourceManagerInterface::Register(lua_State *state) { }
+void SceneInterface::Register(lua_State *state) { }
+void ScriptComponentInterface::Register(lua_State *state) { }
+void SkeletalMeshComponentInterface::Register(lua_State *state) { }
+void SoundManagerInterface::Register(lua_State *state) { }
+void StaticMeshComponentInterface::Register(lua_State *state) { }
+void SystemInterface::Register(lua_State *state) { }
+void VFSInterface::Register(lua_State *state) { }
+
+FixedTimestep Engine::_fixedTimestep{};
+ComponentClassMapType *EngineClassFactory::_componentClassMap{ nullptr };
+
+int CameraComponent::Load() { return ENGINE_OK; }
+void CameraComponent::_UpdateView() noexcept { }
@@ -0,0 +1,331 @@
+/* NekoEngine
+ *
+ * ShadowCacheTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Shadow caster cache tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <bitset>
+#include <vector>
+#include <algorithm>
+
+#include <Engine/Defs.h>
+#include <Renderer/ShadowCache.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Test.h"
+
+// A point light at the origin with casters on a grid around it
+#define SCT_FACES			6
+#define SCT_GRID			15
+#define SCT_SPACING			4.f
+#define SCT_RADIUS			.5f
+
+using namespace std;
+using namespace glm;
+
+typedef struct SCT_CASTER
+{
+	mat4 model;
+	bool present, animated, noCull;
+} SctCaster;
+
+class ShadowCacheTest
+{
+public:
+	ShadowCacheTest() :
+		renders{ 0 },
+		_casters(SCT_GRID * SCT_GRID * SCT_GRID),
+		_objects(_casters.size()),
+		_lightOffset{ 0.f }
+	{
+		for (uint32_t i = 0; i < _casters.size(); ++i)
+		{
+			const vec3 p{ (float)(i % SCT_GRID), (float)((i / SCT_GRID) % SCT_GRID), (float)(i / (SCT_GRID * SCT_GRID)) };
+			_casters[i] = { translate(mat4(1.f), (p - vec3(SCT_GRID / 2)) * SCT_SPACING), true, false, false };
+		}
+
+		// The light sits inside the grid, not on a caster
+		_casters[_Index(SCT_GRID / 2, SCT_GRID / 2, SCT_GRID / 2)].present = false;
+	}
+
+	SctCaster &Caster(uint32_t x, uint32_t y, uint32_t z) { return _casters[_Index(x, y, z)]; }
+	const Object *Address(uint32_t x, uint32_t y, uint32_t z) const { return At(_Index(x, y, z)); }
+	const Object *At(size_t i) const { return (const Object *)&_objects[i]; }
+	ShadowCache &Cache() { return _cache; }
+
+	void MoveLight(float offset) { _lightOffset = offset; }
+
+	/** Run one frame the way Scene and ShadowRenderer do; returns false if a face's casters are wrong */
+	bool Frame()
+	{
+		_cache.BeginFrame();
+
+		for (size_t i = 0; i < _casters.size(); ++i)
+			if (_casters[i].present)
+				_cache.UpdateCaster(At(i), _casters[i].model, _Bounds(i), _casters[i].animated, _casters[i].noCull);
+
+		_cache.EndCasterUpdate();
+
+		bool correct{ true };
+		renders = 0;
+
+		for (uint32_t f = 0; f < SCT_FACES; ++f)
+		{
+			mat4 vp{ _FaceMatrix(f) };
+
+			if (_cache.UpdateFace(f, vp, [this](const NFrustum &frustum, NArray<const Object *> &casters) {
+				for (size_t i = 0; i < _casters.size(); ++i)
+					if (_casters[i].present && !_casters[i].noCull && frustum.ContainsBounds(_Bounds(i)))
+						casters.Add(At(i));
+			}))
+				renders |= 1 << f;
+
+			// Brute force: every present caster inside the frustum, sorted by address
+			NFrustum frustum;
+			frustum.FromViewProjection(vp);
+
+			vector<const Object *> expected;
+			for (size_t i = 0; i < _casters.size(); ++i)
+				if (_casters[i].present && (_casters[i].noCull || frustum.ContainsBounds(_Bounds(i))))
+					expected.push_back(At(i));
+			sort(expected.begin(), expected.end());
+
+			correct &= expected == _cache.GetFaceCasters(f);
+		}
+
+		return correct;
+	}
+
+	void Settle()
+	{
+		for (uint32_t i = 0; i <= SHADOW_CACHE_SETTLE_FRAMES; ++i)
+			Frame();
+	}
+
+	uint32_t renders;
+
+private:
+	vector<SctCaster> _casters;
+	vector<char> _objects;
+	ShadowCache _cache;
+	float _lightOffset;
+
+	static uint32_t _Index(uint32_t x, uint32_t y, uint32_t z) { return (z * SCT_GRID + y) * SCT_GRID + x; }
+
+	NBounds _Bounds(size_t i) const
+	{
+		NBounds b;
+		b.InitSphere(vec3(_casters[i].model[3]), SCT_RADIUS);
+		return b;
+	}
+
+	mat4 _FaceMatrix(uint32_t face) const
+	{
+		static const vec3 dirs[SCT_FACES]{ { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+		static const vec3 ups[SCT_FACES]{ { 0, -1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, -1, 0 }, { 0, -1, 0 } };
+		const vec3 eye{ _lightOffset, 0.f, 0.f };
+
+		return perspective(radians(90.f), 1.f, .1f, SCT_GRID * SCT_SPACING) * lookAt(eye, eye + dirs[face], ups[face]);
+	}
+};
+
+static void _sct_TestSteady()
+{
+	ShadowCacheTest t;
+
+	// Everything is new: all faces render
+	TEST_CHECK(t.Frame());
+	TEST_CHECK(t.renders == 0x3F);
+	TEST_CHECK(t.Cache().IsDynamic(t.Address(0, 0, 0)));
+
+	t.Settle();
+	TEST_CHECK(!t.Cache().IsDynamic(t.Address(0, 0, 0)));
+
+	TEST_CHECK(t.Frame());
+	TEST_CHECK(t.renders == 0);
+	TEST_CHECK(t.Cache().GetStats().queries == 0);
+	TEST_CHECK(t.Cache().GetStats().facesCached == SCT_FACES);
+	TEST_CHECK(t.Cache().GetStats().dynamicCasters == 0);
+}
+
+static void _sct_TestMovement()
+{
+	ShadowCacheTest t;
+	t.Settle();
+
+	// A caster far along +X moves inside the +X face only
+	SctCaster &c{ t.Caster(SCT_GRID - 1, SCT_GRID / 2, SCT_GRID / 2) };
+	c.model = translate(c.model, vec3(0.f, .1f, 0.f));
+
+	TEST_CHECK(t.Frame());
+	TEST_CHECK(t.renders == 0x1);
+	TEST_CHECK(t.Cache().IsDynamic(t.Address(SCT_GRID - 1, SCT_GRID / 2, SCT_GRID / 2)));
+
+	// Still dynamic but not moving: nothing to render
+	TEST_CHECK(t.Frame());
+	TEST_CHECK(t.renders == 0);
+
+	// Once it settles it goes back to the static list without a render
+	t.Settle();
+	TEST_CHECK(!t.Cache().IsDynamic(t.Address(SCT_GRID - 1, SCT_GRID / 2, SCT_GRID / 2)));
+	TEST_CHECK(t.Frame());
+	TEST_CHECK(t.renders == 0);
+
+	// Animated casters render their faces every frame
+	t.Caster(SCT_GRID / 2, SCT_GRID / 2, 0).animated = true;
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		TEST_CHECK(t.Frame());
+		TEST_CHECK(t.renders == 0x20);
+	}
+	t.Caster(SCT_GRID / 2, SCT_GRID / 2, 0).animated = false;
+
+	// A caster that crosses into another face renders both
+	SctCaster &cross{ t.Caster(SCT_GRID - 1, SCT_GRID / 2, SCT_GRID - 1) };
+	cross.model = translate(mat4(1.f), vec3(-SCT_SPACING * 2.f, 0.f, (SCT_GRID / 2) * SCT_SPACING));
+	TEST_CHECK(t.Frame());
+	TEST_CHECK((t.renders & 0x11) == 0x11);
+}
+
+static void _sct_TestRemoval()
+{
+	ShadowCacheTest t;
+	t.Settle();
+
+	// A removed static caster renders its old face once
+	t.Caster(0, SCT_GRID / 2, SCT_GRID / 2).present = false;
+	TEST_CHECK(t.Frame());
+	TEST_CHECK(t.renders == 0x2);
+	TEST_CHECK(t.Frame());
+	TEST_CHECK(t.renders == 0);
+
+	// Invalidated faces render again
+	t.Cache().InvalidateFace(3);
+	TEST_CHECK(t.Frame());
+	TEST_CHECK(t.renders == 0x8);
+
+	// Moving the light renders every face
+	t.MoveLight(.5f);
+	TEST_CHECK(t.Frame());
+	TEST_CHECK(t.renders == 0x3F);
+	TEST_CHECK(t.Cache().GetStats().queries == SCT_FACES);
+}
+
+// Casters that cannot be culled are in every face and never settle
+static void _sct_TestNoCull()
+{
+	ShadowCacheTest t;
+	t.Caster(0, 0, 0).noCull = true;
+	t.Settle();
+
+	TEST_CHECK(t.Cache().IsDynamic(t.Address(0, 0, 0)));
+	TEST_CHECK(t.Frame());
+	TEST_CHECK(t.renders == 0);
+
+	bool everywhere{ true };
+	for (uint32_t f = 0; f < SCT_FACES; ++f)
+		everywhere &= binary_search(t.Cache().GetFaceCasters(f).begin(), t.Cache().GetFaceCasters(f).end(), t.Address(0, 0, 0));
+	TEST_CHECK(everywhere);
+}
+
+// What the renderer does when a scene is unloaded: the next scene's
+// objects may be allocated at the same addresses and must not inherit
+// the old records or the old maps
+static void _sct_TestClear()
+{
+	ShadowCacheTest t;
+	t.Settle();
+	TEST_CHECK(t.Cache().GetCasterCount() > 0);
+
+	t.Cache().Clear();
+	TEST_CHECK(t.Cache().GetCasterCount() == 0);
+	TEST_CHECK(t.Cache().IsDynamic(t.Address(0, 0, 0)));
+
+	TEST_CHECK(t.Frame());
+	TEST_CHECK(t.renders == 0x3F);
+	TEST_CHECK(t.Cache().IsDynamic(t.Address(0, 0, 0)));
+	TEST_CHECK(t.Cache().GetStats().dynamicCasters == t.Cache().GetCasterCount());
+
+	t.Settle();
+	TEST_CHECK(t.Frame());
+	TEST_CHECK(t.renders == 0);
+}
+
+// Every frame of a longer run must give each face exactly its casters
+static void _sct_TestTimeline()
+{
+	ShadowCacheTest t;
+	bool correct{ true };
+	uint32_t faceRenders{ 0 };
+
+	for (uint32_t frame = 0; frame < 200; ++frame)
+	{
+		uint32_t x{ (frame * 7) % SCT_GRID }, y{ (frame * 3) % SCT_GRID }, z{ (frame * 11) % SCT_GRID };
+
+		if (frame % 5 == 0)
+		{
+			SctCaster &c{ t.Caster(x, y, z) };
+			c.model = translate(c.model, vec3(.3f, -.2f, .1f));
+		}
+
+		if (frame % 17 == 0)
+			t.Caster(z, x, y).present = !t.Caster(z, x, y).present;
+
+		if (frame == 120)
+			t.MoveLight(1.f);
+
+		correct &= t.Frame();
+		faceRenders += (uint32_t)bitset<SCT_FACES>(t.renders).count();
+	}
+
+	TEST_CHECK(correct);
+	TEST_CHECK(faceRenders < 200 * SCT_FACES);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_sct_TestSteady();
+	_sct_TestMovement();
+	_sct_TestRemoval();
+	_sct_TestNoCull();
+	_sct_TestClear();
+	_sct_TestTimeline();
+
+	return Test::Result();
+}
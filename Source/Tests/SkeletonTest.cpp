@@ -0,0 +1,213 @@
+/* NekoEngine
+ *
+ * SkeletonTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Skeleton evaluation tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <memory>
+
+#include "AnimationTest.h"
+#include "Test.h"
+
+#define SKT_NODES			60
+#define SKT_DURATION		100.0
+#define SKT_TICKS			25.0
+#define SKT_TOLERANCE		1e-3f
+#define SKT_BENCH_COUNT		500
+#define SKT_BENCH_FRAMES	100
+
+using namespace std;
+using namespace glm;
+
+// The recursive double precision evaluation the flattened skeleton replaced
+static void _skt_Reference(const vector<TransformNode> &nodes, const vector<Bone> &bones, TestClip &clip, int16_t node, const dmat4 &parent, double ticks, vector<dmat4> &out)
+{
+	dmat4 local{ nodes[node].transform };
+
+	for (const AnimationNode &channel : clip.Channels())
+	{
+		if (nodes[node].name != *channel.name)
+			continue;
+
+		const size_t k{ glm::min((size_t)ticks, channel.positionKeys.size() - 2) };
+		const double f{ glm::clamp(ticks - channel.positionKeys[k].time, 0.0, 1.0) };
+
+		dvec3 t{ mix(channel.positionKeys[k].value, channel.positionKeys[k + 1].value, f) };
+		dquat r{ normalize(slerp(channel.rotationKeys[k].value, channel.rotationKeys[k + 1].value, f)) };
+		dvec3 s{ mix(channel.scalingKeys[k].value, channel.scalingKeys[k + 1].value, f) };
+
+		local = translate(dmat4(1.0), t) * mat4_cast(r) * scale(dmat4(1.0), s);
+	}
+
+	dmat4 global{ parent * local };
+	out[node] = global * bones[node].offset;
+
+	for (uint16_t child : nodes[node].childrenIds)
+		_skt_Reference(nodes, bones, clip, child, global, ticks, out);
+}
+
+static float _skt_MaxError(const Skeleton &skeleton, const vector<dmat4> &reference)
+{
+	const TrMat *bones{ TestGetBones(skeleton) };
+	float error{ 0.f };
+
+	for (size_t i = 0; i < reference.size(); ++i)
+		for (int j = 0; j < 16; ++j)
+			error = glm::max(error, fabsf(bones[i].m[j] - (float)reference[i][j / 4][j % 4]));
+
+	return error;
+}
+
+static bool _skt_Finite(const Skeleton &skeleton)
+{
+	const TrMat *bones{ TestGetBones(skeleton) };
+
+	for (uint16_t i = 0; i < skeleton.GetBoneCount(); ++i)
+		for (int j = 0; j < 16; ++j)
+			if (!isfinite(bones[i].m[j]))
+				return false;
+
+	return true;
+}
+
+static void _skt_TestReference()
+{
+	vector<Bone> bones;
+	vector<TransformNode> nodes;
+	TestBuildHierarchy(SKT_NODES, bones, nodes);
+
+	TestClip clip{ SKT_DURATION, SKT_TICKS };
+	TestBuildClip(clip, nodes, 1);
+
+	// Leave one node without a channel so it keeps its bind pose
+	clip.Channels().erase(clip.Channels().begin() + 7);
+
+	dmat4 globalInverse{ 1.0 };
+	Skeleton skeleton{ bones, nodes, globalInverse };
+	TEST_CHECK(skeleton.Load() == ENGINE_OK);
+	skeleton.SetAnimationClip(&clip);
+
+	vector<dmat4> reference(SKT_NODES);
+	float error{ 0.f };
+
+	// Forward, across the loop point and backwards
+	const double times[]{ 0.0, .33, 1.7, 3.9, 4.1, 2.2, .5 };
+	for (double t : times)
+	{
+		skeleton.TransformBones(t);
+		_skt_Reference(nodes, bones, clip, 0, dmat4(1.0), fmod(t * SKT_TICKS, SKT_DURATION), reference);
+		error = glm::max(error, _skt_MaxError(skeleton, reference));
+	}
+
+	TEST_CHECK(error < SKT_TOLERANCE);
+}
+
+static void _skt_TestDegenerateBindPose()
+{
+	vector<Bone> bones;
+	vector<TransformNode> nodes;
+	TestBuildHierarchy(16, bones, nodes);
+
+	// Collapsed axis on an inner node and a completely collapsed leaf
+	nodes[3].transform = scale(nodes[3].transform, dvec3(0.0, 1.0, 1.0));
+	nodes[12].transform = dmat4(0.0);
+
+	TestClip clip{ SKT_DURATION, SKT_TICKS };
+	TestBuildClip(clip, nodes, 2);
+	clip.Channels().erase(clip.Channels().begin() + 12);
+	clip.Channels().erase(clip.Channels().begin() + 3);
+
+	const uint32_t warnings{ Test::GetLogCount(LOG_WARNING) };
+
+	dmat4 globalInverse{ 1.0 };
+	Skeleton skeleton{ bones, nodes, globalInverse };
+	TEST_CHECK(skeleton.Load() == ENGINE_OK);
+	TEST_CHECK(Test::GetLogCount(LOG_WARNING) == warnings + 2);
+
+	const SkeletonPose &bind{ skeleton.GetBindPose() };
+	for (size_t i = 0; i < bind.Count(); ++i)
+	{
+		TEST_CHECK(!isnan(bind.rotations[i].x) && !isnan(bind.rotations[i].w));
+		TEST_CHECK(isfinite(bind.scales[i].x));
+	}
+
+	skeleton.SetAnimationClip(&clip);
+	skeleton.TransformBones(1.3);
+	TEST_CHECK(_skt_Finite(skeleton));
+}
+
+static void _skt_Benchmark()
+{
+	vector<Bone> bones;
+	vector<TransformNode> nodes;
+	TestBuildHierarchy(SKT_NODES, bones, nodes);
+
+	TestClip clip{ SKT_DURATION, SKT_TICKS };
+	TestBuildClip(clip, nodes, 3);
+
+	dmat4 globalInverse{ 1.0 };
+	vector<unique_ptr<Skeleton>> skeletons;
+
+	for (int i = 0; i < SKT_BENCH_COUNT; ++i)
+	{
+		skeletons.emplace_back(new Skeleton(bones, nodes, globalInverse));
+		skeletons.back()->Load();
+		skeletons.back()->SetAnimationClip(&clip);
+	}
+
+	double start{ Test::Time() };
+
+	for (int f = 0; f < SKT_BENCH_FRAMES; ++f)
+		for (size_t i = 0; i < skeletons.size(); ++i)
+			skeletons[i]->TransformBones(f / 60.0 + i * .01);
+
+	double ms{ (Test::Time() - start) / SKT_BENCH_FRAMES };
+	printf("%d skeletons of %d nodes: %.3f ms per frame, %.0f ns per node\n", SKT_BENCH_COUNT, SKT_NODES, ms, ms * 1e6 / (SKT_BENCH_COUNT * SKT_NODES));
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_skt_TestReference();
+	_skt_TestDegenerateBindPose();
+
+	if (Test::Benchmark())
+		_skt_Benchmark();
+
+	return Test::Result();
+}
@@ -0,0 +1,306 @@
+/* NekoEngine
+ *
+ * StagingRingTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Staging ring tests driven by a simulated fence timeline
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <map>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include <Renderer/StagingRing.h>
+
+#include "Test.h"
+
+// Same layout as the renderer's ring, see Renderer.h
+#define SRT_RING_SIZE		(32 * 1024 * 1024)
+#define SRT_FRAMES			2
+#define SRT_FRAME_DATA		(2 * 1024 * 1024)
+#define SRT_BUDGET			(SRT_RING_SIZE / SRT_FRAMES - SRT_FRAME_DATA)
+#define SRT_ALIGNMENT		256
+#define SRT_SEED			11
+#define SRT_TIMELINE_FRAMES	20000
+#define SRT_LARGE_UPLOAD	(40 * 1024 * 1024)
+
+using namespace std;
+
+typedef struct SRT_RANGE
+{
+	VkDeviceSize offset, size;
+} SrtRange;
+
+typedef struct SRT_UPLOAD
+{
+	uint32_t id;
+	VkDeviceSize offset, size;
+} SrtUpload;
+
+static void _srt_TestAllocate()
+{
+	StagingRing ring{ 4096, 2048 };
+	VkDeviceSize a, b, c;
+
+	ring.BeginFrame(1);
+
+	TEST_CHECK(ring.Allocate(100, 1, a) && a == 0);
+	TEST_CHECK(ring.Allocate(100, 256, b) && b == 256);
+	TEST_CHECK(ring.GetUsed() == 356 && ring.GetFrameUsed() == 356);
+	TEST_CHECK(!ring.Allocate(0, 1, c));
+
+	// Whatever GetAvailable reports must fit, and nothing more
+	VkDeviceSize available{ ring.GetAvailable(16) };
+	TEST_CHECK(available == 2048 - 356 - 12);
+	TEST_CHECK(!ring.Allocate(available + 1, 16, c));
+	TEST_CHECK(ring.Allocate(available, 16, c) && c == 368);
+	TEST_CHECK(ring.GetFrameUsed() == 2048 && ring.GetAvailable(1) == 0);
+	TEST_CHECK(!ring.Allocate(1, 1, c));
+
+	// Frame data is not budgeted, only limited by the free space
+	TEST_CHECK(ring.Allocate(1024, 1, c, false) && c == 2048);
+	TEST_CHECK(ring.GetFrameUsed() == 2048 && ring.GetUsed() == 3072);
+
+	// Only the most recent allocation can be returned early
+	TEST_CHECK(!ring.Release(a, 100));
+	TEST_CHECK(ring.Release(c, 1024));
+	TEST_CHECK(!ring.Release(c, 1024));
+	TEST_CHECK(ring.GetUsed() == 2048);
+
+	ring.BeginFrame(2);
+	TEST_CHECK(ring.GetFrameUsed() == 0);
+	TEST_CHECK(ring.Allocate(2048, 1, c) && c == 2048);
+	TEST_CHECK(ring.GetUsed() == 4096);
+
+	// Full until the first frame is reclaimed; the next allocation wraps to the start
+	ring.BeginFrame(3);
+	TEST_CHECK(!ring.Allocate(16, 1, c, false));
+	ring.Reclaim(1);
+	TEST_CHECK(ring.GetUsed() == 2048);
+	TEST_CHECK(ring.Allocate(512, 1, c) && c == 0);
+
+	ring.Reclaim(3);
+	TEST_CHECK(ring.GetUsed() == 0);
+
+	// With nothing in flight the ring starts over instead of wrapping
+	ring.BeginFrame(4);
+	TEST_CHECK(ring.Allocate(2048, 1, c) && c == 0);
+}
+
+/**
+ * Load staging: every copy completes before it is freed, so the space is
+ * returned by count instead of by fence, in any order.
+ */
+static void _srt_TestLoads()
+{
+	StagingRing ring{ 1 << 20, 1 << 20 };
+	VkDeviceSize a, b;
+	uint32_t count{ 0 };
+
+	TEST_CHECK(ring.Allocate(300000, SRT_ALIGNMENT, a));
+	++count;
+	TEST_CHECK(ring.Allocate(300000, SRT_ALIGNMENT, b));
+	++count;
+
+	// Freed out of order: the first release is refused, the last one empties the area
+	TEST_CHECK(!ring.Release(a, 300000));
+	--count;
+	TEST_CHECK(ring.GetUsed() > 600000);
+
+	if (!--count)
+		ring.Reclaim(ring.GetFrame());
+
+	TEST_CHECK(ring.GetUsed() == 0);
+	TEST_CHECK(ring.Allocate(1 << 20, SRT_ALIGNMENT, a) && a == 0);
+}
+
+static bool _srt_Overlaps(const map<uint64_t, vector<SrtRange>> &live, VkDeviceSize offset, VkDeviceSize size)
+{
+	for (auto &frame : live)
+		for (const SrtRange &range : frame.second)
+			if (offset < range.offset + range.size && range.offset < offset + size)
+				return true;
+
+	return false;
+}
+
+/**
+ * The renderer's update loop against a GPU that finishes each frame some time
+ * after it is submitted. Frame n waits for the fence of frame n - SRT_FRAMES
+ * before reclaiming; the staging space written by any frame the GPU has not
+ * finished must never be handed out again.
+ */
+static void _srt_TestTimeline()
+{
+	mt19937 rng{ SRT_SEED };
+	StagingRing ring{ SRT_RING_SIZE, SRT_BUDGET };
+
+	map<uint64_t, vector<SrtRange>> live{};
+	deque<SrtUpload> pending{};
+	uint32_t nextId{ 0 }, expectedId{ 0 }, largeId{ 0 };
+	VkDeviceSize expectedOffset{ 0 }, peak{ 0 };
+	uint32_t overlaps{ 0 }, overBudget{ 0 }, outOfOrder{ 0 }, frameDataFailed{ 0 }, deferred{ 0 };
+	uint64_t largeStart{ 0 }, largeEnd{ 0 };
+
+	auto stage = [&](uint64_t frame, VkDeviceSize size, bool budgeted, VkDeviceSize &offset) -> bool {
+		if (!ring.Allocate(size, SRT_ALIGNMENT, offset, budgeted))
+			return false;
+
+		if (_srt_Overlaps(live, offset, size))
+			++overlaps;
+
+		live[frame].push_back({ offset, size });
+
+		if (ring.GetFrameUsed() > ring.GetFrameBudget())
+			++overBudget;
+
+		peak = std::max(peak, ring.GetUsed());
+		return true;
+	};
+
+	// Same split as Renderer::_StageCopy
+	auto stream = [&](uint64_t frame, SrtUpload &upload) -> VkDeviceSize {
+		VkDeviceSize chunk{ std::min(upload.size, ring.GetAvailable(SRT_ALIGNMENT)) }, offset;
+
+		if (chunk < upload.size)
+			chunk &= ~(VkDeviceSize)15;
+
+		if (!chunk || !stage(frame, chunk, true, offset))
+			return 0;
+
+		// Copies must reach the destination in submission order
+		if (upload.id != expectedId || upload.offset != expectedOffset)
+			++outOfOrder;
+
+		upload.offset += chunk;
+		upload.size -= chunk;
+		expectedOffset = upload.offset;
+		if (!upload.size)
+		{
+			++expectedId;
+			expectedOffset = 0;
+		}
+
+		return chunk;
+	};
+
+	for (uint64_t frame = 1; frame <= SRT_TIMELINE_FRAMES; ++frame)
+	{
+		// Waiting on the slot's fence means the GPU finished that frame and every one before it
+		if (frame > SRT_FRAMES)
+		{
+			const uint64_t waited{ frame - SRT_FRAMES };
+
+			ring.Reclaim(waited);
+			live.erase(live.begin(), live.upper_bound(waited));
+		}
+
+		ring.BeginFrame(frame);
+
+		while (!pending.empty())
+		{
+			stream(frame, pending.front());
+			if (pending.front().size)
+				break;
+			pending.pop_front();
+		}
+
+		// New streaming uploads queue behind the ones already waiting
+		const uint32_t uploads{ (uint32_t)(rng() % 8) };
+		for (uint32_t i = 0; i < uploads; ++i)
+		{
+			const uint32_t kind{ (uint32_t)(rng() % 32) };
+			SrtUpload upload{ nextId++, 0, kind ? (VkDeviceSize)(rng() % (512 * 1024) + 1) : (VkDeviceSize)(rng() % (12 * 1024 * 1024) + 1) };
+
+			if (pending.empty())
+				stream(frame, upload);
+
+			if (upload.size)
+			{
+				++deferred;
+				pending.push_back(upload);
+			}
+		}
+
+		if (frame == SRT_TIMELINE_FRAMES / 2)
+		{
+			SrtUpload large{ nextId++, 0, SRT_LARGE_UPLOAD };
+			largeId = large.id;
+			largeStart = frame;
+
+			if (pending.empty())
+				stream(frame, large);
+			pending.push_back(large);
+		}
+
+		if (largeStart && !largeEnd && expectedId > largeId)
+			largeEnd = frame;
+
+		// Scene data, lights and the bone palette arrive whole every frame
+		VkDeviceSize offset;
+		if (!stage(frame, 4096, false, offset) ||
+			!stage(frame, rng() % (256 * 1024) + 1, false, offset) ||
+			!stage(frame, rng() % (1024 * 1024) + 1, false, offset))
+			++frameDataFailed;
+	}
+
+	TEST_CHECK(overlaps == 0);
+	TEST_CHECK(overBudget == 0);
+	TEST_CHECK(outOfOrder == 0);
+	TEST_CHECK(frameDataFailed == 0);
+	TEST_CHECK(deferred > 0);
+	TEST_CHECK(peak <= SRT_RING_SIZE);
+
+	// The large upload does not fit one frame's budget
+	TEST_CHECK(largeStart && largeEnd >= largeStart + SRT_LARGE_UPLOAD / SRT_BUDGET);
+
+	ring.Reclaim(SRT_TIMELINE_FRAMES);
+	TEST_CHECK(ring.GetUsed() == 0);
+
+	if (Test::Benchmark())
+		printf("Timeline: peak %.1f MB, %u deferred uploads, large upload over %u frames\n",
+			peak / (1024.0 * 1024.0), deferred, (uint32_t)(largeEnd - largeStart + 1));
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_srt_TestAllocate();
+	_srt_TestLoads();
+	_srt_TestTimeline();
+
+	return Test::Result();
+}
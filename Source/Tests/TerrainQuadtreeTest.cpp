@@ -0,0 +1,293 @@
+/* NekoEngine
+ *
+ * TerrainQuadtreeTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Terrain quadtree build, LOD selection and culling tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+#include <Engine/Defs.h>
+#include <Engine/TaskManager.h>
+#include <Scene/TerrainQuadtree.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Test.h"
+
+#define TQTT_CELLS			512
+#define TQTT_CHUNK_CELLS	32
+#define TQTT_CELL_SIZE		2.f
+#define TQTT_LOD_DISTANCE	2.f
+#define TQTT_BENCH_RUNS		1000
+
+using namespace std;
+using namespace glm;
+
+static float _tqtt_Height(uint32_t x, uint32_t z)
+{
+	return 20.f * sinf(x * .05f) * cosf(z * .03f) + 5.f;
+}
+
+static vector<uint32_t> _tqtt_Parents(const TerrainQuadtree &tree)
+{
+	const vector<TerrainChunk> &chunks{ tree.GetChunks() };
+	vector<uint32_t> parents(chunks.size(), TQT_NO_CHILDREN);
+
+	for (uint32_t i = 0; i < chunks.size(); ++i)
+		if (chunks[i].firstChild != TQT_NO_CHILDREN)
+			for (uint32_t j = 0; j < 4; ++j)
+				parents[chunks[i].firstChild + j] = i;
+
+	return parents;
+}
+
+static float _tqtt_Distance(const TerrainQuadtree &tree, uint32_t id, const vec3 &view)
+{
+	return sqrtf((float)tree.GetChunks()[id].bounds.GetBox().SquaredDistanceToPoint(view));
+}
+
+static void _tqtt_TestBuild()
+{
+	TerrainQuadtree tree;
+
+	TEST_CHECK(!tree.Build(0, TQTT_CHUNK_CELLS, TQTT_CELL_SIZE, _tqtt_Height));
+	TEST_CHECK(!tree.Build(TQTT_CELLS, 0, TQTT_CELL_SIZE, _tqtt_Height));
+	TEST_CHECK(Test::GetLogCount(LOG_CRITICAL) == 2);
+
+	// The depth is the largest that divides the size and keeps the chunk size
+	TEST_CHECK(tree.Build(96, 32, 1.f, _tqtt_Height));
+	TEST_CHECK(tree.GetDepth() == 1 && tree.GetChunkCells() == 48 && tree.GetChunks().size() == 5);
+
+	TEST_CHECK(tree.Build(100, 64, 1.f, _tqtt_Height));
+	TEST_CHECK(tree.GetDepth() == 0 && tree.GetChunks().size() == 1);
+
+	TEST_CHECK(tree.Build(TQTT_CELLS, TQTT_CHUNK_CELLS, TQTT_CELL_SIZE, _tqtt_Height));
+	TEST_CHECK(tree.GetDepth() == 4 && tree.GetChunkCells() == TQTT_CHUNK_CELLS);
+	TEST_CHECK(tree.GetChunks().size() == 1 + 4 + 16 + 64 + 256);
+
+	const vector<TerrainChunk> &chunks{ tree.GetChunks() };
+	const vector<TerrainVertex> &vertices{ tree.GetVertices() };
+	const vector<uint32_t> &indices{ tree.GetIndices() };
+	const uint32_t row{ tree.GetChunkCells() + 1 };
+	bool inRange{ true }, inBounds{ true }, heights{ true }, contiguous{ true };
+
+	for (const TerrainChunk &c : chunks)
+	{
+		const NBoundingBox &box{ c.bounds.GetBox() };
+
+		for (uint32_t i = c.indexOffset; i < c.indexOffset + c.indexCount; ++i)
+			inRange &= indices[i] >= c.vertexOffset && indices[i] < c.vertexOffset + tree.GetChunkVertexCount();
+
+		for (uint32_t i = c.vertexOffset; i < c.vertexOffset + tree.GetChunkVertexCount(); ++i)
+		{
+			const vec3 &p{ vertices[i].position };
+			inBounds &= all(greaterThanEqual(p, box.GetMin() - vec3(.001f))) && all(lessThanEqual(p, box.GetMax() + vec3(.001f)));
+		}
+
+		// Grid vertices sample the height function on the finest grid
+		for (uint32_t i = 0; i < row; i += 7)
+			for (uint32_t j = 0; j < row; j += 5)
+				heights &= vertices[c.vertexOffset + i * row + j].position.y == _tqtt_Height(c.x + j * c.step, c.z + i * c.step);
+
+		contiguous &= c.firstChild == TQT_NO_CHILDREN || chunks[c.firstChild].level == c.level + 1;
+	}
+
+	TEST_CHECK(inRange);
+	TEST_CHECK(inBounds);
+	TEST_CHECK(heights);
+	TEST_CHECK(contiguous);
+
+	// Skirts only on interior edges
+	TEST_CHECK(chunks[0].skirtEdges == 0);
+	TEST_CHECK(chunks[1].skirtEdges == (TQT_EDGE_SOUTH | TQT_EDGE_EAST));
+	TEST_CHECK(chunks[4].skirtEdges == (TQT_EDGE_NORTH | TQT_EDGE_WEST));
+
+	tree.Clear();
+	TEST_CHECK(tree.GetChunks().empty() && tree.GetVertices().empty() && tree.GetIndices().empty());
+
+	vector<uint32_t> selected{ 1, 2, 3 };
+	tree.Select(vec3(0.f), TQTT_LOD_DISTANCE, nullptr, selected);
+	TEST_CHECK(selected.empty());
+}
+
+static void _tqtt_TestSelection()
+{
+	TerrainQuadtree tree;
+	TEST_CHECK(tree.Build(TQTT_CELLS, TQTT_CHUNK_CELLS, TQTT_CELL_SIZE, _tqtt_Height));
+
+	const vector<TerrainChunk> &chunks{ tree.GetChunks() };
+	const vector<uint32_t> parents{ _tqtt_Parents(tree) };
+	const float extent{ TQTT_CELLS * TQTT_CELL_SIZE * .5f };
+	const vec3 views[]{
+		{ 0.f, 30.f, 0.f },
+		{ -extent, 10.f, -extent },
+		{ extent * .5f, 200.f, -extent * .3f },
+		{ extent * 3.f, 50.f, 0.f },
+		{ 0.f, 5000.f, 0.f }
+	};
+
+	vector<uint32_t> selected;
+	vector<uint8_t> covered(TQTT_CELLS * TQTT_CELLS);
+	bool exact{ true }, split{ true }, notSplit{ true };
+
+	for (const vec3 &view : views)
+	{
+		tree.Select(view, TQTT_LOD_DISTANCE, nullptr, selected);
+		fill(covered.begin(), covered.end(), 0);
+
+		for (uint32_t id : selected)
+		{
+			const TerrainChunk &c{ chunks[id] };
+			const uint32_t size{ tree.GetChunkCells() * c.step };
+
+			for (uint32_t z = c.z; z < c.z + size; ++z)
+				for (uint32_t x = c.x; x < c.x + size; ++x)
+					++covered[z * TQTT_CELLS + x];
+
+			// Every ancestor was close enough to split, the chunk itself was not
+			for (uint32_t p = parents[id]; p != TQT_NO_CHILDREN; p = parents[p])
+				split &= _tqtt_Distance(tree, p, view) <= tree.GetChunkSize(chunks[p]) * TQTT_LOD_DISTANCE;
+
+			notSplit &= c.firstChild == TQT_NO_CHILDREN || _tqtt_Distance(tree, id, view) > tree.GetChunkSize(c) * TQTT_LOD_DISTANCE;
+		}
+
+		// The selection covers every cell exactly once
+		exact &= all_of(covered.begin(), covered.end(), [](uint8_t n) { return n == 1; });
+	}
+
+	TEST_CHECK(exact);
+	TEST_CHECK(split);
+	TEST_CHECK(notSplit);
+
+	// Close to the ground the finest chunks are used; far away only the root
+	tree.Select(views[0], TQTT_LOD_DISTANCE, nullptr, selected);
+	TEST_CHECK(any_of(selected.begin(), selected.end(), [&](uint32_t id) { return chunks[id].level == tree.GetDepth(); }));
+	TEST_CHECK(selected.size() > 4);
+
+	tree.Select(views[4], TQTT_LOD_DISTANCE, nullptr, selected);
+	TEST_CHECK(selected.size() == 1 && selected[0] == 0);
+
+	// A larger distance factor never selects fewer chunks
+	vector<uint32_t> finer;
+	tree.Select(views[2], TQTT_LOD_DISTANCE * 2.f, nullptr, finer);
+	tree.Select(views[2], TQTT_LOD_DISTANCE, nullptr, selected);
+	TEST_CHECK(finer.size() >= selected.size());
+}
+
+static void _tqtt_TestCulling()
+{
+	TerrainQuadtree tree;
+	TEST_CHECK(tree.Build(TQTT_CELLS, TQTT_CHUNK_CELLS, TQTT_CELL_SIZE, _tqtt_Height));
+
+	const vector<TerrainChunk> &chunks{ tree.GetChunks() };
+	const vector<uint32_t> parents{ _tqtt_Parents(tree) };
+	const vec3 eye{ -100.f, 40.f, -100.f };
+	const mat4 projection{ perspective(radians(60.f), 16.f / 9.f, .1f, 2000.f) };
+
+	vector<uint32_t> all, culled;
+	tree.Select(eye, TQTT_LOD_DISTANCE, nullptr, all);
+
+	// Looking along the diagonal: part of the terrain is in view
+	mat4 viewProjection{ projection * lookAt(eye, vec3(400.f, 0.f, 400.f), vec3(0.f, 1.f, 0.f)) };
+	NFrustum frustum{};
+	frustum.FromViewProjection(viewProjection);
+	tree.Select(eye, TQTT_LOD_DISTANCE, &frustum, culled);
+
+	TEST_CHECK(!culled.empty() && culled.size() < all.size());
+
+	// Culled chunks are the unculled selection minus the chunks with a
+	// subtree root outside the frustum, in the same order
+	vector<uint32_t> expected;
+	for (uint32_t id : all)
+	{
+		bool inside{ true };
+		for (uint32_t p = id; p != TQT_NO_CHILDREN && inside; p = parents[p])
+			inside = frustum.ContainsBounds(chunks[p].bounds);
+		if (inside)
+			expected.push_back(id);
+	}
+	TEST_CHECK(culled == expected);
+
+	// Looking at the sky from below the terrain sees nothing
+	viewProjection = projection * lookAt(vec3(0.f, -500.f, 0.f), vec3(0.f, -1000.f, 0.f), vec3(0.f, 0.f, 1.f));
+	frustum.FromViewProjection(viewProjection);
+	tree.Select(eye, TQTT_LOD_DISTANCE, &frustum, culled);
+	TEST_CHECK(culled.empty());
+
+	// From high above looking down everything is in view
+	viewProjection = projection * lookAt(vec3(0.f, 1500.f, 0.f), vec3(0.f), vec3(0.f, 0.f, 1.f));
+	frustum.FromViewProjection(viewProjection);
+	tree.Select(eye, TQTT_LOD_DISTANCE, &frustum, culled);
+	TEST_CHECK(culled == all);
+}
+
+static void _tqtt_Benchmark()
+{
+	TerrainQuadtree tree;
+	vector<uint32_t> selected;
+
+	TaskManager::Initialize();
+
+	double start{ Test::Time() };
+	tree.Build(TQTT_CELLS, TQTT_CHUNK_CELLS, TQTT_CELL_SIZE, _tqtt_Height);
+	const double build{ Test::Time() - start };
+
+	start = Test::Time();
+	for (uint32_t i = 0; i < TQTT_BENCH_RUNS; ++i)
+		tree.Select(vec3((float)(i % 512) - 256.f, 30.f, 0.f), TQTT_LOD_DISTANCE, nullptr, selected);
+	const double select{ (Test::Time() - start) / TQTT_BENCH_RUNS };
+
+	printf("TerrainQuadtree: %d cells, %u chunks, build %.2f ms on %u workers, select %.2f us\n",
+		TQTT_CELLS, (uint32_t)tree.GetChunks().size(), build, TaskManager::GetWorkerCount(), select * 1000.0);
+
+	TaskManager::Release();
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_tqtt_TestBuild();
+	_tqtt_TestSelection();
+	_tqtt_TestCulling();
+
+	if (Test::Benchmark())
+		_tqtt_Benchmark();
+
+	return Test::Result();
+}
@@ -0,0 +1,85 @@
+/* NekoEngine
+ *
+ * Test.h
+ * Author: Alexandru Naiman
+ *
+ * Headless test helpers
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <System/Logger.h>
+
+#define TEST_CHECK(x)	do { if (!(x)) Test::Fail(__FILE__, __LINE__, #x); } while (0)
+
+/**
+ * Tests are standalone executables built with -DEngineTests=ON. They return
+ * non-zero if a check failed; run with --bench to run the benchmarks as well.
+ */
+class Test
+{
+public:
+	static void Init(int argc, char *argv[]);
+
+	static void Fail(const char *file, int line, const char *expr);
+	static int Result();
+
+	static bool Benchmark() { return _benchmark; }
+
+	/**
+	 * Path of a file in Source/Tests/Data; tests run from Source/Tests.
+	 */
+	static const char *DataPath(const char *file);
+
+	/**
+	 * Monotonic time in milliseconds.
+	 */
+	static double Time();
+
+	/**
+	 * Number of messages logged with the severity since start.
+	 */
+	static uint32_t GetLogCount(unsigned int severity);
+
+	static bool HasArgument(const char *name);
+
+private:
+	static int _argc;
+	static char **_argv;
+	static bool _benchmark;
+	static uint32_t _failures;
+};
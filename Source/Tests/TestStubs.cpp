@@ -0,0 +1,148 @@
+/* NekoEngine
+ *
+ * TestStubs.cpp
+ * Author: Alexandru Naiman
+ *
+ * Engine services for headless tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <chrono>
+#include <thread>
+#include <string.h>
+
+#include <Engine/Debug.h>
+#include <Engine/Engine.h>
+#include <Platform/Platform.h>
+#include <System/Logger.h>
+
+#include "Test.h"
+
+int Test::_argc{ 0 };
+char **Test::_argv{ nullptr };
+bool Test::_benchmark{ false };
+uint32_t Test::_failures{ 0 };
+
+static uint32_t _test_logCount[LOG_CRITICAL + 1]{};
+static char _test_path[NE_PATH_SIZE]{};
+
+// Tests link the engine sources they cover instead of the engine library,
+// so the services those sources depend on are replaced here.
+Configuration Engine::_config{};
+
+int32_t Platform::GetNumberOfProcessors()
+{
+	return (int32_t)std::thread::hardware_concurrency();
+}
+
+MessageBoxResult Platform::MessageBox(const char *title, const char *message, MessageBoxButtons buttons, MessageBoxIcon icon)
+{
+	fprintf(stderr, "%s: %s\n", title, message);
+	return MessageBoxResult::OK;
+}
+
+// Debug builds name the task manager's worker threads
+void EngineDebug::SetThreadName(std::thread::id tid, const char *name) { }
+
+static void _test_Log(unsigned int severity, const char *module, const char *message)
+{
+	if (severity <= LOG_CRITICAL)
+		++_test_logCount[severity];
+
+	if (severity >= LOG_WARNING)
+		fprintf(stderr, "[%s] %s\n", module, message);
+}
+
+void Logger::Log(const char *module, unsigned int severity, const char *format, ...) noexcept
+{
+	char buff[4096];
+	va_list args;
+
+	va_start(args, format);
+	vsnprintf(buff, sizeof(buff), format, args);
+	va_end(args);
+
+	_test_Log(severity, module, buff);
+}
+
+void Logger::Log(const char *module, unsigned int severity, const std::string &message) noexcept { _test_Log(severity, module, message.c_str()); }
+void Logger::Log(const char *module, unsigned int severity, const NString &message) noexcept { _test_Log(severity, module, *message); }
+
+void Test::Init(int argc, char *argv[])
+{
+	_argc = argc;
+	_argv = argv;
+
+	_benchmark = HasArgument("--bench");
+}
+
+void Test::Fail(const char *file, int line, const char *expr)
+{
+	fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+	++_failures;
+}
+
+int Test::Result()
+{
+	if (_failures)
+		fprintf(stderr, "%u checks failed\n", _failures);
+	else
+		printf("All checks passed\n");
+
+	return _failures ? 1 : 0;
+}
+
+const char *Test::DataPath(const char *file)
+{
+	snprintf(_test_path, sizeof(_test_path), "Data/%s", file);
+	return _test_path;
+}
+
+double Test::Time()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t Test::GetLogCount(unsigned int severity)
+{
+	return severity <= LOG_CRITICAL ? _test_logCount[severity] : 0;
+}
+
+bool Test::HasArgument(const char *name)
+{
+	for (int i = 1; i < _argc; ++i)
+		if (!strcmp(_argv[i], name))
+			return true;
+
+	return false;
+}
@@ -0,0 +1,261 @@
+/* NekoEngine
+ *
+ * TextRunCacheTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Retained text run cache tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <Renderer/TextRunCache.h>
+
+#include "Test.h"
+
+#define TRT_PERSISTENT_QUADS	1000
+#define TRT_DYNAMIC_QUADS		1000
+#define TRT_STATIC_LINES		20
+#define TRT_FRAMES				100
+#define TRT_FPS_LENGTH			8
+#define TRT_BENCH_FRAMES		10000
+
+using namespace std;
+using namespace glm;
+
+/**
+ * Plays the uploads planned by the cache into a buffer standing in for the
+ * vertex buffer, the way NFont records them.
+ */
+class TestTextRenderer
+{
+public:
+	TextRunCache cache{ TRT_PERSISTENT_QUADS, TRT_DYNAMIC_QUADS };
+	TextRunUpdate update{};
+	vector<uint8_t> staging;
+	vector<uint8_t> buffer;
+
+	TestTextRenderer() :
+		staging(1 << 20),
+		buffer((TRT_PERSISTENT_QUADS + TEXT_RUN_RING_SIZE * TRT_DYNAMIC_QUADS) * TEXT_RUN_QUAD_SIZE)
+	{ }
+
+	/** One quad per character; every vertex holds the run's y */
+	void Draw(const string &text, float y)
+	{
+		uint64_t key{ TextRunCache::Hash(text.data(), text.size()) };
+		key = TextRunCache::Hash(&y, sizeof(y), key);
+
+		if (cache.Find(key))
+			return;
+
+		TextRun *run{ cache.Add(key) };
+		run->vertices.resize(text.size() * 4);
+		for (GUIVertex &v : run->vertices)
+			v.posAndUV = vec4(0.f, y, 0.f, 0.f);
+		run->width = (float)text.size();
+	}
+
+	void EndFrame()
+	{
+		const bool dynamic{ cache.GetDynamicRunCount() != 0 };
+		cache.EndFrame(dynamic ? staging.data() : nullptr, dynamic ? staging.size() : 0, update);
+
+		for (const TextRunFill &fill : update.fills)
+			memset(&buffer[fill.offset], 0x0, fill.size);
+
+		for (const TextRunCopy &copy : update.copies)
+			memcpy(&buffer[copy.dstOffset], &staging[copy.srcOffset], copy.size);
+	}
+
+	/** Number of drawn persistent quads whose vertices hold y */
+	uint32_t CountPersistentQuads(float y) const
+	{
+		uint32_t count{ 0 };
+		for (uint32_t i = 0; i < update.persistentQuads; ++i)
+			if (((const GUIVertex *)&buffer[i * TEXT_RUN_QUAD_SIZE])->posAndUV.y == y)
+				++count;
+		return count;
+	}
+};
+
+static string _trt_Line(int line)
+{
+	return "Static label line " + to_string(line);
+}
+
+static void _trt_DrawStatic(TestTextRenderer &r, int skip = -1)
+{
+	for (int i = 0; i < TRT_STATIC_LINES; ++i)
+		if (i != skip)
+			r.Draw(_trt_Line(i), (float)(i + 1));
+}
+
+static void _trt_TestOverlay()
+{
+	TestTextRenderer r{};
+
+	// A stats overlay: static lines and an FPS counter that changes every frame
+	for (int frame = 0; frame < TRT_FRAMES; ++frame)
+	{
+		_trt_DrawStatic(r);
+		r.Draw("FPS " + to_string(1000 + frame), 100.f);
+		r.EndFrame();
+	}
+
+	// Each line is tessellated once, the counter every frame
+	const TextRunStats &stats{ r.cache.GetStats() };
+	TEST_CHECK(stats.tessellations == TRT_STATIC_LINES + TRT_FRAMES);
+	TEST_CHECK(stats.promotions == TRT_STATIC_LINES);
+	TEST_CHECK(stats.evictions == TRT_FRAMES - 1);
+
+	// Static lines are uploaded while dynamic and once more when promoted
+	uint64_t expected{ (uint64_t)TRT_FRAMES * TRT_FPS_LENGTH * TEXT_RUN_QUAD_SIZE };
+	for (int i = 0; i < TRT_STATIC_LINES; ++i)
+		expected += TEXT_RUN_PROMOTE_FRAMES * _trt_Line(i).size() * TEXT_RUN_QUAD_SIZE;
+	TEST_CHECK(stats.bytesUploaded == expected);
+
+	// Static text alone uploads nothing
+	const uint64_t uploaded{ stats.bytesUploaded };
+	for (int frame = 0; frame < 10; ++frame)
+	{
+		_trt_DrawStatic(r);
+		r.EndFrame();
+	}
+
+	TEST_CHECK(stats.bytesUploaded == uploaded);
+	TEST_CHECK(r.update.copies.empty() && r.update.fills.empty());
+	TEST_CHECK(r.update.stagingUsed == 0);
+	TEST_CHECK(r.cache.GetDynamicRunCount() == 0);
+
+	for (int i = 0; i < TRT_STATIC_LINES; ++i)
+		TEST_CHECK(r.CountPersistentQuads((float)(i + 1)) == _trt_Line(i).size());
+
+	// A line removed from the middle is zeroed and the draw range is kept
+	const uint32_t quads{ r.update.persistentQuads };
+	_trt_DrawStatic(r, 5);
+	r.EndFrame();
+
+	TEST_CHECK(r.update.fills.size() == 1 && r.update.fills[0].size == _trt_Line(5).size() * TEXT_RUN_QUAD_SIZE);
+	TEST_CHECK(r.update.persistentQuads == quads);
+	TEST_CHECK(r.CountPersistentQuads(6.f) == 0);
+	TEST_CHECK(r.CountPersistentQuads(0.f) == _trt_Line(5).size());
+
+	// The hole is reused by a run that fits in it
+	const string shorter{ "Short label" };
+	for (int frame = 0; frame < TEXT_RUN_PROMOTE_FRAMES; ++frame)
+	{
+		_trt_DrawStatic(r, 5);
+		r.Draw(shorter, 50.f);
+		r.EndFrame();
+	}
+
+	TEST_CHECK(r.update.persistentQuads == quads);
+	TEST_CHECK(r.CountPersistentQuads(50.f) == shorter.size());
+
+	r.cache.Clear();
+	TEST_CHECK(r.cache.GetRunCount() == 0);
+	TEST_CHECK(r.cache.GetDynamicRunCount() == 0);
+}
+
+static void _trt_TestRing()
+{
+	TestTextRenderer r{};
+
+	// Dynamic runs alternate between the slices after the persistent region
+	r.Draw("x", 1.f);
+	r.EndFrame();
+	const uint32_t first{ r.update.dynamicFirstQuad };
+
+	r.Draw("x", 1.f);
+	r.EndFrame();
+	const uint32_t second{ r.update.dynamicFirstQuad };
+
+	TEST_CHECK(first == TRT_PERSISTENT_QUADS);
+	TEST_CHECK(second == TRT_PERSISTENT_QUADS + TRT_DYNAMIC_QUADS);
+	TEST_CHECK(r.update.dynamicQuads == 1);
+}
+
+static void _trt_TestFull()
+{
+	TestTextRenderer r{};
+	const string line(TRT_PERSISTENT_QUADS / 2 + 1, 'x');
+
+	// The second line does not fit in the persistent region and stays dynamic
+	for (int frame = 0; frame < TEXT_RUN_PROMOTE_FRAMES + 2; ++frame)
+	{
+		r.Draw(line, 1.f);
+		r.Draw(line, 2.f);
+		r.EndFrame();
+	}
+
+	TEST_CHECK(r.cache.GetStats().promotions == 1);
+	TEST_CHECK(r.cache.GetDynamicRunCount() == 1);
+	TEST_CHECK(r.update.persistentQuads == line.size());
+	TEST_CHECK(r.update.dynamicQuads == line.size());
+	TEST_CHECK(r.update.stagingUsed == line.size() * TEXT_RUN_QUAD_SIZE);
+}
+
+static void _trt_Benchmark()
+{
+	TestTextRenderer r{};
+	const double start{ Test::Time() };
+
+	for (int frame = 0; frame < TRT_BENCH_FRAMES; ++frame)
+	{
+		_trt_DrawStatic(r);
+		r.Draw("FPS " + to_string(1000 + frame % 1000), 100.f);
+		r.EndFrame();
+	}
+
+	const double time{ Test::Time() - start };
+	printf("Overlay: %.3f us per frame, %.1f bytes uploaded per frame\n", time * 1000.0 / TRT_BENCH_FRAMES,
+		(double)r.cache.GetStats().bytesUploaded / TRT_BENCH_FRAMES);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_trt_TestOverlay();
+	_trt_TestRing();
+	_trt_TestFull();
+
+	if (Test::Benchmark())
+		_trt_Benchmark();
+
+	return Test::Result();
+}
@@ -0,0 +1,331 @@
+/* NekoEngine
+ *
+ * TriangleBVHTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Triangle BVH tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <random>
+
+#include <Physics/TriangleBVH.h>
+#include <System/VFS/VFSFile.h>
+
+#include "Test.h"
+
+#define TBT_CLUSTERS		120
+#define TBT_CORE			70000
+#define TBT_RAYS			500
+#define TBT_STACK_SIZE		64
+#define TBT_BENCH_RAYS		100000
+
+using namespace std;
+using namespace glm;
+
+static mt19937 _tbt_rng{ 3 };
+
+static float _tbt_Random(float min, float max)
+{
+	return uniform_real_distribution<float>(min, max)(_tbt_rng);
+}
+
+/**
+ * In-memory file for the cache round trip
+ */
+class TestMemoryFile : public VFSFile
+{
+public:
+	TestMemoryFile() : VFSFile(FileType::Loose), _pos{ 0 } { }
+
+	virtual bool IsOpen() override { return true; }
+	virtual bool IsReadonly() override { return false; }
+	virtual int Open() override { _pos = 0; return ENGINE_OK; }
+	virtual int Create() override { _data.clear(); _pos = 0; return ENGINE_OK; }
+
+	virtual size_t Read(void *buffer, size_t size, size_t count) override
+	{
+		const size_t n{ glm::min(count, (_data.size() - _pos) / size) };
+		memcpy(buffer, _data.data() + _pos, n * size);
+		_pos += n * size;
+		return n;
+	}
+
+	virtual char *Gets(char *str, int num) override { return nullptr; }
+
+	virtual size_t Write(void *buffer, size_t size, size_t count) override
+	{
+		_data.insert(_data.begin() + _pos, (uint8_t *)buffer, (uint8_t *)buffer + size * count);
+		_pos += size * count;
+		return count;
+	}
+
+	virtual int Seek(size_t offset, int origin) override { _pos = offset; return ENGINE_OK; }
+	virtual size_t Tell() override { return _pos; }
+	virtual bool EoF() override { return _pos >= _data.size(); }
+	virtual void Close() override { }
+
+	vector<uint8_t> &Data() noexcept { return _data; }
+
+private:
+	vector<uint8_t> _data;
+	size_t _pos;
+};
+
+static void _tbt_AddTriangle(vector<vec3> &triangles, const vec3 &center, float size)
+{
+	triangles.push_back(center + vec3(_tbt_Random(-size, size), _tbt_Random(-size, size), _tbt_Random(-size, size)));
+	triangles.push_back(center + vec3(_tbt_Random(-size, size), _tbt_Random(-size, size), _tbt_Random(-size, size)));
+	triangles.push_back(center + vec3(_tbt_Random(-size, size), _tbt_Random(-size, size), _tbt_Random(-size, size)));
+}
+
+static bool _tbt_BruteHit(const vector<vec3> &t, const vec3 &origin, const vec3 &direction, float maxT, float &best)
+{
+	bool hit{ false };
+	best = maxT;
+
+	for (size_t i = 0; i < t.size(); i += 3)
+	{
+		const vec3 e1{ t[i + 1] - t[i] }, e2{ t[i + 2] - t[i] }, p{ cross(direction, e2) };
+		const float det{ dot(e1, p) };
+		if (fabsf(det) < 1e-12f)
+			continue;
+
+		const vec3 s{ origin - t[i] }, q{ cross(s, e1) };
+		const float u{ dot(s, p) / det }, v{ dot(direction, q) / det }, d{ dot(e2, q) / det };
+
+		if (u >= 0.f && u <= 1.f && v >= 0.f && u + v <= 1.f && d >= 0.f && d <= best)
+		{
+			best = d;
+			hit = true;
+		}
+	}
+
+	return hit;
+}
+
+// Depth of the deepest node; children always follow their parent
+static uint32_t _tbt_Depth(const vector<BVHNode> &nodes)
+{
+	vector<uint32_t> depth(nodes.size(), 0);
+	uint32_t max{ 0 };
+
+	for (uint32_t i = 0; i < nodes.size(); ++i)
+	{
+		max = glm::max(max, depth[i]);
+
+		if (!nodes[i].count)
+			depth[i + 1] = depth[nodes[i].offset] = depth[i] + 1;
+	}
+
+	return max;
+}
+
+static uint32_t _tbt_Mismatches(const TriangleBVH &bvh, const vector<vec3> &triangles, const vec3 &target, float spread)
+{
+	uint32_t mismatches{ 0 };
+
+	for (uint32_t r = 0; r < TBT_RAYS; ++r)
+	{
+		const vec3 origin{ target + vec3(_tbt_Random(-spread, spread), spread * 2.f, _tbt_Random(-spread, spread)) };
+		const vec3 direction{ normalize(target + vec3(_tbt_Random(-spread, spread), 0.f, _tbt_Random(-spread, spread)) * .5f - origin) };
+
+		BVHHit hit{};
+		float best{};
+		const bool expected{ _tbt_BruteHit(triangles, origin, direction, 1e6f, best) };
+		const bool found{ bvh.ClosestHit(origin, direction, 1e6f, hit) };
+
+		if (expected != found || (found && fabsf(hit.t - best) > 1e-3f * glm::max(1.f, best)))
+			++mismatches;
+		else if (bvh.AnyHit(origin, direction, 1e6f) != expected)
+			++mismatches;
+	}
+
+	return mismatches;
+}
+
+static void _tbt_TestQueries()
+{
+	vector<vec3> triangles;
+	for (uint32_t i = 0; i < 20000; ++i)
+		_tbt_AddTriangle(triangles, vec3(_tbt_Random(-50.f, 50.f), _tbt_Random(-5.f, 5.f), _tbt_Random(-50.f, 50.f)), 1.f);
+
+	TriangleBVH bvh;
+	TEST_CHECK(bvh.Build(triangles) == ENGINE_OK);
+	TEST_CHECK(_tbt_Mismatches(bvh, triangles, vec3(0.f), 50.f) == 0);
+
+	// Box overlap finds every triangle whose bounds are inside the box
+	const vec3 min{ -10.f, -10.f, -10.f }, max{ 10.f, 10.f, 10.f };
+	vector<uint32_t> found;
+	bvh.Overlap(min, max, found);
+
+	uint32_t missing{ 0 };
+	for (uint32_t i = 0; i < triangles.size() / 3; ++i)
+	{
+		const vec3 lo{ glm::min(triangles[i * 3], glm::min(triangles[i * 3 + 1], triangles[i * 3 + 2])) };
+		const vec3 hi{ glm::max(triangles[i * 3], glm::max(triangles[i * 3 + 1], triangles[i * 3 + 2])) };
+
+		if (all(greaterThanEqual(lo, min)) && all(lessThanEqual(hi, max)) && find(found.begin(), found.end(), i) == found.end())
+			++missing;
+	}
+	TEST_CHECK(missing == 0);
+}
+
+/*
+ * Single triangles spiralling out from a dense core: every SAH split peels a
+ * few of them off and the core of more than 65535 triangles stays unsplit for
+ * most of the maximum depth. The tree must still fit the traversal stack.
+ */
+static void _tbt_TestDepth()
+{
+	vector<vec3> triangles;
+
+	const float core{ ldexpf(1.f, -12) };
+	for (uint32_t i = 0; i < TBT_CORE; ++i)
+		_tbt_AddTriangle(triangles, vec3(_tbt_Random(-core, core), _tbt_Random(-core, core), _tbt_Random(-core, core)), core * .1f);
+
+	for (uint32_t k = 0; k < TBT_CLUSTERS; ++k)
+	{
+		vec3 center{ 0.f };
+		center[k % 3] = exp2f(-6.f + k * .5f);
+		_tbt_AddTriangle(triangles, center, 1.f);
+	}
+
+	TriangleBVH bvh;
+	TEST_CHECK(bvh.Build(triangles) == ENGINE_OK);
+	TEST_CHECK(_tbt_Depth(bvh.GetNodes()) + 1 <= TBT_STACK_SIZE);
+	TEST_CHECK(_tbt_Mismatches(bvh, triangles, vec3(0.f), core) == 0);
+
+	// The cache round trip keeps the tree
+	TestMemoryFile file;
+	TEST_CHECK(bvh.Save(&file) == ENGINE_OK);
+	file.Seek(0, SEEK_SET);
+
+	TriangleBVH loaded;
+	TEST_CHECK(loaded.Load(&file, TriangleBVH::HashTriangles(triangles)) == ENGINE_OK);
+	TEST_CHECK(loaded.GetNodeCount() == bvh.GetNodeCount());
+}
+
+// A cached tree that would overflow the traversal stack is rejected
+static void _tbt_TestLoadValidation()
+{
+	vector<vec3> triangles;
+	for (uint32_t i = 0; i < 200; ++i)
+		_tbt_AddTriangle(triangles, vec3((float)i, 0.f, 0.f), .5f);
+
+	TriangleBVH bvh;
+	bvh.Build(triangles);
+
+	TestMemoryFile file;
+	bvh.Save(&file);
+
+	// Rewrite the nodes as a chain: every interior node has a one triangle leaf as second child
+	const size_t nodesOffset{ 7 + sizeof(uint64_t) + sizeof(uint32_t) * 2 };
+	const uint32_t nodeCount{ bvh.GetNodeCount() };
+	BVHNode *nodes{ (BVHNode *)(file.Data().data() + nodesOffset) };
+
+	for (uint32_t i = 0; i + 2 < nodeCount; i += 2)
+	{
+		nodes[i] = BVHNode{ bvh.GetMin(), i + 2, bvh.GetMax(), 0, 0 };
+		nodes[i + 1] = BVHNode{ bvh.GetMin(), 0, bvh.GetMax(), 1, 0 };
+	}
+
+	file.Seek(0, SEEK_SET);
+	TriangleBVH loaded;
+	TEST_CHECK(loaded.Load(&file, TriangleBVH::HashTriangles(triangles)) != ENGINE_OK);
+
+	// An empty mesh still loads
+	const vector<vec3> empty;
+	TriangleBVH emptyBvh;
+	TestMemoryFile emptyFile;
+	emptyBvh.Build(empty);
+	TEST_CHECK(emptyBvh.Save(&emptyFile) == ENGINE_OK);
+
+	emptyFile.Seek(0, SEEK_SET);
+	TEST_CHECK(loaded.Load(&emptyFile, TriangleBVH::HashTriangles(empty)) == ENGINE_OK);
+}
+
+static void _tbt_Benchmark()
+{
+	vector<vec3> triangles;
+	const int size{ 200 };
+
+	// Height field with clutter on top
+	for (int z = 0; z < size; ++z)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			const vec3 a{ (float)x, sinf(x * .3f) * cosf(z * .2f) * 3.f, (float)z };
+			const vec3 b{ (float)x + 1.f, sinf((x + 1) * .3f) * cosf(z * .2f) * 3.f, (float)z };
+			const vec3 c{ (float)x, sinf(x * .3f) * cosf((z + 1) * .2f) * 3.f, (float)z + 1.f };
+			triangles.insert(triangles.end(), { a, b, c });
+		}
+	}
+
+	for (uint32_t i = 0; i < 20000; ++i)
+		_tbt_AddTriangle(triangles, vec3(_tbt_Random(0.f, 200.f), _tbt_Random(0.f, 8.f), _tbt_Random(0.f, 200.f)), .5f);
+
+	TriangleBVH bvh;
+	double start{ Test::Time() };
+	bvh.Build(triangles);
+	const double build{ Test::Time() - start };
+
+	uint32_t hits{ 0 };
+	start = Test::Time();
+	for (uint32_t r = 0; r < TBT_BENCH_RAYS; ++r)
+	{
+		const vec3 origin{ _tbt_Random(0.f, 200.f), 20.f, _tbt_Random(0.f, 200.f) };
+		BVHHit hit{};
+		hits += bvh.ClosestHit(origin, normalize(vec3(_tbt_Random(-1.f, 1.f), -2.f, _tbt_Random(-1.f, 1.f))), 500.f, hit);
+	}
+	const double rays{ (Test::Time() - start) * 1000.0 / TBT_BENCH_RAYS };
+
+	printf("%u triangles: build %.1f ms, %u nodes, depth %u, %.2f us per ray (%u hits)\n",
+		bvh.GetTriangleCount(), build, bvh.GetNodeCount(), _tbt_Depth(bvh.GetNodes()), rays, hits);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_tbt_TestQueries();
+	_tbt_TestDepth();
+	_tbt_TestLoadValidation();
+
+	if (Test::Benchmark())
+		_tbt_Benchmark();
+
+	return Test::Result();
+}
@@ -0,0 +1,182 @@
+/* NekoEngine
+ *
+ * VectorInterfaceTest.cpp
+ * Author: Alexandru Naiman
+ *
+ * Script vector type tests
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+
+#include <Script/Script.h>
+
+#include "Test.h"
+#include "ScriptTest.h"
+
+#define VIT_BENCH_COUNT		100000
+#define VIT_BENCH_FRAMES	20
+
+// Runs code that returns true on success; errors are reported as failures
+static bool _vit_Check(const char *code)
+{
+	lua_State *state{ Script::GetState() };
+
+	if (luaL_loadstring(state, code) || lua_pcall(state, 0, 1, 0))
+	{
+		fprintf(stderr, "%s\n", lua_tostring(state, -1));
+		lua_pop(state, 1);
+		return false;
+	}
+
+	const bool ret{ lua_toboolean(state, -1) != 0 };
+	lua_pop(state, 1);
+
+	return ret;
+}
+
+static double _vit_Number(const char *code)
+{
+	lua_State *state{ Script::GetState() };
+
+	if (luaL_loadstring(state, code) || lua_pcall(state, 0, 1, 0))
+	{
+		fprintf(stderr, "%s\n", lua_tostring(state, -1));
+		lua_pop(state, 1);
+		return NAN;
+	}
+
+	const double ret{ lua_tonumber(state, -1) };
+	lua_pop(state, 1);
+
+	return ret;
+}
+
+static void _vit_TestOperators()
+{
+	TEST_CHECK(_vit_Check("return vec3(1, 2, 3) + vec3(1) == vec3(2, 3, 4)"));
+	TEST_CHECK(_vit_Check("return 2 * vec3(1, 2, 3) - vec3(1, 2, 3) / 1 == vec3(1, 2, 3)"));
+	TEST_CHECK(_vit_Check("return vec3(1, 0, 0):cross(vec3(0, 1, 0)) == vec3(0, 0, 1)"));
+	TEST_CHECK(_vit_Check("return vec4(vec3(1, 2, 3), 4) == vec4(1, 2, 3, 4)"));
+	TEST_CHECK(_vit_Check("return #vec2(3, 4) == 5"));
+	TEST_CHECK(_vit_Check("local v = vec3(3, 0, 4) return v:normalize() == v and math.abs(v:length() - 1) < 1e-6"));
+	TEST_CHECK(_vit_Check("local m = mat4():translate(vec3(1, 2, 3)) return m * vec3(0) == vec3(1, 2, 3)"));
+	TEST_CHECK(_vit_Check("local q = quat(math.pi / 2, vec3(0, 1, 0)) local r = q * vec3(1, 0, 0) return math.abs(r.z + 1) < 1e-6"));
+
+	// The shims accept the types as well as engine pointers
+	TEST_CHECK(_vit_Check("local out = vec3() M_vec3_Cross(vec3(1, 0, 0), vec3(0, 1, 0), out) return out == vec3(0, 0, 1)"));
+}
+
+static void _vit_TestSwizzles()
+{
+	TEST_CHECK(_vit_Check("return vec3(1, 2, 3).zyx == vec3(3, 2, 1)"));
+	TEST_CHECK(_vit_Check("return vec4(1, 2, 3, 4).wx == vec2(4, 1)"));
+	TEST_CHECK(_vit_Check("return vec4(1, 2, 3, 4).rgba == vec4(1, 2, 3, 4)"));
+	TEST_CHECK(_vit_Check("return vec2(1, 2).yyy == vec3(2, 2, 2)"));
+	TEST_CHECK(_vit_Check("return vec3(1, 2, 3).b == 3"));
+
+	// Repeated lookups of one key give independent values
+	TEST_CHECK(_vit_Check("local v = vec3(1, 2, 3) local a, b = v.zy, v.zy a.x = 9 return b.x == 3 and a ~= b"));
+
+	// Components past the size and unknown names are not swizzles
+	TEST_CHECK(_vit_Check("return vec2(1, 2).xz == nil and vec3(1, 2, 3).xyzw == nil"));
+	TEST_CHECK(_vit_Check("return vec3(1, 2, 3).xq == nil and vec3(1, 2, 3).xxxxx == nil and vec3(1, 2, 3)[''] == nil"));
+
+	// A swizzle allocates the result and nothing else: the same as the
+	// constructor. The interpreter is used, as compiled code sinks both.
+	const char *garbage =
+		"jit.off()\n"
+		"local v, out = vec3(1, 2, 3), 0\n"
+		"local mode = %s\n"
+		"collectgarbage('collect') collectgarbage('stop')\n"
+		"local before = collectgarbage('count')\n"
+		"for i = 1, 10000 do local s = mode and v.zyx or vec3(v.z, v.y, v.x) out = out + s.x end\n"
+		"local kb = collectgarbage('count') - before\n"
+		"collectgarbage('restart')\n"
+		"jit.on()\n"
+		"return kb\n";
+
+	char code[512];
+	snprintf(code, sizeof(code), garbage, "true");
+	const double swizzle{ _vit_Number(code) };
+	snprintf(code, sizeof(code), garbage, "false");
+	const double constructor{ _vit_Number(code) };
+
+	TEST_CHECK(constructor > 0.0 && swizzle <= constructor * 1.1);
+}
+
+static void _vit_Benchmark()
+{
+	const char *bench =
+		"local N, F = %d, %d\n"
+		"local up, n = vec3(0, 1, 0), vec3(0, 0, 1)\n"
+		"local v = {} for i = 1, N do v[i] = vec3(i, i * .5, -i) end\n"
+		"local function run(name, fn)\n"
+		"	fn() collectgarbage('collect') collectgarbage('stop')\n"
+		"	local kb, t = collectgarbage('count'), os.clock()\n"
+		"	for f = 1, F do fn() end\n"
+		"	t, kb = (os.clock() - t) * 1000 / F, (collectgarbage('count') - kb) / F\n"
+		"	collectgarbage('restart')\n"
+		"	print(string.format('%%-24s %%7.2f ms %%9.1f KB per frame', name, t, kb))\n"
+		"end\n"
+		"local s = 0\n"
+		"run('operators', function() for i = 1, N do local c = v[i]:cross(up) s = s + c:reflect(n):dot(up) + #c end end)\n"
+		"local t = vec3()\n"
+		"run('in-place', function() for i = 1, N do t:set(v[i]):crossWith(up) s = s + t:dot(n) + t:length() end end)\n"
+		"run('swizzles', function() for i = 1, N do local w = v[i].zyx s = s + w.x + v[i].xy:dot(v[i].yx) end end)\n"
+		"local out = vec3()\n"
+		"run('M_ shims', function() for i = 1, N do M_vec3_Cross(v[i], up, out) s = s + M_vec3_Dot(out, n) + M_vec3_Length(out) end end)\n"
+		"return s\n";
+
+	char code[2048];
+	snprintf(code, sizeof(code), bench, VIT_BENCH_COUNT, VIT_BENCH_FRAMES);
+
+	printf("%d vec3 per frame\n", VIT_BENCH_COUNT);
+	_vit_Number(code);
+}
+
+int main(int argc, char *argv[])
+{
+	Test::Init(argc, argv);
+
+	_vit_TestOperators();
+	_vit_TestSwizzles();
+
+	if (Test::Benchmark())
+		_vit_Benchmark();
+
+	TEST_CHECK(lua_gettop(Script::GetState()) == 0);
+	Script::Release();
+
+	return Test::Result();
+}
@@ -40,6 +40,7 @@
 #include <zlib.h>
 
 #include "AnimationClip.h"
+#include "AnimationCompressor.h"
 
 void AnimationClip::Export(const char *file)
 {
@@ -92,3 +93,8 @@ void AnimationClip::Export(const char *file)
 
 	gzclose(fp);
 }
+
+void AnimationClip::ExportCompressed(const char *file, const AnimationCompressor &compressor, std::vector<ChannelError> &errors)
+{
+	compressor.Export(file, _duration, _ticksPerSecond, _channels, errors);
+}
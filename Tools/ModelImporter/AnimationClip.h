@@ -49,8 +49,9 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#define ANIM_HEADER	"NANIM2 "
-#define ANIM_FOOTER	"ENDANIM"
+#define ANIM_HEADER				"NANIM2 "
+#define ANIM_COMPRESSED_HEADER	"NANIM3 "
+#define ANIM_FOOTER				"ENDANIM"
 
 struct VectorKey
 {
@@ -72,6 +73,9 @@ typedef struct ANIMATION_NODE
 	std::vector<VectorKey> scalingKeys;
 } AnimationNode;
 
+struct ChannelError;
+class AnimationCompressor;
+
 class AnimationClip
 {
 public:
@@ -83,6 +87,12 @@ public:
 
 	void Export(const char *file);
 
+	/**
+	 * Compress every channel and write a NANIM3 file.
+	 * The error of each channel against the source keys is returned in errors.
+	 */
+	void ExportCompressed(const char *file, const AnimationCompressor &compressor, std::vector<ChannelError> &errors);
+
 	virtual ~AnimationClip() { }
 
 private:
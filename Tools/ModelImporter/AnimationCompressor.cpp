@@ -0,0 +1,371 @@
+/* NekoEngine - ModelImporter
+ *
+ * AnimationCompressor.cpp
+ * Author: Alexandru Naiman
+ *
+ * AnimationCompressor implementation
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <zlib.h>
+#include <string.h>
+
+#include "AnimationCompressor.h"
+
+using namespace std;
+using namespace glm;
+
+// Rotation angle between a and b; atan2 stays accurate for small angles where acos(dot) does not
+static inline double _Angle(const dquat &a, const dquat &b)
+{
+	const dvec4 u{ a.x, a.y, a.z, a.w };
+	const dvec4 v{ dot(a, b) < 0.0 ? -dvec4(b.x, b.y, b.z, b.w) : dvec4(b.x, b.y, b.z, b.w) };
+	return 4.0 * atan2(length(u - v), length(u + v));
+}
+
+static inline double _Factor(double start, double end, double time)
+{
+	const double dt{ end - start };
+	return dt > 0.0 ? glm::clamp((time - start) / dt, 0.0, 1.0) : 0.0;
+}
+
+/*
+ * Greedy error-bounded reduction: extend the segment starting at the last kept
+ * key for as long as every key inside it is reconstructed within tolerance.
+ * fits(a, e) tests the keys between a and e.
+ */
+template<typename F>
+static vector<uint32_t> _ReduceKeys(uint32_t count, F fits)
+{
+	vector<uint32_t> kept{ 0 };
+	uint32_t anchor{ 0 };
+
+	for (uint32_t end = 2; end < count; ++end)
+	{
+		if (fits(anchor, end))
+			continue;
+
+		anchor = end - 1;
+		kept.push_back(anchor);
+	}
+
+	if (count > 1)
+		kept.push_back(count - 1);
+
+	return kept;
+}
+
+void AnimationCompressor::Compress(const AnimationNode &channel, CompressedChannel &out, ChannelError &error) const
+{
+	unordered_map<string, BindPose>::const_iterator it{ _bindPoses.find(channel.name) };
+	const BindPose *bind{ it != _bindPoses.end() ? &it->second : nullptr };
+
+	out.name = channel.name;
+
+	_CompressVectorTrack(channel.positionKeys, bind ? &bind->position : nullptr, _positionError, out.position);
+	_CompressQuatTrack(channel.rotationKeys, bind ? &bind->rotation : nullptr, _rotationError, out.rotation);
+	_CompressVectorTrack(channel.scalingKeys, bind ? &bind->scaling : nullptr, _scaleError, out.scaling);
+
+	error.name = channel.name;
+	error.sourceKeys = (uint32_t)(channel.positionKeys.size() + channel.rotationKeys.size() + channel.scalingKeys.size());
+	error.keys = 0;
+
+	for (uint8_t type : { out.position.type, out.rotation.type, out.scaling.type })
+		if (type == ANIM_TRACK_CONSTANT)
+			++error.keys;
+
+	error.keys += (uint32_t)(out.position.times.size() + out.rotation.times.size() + out.scaling.times.size());
+
+	error.position = _VectorTrackError(channel.positionKeys, bind ? &bind->position : nullptr, out.position);
+	error.rotation = _QuatTrackError(channel.rotationKeys, bind ? &bind->rotation : nullptr, out.rotation);
+	error.scaling = _VectorTrackError(channel.scalingKeys, bind ? &bind->scaling : nullptr, out.scaling);
+}
+
+static void _WriteVectorTrack(gzFile fp, const CompressedVectorTrack &track)
+{
+	uint32_t num{ (uint32_t)track.times.size() };
+
+	gzwrite(fp, &track.type, sizeof(uint8_t));
+
+	if (track.type == ANIM_TRACK_CONSTANT)
+	{
+		gzwrite(fp, &track.min.x, sizeof(float) * 3);
+	}
+	else if (track.type == ANIM_TRACK_QUANTIZED)
+	{
+		gzwrite(fp, &num, sizeof(uint32_t));
+		gzwrite(fp, &track.min.x, sizeof(float) * 3);
+		gzwrite(fp, &track.extent.x, sizeof(float) * 3);
+		gzwrite(fp, track.times.data(), sizeof(float) * num);
+		gzwrite(fp, track.values.data(), sizeof(uint16_t) * num * 3);
+	}
+}
+
+static void _WriteQuatTrack(gzFile fp, const CompressedQuatTrack &track)
+{
+	uint32_t num{ (uint32_t)track.times.size() };
+	float q[4]{ track.constant.x, track.constant.y, track.constant.z, track.constant.w };
+
+	gzwrite(fp, &track.type, sizeof(uint8_t));
+
+	if (track.type == ANIM_TRACK_CONSTANT)
+	{
+		gzwrite(fp, q, sizeof(float) * 4);
+	}
+	else if (track.type == ANIM_TRACK_QUANTIZED)
+	{
+		gzwrite(fp, &num, sizeof(uint32_t));
+		gzwrite(fp, track.times.data(), sizeof(float) * num);
+		gzwrite(fp, track.values.data(), sizeof(uint16_t) * num * 3);
+	}
+}
+
+void AnimationCompressor::Export(const char *file, double duration, double ticksPerSecond,
+								 const vector<AnimationNode> &channels, vector<ChannelError> &errors) const
+{
+	uint32_t num{0};
+	gzFile fp = gzopen(file, "wb");
+
+	gzwrite(fp, ANIM_COMPRESSED_HEADER, 7);
+
+	gzwrite(fp, &num, sizeof(uint32_t));
+
+	gzwrite(fp, &duration, sizeof(double));
+	gzwrite(fp, &ticksPerSecond, sizeof(double));
+
+	num = (uint32_t)channels.size();
+	gzwrite(fp, &num, sizeof(uint32_t));
+
+	errors.resize(channels.size());
+
+	for (size_t i = 0; i < channels.size(); ++i)
+	{
+		CompressedChannel channel;
+		Compress(channels[i], channel, errors[i]);
+
+		num = (uint32_t)strlen(channel.name.c_str());
+		gzwrite(fp, &num, sizeof(uint32_t));
+		gzwrite(fp, channel.name.c_str(), num);
+
+		_WriteVectorTrack(fp, channel.position);
+		_WriteQuatTrack(fp, channel.rotation);
+		_WriteVectorTrack(fp, channel.scaling);
+	}
+
+	gzwrite(fp, ANIM_FOOTER, 7);
+
+	gzclose(fp);
+}
+
+void AnimationCompressor::_CompressVectorTrack(const vector<VectorKey> &keys, const dvec3 *bind, double tolerance, CompressedVectorTrack &track) const
+{
+	double constantError{ 0.0 }, bindError{ 0.0 };
+
+	track.times.clear();
+	track.values.clear();
+
+	// A channel without keys leaves the node at its bind pose
+	if (keys.empty())
+	{
+		track.type = ANIM_TRACK_DEFAULT;
+		return;
+	}
+
+	for (const VectorKey &key : keys)
+	{
+		constantError = glm::max(constantError, distance(key.value, keys[0].value));
+		if (bind)
+			bindError = glm::max(bindError, distance(key.value, *bind));
+	}
+
+	if (bind && bindError <= tolerance)
+	{
+		track.type = ANIM_TRACK_DEFAULT;
+		return;
+	}
+
+	if (constantError <= tolerance)
+	{
+		track.type = ANIM_TRACK_CONSTANT;
+		track.min = (vec3)keys[0].value;
+		return;
+	}
+
+	dvec3 min{ keys[0].value }, max{ keys[0].value };
+	for (const VectorKey &key : keys)
+	{
+		min = glm::min(min, key.value);
+		max = glm::max(max, key.value);
+	}
+
+	track.type = ANIM_TRACK_QUANTIZED;
+	track.min = (vec3)min;
+	track.extent = (vec3)(max - min);
+
+	// Reduce against the dequantized values so the tolerance covers quantization error too
+	vector<uint16_t> values(keys.size() * 3);
+	vector<dvec3> decoded(keys.size());
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		AnimEncodeVector((vec3)keys[i].value, track.min, track.extent, &values[i * 3]);
+		decoded[i] = (dvec3)AnimDecodeVector(&values[i * 3], track.min, track.extent);
+	}
+
+	vector<uint32_t> kept{ _ReduceKeys((uint32_t)keys.size(), [&](uint32_t a, uint32_t e) -> bool {
+		for (uint32_t i = a + 1; i < e; ++i)
+		{
+			const double f{ _Factor(keys[a].time, keys[e].time, keys[i].time) };
+			if (distance(mix(decoded[a], decoded[e], f), keys[i].value) > tolerance)
+				return false;
+		}
+		return true;
+	}) };
+
+	for (uint32_t i : kept)
+	{
+		track.times.push_back((float)keys[i].time);
+		track.values.insert(track.values.end(), &values[i * 3], &values[i * 3] + 3);
+	}
+}
+
+void AnimationCompressor::_CompressQuatTrack(const vector<QuatKey> &keys, const dquat *bind, double tolerance, CompressedQuatTrack &track) const
+{
+	double constantError{ 0.0 }, bindError{ 0.0 };
+
+	track.times.clear();
+	track.values.clear();
+
+	if (keys.empty())
+	{
+		track.type = ANIM_TRACK_DEFAULT;
+		return;
+	}
+
+	vector<dquat> source(keys.size());
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		source[i] = normalize(keys[i].value);
+
+		constantError = glm::max(constantError, _Angle(source[i], source[0]));
+		if (bind)
+			bindError = glm::max(bindError, _Angle(source[i], *bind));
+	}
+
+	if (bind && bindError <= tolerance)
+	{
+		track.type = ANIM_TRACK_DEFAULT;
+		return;
+	}
+
+	if (constantError <= tolerance)
+	{
+		track.type = ANIM_TRACK_CONSTANT;
+		track.constant = (quat)source[0];
+		return;
+	}
+
+	track.type = ANIM_TRACK_QUANTIZED;
+
+	vector<uint16_t> values(keys.size() * 3);
+	vector<quat> decoded(keys.size());
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		AnimEncodeQuat((quat)source[i], &values[i * 3]);
+		decoded[i] = AnimDecodeQuat(&values[i * 3]);
+	}
+
+	vector<uint32_t> kept{ _ReduceKeys((uint32_t)keys.size(), [&](uint32_t a, uint32_t e) -> bool {
+		for (uint32_t i = a + 1; i < e; ++i)
+		{
+			const float f{ (float)_Factor(keys[a].time, keys[e].time, keys[i].time) };
+			if (_Angle((dquat)normalize(slerp(decoded[a], decoded[e], f)), source[i]) > tolerance)
+				return false;
+		}
+		return true;
+	}) };
+
+	for (uint32_t i : kept)
+	{
+		track.times.push_back((float)keys[i].time);
+		track.values.insert(track.values.end(), &values[i * 3], &values[i * 3] + 3);
+	}
+}
+
+/*
+ * Errors are measured at the source key times. Both the source and the
+ * compressed tracks interpolate linearly between those times, so this is
+ * where the largest position and scale errors occur.
+ */
+double AnimationCompressor::_VectorTrackError(const vector<VectorKey> &keys, const dvec3 *bind, const CompressedVectorTrack &track) const
+{
+	double error{ 0.0 };
+	uint32_t cursor{ 0 };
+
+	for (const VectorKey &key : keys)
+	{
+		dvec3 value{ key.value };
+
+		if (track.type == ANIM_TRACK_DEFAULT && bind)
+			value = *bind;
+		else if (track.type == ANIM_TRACK_CONSTANT)
+			value = (dvec3)track.min;
+		else if (track.type == ANIM_TRACK_QUANTIZED)
+			value = (dvec3)AnimSampleTrack(track, key.time, cursor);
+
+		error = glm::max(error, distance(value, key.value));
+	}
+
+	return error;
+}
+
+double AnimationCompressor::_QuatTrackError(const vector<QuatKey> &keys, const dquat *bind, const CompressedQuatTrack &track) const
+{
+	double error{ 0.0 };
+	uint32_t cursor{ 0 };
+
+	for (const QuatKey &key : keys)
+	{
+		dquat value{ key.value };
+
+		if (track.type == ANIM_TRACK_DEFAULT && bind)
+			value = *bind;
+		else if (track.type == ANIM_TRACK_CONSTANT)
+			value = (dquat)track.constant;
+		else if (track.type == ANIM_TRACK_QUANTIZED)
+			value = (dquat)AnimSampleTrack(track, key.time, cursor);
+
+		error = glm::max(error, _Angle(value, normalize(key.value)));
+	}
+
+	return error;
+}
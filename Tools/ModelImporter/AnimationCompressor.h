@@ -0,0 +1,121 @@
+/* NekoEngine - ModelImporter
+ *
+ * AnimationCompressor.h
+ * Author: Alexandru Naiman
+ *
+ * AnimationCompressor class definition
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2015-2017, Alexandru Naiman
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ALEXANDRU NAIMAN "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ALEXANDRU NAIMAN BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ANIMATIONCOMPRESSOR_H
+#define ANIMATIONCOMPRESSOR_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <AnimationClip.h>
+#include <Animation/AnimationCompression.h>
+
+#define ANIM_POSITION_ERROR		0.0001
+#define ANIM_ROTATION_ERROR		0.0005
+#define ANIM_SCALE_ERROR		0.0001
+
+struct BindPose
+{
+	glm::dvec3 position;
+	glm::dquat rotation;
+	glm::dvec3 scaling;
+};
+
+struct CompressedChannel
+{
+	std::string name;
+	CompressedVectorTrack position;
+	CompressedQuatTrack rotation;
+	CompressedVectorTrack scaling;
+};
+
+/**
+ * Maximum error of a compressed channel against the source keys.
+ * Position and scale errors are distances, rotation errors are in radians.
+ */
+struct ChannelError
+{
+	std::string name;
+	uint32_t sourceKeys;
+	uint32_t keys;
+	double position;
+	double rotation;
+	double scaling;
+};
+
+class AnimationCompressor
+{
+public:
+	AnimationCompressor(double positionError = ANIM_POSITION_ERROR,
+						double rotationError = ANIM_ROTATION_ERROR,
+						double scaleError = ANIM_SCALE_ERROR) :
+		_positionError(positionError), _rotationError(rotationError), _scaleError(scaleError)
+	{ }
+
+	/**
+	 * Tracks that stay within tolerance of the node's bind pose are stripped
+	 * and the runtime keeps the bind pose value. Channels without a bind pose
+	 * are never stripped.
+	 */
+	void SetBindPose(const std::string &node, const BindPose &pose) { _bindPoses[node] = pose; }
+
+	void Compress(const AnimationNode &channel, CompressedChannel &out, ChannelError &error) const;
+
+	/**
+	 * Compress every channel and write a NANIM3 file.
+	 * The error of each channel against the source keys is returned in errors.
+	 */
+	void Export(const char *file, double duration, double ticksPerSecond,
+				const std::vector<AnimationNode> &channels, std::vector<ChannelError> &errors) const;
+
+	virtual ~AnimationCompressor() { }
+
+private:
+	double _positionError, _rotationError, _scaleError;
+	std::unordered_map<std::string, BindPose> _bindPoses;
+
+	void _CompressVectorTrack(const std::vector<VectorKey> &keys, const glm::dvec3 *bind, double tolerance, CompressedVectorTrack &track) const;
+	void _CompressQuatTrack(const std::vector<QuatKey> &keys, const glm::dquat *bind, double tolerance, CompressedQuatTrack &track) const;
+
+	double _VectorTrackError(const std::vector<VectorKey> &keys, const glm::dvec3 *bind, const CompressedVectorTrack &track) const;
+	double _QuatTrackError(const std::vector<QuatKey> &keys, const glm::dquat *bind, const CompressedQuatTrack &track) const;
+};
+
+#endif // ANIMATIONCOMPRESSOR_H
@@ -40,7 +40,6 @@
 #include "AssimpConverter.h"
 
 #include <QDir>
-#include <QMessageBox>
 
 #include <vector>
 #include <iostream>
@@ -50,6 +49,7 @@
 
 #include <Material.h>
 #include <AnimationClip.h>
+#include <AnimationCompressor.h>
 
 using namespace std;
 using namespace glm;
@@ -61,19 +61,23 @@ AssimpConverter::AssimpConverter(QObject *parent) : QObject(parent)
 {
 	_staticMesh = nullptr;
 	_skeletalMesh = nullptr;
+	_compressAnimations = true;
 }
 
 bool AssimpConverter::Convert(const char *inFile, const char *outFile, bool forceStaticMesh)
 {
 	Importer importer;
 
+	_error.clear();
+	_warnings.clear();
+
 	importer.SetPropertyInteger(AI_CONFIG_PP_LBW_MAX_WEIGHTS, 4);
 
 	const aiScene *scene = importer.ReadFile(inFile, aiProcessPreset_TargetRealtime_MaxQuality);
 
 	if (!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 	{
-		QMessageBox::critical(nullptr, "Fatal Error", "Failed to load model file");
+		_error = QString("Failed to load model file: %1").arg(importer.GetErrorString());
 		return false;
 	}
 
@@ -128,7 +132,7 @@ bool AssimpConverter::Convert(const char *inFile, const char *outFile, bool forc
 		delete _skeletalMesh;
 		_skeletalMesh = nullptr;
 
-		QMessageBox::warning(nullptr, "Failed to create directory", "Failed to create Materials directory; materials will not be exported.");
+		_warnings.append("Failed to create Materials directory; materials will not be exported.");
 		return true;
 	}
 	dir.cd("Materials");
@@ -149,7 +153,7 @@ bool AssimpConverter::Convert(const char *inFile, const char *outFile, bool forc
 		delete _skeletalMesh;
 		_skeletalMesh = nullptr;
 
-		QMessageBox::warning(nullptr, "Failed to create scene file", "Failed to create scene file; materials will not be exported.");
+		_warnings.append("Failed to create scene file; materials will not be exported.");
 		return true;
 	}
 
@@ -245,9 +249,9 @@ bool AssimpConverter::Convert(const char *inFile, const char *outFile, bool forc
 	{
 		QDir animDir(outFile);
 		animDir.cdUp();
-		if (!animDir.exists("Animations") && !dir.mkdir("Animations"))
+		if (!animDir.exists("Animations") && !animDir.mkdir("Animations"))
 		{
-			QMessageBox::warning(nullptr, "Failed to create directory", "Failed to create Animations directory; animations will not be exported.");
+			_warnings.append("Failed to create Animations directory; animations will not be exported.");
 			return true;
 		}
 		animDir.cd("Animations");
@@ -321,7 +325,35 @@ void AssimpConverter::_ProcessAnimation(struct aiAnimation *animation)
 	char file[255];
 	snprintf(file, 255, "%s.nanim", animation->mName.C_Str());
 
-	animClip.Export(file);
+	if (!_compressAnimations)
+	{
+		animClip.Export(file);
+		return;
+	}
+
+	AnimationCompressor compressor;
+	vector<ChannelError> errors;
+
+	for (aiNode *node : _nodes)
+	{
+		aiVector3D position, scaling;
+		aiQuaternion rotation;
+		BindPose pose;
+
+		node->mTransformation.Decompose(scaling, rotation, position);
+
+		pose.position = dvec3(position.x, position.y, position.z);
+		pose.rotation = dquat(rotation.w, rotation.x, rotation.y, rotation.z);
+		pose.scaling = dvec3(scaling.x, scaling.y, scaling.z);
+
+		compressor.SetBindPose(node->mName.C_Str(), pose);
+	}
+
+	animClip.ExportCompressed(file, compressor, errors);
+
+	fprintf(stderr, "Animation %s: per-bone error (position, rotation [rad], scale)\n", animation->mName.C_Str());
+	for (ChannelError &e : errors)
+		fprintf(stderr, "\t%-32s %5u -> %5u keys  %.6f  %.6f  %.6f\n", e.name.c_str(), e.sourceKeys, e.keys, e.position, e.rotation, e.scaling);
 }
 
 void AssimpConverter::_ProcessStaticMesh(struct aiMesh *mesh)
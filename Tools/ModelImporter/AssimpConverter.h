@@ -41,6 +41,7 @@
 #define ASSIMPIMPORTER_H
 
 #include <QObject>
+#include <QStringList>
 
 #include <assimp/Importer.hpp>
 
@@ -58,6 +59,19 @@ public:
 	StaticMesh *GetStaticMesh() { return _staticMesh; }
 	SkeletalMesh *GetSkeletalMesh() { return _skeletalMesh; }
 
+	void SetCompressAnimations(bool compress) { _compressAnimations = compress; }
+
+	/**
+	 * Reason for the last failed Convert call.
+	 */
+	const QString &GetError() const { return _error; }
+
+	/**
+	 * Problems that did not stop the mesh from being written, such as
+	 * materials or animations that could not be exported.
+	 */
+	const QStringList &GetWarnings() const { return _warnings; }
+
 	virtual ~AssimpConverter();
 
 signals:
@@ -67,6 +81,9 @@ public slots:
 private:
 	StaticMesh *_staticMesh;
 	SkeletalMesh *_skeletalMesh;
+	bool _compressAnimations;
+	QString _error;
+	QStringList _warnings;
 
 	void _ProcessAnimation(struct aiAnimation *animation);
 	void _ProcessStaticMesh(struct aiMesh *mesh);
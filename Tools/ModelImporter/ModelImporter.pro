@@ -41,6 +41,7 @@ SOURCES += main.cpp\
     AssimpConverter.cpp \
     Material.cpp \
     AnimationClip.cpp \
+    AnimationCompressor.cpp \
     FBXConverter.cpp
 
 HEADERS  += \
@@ -51,6 +52,7 @@ HEADERS  += \
     AssimpConverter.h \
     Material.h \
     AnimationClip.h \
+    AnimationCompressor.h \
     FBXConverter.h
 
 FORMS    += ModelImporterWindow.ui \
@@ -83,10 +83,12 @@ void ModelImporterWindow::Convert()
 {
 	AssimpConverter converter;
 
-	if (converter.Convert(ui->inputFileEdit->text().toStdString().c_str(), ui->outputFileEdit->text().toStdString().c_str(), ui->forceSMChk->checkState() == Qt::Checked))
-		QMessageBox::information(this, "Conversion complete", "The mesh has been converted");
+	if (!converter.Convert(ui->inputFileEdit->text().toStdString().c_str(), ui->outputFileEdit->text().toStdString().c_str(), ui->forceSMChk->checkState() == Qt::Checked))
+		QMessageBox::critical(this, "Conversion failed", converter.GetError());
+	else if (!converter.GetWarnings().isEmpty())
+		QMessageBox::warning(this, "Conversion complete", "The mesh has been converted with warnings:\n" + converter.GetWarnings().join("\n"));
 	else
-		QMessageBox::information(this, "Conversion failed", "The mesh has not been converted");
+		QMessageBox::information(this, "Conversion complete", "The mesh has been converted");
 }
 
 ModelImporterWindow::~ModelImporterWindow()
@@ -38,11 +38,56 @@
  */
 
 #include "ModelImporterWindow.h"
+#include "AssimpConverter.h"
+
 #include <QApplication>
+#include <QCoreApplication>
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Usage: ModelImporter [input output [--static] [--uncompressed]]
+ * With input and output the model is converted without showing the window.
+ * Errors, warnings and the per-bone animation compression error are printed
+ * to stderr. Exits with 0 on success, 1 if the conversion failed and 2 if the
+ * mesh was written but some materials or animations were not.
+ */
+static int _ConvertHeadless(int argc, char *argv[])
+{
+	AssimpConverter converter;
+	bool forceStaticMesh{ false };
+
+	for (int i = 3; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--static"))
+			forceStaticMesh = true;
+		else if (!strcmp(argv[i], "--uncompressed"))
+			converter.SetCompressAnimations(false);
+	}
+
+	if (!converter.Convert(argv[1], argv[2], forceStaticMesh))
+	{
+		fprintf(stderr, "error: %s\n", converter.GetError().toStdString().c_str());
+		return 1;
+	}
+
+	for (const QString &warning : converter.GetWarnings())
+		fprintf(stderr, "warning: %s\n", warning.toStdString().c_str());
+
+	return converter.GetWarnings().isEmpty() ? 0 : 2;
+}
 
 int main(int argc, char *argv[])
 {
+	if (argc > 2)
+	{
+		QCoreApplication a(argc, argv);
+		return _ConvertHeadless(argc, argv);
+	}
+
 	QApplication a(argc, argv);
+
 	ModelImporterWindow w;
 	w.show();
 